@@ -92,7 +92,7 @@ WynObject* wyn_arc_retain_optimized(WynObject* obj) {
         }
         
         // Preserve weak flag, increment count
-        uint32_t new_count = (old_count & ARC_WEAK_FLAG) | (count_part + 1);
+        uint32_t new_count = (old_count & ~ARC_COUNT_MASK) | (count_part + 1);
         
         if (atomic_compare_exchange_weak_explicit(&obj->header.ref_count, &old_count, new_count,
                                                 memory_order_acq_rel, memory_order_acquire)) {
@@ -120,6 +120,7 @@ void wyn_arc_release_optimized(WynObject* obj) {
     
     // Try fast path first
     if (wyn_arc_release_fast(obj)) {
+        if (wyn_cycle_traced(obj)) wyn_cycle_add_candidate(obj);
         return;
     }
     
@@ -136,13 +137,15 @@ void wyn_arc_release_optimized(WynObject* obj) {
         }
         
         // Preserve weak flag, decrement count
-        uint32_t new_count = (old_count & ARC_WEAK_FLAG) | (count_part - 1);
+        uint32_t new_count = (old_count & ~ARC_COUNT_MASK) | (count_part - 1);
         
         if (atomic_compare_exchange_weak_explicit(&obj->header.ref_count, &old_count, new_count,
                                                 memory_order_acq_rel, memory_order_acquire)) {
             // If count reached zero, deallocate
             if ((new_count & ARC_COUNT_MASK) == 0) {
-                wyn_arc_deallocate(obj);
+                if (!wyn_cycle_release_held(obj)) wyn_arc_deallocate(obj);
+            } else if (wyn_cycle_traced(obj)) {
+                wyn_cycle_add_candidate(obj);
             }
             break;
         }
@@ -1,9 +1,16 @@
 #include "arc_runtime.h"
-#include <stdlib.h>
 #include <string.h>
 
+_Atomic bool wyn_arc_all_shared = false;
+
+// For values whose contents the compiler cannot enumerate: every count
+// turns atomic, as before thread-escape analysis
+void wyn_arc_share_all(void) {
+    atomic_store(&wyn_arc_all_shared, true);
+}
+
 WynArc* wyn_arc_new(size_t size, void* init_data) {
-    WynArc* arc = malloc(sizeof(WynArc) + size);
+    WynArc* arc = wyn_pool_alloc(sizeof(WynArc) + size);
     if (!arc) return NULL;
     arc->ref_count = 1;
     if (init_data) memcpy(arc->data, init_data, size);
@@ -11,38 +18,58 @@ WynArc* wyn_arc_new(size_t size, void* init_data) {
 }
 
 WynArc* wyn_arc_retain_arc(WynArc* arc) {
-    if (arc) arc->ref_count++;
+    if (arc) wyn_arc_count_retain(&arc->ref_count);
     return arc;
 }
 
 void wyn_arc_release_arc(WynArc* arc) {
-    if (arc && --arc->ref_count == 0) free(arc);
+    if (arc && wyn_arc_count_release(&arc->ref_count)) wyn_pool_release(arc);
+}
+
+WynArc* wyn_arc_share_arc(WynArc* arc) {
+    if (arc) wyn_arc_count_share(&arc->ref_count);
+    return arc;
 }
 
 // WynObject-based ARC implementations
 WynObject* wyn_arc_alloc(size_t size, uint32_t type_id, void (*destructor)(void*)) {
-    WynObject* obj = malloc(sizeof(WynObject) + size);
+    WynObject* obj = wyn_pool_alloc(sizeof(WynObject) + size);
     if (!obj) return NULL;
     obj->header.ref_count = 1;
     obj->header.type_id = type_id;
     obj->header.destructor = destructor;
     obj->header.size = size;
+    atomic_init(&obj->header.cycle, 0);
     obj->header.magic = 0xDEADBEEF;
     return obj;
 }
 
 WynObject* wyn_arc_retain(WynObject* obj) {
-    if (obj) obj->header.ref_count++;
+    if (obj) wyn_arc_count_retain(&obj->header.ref_count);
     return obj;
 }
 
 void wyn_arc_release(WynObject* obj) {
-    if (obj && --obj->header.ref_count == 0) {
-        if (obj->header.destructor) obj->header.destructor(obj);
-        free(obj);
+    if (!obj) return;
+    if (wyn_arc_count_release(&obj->header.ref_count)) {
+        if (!wyn_cycle_release_held(obj)) wyn_arc_deallocate(obj);
+    } else if (wyn_cycle_traced(obj)) {
+        wyn_cycle_add_candidate(obj);
     }
 }
 
+WynObject* wyn_arc_share(WynObject* obj) {
+    if (obj) wyn_arc_count_share(&obj->header.ref_count);
+    return obj;
+}
+
+void wyn_arc_deallocate(WynObject* obj) {
+    if (!obj) return;
+    if (obj->header.destructor) obj->header.destructor(obj);
+    obj->header.magic = 0;
+    wyn_pool_release(obj);
+}
+
 
 // Additional ARC utility functions
 void* wyn_arc_get_data(WynObject* obj) {
@@ -50,7 +77,7 @@ void* wyn_arc_get_data(WynObject* obj) {
 }
 
 uint32_t wyn_arc_get_ref_count(WynObject* obj) {
-    return obj ? obj->header.ref_count : 0;
+    return obj ? atomic_load(&obj->header.ref_count) & ARC_COUNT_MASK : 0;
 }
 
 bool wyn_arc_is_valid(WynObject* obj) {
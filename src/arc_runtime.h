@@ -11,14 +11,16 @@
 
 #define ARC_MAGIC 0x41524330  // "ARC0" in hex (0x41='A', 0x52='R', 0x43='C', 0x30='0')
 #define ARC_WEAK_FLAG 0x80000000
-#define ARC_COUNT_MASK 0x7FFFFFFF
+#define ARC_SHARED_FLAG 0x40000000   // Reachable from more than one thread
+#define ARC_COUNT_MASK 0x3FFFFFFF
 
 // Object header for ARC memory management
 typedef struct WynObjectHeader {
     uint32_t magic;                    // Magic number for validation
-    _Atomic uint32_t ref_count;        // Atomic reference count (MSB = weak flag)
+    _Atomic uint32_t ref_count;        // Reference count plus the weak and shared flags
     uint32_t type_id;                  // Type identifier for runtime type information
     uint32_t size;                     // Object size for deallocation
+    _Atomic uint32_t cycle;            // Cycle collector flags and graph index (WYN_CYCLE_*)
     void (*destructor)(void*);         // Custom destructor function pointer
 } WynObjectHeader;
 
@@ -38,24 +40,69 @@ typedef enum {
     WYN_TYPE_ARRAY = 5,
     WYN_TYPE_STRUCT = 6,
     WYN_TYPE_FUNCTION = 7,
+    WYN_TYPE_MAP = 8,
     WYN_TYPE_CUSTOM_BASE = 1000  // Base for user-defined types
 } WynTypeId;
 
 // Minimal ARC struct
 typedef struct WynArc {
-    int ref_count;
+    _Atomic uint32_t ref_count;    // Count plus ARC_SHARED_FLAG
     char data[];
 } WynArc;
 
+// Thread-escape driven reference counting. Objects start out owned by the
+// thread that made them and count with plain loads and stores. The compiler
+// promotes a value with wyn_*_share before it can reach another thread (as
+// a spawn argument); shared objects count atomically from then on. Values
+// the compiler cannot see into promote everything (wyn_arc_share_all).
+// Strings and maps count the same way with their own counters.
+extern _Atomic bool wyn_arc_all_shared;
+
+static inline bool wyn_arc_count_shared(uint32_t count) {
+    return (count & ARC_SHARED_FLAG) || atomic_load_explicit(&wyn_arc_all_shared, memory_order_relaxed);
+}
+
+static inline void wyn_arc_count_retain(_Atomic uint32_t* count) {
+    uint32_t old = atomic_load_explicit(count, memory_order_relaxed);
+    if (wyn_arc_count_shared(old)) {
+        atomic_fetch_add_explicit(count, 1, memory_order_relaxed);
+    } else {
+        atomic_store_explicit(count, old + 1, memory_order_relaxed);
+    }
+}
+
+// True when the last reference went away
+static inline bool wyn_arc_count_release(_Atomic uint32_t* count) {
+    uint32_t old = atomic_load_explicit(count, memory_order_relaxed);
+    if (wyn_arc_count_shared(old)) {
+        old = atomic_fetch_sub_explicit(count, 1, memory_order_acq_rel);
+    } else {
+        atomic_store_explicit(count, old - 1, memory_order_relaxed);
+    }
+    return (old & ARC_COUNT_MASK) == 1;
+}
+
+// Only the owning thread can see an unshared count, so the flag is set
+// before any other thread touches it
+static inline void wyn_arc_count_share(_Atomic uint32_t* count) {
+    if (!(atomic_load_explicit(count, memory_order_relaxed) & ARC_SHARED_FLAG)) {
+        atomic_fetch_or_explicit(count, ARC_SHARED_FLAG, memory_order_relaxed);
+    }
+}
+
+void wyn_arc_share_all(void);
+
 // Minimal ARC operations
 WynArc* wyn_arc_new(size_t size, void* init_data);
 WynArc* wyn_arc_retain_arc(WynArc* arc);
 void wyn_arc_release_arc(WynArc* arc);
+WynArc* wyn_arc_share_arc(WynArc* arc);
 
 // ARC operations - core interface
 WynObject* wyn_arc_alloc(size_t size, uint32_t type_id, void (*destructor)(void*));
 WynObject* wyn_arc_retain(WynObject* obj);
 void wyn_arc_release(WynObject* obj);
+WynObject* wyn_arc_share(WynObject* obj);
 WynObject* wyn_arc_weak_retain(WynObject* obj);
 void wyn_arc_weak_release(WynObject* obj);
 
@@ -81,33 +128,77 @@ void wyn_weak_create_batch(WynObject** objects, WynWeakRef** weak_refs, size_t c
 void wyn_weak_destroy_batch(WynWeakRef** weak_refs, size_t count);
 
 // T2.3.4: Cycle Detection Algorithm
+// Trial deletion (Bacon-Rajan) over objects whose types register a tracer.
+// Releasing a traced object to a nonzero count buffers it as a possible
+// cycle root on the releasing thread. That thread collects its buffer in
+// slices of bounded length, and no other thread ever pauses (cycle_detection.c).
 typedef struct {
-    size_t collection_threshold;
-    size_t max_objects_per_cycle;
-    bool auto_collection_enabled;
-    double collection_frequency;
-    size_t min_cycle_size;
+    size_t collection_threshold;      // Roots buffered between automatic slices
+    size_t max_objects_per_cycle;     // Largest graph one round examines
+    bool auto_collection_enabled;     // Run slices from the release path
+    uint64_t slice_budget_ns;         // Time one slice may take
 } CycleDetectionConfig;
 
 typedef struct {
-    size_t cycles_detected;
+    size_t cycles_detected;           // Buffered roots found to be garbage
     size_t objects_collected;
-    size_t collection_runs;
-    size_t false_positives;
-    size_t candidate_count;
-    size_t allocations_since_collection;
-    double collection_efficiency;
+    size_t collection_runs;           // Rounds of trial deletion completed
+    size_t false_positives;           // Buffered roots found to be live
+    size_t rounds_abandoned;          // Graph outgrew max_objects_per_cycle or became shared
+    size_t slices;
+    uint64_t max_slice_ns;
+    uint64_t total_slice_ns;
+    size_t candidate_count;           // Roots buffered on the calling thread
 } WynCycleStats;
 
+// Calls visit once for every counted reference obj holds to another
+// WynObject: exactly the references its destructor releases
+typedef void (*WynCycleVisit)(WynObject* child, void* ctx);
+typedef void (*WynCycleTrace)(WynObject* obj, WynCycleVisit visit, void* ctx);
+
+#define WYN_CYCLE_MAX_TYPES 4096          // Type ids below this can be traced
+#define WYN_CYCLE_BUFFERED 0x1u           // In a thread's root buffer
+#define WYN_CYCLE_MARKED 0x2u             // In the graph of a round in progress
+#define WYN_CYCLE_ZERO 0x4u               // Count reached zero while held; the collector frees it
+#define WYN_CYCLE_DESTROYED 0x8u          // Collected; only the memory is left to free
+#define WYN_CYCLE_HELD (WYN_CYCLE_BUFFERED | WYN_CYCLE_MARKED)
+#define WYN_CYCLE_INDEX_SHIFT 8           // Position in the round's graph
+
+extern _Atomic(WynCycleTrace) wyn_cycle_tracers[WYN_CYCLE_MAX_TYPES];
+
+// Objects of types without a tracer cannot be part of a cycle
+static inline bool wyn_cycle_traced(const WynObject* obj) {
+    uint32_t type = obj->header.type_id;
+    return type < WYN_CYCLE_MAX_TYPES &&
+           atomic_load_explicit(&wyn_cycle_tracers[type], memory_order_relaxed) != NULL;
+}
+
+bool wyn_cycle_defer_free(WynObject* obj);
+
+// For release paths whose count just reached zero: true when the collector
+// holds obj and will free it itself
+static inline bool wyn_cycle_release_held(WynObject* obj) {
+    return (atomic_load_explicit(&obj->header.cycle, memory_order_acquire) & WYN_CYCLE_HELD) &&
+           wyn_cycle_defer_free(obj);
+}
+
 void wyn_cycle_detection_init(void);
 void wyn_cycle_configure(CycleDetectionConfig* config);
+void wyn_cycle_register_type(uint32_t type_id, WynCycleTrace trace);
+// Release-path hook: obj was released to a nonzero count
 void wyn_cycle_add_candidate(WynObject* obj);
+// One slice of at most budget_ns (plus the scan of one graph); false once
+// the calling thread has nothing left to examine
+bool wyn_cycle_collect_slice(uint64_t budget_ns);
+// Collects everything the calling thread has buffered; returns the objects freed
 size_t wyn_cycle_collect(void);
+// A slice with the configured budget when the calling thread has work
 void wyn_cycle_check_collection_trigger(void);
 CycleDetectionConfig wyn_cycle_get_config(void);
 WynCycleStats wyn_cycle_get_stats(void);
 void wyn_cycle_reset_stats(void);
 void wyn_cycle_print_stats(void);
+// Collects and drops the calling thread's buffer (also run at thread exit)
 void wyn_cycle_cleanup(void);
 
 // T2.3.5: Memory Pool Optimization
@@ -128,6 +219,12 @@ typedef struct {
 void wyn_pool_init(void);
 void* wyn_pool_alloc(size_t size);
 void wyn_pool_free(void* ptr, size_t size);
+void* wyn_pool_calloc(size_t count, size_t size);
+void* wyn_pool_realloc(void* ptr, size_t size);     // ptr may come from malloc
+void wyn_pool_release(void* ptr);                  // Any pool or malloc pointer
+int wyn_pool_cache_register(size_t block_size);    // -1 if no cache is left
+void* wyn_pool_cache_pop(int cache);               // NULL when the caller must carve a block
+void wyn_pool_cache_push(int cache, void* block);
 WynObject* wyn_arc_alloc_pooled(size_t size, uint32_t type_id, void (*destructor)(void*));
 void wyn_arc_deallocate_pooled(WynObject* obj);
 WynPoolStats wyn_pool_get_stats(void);
@@ -189,6 +286,7 @@ typedef struct {
     size_t total_allocation_sites;
     size_t stack_allocatable_sites;
     size_t eliminated_retain_release_pairs;
+    size_t thread_escaping_sites;      // Values promoted to atomic counts
     double stack_allocation_ratio;
     double optimization_ratio;
 } WynEscapeStats;
@@ -196,6 +294,11 @@ typedef struct {
 void wyn_escape_analysis_init(void);
 AllocationSite* wyn_escape_register_allocation(void* allocation_point, size_t size, uint32_t type_id);
 void wyn_escape_add_reference(AllocationSite* site);
+void wyn_escape_mark(AllocationSite* site, EscapeStatus status);
+AllocationSite* wyn_escape_find(const void* allocation_point);
+EscapeStatus wyn_escape_status(const AllocationSite* site);
+uint32_t wyn_escape_type_id(const AllocationSite* site);
+bool wyn_escape_crosses_threads(const AllocationSite* site);
 void wyn_escape_analyze_all(void);
 bool wyn_escape_can_stack_allocate(AllocationSite* site);
 bool wyn_escape_needs_retain_release(AllocationSite* site);
@@ -52,6 +52,7 @@ typedef enum {
     EXPR_PATTERN,        // T3.3.1: Pattern expressions for destructuring
     EXPR_FN_TYPE,        // Function type: fn(T1, T2) -> R
     EXPR_BLOCK,          // Block expression: { stmt1; stmt2; expr }
+    EXPR_SPAWN,          // spawn f(args) used as a value: a join handle
 } ExprType;
 
 // T3.3.1: Pattern types for destructuring
@@ -125,6 +126,10 @@ typedef struct {
     Expr* expr;
 } AwaitExpr;
 
+typedef struct {
+    Expr* call;
+} SpawnExpr;
+
 // T3.3.1: Pattern structures for destructuring
 typedef struct Pattern Pattern;
 
@@ -311,6 +316,7 @@ struct Expr {
         FieldAccessExpr field_access;
         UnaryExpr unary;
         AwaitExpr await;
+        SpawnExpr spawn;
         MatchExpr match;
         OptionExpr option;
         TernaryExpr ternary;
@@ -363,6 +369,7 @@ typedef enum {
     STMT_TRAIT, // T3.2.1: Trait definition statement
     STMT_MODULE, // T3.5.1: Module declaration statement
     STMT_SPAWN, // Concurrency: spawn statement
+    STMT_SCOPE, // Concurrency: scope { ... } waits for the spawns made inside
 } StmtType;
 
 typedef struct Stmt Stmt;
@@ -588,6 +595,9 @@ struct Stmt {
         struct {  // Spawn statement
             Expr* call;
         } spawn;
+        struct {  // Structured spawn scope
+            Stmt* body;
+        } scope;
     };
 };
 
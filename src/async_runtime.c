@@ -4,35 +4,511 @@
 #endif
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <pthread.h>
 #ifndef _WIN32
 #include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#else
+#include <poll.h>
+#endif
 #else
 #include <windows.h>
 #define usleep(us) Sleep((us) / 1000)
 #endif
 #include "async_runtime.h"
 
+// Futures are completed by whichever thread produces the value (an async fn
+// body, or the reactor thread for I/O and timers). wyn_block_on spins
+// briefly and then parks on the state word instead of polling.
+
+#define BLOCK_ON_SPINS 64
+
+#ifndef __linux__
+static pthread_mutex_t future_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t future_cond = PTHREAD_COND_INITIALIZER;
+#endif
+
 WynFuture* wyn_future_new(void) {
     WynFuture* future = malloc(sizeof(WynFuture));
-    future->state = WYN_FUTURE_PENDING;
+    atomic_init(&future->state, WYN_FUTURE_PENDING);
     future->value = NULL;
     return future;
 }
 
 int wyn_future_poll(WynFuture* future) {
-    return future->state == WYN_FUTURE_READY;
+    return atomic_load_explicit(&future->state, memory_order_acquire) == WYN_FUTURE_READY;
 }
 
 void wyn_future_ready(WynFuture* future, void* value) {
     future->value = value;
-    future->state = WYN_FUTURE_READY;
+    uint32_t prev = atomic_exchange_explicit(&future->state, WYN_FUTURE_READY, memory_order_acq_rel);
+    if (prev != WYN_FUTURE_WAITING) return;
+    // The waiter may free the future as soon as it sees READY; a futex wake
+    // on a stale address is harmless
+#ifdef __linux__
+    syscall(SYS_futex, &future->state, FUTEX_WAKE_PRIVATE, INT32_MAX, NULL, NULL, 0);
+#else
+    pthread_mutex_lock(&future_lock);
+    pthread_cond_broadcast(&future_cond);
+    pthread_mutex_unlock(&future_lock);
+#endif
 }
 
 void* wyn_block_on(WynFuture* future) {
+    int spins = 0;
     while (!wyn_future_poll(future)) {
-        usleep(1000); // 1ms
+        if (spins++ < BLOCK_ON_SPINS) continue;
+        uint32_t expected = WYN_FUTURE_PENDING;
+        if (!atomic_compare_exchange_strong_explicit(&future->state, &expected, WYN_FUTURE_WAITING,
+                                                     memory_order_acq_rel, memory_order_acquire) &&
+            expected == WYN_FUTURE_READY) {
+            break;
+        }
+#ifdef __linux__
+        syscall(SYS_futex, &future->state, FUTEX_WAIT_PRIVATE, WYN_FUTURE_WAITING, NULL, NULL, 0);
+#else
+        pthread_mutex_lock(&future_lock);
+        while (atomic_load_explicit(&future->state, memory_order_acquire) == WYN_FUTURE_WAITING) {
+            pthread_cond_wait(&future_cond, &future_lock);
+        }
+        pthread_mutex_unlock(&future_lock);
+#endif
     }
     void* result = future->value;
     free(future);
     return result;
-}
\ No newline at end of file
+}
+
+// Reactor
+
+#ifndef _WIN32
+
+typedef struct {
+    WynIoCallback callback;
+    void* arg;
+    int once;
+} IoInterest;
+
+typedef struct {
+    IoInterest read;
+    IoInterest write;
+    int mask;            // Events currently registered with the kernel
+} IoSlot;
+
+typedef struct {
+    uint64_t deadline_ns;
+    WynTimerCallback callback;
+    void* arg;
+} Timer;
+
+typedef struct {
+    IoInterest interest;
+    int events;
+} IoFire;
+
+static struct {
+    pthread_mutex_t lock;
+    IoSlot* slots;          // Indexed by fd
+    int slot_count;
+    Timer* timers;          // Min-heap on deadline
+    int timer_count;
+    int timer_capacity;
+#ifdef __linux__
+    int epoll_fd;
+    int timer_fd;           // Armed for the earliest deadline
+#else
+    int wake_pipe[2];
+#endif
+    int started;
+} reactor = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static pthread_once_t reactor_once = PTHREAD_ONCE_INIT;
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int interest_mask(const IoSlot* slot) {
+    return (slot->read.callback ? WYN_IO_READ : 0) | (slot->write.callback ? WYN_IO_WRITE : 0);
+}
+
+#ifndef __linux__
+static void wake_reactor(void) {
+    char byte = 0;
+    ssize_t n = write(reactor.wake_pipe[1], &byte, 1);
+    (void)n;
+}
+#endif
+
+// Bring the kernel registration in line with the slot's interests
+static int sync_slot_locked(int fd, IoSlot* slot) {
+    int mask = interest_mask(slot);
+    if (mask == slot->mask) return 0;
+#ifdef __linux__
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = ((mask & WYN_IO_READ) ? EPOLLIN | EPOLLRDHUP : 0) | ((mask & WYN_IO_WRITE) ? EPOLLOUT : 0);
+    ev.data.fd = fd;
+    int rc;
+    if (mask == 0) {
+        // Fails if the fd was already closed, which removed it anyway
+        epoll_ctl(reactor.epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+        rc = 0;
+    } else if (slot->mask == 0) {
+        rc = epoll_ctl(reactor.epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+        if (rc < 0 && errno == EEXIST) rc = epoll_ctl(reactor.epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+    } else {
+        // A closed and reused fd is no longer in the epoll set
+        rc = epoll_ctl(reactor.epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+        if (rc < 0 && errno == ENOENT) rc = epoll_ctl(reactor.epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+    }
+    if (rc < 0) return -1;
+#else
+    wake_reactor();
+#endif
+    slot->mask = mask;
+    return 0;
+}
+
+static void arm_timer_locked(void) {
+#ifdef __linux__
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    if (reactor.timer_count > 0) {
+        uint64_t deadline = reactor.timers[0].deadline_ns;
+        its.it_value.tv_sec = (time_t)(deadline / 1000000000ULL);
+        its.it_value.tv_nsec = (long)(deadline % 1000000000ULL);
+        if (its.it_value.tv_sec == 0 && its.it_value.tv_nsec == 0) its.it_value.tv_nsec = 1;
+    }
+    timerfd_settime(reactor.timer_fd, TFD_TIMER_ABSTIME, &its, NULL);
+#else
+    wake_reactor();
+#endif
+}
+
+static void timer_push_locked(Timer timer) {
+    if (reactor.timer_count == reactor.timer_capacity) {
+        reactor.timer_capacity = reactor.timer_capacity ? reactor.timer_capacity * 2 : 64;
+        reactor.timers = realloc(reactor.timers, (size_t)reactor.timer_capacity * sizeof(Timer));
+    }
+    int i = reactor.timer_count++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (reactor.timers[parent].deadline_ns <= timer.deadline_ns) break;
+        reactor.timers[i] = reactor.timers[parent];
+        i = parent;
+    }
+    reactor.timers[i] = timer;
+}
+
+static Timer timer_pop_locked(void) {
+    Timer top = reactor.timers[0];
+    Timer last = reactor.timers[--reactor.timer_count];
+    int count = reactor.timer_count;
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= count) break;
+        if (child + 1 < count && reactor.timers[child + 1].deadline_ns < reactor.timers[child].deadline_ns) child++;
+        if (last.deadline_ns <= reactor.timers[child].deadline_ns) break;
+        reactor.timers[i] = reactor.timers[child];
+        i = child;
+    }
+    if (count > 0) reactor.timers[i] = last;
+    return top;
+}
+
+static void run_expired_timers(void) {
+    Timer batch[64];
+    for (;;) {
+        int n = 0;
+        pthread_mutex_lock(&reactor.lock);
+        uint64_t now = monotonic_ns();
+        while (n < 64 && reactor.timer_count > 0 && reactor.timers[0].deadline_ns <= now) {
+            batch[n++] = timer_pop_locked();
+        }
+        if (n < 64) arm_timer_locked();
+        pthread_mutex_unlock(&reactor.lock);
+        for (int i = 0; i < n; i++) batch[i].callback(batch[i].arg);
+        if (n < 64) return;
+    }
+}
+
+static void dispatch_fd(int fd, int ready) {
+    IoFire fire[2];
+    int n = 0;
+    pthread_mutex_lock(&reactor.lock);
+    if (fd < reactor.slot_count) {
+        IoSlot* slot = &reactor.slots[fd];
+        if ((ready & WYN_IO_READ) && slot->read.callback) {
+            fire[n++] = (IoFire){ slot->read, WYN_IO_READ };
+            if (slot->read.once) slot->read.callback = NULL;
+        }
+        if ((ready & WYN_IO_WRITE) && slot->write.callback) {
+            fire[n++] = (IoFire){ slot->write, WYN_IO_WRITE };
+            if (slot->write.once) slot->write.callback = NULL;
+        }
+        sync_slot_locked(fd, slot);
+    }
+    pthread_mutex_unlock(&reactor.lock);
+    for (int i = 0; i < n; i++) fire[i].interest.callback(fire[i].interest.arg, fire[i].events);
+}
+
+#ifdef __linux__
+#define REACTOR_BATCH 256
+
+static void* reactor_loop(void* unused) {
+    (void)unused;
+    struct epoll_event events[REACTOR_BATCH];
+    for (;;) {
+        int n = epoll_wait(reactor.epoll_fd, events, REACTOR_BATCH, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return NULL;
+        }
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            if (fd == reactor.timer_fd) {
+                uint64_t expirations;
+                ssize_t r = read(reactor.timer_fd, &expirations, sizeof(expirations));
+                (void)r;
+                run_expired_timers();
+                continue;
+            }
+            uint32_t e = events[i].events;
+            int ready = 0;
+            if (e & (EPOLLIN | EPOLLRDHUP)) ready |= WYN_IO_READ;
+            if (e & EPOLLOUT) ready |= WYN_IO_WRITE;
+            if (e & (EPOLLERR | EPOLLHUP)) ready |= WYN_IO_READ | WYN_IO_WRITE;
+            dispatch_fd(fd, ready);
+        }
+    }
+}
+
+static void reactor_init(void) {
+    reactor.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    reactor.timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (reactor.epoll_fd < 0 || reactor.timer_fd < 0) return;
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = reactor.timer_fd;
+    epoll_ctl(reactor.epoll_fd, EPOLL_CTL_ADD, reactor.timer_fd, &ev);
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, reactor_loop, NULL) == 0) {
+        pthread_detach(thread);
+        reactor.started = 1;
+    }
+}
+#else
+// poll() fallback: rebuilds the pollfd set each round, woken through a pipe
+static void* reactor_loop(void* unused) {
+    (void)unused;
+    struct pollfd* fds = NULL;
+    int capacity = 0;
+    for (;;) {
+        pthread_mutex_lock(&reactor.lock);
+        int needed = 1;
+        for (int fd = 0; fd < reactor.slot_count; fd++) {
+            if (reactor.slots[fd].mask) needed++;
+        }
+        if (needed > capacity) {
+            capacity = needed * 2;
+            fds = realloc(fds, (size_t)capacity * sizeof(struct pollfd));
+        }
+        int n = 0;
+        fds[n++] = (struct pollfd){ reactor.wake_pipe[0], POLLIN, 0 };
+        for (int fd = 0; fd < reactor.slot_count; fd++) {
+            int mask = reactor.slots[fd].mask;
+            if (!mask) continue;
+            short events = (short)(((mask & WYN_IO_READ) ? POLLIN : 0) | ((mask & WYN_IO_WRITE) ? POLLOUT : 0));
+            fds[n++] = (struct pollfd){ fd, events, 0 };
+        }
+        int timeout_ms = -1;
+        if (reactor.timer_count > 0) {
+            uint64_t now = monotonic_ns();
+            uint64_t deadline = reactor.timers[0].deadline_ns;
+            timeout_ms = deadline <= now ? 0 : (int)((deadline - now + 999999) / 1000000);
+        }
+        pthread_mutex_unlock(&reactor.lock);
+
+        int ready = poll(fds, (nfds_t)n, timeout_ms);
+        if (ready < 0 && errno != EINTR) return NULL;
+        if (ready > 0) {
+            if (fds[0].revents) {
+                char drain[64];
+                while (read(reactor.wake_pipe[0], drain, sizeof(drain)) > 0) {}
+            }
+            for (int i = 1; i < n; i++) {
+                short r = fds[i].revents;
+                if (!r) continue;
+                int events = 0;
+                if (r & POLLIN) events |= WYN_IO_READ;
+                if (r & POLLOUT) events |= WYN_IO_WRITE;
+                if (r & (POLLERR | POLLHUP | POLLNVAL)) events |= WYN_IO_READ | WYN_IO_WRITE;
+                dispatch_fd(fds[i].fd, events);
+            }
+        }
+        run_expired_timers();
+    }
+}
+
+static void reactor_init(void) {
+    if (pipe(reactor.wake_pipe) < 0) return;
+    for (int i = 0; i < 2; i++) {
+        fcntl(reactor.wake_pipe[i], F_SETFL, fcntl(reactor.wake_pipe[i], F_GETFL) | O_NONBLOCK);
+        fcntl(reactor.wake_pipe[i], F_SETFD, FD_CLOEXEC);
+    }
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, reactor_loop, NULL) == 0) {
+        pthread_detach(thread);
+        reactor.started = 1;
+    }
+}
+#endif
+
+static int reactor_start(void) {
+    pthread_once(&reactor_once, reactor_init);
+    return reactor.started ? 0 : -1;
+}
+
+static int add_interest(int fd, int events, WynIoCallback callback, void* arg, int once) {
+    if (fd < 0 || !callback || !(events & (WYN_IO_READ | WYN_IO_WRITE))) return -1;
+    if (reactor_start() < 0) return -1;
+    pthread_mutex_lock(&reactor.lock);
+    if (fd >= reactor.slot_count) {
+        int count = reactor.slot_count ? reactor.slot_count : 64;
+        while (count <= fd) count *= 2;
+        IoSlot* slots = realloc(reactor.slots, (size_t)count * sizeof(IoSlot));
+        if (!slots) {
+            pthread_mutex_unlock(&reactor.lock);
+            return -1;
+        }
+        memset(slots + reactor.slot_count, 0, (size_t)(count - reactor.slot_count) * sizeof(IoSlot));
+        reactor.slots = slots;
+        reactor.slot_count = count;
+    }
+    IoSlot* slot = &reactor.slots[fd];
+    IoSlot saved = *slot;
+    IoInterest interest = { callback, arg, once };
+    if (events & WYN_IO_READ) slot->read = interest;
+    if (events & WYN_IO_WRITE) slot->write = interest;
+    int rc = sync_slot_locked(fd, slot);
+    if (rc < 0) *slot = saved;
+    pthread_mutex_unlock(&reactor.lock);
+    return rc;
+}
+
+int wyn_reactor_watch(int fd, int events, WynIoCallback callback, void* arg) {
+    return add_interest(fd, events, callback, arg, 0);
+}
+
+int wyn_reactor_watch_once(int fd, int events, WynIoCallback callback, void* arg) {
+    return add_interest(fd, events, callback, arg, 1);
+}
+
+void wyn_reactor_unwatch(int fd) {
+    pthread_mutex_lock(&reactor.lock);
+    if (fd >= 0 && fd < reactor.slot_count) {
+        IoSlot* slot = &reactor.slots[fd];
+        slot->read.callback = NULL;
+        slot->write.callback = NULL;
+        sync_slot_locked(fd, slot);
+    }
+    pthread_mutex_unlock(&reactor.lock);
+}
+
+void wyn_reactor_timer(uint64_t delay_us, WynTimerCallback callback, void* arg) {
+    if (!callback) return;
+    if (reactor_start() < 0) {
+        usleep((useconds_t)delay_us);
+        callback(arg);
+        return;
+    }
+    Timer timer = { monotonic_ns() + delay_us * 1000ULL, callback, arg };
+    pthread_mutex_lock(&reactor.lock);
+    timer_push_locked(timer);
+    if (reactor.timers[0].deadline_ns == timer.deadline_ns) arm_timer_locked();
+    pthread_mutex_unlock(&reactor.lock);
+}
+
+#else  // _WIN32: no reactor; readiness is reported immediately
+
+int wyn_reactor_watch(int fd, int events, WynIoCallback callback, void* arg) {
+    (void)fd; (void)events; (void)callback; (void)arg;
+    return -1;
+}
+
+int wyn_reactor_watch_once(int fd, int events, WynIoCallback callback, void* arg) {
+    (void)fd; (void)events; (void)callback; (void)arg;
+    return -1;
+}
+
+void wyn_reactor_unwatch(int fd) {
+    (void)fd;
+}
+
+void wyn_reactor_timer(uint64_t delay_us, WynTimerCallback callback, void* arg) {
+    usleep(delay_us);
+    if (callback) callback(arg);
+}
+
+#endif
+
+static void complete_io_future(void* arg, int events) {
+    int* value = malloc(sizeof(int));
+    *value = events;
+    wyn_future_ready((WynFuture*)arg, value);
+}
+
+static void complete_timer_future(void* arg) {
+    complete_io_future(arg, 0);
+}
+
+// Regular files cannot be watched and are always ready
+static WynFuture* io_future(int fd, int events) {
+    WynFuture* future = wyn_future_new();
+    if (wyn_reactor_watch_once(fd, events, complete_io_future, future) < 0) {
+        complete_io_future(future, events);
+    }
+    return future;
+}
+
+WynFuture* wyn_future_readable(int fd) {
+    return io_future(fd, WYN_IO_READ);
+}
+
+WynFuture* wyn_future_writable(int fd) {
+    return io_future(fd, WYN_IO_WRITE);
+}
+
+WynFuture* wyn_future_sleep_us(uint64_t delay_us) {
+    WynFuture* future = wyn_future_new();
+    if (delay_us == 0) {
+        complete_timer_future(future);
+    } else {
+        wyn_reactor_timer(delay_us, complete_timer_future, future);
+    }
+    return future;
+}
+
+WynFuture* Async_sleep(int ms) {
+    return wyn_future_sleep_us(ms > 0 ? (uint64_t)ms * 1000ULL : 0);
+}
+
+WynFuture* Async_readable(int fd) {
+    return wyn_future_readable(fd);
+}
+
+WynFuture* Async_writable(int fd) {
+    return wyn_future_writable(fd);
+}
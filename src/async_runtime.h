@@ -1,19 +1,51 @@
 #ifndef ASYNC_RUNTIME_H
 #define ASYNC_RUNTIME_H
 
+#include <stdint.h>
+#include <stdatomic.h>
+
 typedef enum {
     WYN_FUTURE_PENDING,
+    WYN_FUTURE_WAITING,   // Pending with a thread blocked in wyn_block_on
     WYN_FUTURE_READY
 } WynFutureState;
 
 typedef struct {
-    WynFutureState state;
+    _Atomic uint32_t state;
     void* value;
 } WynFuture;
 
 WynFuture* wyn_future_new(void);
 int wyn_future_poll(WynFuture* future);
 void wyn_future_ready(WynFuture* future, void* value);
+// Parks the calling thread until the future is ready, then frees it
 void* wyn_block_on(WynFuture* future);
 
-#endif
\ No newline at end of file
+// Reactor: one background thread waits on epoll (poll() off Linux) and runs
+// callbacks when a watched fd becomes ready or a timer expires. Callbacks run
+// on the reactor thread and must not block; hand longer work to wyn_spawn.
+#define WYN_IO_READ  1
+#define WYN_IO_WRITE 2
+
+typedef void (*WynIoCallback)(void* arg, int events);
+typedef void (*WynTimerCallback)(void* arg);
+
+// Watch fd until wyn_reactor_unwatch; level-triggered. Returns 0 or -1.
+int wyn_reactor_watch(int fd, int events, WynIoCallback callback, void* arg);
+// Run callback once, the next time fd is ready for events
+int wyn_reactor_watch_once(int fd, int events, WynIoCallback callback, void* arg);
+void wyn_reactor_unwatch(int fd);
+void wyn_reactor_timer(uint64_t delay_us, WynTimerCallback callback, void* arg);
+
+// Futures completed by the reactor; awaiting them yields the ready events
+// (or 0 for a timer)
+WynFuture* wyn_future_readable(int fd);
+WynFuture* wyn_future_writable(int fd);
+WynFuture* wyn_future_sleep_us(uint64_t delay_us);
+
+// Async:: module, for `await Async::sleep(10)` and friends
+WynFuture* Async_sleep(int ms);
+WynFuture* Async_readable(int fd);
+WynFuture* Async_writable(int fd);
+
+#endif
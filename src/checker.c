@@ -9,6 +9,8 @@
 #include "optional.h"
 #include "result.h"
 #include "traits.h"
+#include "intern.h"
+#include "arc_runtime.h"  // Thread-escape records for spawn arguments
 
 // Forward declarations
 void check_stmt(Stmt* stmt, SymbolTable* scope);
@@ -26,28 +28,90 @@ static Type* builtin_void = NULL;
 static Type* builtin_array = NULL;
 static bool had_error = false;
 static Type* current_function_return_type = NULL;
+static int current_line = 0;            // line of the expression being checked, for diagnostics
+static Stmt* current_decl = NULL;       // top-level declaration being checked
 
 // Module visibility tracking
 static char current_module_name[256] = "";
 
+// Name lookup for scopes and the module registries: slots keep each entry's
+// hash beside its index, so growing never rehashes keys and most probes that
+// miss never touch the entries themselves
+typedef bool (*EntryMatches)(const void* table, int entry, const void* key);
+
+// Returns the slot holding the first entry with this key, or the empty slot where it belongs
+static NameSlot* find_name_slot(NameSlot* slots, int capacity, uint32_t hash,
+                                EntryMatches matches, const void* table, const void* key) {
+    uint32_t mask = (uint32_t)capacity - 1;
+    for (uint32_t i = hash & mask;; i = (i + 1) & mask) {
+        NameSlot* slot = &slots[i];
+        if (slot->entry == 0) return slot;
+        if (slot->hash == hash && matches(table, slot->entry - 1, key)) return slot;
+    }
+}
+
+// Indexes entry unless an earlier entry has the same key, keeping the table at most half full
+static void index_name(NameSlot** slots, int* capacity, uint32_t hash, int entry,
+                       EntryMatches matches, const void* table, const void* key) {
+    if ((entry + 1) * 2 > *capacity) {
+        int grown_capacity = *capacity ? *capacity * 2 : 16;
+        uint32_t mask = (uint32_t)grown_capacity - 1;
+        NameSlot* grown = calloc(grown_capacity, sizeof(NameSlot));
+        for (int i = 0; i < *capacity; i++) {
+            if ((*slots)[i].entry == 0) continue;
+            uint32_t j = (*slots)[i].hash & mask;
+            while (grown[j].entry) j = (j + 1) & mask;
+            grown[j] = (*slots)[i];
+        }
+        free(*slots);
+        *slots = grown;
+        *capacity = grown_capacity;
+    }
+    NameSlot* slot = find_name_slot(*slots, *capacity, hash, matches, table, key);
+    if (slot->entry == 0) {
+        slot->hash = hash;
+        slot->entry = entry + 1;
+    }
+}
+
 typedef struct {
     char module_name[128];
     char function_name[128];
     bool is_public;
 } FunctionVisibility;
 
-static FunctionVisibility function_registry[512];
-static int function_registry_count = 0;
+static struct {
+    FunctionVisibility* entries;
+    int count;
+    int capacity;
+    NameSlot* index;
+    int index_capacity;
+} function_registry;
 
 // Module collision tracking
 typedef struct {
     char short_name[128];
     char full_path[256];
     int line_number;
+    int next_same_name;     // next import with this short name, or -1
 } ImportedModule;
 
-static ImportedModule imported_modules[128];
-static int imported_modules_count = 0;
+static struct {
+    ImportedModule* entries;
+    int count;
+    int capacity;
+    NameSlot* index;        // short name -> first import
+    int index_capacity;
+} imported_modules;
+
+static void reset_module_registries(void) {
+    free(function_registry.entries);
+    free(function_registry.index);
+    free(imported_modules.entries);
+    free(imported_modules.index);
+    memset(&function_registry, 0, sizeof(function_registry));
+    memset(&imported_modules, 0, sizeof(imported_modules));
+}
 
 void set_current_module(const char* name) {
     if (name) {
@@ -58,61 +122,103 @@ void set_current_module(const char* name) {
     }
 }
 
-static void register_import(const char* full_path, int line) {
+static bool import_matches(const void* table, int entry, const void* key) {
+    (void)table;
+    return strcmp(imported_modules.entries[entry].short_name, key) == 0;
+}
+
+static void register_import(const char* full_path, int length, int line) {
     // Extract short name (last component after /)
-    const char* last_slash = strrchr(full_path, '/');
-    const char* short_name = last_slash ? last_slash + 1 : full_path;
+    const char* short_name = full_path;
+    for (int i = 0; i < length; i++) {
+        if (full_path[i] == '/') short_name = full_path + i + 1;
+    }
     
     // Just register - don't error yet
     // Error will happen at call site if short name is used ambiguously
-    if (imported_modules_count < 128) {
-        strncpy(imported_modules[imported_modules_count].short_name, short_name, 127);
-        strncpy(imported_modules[imported_modules_count].full_path, full_path, 255);
-        imported_modules[imported_modules_count].line_number = line;
-        imported_modules_count++;
+    if (imported_modules.count >= imported_modules.capacity) {
+        imported_modules.capacity = imported_modules.capacity ? imported_modules.capacity * 2 : 16;
+        imported_modules.entries = realloc(imported_modules.entries,
+                                           imported_modules.capacity * sizeof(ImportedModule));
+    }
+    int entry = imported_modules.count++;
+    ImportedModule* module = &imported_modules.entries[entry];
+    snprintf(module->short_name, sizeof(module->short_name), "%.*s",
+             (int)(full_path + length - short_name), short_name);
+    snprintf(module->full_path, sizeof(module->full_path), "%.*s", length, full_path);
+    module->line_number = line;
+    module->next_same_name = -1;
+    
+    uint32_t hash = intern_hash(module->short_name, (int)strlen(module->short_name));
+    NameSlot* slot = imported_modules.index
+        ? find_name_slot(imported_modules.index, imported_modules.index_capacity, hash,
+                         import_matches, NULL, module->short_name)
+        : NULL;
+    if (slot && slot->entry) {
+        // Chain onto the earlier imports of this short name
+        int last = slot->entry - 1;
+        while (imported_modules.entries[last].next_same_name >= 0) {
+            last = imported_modules.entries[last].next_same_name;
+        }
+        imported_modules.entries[last].next_same_name = entry;
+    } else {
+        index_name(&imported_modules.index, &imported_modules.index_capacity, hash, entry,
+                   import_matches, NULL, module->short_name);
     }
 }
 
 static bool is_ambiguous_module(const char* name, char* first_path, int* first_line, char* second_path, int* second_line) {
-    int count = 0;
-    int indices[2] = {-1, -1};
-    const char* first_full_path = NULL;
-    
-    for (int i = 0; i < imported_modules_count; i++) {
-        if (strcmp(imported_modules[i].short_name, name) == 0) {
-            // Check if this is a different full path
-            if (count == 0) {
-                first_full_path = imported_modules[i].full_path;
-                indices[0] = i;
-                count = 1;
-            } else if (strcmp(imported_modules[i].full_path, first_full_path) != 0) {
-                // Different full path - this is ambiguous
-                if (count == 1) {
-                    indices[1] = i;
-                }
-                count++;
-            }
-            // Same full path - duplicate import, not ambiguous
-        }
-    }
+    if (!imported_modules.index) return false;
+    NameSlot* slot = find_name_slot(imported_modules.index, imported_modules.index_capacity,
+                                    intern_hash(name, (int)strlen(name)), import_matches, NULL, name);
+    if (slot->entry == 0) return false;
     
-    if (count > 1) {
-        strcpy(first_path, imported_modules[indices[0]].full_path);
-        *first_line = imported_modules[indices[0]].line_number;
-        strcpy(second_path, imported_modules[indices[1]].full_path);
-        *second_line = imported_modules[indices[1]].line_number;
-        return true;
+    ImportedModule* first = &imported_modules.entries[slot->entry - 1];
+    for (int i = first->next_same_name; i >= 0; i = imported_modules.entries[i].next_same_name) {
+        ImportedModule* other = &imported_modules.entries[i];
+        // Same full path is a duplicate import, not ambiguous
+        if (strcmp(other->full_path, first->full_path) != 0) {
+            strcpy(first_path, first->full_path);
+            *first_line = first->line_number;
+            strcpy(second_path, other->full_path);
+            *second_line = other->line_number;
+            return true;
+        }
     }
     return false;
 }
 
+typedef struct {
+    const char* module;
+    const char* func;
+} QualifiedName;
+
+static uint32_t hash_qualified_name(const char* module, const char* func) {
+    return intern_hash(module, (int)strlen(module)) * 31 + intern_hash(func, (int)strlen(func));
+}
+
+static bool function_matches(const void* table, int entry, const void* key) {
+    (void)table;
+    const QualifiedName* name = key;
+    return strcmp(function_registry.entries[entry].module_name, name->module) == 0 &&
+           strcmp(function_registry.entries[entry].function_name, name->func) == 0;
+}
+
 static void register_function_visibility(const char* module, const char* func, bool is_public) {
-    if (function_registry_count < 512) {
-        strncpy(function_registry[function_registry_count].module_name, module, 127);
-        strncpy(function_registry[function_registry_count].function_name, func, 127);
-        function_registry[function_registry_count].is_public = is_public;
-        function_registry_count++;
+    if (function_registry.count >= function_registry.capacity) {
+        function_registry.capacity = function_registry.capacity ? function_registry.capacity * 2 : 64;
+        function_registry.entries = realloc(function_registry.entries,
+                                            function_registry.capacity * sizeof(FunctionVisibility));
     }
+    int entry = function_registry.count++;
+    FunctionVisibility* fv = &function_registry.entries[entry];
+    snprintf(fv->module_name, sizeof(fv->module_name), "%s", module);
+    snprintf(fv->function_name, sizeof(fv->function_name), "%s", func);
+    fv->is_public = is_public;
+    
+    QualifiedName name = { fv->module_name, fv->function_name };
+    index_name(&function_registry.index, &function_registry.index_capacity,
+               hash_qualified_name(name.module, name.func), entry, function_matches, NULL, &name);
 }
 
 static bool check_function_visibility(const char* module, const char* func) {
@@ -122,48 +228,58 @@ static bool check_function_visibility(const char* module, const char* func) {
     }
     
     // Check if function is public
-    for (int i = 0; i < function_registry_count; i++) {
-        if (strcmp(function_registry[i].module_name, module) == 0 &&
-            strcmp(function_registry[i].function_name, func) == 0) {
-            return function_registry[i].is_public;
-        }
+    if (function_registry.index) {
+        QualifiedName name = { module, func };
+        NameSlot* slot = find_name_slot(function_registry.index, function_registry.index_capacity,
+                                        hash_qualified_name(module, func), function_matches, NULL, &name);
+        if (slot->entry) return function_registry.entries[slot->entry - 1].is_public;
     }
     
     // Not found - assume public for backwards compatibility
     return true;
 }
 
-static void print_type_name(Type* type) {
+// Appends a type's name to buf for diagnostics
+static void format_type_name(Type* type, char* buf, size_t size) {
+    size_t len = strlen(buf);
+    if (len >= size) return;
+    char* out = buf + len;
+    size_t room = size - len;
     if (!type) {
-        fprintf(stderr, "unknown");
+        snprintf(out, room, "unknown");
         return;
     }
     switch (type->kind) {
-        case TYPE_INT: fprintf(stderr, "int"); break;
-        case TYPE_FLOAT: fprintf(stderr, "float"); break;
-        case TYPE_STRING: fprintf(stderr, "string"); break;
-        case TYPE_BOOL: fprintf(stderr, "bool"); break;
-        case TYPE_VOID: fprintf(stderr, "void"); break;
-        case TYPE_ARRAY: fprintf(stderr, "array"); break;
+        case TYPE_INT: snprintf(out, room, "int"); break;
+        case TYPE_FLOAT: snprintf(out, room, "float"); break;
+        case TYPE_STRING: snprintf(out, room, "string"); break;
+        case TYPE_BOOL: snprintf(out, room, "bool"); break;
+        case TYPE_VOID: snprintf(out, room, "void"); break;
+        case TYPE_ARRAY: snprintf(out, room, "array"); break;
         case TYPE_STRUCT:
             if (type->struct_type.name.length > 0) {
-                fprintf(stderr, "%.*s", type->struct_type.name.length, type->struct_type.name.start);
+                snprintf(out, room, "%.*s", type->struct_type.name.length, type->struct_type.name.start);
             } else {
-                fprintf(stderr, "struct");
+                snprintf(out, room, "struct");
             }
             break;
         case TYPE_OPTIONAL: // T2.5.1: Optional Type Implementation
-            print_type_name(type->optional_type.inner_type);
-            fprintf(stderr, "?");
+            format_type_name(type->optional_type.inner_type, buf, size);
+            strncat(buf, "?", size - strlen(buf) - 1);
             break;
         case TYPE_RESULT: // TASK-026: Result Type Implementation
-            fprintf(stderr, "Result<");
-            print_type_name(type->result_type.ok_type);
-            fprintf(stderr, ", ");
-            print_type_name(type->result_type.err_type);
-            fprintf(stderr, ">");
+            snprintf(out, room, "Result<");
+            format_type_name(type->result_type.ok_type, buf, size);
+            strncat(buf, ", ", size - strlen(buf) - 1);
+            format_type_name(type->result_type.err_type, buf, size);
+            strncat(buf, ">", size - strlen(buf) - 1);
+            break;
+        case TYPE_FUTURE:
+            snprintf(out, room, "Future<");
+            format_type_name(type->future_type.value_type, buf, size);
+            strncat(buf, ">", size - strlen(buf) - 1);
             break;
-        default: fprintf(stderr, "unknown"); break;
+        default: snprintf(out, room, "unknown"); break;
     }
 }
 
@@ -183,6 +299,12 @@ static bool is_result_type(Type* type) {
     return type && type->kind == TYPE_RESULT;
 }
 
+static Type* make_future_type(Type* value_type) {
+    Type* future = make_type(TYPE_FUTURE);
+    future->future_type.value_type = value_type;
+    return future;
+}
+
 static Type* make_result_type(Type* ok_type, Type* err_type) {
     Type* result_type = make_type(TYPE_RESULT);
     result_type->result_type.ok_type = ok_type;
@@ -216,6 +338,46 @@ static StructStmt* find_struct_definition(Token struct_name) {
     return NULL;
 }
 
+// sort_by_key("field") sorts struct elements on an int, float or string field
+static void check_sort_by_key(Type* elem_type, Expr* expr) {
+    int line = expr->method_call.method.line;
+    Expr* arg = expr->method_call.arg_count == 1 ? expr->method_call.args[0] : NULL;
+    if (!elem_type) return;  // Element type unknown here (e.g. a [T] parameter)
+    if (elem_type->kind != TYPE_STRUCT) {
+        compile_error(ERR_TYPE_MISMATCH, line, "sort_by_key needs an array of structs");
+        had_error = true;
+        return;
+    }
+    if (!arg || arg->type != EXPR_STRING) {
+        compile_error(ERR_INVALID_EXPRESSION, line, "sort_by_key expects a field name as a string literal");
+        had_error = true;
+        return;
+    }
+    StructStmt* decl = find_struct_definition(elem_type->struct_type.name);
+    if (!decl) return;  // Declared in another module; codegen resolves it
+    const char* field = arg->token.start + 1;  // Strip quotes
+    int field_len = arg->token.length - 2;
+    for (int i = 0; i < decl->field_count; i++) {
+        Token name = decl->fields[i];
+        if (name.length != field_len || memcmp(name.start, field, field_len) != 0) continue;
+        Expr* type_expr = decl->field_types[i];
+        Token t = type_expr && type_expr->type == EXPR_IDENT ? type_expr->token : (Token){0};
+        if ((t.length == 3 && memcmp(t.start, "int", 3) == 0) ||
+            (t.length == 5 && memcmp(t.start, "float", 5) == 0) ||
+            (t.length == 6 && memcmp(t.start, "string", 6) == 0) ||
+            (t.length == 3 && memcmp(t.start, "str", 3) == 0)) {
+            return;
+        }
+        compile_error(ERR_TYPE_MISMATCH, line, "sort_by_key: field '%.*s' of %.*s is not an int, float or string",
+                      field_len, field, decl->name.length, decl->name.start);
+        had_error = true;
+        return;
+    }
+    compile_error(ERR_UNDEFINED_VARIABLE, line, "sort_by_key: %.*s has no field '%.*s'",
+                  decl->name.length, decl->name.start, field_len, field);
+    had_error = true;
+}
+
 static EnumStmt* find_enum_definition(Token enum_name) {
     if (!current_program) return NULL;
     
@@ -232,6 +394,106 @@ static EnumStmt* find_enum_definition(Token enum_name) {
     return NULL;
 }
 
+static FnStmt* find_fn_definition(Token fn_name) {
+    if (!current_program) return NULL;
+    
+    for (int i = 0; i < current_program->count; i++) {
+        Stmt* stmt = current_program->stmts[i];
+        if (stmt->type == STMT_FN && !stmt->fn.is_extension) {
+            Token name = stmt->fn.name;
+            if (name.length == fn_name.length &&
+                memcmp(name.start, fn_name.start, name.length) == 0) {
+                return &stmt->fn;
+            }
+        }
+    }
+    return NULL;
+}
+
+static bool type_name_is(Token t, const char* name) {
+    return t.length == (int)strlen(name) && memcmp(t.start, name, t.length) == 0;
+}
+
+// Map values are stored as int, float, string or bool
+static Type* map_scalar_type(Type* t) {
+    if (!t) return NULL;
+    switch (t->kind) {
+        case TYPE_INT: return builtin_int;
+        case TYPE_FLOAT: return builtin_float;
+        case TYPE_STRING: return builtin_string;
+        case TYPE_BOOL: return builtin_bool;
+        default: return NULL;
+    }
+}
+
+static Type* map_scalar_type_named(Expr* type_expr) {
+    if (!type_expr || type_expr->type != EXPR_IDENT) return NULL;
+    Token t = type_expr->token;
+    if (type_name_is(t, "int")) return builtin_int;
+    if (type_name_is(t, "float")) return builtin_float;
+    if (type_name_is(t, "string") || type_name_is(t, "str")) return builtin_string;
+    if (type_name_is(t, "bool")) return builtin_bool;
+    return NULL;
+}
+
+// A map reads back int values unless its literal, its HashMap<K, V>
+// annotation or its first indexed assignment says otherwise
+static Type* map_value_type(Type* map_type) {
+    Type* value_type = map_type ? map_type->map_type.value_type : NULL;
+    return value_type ? value_type : builtin_int;
+}
+
+// What a spawned function's parameter hands to the other thread: nothing
+// counted for scalars, enums and structs of scalars, a string, map or array
+// the generated code can mark shared, or WYN_TYPE_UNKNOWN for anything it
+// cannot walk
+static int thread_escape_kind(Expr* type_expr, Type* arg_type) {
+    if (!type_expr) {
+        if (!arg_type) return -1;
+        switch (arg_type->kind) {
+            case TYPE_INT: case TYPE_FLOAT: case TYPE_BOOL: case TYPE_ENUM: return -1;
+            case TYPE_STRING: return WYN_TYPE_STRING;
+            case TYPE_MAP: return WYN_TYPE_MAP;
+            case TYPE_ARRAY: return WYN_TYPE_ARRAY;
+            default: return WYN_TYPE_UNKNOWN;
+        }
+    }
+    if (type_expr->type == EXPR_ARRAY) return WYN_TYPE_ARRAY;
+    if (type_expr->type != EXPR_IDENT) return WYN_TYPE_UNKNOWN;
+    Token t = type_expr->token;
+    if (type_name_is(t, "int") || type_name_is(t, "float") || type_name_is(t, "bool")) return -1;
+    if (type_name_is(t, "string") || type_name_is(t, "str")) return WYN_TYPE_STRING;
+    if (type_name_is(t, "HashMap")) return WYN_TYPE_MAP;
+    if (type_name_is(t, "array")) return WYN_TYPE_ARRAY;
+    if (find_enum_definition(t)) return -1;
+    StructStmt* def = find_struct_definition(t);
+    if (!def) return WYN_TYPE_UNKNOWN;
+    for (int i = 0; i < def->field_count; i++) {
+        Expr* field = def->field_types[i];
+        if (!field || field->type != EXPR_IDENT) return WYN_TYPE_UNKNOWN;
+        Token f = field->token;
+        if (!type_name_is(f, "int") && !type_name_is(f, "float") && !type_name_is(f, "bool")) {
+            return WYN_TYPE_UNKNOWN;
+        }
+    }
+    return -1;
+}
+
+// The arguments of spawn f(...) are the only values that reach another
+// thread; record each one codegen has to mark shared
+static void record_spawn_arguments(Expr* call) {
+    if (!call || call->type != EXPR_CALL || call->call.callee->type != EXPR_IDENT) return;
+    FnStmt* fn = find_fn_definition(call->call.callee->token);
+    for (int i = 0; i < call->call.arg_count; i++) {
+        Expr* arg = call->call.args[i];
+        Expr* param_type = fn && i < fn->param_count ? fn->param_types[i] : NULL;
+        int kind = thread_escape_kind(param_type, arg->expr_type);
+        if (kind < 0) continue;
+        AllocationSite* site = wyn_escape_register_allocation(arg, 0, (uint32_t)kind);
+        wyn_escape_mark(site, ESCAPE_ARGUMENT_ESCAPE);
+    }
+}
+
 // Helper function to get field type from struct definition
 static Type* get_struct_field_type(StructStmt* struct_def, Token field_name) {
     if (!struct_def) return NULL;
@@ -376,28 +638,74 @@ static Type* get_inner_type(Type* optional_type) {
     return optional_type->optional_type.inner_type;
 }
 
+// Scopes this small are scanned; bigger ones get a hash index
+#define SCOPE_INDEX_THRESHOLD 8
+
+// Scopes are keyed on interned ids; multiplying by an odd constant spreads
+// consecutive ids over the table without merging any two of them
+static uint32_t symbol_hash(uint32_t id) {
+    return id * 2654435761u;
+}
+
+static bool symbol_matches(const void* table, int entry, const void* key) {
+    return ((const SymbolTable*)table)->symbols[entry].id == *(const uint32_t*)key;
+}
+
+static void index_symbol(SymbolTable* scope, int entry) {
+    uint32_t id = scope->symbols[entry].id;
+    index_name(&scope->index, &scope->index_capacity, symbol_hash(id), entry, symbol_matches, scope, &id);
+}
+
+// First symbol with this id in this scope alone
+static Symbol* lookup_in_scope(SymbolTable* scope, uint32_t id) {
+    if (scope->index) {
+        NameSlot* slot = find_name_slot(scope->index, scope->index_capacity, symbol_hash(id),
+                                        symbol_matches, scope, &id);
+        return slot->entry ? &scope->symbols[slot->entry - 1] : NULL;
+    }
+    for (int i = 0; i < scope->count; i++) {
+        if (scope->symbols[i].id == id) return &scope->symbols[i];
+    }
+    return NULL;
+}
+
 void add_symbol(SymbolTable* scope, Token name, Type* type, bool is_mutable) {
     if (scope->count >= scope->capacity) {
         scope->capacity = scope->capacity == 0 ? 8 : scope->capacity * 2;
         scope->symbols = realloc(scope->symbols, scope->capacity * sizeof(Symbol));
     }
     scope->symbols[scope->count].name = name;
+    scope->symbols[scope->count].id = token_name_id(&name);
     scope->symbols[scope->count].type = type;
     scope->symbols[scope->count].is_mutable = is_mutable;
     scope->symbols[scope->count].next_overload = NULL;  // T1.5.3: Initialize overload chain
     scope->symbols[scope->count].mangled_name = NULL;   // T1.5.3: Initialize mangled name
     scope->count++;
+    
+    if (scope->index) {
+        index_symbol(scope, scope->count - 1);
+    } else if (scope->count > SCOPE_INDEX_THRESHOLD) {
+        for (int i = 0; i < scope->count; i++) index_symbol(scope, i);
+    }
+}
+
+void free_symbol_table(SymbolTable* scope) {
+    free(scope->symbols);
+    free(scope->index);
+    scope->symbols = NULL;
+    scope->index = NULL;
+    scope->count = scope->capacity = scope->index_capacity = 0;
 }
 
 static void mark_used(SymbolTable* scope, Token name) {
-    for (int i = 0; i < scope->count; i++) {
-        if (scope->symbols[i].name.length == name.length &&
-            memcmp(scope->symbols[i].name.start, name.start, name.length) == 0) {
-            scope->symbols[i].is_mutable = true; // Reuse flag to mark as used
+    uint32_t id = token_name_id(&name);
+    for (; scope; scope = scope->parent) {
+        Symbol* symbol = lookup_in_scope(scope, id);
+        if (symbol) {
+            symbol->is_mutable = true; // Reuse flag to mark as used
             return;
         }
     }
-    if (scope->parent) mark_used(scope->parent, name);
 }
 
 void init_checker() {
@@ -405,6 +713,10 @@ void init_checker() {
     global_scope->capacity = 128;
     global_scope->symbols = calloc(128, sizeof(Symbol));
     had_error = false;
+    current_decl = NULL;
+    reset_module_registries();
+    wyn_escape_analysis_init();
+    wyn_escape_reset();
     
     // Initialize trait system
     wyn_traits_init();
@@ -418,13 +730,17 @@ void init_checker() {
     
     // Register collection types
     Type* builtin_map = make_type(TYPE_MAP);
-    Token map_tok = {TOKEN_IDENT, "HashMap", 7, 0};
+    Token map_tok = {TOKEN_IDENT, "HashMap", 7, 0, 0};
     add_symbol(global_scope, map_tok, builtin_map, false);
     
     Type* builtin_set = make_type(TYPE_SET);
-    Token set_tok = {TOKEN_IDENT, "HashSet", 7, 0};
+    Token set_tok = {TOKEN_IDENT, "HashSet", 7, 0, 0};
     add_symbol(global_scope, set_tok, builtin_set, false);
     
+    Type* builtin_builder = make_type(TYPE_STRING_BUILDER);
+    Token builder_tok = {TOKEN_IDENT, "StringBuilder", 13, 0, 0};
+    add_symbol(global_scope, builder_tok, builtin_builder, false);
+    
     // Add built-in functions
     const char* stdlib_funcs[] = {
         "print", "print_float", "print_str", "print_bool", "print_hex", "print_bin", "println", "print_debug", "input", "input_float", "input_line", "printf_wyn", "sin_approx", "cos_approx", "pi_const", "e_const",
@@ -475,7 +791,7 @@ void init_checker() {
     };
     
     for (int i = 0; i < 214; i++) {  // Updated count: 217 - 3 = 214
-        Token tok = {TOKEN_IDENT, stdlib_funcs[i], (int)strlen(stdlib_funcs[i]), 0};
+        Token tok = {TOKEN_IDENT, stdlib_funcs[i], (int)strlen(stdlib_funcs[i]), 0, 0};
         add_symbol(global_scope, tok, builtin_int, false);
     }
     
@@ -483,7 +799,7 @@ void init_checker() {
     Type* get_argc_type = make_type(TYPE_FUNCTION);
     get_argc_type->fn_type.param_count = 0;
     get_argc_type->fn_type.return_type = builtin_int;
-    Token get_argc_tok = {TOKEN_IDENT, "get_argc", 8, 0};
+    Token get_argc_tok = {TOKEN_IDENT, "get_argc", 8, 0, 0};
     add_symbol(global_scope, get_argc_tok, get_argc_type, false);
     
     Type* get_argv_type = make_type(TYPE_FUNCTION);
@@ -491,7 +807,7 @@ void init_checker() {
     get_argv_type->fn_type.param_types = malloc(sizeof(Type*));
     get_argv_type->fn_type.param_types[0] = builtin_int;
     get_argv_type->fn_type.return_type = builtin_string;
-    Token get_argv_tok = {TOKEN_IDENT, "get_argv", 8, 0};
+    Token get_argv_tok = {TOKEN_IDENT, "get_argv", 8, 0, 0};
     add_symbol(global_scope, get_argv_tok, get_argv_type, false);
     
     Type* read_file_content_type = make_type(TYPE_FUNCTION);
@@ -499,7 +815,7 @@ void init_checker() {
     read_file_content_type->fn_type.param_types = malloc(sizeof(Type*));
     read_file_content_type->fn_type.param_types[0] = builtin_string;
     read_file_content_type->fn_type.return_type = builtin_string;
-    Token read_file_content_tok = {TOKEN_IDENT, "read_file_content", 17, 0};
+    Token read_file_content_tok = {TOKEN_IDENT, "read_file_content", 17, 0, 0};
     add_symbol(global_scope, read_file_content_tok, read_file_content_type, false);
     
     Type* check_file_exists_type = make_type(TYPE_FUNCTION);
@@ -507,7 +823,7 @@ void init_checker() {
     check_file_exists_type->fn_type.param_types = malloc(sizeof(Type*));
     check_file_exists_type->fn_type.param_types[0] = builtin_string;
     check_file_exists_type->fn_type.return_type = builtin_bool;
-    Token check_file_exists_tok = {TOKEN_IDENT, "check_file_exists", 17, 0};
+    Token check_file_exists_tok = {TOKEN_IDENT, "check_file_exists", 17, 0, 0};
     add_symbol(global_scope, check_file_exists_tok, check_file_exists_type, false);
     
     Type* is_content_valid_type = make_type(TYPE_FUNCTION);
@@ -515,7 +831,7 @@ void init_checker() {
     is_content_valid_type->fn_type.param_types = malloc(sizeof(Type*));
     is_content_valid_type->fn_type.param_types[0] = builtin_string;
     is_content_valid_type->fn_type.return_type = builtin_bool;
-    Token is_content_valid_tok = {TOKEN_IDENT, "is_content_valid", 16, 0};
+    Token is_content_valid_tok = {TOKEN_IDENT, "is_content_valid", 16, 0, 0};
     add_symbol(global_scope, is_content_valid_tok, is_content_valid_type, false);
     
     // Add compiler interface functions
@@ -524,25 +840,25 @@ void init_checker() {
     c_init_lexer_type->fn_type.param_types = malloc(sizeof(Type*));
     c_init_lexer_type->fn_type.param_types[0] = builtin_string;
     c_init_lexer_type->fn_type.return_type = builtin_bool;
-    Token c_init_lexer_tok = {TOKEN_IDENT, "c_init_lexer", 12, 0};
+    Token c_init_lexer_tok = {TOKEN_IDENT, "c_init_lexer", 12, 0, 0};
     add_symbol(global_scope, c_init_lexer_tok, c_init_lexer_type, false);
     
     Type* c_init_parser_type = make_type(TYPE_FUNCTION);
     c_init_parser_type->fn_type.param_count = 0;
     c_init_parser_type->fn_type.return_type = builtin_int;
-    Token c_init_parser_tok = {TOKEN_IDENT, "c_init_parser", 13, 0};
+    Token c_init_parser_tok = {TOKEN_IDENT, "c_init_parser", 13, 0, 0};
     add_symbol(global_scope, c_init_parser_tok, c_init_parser_type, false);
     
     Type* c_parse_program_type = make_type(TYPE_FUNCTION);
     c_parse_program_type->fn_type.param_count = 0;
     c_parse_program_type->fn_type.return_type = builtin_int;
-    Token c_parse_program_tok = {TOKEN_IDENT, "c_parse_program", 15, 0};
+    Token c_parse_program_tok = {TOKEN_IDENT, "c_parse_program", 15, 0, 0};
     add_symbol(global_scope, c_parse_program_tok, c_parse_program_type, false);
     
     Type* c_init_checker_type = make_type(TYPE_FUNCTION);
     c_init_checker_type->fn_type.param_count = 0;
     c_init_checker_type->fn_type.return_type = builtin_int;
-    Token c_init_checker_tok = {TOKEN_IDENT, "c_init_checker", 14, 0};
+    Token c_init_checker_tok = {TOKEN_IDENT, "c_init_checker", 14, 0, 0};
     add_symbol(global_scope, c_init_checker_tok, c_init_checker_type, false);
     
     Type* c_check_program_type = make_type(TYPE_FUNCTION);
@@ -550,13 +866,13 @@ void init_checker() {
     c_check_program_type->fn_type.param_types = malloc(sizeof(Type*));
     c_check_program_type->fn_type.param_types[0] = builtin_int;
     c_check_program_type->fn_type.return_type = builtin_int;
-    Token c_check_program_tok = {TOKEN_IDENT, "c_check_program", 15, 0};
+    Token c_check_program_tok = {TOKEN_IDENT, "c_check_program", 15, 0, 0};
     add_symbol(global_scope, c_check_program_tok, c_check_program_type, false);
     
     Type* c_checker_had_error_type = make_type(TYPE_FUNCTION);
     c_checker_had_error_type->fn_type.param_count = 0;
     c_checker_had_error_type->fn_type.return_type = builtin_bool;
-    Token c_checker_had_error_tok = {TOKEN_IDENT, "c_checker_had_error", 19, 0};
+    Token c_checker_had_error_tok = {TOKEN_IDENT, "c_checker_had_error", 19, 0, 0};
     add_symbol(global_scope, c_checker_had_error_tok, c_checker_had_error_type, false);
     
     Type* c_generate_code_type = make_type(TYPE_FUNCTION);
@@ -565,7 +881,7 @@ void init_checker() {
     c_generate_code_type->fn_type.param_types[0] = builtin_int;
     c_generate_code_type->fn_type.param_types[1] = builtin_string;
     c_generate_code_type->fn_type.return_type = builtin_bool;
-    Token c_generate_code_tok = {TOKEN_IDENT, "c_generate_code", 15, 0};
+    Token c_generate_code_tok = {TOKEN_IDENT, "c_generate_code", 15, 0, 0};
     add_symbol(global_scope, c_generate_code_tok, c_generate_code_type, false);
     
     Type* c_create_c_filename_type = make_type(TYPE_FUNCTION);
@@ -573,7 +889,7 @@ void init_checker() {
     c_create_c_filename_type->fn_type.param_types = malloc(sizeof(Type*));
     c_create_c_filename_type->fn_type.param_types[0] = builtin_string;
     c_create_c_filename_type->fn_type.return_type = builtin_string;
-    Token c_create_c_filename_tok = {TOKEN_IDENT, "c_create_c_filename", 19, 0};
+    Token c_create_c_filename_tok = {TOKEN_IDENT, "c_create_c_filename", 19, 0, 0};
     add_symbol(global_scope, c_create_c_filename_tok, c_create_c_filename_type, false);
     
     Type* c_compile_to_binary_type = make_type(TYPE_FUNCTION);
@@ -582,7 +898,7 @@ void init_checker() {
     c_compile_to_binary_type->fn_type.param_types[0] = builtin_string;
     c_compile_to_binary_type->fn_type.param_types[1] = builtin_string;
     c_compile_to_binary_type->fn_type.return_type = builtin_bool;
-    Token c_compile_to_binary_tok = {TOKEN_IDENT, "c_compile_to_binary", 19, 0};
+    Token c_compile_to_binary_tok = {TOKEN_IDENT, "c_compile_to_binary", 19, 0, 0};
     add_symbol(global_scope, c_compile_to_binary_tok, c_compile_to_binary_type, false);
     
     Type* c_remove_file_type = make_type(TYPE_FUNCTION);
@@ -590,18 +906,16 @@ void init_checker() {
     c_remove_file_type->fn_type.param_types = malloc(sizeof(Type*));
     c_remove_file_type->fn_type.param_types[0] = builtin_string;
     c_remove_file_type->fn_type.return_type = builtin_bool;
-    Token c_remove_file_tok = {TOKEN_IDENT, "c_remove_file", 13, 0};
+    Token c_remove_file_tok = {TOKEN_IDENT, "c_remove_file", 13, 0, 0};
     add_symbol(global_scope, c_remove_file_tok, c_remove_file_type, false);
 }
 
 Symbol* find_symbol(SymbolTable* scope, Token name) {
-    for (int i = 0; i < scope->count; i++) {
-        if (scope->symbols[i].name.length == name.length &&
-            memcmp(scope->symbols[i].name.start, name.start, name.length) == 0) {
-            return &scope->symbols[i];
-        }
+    uint32_t id = token_name_id(&name);
+    for (; scope; scope = scope->parent) {
+        Symbol* symbol = lookup_in_scope(scope, id);
+        if (symbol) return symbol;
     }
-    if (scope->parent) return find_symbol(scope->parent, name);
     return NULL;
 }
 
@@ -634,6 +948,7 @@ static void add_function_overload(SymbolTable* scope, Token name, Type* type, bo
         // Create new overload
         current->next_overload = malloc(sizeof(Symbol));
         current->next_overload->name = name;
+        current->next_overload->id = existing->id;
         current->next_overload->type = type;
         current->next_overload->is_mutable = is_mutable;
         current->next_overload->next_overload = NULL;
@@ -755,6 +1070,7 @@ static bool can_convert_type(Type* from, Type* to) {
 
 Type* check_expr(Expr* expr, SymbolTable* scope) {
     if (!expr) return NULL;
+    if (expr->token.line > 0) current_line = expr->token.line;
     
     // Handle generic type instantiation: HashMap<K,V>, Option<T>, etc.
     // Parser represents this as EXPR_CALL with type arguments
@@ -772,6 +1088,10 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
             Type* base_type = NULL;
             if (type_name.length == 7 && memcmp(type_name.start, "HashMap", 7) == 0) {
                 base_type = make_type(TYPE_MAP);
+                if (expr->call.arg_count == 2) {
+                    base_type->map_type.key_type = map_scalar_type_named(expr->call.args[0]);
+                    base_type->map_type.value_type = map_scalar_type_named(expr->call.args[1]);
+                }
             } else if (type_name.length == 7 && memcmp(type_name.start, "HashSet", 7) == 0) {
                 base_type = make_type(TYPE_SET);
             } else if (type_name.length == 6 && memcmp(type_name.start, "Option", 6) == 0) {
@@ -861,19 +1181,19 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
                     return builtin_int;
                 }
                 
-                fprintf(stderr, "\nError at line %d: Undefined variable '%.*s'\n", 
-                        expr->token.line, expr->token.length, expr->token.start);
+                compile_error(ERR_UNDEFINED_VARIABLE, expr->token.line, "Undefined variable '%.*s'",
+                              expr->token.length, expr->token.start);
                 
                 // Suggest similar names
-                fprintf(stderr, "  Available variables in scope:\n");
+                compile_note("  Available variables in scope:\n");
                 int suggestions = 0;
                 for (int i = 0; i < scope->count && suggestions < 3; i++) {
-                    fprintf(stderr, "    - %.*s\n",
-                            scope->symbols[i].name.length, scope->symbols[i].name.start);
+                    compile_note("    - %.*s\n",
+                                 scope->symbols[i].name.length, scope->symbols[i].name.start);
                     suggestions++;
                 }
                 if (suggestions == 0) {
-                    fprintf(stderr, "    (none)\n");
+                    compile_note("    (none)\n");
                 }
                 
                 had_error = true;
@@ -906,8 +1226,8 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
                 bool right_ok = (right->kind == TYPE_BOOL || right->kind == TYPE_INT);
                 
                 if (!left_ok || !right_ok) {
-                    fprintf(stderr, "Error at line %d: Boolean operation requires bool or int operands\n", 
-                            expr->binary.op.line);
+                    compile_error(ERR_TYPE_MISMATCH, expr->binary.op.line,
+                                  "Boolean operation requires bool or int operands");
                     had_error = true;
                     return NULL;
                 }
@@ -930,8 +1250,7 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
                                        (left->kind == TYPE_ENUM && right->kind == TYPE_ENUM);
                 
                 if (!types_compatible) {
-                    fprintf(stderr, "Error at line %d: Cannot compare different types\n", 
-                            expr->binary.op.line);
+                    compile_error(ERR_TYPE_MISMATCH, expr->binary.op.line, "Cannot compare different types");
                     had_error = true;
                     return NULL;
                 }
@@ -956,8 +1275,9 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
             }
             
             if (left->kind != right->kind) {
-                fprintf(stderr, "Error at line %d: Type mismatch in binary expression (left: %d, right: %d, op: %d)\n", 
-                        expr->binary.op.line, left->kind, right->kind, expr->binary.op.type);
+                compile_error(ERR_TYPE_MISMATCH, expr->binary.op.line,
+                              "Type mismatch in binary expression (left: %d, right: %d, op: %d)",
+                              left->kind, right->kind, expr->binary.op.type);
                 had_error = true;
                 return NULL;
             }
@@ -1022,12 +1342,12 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
                     char first_path[256], second_path[256];
                     int first_line, second_line;
                     if (is_ambiguous_module(qual_module, first_path, &first_line, second_path, &second_line)) {
-                        fprintf(stderr, "Error at line %d: Ambiguous module name '%s'\n",
-                                expr->call.callee->token.line, qual_module);
-                        fprintf(stderr, "  Could refer to:\n");
-                        fprintf(stderr, "    - %s (imported at line %d)\n", first_path, first_line);
-                        fprintf(stderr, "    - %s (imported at line %d)\n", second_path, second_line);
-                        fprintf(stderr, "  Use full path to disambiguate:\n");
+                        compile_error(ERR_UNDEFINED_FUNCTION, expr->call.callee->token.line,
+                                      "Ambiguous module name '%s'", qual_module);
+                        compile_note("  Could refer to:\n");
+                        compile_note("    - %s (imported at line %d)\n", first_path, first_line);
+                        compile_note("    - %s (imported at line %d)\n", second_path, second_line);
+                        compile_note("  Use full path to disambiguate:\n");
                         
                         char c_ident1[256], c_ident2[256];
                         strcpy(c_ident1, first_path);
@@ -1035,17 +1355,17 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
                         for (char* p = c_ident1; *p; p++) if (*p == '/') *p = '_';
                         for (char* p = c_ident2; *p; p++) if (*p == '/') *p = '_';
                         
-                        fprintf(stderr, "    - %s::%s()\n", c_ident1, qual_func);
-                        fprintf(stderr, "    - %s::%s()\n", c_ident2, qual_func);
+                        compile_note("    - %s::%s()\n", c_ident1, qual_func);
+                        compile_note("    - %s::%s()\n", c_ident2, qual_func);
                         had_error = true;
                         free(arg_types);
                         return builtin_int;
                     }
                     
                     if (!check_function_visibility(qual_module, qual_func)) {
-                        fprintf(stderr, "Error at line %d: Function '%s' in module '%s' is private\n",
-                                expr->call.callee->token.line, qual_func, qual_module);
-                        fprintf(stderr, "  Note: Only 'pub' functions can be called from outside the module\n");
+                        compile_error(ERR_UNDEFINED_FUNCTION, expr->call.callee->token.line,
+                                      "Function '%s' in module '%s' is private", qual_func, qual_module);
+                        compile_note("  Note: Only 'pub' functions can be called from outside the module\n");
                         had_error = true;
                         free(arg_types);
                         return builtin_int;
@@ -1067,8 +1387,9 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
                         char func_name[256];
                         snprintf(func_name, sizeof(func_name), "%.*s", 
                                 expr->call.callee->token.length, expr->call.callee->token.start);
-                        fprintf(stderr, "Error: Function call validation failed for '%s': %s\n",
-                                func_name, wyn_validation_error_message(validation));
+                        compile_error(ERR_WRONG_ARG_COUNT, expr->call.callee->token.line,
+                                      "Function call validation failed for '%s': %s",
+                                      func_name, wyn_validation_error_message(validation));
                         had_error = true;
                     }
                     
@@ -1081,8 +1402,9 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
                     char func_name[256];
                     snprintf(func_name, sizeof(func_name), "%.*s", 
                             expr->call.callee->token.length, expr->call.callee->token.start);
-                    fprintf(stderr, "Error: No matching overload found for function '%s' with %d arguments\n",
-                            func_name, expr->call.arg_count);
+                    compile_error(ERR_UNDEFINED_FUNCTION, expr->call.callee->token.line,
+                                  "No matching overload found for function '%s' with %d arguments",
+                                  func_name, expr->call.arg_count);
                     had_error = true;
                 }
                 
@@ -1097,13 +1419,15 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
                 // For variadic functions, allow any number of arguments >= param_count
                 if (callee_type->fn_type.is_variadic) {
                     if (expr->call.arg_count < callee_type->fn_type.param_count) {
-                        fprintf(stderr, "Error: Variadic function expects at least %d arguments, got %d\n",
-                                callee_type->fn_type.param_count, expr->call.arg_count);
+                        compile_error(ERR_WRONG_ARG_COUNT, expr->token.line,
+                                      "Variadic function expects at least %d arguments, got %d",
+                                      callee_type->fn_type.param_count, expr->call.arg_count);
                         had_error = true;
                     }
                 } else if (expr->call.arg_count != callee_type->fn_type.param_count) {
-                    fprintf(stderr, "Error: Parameter count mismatch - function expects %d arguments, got %d\n",
-                            callee_type->fn_type.param_count, expr->call.arg_count);
+                    compile_error(ERR_WRONG_ARG_COUNT, expr->token.line,
+                                  "Parameter count mismatch - function expects %d arguments, got %d",
+                                  callee_type->fn_type.param_count, expr->call.arg_count);
                     had_error = true;
                 }
                 
@@ -1114,11 +1438,12 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
                     Type* actual_type = check_expr(expr->call.args[i], scope);
                     
                     if (!wyn_is_type_compatible(expected_type, actual_type)) {
-                        fprintf(stderr, "Error: Type mismatch for argument %d - expected ", i + 1);
-                        print_type_name(expected_type);
-                        fprintf(stderr, ", got ");
-                        print_type_name(actual_type);
-                        fprintf(stderr, "\n");
+                        char expected_name[128] = "", actual_name[128] = "";
+                        format_type_name(expected_type, expected_name, sizeof(expected_name));
+                        format_type_name(actual_type, actual_name, sizeof(actual_name));
+                        compile_error(ERR_TYPE_MISMATCH, current_line,
+                                      "Type mismatch for argument %d - expected %s, got %s",
+                                      i + 1, expected_name, actual_name);
                         had_error = true;
                     }
                 }
@@ -1142,9 +1467,24 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
                 check_expr(expr->method_call.args[i], scope);
             }
             
+            // Join handles from spawn: join() yields the spawned function's result
+            if (object_type && object_type->kind == TYPE_SPAWN) {
+                Token method = expr->method_call.method;
+                if (!(method.length == 4 && memcmp(method.start, "join", 4) == 0) ||
+                    expr->method_call.arg_count != 0) {
+                    compile_error(ERR_INVALID_EXPRESSION, method.line, "Spawn handles only support join()");
+                    had_error = true;
+                }
+                expr->expr_type = object_type->spawn_type.result_type;
+                return expr->expr_type;
+            }
+            
             // Special handling for array.get() - return element type
             if (object_type && object_type->kind == TYPE_ARRAY) {
                 Token method = expr->method_call.method;
+                if (method.length == 11 && memcmp(method.start, "sort_by_key", 11) == 0) {
+                    check_sort_by_key(object_type->array_type.element_type, expr);
+                }
                 if (method.length == 3 && memcmp(method.start, "get", 3) == 0) {
                     // Return the element type if known
                     if (object_type->array_type.element_type) {
@@ -1189,6 +1529,35 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
             expr->expr_type = builtin_int;
             return builtin_int;
         }
+        case EXPR_AWAIT: {
+            Type* future = check_expr(expr->await.expr, scope);
+            if (future && future->kind != TYPE_FUTURE) {
+                char name[128] = "";
+                format_type_name(future, name, sizeof(name));
+                compile_error(ERR_TYPE_MISMATCH, current_line,
+                              "await expects an async fn call or an Async:: future, got %s", name);
+                had_error = true;
+                return NULL;
+            }
+            Type* value_type = future && future->future_type.value_type ? future->future_type.value_type : builtin_int;
+            expr->expr_type = value_type;
+            return value_type;
+        }
+        case EXPR_SPAWN: {
+            Expr* call = expr->spawn.call;
+            if (!call || call->type != EXPR_CALL || call->call.callee->type != EXPR_IDENT) {
+                compile_error(ERR_INVALID_EXPRESSION, expr->token.line, "spawn expects a function call");
+                had_error = true;
+                return NULL;
+            }
+            Type* result_type = check_expr(call, scope);
+            record_spawn_arguments(call);
+            Type* handle = make_type(TYPE_SPAWN);
+            handle->spawn_type.fn_name = call->call.callee->token;
+            handle->spawn_type.result_type = result_type ? result_type : builtin_int;
+            expr->expr_type = handle;
+            return handle;
+        }
         case EXPR_ARRAY: {
             // Check array elements and ensure type consistency
             if (expr->array.count > 0) {
@@ -1198,7 +1567,7 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
                 for (int i = 1; i < expr->array.count; i++) {
                     Type* elem_type = check_expr(expr->array.elements[i], scope);
                     if (elem_type && element_type && elem_type->kind != element_type->kind) {
-                        fprintf(stderr, "Error: Array elements must have consistent types\n");
+                        compile_error(ERR_TYPE_MISMATCH, current_line, "Array elements must have consistent types");
                         had_error = true;
                         return NULL;
                     }
@@ -1215,8 +1584,20 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
             return builtin_array;
         }
         case EXPR_HASHMAP_LITERAL: {
-            // v1.3.0: {} creates a hashmap with proper type
+            // v1.3.0: {} creates a hashmap with proper type; elements are
+            // stored key, value, key, value...
             Type* map_type = make_type(TYPE_MAP);
+            for (int i = 0; i + 1 < expr->array.count; i += 2) {
+                Type* key_type = map_scalar_type(check_expr(expr->array.elements[i], scope));
+                Type* value_type = map_scalar_type(check_expr(expr->array.elements[i + 1], scope));
+                if (i == 0) {
+                    map_type->map_type.key_type = key_type;
+                    map_type->map_type.value_type = value_type;
+                } else if (map_type->map_type.value_type != value_type) {
+                    // Mixed values read back as int, as before
+                    map_type->map_type.value_type = NULL;
+                }
+            }
             expr->expr_type = map_type;
             return map_type;
         }
@@ -1233,7 +1614,7 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
             // Check if this is string indexing
             if (array_type && array_type->kind == TYPE_STRING) {
                 if (idx_type && idx_type->kind != TYPE_INT) {
-                    fprintf(stderr, "Error: String index must be int\n");
+                    compile_error(ERR_TYPE_MISMATCH, current_line, "String index must be int");
                     return NULL;
                 }
                 expr->expr_type = builtin_string; // Return single-char string
@@ -1242,17 +1623,18 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
             
             // Allow string indices for maps, int indices for arrays
             if (array_type && array_type->kind == TYPE_MAP) {
-                // Map indexing - allow string keys
-                if (idx_type && idx_type->kind != TYPE_STRING) {
-                    fprintf(stderr, "Error: Map index must be string\n");
+                // Map indexing - string or int keys
+                if (idx_type && idx_type->kind != TYPE_STRING && idx_type->kind != TYPE_INT) {
+                    compile_error(ERR_TYPE_MISMATCH, current_line, "Map index must be string or int");
                     return NULL;
                 }
-                expr->expr_type = builtin_int; // Map value type (simplified)
-                return builtin_int;
+                Type* value_type = map_value_type(array_type);
+                expr->expr_type = value_type;
+                return value_type;
             } else {
                 // Array indexing - require int indices
                 if (idx_type && idx_type->kind != TYPE_INT) {
-                    fprintf(stderr, "Error: Array index must be int\n");
+                    compile_error(ERR_TYPE_MISMATCH, current_line, "Array index must be int");
                     return NULL;
                 }
                 
@@ -1324,8 +1706,8 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
         case EXPR_ASSIGN: {
             Symbol* sym = find_symbol(scope, expr->assign.name);
             if (!sym) {
-                fprintf(stderr, "Error: Undefined variable '%.*s'\n",
-                        expr->assign.name.length, expr->assign.name.start);
+                compile_error(ERR_UNDEFINED_VARIABLE, expr->assign.name.line, "Undefined variable '%.*s'",
+                              expr->assign.name.length, expr->assign.name.start);
                 return NULL;
             }
             Type* val_type = check_expr(expr->assign.value, scope);
@@ -1334,8 +1716,9 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
             if (val_type && sym->type) {
                 // Check if assigning optional to non-optional
                 if (!is_optional_type(sym->type) && is_optional_type(val_type)) {
-                    fprintf(stderr, "Error: Cannot assign optional type to non-optional variable '%.*s'\n",
-                            expr->assign.name.length, expr->assign.name.start);
+                    compile_error(ERR_INVALID_ASSIGNMENT, expr->assign.name.line,
+                                  "Cannot assign optional type to non-optional variable '%.*s'",
+                                  expr->assign.name.length, expr->assign.name.start);
                     had_error = true;
                     return NULL;
                 }
@@ -1343,7 +1726,7 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
                 Type* sym_inner = get_inner_type(sym->type);
                 Type* val_inner = get_inner_type(val_type);
                 if (sym_inner->kind != val_inner->kind) {
-                    fprintf(stderr, "Error: Type mismatch in assignment\n");
+                    compile_error(ERR_INVALID_ASSIGNMENT, current_line, "Type mismatch in assignment");
                     return NULL;
                 }
             }
@@ -1368,6 +1751,15 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
             return builtin_int;
         }
         case EXPR_STRING_INTERP:
+            // Parts are bare names; record their types so codegen can format them
+            for (int i = 0; i < expr->string_interp.count; i++) {
+                Expr* part = expr->string_interp.expressions[i];
+                if (part && part->type == EXPR_IDENT) {
+                    Symbol* sym = find_symbol(scope, part->token);
+                    if (sym) part->expr_type = sym->type;
+                }
+            }
+            expr->expr_type = builtin_string;
             return builtin_string;
         case EXPR_RANGE:
             return builtin_int; // Range type
@@ -1447,7 +1839,7 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
                         enum_name.length, enum_name.start,
                         member_name.length, member_name.start);
                 
-                Token qualified_token = {TOKEN_IDENT, qualified_member, (int)strlen(qualified_member), 0};
+                Token qualified_token = {TOKEN_IDENT, qualified_member, (int)strlen(qualified_member), 0, 0};
                 Symbol* enum_member_symbol = find_symbol(global_scope, qualified_token);
                 
                 if (enum_member_symbol) {
@@ -1484,7 +1876,7 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
                      obj_name.length, obj_name.start,
                      field_name.length, field_name.start);
             
-            Token qualified_token = {TOKEN_IDENT, qualified_name, (int)strlen(qualified_name), 0};
+            Token qualified_token = {TOKEN_IDENT, qualified_name, (int)strlen(qualified_name), 0, 0};
             Symbol* sym = find_symbol(scope, qualified_token);
             if (sym) {
                 return sym->type;
@@ -1494,9 +1886,12 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
         }
         case EXPR_INDEX_ASSIGN: {
             // Check index assignment
-            check_expr(expr->index_assign.object, scope);
+            Type* object_type = check_expr(expr->index_assign.object, scope);
             check_expr(expr->index_assign.index, scope);
-            check_expr(expr->index_assign.value, scope);
+            Type* value_type = check_expr(expr->index_assign.value, scope);
+            if (object_type && object_type->kind == TYPE_MAP && !object_type->map_type.value_type) {
+                object_type->map_type.value_type = map_scalar_type(value_type);
+            }
             return builtin_int; // Assignment returns int (simplified)
         }
         case EXPR_FIELD_ASSIGN: {
@@ -1582,7 +1977,7 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
         case EXPR_OK: {
             // TASK-026: Ok(value) expression - creates Result type
             if (!expr->option.value) {
-                fprintf(stderr, "Error: Ok() requires a value\n");
+                compile_error(ERR_INVALID_EXPRESSION, current_line, "Ok() requires a value");
                 had_error = true;
                 return NULL;
             }
@@ -1598,7 +1993,7 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
         case EXPR_ERR: {
             // TASK-026: Err(error) expression - creates Result type
             if (!expr->option.value) {
-                fprintf(stderr, "Error: Err() requires an error value\n");
+                compile_error(ERR_INVALID_EXPRESSION, current_line, "Err() requires an error value");
                 had_error = true;
                 return NULL;
             }
@@ -1614,14 +2009,14 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
         case EXPR_TRY: {
             // TASK-026: ? operator for error propagation
             if (!expr->try_expr.value) {
-                fprintf(stderr, "Error: ? operator requires an expression\n");
+                compile_error(ERR_INVALID_EXPRESSION, current_line, "? operator requires an expression");
                 had_error = true;
                 return NULL;
             }
             
             Type* value_type = check_expr(expr->try_expr.value, scope);
             if (!value_type || !is_result_type(value_type)) {
-                fprintf(stderr, "Error: ? operator can only be used on Result types\n");
+                compile_error(ERR_TYPE_MISMATCH, current_line, "? operator can only be used on Result types");
                 had_error = true;
                 return NULL;
             }
@@ -1644,7 +2039,7 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
         case EXPR_SOME: {
             // T2.5.1: Some(value) expression - creates optional type
             if (!expr->option.value) {
-                fprintf(stderr, "Error: Some() requires a value\n");
+                compile_error(ERR_INVALID_EXPRESSION, current_line, "Some() requires a value");
                 had_error = true;
                 return NULL;
             }
@@ -1732,7 +2127,7 @@ Type* check_expr(Expr* expr, SymbolTable* scope) {
                 if (result_type == NULL) {
                     result_type = arm_type;
                 } else if (!types_equal(result_type, arm_type)) {
-                    fprintf(stderr, "Error: Match arms have different types\n");
+                    compile_error(ERR_TYPE_MISMATCH, current_line, "Match arms have different types");
                     had_error = true;
                     return NULL;
                 }
@@ -1855,7 +2250,7 @@ void check_stmt(Stmt* stmt, SymbolTable* scope) {
                 // Process let binding with pattern matching
                 if (stmt->var.init) {
                     if (!wyn_process_let_binding(stmt->var.pattern, stmt->var.init, scope)) {
-                        printf("Error: Failed to process pattern in let binding\n");
+                        compile_error(ERR_INVALID_ASSIGNMENT, current_line, "Failed to process pattern in let binding");
                         had_error = true;
                     }
                     
@@ -1864,11 +2259,18 @@ void check_stmt(Stmt* stmt, SymbolTable* scope) {
                         wyn_check_let_pattern_completeness(stmt->var.pattern, init_type);
                     }
                 } else {
-                    printf("Error: Pattern-based let binding requires initialization\n");
+                    compile_error(ERR_INVALID_ASSIGNMENT, current_line, "Pattern-based let binding requires initialization");
                     had_error = true;
                 }
             } else {
                 // Traditional single variable declaration
+                if (init_type && init_type->kind == TYPE_MAP) {
+                    // Each map variable records its own value type (see
+                    // map_value_type); HashMap::new() shares one Type
+                    Type* own = make_type(TYPE_MAP);
+                    own->map_type = init_type->map_type;
+                    init_type = own;
+                }
                 if (init_type) {
                     add_symbol(scope, stmt->var.name, init_type, !stmt->var.is_const);
                 }
@@ -1889,11 +2291,11 @@ void check_stmt(Stmt* stmt, SymbolTable* scope) {
                         break;
                     }
                     if (current_function_return_type->kind != return_expr_type->kind) {
-                        fprintf(stderr, "Error: Return type mismatch. Expected ");
-                        print_type_name(current_function_return_type);
-                        fprintf(stderr, ", got ");
-                        print_type_name(return_expr_type);
-                        fprintf(stderr, "\n");
+                        char expected_name[128] = "", actual_name[128] = "";
+                        format_type_name(current_function_return_type, expected_name, sizeof(expected_name));
+                        format_type_name(return_expr_type, actual_name, sizeof(actual_name));
+                        compile_error(ERR_TYPE_MISMATCH, current_line,
+                                      "Return type mismatch. Expected %s, got %s", expected_name, actual_name);
                         had_error = true;
                     }
                 }
@@ -2000,7 +2402,7 @@ void check_stmt(Stmt* stmt, SymbolTable* scope) {
                 check_stmt(fn->body, &fn_scope);
             }
             
-            free(fn_scope.symbols);
+            free_symbol_table(&fn_scope);
             break;
         }
         case STMT_CONST: {
@@ -2234,7 +2636,7 @@ void check_stmt(Stmt* stmt, SymbolTable* scope) {
                             stmt->enum_decl.name.length, stmt->enum_decl.name.start,
                             stmt->enum_decl.variants[i].length, stmt->enum_decl.variants[i].start);
                     
-                    Token qualified_token_dot = {TOKEN_IDENT, strdup(qualified_member_dot), (int)strlen(qualified_member_dot), 0};
+                    Token qualified_token_dot = {TOKEN_IDENT, strdup(qualified_member_dot), (int)strlen(qualified_member_dot), 0, 0};
                     add_symbol(global_scope, qualified_token_dot, enum_type, false);
                     
                     // Register qualified variant with :: (e.g., Status::DONE) - maps to Status_DONE in C
@@ -2243,7 +2645,7 @@ void check_stmt(Stmt* stmt, SymbolTable* scope) {
                             stmt->enum_decl.name.length, stmt->enum_decl.name.start,
                             stmt->enum_decl.variants[i].length, stmt->enum_decl.variants[i].start);
                     
-                    Token qualified_token_colon = {TOKEN_IDENT, strdup(qualified_member_colon), (int)strlen(qualified_member_colon), 0};
+                    Token qualified_token_colon = {TOKEN_IDENT, strdup(qualified_member_colon), (int)strlen(qualified_member_colon), 0, 0};
                     add_symbol(global_scope, qualified_token_colon, enum_type, false);
                     
                     // Also register with _ for C compatibility (e.g., Status_DONE)
@@ -2252,7 +2654,7 @@ void check_stmt(Stmt* stmt, SymbolTable* scope) {
                             stmt->enum_decl.name.length, stmt->enum_decl.name.start,
                             stmt->enum_decl.variants[i].length, stmt->enum_decl.variants[i].start);
                     
-                    Token qualified_token_underscore = {TOKEN_IDENT, strdup(qualified_member_underscore), (int)strlen(qualified_member_underscore), 0};
+                    Token qualified_token_underscore = {TOKEN_IDENT, strdup(qualified_member_underscore), (int)strlen(qualified_member_underscore), 0, 0};
                     add_symbol(global_scope, qualified_token_underscore, enum_type, false);
                     
                     // Register constructor function for variants with data
@@ -2263,7 +2665,7 @@ void check_stmt(Stmt* stmt, SymbolTable* scope) {
                                 stmt->enum_decl.name.length, stmt->enum_decl.name.start,
                                 stmt->enum_decl.variants[i].length, stmt->enum_decl.variants[i].start);
                         
-                        Token constructor_token = {TOKEN_IDENT, strdup(constructor_name), (int)strlen(constructor_name), 0};
+                        Token constructor_token = {TOKEN_IDENT, strdup(constructor_name), (int)strlen(constructor_name), 0, 0};
                         
                         Type* constructor_type = make_type(TYPE_FUNCTION);
                         constructor_type->fn_type.param_count = stmt->enum_decl.variant_type_counts[i];
@@ -2284,7 +2686,7 @@ void check_stmt(Stmt* stmt, SymbolTable* scope) {
                 snprintf(tostring_name, 128, "%.*s_toString",
                         stmt->enum_decl.name.length, stmt->enum_decl.name.start);
                 
-                Token tostring_token = {TOKEN_IDENT, strdup(tostring_name), (int)strlen(tostring_name), 0};
+                Token tostring_token = {TOKEN_IDENT, strdup(tostring_name), (int)strlen(tostring_name), 0, 0};
                 
                 Type* tostring_type = make_type(TYPE_FUNCTION);
                 tostring_type->fn_type.param_count = 1;
@@ -2298,11 +2700,18 @@ void check_stmt(Stmt* stmt, SymbolTable* scope) {
             // Register type alias in global scope
             add_symbol(global_scope, stmt->type_alias.name, builtin_int, false);
             break;
+        case STMT_SPAWN:
+            check_expr(stmt->spawn.call, scope);
+            record_spawn_arguments(stmt->spawn.call);
+            break;
+        case STMT_SCOPE:
+            check_stmt(stmt->scope.body, scope);
+            break;
         case STMT_IMPORT:
             // Register module namespace in scope
             add_symbol(scope, stmt->import.module, builtin_int, false);
             // Check for collision
-            register_import(stmt->import.module.start, stmt->import.module.line);
+            register_import(stmt->import.module.start, stmt->import.module.length, stmt->import.module.line);
             break;
         case STMT_MATCH: {
             // Type-check match statement with exhaustiveness checking
@@ -2431,8 +2840,9 @@ void check_stmt(Stmt* stmt, SymbolTable* scope) {
                             for (int v = 0; v < sym->type->enum_type.variant_count; v++) {
                                 if (!covered[v]) {
                                     Token variant = sym->type->enum_type.variants[v];
-                                    fprintf(stderr, "Error: non-exhaustive match, missing case: %.*s\n",
-                                            variant.length, variant.start);
+                                    compile_error(ERR_INVALID_EXPRESSION, current_line,
+                                                  "non-exhaustive match, missing case: %.*s",
+                                                  variant.length, variant.start);
                                     had_error = true;
                                 }
                             }
@@ -2453,9 +2863,11 @@ void check_stmt(Stmt* stmt, SymbolTable* scope) {
 void check_program(Program* prog) {
     // Set global pointer for struct field type lookup
     current_program = prog;
+    Stmt* saved_decl = current_decl;
     
     // Pass 0: Register all struct types, enums, and constants first (so functions can reference them)
     for (int i = 0; i < prog->count; i++) {
+        current_decl = prog->stmts[i];
         if (prog->stmts[i]->type == STMT_STRUCT) {
             StructStmt* struct_decl = &prog->stmts[i]->struct_decl;
             Type* struct_type = make_type(TYPE_STRUCT);
@@ -2483,7 +2895,7 @@ void check_program(Program* prog) {
                 snprintf(qualified, 128, "%.*s::%.*s",
                         enum_decl->name.length, enum_decl->name.start,
                         enum_decl->variants[j].length, enum_decl->variants[j].start);
-                Token qualified_token = {TOKEN_IDENT, strdup(qualified), (int)strlen(qualified), 0};
+                Token qualified_token = {TOKEN_IDENT, strdup(qualified), (int)strlen(qualified), 0, 0};
                 add_symbol(global_scope, qualified_token, enum_type, false);
                 
                 // Register constructor function for all variants (with or without data)
@@ -2503,7 +2915,7 @@ void check_program(Program* prog) {
                             enum_decl->name.length, enum_decl->name.start,
                             enum_decl->variants[j].length, enum_decl->variants[j].start);
                     
-                    Token constructor_token = {TOKEN_IDENT, strdup(constructor_name), (int)strlen(constructor_name), 0};
+                    Token constructor_token = {TOKEN_IDENT, strdup(constructor_name), (int)strlen(constructor_name), 0, 0};
                     
                     Type* constructor_type = make_type(TYPE_FUNCTION);
                     int param_count = (enum_decl->variant_type_counts && enum_decl->variant_type_counts[j] > 0) 
@@ -2546,7 +2958,7 @@ void check_program(Program* prog) {
             snprintf(tostring_name, 128, "%.*s_toString",
                     enum_decl->name.length, enum_decl->name.start);
             
-            Token tostring_token = {TOKEN_IDENT, strdup(tostring_name), (int)strlen(tostring_name), 0};
+            Token tostring_token = {TOKEN_IDENT, strdup(tostring_name), (int)strlen(tostring_name), 0, 0};
             
             Type* tostring_type = make_type(TYPE_FUNCTION);
             tostring_type->fn_type.param_count = 1;
@@ -2614,7 +3026,7 @@ void check_program(Program* prog) {
     // Register standard library modules (always available, no import needed)
     {
         // File module
-        Token file_read_tok = {TOKEN_IDENT, "File::read", 10, 0};
+        Token file_read_tok = {TOKEN_IDENT, "File::read", 10, 0, 0};
         Type* file_read_type = make_type(TYPE_FUNCTION);
         file_read_type->fn_type.param_count = 1;
         file_read_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
@@ -2622,7 +3034,7 @@ void check_program(Program* prog) {
         file_read_type->fn_type.return_type = builtin_string;
         add_symbol(global_scope, file_read_tok, file_read_type, false);
         
-        Token file_write_tok = {TOKEN_IDENT, "File::write", 11, 0};
+        Token file_write_tok = {TOKEN_IDENT, "File::write", 11, 0, 0};
         Type* file_write_type = make_type(TYPE_FUNCTION);
         file_write_type->fn_type.param_count = 2;
         file_write_type->fn_type.param_types = malloc(sizeof(Type*) * 2);
@@ -2631,7 +3043,7 @@ void check_program(Program* prog) {
         file_write_type->fn_type.return_type = builtin_int;
         add_symbol(global_scope, file_write_tok, file_write_type, false);
         
-        Token file_exists_tok = {TOKEN_IDENT, "File::exists", 12, 0};
+        Token file_exists_tok = {TOKEN_IDENT, "File::exists", 12, 0, 0};
         Type* file_exists_type = make_type(TYPE_FUNCTION);
         file_exists_type->fn_type.param_count = 1;
         file_exists_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
@@ -2639,7 +3051,7 @@ void check_program(Program* prog) {
         file_exists_type->fn_type.return_type = builtin_int;
         add_symbol(global_scope, file_exists_tok, file_exists_type, false);
         
-        Token file_delete_tok = {TOKEN_IDENT, "File::delete", 12, 0};
+        Token file_delete_tok = {TOKEN_IDENT, "File::delete", 12, 0, 0};
         Type* file_delete_type = make_type(TYPE_FUNCTION);
         file_delete_type->fn_type.param_count = 1;
         file_delete_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
@@ -2647,7 +3059,7 @@ void check_program(Program* prog) {
         file_delete_type->fn_type.return_type = builtin_int;
         add_symbol(global_scope, file_delete_tok, file_delete_type, false);
         
-        Token file_list_dir_tok = {TOKEN_IDENT, "File::list_dir", 14, 0};
+        Token file_list_dir_tok = {TOKEN_IDENT, "File::list_dir", 14, 0, 0};
         Type* file_list_dir_type = make_type(TYPE_FUNCTION);
         file_list_dir_type->fn_type.param_count = 1;
         file_list_dir_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
@@ -2658,7 +3070,7 @@ void check_program(Program* prog) {
         file_list_dir_type->fn_type.return_type = string_array_list;
         add_symbol(global_scope, file_list_dir_tok, file_list_dir_type, false);
         
-        Token file_is_file_tok = {TOKEN_IDENT, "File::is_file", 13, 0};
+        Token file_is_file_tok = {TOKEN_IDENT, "File::is_file", 13, 0, 0};
         Type* file_is_file_type = make_type(TYPE_FUNCTION);
         file_is_file_type->fn_type.param_count = 1;
         file_is_file_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
@@ -2666,7 +3078,7 @@ void check_program(Program* prog) {
         file_is_file_type->fn_type.return_type = builtin_int;
         add_symbol(global_scope, file_is_file_tok, file_is_file_type, false);
         
-        Token file_is_dir_tok = {TOKEN_IDENT, "File::is_dir", 12, 0};
+        Token file_is_dir_tok = {TOKEN_IDENT, "File::is_dir", 12, 0, 0};
         Type* file_is_dir_type = make_type(TYPE_FUNCTION);
         file_is_dir_type->fn_type.param_count = 1;
         file_is_dir_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
@@ -2674,14 +3086,14 @@ void check_program(Program* prog) {
         file_is_dir_type->fn_type.return_type = builtin_int;
         add_symbol(global_scope, file_is_dir_tok, file_is_dir_type, false);
         
-        Token file_get_cwd_tok = {TOKEN_IDENT, "File::get_cwd", 13, 0};
+        Token file_get_cwd_tok = {TOKEN_IDENT, "File::get_cwd", 13, 0, 0};
         Type* file_get_cwd_type = make_type(TYPE_FUNCTION);
         file_get_cwd_type->fn_type.param_count = 0;
         file_get_cwd_type->fn_type.param_types = NULL;
         file_get_cwd_type->fn_type.return_type = builtin_string;
         add_symbol(global_scope, file_get_cwd_tok, file_get_cwd_type, false);
         
-        Token file_create_dir_tok = {TOKEN_IDENT, "File::create_dir", 16, 0};
+        Token file_create_dir_tok = {TOKEN_IDENT, "File::create_dir", 16, 0, 0};
         Type* file_create_dir_type = make_type(TYPE_FUNCTION);
         file_create_dir_type->fn_type.param_count = 1;
         file_create_dir_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
@@ -2689,7 +3101,7 @@ void check_program(Program* prog) {
         file_create_dir_type->fn_type.return_type = builtin_int;
         add_symbol(global_scope, file_create_dir_tok, file_create_dir_type, false);
         
-        Token file_file_size_tok = {TOKEN_IDENT, "File::file_size", 15, 0};
+        Token file_file_size_tok = {TOKEN_IDENT, "File::file_size", 15, 0, 0};
         Type* file_file_size_type = make_type(TYPE_FUNCTION);
         file_file_size_type->fn_type.param_count = 1;
         file_file_size_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
@@ -2697,7 +3109,7 @@ void check_program(Program* prog) {
         file_file_size_type->fn_type.return_type = builtin_int;
         add_symbol(global_scope, file_file_size_tok, file_file_size_type, false);
         
-        Token file_path_join_tok = {TOKEN_IDENT, "File::path_join", 15, 0};
+        Token file_path_join_tok = {TOKEN_IDENT, "File::path_join", 15, 0, 0};
         Type* file_path_join_type = make_type(TYPE_FUNCTION);
         file_path_join_type->fn_type.param_count = 2;
         file_path_join_type->fn_type.param_types = malloc(sizeof(Type*) * 2);
@@ -2706,7 +3118,7 @@ void check_program(Program* prog) {
         file_path_join_type->fn_type.return_type = builtin_string;
         add_symbol(global_scope, file_path_join_tok, file_path_join_type, false);
         
-        Token file_basename_tok = {TOKEN_IDENT, "File::basename", 14, 0};
+        Token file_basename_tok = {TOKEN_IDENT, "File::basename", 14, 0, 0};
         Type* file_basename_type = make_type(TYPE_FUNCTION);
         file_basename_type->fn_type.param_count = 1;
         file_basename_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
@@ -2714,7 +3126,7 @@ void check_program(Program* prog) {
         file_basename_type->fn_type.return_type = builtin_string;
         add_symbol(global_scope, file_basename_tok, file_basename_type, false);
         
-        Token file_dirname_tok = {TOKEN_IDENT, "File::dirname", 13, 0};
+        Token file_dirname_tok = {TOKEN_IDENT, "File::dirname", 13, 0, 0};
         Type* file_dirname_type = make_type(TYPE_FUNCTION);
         file_dirname_type->fn_type.param_count = 1;
         file_dirname_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
@@ -2722,7 +3134,7 @@ void check_program(Program* prog) {
         file_dirname_type->fn_type.return_type = builtin_string;
         add_symbol(global_scope, file_dirname_tok, file_dirname_type, false);
         
-        Token file_extension_tok = {TOKEN_IDENT, "File::extension", 15, 0};
+        Token file_extension_tok = {TOKEN_IDENT, "File::extension", 15, 0, 0};
         Type* file_extension_type = make_type(TYPE_FUNCTION);
         file_extension_type->fn_type.param_count = 1;
         file_extension_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
@@ -2731,7 +3143,7 @@ void check_program(Program* prog) {
         add_symbol(global_scope, file_extension_tok, file_extension_type, false);
         
         // System module
-        Token sys_exec_tok = {TOKEN_IDENT, "System::exec", 12, 0};
+        Token sys_exec_tok = {TOKEN_IDENT, "System::exec", 12, 0, 0};
         Type* sys_exec_type = make_type(TYPE_FUNCTION);
         sys_exec_type->fn_type.param_count = 1;
         sys_exec_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
@@ -2739,7 +3151,7 @@ void check_program(Program* prog) {
         sys_exec_type->fn_type.return_type = builtin_string;
         add_symbol(global_scope, sys_exec_tok, sys_exec_type, false);
         
-        Token sys_exec_code_tok = {TOKEN_IDENT, "System::exec_code", 17, 0};
+        Token sys_exec_code_tok = {TOKEN_IDENT, "System::exec_code", 17, 0, 0};
         Type* sys_exec_code_type = make_type(TYPE_FUNCTION);
         sys_exec_code_type->fn_type.param_count = 1;
         sys_exec_code_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
@@ -2747,7 +3159,7 @@ void check_program(Program* prog) {
         sys_exec_code_type->fn_type.return_type = builtin_int;
         add_symbol(global_scope, sys_exec_code_tok, sys_exec_code_type, false);
         
-        Token sys_exit_tok = {TOKEN_IDENT, "System::exit", 12, 0};
+        Token sys_exit_tok = {TOKEN_IDENT, "System::exit", 12, 0, 0};
         Type* sys_exit_type = make_type(TYPE_FUNCTION);
         sys_exit_type->fn_type.param_count = 1;
         sys_exit_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
@@ -2755,7 +3167,7 @@ void check_program(Program* prog) {
         sys_exit_type->fn_type.return_type = builtin_void;
         add_symbol(global_scope, sys_exit_tok, sys_exit_type, false);
         
-        Token sys_args_tok = {TOKEN_IDENT, "System::args", 12, 0};
+        Token sys_args_tok = {TOKEN_IDENT, "System::args", 12, 0, 0};
         Type* sys_args_type = make_type(TYPE_FUNCTION);
         sys_args_type->fn_type.param_count = 0;
         sys_args_type->fn_type.param_types = NULL;
@@ -2765,7 +3177,7 @@ void check_program(Program* prog) {
         sys_args_type->fn_type.return_type = string_array;
         add_symbol(global_scope, sys_args_tok, sys_args_type, false);
         
-        Token sys_env_tok = {TOKEN_IDENT, "System::env", 11, 0};
+        Token sys_env_tok = {TOKEN_IDENT, "System::env", 11, 0, 0};
         Type* sys_env_type = make_type(TYPE_FUNCTION);
         sys_env_type->fn_type.param_count = 1;
         sys_env_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
@@ -2773,7 +3185,7 @@ void check_program(Program* prog) {
         sys_env_type->fn_type.return_type = builtin_string;
         add_symbol(global_scope, sys_env_tok, sys_env_type, false);
         
-        Token sys_set_env_tok = {TOKEN_IDENT, "System::set_env", 15, 0};
+        Token sys_set_env_tok = {TOKEN_IDENT, "System::set_env", 15, 0, 0};
         Type* sys_set_env_type = make_type(TYPE_FUNCTION);
         sys_set_env_type->fn_type.param_count = 2;
         sys_set_env_type->fn_type.param_types = malloc(sizeof(Type*) * 2);
@@ -2783,7 +3195,7 @@ void check_program(Program* prog) {
         add_symbol(global_scope, sys_set_env_tok, sys_set_env_type, false);
         
         // Math module (update to Math:: from math.)
-        Token math_pow_tok = {TOKEN_IDENT, "Math::pow", 9, 0};
+        Token math_pow_tok = {TOKEN_IDENT, "Math::pow", 9, 0, 0};
         Type* math_pow_type = make_type(TYPE_FUNCTION);
         math_pow_type->fn_type.param_count = 2;
         math_pow_type->fn_type.param_types = malloc(sizeof(Type*) * 2);
@@ -2792,7 +3204,7 @@ void check_program(Program* prog) {
         math_pow_type->fn_type.return_type = builtin_float;
         add_symbol(global_scope, math_pow_tok, math_pow_type, false);
         
-        Token math_sqrt_tok = {TOKEN_IDENT, "Math::sqrt", 10, 0};
+        Token math_sqrt_tok = {TOKEN_IDENT, "Math::sqrt", 10, 0, 0};
         Type* math_sqrt_type = make_type(TYPE_FUNCTION);
         math_sqrt_type->fn_type.param_count = 1;
         math_sqrt_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
@@ -2801,14 +3213,14 @@ void check_program(Program* prog) {
         add_symbol(global_scope, math_sqrt_tok, math_sqrt_type, false);
         
         // Time module
-        Token time_now_tok = {TOKEN_IDENT, "Time::now", 9, 0};
+        Token time_now_tok = {TOKEN_IDENT, "Time::now", 9, 0, 0};
         Type* time_now_type = make_type(TYPE_FUNCTION);
         time_now_type->fn_type.param_count = 0;
         time_now_type->fn_type.param_types = NULL;
         time_now_type->fn_type.return_type = builtin_int;
         add_symbol(global_scope, time_now_tok, time_now_type, false);
         
-        Token time_sleep_tok = {TOKEN_IDENT, "Time::sleep", 11, 0};
+        Token time_sleep_tok = {TOKEN_IDENT, "Time::sleep", 11, 0, 0};
         Type* time_sleep_type = make_type(TYPE_FUNCTION);
         time_sleep_type->fn_type.param_count = 1;
         time_sleep_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
@@ -2816,7 +3228,7 @@ void check_program(Program* prog) {
         time_sleep_type->fn_type.return_type = builtin_void;
         add_symbol(global_scope, time_sleep_tok, time_sleep_type, false);
         
-        Token time_format_tok = {TOKEN_IDENT, "Time::format", 12, 0};
+        Token time_format_tok = {TOKEN_IDENT, "Time::format", 12, 0, 0};
         Type* time_format_type = make_type(TYPE_FUNCTION);
         time_format_type->fn_type.param_count = 1;
         time_format_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
@@ -2824,8 +3236,53 @@ void check_program(Program* prog) {
         time_format_type->fn_type.return_type = builtin_string;
         add_symbol(global_scope, time_format_tok, time_format_type, false);
         
+        // Async module: futures completed by the reactor, consumed with await
+        const char* async_names[] = {"Async::sleep", "Async::readable", "Async::writable"};
+        for (int i = 0; i < 3; i++) {
+            Token async_tok = {TOKEN_IDENT, async_names[i], (int)strlen(async_names[i]), 0, 0};
+            Type* async_type = make_type(TYPE_FUNCTION);
+            async_type->fn_type.param_count = 1;
+            async_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
+            async_type->fn_type.param_types[0] = builtin_int;
+            async_type->fn_type.return_type = make_future_type(builtin_int);
+            add_symbol(global_scope, async_tok, async_type, false);
+        }
+        
+        // Json module. Documents, nodes and readers are opaque handles, typed
+        // int like Net sockets. Signatures: return type, then parameters;
+        // h = handle, s = string, i = int, f = float, v = void.
+        struct { const char* name; const char* sig; } json_fns[] = {
+            {"Json::parse", "hs"}, {"Json::parse_file", "hs"}, {"Json::error", "s"},
+            {"Json::get", "hhs"}, {"Json::at", "hhi"}, {"Json::len", "ih"},
+            {"Json::has", "ihs"}, {"Json::kind", "ih"},
+            {"Json::get_string", "shs"}, {"Json::get_int", "ihs"},
+            {"Json::get_float", "fhs"}, {"Json::get_bool", "ihs"},
+            {"Json::as_string", "sh"}, {"Json::as_int", "ih"},
+            {"Json::as_float", "fh"}, {"Json::as_bool", "ih"},
+            {"Json::stringify", "sh"}, {"Json::free", "vh"},
+            {"Json::reader_open", "hs"}, {"Json::reader_from_string", "hs"},
+            {"Json::reader_next", "ih"}, {"Json::reader_string", "sh"},
+            {"Json::reader_int", "ih"}, {"Json::reader_float", "fh"},
+            {"Json::reader_bool", "ih"}, {"Json::reader_depth", "ih"},
+            {"Json::reader_error", "sh"}, {"Json::reader_close", "vh"},
+        };
+        for (size_t i = 0; i < sizeof(json_fns) / sizeof(json_fns[0]); i++) {
+            const char* sig = json_fns[i].sig;
+            Type* json_type = make_type(TYPE_FUNCTION);
+            json_type->fn_type.param_count = (int)strlen(sig) - 1;
+            json_type->fn_type.param_types = malloc(sizeof(Type*) * strlen(sig));
+            for (int j = 0; j <= json_type->fn_type.param_count; j++) {
+                Type* t = sig[j] == 's' ? builtin_string : sig[j] == 'f' ? builtin_float :
+                          sig[j] == 'v' ? builtin_void : builtin_int;
+                if (j == 0) json_type->fn_type.return_type = t;
+                else json_type->fn_type.param_types[j - 1] = t;
+            }
+            Token json_tok = {TOKEN_IDENT, json_fns[i].name, (int)strlen(json_fns[i].name), 0, 0};
+            add_symbol(global_scope, json_tok, json_type, false);
+        }
+        
         // Net module
-        Token net_listen_tok = {TOKEN_IDENT, "Net::listen", 11, 0};
+        Token net_listen_tok = {TOKEN_IDENT, "Net::listen", 11, 0, 0};
         Type* net_listen_type = make_type(TYPE_FUNCTION);
         net_listen_type->fn_type.param_count = 1;
         net_listen_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
@@ -2833,7 +3290,7 @@ void check_program(Program* prog) {
         net_listen_type->fn_type.return_type = builtin_int;
         add_symbol(global_scope, net_listen_tok, net_listen_type, false);
         
-        Token net_connect_tok = {TOKEN_IDENT, "Net::connect", 12, 0};
+        Token net_connect_tok = {TOKEN_IDENT, "Net::connect", 12, 0, 0};
         Type* net_connect_type = make_type(TYPE_FUNCTION);
         net_connect_type->fn_type.param_count = 2;
         net_connect_type->fn_type.param_types = malloc(sizeof(Type*) * 2);
@@ -2842,7 +3299,7 @@ void check_program(Program* prog) {
         net_connect_type->fn_type.return_type = builtin_int;
         add_symbol(global_scope, net_connect_tok, net_connect_type, false);
         
-        Token net_send_tok = {TOKEN_IDENT, "Net::send", 9, 0};
+        Token net_send_tok = {TOKEN_IDENT, "Net::send", 9, 0, 0};
         Type* net_send_type = make_type(TYPE_FUNCTION);
         net_send_type->fn_type.param_count = 2;
         net_send_type->fn_type.param_types = malloc(sizeof(Type*) * 2);
@@ -2851,7 +3308,7 @@ void check_program(Program* prog) {
         net_send_type->fn_type.return_type = builtin_int;
         add_symbol(global_scope, net_send_tok, net_send_type, false);
         
-        Token net_recv_tok = {TOKEN_IDENT, "Net::recv", 9, 0};
+        Token net_recv_tok = {TOKEN_IDENT, "Net::recv", 9, 0, 0};
         Type* net_recv_type = make_type(TYPE_FUNCTION);
         net_recv_type->fn_type.param_count = 1;
         net_recv_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
@@ -2859,7 +3316,7 @@ void check_program(Program* prog) {
         net_recv_type->fn_type.return_type = builtin_string;
         add_symbol(global_scope, net_recv_tok, net_recv_type, false);
         
-        Token net_close_tok = {TOKEN_IDENT, "Net::close", 10, 0};
+        Token net_close_tok = {TOKEN_IDENT, "Net::close", 10, 0, 0};
         Type* net_close_type = make_type(TYPE_FUNCTION);
         net_close_type->fn_type.param_count = 1;
         net_close_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
@@ -2867,121 +3324,164 @@ void check_program(Program* prog) {
         net_close_type->fn_type.return_type = builtin_int;
         add_symbol(global_scope, net_close_tok, net_close_type, false);
         
-        // HashMap module
-        Token hashmap_new_tok = {TOKEN_IDENT, "HashMap::new", 12, 0};
+        // Socket module (buffered reads on the descriptors Net:: returns), Http
+        // client and HttpServer, signatures in the same notation as json_fns;
+        // 'F' is a handler function
+        struct { const char* name; const char* sig; } socket_fns[] = {
+            {"Socket::read_line", "si"}, {"Socket::read_until", "sis"},
+            {"Socket::read_exact", "sii"}, {"Socket::read", "sii"},
+            {"Socket::close", "ii"}, {"Socket::set_timeout", "iii"},
+            {"Socket::set_nonblocking", "ii"}, {"Socket::poll_read", "iii"},
+            {"Http::get", "hs"}, {"Http::post", "hsss"}, {"Http::status", "ih"},
+            {"Http::body", "sh"}, {"Http::header", "shs"}, {"Http::free", "vh"},
+            {"HttpServer::new", "hi"}, {"HttpServer::workers", "vhi"},
+            {"HttpServer::port", "ih"}, {"HttpServer::serve", "ihF"},
+            {"HttpServer::stop", "vh"}, {"HttpServer::free", "vh"},
+            {"HttpServer::method", "si"}, {"HttpServer::path", "si"},
+            {"HttpServer::query", "si"}, {"HttpServer::header", "sis"},
+            {"HttpServer::body", "si"}, {"HttpServer::set_header", "viss"},
+            {"HttpServer::respond", "iiiss"}, {"HttpServer::send_file", "iiss"},
+            {"HttpServer::shutdown", "vi"},
+        };
+        for (size_t i = 0; i < sizeof(socket_fns) / sizeof(socket_fns[0]); i++) {
+            const char* sig = socket_fns[i].sig;
+            Type* socket_type = make_type(TYPE_FUNCTION);
+            socket_type->fn_type.param_count = (int)strlen(sig) - 1;
+            socket_type->fn_type.param_types = malloc(sizeof(Type*) * strlen(sig));
+            for (int j = 0; j <= socket_type->fn_type.param_count; j++) {
+                Type* t = sig[j] == 's' ? builtin_string : sig[j] == 'v' ? builtin_void :
+                          sig[j] == 'F' ? make_type(TYPE_FUNCTION) : builtin_int;
+                if (j == 0) socket_type->fn_type.return_type = t;
+                else socket_type->fn_type.param_types[j - 1] = t;
+            }
+            Token socket_tok = {TOKEN_IDENT, socket_fns[i].name, (int)strlen(socket_fns[i].name), 0, 0};
+            add_symbol(global_scope, socket_tok, socket_type, false);
+        }
+        
+        // HashMap module: maps are WynHashMap pointers, not integer handles
+        Type* hashmap_ptr = make_type(TYPE_MAP);
+        Token hashmap_new_tok = {TOKEN_IDENT, "HashMap::new", 12, 0, 0};
         Type* hashmap_new_type = make_type(TYPE_FUNCTION);
         hashmap_new_type->fn_type.param_count = 0;
         hashmap_new_type->fn_type.param_types = NULL;
-        hashmap_new_type->fn_type.return_type = builtin_int;
+        hashmap_new_type->fn_type.return_type = hashmap_ptr;
         add_symbol(global_scope, hashmap_new_tok, hashmap_new_type, false);
         
-        Token hashmap_insert_tok = {TOKEN_IDENT, "HashMap::insert", 15, 0};
+        Token hashmap_insert_tok = {TOKEN_IDENT, "HashMap::insert", 15, 0, 0};
         Type* hashmap_insert_type = make_type(TYPE_FUNCTION);
         hashmap_insert_type->fn_type.param_count = 3;
         hashmap_insert_type->fn_type.param_types = malloc(sizeof(Type*) * 3);
-        hashmap_insert_type->fn_type.param_types[0] = builtin_int;
+        hashmap_insert_type->fn_type.param_types[0] = hashmap_ptr;
         hashmap_insert_type->fn_type.param_types[1] = builtin_string;
         hashmap_insert_type->fn_type.param_types[2] = builtin_int;
         hashmap_insert_type->fn_type.return_type = builtin_int;
         add_symbol(global_scope, hashmap_insert_tok, hashmap_insert_type, false);
         
-        Token hashmap_get_tok = {TOKEN_IDENT, "HashMap::get", 12, 0};
+        Token hashmap_get_tok = {TOKEN_IDENT, "HashMap::get", 12, 0, 0};
         Type* hashmap_get_type = make_type(TYPE_FUNCTION);
         hashmap_get_type->fn_type.param_count = 2;
         hashmap_get_type->fn_type.param_types = malloc(sizeof(Type*) * 2);
-        hashmap_get_type->fn_type.param_types[0] = builtin_int;
+        hashmap_get_type->fn_type.param_types[0] = hashmap_ptr;
         hashmap_get_type->fn_type.param_types[1] = builtin_string;
         hashmap_get_type->fn_type.return_type = builtin_int;
         add_symbol(global_scope, hashmap_get_tok, hashmap_get_type, false);
         
-        Token hashmap_contains_tok = {TOKEN_IDENT, "HashMap::contains", 17, 0};
+        Token hashmap_contains_tok = {TOKEN_IDENT, "HashMap::contains", 17, 0, 0};
         Type* hashmap_contains_type = make_type(TYPE_FUNCTION);
         hashmap_contains_type->fn_type.param_count = 2;
         hashmap_contains_type->fn_type.param_types = malloc(sizeof(Type*) * 2);
-        hashmap_contains_type->fn_type.param_types[0] = builtin_int;
+        hashmap_contains_type->fn_type.param_types[0] = hashmap_ptr;
         hashmap_contains_type->fn_type.param_types[1] = builtin_string;
         hashmap_contains_type->fn_type.return_type = builtin_int;
         add_symbol(global_scope, hashmap_contains_tok, hashmap_contains_type, false);
         
-        Token hashmap_len_tok = {TOKEN_IDENT, "HashMap::len", 12, 0};
+        Token hashmap_len_tok = {TOKEN_IDENT, "HashMap::len", 12, 0, 0};
         Type* hashmap_len_type = make_type(TYPE_FUNCTION);
         hashmap_len_type->fn_type.param_count = 1;
         hashmap_len_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
-        hashmap_len_type->fn_type.param_types[0] = builtin_int;
+        hashmap_len_type->fn_type.param_types[0] = hashmap_ptr;
         hashmap_len_type->fn_type.return_type = builtin_int;
         add_symbol(global_scope, hashmap_len_tok, hashmap_len_type, false);
         
-        Token hashmap_remove_tok = {TOKEN_IDENT, "HashMap::remove", 15, 0};
+        Token hashmap_remove_tok = {TOKEN_IDENT, "HashMap::remove", 15, 0, 0};
         Type* hashmap_remove_type = make_type(TYPE_FUNCTION);
         hashmap_remove_type->fn_type.param_count = 2;
         hashmap_remove_type->fn_type.param_types = malloc(sizeof(Type*) * 2);
-        hashmap_remove_type->fn_type.param_types[0] = builtin_int;
+        hashmap_remove_type->fn_type.param_types[0] = hashmap_ptr;
         hashmap_remove_type->fn_type.param_types[1] = builtin_string;
         hashmap_remove_type->fn_type.return_type = builtin_int;
         add_symbol(global_scope, hashmap_remove_tok, hashmap_remove_type, false);
         
-        Token hashmap_free_tok = {TOKEN_IDENT, "HashMap::free", 13, 0};
+        Token hashmap_free_tok = {TOKEN_IDENT, "HashMap::free", 13, 0, 0};
         Type* hashmap_free_type = make_type(TYPE_FUNCTION);
         hashmap_free_type->fn_type.param_count = 1;
         hashmap_free_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
-        hashmap_free_type->fn_type.param_types[0] = builtin_int;
+        hashmap_free_type->fn_type.param_types[0] = hashmap_ptr;
         hashmap_free_type->fn_type.return_type = builtin_void;
         add_symbol(global_scope, hashmap_free_tok, hashmap_free_type, false);
         
+        // StringBuilder module; the builder's methods are in the method table
+        Token builder_new_tok = {TOKEN_IDENT, "StringBuilder::new", 18, 0, 0};
+        Type* builder_new_type = make_type(TYPE_FUNCTION);
+        builder_new_type->fn_type.param_count = 0;
+        builder_new_type->fn_type.param_types = NULL;
+        builder_new_type->fn_type.return_type = make_type(TYPE_STRING_BUILDER);
+        add_symbol(global_scope, builder_new_tok, builder_new_type, false);
+        
         // Lowercase hashmap functions (for compatibility)
-        Token hashmap_new_lc_tok = {TOKEN_IDENT, "wyn_hashmap_new", 15, 0};
+        Token hashmap_new_lc_tok = {TOKEN_IDENT, "wyn_hashmap_new", 15, 0, 0};
         Type* hashmap_new_lc_type = make_type(TYPE_FUNCTION);
         hashmap_new_lc_type->fn_type.param_count = 0;
         hashmap_new_lc_type->fn_type.param_types = NULL;
-        hashmap_new_lc_type->fn_type.return_type = builtin_int;
+        hashmap_new_lc_type->fn_type.return_type = hashmap_ptr;
         add_symbol(global_scope, hashmap_new_lc_tok, hashmap_new_lc_type, false);
         
-        Token hashmap_insert_int_lc_tok = {TOKEN_IDENT, "wyn_hashmap_insert_int", 22, 0};
+        Token hashmap_insert_int_lc_tok = {TOKEN_IDENT, "wyn_hashmap_insert_int", 22, 0, 0};
         Type* hashmap_insert_int_lc_type = make_type(TYPE_FUNCTION);
         hashmap_insert_int_lc_type->fn_type.param_count = 3;
         hashmap_insert_int_lc_type->fn_type.param_types = malloc(sizeof(Type*) * 3);
-        hashmap_insert_int_lc_type->fn_type.param_types[0] = builtin_int;
+        hashmap_insert_int_lc_type->fn_type.param_types[0] = hashmap_ptr;
         hashmap_insert_int_lc_type->fn_type.param_types[1] = builtin_string;
         hashmap_insert_int_lc_type->fn_type.param_types[2] = builtin_int;
         hashmap_insert_int_lc_type->fn_type.return_type = builtin_void;
         add_symbol(global_scope, hashmap_insert_int_lc_tok, hashmap_insert_int_lc_type, false);
         
-        Token hashmap_get_int_lc_tok = {TOKEN_IDENT, "wyn_hashmap_get_int", 19, 0};
+        Token hashmap_get_int_lc_tok = {TOKEN_IDENT, "wyn_hashmap_get_int", 19, 0, 0};
         Type* hashmap_get_int_lc_type = make_type(TYPE_FUNCTION);
         hashmap_get_int_lc_type->fn_type.param_count = 2;
         hashmap_get_int_lc_type->fn_type.param_types = malloc(sizeof(Type*) * 2);
-        hashmap_get_int_lc_type->fn_type.param_types[0] = builtin_int;
+        hashmap_get_int_lc_type->fn_type.param_types[0] = hashmap_ptr;
         hashmap_get_int_lc_type->fn_type.param_types[1] = builtin_string;
         hashmap_get_int_lc_type->fn_type.return_type = builtin_int;
         add_symbol(global_scope, hashmap_get_int_lc_tok, hashmap_get_int_lc_type, false);
         
-        Token hashmap_has_lc_tok = {TOKEN_IDENT, "wyn_hashmap_has", 15, 0};
+        Token hashmap_has_lc_tok = {TOKEN_IDENT, "wyn_hashmap_has", 15, 0, 0};
         Type* hashmap_has_lc_type = make_type(TYPE_FUNCTION);
         hashmap_has_lc_type->fn_type.param_count = 2;
         hashmap_has_lc_type->fn_type.param_types = malloc(sizeof(Type*) * 2);
-        hashmap_has_lc_type->fn_type.param_types[0] = builtin_int;
+        hashmap_has_lc_type->fn_type.param_types[0] = hashmap_ptr;
         hashmap_has_lc_type->fn_type.param_types[1] = builtin_string;
         hashmap_has_lc_type->fn_type.return_type = builtin_int;
         add_symbol(global_scope, hashmap_has_lc_tok, hashmap_has_lc_type, false);
         
-        Token hashmap_len_lc_tok = {TOKEN_IDENT, "wyn_hashmap_len", 15, 0};
+        Token hashmap_len_lc_tok = {TOKEN_IDENT, "wyn_hashmap_len", 15, 0, 0};
         Type* hashmap_len_lc_type = make_type(TYPE_FUNCTION);
         hashmap_len_lc_type->fn_type.param_count = 1;
         hashmap_len_lc_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
-        hashmap_len_lc_type->fn_type.param_types[0] = builtin_int;
+        hashmap_len_lc_type->fn_type.param_types[0] = hashmap_ptr;
         hashmap_len_lc_type->fn_type.return_type = builtin_int;
         add_symbol(global_scope, hashmap_len_lc_tok, hashmap_len_lc_type, false);
         
-        Token hashmap_free_lc_tok = {TOKEN_IDENT, "wyn_hashmap_free", 16, 0};
+        Token hashmap_free_lc_tok = {TOKEN_IDENT, "wyn_hashmap_free", 16, 0, 0};
         Type* hashmap_free_lc_type = make_type(TYPE_FUNCTION);
         hashmap_free_lc_type->fn_type.param_count = 1;
         hashmap_free_lc_type->fn_type.param_types = malloc(sizeof(Type*) * 1);
-        hashmap_free_lc_type->fn_type.param_types[0] = builtin_int;
+        hashmap_free_lc_type->fn_type.param_types[0] = hashmap_ptr;
         hashmap_free_lc_type->fn_type.return_type = builtin_void;
         add_symbol(global_scope, hashmap_free_lc_tok, hashmap_free_lc_type, false);
         
         // Arena functions
-        Token wyn_arena_new_tok = {TOKEN_IDENT, "wyn_arena_new", 13, 0};
+        Token wyn_arena_new_tok = {TOKEN_IDENT, "wyn_arena_new", 13, 0, 0};
         Type* wyn_arena_new_type = make_type(TYPE_FUNCTION);
         wyn_arena_new_type->fn_type.param_count = 0;
         wyn_arena_new_type->fn_type.param_types = NULL;
@@ -2991,6 +3491,7 @@ void check_program(Program* prog) {
     
     // First pass: process imports and register functions with their signatures
     for (int i = 0; i < prog->count; i++) {
+        current_decl = prog->stmts[i];
         if (prog->stmts[i]->type == STMT_IMPORT) {
             // Load and process imported module
             ImportStmt* import = &prog->stmts[i]->import;
@@ -3005,21 +3506,21 @@ void check_program(Program* prog) {
                 
                 // Register math module functions - only useful ones (not add/multiply/etc)
                 // Users should use operators: +, -, *, / for basic arithmetic
-                Token math_pow = {TOKEN_IDENT, "math.pow", 8, 0};
-                Token math_sqrt = {TOKEN_IDENT, "math.sqrt", 9, 0};
-                Token math_abs = {TOKEN_IDENT, "math.abs", 8, 0};
-                Token math_floor = {TOKEN_IDENT, "math.floor", 10, 0};
-                Token math_ceil = {TOKEN_IDENT, "math.ceil", 9, 0};
-                Token math_round = {TOKEN_IDENT, "math.round", 10, 0};
-                Token math_sin = {TOKEN_IDENT, "math.sin", 8, 0};
-                Token math_cos = {TOKEN_IDENT, "math.cos", 8, 0};
-                Token math_tan = {TOKEN_IDENT, "math.tan", 8, 0};
-                Token math_log = {TOKEN_IDENT, "math.log", 8, 0};
-                Token math_exp = {TOKEN_IDENT, "math.exp", 8, 0};
-                Token math_min = {TOKEN_IDENT, "math.min", 8, 0};
-                Token math_max = {TOKEN_IDENT, "math.max", 8, 0};
-                Token math_pi = {TOKEN_IDENT, "math.pi", 7, 0};
-                Token math_e = {TOKEN_IDENT, "math.e", 6, 0};
+                Token math_pow = {TOKEN_IDENT, "math.pow", 8, 0, 0};
+                Token math_sqrt = {TOKEN_IDENT, "math.sqrt", 9, 0, 0};
+                Token math_abs = {TOKEN_IDENT, "math.abs", 8, 0, 0};
+                Token math_floor = {TOKEN_IDENT, "math.floor", 10, 0, 0};
+                Token math_ceil = {TOKEN_IDENT, "math.ceil", 9, 0, 0};
+                Token math_round = {TOKEN_IDENT, "math.round", 10, 0, 0};
+                Token math_sin = {TOKEN_IDENT, "math.sin", 8, 0, 0};
+                Token math_cos = {TOKEN_IDENT, "math.cos", 8, 0, 0};
+                Token math_tan = {TOKEN_IDENT, "math.tan", 8, 0, 0};
+                Token math_log = {TOKEN_IDENT, "math.log", 8, 0, 0};
+                Token math_exp = {TOKEN_IDENT, "math.exp", 8, 0, 0};
+                Token math_min = {TOKEN_IDENT, "math.min", 8, 0, 0};
+                Token math_max = {TOKEN_IDENT, "math.max", 8, 0, 0};
+                Token math_pi = {TOKEN_IDENT, "math.pi", 7, 0, 0};
+                Token math_e = {TOKEN_IDENT, "math.e", 6, 0, 0};
                 
                 Type* math_fn_type = make_type(TYPE_FUNCTION);
                 math_fn_type->fn_type.param_count = 2;
@@ -3254,6 +3755,11 @@ void check_program(Program* prog) {
                 }
             }
             
+            // Calling an async fn starts it; await yields the declared type
+            if (fn->is_async) {
+                fn_type->fn_type.return_type = make_future_type(fn_type->fn_type.return_type);
+            }
+            
             // Register function name (or Type_method for extension methods)
             Token function_name = fn->name;
             if (fn->is_extension) {
@@ -3330,6 +3836,9 @@ void check_program(Program* prog) {
                         }
                     }
                 }
+                if (fn->is_async) {
+                    fn_type->fn_type.return_type = make_future_type(fn_type->fn_type.return_type);
+                }
                 
                 add_symbol(global_scope, fn->name, fn_type, false);
             } else if (exported->type == STMT_VAR) {
@@ -3346,8 +3855,9 @@ void check_program(Program* prog) {
     
     // Second pass: check function bodies
     for (int i = 0; i < prog->count; i++) {
+        current_decl = prog->stmts[i];
         if (prog->stmts[i]->type == STMT_FN) {
-            SymbolTable local_scope;
+            SymbolTable local_scope = {0};
             local_scope.parent = global_scope;
             local_scope.capacity = 32;
             local_scope.symbols = calloc(32, sizeof(Symbol));
@@ -3499,11 +4009,12 @@ void check_program(Program* prog) {
             
             check_stmt(fn->body, &local_scope);
             current_function_return_type = NULL; // Reset after function
-            free(local_scope.symbols);
+            free_symbol_table(&local_scope);
         } else {
             check_stmt(prog->stmts[i], global_scope);
         }
     }
+    current_decl = saved_decl;
 }
 
 SymbolTable* get_global_scope() {
@@ -3514,6 +4025,10 @@ bool checker_had_error() {
     return had_error;
 }
 
+Stmt* checker_current_decl() {
+    return current_decl;
+}
+
 // T1.5.2: Helper functions for default parameter type checking
 bool types_equal(Type* a, Type* b) {
     if (!a || !b) return false;
@@ -3542,8 +4057,11 @@ bool types_equal(Type* a, Type* b) {
         case TYPE_MAP:
         case TYPE_OPTIONAL:
         case TYPE_UNION:
+        case TYPE_STRING_BUILDER:
             // For now, just compare kinds - more detailed comparison can be added later
             return true;
+        case TYPE_FUTURE:
+            return types_equal(a->future_type.value_type, b->future_type.value_type);
         default:
             return false;
     }
@@ -328,21 +328,21 @@ void wyn_implement_closure_traits(LambdaExpr* lambda) {
     // Create a unique type name for this closure
     char closure_type_name[64];
     wyn_generate_closure_name(lambda, closure_type_name, sizeof(closure_type_name));
-    Token closure_type_token = {TOKEN_IDENT, closure_type_name, (int)strlen(closure_type_name), 0};
+    Token closure_type_token = {TOKEN_IDENT, closure_type_name, (int)strlen(closure_type_name), 0, 0};
     
     // Register trait implementations
     if (implements_fn_once) {
-        Token fn_once_trait = {TOKEN_IDENT, "FnOnce", 6, 0};
+        Token fn_once_trait = {TOKEN_IDENT, "FnOnce", 6, 0, 0};
         wyn_register_trait_impl(fn_once_trait, closure_type_token, NULL, 0);
     }
     
     if (implements_fn_mut) {
-        Token fn_mut_trait = {TOKEN_IDENT, "FnMut", 5, 0};
+        Token fn_mut_trait = {TOKEN_IDENT, "FnMut", 5, 0, 0};
         wyn_register_trait_impl(fn_mut_trait, closure_type_token, NULL, 0);
     }
     
     if (implements_fn) {
-        Token fn_trait = {TOKEN_IDENT, "Fn", 2, 0};
+        Token fn_trait = {TOKEN_IDENT, "Fn", 2, 0, 0};
         wyn_register_trait_impl(fn_trait, closure_type_token, NULL, 0);
     }
 }
@@ -390,15 +390,15 @@ Type* wyn_apply_higher_order_function(Token fn_name, LambdaExpr* closure, Expr**
     if (!closure || !args) return NULL;
     
     // Check if the closure implements the required trait for this higher-order function
-    Token required_trait = {TOKEN_IDENT, "Fn", 2, 0}; // Default to Fn
+    Token required_trait = {TOKEN_IDENT, "Fn", 2, 0, 0}; // Default to Fn
     
     // Determine required trait based on function name
     if (fn_name.length == 3 && memcmp(fn_name.start, "map", 3) == 0) {
-        required_trait = (Token){TOKEN_IDENT, "Fn", 2, 0};
+        required_trait = (Token){TOKEN_IDENT, "Fn", 2, 0, 0};
     } else if (fn_name.length == 6 && memcmp(fn_name.start, "filter", 6) == 0) {
-        required_trait = (Token){TOKEN_IDENT, "Fn", 2, 0};
+        required_trait = (Token){TOKEN_IDENT, "Fn", 2, 0, 0};
     } else if (fn_name.length == 6 && memcmp(fn_name.start, "reduce", 6) == 0) {
-        required_trait = (Token){TOKEN_IDENT, "FnMut", 5, 0};
+        required_trait = (Token){TOKEN_IDENT, "FnMut", 5, 0, 0};
     }
     
     // Create closure type with bounds checking
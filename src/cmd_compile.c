@@ -8,6 +8,7 @@
 #include "common.h"
 #include "ast.h"
 #include "wyn_interface.h"
+#include "runtime_lib.h"
 
 // Forward declarations
 extern void init_lexer(const char* source);
@@ -21,8 +22,9 @@ extern void free_program(Program* prog);
 extern void codegen_c_header();
 extern void codegen_program(Program* prog);
 
-// Compile a single file
-static int compile_file_with_output(const char* filename, const char* output_name) {
+// Compile a single file with the optimization flags in opts
+static int compile_file_with_output(const char* filename, const char* output_name,
+                                    const WynBuildOptions* opts) {
     char* source = wyn_read_file(filename);
     
     // Generate output filename
@@ -73,51 +75,12 @@ static int compile_file_with_output(const char* filename, const char* output_nam
     }
     
     // Get the directory where wyn binary is located
-    char wyn_dir[1024] = ".";
-    char* wyn_path = getenv("WYN_ROOT");
-    if (wyn_path) {
-        snprintf(wyn_dir, sizeof(wyn_dir), "%s", wyn_path);
-    } else {
-        // Auto-detect: try common locations
-        const char* search_paths[] = {
-            ".",
-            "./wyn",
-            "../",
-            "../../",
-            "/usr/local/share/wyn",
-            "/usr/share/wyn",
-            NULL
-        };
-        
-        for (int i = 0; search_paths[i] != NULL; i++) {
-            char test_path[1024];
-            snprintf(test_path, sizeof(test_path), "%s/src/wyn_wrapper.c", search_paths[i]);
-            FILE* test = fopen(test_path, "r");
-            if (test) {
-                fclose(test);
-                snprintf(wyn_dir, sizeof(wyn_dir), "%s", search_paths[i]);
-                break;
-            }
-        }
-    }
+    char wyn_dir[1024];
+    wyn_find_root(wyn_dir, sizeof(wyn_dir));
     
-    char cmd[4096];
-    snprintf(cmd, sizeof(cmd), 
-             "gcc -O0 -I %s/src -o %s %s %s/src/wyn_wrapper.c %s/src/wyn_interface.c "
-             "%s/src/io.c %s/src/optional.c %s/src/result.c %s/src/arc_runtime.c "
-             "%s/src/concurrency.c %s/src/async_runtime.c "
-             "%s/src/safe_memory.c %s/src/error.c %s/src/string_runtime.c "
-             "%s/src/hashmap.c %s/src/hashset.c %s/src/json.c %s/src/json_runtime.c %s/src/stdlib_runtime.c %s/src/hashmap_runtime.c "
-             "%s/src/stdlib_string.c %s/src/stdlib_array.c %s/src/stdlib_time.c %s/src/stdlib_crypto.c "
-             "%s/src/spawn.c %s/src/net.c %s/src/net_runtime.c "
-             "%s/src/test_runtime.c %s/src/net_advanced.c -lm 2>&1",
-             wyn_dir, output_bin, output_c,
-             wyn_dir, wyn_dir, wyn_dir, wyn_dir, wyn_dir, wyn_dir, wyn_dir, wyn_dir,
-             wyn_dir, wyn_dir, wyn_dir, wyn_dir, wyn_dir, wyn_dir, wyn_dir,
-             wyn_dir, wyn_dir, wyn_dir, wyn_dir, wyn_dir, wyn_dir, wyn_dir,
-             wyn_dir, wyn_dir, wyn_dir, wyn_dir);
-    
-    int result = system(cmd);
+    WynBuildOptions build_opts = *opts;
+    wyn_build_options_set_source(&build_opts, filename);
+    int result = wyn_link_program(wyn_dir, output_c, output_bin, &build_opts);
     if (result != 0) {
         return 1;
     }
@@ -127,7 +90,9 @@ static int compile_file_with_output(const char* filename, const char* output_nam
 }
 
 static int compile_file(const char* filename) {
-    return compile_file_with_output(filename, NULL);
+    WynBuildOptions build_opts;
+    wyn_build_options_init(&build_opts, "-O0");
+    return compile_file_with_output(filename, NULL, &build_opts);
 }
 
 #ifndef _WIN32
@@ -154,12 +119,15 @@ static char* find_main_file(const char* dir) {
 
 // Main compile command
 int cmd_compile(const char* target, int argc, char** argv) {
-    // Check for -o flag
+    // -o <file> plus the same optimization flags as `wyn build`
     const char* output_name = NULL;
+    WynBuildOptions build_opts;
+    wyn_build_options_init(&build_opts, "-O0");
     for (int i = 0; i < argc; i++) {
         if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
-            output_name = argv[i + 1];
-            break;
+            output_name = argv[++i];
+        } else {
+            wyn_build_options_parse(&build_opts, argv[i]);
         }
     }
     
@@ -168,14 +136,14 @@ int cmd_compile(const char* target, int argc, char** argv) {
     if (f) {
         // It's a file
         fclose(f);
-        return compile_file_with_output(target, output_name);
+        return compile_file_with_output(target, output_name, &build_opts);
     }
     
 #ifndef _WIN32
     // Try as directory (not supported on Windows)
     char* main_file = find_main_file(target);
     if (main_file) {
-        return compile_file_with_output(main_file, output_name);
+        return compile_file_with_output(main_file, output_name, &build_opts);
     }
 #endif
     
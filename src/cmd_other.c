@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <time.h>
 #ifndef _WIN32
 #include <sys/wait.h>  // For WEXITSTATUS
 #include <unistd.h>    // For sleep, readlink
@@ -15,10 +16,29 @@
 #include <direct.h>    // For _mkdir
 #endif
 
+#include "ast.h"
+#include "module.h"
+#include "module_registry.h"
+#include "file_watch.h"
+#include "runtime_lib.h"
+#include "wyn_interface.h"
+
 // Forward declarations
 extern void* parse_file(const char* filename);
 extern void format_program(void* program);
 extern int wyn_format_file(const char* filename);
+extern void init_lexer(const char* source);
+extern void init_parser();
+extern Program* parse_program();
+extern void set_parser_filename(const char* filename);
+extern bool parser_had_error();
+extern void init_checker();
+extern void check_program(Program* prog);
+extern bool checker_had_error();
+extern void init_codegen(FILE* output);
+extern void codegen_c_header();
+extern void codegen_program(Program* prog);
+extern void set_source_directory(const char* source_file);
 
 int cmd_fmt(const char* file, int argc, char** argv) {
     if (!file) {
@@ -533,81 +553,125 @@ int cmd_init(const char* name, int argc, char** argv) {
     return 0;
 }
 
-int cmd_watch(const char* file, int argc, char** argv) {
-    (void)argc; (void)argv;  // Unused
-    
-    if (!file) {
-        fprintf(stderr, "Usage: wyn watch <file.wyn>\n");
+// One build of file inside the watch process. Modules left in the registry
+// by the previous build are reused as parsed, so only the files that changed
+// since are read, lexed and parsed again; checking and codegen run over the
+// whole program, and the runtime comes from the cached library.
+static int watch_build(const char* file, const char* wyn_root, const WynBuildOptions* opts) {
+    // The previous main AST points into its source until this build replaces it
+    static char* source = NULL;
+    free(source);
+    source = wyn_read_file(file);
+    if (!source) {
+        fprintf(stderr, "Error: Could not open file '%s'\n", file);
         return 1;
     }
     
-    // Get current executable path
-    char exe_path[2048];
-    #ifdef __APPLE__
-    uint32_t size = sizeof(exe_path);
-    if (_NSGetExecutablePath(exe_path, &size) != 0) {
-        fprintf(stderr, "Error: Could not determine executable path\n");
+    preload_imports(source);
+    init_lexer(source);
+    init_parser();
+    set_parser_filename(file);
+    init_checker();
+    check_all_modules();
+    
+    Program* prog = parse_program();
+    if (!prog || parser_had_error()) {
+        fprintf(stderr, "Error: Failed to parse program\n");
         return 1;
     }
-    #elif defined(__linux__)
-    ssize_t len = readlink("/proc/self/exe", exe_path, sizeof(exe_path) - 1);
-    if (len == -1) {
-        fprintf(stderr, "Error: Could not determine executable path\n");
+    check_program(prog);
+    if (checker_had_error()) {
+        fprintf(stderr, "Compilation failed due to errors\n");
         return 1;
     }
-    exe_path[len] = '\0';
-    #elif defined(_WIN32)
-    if (GetModuleFileNameA(NULL, exe_path, sizeof(exe_path)) == 0) {
-        fprintf(stderr, "Error: Could not determine executable path\n");
+    
+    char out_path[1024];
+    snprintf(out_path, sizeof(out_path), "%s.c", file);
+    FILE* out = fopen(out_path, "w");
+    if (!out) {
+        fprintf(stderr, "Error: Could not write '%s'\n", out_path);
         return 1;
     }
-    #else
-    strcpy(exe_path, "wyn");  // Fallback
-    #endif
+    init_codegen(out);
+    codegen_c_header();
+    codegen_program(prog);
+    fclose(out);
     
-    printf("Watching %s for changes (Ctrl+C to stop)...\n", file);
+    char bin_path[1024];
+    snprintf(bin_path, sizeof(bin_path), "%s.out", file);
+    return wyn_link_program(wyn_root, out_path, bin_path, opts);
+}
+
+static double watch_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+int cmd_watch(const char* file, int argc, char** argv) {
+    if (!file) {
+        fprintf(stderr, "Usage: wyn watch <file.wyn>\n");
+        return 1;
+    }
     
-    // Initial build
-    printf("\n[%s] Building...\n", file);
-    char cmd[4096];
-    snprintf(cmd, sizeof(cmd), "%s run %s 2>&1", exe_path, file);
-    int result = system(cmd);
-    if (result == 0) {
-        printf("[%s] ✓ Build successful\n", file);
-    } else {
-        printf("[%s] ✗ Build failed\n", file);
+    WynBuildOptions build_opts;
+    wyn_build_options_init(&build_opts, "-O2");
+    for (int i = 0; i < argc; i++) {
+        if (!wyn_build_options_parse(&build_opts, argv[i])) {
+            fprintf(stderr, "Warning: ignoring unknown option '%s'\n", argv[i]);
+        }
     }
+    wyn_build_options_set_source(&build_opts, file);
+    
+    char wyn_root[1024];
+    wyn_find_root(wyn_root, sizeof(wyn_root));
+    init_module_registry();
+    set_source_directory(file);
     
-    // Watch for changes
-    struct stat last_stat;
-    if (stat(file, &last_stat) != 0) {
+    FileWatcher* watcher = file_watcher_create();
+    file_watcher_add(watcher, file);
+    if (watcher->count == 0) {
         fprintf(stderr, "Error: Could not stat file '%s'\n", file);
+        file_watcher_free(watcher);
         return 1;
     }
     
+    char run_cmd[1100];
+    snprintf(run_cmd, sizeof(run_cmd), "%s%s.out", file[0] == '/' ? "" : "./", file);
+    
+    printf("Watching %s for changes (Ctrl+C to stop)...\n", file);
+    printf("\n[%s] Building...\n", file);
+    
     while (1) {
-        // Sleep for 1 second
-        #ifdef _WIN32
-        Sleep(1000);
-        #else
-        sleep(1);
-        #endif
+        double start = watch_now_ms();
+        int result = watch_build(file, wyn_root, &build_opts);
+        if (result == 0) {
+            printf("[%s] ✓ Build successful (%.0f ms)\n", file, watch_now_ms() - start);
+            fflush(stdout);
+            result = system(run_cmd);
+        } else {
+            printf("[%s] ✗ Build failed\n", file);
+        }
+        fflush(stdout);
         
-        struct stat current_stat;
-        if (stat(file, &current_stat) != 0) continue;
+        // Watch the whole import graph, including modules the last edit added
+        ModuleEntry* modules[64];
+        int module_count = get_all_modules(modules, 64);
+        for (int i = 0; i < module_count; i++) {
+            if (modules[i]->path) file_watcher_add(watcher, modules[i]->path);
+        }
         
-        if (current_stat.st_mtime > last_stat.st_mtime) {
-            last_stat = current_stat;
-            printf("\n[%s] File changed, rebuilding...\n", file);
-            result = system(cmd);
-            if (result == 0) {
-                printf("[%s] ✓ Build successful\n", file);
-            } else {
-                printf("[%s] ✗ Build failed\n", file);
-            }
+        if (file_watcher_wait(watcher, -1) <= 0) continue;
+        for (int i = 0; i < watcher->count; i++) {
+            WatchedFile* changed = &watcher->files[i];
+            if (!changed->changed) continue;
+            changed->changed = 0;
+            forget_module_file(changed->path);
+            printf("\n[%s] File changed, rebuilding...\n", changed->path);
         }
     }
     
+    file_watcher_free(watcher);
     return 0;
 }
 
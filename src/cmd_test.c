@@ -51,8 +51,8 @@ int cmd_test(const char* test_dir, int argc, char** argv) {
         
         clock_t test_start = clock();
         
-        // Compile the test
-        if (cmd_compile(filepath, 0, NULL) == 0) {
+        // Compile the test with the runner's optimization flags
+        if (cmd_compile(filepath, argc, argv) == 0) {
             // Run the test
             char output[512];
             snprintf(output, sizeof(output), "%s.out", filepath);
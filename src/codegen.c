@@ -18,6 +18,7 @@
 #include "module_registry.h"
 #include "module_aliases.h"
 #include "scope.h"
+#include "intern.h"
 
 // Forward declarations
 void codegen_stmt(Stmt* stmt);
@@ -49,9 +50,30 @@ static const char* module_to_c_ident(const char* module_name) {
     return c_ident;
 }
 
+// Sets of interned names (see intern.h), compared by id
+typedef struct {
+    uint32_t* ids;
+    int count;
+    int capacity;
+} NameSet;
+
+static void name_set_add(NameSet* set, uint32_t id) {
+    if (set->count >= set->capacity) {
+        set->capacity = set->capacity ? set->capacity * 2 : 32;
+        set->ids = realloc(set->ids, set->capacity * sizeof(uint32_t));
+    }
+    set->ids[set->count++] = id;
+}
+
+static bool name_set_has(const NameSet* set, uint32_t id) {
+    for (int i = 0; i < set->count; i++) {
+        if (set->ids[i] == id) return true;
+    }
+    return false;
+}
+
 // Simple function registry for current module
-static char* module_functions[256];
-static int module_function_count = 0;
+static NameSet module_functions;
 
 // Map short module names to full paths (http -> network/http)
 static struct {
@@ -82,77 +104,45 @@ static const char* resolve_short_module_name(const char* short_name) {
 }
 
 // Parameter tracking for current function
-static char* current_function_params[64];
-static int current_param_count = 0;
+static NameSet current_function_params;
 
 // Local variable tracking for current function
-static char* current_function_locals[256];
-static int current_local_count = 0;
+static NameSet current_function_locals;
 
-static void register_module_function(const char* name) {
-    if (module_function_count < 256) {
-        module_functions[module_function_count++] = strdup(name);
-    }
+static void register_module_function(Token name) {
+    name_set_add(&module_functions, token_name_id(&name));
 }
 
-static bool is_module_function(const char* name) {
-    for (int i = 0; i < module_function_count; i++) {
-        if (strcmp(module_functions[i], name) == 0) {
-            return true;
-        }
-    }
-    return false;
+static bool is_module_function(Token name) {
+    return name_set_has(&module_functions, token_name_id(&name));
 }
 
 static void clear_module_functions() {
-    for (int i = 0; i < module_function_count; i++) {
-        free(module_functions[i]);
-    }
-    module_function_count = 0;
+    module_functions.count = 0;
 }
 
-static void register_parameter(const char* name) {
-    if (current_param_count < 64) {
-        current_function_params[current_param_count++] = strdup(name);
-    }
+static void register_parameter(Token name) {
+    name_set_add(&current_function_params, token_name_id(&name));
 }
 
-static bool is_parameter(const char* name) {
-    for (int i = 0; i < current_param_count; i++) {
-        if (strcmp(current_function_params[i], name) == 0) {
-            return true;
-        }
-    }
-    return false;
+static bool is_parameter(Token name) {
+    return name_set_has(&current_function_params, token_name_id(&name));
 }
 
 static void clear_parameters() {
-    for (int i = 0; i < current_param_count; i++) {
-        free(current_function_params[i]);
-    }
-    current_param_count = 0;
+    current_function_params.count = 0;
 }
 
-static void register_local_variable(const char* name) {
-    if (current_local_count < 256) {
-        current_function_locals[current_local_count++] = strdup(name);
-    }
+static void register_local_variable(Token name) {
+    name_set_add(&current_function_locals, token_name_id(&name));
 }
 
-static bool is_local_variable(const char* name) {
-    for (int i = 0; i < current_local_count; i++) {
-        if (strcmp(current_function_locals[i], name) == 0) {
-            return true;
-        }
-    }
-    return false;
+static bool is_local_variable(Token name) {
+    return name_set_has(&current_function_locals, token_name_id(&name));
 }
 
 static void clear_local_variables() {
-    for (int i = 0; i < current_local_count; i++) {
-        free(current_function_locals[i]);
-    }
-    current_local_count = 0;
+    current_function_locals.count = 0;
 }
 
 // Module alias tracking
@@ -191,6 +181,9 @@ typedef struct {
 static LambdaFunction lambda_functions[256];
 static int lambda_count = 0;
 static int lambda_id_counter = 0;
+// Lambdas are matched to their pre-scanned definitions by order of use
+static int lambda_ref_counter = 0;
+static int lambda_var_counter = 0;
 
 // Track lambda variable names and their captures for call site injection
 typedef struct {
@@ -202,16 +195,964 @@ typedef struct {
 static LambdaVarInfo lambda_var_info[256];
 static int lambda_var_count = 0;
 
-// Spawn wrapper collection
+// Spawn wrapper collection. Functions declared in the program get a record
+// type carrying their arguments and result (see emit_spawn_record); fn is
+// NULL for the legacy zero-argument wrapper.
 typedef struct {
     char func_name[256];
+    FnStmt* fn;
 } SpawnWrapper;
 
 static SpawnWrapper spawn_wrappers[256];
 static int spawn_wrapper_count = 0;
+static int spawn_scope_counter = 0;
+
+// Forward declarations
+static void emit(const char* fmt, ...);
+void codegen_expr(Expr* expr);
+
+// Dense (unboxed) local arrays for the current function.
+// A local initialized from an array literal whose element type is known is
+// stored as a plain C array of that type instead of a WynArray of tagged
+// WynValues, as long as it is only indexed, assigned by index, iterated,
+// and used with len/is_empty/push/pop/get/first/last or the sort methods. Any
+// other use (passing it to a function, returning it, reassigning it,
+// capturing it) keeps the boxed representation so the array can cross the
+// WynArray ABI.
+typedef enum {
+    DENSE_NONE,
+    DENSE_INT,
+    DENSE_FLOAT,
+    DENSE_STRING,
+    DENSE_STRUCT
+} DenseKind;
+
+typedef struct {
+    char name[64];
+    DenseKind kind;
+    char struct_name[64];  // C element type for DENSE_STRUCT
+    bool declared;         // Declaration seen during the use scan
+    bool rejected;
+} DenseArray;
+
+static DenseArray dense_arrays[64];
+static int dense_array_count = 0;
+static bool dense_scan_failed = false;
+static int dense_lambda_depth = 0;
+
+static DenseArray* find_dense_array(Token name) {
+    for (int i = 0; i < dense_array_count; i++) {
+        if ((int)strlen(dense_arrays[i].name) == name.length &&
+            memcmp(dense_arrays[i].name, name.start, name.length) == 0) {
+            return &dense_arrays[i];
+        }
+    }
+    return NULL;
+}
+
+// Dense array referenced by expr, if expr is the identifier of one in use
+static DenseArray* dense_array_for(Expr* expr) {
+    if (!expr || expr->type != EXPR_IDENT || dense_array_count == 0) return NULL;
+    DenseArray* arr = find_dense_array(expr->token);
+    return (arr && !arr->rejected) ? arr : NULL;
+}
+
+static DenseKind dense_kind_of(Type* type) {
+    if (!type) return DENSE_NONE;
+    switch (type->kind) {
+        case TYPE_INT: return DENSE_INT;
+        case TYPE_FLOAT: return DENSE_FLOAT;
+        case TYPE_STRING: return DENSE_STRING;
+        case TYPE_STRUCT: return DENSE_STRUCT;
+        default: return DENSE_NONE;
+    }
+}
+
+static const char* dense_elem_c_type(DenseArray* arr) {
+    switch (arr->kind) {
+        case DENSE_INT: return "int";
+        case DENSE_FLOAT: return "double";
+        case DENSE_STRING: return "const char*";
+        default: return arr->struct_name;
+    }
+}
+
+// Element kind of an array literal initializer, or DENSE_NONE
+static DenseKind dense_literal_kind(Expr* init, char* struct_name) {
+    if (!init || init->type != EXPR_ARRAY || init->array.count == 0) return DENSE_NONE;
+    DenseKind kind = dense_kind_of(init->array.elements[0]->expr_type);
+    for (int i = 0; i < init->array.count; i++) {
+        Expr* elem = init->array.elements[i];
+        if (dense_kind_of(elem->expr_type) != kind) return DENSE_NONE;
+        if (kind == DENSE_STRUCT) {
+            // Only plain (non-generic) struct literals of a single type
+            if (elem->type != EXPR_STRUCT_INIT || elem->struct_init.monomorphic_name) return DENSE_NONE;
+            Token type_name = elem->struct_init.type_name;
+            if (i == 0) {
+                snprintf(struct_name, 64, "%.*s", type_name.length, type_name.start);
+            } else if ((int)strlen(struct_name) != type_name.length ||
+                       memcmp(struct_name, type_name.start, type_name.length) != 0) {
+                return DENSE_NONE;
+            }
+        }
+    }
+    return kind;
+}
+
+static void dense_collect_stmt(Stmt* stmt);
+static void dense_scan_expr(Expr* expr);
+static void dense_scan_stmt(Stmt* stmt);
+
+// Pass 1: find array-literal locals with a known element type
+static void dense_collect_stmt(Stmt* stmt) {
+    if (!stmt) return;
+    switch (stmt->type) {
+        case STMT_VAR: {
+            if (stmt->var.uses_pattern || stmt->var.name.length >= 64) break;
+            DenseArray* existing = find_dense_array(stmt->var.name);
+            if (existing) {
+                // Shadowed or redeclared names stay boxed
+                existing->rejected = true;
+                break;
+            }
+            if (dense_array_count >= 64) break;
+            DenseArray* arr = &dense_arrays[dense_array_count];
+            memset(arr, 0, sizeof(*arr));
+            snprintf(arr->name, 64, "%.*s", stmt->var.name.length, stmt->var.name.start);
+            arr->kind = dense_literal_kind(stmt->var.init, arr->struct_name);
+            arr->rejected = (arr->kind == DENSE_NONE);
+            dense_array_count++;
+            break;
+        }
+        case STMT_BLOCK:
+        case STMT_UNSAFE:
+            for (int i = 0; i < stmt->block.count; i++) dense_collect_stmt(stmt->block.stmts[i]);
+            break;
+        case STMT_IF:
+            dense_collect_stmt(stmt->if_stmt.then_branch);
+            dense_collect_stmt(stmt->if_stmt.else_branch);
+            break;
+        case STMT_WHILE:
+            dense_collect_stmt(stmt->while_stmt.body);
+            break;
+        case STMT_SCOPE:
+            dense_collect_stmt(stmt->scope.body);
+            break;
+        case STMT_FOR:
+            dense_collect_stmt(stmt->for_stmt.init);
+            dense_collect_stmt(stmt->for_stmt.body);
+            break;
+        default:
+            break;
+    }
+}
+
+static void dense_reject(Expr* ident) {
+    DenseArray* arr = find_dense_array(ident->token);
+    if (arr) arr->rejected = true;
+}
+
+// Candidate targeted by an allowed use. Lambda bodies are emitted as separate
+// C functions, so any reference from inside one keeps the array boxed.
+static DenseArray* dense_use_target(Expr* expr) {
+    if (!expr || expr->type != EXPR_IDENT || dense_lambda_depth > 0) return NULL;
+    DenseArray* arr = find_dense_array(expr->token);
+    return (arr && arr->declared) ? arr : NULL;
+}
+
+// Check that a value stored into a dense array has the element type
+static void dense_scan_stored_value(DenseArray* arr, Expr* value) {
+    if (!arr) return;
+    DenseKind kind = value ? dense_kind_of(value->expr_type) : DENSE_NONE;
+    if (kind != arr->kind) {
+        arr->rejected = true;
+    } else if (kind == DENSE_STRUCT) {
+        Token name = value->expr_type->struct_type.name;
+        if ((int)strlen(arr->struct_name) != name.length ||
+            memcmp(arr->struct_name, name.start, name.length) != 0) {
+            arr->rejected = true;
+        }
+    }
+}
+
+// Pass 2: reject candidates used in any way the dense form cannot express
+static void dense_scan_expr(Expr* expr) {
+    if (!expr || dense_scan_failed) return;
+    switch (expr->type) {
+        case EXPR_INT:
+        case EXPR_FLOAT:
+        case EXPR_STRING:
+        case EXPR_CHAR:
+        case EXPR_BOOL:
+        case EXPR_NONE:
+            break;
+        case EXPR_IDENT: {
+            // A bare reference lets the array escape
+            dense_reject(expr);
+            break;
+        }
+        case EXPR_BINARY:
+            dense_scan_expr(expr->binary.left);
+            dense_scan_expr(expr->binary.right);
+            break;
+        case EXPR_UNARY:
+            dense_scan_expr(expr->unary.operand);
+            break;
+        case EXPR_CALL:
+            dense_scan_expr(expr->call.callee);
+            for (int i = 0; i < expr->call.arg_count; i++) dense_scan_expr(expr->call.args[i]);
+            break;
+        case EXPR_METHOD_CALL: {
+            Expr* object = expr->method_call.object;
+            DenseArray* arr = dense_use_target(object);
+            if (arr) {
+                Token m = expr->method_call.method;
+                int argc = expr->method_call.arg_count;
+                bool ok = false;
+                if ((m.length == 3 && memcmp(m.start, "len", 3) == 0) ||
+                    (m.length == 8 && memcmp(m.start, "is_empty", 8) == 0) ||
+                    (m.length == 3 && memcmp(m.start, "pop", 3) == 0) ||
+                    (m.length == 5 && memcmp(m.start, "first", 5) == 0) ||
+                    (m.length == 4 && memcmp(m.start, "last", 4) == 0)) {
+                    ok = (argc == 0);
+                } else if (m.length == 4 && memcmp(m.start, "push", 4) == 0 && argc == 1) {
+                    ok = true;
+                    dense_scan_stored_value(arr, expr->method_call.args[0]);
+                } else if (m.length == 3 && memcmp(m.start, "get", 3) == 0 && argc == 1) {
+                    ok = true;
+                } else if (m.length == 4 && memcmp(m.start, "sort", 4) == 0) {
+                    ok = (argc == 0 && arr->kind != DENSE_STRUCT);
+                } else if ((m.length == 7 && memcmp(m.start, "sort_by", 7) == 0) ||
+                           (m.length == 14 && memcmp(m.start, "stable_sort_by", 14) == 0)) {
+                    ok = (argc == 1 && arr->kind == DENSE_INT);
+                } else if (m.length == 11 && memcmp(m.start, "sort_by_key", 11) == 0) {
+                    ok = (argc == 1 && arr->kind == DENSE_STRUCT);
+                }
+                if (!ok) arr->rejected = true;
+            } else {
+                dense_scan_expr(object);
+            }
+            for (int i = 0; i < expr->method_call.arg_count; i++) dense_scan_expr(expr->method_call.args[i]);
+            break;
+        }
+        case EXPR_ARRAY:
+            for (int i = 0; i < expr->array.count; i++) dense_scan_expr(expr->array.elements[i]);
+            break;
+        case EXPR_INDEX: {
+            DenseArray* arr = dense_use_target(expr->index.array);
+            if (arr) {
+                // Map-style indexing is dispatched on the index type
+                if (dense_kind_of(expr->index.index->expr_type) != DENSE_INT) arr->rejected = true;
+            } else {
+                dense_scan_expr(expr->index.array);
+            }
+            dense_scan_expr(expr->index.index);
+            break;
+        }
+        case EXPR_INDEX_ASSIGN: {
+            Expr* object = expr->index_assign.object;
+            DenseArray* arr = dense_use_target(object);
+            if (arr && arr->kind != DENSE_STRUCT &&
+                dense_kind_of(expr->index_assign.index->expr_type) == DENSE_INT) {
+                dense_scan_stored_value(arr, expr->index_assign.value);
+            } else {
+                dense_scan_expr(object);
+                if (arr) arr->rejected = true;
+            }
+            dense_scan_expr(expr->index_assign.index);
+            dense_scan_expr(expr->index_assign.value);
+            break;
+        }
+        case EXPR_ASSIGN: {
+            DenseArray* arr = find_dense_array(expr->assign.name);
+            if (arr) arr->rejected = true;
+            dense_scan_expr(expr->assign.value);
+            break;
+        }
+        case EXPR_STRUCT_INIT:
+            for (int i = 0; i < expr->struct_init.field_count; i++) dense_scan_expr(expr->struct_init.field_values[i]);
+            break;
+        case EXPR_FIELD_ACCESS:
+            dense_scan_expr(expr->field_access.object);
+            break;
+        case EXPR_FIELD_ASSIGN:
+            dense_scan_expr(expr->field_assign.object);
+            dense_scan_expr(expr->field_assign.value);
+            break;
+        case EXPR_TERNARY:
+            dense_scan_expr(expr->ternary.condition);
+            dense_scan_expr(expr->ternary.then_expr);
+            dense_scan_expr(expr->ternary.else_expr);
+            break;
+        case EXPR_IF_EXPR:
+            dense_scan_expr(expr->if_expr.condition);
+            dense_scan_expr(expr->if_expr.then_expr);
+            dense_scan_expr(expr->if_expr.else_expr);
+            break;
+        case EXPR_STRING_INTERP:
+            for (int i = 0; i < expr->string_interp.count; i++) dense_scan_expr(expr->string_interp.expressions[i]);
+            break;
+        case EXPR_RANGE:
+            dense_scan_expr(expr->range.start);
+            dense_scan_expr(expr->range.end);
+            break;
+        case EXPR_SOME:
+        case EXPR_OK:
+        case EXPR_ERR:
+            dense_scan_expr(expr->option.value);
+            break;
+        case EXPR_TUPLE:
+            for (int i = 0; i < expr->tuple.count; i++) dense_scan_expr(expr->tuple.elements[i]);
+            break;
+        case EXPR_TUPLE_INDEX:
+            dense_scan_expr(expr->tuple_index.tuple);
+            break;
+        case EXPR_SPAWN:
+            // Arguments are captured into the spawn record, so arrays escape
+            dense_scan_expr(expr->spawn.call);
+            break;
+        case EXPR_LAMBDA:
+            dense_lambda_depth++;
+            dense_scan_expr(expr->lambda.body);
+            dense_lambda_depth--;
+            break;
+        default:
+            // Lambdas, matches, blocks, pipelines, ...: stay boxed
+            dense_scan_failed = true;
+            break;
+    }
+}
+
+static void dense_scan_stmt(Stmt* stmt) {
+    if (!stmt || dense_scan_failed) return;
+    switch (stmt->type) {
+        case STMT_EXPR:
+            dense_scan_expr(stmt->expr);
+            break;
+        case STMT_VAR: {
+            DenseArray* arr = find_dense_array(stmt->var.name);
+            if (arr && !arr->rejected && !stmt->var.uses_pattern) {
+                // Element expressions of the literal itself are ordinary uses
+                for (int i = 0; i < stmt->var.init->array.count; i++) {
+                    dense_scan_expr(stmt->var.init->array.elements[i]);
+                }
+            } else {
+                dense_scan_expr(stmt->var.init);
+            }
+            if (arr) arr->declared = true;
+            break;
+        }
+        case STMT_RETURN:
+            dense_scan_expr(stmt->ret.value);
+            break;
+        case STMT_BLOCK:
+        case STMT_UNSAFE:
+            for (int i = 0; i < stmt->block.count; i++) dense_scan_stmt(stmt->block.stmts[i]);
+            break;
+        case STMT_IF:
+            dense_scan_expr(stmt->if_stmt.condition);
+            dense_scan_stmt(stmt->if_stmt.then_branch);
+            dense_scan_stmt(stmt->if_stmt.else_branch);
+            break;
+        case STMT_WHILE:
+            dense_scan_expr(stmt->while_stmt.condition);
+            dense_scan_stmt(stmt->while_stmt.body);
+            break;
+        case STMT_FOR: {
+            Expr* iterable = stmt->for_stmt.array_expr;
+            if (!dense_use_target(iterable)) dense_scan_expr(iterable);
+            if (find_dense_array(stmt->for_stmt.loop_var)) {
+                // Loop variable shadows a candidate
+                find_dense_array(stmt->for_stmt.loop_var)->rejected = true;
+            }
+            dense_scan_stmt(stmt->for_stmt.init);
+            dense_scan_expr(stmt->for_stmt.condition);
+            dense_scan_expr(stmt->for_stmt.increment);
+            dense_scan_stmt(stmt->for_stmt.body);
+            break;
+        }
+        case STMT_SCOPE:
+            dense_scan_stmt(stmt->scope.body);
+            break;
+        case STMT_SPAWN:
+            dense_scan_expr(stmt->spawn.call);
+            break;
+        case STMT_BREAK:
+        case STMT_CONTINUE:
+            break;
+        default:
+            dense_scan_failed = true;
+            break;
+    }
+}
+
+// Program being compiled, for looking up struct declarations
+static Program* codegen_current_program = NULL;
+
+static StructStmt* find_struct_decl(const char* name) {
+    if (!codegen_current_program || !name) return NULL;
+    size_t len = strlen(name);
+    for (int i = 0; i < codegen_current_program->count; i++) {
+        Stmt* s = codegen_current_program->stmts[i];
+        if (s->type == STMT_STRUCT && s->struct_decl.name.length == (int)len &&
+            memcmp(s->struct_decl.name.start, name, len) == 0) {
+            return &s->struct_decl;
+        }
+    }
+    return NULL;
+}
+
+static FnStmt* find_fn_decl(Token name) {
+    if (!codegen_current_program) return NULL;
+    for (int i = 0; i < codegen_current_program->count; i++) {
+        Stmt* s = codegen_current_program->stmts[i];
+        if (s->type == STMT_FN && !s->fn.is_extension && s->fn.name.length == name.length &&
+            memcmp(s->fn.name.start, name.start, name.length) == 0) {
+            return &s->fn;
+        }
+    }
+    return NULL;
+}
+
+// C type for a parameter or return type annotation, as the function
+// definitions spell it; NULL for types a spawn record cannot hold
+static const char* spawn_c_type(Expr* type_expr, bool is_param, char* buf, size_t size) {
+    if (!type_expr) return "int";
+    if (type_expr->type == EXPR_ARRAY) return "WynArray";
+    if (type_expr->type == EXPR_OPTIONAL_TYPE) return "WynOptional*";
+    if (type_expr->type != EXPR_IDENT) return NULL;
+    Token t = type_expr->token;
+    if (t.length == 3 && memcmp(t.start, "int", 3) == 0) return "int";
+    if ((t.length == 6 && memcmp(t.start, "string", 6) == 0) ||
+        (is_param && t.length == 3 && memcmp(t.start, "str", 3) == 0)) {
+        return is_param ? "const char*" : "char*";
+    }
+    if (t.length == 5 && memcmp(t.start, "float", 5) == 0) return "double";
+    if (t.length == 4 && memcmp(t.start, "bool", 4) == 0) return "bool";
+    if (t.length == 5 && memcmp(t.start, "array", 5) == 0) return "WynArray";
+    if (t.length == 7 && memcmp(t.start, "HashMap", 7) == 0) return "WynHashMap*";
+    if (t.length == 7 && memcmp(t.start, "HashSet", 7) == 0) return "WynHashSet*";
+    if (t.length == 13 && memcmp(t.start, "StringBuilder", 13) == 0) return "WynStringBuilder*";
+    snprintf(buf, size, "%.*s", t.length, t.start);
+    return buf;
+}
+
+static bool spawn_fn_supported(FnStmt* fn) {
+    char buf[256];
+    if (fn->is_async || fn->type_param_count > 0) return false;
+    if (fn->name.length == 4 && memcmp(fn->name.start, "main", 4) == 0) return false;
+    for (int i = 0; i < fn->param_count; i++) {
+        if (!spawn_c_type(fn->param_types[i], true, buf, sizeof(buf))) return false;
+    }
+    return spawn_c_type(fn->return_type, false, buf, sizeof(buf)) != NULL;
+}
+
+static bool spawn_fn_returns_void(FnStmt* fn) {
+    return fn->return_type && fn->return_type->type == EXPR_IDENT &&
+           fn->return_type->token.length == 4 && memcmp(fn->return_type->token.start, "void", 4) == 0;
+}
+
+// Collect the target of spawn f(...); called from the pre-scan
+static void register_spawn_target(Expr* call) {
+    if (!call || call->type != EXPR_CALL || call->call.callee->type != EXPR_IDENT) return;
+    Token name = call->call.callee->token;
+    FnStmt* fn = find_fn_decl(name);
+    if (fn && (!spawn_fn_supported(fn) || fn->param_count != call->call.arg_count)) fn = NULL;
+    if (!fn && call->call.arg_count != 0) return;
+    
+    char func_name[256];
+    snprintf(func_name, sizeof(func_name), "%.*s", name.length, name.start);
+    for (int i = 0; i < spawn_wrapper_count; i++) {
+        if (strcmp(spawn_wrappers[i].func_name, func_name) == 0) return;
+    }
+    if (spawn_wrapper_count < 256) {
+        strcpy(spawn_wrappers[spawn_wrapper_count].func_name, func_name);
+        spawn_wrappers[spawn_wrapper_count].fn = fn;
+        spawn_wrapper_count++;
+    }
+}
+
+static SpawnWrapper* find_spawn_wrapper(Expr* call) {
+    if (!call || call->type != EXPR_CALL || call->call.callee->type != EXPR_IDENT) return NULL;
+    Token name = call->call.callee->token;
+    for (int i = 0; i < spawn_wrapper_count; i++) {
+        if ((int)strlen(spawn_wrappers[i].func_name) == name.length &&
+            memcmp(spawn_wrappers[i].func_name, name.start, name.length) == 0) {
+            return &spawn_wrappers[i];
+        }
+    }
+    return NULL;
+}
+
+// A spawn argument, marked shared first when the checker recorded that it
+// carries reference-counted values to the other thread
+static void emit_spawn_arg(Expr* arg) {
+    AllocationSite* site = wyn_escape_find(arg);
+    if (!wyn_escape_crosses_threads(site)) {
+        codegen_expr(arg);
+        return;
+    }
+    switch (wyn_escape_type_id(site)) {
+        case WYN_TYPE_STRING: emit("wyn_str_share("); break;
+        case WYN_TYPE_MAP: emit("hashmap_share("); break;
+        case WYN_TYPE_ARRAY: emit("wyn_array_share("); break;
+        default: emit("(wyn_arc_share_all(), "); break;
+    }
+    codegen_expr(arg);
+    emit(")");
+}
+
+// Record for spawn f(a, b): the join handle, the arguments captured by
+// value and the result, plus helpers to start and join it. The variable
+// holding a handle owns a reference and drops it when it goes out of scope
+// (emit_spawn_owned); a temporary handle is joined and released at once.
+static void emit_spawn_record(SpawnWrapper* w) {
+    FnStmt* fn = w->fn;
+    const char* name = w->func_name;
+    char buf[256];
+    bool is_void = spawn_fn_returns_void(fn);
+    
+    emit("typedef struct {\n    WynSpawnHandle handle;\n");
+    for (int i = 0; i < fn->param_count; i++) {
+        emit("    %s a%d;\n", spawn_c_type(fn->param_types[i], true, buf, sizeof(buf)), i);
+    }
+    const char* result_type = spawn_c_type(fn->return_type, false, buf, sizeof(buf));
+    if (!is_void) emit("    %s result;\n", result_type);
+    emit("} __spawn_%s;\n\n", name);
+    
+    emit("static void __spawn_run_%s(void* arg) {\n", name);
+    emit("    __spawn_%s* s = arg;\n    ", name);
+    if (!is_void) emit("s->result = ");
+    emit("%s(", name);
+    for (int i = 0; i < fn->param_count; i++) emit("%ss->a%d", i > 0 ? ", " : "", i);
+    emit(");\n}\n\n");
+    
+    emit("static __spawn_%s* __spawn_start_%s(", name, name);
+    for (int i = 0; i < fn->param_count; i++) {
+        if (i > 0) emit(", ");
+        emit("%s a%d", spawn_c_type(fn->param_types[i], true, buf, sizeof(buf)), i);
+    }
+    if (fn->param_count == 0) emit("void");
+    emit(") {\n");
+    emit("    __spawn_%s* s = wyn_spawn_record(sizeof(__spawn_%s));\n", name, name);
+    for (int i = 0; i < fn->param_count; i++) emit("    s->a%d = a%d;\n", i, i);
+    emit("    wyn_spawn_submit(&s->handle, __spawn_run_%s);\n", name);
+    emit("    return s;\n}\n\n");
+    
+    result_type = spawn_c_type(fn->return_type, false, buf, sizeof(buf));
+    const char* ret = is_void ? "void" : result_type;
+    emit("static %s __spawn_join_%s(__spawn_%s* s) {\n", ret, name, name);
+    emit("    wyn_spawn_join(&s->handle);\n");
+    emit(is_void ? "}\n\n" : "    return s->result;\n}\n\n");
+    
+    emit("static %s __spawn_take_%s(__spawn_%s* s) {\n", ret, name, name);
+    emit("    wyn_spawn_join(&s->handle);\n");
+    if (is_void) {
+        emit("    wyn_spawn_release(&s->handle);\n}\n\n");
+    } else {
+        emit("    %s result = s->result;\n", result_type);
+        emit("    wyn_spawn_release(&s->handle);\n    return result;\n}\n\n");
+    }
+    
+    emit("static __spawn_%s* __spawn_copy_%s(__spawn_%s* s) {\n", name, name, name);
+    emit("    wyn_spawn_retain(&s->handle);\n    return s;\n}\n\n");
+    emit("static void __spawn_drop_%s(__spawn_%s** s) {\n", name, name);
+    emit("    if (*s) wyn_spawn_release(&(*s)->handle);\n}\n\n");
+}
+
+// A handle value the receiving variable will own: a fresh spawn hands over
+// its reference, a copy of another variable's handle takes a new one
+static void emit_spawn_owned(Expr* value) {
+    if (value->type == EXPR_SPAWN) {
+        codegen_expr(value);
+        return;
+    }
+    Token fn_name = value->expr_type->spawn_type.fn_name;
+    emit("__spawn_copy_%.*s(", fn_name.length, fn_name.start);
+    codegen_expr(value);
+    emit(")");
+}
+
+// Suffix of the hashmap_insert*/hashmap_get* function for a map's value and
+// key types: "_float" for string keys, "_float_int_key" for int keys. Int
+// values of int-keyed maps use the bare "_int_key" functions.
+static const char* map_access_suffix(Type* value_type, bool int_key) {
+    TypeKind kind = value_type ? value_type->kind : TYPE_INT;
+    switch (kind) {
+        case TYPE_FLOAT: return int_key ? "_float_int_key" : "_float";
+        case TYPE_STRING: return int_key ? "_string_int_key" : "_string";
+        case TYPE_BOOL: return int_key ? "_bool_int_key" : "_bool";
+        default: return int_key ? "_int_key" : "_int";
+    }
+}
+
+// Emit "offsetof(T, field), WYN_SORT_KEY_*" for sort_by_key("field")
+static bool emit_sort_key_args(const char* wyn_struct_name, const char* c_struct_name, Expr* field_arg) {
+    StructStmt* decl = find_struct_decl(wyn_struct_name);
+    if (!decl || !field_arg || field_arg->type != EXPR_STRING) return false;
+    const char* field = field_arg->token.start + 1;  // Strip quotes
+    int field_len = field_arg->token.length - 2;
+    for (int i = 0; i < decl->field_count; i++) {
+        Token name = decl->fields[i];
+        Expr* field_type = decl->field_types[i];
+        if (name.length != field_len || memcmp(name.start, field, field_len) != 0) continue;
+        if (!field_type || field_type->type != EXPR_IDENT) return false;
+        Token t = field_type->token;
+        const char* key_type = NULL;
+        if (t.length == 3 && memcmp(t.start, "int", 3) == 0) {
+            key_type = "WYN_SORT_KEY_INT";
+        } else if (t.length == 5 && memcmp(t.start, "float", 5) == 0) {
+            key_type = "WYN_SORT_KEY_FLOAT";
+        } else if ((t.length == 6 && memcmp(t.start, "string", 6) == 0) ||
+                   (t.length == 3 && memcmp(t.start, "str", 3) == 0)) {
+            key_type = "WYN_SORT_KEY_STRING";
+        } else {
+            return false;
+        }
+        emit("offsetof(%s, %.*s), %s", c_struct_name, field_len, field, key_type);
+        return true;
+    }
+    return false;
+}
+
+static void emit_dense_fallback(DenseArray* arr) {
+    switch (arr->kind) {
+        case DENSE_INT: emit("0"); break;
+        case DENSE_FLOAT: emit("0.0"); break;
+        case DENSE_STRING: emit("\"\""); break;
+        default: emit("(%s){0}", arr->struct_name); break;
+    }
+}
+
+// Decide which locals of a function body get dense storage
+static void analyze_dense_arrays(Stmt* body) {
+    dense_array_count = 0;
+    dense_scan_failed = false;
+    dense_lambda_depth = 0;
+    if (current_module_prefix) return;
+    dense_collect_stmt(body);
+    dense_scan_stmt(body);
+    if (dense_scan_failed) dense_array_count = 0;
+}
+
+// Append-only string locals for the current function.
+// `s = s + e` (and `s += e`) on a string local compiles to wyn_str_append,
+// which grows the local's buffer in place, when nothing but the local can
+// hold that buffer: the local is only read by comparisons, concatenation,
+// interpolation, indexing, print/len and the string methods that return no
+// string, and is never copied, passed, returned or captured. Reassigning it
+// is fine; the runtime only mutates buffers an earlier append produced.
+typedef struct {
+    char name[64];
+    bool rejected;
+} AppendLocal;
+
+static AppendLocal append_locals[64];
+static int append_local_count = 0;
+static bool append_scan_failed = false;
+static int append_lambda_depth = 0;
+
+static bool is_string_expr(Expr* expr) {
+    return expr && (expr->type == EXPR_STRING ||
+                    (expr->expr_type && expr->expr_type->kind == TYPE_STRING));
+}
+
+// `a + b` where either side is a string
+static bool is_concat_expr(Expr* expr) {
+    return expr && expr->type == EXPR_BINARY && expr->binary.op.type == TOKEN_PLUS &&
+           (is_string_expr(expr->binary.left) || is_string_expr(expr->binary.right));
+}
+
+// Operands of a chain of string `+`, left to right; returns the total count
+// and stores at most max of them
+static int collect_concat_parts(Expr* expr, Expr** parts, int count, int max) {
+    if (!is_concat_expr(expr)) {
+        if (count < max) parts[count] = expr;
+        return count + 1;
+    }
+    count = collect_concat_parts(expr->binary.left, parts, count, max);
+    return collect_concat_parts(expr->binary.right, parts, count, max);
+}
+
+static AppendLocal* find_append_local(Token name) {
+    for (int i = 0; i < append_local_count; i++) {
+        if ((int)strlen(append_locals[i].name) == name.length &&
+            memcmp(append_locals[i].name, name.start, name.length) == 0) {
+            return &append_locals[i];
+        }
+    }
+    return NULL;
+}
+
+// Candidate read by expr, if expr is a bare reference outside any lambda
+static AppendLocal* append_read_target(Expr* expr) {
+    if (!expr || expr->type != EXPR_IDENT || append_lambda_depth > 0) return NULL;
+    return find_append_local(expr->token);
+}
+
+static void append_collect_stmt(Stmt* stmt) {
+    if (!stmt) return;
+    switch (stmt->type) {
+        case STMT_VAR: {
+            if (stmt->var.uses_pattern || stmt->var.name.length >= 64) break;
+            AppendLocal* existing = find_append_local(stmt->var.name);
+            if (existing) {
+                existing->rejected = true;
+                break;
+            }
+            if (!is_string_expr(stmt->var.init) || append_local_count >= 64) break;
+            AppendLocal* local = &append_locals[append_local_count++];
+            snprintf(local->name, 64, "%.*s", stmt->var.name.length, stmt->var.name.start);
+            local->rejected = false;
+            break;
+        }
+        case STMT_BLOCK:
+        case STMT_UNSAFE:
+            for (int i = 0; i < stmt->block.count; i++) append_collect_stmt(stmt->block.stmts[i]);
+            break;
+        case STMT_IF:
+            append_collect_stmt(stmt->if_stmt.then_branch);
+            append_collect_stmt(stmt->if_stmt.else_branch);
+            break;
+        case STMT_WHILE:
+            append_collect_stmt(stmt->while_stmt.body);
+            break;
+        case STMT_SCOPE:
+            append_collect_stmt(stmt->scope.body);
+            break;
+        case STMT_FOR:
+            append_collect_stmt(stmt->for_stmt.init);
+            append_collect_stmt(stmt->for_stmt.body);
+            break;
+        default:
+            break;
+    }
+}
+
+// `name = name + e + ...` on a string, with name an accepted candidate
+static AppendLocal* append_target(Expr* assign) {
+    if (append_local_count == 0 || assign->type != EXPR_ASSIGN) return NULL;
+    Expr* value = assign->assign.value;
+    if (!value || value->type != EXPR_BINARY || value->binary.op.type != TOKEN_PLUS) return NULL;
+    Expr* left = value->binary.left;
+    while (is_concat_expr(left)) left = left->binary.left;
+    if (left->type != EXPR_IDENT || left->token.length != assign->assign.name.length ||
+        memcmp(left->token.start, assign->assign.name.start, left->token.length) != 0) {
+        return NULL;
+    }
+    if (!is_string_expr(value)) return NULL;
+    AppendLocal* local = find_append_local(assign->assign.name);
+    return (local && !local->rejected) ? local : NULL;
+}
+
+static void append_scan_stmt(Stmt* stmt);
+
+// Scan expr; a candidate read directly by expr's parent has already been
+// allowed, so any identifier reaching here escapes
+static void append_scan_expr(Expr* expr) {
+    if (!expr || append_scan_failed) return;
+    switch (expr->type) {
+        case EXPR_INT:
+        case EXPR_FLOAT:
+        case EXPR_STRING:
+        case EXPR_CHAR:
+        case EXPR_BOOL:
+        case EXPR_NONE:
+            break;
+        case EXPR_IDENT: {
+            AppendLocal* local = find_append_local(expr->token);
+            if (local) local->rejected = true;
+            break;
+        }
+        case EXPR_BINARY:
+            // ?? yields one of its operands
+            if (expr->binary.op.type == TOKEN_QUESTION_QUESTION || !append_read_target(expr->binary.left)) {
+                append_scan_expr(expr->binary.left);
+            }
+            if (expr->binary.op.type == TOKEN_QUESTION_QUESTION || !append_read_target(expr->binary.right)) {
+                append_scan_expr(expr->binary.right);
+            }
+            break;
+        case EXPR_UNARY:
+            append_scan_expr(expr->unary.operand);
+            break;
+        case EXPR_AWAIT:
+            append_scan_expr(expr->await.expr);
+            break;
+        case EXPR_CALL: {
+            Expr* callee = expr->call.callee;
+            bool reads_only = callee->type == EXPR_IDENT &&
+                ((callee->token.length == 5 && memcmp(callee->token.start, "print", 5) == 0) ||
+                 (callee->token.length == 7 && memcmp(callee->token.start, "println", 7) == 0) ||
+                 (callee->token.length == 3 && memcmp(callee->token.start, "len", 3) == 0));
+            append_scan_expr(callee);
+            for (int i = 0; i < expr->call.arg_count; i++) {
+                if (!reads_only || !append_read_target(expr->call.args[i])) append_scan_expr(expr->call.args[i]);
+            }
+            break;
+        }
+        case EXPR_METHOD_CALL: {
+            AppendLocal* local = append_read_target(expr->method_call.object);
+            if (local) {
+                Token m = expr->method_call.method;
+                bool ok = (m.length == 3 && memcmp(m.start, "len", 3) == 0) ||
+                          (m.length == 8 && memcmp(m.start, "is_empty", 8) == 0) ||
+                          (m.length == 8 && memcmp(m.start, "contains", 8) == 0) ||
+                          (m.length == 11 && memcmp(m.start, "starts_with", 11) == 0) ||
+                          (m.length == 9 && memcmp(m.start, "ends_with", 9) == 0) ||
+                          (m.length == 8 && memcmp(m.start, "index_of", 8) == 0);
+                if (!ok) local->rejected = true;
+            } else {
+                append_scan_expr(expr->method_call.object);
+            }
+            for (int i = 0; i < expr->method_call.arg_count; i++) append_scan_expr(expr->method_call.args[i]);
+            break;
+        }
+        case EXPR_ARRAY:
+            for (int i = 0; i < expr->array.count; i++) append_scan_expr(expr->array.elements[i]);
+            break;
+        case EXPR_INDEX:
+            // s[i] copies the character out
+            if (!append_read_target(expr->index.array)) append_scan_expr(expr->index.array);
+            append_scan_expr(expr->index.index);
+            break;
+        case EXPR_INDEX_ASSIGN:
+            append_scan_expr(expr->index_assign.object);
+            append_scan_expr(expr->index_assign.index);
+            append_scan_expr(expr->index_assign.value);
+            break;
+        case EXPR_ASSIGN: {
+            AppendLocal* local = find_append_local(expr->assign.name);
+            if (local && append_lambda_depth > 0) local->rejected = true;
+            if (append_target(expr)) {
+                int count = collect_concat_parts(expr->assign.value, NULL, 0, 0);
+                Expr** parts = malloc(sizeof(Expr*) * count);
+                collect_concat_parts(expr->assign.value, parts, 0, count);
+                for (int i = 1; i < count; i++) {
+                    if (!append_read_target(parts[i])) append_scan_expr(parts[i]);
+                }
+                free(parts);
+            } else {
+                append_scan_expr(expr->assign.value);
+            }
+            break;
+        }
+        case EXPR_STRUCT_INIT:
+            for (int i = 0; i < expr->struct_init.field_count; i++) append_scan_expr(expr->struct_init.field_values[i]);
+            break;
+        case EXPR_FIELD_ACCESS:
+            append_scan_expr(expr->field_access.object);
+            break;
+        case EXPR_FIELD_ASSIGN:
+            append_scan_expr(expr->field_assign.object);
+            append_scan_expr(expr->field_assign.value);
+            break;
+        case EXPR_TERNARY:
+            append_scan_expr(expr->ternary.condition);
+            append_scan_expr(expr->ternary.then_expr);
+            append_scan_expr(expr->ternary.else_expr);
+            break;
+        case EXPR_IF_EXPR:
+            append_scan_expr(expr->if_expr.condition);
+            append_scan_expr(expr->if_expr.then_expr);
+            append_scan_expr(expr->if_expr.else_expr);
+            break;
+        case EXPR_STRING_INTERP:
+            // Interpolation copies every part into the result
+            for (int i = 0; i < expr->string_interp.count; i++) {
+                Expr* part = expr->string_interp.expressions[i];
+                if (!append_read_target(part)) append_scan_expr(part);
+            }
+            break;
+        case EXPR_RANGE:
+            append_scan_expr(expr->range.start);
+            append_scan_expr(expr->range.end);
+            break;
+        case EXPR_SOME:
+        case EXPR_OK:
+        case EXPR_ERR:
+            append_scan_expr(expr->option.value);
+            break;
+        case EXPR_TUPLE:
+            for (int i = 0; i < expr->tuple.count; i++) append_scan_expr(expr->tuple.elements[i]);
+            break;
+        case EXPR_TUPLE_INDEX:
+            append_scan_expr(expr->tuple_index.tuple);
+            break;
+        case EXPR_SPAWN:
+            append_scan_expr(expr->spawn.call);
+            break;
+        case EXPR_LAMBDA:
+            append_lambda_depth++;
+            append_scan_expr(expr->lambda.body);
+            append_lambda_depth--;
+            break;
+        default:
+            append_scan_failed = true;
+            break;
+    }
+}
+
+static void append_scan_stmt(Stmt* stmt) {
+    if (!stmt || append_scan_failed) return;
+    switch (stmt->type) {
+        case STMT_EXPR:
+            append_scan_expr(stmt->expr);
+            break;
+        case STMT_VAR:
+            append_scan_expr(stmt->var.init);
+            break;
+        case STMT_RETURN:
+            append_scan_expr(stmt->ret.value);
+            break;
+        case STMT_BLOCK:
+        case STMT_UNSAFE:
+            for (int i = 0; i < stmt->block.count; i++) append_scan_stmt(stmt->block.stmts[i]);
+            break;
+        case STMT_IF:
+            append_scan_expr(stmt->if_stmt.condition);
+            append_scan_stmt(stmt->if_stmt.then_branch);
+            append_scan_stmt(stmt->if_stmt.else_branch);
+            break;
+        case STMT_WHILE:
+            append_scan_expr(stmt->while_stmt.condition);
+            append_scan_stmt(stmt->while_stmt.body);
+            break;
+        case STMT_FOR: {
+            AppendLocal* shadowed = find_append_local(stmt->for_stmt.loop_var);
+            if (shadowed) shadowed->rejected = true;
+            append_scan_expr(stmt->for_stmt.array_expr);
+            append_scan_stmt(stmt->for_stmt.init);
+            append_scan_expr(stmt->for_stmt.condition);
+            append_scan_expr(stmt->for_stmt.increment);
+            append_scan_stmt(stmt->for_stmt.body);
+            break;
+        }
+        case STMT_SCOPE:
+            append_scan_stmt(stmt->scope.body);
+            break;
+        case STMT_SPAWN:
+            append_scan_expr(stmt->spawn.call);
+            break;
+        case STMT_BREAK:
+        case STMT_CONTINUE:
+            break;
+        default:
+            append_scan_failed = true;
+            break;
+    }
+}
 
-// Forward declaration
-static void emit(const char* fmt, ...);
+// Decide which string locals of a function body are appended in place
+static void analyze_append_locals(Stmt* body) {
+    append_local_count = 0;
+    append_scan_failed = false;
+    append_lambda_depth = 0;
+    if (current_module_prefix) return;
+    append_collect_stmt(body);
+    append_scan_stmt(body);
+    if (append_scan_failed) append_local_count = 0;
+}
 
 // Scope tracking for automatic cleanup with ARC integration
 typedef struct {
@@ -250,7 +1191,7 @@ static void pop_scope() {
             
             if (var_type && strcmp(var_type, "WynArray") == 0) {
                 // For WynArray, free the internal data array if it exists
-                emit("    if(%s.data) free(%s.data);\n", var_name, var_name);
+                emit("    if(%s.data) wyn_pool_release(%s.data);\n", var_name, var_name);
             } else if (var_type && (strcmp(var_type, "char*") == 0 || strcmp(var_type, "const char*") == 0)) {
                 // For string pointers, only free if they're not string literals
                 emit("    /* String cleanup handled by ARC */\n");
@@ -336,6 +1277,26 @@ static void emit_type_from_expr(Expr* type_expr) {
     }
 }
 
+void codegen_expr(Expr* expr);
+
+// Operands of a concatenation as a `(const char*[]){...}` literal. Ints are
+// formatted into a stack buffer, so only the joined result is allocated.
+static void emit_concat_array(Expr** parts, int start, int count) {
+    emit("(const char*[]){");
+    for (int i = start; i < count; i++) {
+        if (i > start) emit(", ");
+        Expr* part = parts[i];
+        if (part->expr_type && part->expr_type->kind == TYPE_INT && !is_string_expr(part)) {
+            emit("wyn_str_from_int((char[24]){0}, ");
+            codegen_expr(part);
+            emit(")");
+        } else {
+            codegen_expr(part);
+        }
+    }
+    emit("}");
+}
+
 void codegen_expr(Expr* expr) {
     if (!expr) return;
     
@@ -417,7 +1378,7 @@ void codegen_expr(Expr* expr) {
             // If we're inside a module function, check if this identifier needs module prefix
             if (current_module_prefix && !strchr(temp_ident, ':') && !strchr(temp_ident, '.')) {
                 // Check if this is a parameter - never prefix parameters
-                if (is_parameter(temp_ident)) {
+                if (is_parameter(expr->token)) {
                     // This is a parameter, emit as-is
                     emit("%s", temp_ident);
                     free(ident);
@@ -425,7 +1386,7 @@ void codegen_expr(Expr* expr) {
                 }
                 
                 // Check if this is a local variable - never prefix local variables
-                if (is_local_variable(temp_ident)) {
+                if (is_local_variable(expr->token)) {
                     // This is a local variable, emit as-is
                     emit("%s", temp_ident);
                     free(ident);
@@ -473,16 +1434,24 @@ void codegen_expr(Expr* expr) {
                 const char* full_path = resolve_short_module_name(temp_ident);
                 const char* resolved = resolve_module_alias(full_path);
                 
-                // Rebuild identifier with resolved module name
-                snprintf(temp_ident, sizeof(temp_ident), "%s::%s", resolved, function_part);
+                // Rebuild identifier with resolved module name (resolved may alias temp_ident)
+                char module_part[256];
+                snprintf(module_part, sizeof(module_part), "%s", resolved);
+                if (snprintf(temp_ident, sizeof(temp_ident), "%s::%s", module_part, function_part) >= (int)sizeof(temp_ident)) {
+                    fprintf(stderr, "Error: qualified name %s::%s is too long\n", module_part, function_part);
+                }
             } else if (dot) {
                 // Handle module.function syntax
                 char function_part[256];
                 strcpy(function_part, dot + 1);  // Save function name
                 *dot = '\0';  // Split at dot
                 const char* resolved = resolve_module_alias(temp_ident);
-                // Rebuild identifier with resolved module name
-                snprintf(temp_ident, sizeof(temp_ident), "%s.%s", resolved, function_part);
+                // Rebuild identifier with resolved module name (resolved may alias temp_ident)
+                char module_part[256];
+                snprintf(module_part, sizeof(module_part), "%s", resolved);
+                if (snprintf(temp_ident, sizeof(temp_ident), "%s.%s", module_part, function_part) >= (int)sizeof(temp_ident)) {
+                    fprintf(stderr, "Error: qualified name %s.%s is too long\n", module_part, function_part);
+                }
             }
             
             // Check if this is a C keyword that needs prefix
@@ -531,12 +1500,48 @@ void codegen_expr(Expr* expr) {
             }
             codegen_expr(expr->unary.operand);
             break;
-        case EXPR_AWAIT:
-            // Await: call async function, block on future, cast result
-            emit("*(int*)wyn_block_on(");
+        case EXPR_AWAIT: {
+            // Await: block the calling thread on the future, then take the
+            // value out of the malloc'd box it was completed with. async fn
+            // bodies are not lowered to resumable state machines, so nothing
+            // suspends here; concurrency comes from spawn
+            Type* value_type = expr->expr_type;
+            char struct_name[128];
+            const char* c_type = "int";
+            if (value_type && value_type->kind == TYPE_FLOAT) {
+                c_type = "double";
+            } else if (value_type && value_type->kind == TYPE_STRING) {
+                c_type = "const char*";
+            } else if (value_type && value_type->kind == TYPE_BOOL) {
+                c_type = "bool";
+            } else if (value_type && value_type->kind == TYPE_STRUCT) {
+                snprintf(struct_name, sizeof(struct_name), "%.*s",
+                         value_type->struct_type.name.length, value_type->struct_type.name.start);
+                c_type = struct_name;
+            }
+            emit("({ %s* __await_box = wyn_block_on(", c_type);
             codegen_expr(expr->await.expr);
-            emit(")");
+            emit("); %s __await_value = *__await_box; free(__await_box); __await_value; })", c_type);
+            break;
+        }
+        case EXPR_SPAWN: {
+            // The checker only accepts direct calls; the pre-scan registered a record
+            SpawnWrapper* wrapper = find_spawn_wrapper(expr->spawn.call);
+            if (wrapper && wrapper->fn) {
+                emit("__spawn_start_%s(", wrapper->func_name);
+                for (int i = 0; i < expr->spawn.call->call.arg_count; i++) {
+                    if (i > 0) emit(", ");
+                    emit_spawn_arg(expr->spawn.call->call.args[i]);
+                }
+                emit(")");
+            } else {
+                Token name = expr->spawn.call->call.callee->token;
+                fprintf(stderr, "Error at line %d: cannot spawn '%.*s' with a join handle\n",
+                        expr->token.line, name.length, name.start);
+                emit("NULL");
+            }
             break;
+        }
         case EXPR_BINARY:
             // Special handling for string concatenation with + operator
             if (expr->binary.op.type == TOKEN_PLUS) {
@@ -546,34 +1551,15 @@ void codegen_expr(Expr* expr) {
                 bool right_is_string = (expr->binary.right->type == EXPR_STRING) ||
                                       (expr->binary.right->expr_type && expr->binary.right->expr_type->kind == TYPE_STRING);
                 
-                bool left_is_int = (expr->binary.left->expr_type && expr->binary.left->expr_type->kind == TYPE_INT);
-                bool right_is_int = (expr->binary.right->expr_type && expr->binary.right->expr_type->kind == TYPE_INT);
-                
                 if (left_is_string || right_is_string) {
-                    // Use ARC-managed string concatenation with automatic conversion
-                    emit("wyn_string_concat_safe(");
-                    
-                    // Convert left operand to string if it's an int
-                    if (left_is_int && !left_is_string) {
-                        emit("int_to_string(");
-                        codegen_expr(expr->binary.left);
-                        emit(")");
-                    } else {
-                        codegen_expr(expr->binary.left);
-                    }
-                    
-                    emit(", ");
-                    
-                    // Convert right operand to string if it's an int
-                    if (right_is_int && !right_is_string) {
-                        emit("int_to_string(");
-                        codegen_expr(expr->binary.right);
-                        emit(")");
-                    } else {
-                        codegen_expr(expr->binary.right);
-                    }
-                    
+                    // The whole `a + b + c` chain becomes one sized allocation
+                    int count = collect_concat_parts(expr, NULL, 0, 0);
+                    Expr** parts = malloc(sizeof(Expr*) * count);
+                    collect_concat_parts(expr, parts, 0, count);
+                    emit("wyn_str_concat_n(%d, ", count);
+                    emit_concat_array(parts, 0, count);
                     emit(")");
+                    free(parts);
                     break;
                 }
             }
@@ -588,8 +1574,18 @@ void codegen_expr(Expr* expr) {
                 bool right_is_string = (expr->binary.right->type == EXPR_STRING) ||
                                       (expr->binary.right->expr_type && expr->binary.right->expr_type->kind == TYPE_STRING);
                 
+                if (left_is_string && right_is_string &&
+                    (expr->binary.op.type == TOKEN_EQEQ || expr->binary.op.type == TOKEN_BANGEQ)) {
+                    // Heap strings of different lengths compare unequal without a scan
+                    emit("(wyn_str_eq(");
+                    codegen_expr(expr->binary.left);
+                    emit(", ");
+                    codegen_expr(expr->binary.right);
+                    emit(") %s 0)", expr->binary.op.type == TOKEN_EQEQ ? "!=" : "==");
+                    break;
+                }
                 if (left_is_string && right_is_string) {
-                    // Use strcmp for string comparison
+                    // Use strcmp for ordering
                     emit("(strcmp(");
                     codegen_expr(expr->binary.left);
                     emit(", ");
@@ -954,6 +1950,11 @@ void codegen_expr(Expr* expr) {
                     if (arg->type == EXPR_ARRAY) {
                         // Array literal - count elements directly
                         emit("%d", arg->array.count);
+                    } else if (arg->type == EXPR_STRING ||
+                               (arg->expr_type && arg->expr_type->kind == TYPE_STRING)) {
+                        emit("((int)wyn_str_len(");
+                        codegen_expr(arg);
+                        emit("))");
                     } else {
                         // Variable - assume it's a dynamic array now
                         emit("(");
@@ -1041,9 +2042,7 @@ void codegen_expr(Expr* expr) {
                                 // Check if this is an internal module function call
                                 bool is_internal_call = false;
                                 if (current_module_prefix && !is_module_qualified && expr->call.callee->type == EXPR_IDENT) {
-                                    char func_name[256];
-                                    snprintf(func_name, 256, "%.*s", expr->call.callee->token.length, expr->call.callee->token.start);
-                                    is_internal_call = is_module_function(func_name);
+                                    is_internal_call = is_module_function(expr->call.callee->token);
                                 }
                                 
                                 // Only prefix if NOT an internal call
@@ -1069,9 +2068,7 @@ void codegen_expr(Expr* expr) {
                             // Check if this is an internal module function call
                             bool is_internal_call = false;
                             if (current_module_prefix && !is_module_qualified && expr->call.callee->type == EXPR_IDENT) {
-                                char func_name[256];
-                                snprintf(func_name, 256, "%.*s", expr->call.callee->token.length, expr->call.callee->token.start);
-                                is_internal_call = is_module_function(func_name);
+                                is_internal_call = is_module_function(expr->call.callee->token);
                             }
                             
                             // Only prefix if NOT an internal call
@@ -1134,6 +2131,76 @@ void codegen_expr(Expr* expr) {
         case EXPR_METHOD_CALL: {
             Token method = expr->method_call.method;
             
+            // Join handles from spawn
+            Type* receiver = expr->method_call.object->expr_type;
+            if (receiver && receiver->kind == TYPE_SPAWN) {
+                Token fn_name = receiver->spawn_type.fn_name;
+                // Nothing else holds a temporary handle, so joining it releases it
+                bool temporary = expr->method_call.object->type == EXPR_SPAWN;
+                emit("__spawn_%s_%.*s(", temporary ? "take" : "join", fn_name.length, fn_name.start);
+                codegen_expr(expr->method_call.object);
+                emit(")");
+                break;
+            }
+            
+            // Dense local arrays: operate on the unboxed storage directly
+            DenseArray* dense = dense_array_for(expr->method_call.object);
+            if (dense) {
+                const char* name = dense->name;
+                if (method.length == 3 && memcmp(method.start, "len", 3) == 0) {
+                    emit("(%s).count", name);
+                } else if (method.length == 8 && memcmp(method.start, "is_empty", 8) == 0) {
+                    emit("((%s).count == 0)", name);
+                } else if (method.length == 4 && memcmp(method.start, "push", 4) == 0) {
+                    emit("wyn_dense_push(%s, ", name);
+                    codegen_expr(expr->method_call.args[0]);
+                    emit(")");
+                } else if (method.length == 3 && memcmp(method.start, "get", 3) == 0) {
+                    if (dense->kind == DENSE_STRUCT) {
+                        emit("(%s).data[", name);
+                        codegen_expr(expr->method_call.args[0]);
+                        emit("]");
+                    } else {
+                        emit("wyn_dense_get(%s, ", name);
+                        codegen_expr(expr->method_call.args[0]);
+                        emit(", ");
+                        emit_dense_fallback(dense);
+                        emit(")");
+                    }
+                } else if (method.length == 4 && memcmp(method.start, "sort", 4) == 0) {
+                    if (dense->kind == DENSE_INT) {
+                        emit("wyn_sort_int_parallel((%s).data, (size_t)(%s).count)", name, name);
+                    } else if (dense->kind == DENSE_FLOAT) {
+                        emit("wyn_sort_float((%s).data, (size_t)(%s).count)", name, name);
+                    } else {
+                        emit("wyn_sort_str((%s).data, (size_t)(%s).count)", name, name);
+                    }
+                } else if (method.length == 7 && memcmp(method.start, "sort_by", 7) == 0) {
+                    emit("wyn_sort_int_by((%s).data, (size_t)(%s).count, ", name, name);
+                    codegen_expr(expr->method_call.args[0]);
+                    emit(")");
+                } else if (method.length == 14 && memcmp(method.start, "stable_sort_by", 14) == 0) {
+                    emit("wyn_sort_int_stable_by((%s).data, (size_t)(%s).count, ", name, name);
+                    codegen_expr(expr->method_call.args[0]);
+                    emit(")");
+                } else if (method.length == 11 && memcmp(method.start, "sort_by_key", 11) == 0) {
+                    emit("wyn_sort_by_key((%s).data, (size_t)(%s).count, sizeof(%s), ",
+                         name, name, dense->struct_name);
+                    if (!emit_sort_key_args(dense->struct_name, dense->struct_name, expr->method_call.args[0])) {
+                        fprintf(stderr, "Error: sort_by_key expects the name of an int, float or string field of %s\n",
+                                dense->struct_name);
+                        emit("0, WYN_SORT_KEY_INT");
+                    }
+                    emit(")");
+                } else {
+                    // pop, first, last
+                    emit("wyn_dense_%.*s(%s, ", method.length, method.start, name);
+                    emit_dense_fallback(dense);
+                    emit(")");
+                }
+                break;
+            }
+            
             // Extension methods on struct types - CHECK THIS FIRST
             if (expr->method_call.object->expr_type && 
                 expr->method_call.object->expr_type->kind == TYPE_STRUCT) {
@@ -1217,6 +2284,33 @@ void codegen_expr(Expr* expr) {
                 }
             }
             
+            // array.sort_by_key("field") on struct elements: resolve the field statically
+            if (object_type && object_type->kind == TYPE_ARRAY) {
+                Token method = expr->method_call.method;
+                Type* elem_type = object_type->array_type.element_type;
+                if (method.length == 11 && memcmp(method.start, "sort_by_key", 11) == 0 &&
+                    elem_type && elem_type->kind == TYPE_STRUCT && expr->method_call.arg_count == 1) {
+                    Token type_name = elem_type->struct_type.name;
+                    char wyn_name[64], c_name[128];
+                    snprintf(wyn_name, sizeof(wyn_name), "%.*s", type_name.length, type_name.start);
+                    if (current_module_prefix) {
+                        snprintf(c_name, sizeof(c_name), "%s_%s", current_module_prefix, wyn_name);
+                    } else {
+                        snprintf(c_name, sizeof(c_name), "%s", wyn_name);
+                    }
+                    emit("array_sort_by_key(&(");
+                    codegen_expr(expr->method_call.object);
+                    emit("), ");
+                    if (!emit_sort_key_args(wyn_name, c_name, expr->method_call.args[0])) {
+                        fprintf(stderr, "Error: sort_by_key expects the name of an int, float or string field of %s\n",
+                                wyn_name);
+                        emit("0, WYN_SORT_KEY_INT");
+                    }
+                    emit(")");
+                    break;
+                }
+            }
+            
             // Special handling for array.get() - use type-specific accessor
             if (object_type && object_type->kind == TYPE_ARRAY) {
                 Token method = expr->method_call.method;
@@ -1341,17 +2435,9 @@ void codegen_expr(Expr* expr) {
                 for (int i = 0; i < expr->array.count; i += 2) {
                     Expr* value_expr = expr->array.elements[i+1];
                     
-                    // Determine insert function based on value type
-                    const char* insert_func = "hashmap_insert_int";
-                    if (value_expr->type == EXPR_FLOAT) {
-                        insert_func = "hashmap_insert_float";
-                    } else if (value_expr->type == EXPR_STRING) {
-                        insert_func = "hashmap_insert_string";
-                    } else if (value_expr->type == EXPR_BOOL) {
-                        insert_func = "hashmap_insert_bool";
-                    }
-                    
-                    emit("%s(__map_%d, ", insert_func, map_id);
+                    // Determine insert function based on key and value type
+                    bool int_key = expr->array.elements[i]->type == EXPR_INT;
+                    emit("hashmap_insert%s(__map_%d, ", map_access_suffix(value_expr->expr_type, int_key), map_id);
                     codegen_expr(expr->array.elements[i]);    // key
                     emit(", ");
                     codegen_expr(expr->array.elements[i+1]);  // value
@@ -1385,6 +2471,24 @@ void codegen_expr(Expr* expr) {
             break;
         }
         case EXPR_INDEX: {
+            // Dense local array: direct element access
+            DenseArray* dense = dense_array_for(expr->index.array);
+            if (dense) {
+                if (dense->kind == DENSE_STRUCT) {
+                    // Struct elements are lvalues so fields can be assigned in place
+                    emit("(%s).data[", dense->name);
+                    codegen_expr(expr->index.index);
+                    emit("]");
+                } else {
+                    emit("wyn_dense_get(%s, ", dense->name);
+                    codegen_expr(expr->index.index);
+                    emit(", ");
+                    emit_dense_fallback(dense);
+                    emit(")");
+                }
+                break;
+            }
+            
             // Check if this is string indexing
             if (expr->index.array->expr_type && expr->index.array->expr_type->kind == TYPE_STRING) {
                 // String indexing: s[i] -> wyn_string_charat(s, i)
@@ -1406,8 +2510,9 @@ void codegen_expr(Expr* expr) {
             }
             
             if (is_map_index) {
-                // Map indexing: map["key"] -> hashmap_get_int(map, "key")
-                emit("hashmap_get_int(");
+                // Map indexing: map["key"] -> hashmap_get_<value>(map, "key"), map[n] -> hashmap_get_[<value>_]int_key(map, n)
+                bool int_key = expr->index.index->expr_type && expr->index.index->expr_type->kind == TYPE_INT;
+                emit("hashmap_get%s(", map_access_suffix(expr->expr_type, int_key));
                 codegen_expr(expr->index.array);
                 emit(", ");
                 codegen_expr(expr->index.index);
@@ -1533,6 +2638,29 @@ void codegen_expr(Expr* expr) {
             break;
         }
         case EXPR_ASSIGN: {
+            if (append_target(expr)) {
+                // s = s + e + ... on an append-only local: grow the buffer in place
+                Token name = expr->assign.name;
+                int count = collect_concat_parts(expr->assign.value, NULL, 0, 0);
+                Expr** parts = malloc(sizeof(Expr*) * count);
+                collect_concat_parts(expr->assign.value, parts, 0, count);
+                emit("%.*s = wyn_str_append_n(%.*s, %d, ", name.length, name.start,
+                     name.length, name.start, count - 1);
+                emit_concat_array(parts, 1, count);
+                emit(")");
+                free(parts);
+                break;
+            }
+            if (expr->assign.value->expr_type && expr->assign.value->expr_type->kind == TYPE_SPAWN) {
+                // The variable owns its handle: drop the one it held before
+                Token name = expr->assign.name;
+                emit("({ __auto_type __old_handle = %.*s; %.*s = ", name.length, name.start,
+                     name.length, name.start);
+                emit_spawn_owned(expr->assign.value);
+                emit("; if (__old_handle) wyn_spawn_release(&__old_handle->handle); %.*s; })",
+                     name.length, name.start);
+                break;
+            }
             // Check if we need to prefix the assignment target with module name
             char target_name[512];
             memcpy(target_name, expr->assign.name.start, expr->assign.name.length);
@@ -1540,14 +2668,14 @@ void codegen_expr(Expr* expr) {
             
             if (current_module_prefix && !strchr(target_name, ':') && !strchr(target_name, '.')) {
                 // Check if this is a parameter - never prefix parameters
-                if (is_parameter(target_name)) {
+                if (is_parameter(expr->assign.name)) {
                     emit("%.*s = ", expr->assign.name.length, expr->assign.name.start);
                     codegen_expr(expr->assign.value);
                     break;
                 }
                 
                 // Check if this is a local variable - never prefix local variables
-                if (is_local_variable(target_name)) {
+                if (is_local_variable(expr->assign.name)) {
                     emit("%.*s = ", expr->assign.name.length, expr->assign.name.start);
                     codegen_expr(expr->assign.value);
                     break;
@@ -1578,8 +2706,6 @@ void codegen_expr(Expr* expr) {
             break;
         }
         case EXPR_STRUCT_INIT: {
-            // Check if type needs ARC management
-            bool needs_arc = false;
             Token type_name = expr->struct_init.type_name;
             
             // Use monomorphic name if available (for generic structs)
@@ -1615,33 +2741,17 @@ void codegen_expr(Expr* expr) {
                 }
             }
             
-            // Simple heuristic: types starting with uppercase likely need ARC
-            if (actual_type_name_len > 0 && actual_type_name[0] >= 'A' && actual_type_name[0] <= 'Z') {
-                needs_arc = true;
-            }
-            
-            if (needs_arc) {
-                // Generate ARC-managed struct initialization with cast
-                emit("*(%.*s*)wyn_arc_new(sizeof(%.*s), &(%.*s){", 
-                     actual_type_name_len, actual_type_name,
-                     actual_type_name_len, actual_type_name,
-                     actual_type_name_len, actual_type_name);
-                for (int i = 0; i < expr->struct_init.field_count; i++) {
-                    if (i > 0) emit(", ");
-                    emit(".%.*s = ", expr->struct_init.field_names[i].length, expr->struct_init.field_names[i].start);
-                    codegen_expr(expr->struct_init.field_values[i]);
-                }
-                emit("})->data");
-            } else {
-                // Generate simple struct initialization
-                emit("(%.*s){", actual_type_name_len, actual_type_name);
-                for (int i = 0; i < expr->struct_init.field_count; i++) {
-                    if (i > 0) emit(", ");
-                    emit(".%.*s = ", expr->struct_init.field_names[i].length, expr->struct_init.field_names[i].start);
-                    codegen_expr(expr->struct_init.field_values[i]);
-                }
-                emit("}");
+            // Structs are values: the literal is only ever copied into its
+            // destination, so it needs no ARC box of its own. The copy out of
+            // a box would be the box's last use (a move), and its reference
+            // was never released, so the allocation pair cancels entirely.
+            emit("(%.*s){", actual_type_name_len, actual_type_name);
+            for (int i = 0; i < expr->struct_init.field_count; i++) {
+                if (i > 0) emit(", ");
+                emit(".%.*s = ", expr->struct_init.field_names[i].length, expr->struct_init.field_names[i].start);
+                codegen_expr(expr->struct_init.field_values[i]);
             }
+            emit("}");
             break;
         }
         case EXPR_FIELD_ACCESS: {
@@ -1935,37 +3045,39 @@ void codegen_expr(Expr* expr) {
             emit(")");
             break;
         case EXPR_STRING_INTERP: {
-            // String interpolation: "Hello ${name}" -> sprintf format
-            emit("({ char __buf[256]; sprintf(__buf, \"");
-            
-            // Build format string - use %s for everything and convert with _Generic
+            // "Hello ${name}!" -> wyn_str_concat_n(3, {"Hello ", name, "!"})
+            int count = 0;
             for (int i = 0; i < expr->string_interp.count; i++) {
-                if (expr->string_interp.parts[i]) {
-                    // String literal part
-                    const char* part = expr->string_interp.parts[i];
-                    while (*part) {
-                        if (*part == '%') emit("%%"); // Escape % for sprintf
-                        else emit("%c", *part);
-                        part++;
-                    }
-                } else {
-                    // Expression part - use %s and convert with to_string
-                    emit("%%s");
-                }
+                const char* text = expr->string_interp.parts[i];
+                if (!text || text[0]) count++;
             }
-            
-            emit("\"");
-            
-            // Add arguments for expressions with type conversion
+            if (count == 0) {
+                emit("wyn_str_new(\"\", 0)");
+                break;
+            }
+            emit("wyn_str_concat_n(%d, (const char*[]){", count);
+            bool first = true;
             for (int i = 0; i < expr->string_interp.count; i++) {
-                if (expr->string_interp.expressions[i]) {
-                    emit(", to_string(");
-                    codegen_expr(expr->string_interp.expressions[i]);
+                const char* text = expr->string_interp.parts[i];
+                Expr* part = expr->string_interp.expressions[i];
+                if (text && !text[0]) continue;
+                if (!first) emit(", ");
+                first = false;
+                if (text) {
+                    emit("\"%s\"", text);
+                } else if (is_string_expr(part)) {
+                    codegen_expr(part);
+                } else if (part->expr_type && part->expr_type->kind == TYPE_INT) {
+                    emit("wyn_str_from_int((char[24]){0}, ");
+                    codegen_expr(part);
+                    emit(")");
+                } else {
+                    emit("to_string(");
+                    codegen_expr(part);
                     emit(")");
                 }
             }
-            
-            emit("); __buf; })");
+            emit("})");
             break;
         }
         case EXPR_RANGE:
@@ -1981,7 +3093,6 @@ void codegen_expr(Expr* expr) {
             // Just emit the function pointer reference
             // Find which lambda this is by matching the expression
             // For now, use a simple counter approach
-            static int lambda_ref_counter = 0;
             lambda_ref_counter++;
             emit("__lambda_%d", lambda_ref_counter);
             break;
@@ -2028,6 +3139,16 @@ void codegen_expr(Expr* expr) {
             break;
         }
         case EXPR_INDEX_ASSIGN: {
+            DenseArray* dense = dense_array_for(expr->index_assign.object);
+            if (dense) {
+                emit("wyn_dense_set(%s, ", dense->name);
+                codegen_expr(expr->index_assign.index);
+                emit(", ");
+                codegen_expr(expr->index_assign.value);
+                emit(")");
+                break;
+            }
+            
             // Check if this is map assignment
             bool is_map_assign = false;
             if (expr->index_assign.object->expr_type && expr->index_assign.object->expr_type->kind == TYPE_MAP) {
@@ -2038,8 +3159,11 @@ void codegen_expr(Expr* expr) {
             }
             
             if (is_map_assign) {
-                // Map assignment: map["key"] = value -> hashmap_insert_int(map, "key", value)
-                emit("hashmap_insert_int(");
+                // Map assignment: map["key"] = value -> hashmap_insert_<value>(map, "key", value)
+                bool int_key = expr->index_assign.index->expr_type &&
+                               expr->index_assign.index->expr_type->kind == TYPE_INT;
+                Type* value_type = expr->index_assign.value->expr_type;
+                emit("hashmap_insert%s(", map_access_suffix(value_type, int_key));
                 codegen_expr(expr->index_assign.object);
                 emit(", ");
                 codegen_expr(expr->index_assign.index);
@@ -2118,7 +3242,9 @@ void codegen_c_header() {
     emit("#include \"wyn_interface.h\"\n");
     emit("#include \"io.h\"\n");
     emit("#include \"arc_runtime.h\"\n");
+    emit("#include \"string_runtime.h\"\n");
     emit("#include \"spawn.h\"\n");  // Spawn runtime
+    emit("#include \"sort.h\"\n");
     emit("#include \"optional.h\"\n");
     emit("#include \"result.h\"\n");
     emit("#include \"hashmap.h\"\n");
@@ -2152,9 +3278,6 @@ void codegen_c_header() {
     emit("bool wyn_c_compile_to_binary(const char* c_filename, const char* wyn_filename);\n");
     emit("bool wyn_c_remove_file(const char* filename);\n\n");
     
-    // String runtime functions
-    emit("const char* wyn_string_concat_safe(const char* left, const char* right);\n\n");
-    
     // Testing framework
     emit("// Test module\n");
     emit("void Test_init(const char* suite_name);\n");
@@ -2183,6 +3306,25 @@ void codegen_c_header() {
     emit("const char* Http_header(HttpResponse* resp, const char* name);\n");
     emit("void Http_free(HttpResponse* resp);\n\n");
     
+    // HTTP server
+    emit("// HttpServer module\n");
+    emit("typedef struct WynHttpServer WynHttpServer;\n");
+    emit("WynHttpServer* HttpServer_new(int port);\n");
+    emit("void HttpServer_workers(WynHttpServer* server, int count);\n");
+    emit("int HttpServer_port(WynHttpServer* server);\n");
+    emit("int HttpServer_serve(WynHttpServer* server, int (*handler)(int));\n");
+    emit("void HttpServer_stop(WynHttpServer* server);\n");
+    emit("void HttpServer_free(WynHttpServer* server);\n");
+    emit("const char* HttpServer_method(int req);\n");
+    emit("const char* HttpServer_path(int req);\n");
+    emit("const char* HttpServer_query(int req);\n");
+    emit("const char* HttpServer_header(int req, const char* name);\n");
+    emit("const char* HttpServer_body(int req);\n");
+    emit("void HttpServer_set_header(int req, const char* name, const char* value);\n");
+    emit("int HttpServer_respond(int req, int status, const char* content_type, const char* body);\n");
+    emit("int HttpServer_send_file(int req, const char* path, const char* content_type);\n");
+    emit("void HttpServer_shutdown(int req);\n\n");
+    
     // TCP server
     emit("// TcpServer module\n");
     emit("typedef struct TcpServer TcpServer;\n");
@@ -2196,7 +3338,11 @@ void codegen_c_header() {
     emit("int Socket_set_timeout(int sock, int seconds);\n");
     emit("int Socket_set_nonblocking(int sock);\n");
     emit("int Socket_poll_read(int sock, int timeout_ms);\n");
-    emit("char* Socket_read_line(int sock);\n\n");
+    emit("char* Socket_read_line(int sock);\n");
+    emit("char* Socket_read_until(int sock, const char* delim);\n");
+    emit("char* Socket_read_exact(int sock, int count);\n");
+    emit("char* Socket_read(int sock, int max_len);\n");
+    emit("int Socket_close(int sock);\n\n");
     
     // URL utilities
     emit("// Url module\n");
@@ -2223,10 +3369,35 @@ void codegen_c_header() {
     
     emit("// Json module\n");
     emit("typedef struct WynJson WynJson;\n");
+    emit("typedef struct WynJsonReader WynJsonReader;\n");
     emit("WynJson* Json_parse(const char* text);\n");
+    emit("WynJson* Json_parse_file(const char* path);\n");
+    emit("const char* Json_error(void);\n");
+    emit("WynJson* Json_get(WynJson* json, const char* key);\n");
+    emit("WynJson* Json_at(WynJson* json, int index);\n");
+    emit("int Json_len(WynJson* json);\n");
+    emit("int Json_has(WynJson* json, const char* key);\n");
+    emit("int Json_kind(WynJson* json);\n");
     emit("char* Json_get_string(WynJson* json, const char* key);\n");
     emit("int Json_get_int(WynJson* json, const char* key);\n");
-    emit("void Json_free(WynJson* json);\n\n");
+    emit("double Json_get_float(WynJson* json, const char* key);\n");
+    emit("int Json_get_bool(WynJson* json, const char* key);\n");
+    emit("char* Json_as_string(WynJson* json);\n");
+    emit("int Json_as_int(WynJson* json);\n");
+    emit("double Json_as_float(WynJson* json);\n");
+    emit("int Json_as_bool(WynJson* json);\n");
+    emit("const char* Json_stringify(WynJson* json);\n");
+    emit("void Json_free(WynJson* json);\n");
+    emit("WynJsonReader* Json_reader_open(const char* path);\n");
+    emit("WynJsonReader* Json_reader_from_string(const char* text);\n");
+    emit("int Json_reader_next(WynJsonReader* reader);\n");
+    emit("const char* Json_reader_string(WynJsonReader* reader);\n");
+    emit("int Json_reader_int(WynJsonReader* reader);\n");
+    emit("double Json_reader_float(WynJsonReader* reader);\n");
+    emit("int Json_reader_bool(WynJsonReader* reader);\n");
+    emit("int Json_reader_depth(WynJsonReader* reader);\n");
+    emit("const char* Json_reader_error(WynJsonReader* reader);\n");
+    emit("void Json_reader_close(WynJsonReader* reader);\n\n");
     
     emit("// Time module wrappers\n");
     emit("long Time_now();\n");
@@ -2238,20 +3409,20 @@ void codegen_c_header() {
     emit("unsigned long long Crypto_hash64(const char* data);\n\n");
     
     emit("// HashMap module\n");
-    emit("int HashMap_new();\n");
-    emit("void HashMap_insert(int map, const char* key, int value);\n");
-    emit("int HashMap_get(int map, const char* key);\n");
-    emit("int HashMap_contains(int map, const char* key);\n");
-    emit("int HashMap_len(int map);\n");
-    emit("int HashMap_remove(int map, const char* key);\n");
-    emit("void HashMap_clear(int map);\n");
-    emit("void HashMap_free(int map);\n");
-    emit("int wyn_hashmap_new();\n");
-    emit("void wyn_hashmap_insert_int(int map, const char* key, int value);\n");
-    emit("int wyn_hashmap_get_int(int map, const char* key);\n");
-    emit("int wyn_hashmap_has(int map, const char* key);\n");
-    emit("int wyn_hashmap_len(int map);\n");
-    emit("void wyn_hashmap_free(int map);\n\n");
+    emit("WynHashMap* HashMap_new();\n");
+    emit("void HashMap_insert(WynHashMap* map, const char* key, int value);\n");
+    emit("int HashMap_get(WynHashMap* map, const char* key);\n");
+    emit("int HashMap_contains(WynHashMap* map, const char* key);\n");
+    emit("int HashMap_len(WynHashMap* map);\n");
+    emit("int HashMap_remove(WynHashMap* map, const char* key);\n");
+    emit("void HashMap_clear(WynHashMap* map);\n");
+    emit("void HashMap_free(WynHashMap* map);\n");
+    emit("WynHashMap* wyn_hashmap_new();\n");
+    emit("void wyn_hashmap_insert_int(WynHashMap* map, const char* key, int value);\n");
+    emit("int wyn_hashmap_get_int(WynHashMap* map, const char* key);\n");
+    emit("int wyn_hashmap_has(WynHashMap* map, const char* key);\n");
+    emit("int wyn_hashmap_len(WynHashMap* map);\n");
+    emit("void wyn_hashmap_free(WynHashMap* map);\n\n");
     
     emit("// Arena module\n");
     emit("typedef struct WynArena WynArena;\n");
@@ -2329,6 +3500,20 @@ void codegen_c_header() {
     
     emit("typedef struct WynArray { WynValue* data; int count; int capacity; } WynArray;\n");
     
+    // Spawn arguments: mark an array's strings and nested arrays shared;
+    // elements it cannot walk make every count atomic instead
+    emit("WynArray wyn_array_share(WynArray arr) {\n");
+    emit("    for (int i = 0; i < arr.count; i++) {\n");
+    emit("        switch (arr.data[i].type) {\n");
+    emit("            case WYN_TYPE_INT: case WYN_TYPE_FLOAT: case WYN_TYPE_BOOL: break;\n");
+    emit("            case WYN_TYPE_STRING: wyn_str_share(arr.data[i].data.string_val); break;\n");
+    emit("            case WYN_TYPE_ARRAY: if (arr.data[i].data.array_val) wyn_array_share(*arr.data[i].data.array_val); break;\n");
+    emit("            default: wyn_arc_share_all(); return arr;\n");
+    emit("        }\n");
+    emit("    }\n");
+    emit("    return arr;\n");
+    emit("}\n");
+    
     // Forward declarations for higher-order array functions
     emit("WynArray wyn_array_map(WynArray arr, int (*fn)(int));\n");
     emit("WynArray wyn_array_filter(WynArray arr, int (*fn)(int));\n");
@@ -2338,7 +3523,7 @@ void codegen_c_header() {
     emit("void array_push_int(WynArray* arr, int value) {\n");
     emit("    if (arr->count >= arr->capacity) {\n");
     emit("        arr->capacity = arr->capacity == 0 ? 4 : arr->capacity * 2;\n");
-    emit("        arr->data = realloc(arr->data, sizeof(WynValue) * arr->capacity);\n");
+    emit("        arr->data = wyn_pool_realloc(arr->data, sizeof(WynValue) * arr->capacity);\n");
     emit("    }\n");
     emit("    arr->data[arr->count].type = WYN_TYPE_INT;\n");
     emit("    arr->data[arr->count].data.int_val = value;\n");
@@ -2347,7 +3532,7 @@ void codegen_c_header() {
     emit("void array_push_str(WynArray* arr, const char* value) {\n");
     emit("    if (arr->count >= arr->capacity) {\n");
     emit("        arr->capacity = arr->capacity == 0 ? 4 : arr->capacity * 2;\n");
-    emit("        arr->data = realloc(arr->data, sizeof(WynValue) * arr->capacity);\n");
+    emit("        arr->data = wyn_pool_realloc(arr->data, sizeof(WynValue) * arr->capacity);\n");
     emit("    }\n");
     emit("    arr->data[arr->count].type = WYN_TYPE_STRING;\n");
     emit("    arr->data[arr->count].data.string_val = value;\n");
@@ -2356,7 +3541,7 @@ void codegen_c_header() {
     emit("void array_push_array(WynArray* arr, WynArray* nested) {\n");
     emit("    if (arr->count >= arr->capacity) {\n");
     emit("        arr->capacity = arr->capacity == 0 ? 4 : arr->capacity * 2;\n");
-    emit("        arr->data = realloc(arr->data, sizeof(WynValue) * arr->capacity);\n");
+    emit("        arr->data = wyn_pool_realloc(arr->data, sizeof(WynValue) * arr->capacity);\n");
     emit("    }\n");
     emit("    arr->data[arr->count].type = WYN_TYPE_ARRAY;\n");
     emit("    arr->data[arr->count].data.array_val = nested;\n");
@@ -2397,6 +3582,25 @@ void codegen_c_header() {
     emit("    if (nested2 == NULL) return 0;\n");
     emit("    return array_get_int(*nested2, index3);\n");
     emit("}\n\n");
+
+    // Dense arrays: locals with a single known element type store it unboxed
+    emit("#define WynDenseArray(T) struct { T* data; int count; int capacity; }\n");
+    // The value is variadic: struct compound literals carry top-level commas
+    emit("#define wyn_dense_push(arr, ...) ({ \\\n");
+    emit("    if ((arr).count >= (arr).capacity) { \\\n");
+    emit("        (arr).capacity = (arr).capacity == 0 ? 4 : (arr).capacity * 2; \\\n");
+    emit("        (arr).data = wyn_pool_realloc((arr).data, sizeof(*(arr).data) * (arr).capacity); \\\n");
+    emit("    } \\\n");
+    emit("    (arr).data[(arr).count++] = (__VA_ARGS__); \\\n");
+    emit("    (void)0; })\n");
+    emit("#define wyn_dense_get(arr, index, fallback) ({ int __di = (index); \\\n");
+    emit("    (__di >= 0 && __di < (arr).count) ? (arr).data[__di] : (fallback); })\n");
+    emit("#define wyn_dense_set(arr, index, ...) ({ int __di = (index); \\\n");
+    emit("    if (__di >= 0 && __di < (arr).count) (arr).data[__di] = (__VA_ARGS__); \\\n");
+    emit("    (void)0; })\n");
+    emit("#define wyn_dense_pop(arr, fallback) ((arr).count > 0 ? (arr).data[--(arr).count] : (fallback))\n");
+    emit("#define wyn_dense_first(arr, fallback) ((arr).count > 0 ? (arr).data[0] : (fallback))\n");
+    emit("#define wyn_dense_last(arr, fallback) ((arr).count > 0 ? (arr).data[(arr).count - 1] : (fallback))\n\n");
     
     // Array methods (Phase 4)
     emit("int array_len(WynArray arr) { return arr.count; }\n");
@@ -2410,7 +3614,7 @@ void codegen_c_header() {
     emit("void array_push(WynArray* arr, int value) {\n");
     emit("    if (arr->count >= arr->capacity) {\n");
     emit("        arr->capacity = arr->capacity == 0 ? 4 : arr->capacity * 2;\n");
-    emit("        arr->data = realloc(arr->data, sizeof(WynValue) * arr->capacity);\n");
+    emit("        arr->data = wyn_pool_realloc(arr->data, sizeof(WynValue) * arr->capacity);\n");
     emit("    }\n");
     emit("    arr->data[arr->count].type = WYN_TYPE_INT;\n");
     emit("    arr->data[arr->count].data.int_val = value;\n");
@@ -2420,10 +3624,10 @@ void codegen_c_header() {
     emit("    StructType __temp_val = (value); \\\n");
     emit("    if ((arr)->count >= (arr)->capacity) { \\\n");
     emit("        (arr)->capacity = (arr)->capacity == 0 ? 4 : (arr)->capacity * 2; \\\n");
-    emit("        (arr)->data = realloc((arr)->data, sizeof(WynValue) * (arr)->capacity); \\\n");
+    emit("        (arr)->data = wyn_pool_realloc((arr)->data, sizeof(WynValue) * (arr)->capacity); \\\n");
     emit("    } \\\n");
     emit("    (arr)->data[(arr)->count].type = WYN_TYPE_STRUCT; \\\n");
-    emit("    (arr)->data[(arr)->count].data.struct_val = malloc(sizeof(StructType)); \\\n");
+    emit("    (arr)->data[(arr)->count].data.struct_val = wyn_pool_alloc(sizeof(StructType)); \\\n");
     emit("    memcpy((arr)->data[(arr)->count].data.struct_val, &__temp_val, sizeof(StructType)); \\\n");
     emit("    (arr)->count++; \\\n");
     emit("} while(0)\n");
@@ -2445,16 +3649,68 @@ void codegen_c_header() {
     emit("        arr->data[arr->count - 1 - i] = temp;\n");
     emit("    }\n");
     emit("}\n");
+    // Sorting (runtime in sort.c): uniformly typed arrays are sorted as
+    // unboxed copies, anything else with a stable sort on the tagged values
+    emit("static int wyn_value_compare(const void* a, const void* b, void* ctx) {\n");
+    emit("    (void)ctx;\n");
+    emit("    const WynValue* x = a; const WynValue* y = b;\n");
+    emit("    if (x->type != y->type) return (x->type > y->type) - (x->type < y->type);\n");
+    emit("    if (x->type == WYN_TYPE_FLOAT) return (x->data.float_val > y->data.float_val) - (x->data.float_val < y->data.float_val);\n");
+    emit("    if (x->type == WYN_TYPE_STRING) return strcmp(x->data.string_val ? x->data.string_val : \"\", y->data.string_val ? y->data.string_val : \"\");\n");
+    emit("    return (x->data.int_val > y->data.int_val) - (x->data.int_val < y->data.int_val);\n");
+    emit("}\n");
     emit("void array_sort(WynArray* arr) {\n");
-    emit("    for (int i = 0; i < arr->count - 1; i++) {\n");
-    emit("        for (int j = 0; j < arr->count - i - 1; j++) {\n");
-    emit("            if (arr->data[j].data.int_val > arr->data[j + 1].data.int_val) {\n");
-    emit("                WynValue temp = arr->data[j];\n");
-    emit("                arr->data[j] = arr->data[j + 1];\n");
-    emit("                arr->data[j + 1] = temp;\n");
-    emit("            }\n");
-    emit("        }\n");
+    emit("    int n = arr->count;\n");
+    emit("    if (n < 2) return;\n");
+    emit("    WynTypeId type = arr->data[0].type;\n");
+    emit("    bool uniform = true;\n");
+    emit("    for (int i = 1; i < n && uniform; i++) uniform = arr->data[i].type == type;\n");
+    emit("    if (uniform && type == WYN_TYPE_INT) {\n");
+    emit("        int* keys = malloc(sizeof(int) * n);\n");
+    emit("        for (int i = 0; i < n; i++) keys[i] = arr->data[i].data.int_val;\n");
+    emit("        wyn_sort_int_parallel(keys, n);\n");
+    emit("        for (int i = 0; i < n; i++) arr->data[i].data.int_val = keys[i];\n");
+    emit("        free(keys);\n");
+    emit("    } else if (uniform && type == WYN_TYPE_FLOAT) {\n");
+    emit("        double* keys = malloc(sizeof(double) * n);\n");
+    emit("        for (int i = 0; i < n; i++) keys[i] = arr->data[i].data.float_val;\n");
+    emit("        wyn_sort_float(keys, n);\n");
+    emit("        for (int i = 0; i < n; i++) arr->data[i].data.float_val = keys[i];\n");
+    emit("        free(keys);\n");
+    emit("    } else if (uniform && type == WYN_TYPE_STRING) {\n");
+    emit("        const char** keys = malloc(sizeof(const char*) * n);\n");
+    emit("        for (int i = 0; i < n; i++) keys[i] = arr->data[i].data.string_val;\n");
+    emit("        wyn_sort_str(keys, n);\n");
+    emit("        for (int i = 0; i < n; i++) arr->data[i].data.string_val = keys[i];\n");
+    emit("        free(keys);\n");
+    emit("    } else {\n");
+    emit("        wyn_sort_stable(arr->data, n, sizeof(WynValue), wyn_value_compare, NULL);\n");
     emit("    }\n");
+    emit("}\n");
+    emit("static void array_sort_ints_with(WynArray* arr, int (*cmp)(int, int), bool stable) {\n");
+    emit("    int n = arr->count;\n");
+    emit("    if (n < 2) return;\n");
+    emit("    int* keys = malloc(sizeof(int) * n);\n");
+    emit("    for (int i = 0; i < n; i++) keys[i] = arr->data[i].data.int_val;\n");
+    emit("    if (stable) wyn_sort_int_stable_by(keys, n, cmp); else wyn_sort_int_by(keys, n, cmp);\n");
+    emit("    for (int i = 0; i < n; i++) { arr->data[i].type = WYN_TYPE_INT; arr->data[i].data.int_val = keys[i]; }\n");
+    emit("    free(keys);\n");
+    emit("}\n");
+    emit("void array_sort_by(WynArray* arr, int (*cmp)(int, int)) { array_sort_ints_with(arr, cmp, false); }\n");
+    emit("void array_stable_sort_by(WynArray* arr, int (*cmp)(int, int)) { array_sort_ints_with(arr, cmp, true); }\n");
+    emit("typedef struct { size_t offset; WynSortKeyType key_type; } WynValueKey;\n");
+    emit("static int wyn_value_key_compare(const void* a, const void* b, void* ctx) {\n");
+    emit("    const WynValueKey* key = ctx;\n");
+    emit("    const char* x = (const char*)((const WynValue*)a)->data.struct_val + key->offset;\n");
+    emit("    const char* y = (const char*)((const WynValue*)b)->data.struct_val + key->offset;\n");
+    emit("    if (key->key_type == WYN_SORT_KEY_INT) { int p, q; memcpy(&p, x, sizeof p); memcpy(&q, y, sizeof q); return (p > q) - (p < q); }\n");
+    emit("    if (key->key_type == WYN_SORT_KEY_FLOAT) { double p, q; memcpy(&p, x, sizeof p); memcpy(&q, y, sizeof q); return (p > q) - (p < q); }\n");
+    emit("    const char* p; const char* q; memcpy(&p, x, sizeof p); memcpy(&q, y, sizeof q);\n");
+    emit("    return strcmp(p ? p : \"\", q ? q : \"\");\n");
+    emit("}\n");
+    emit("void array_sort_by_key(WynArray* arr, size_t key_offset, WynSortKeyType key_type) {\n");
+    emit("    WynValueKey key = { key_offset, key_type };\n");
+    emit("    wyn_sort_stable(arr->data, arr->count, sizeof(WynValue), wyn_value_key_compare, &key);\n");
     emit("}\n\n");
     
     // Array first/last - return int directly (0 if empty)
@@ -2527,7 +3783,7 @@ void codegen_c_header() {
     emit("    if (index < 0 || index > arr->count) return;\n");
     emit("    if (arr->count >= arr->capacity) {\n");
     emit("        arr->capacity = arr->capacity == 0 ? 4 : arr->capacity * 2;\n");
-    emit("        arr->data = realloc(arr->data, sizeof(WynValue) * arr->capacity);\n");
+    emit("        arr->data = wyn_pool_realloc(arr->data, sizeof(WynValue) * arr->capacity);\n");
     emit("    }\n");
     emit("    for (int i = arr->count; i > index; i--) {\n");
     emit("        arr->data[i] = arr->data[i-1];\n");
@@ -2543,7 +3799,7 @@ void codegen_c_header() {
     emit("    for (int i = 0; i < count; i++) {\n");
     emit("        if (result.count >= result.capacity) {\n");
     emit("            result.capacity = result.capacity == 0 ? 4 : result.capacity * 2;\n");
-    emit("            result.data = realloc(result.data, sizeof(WynValue) * result.capacity);\n");
+    emit("            result.data = wyn_pool_realloc(result.data, sizeof(WynValue) * result.capacity);\n");
     emit("        }\n");
     emit("        result.data[result.count++] = arr.data[i];\n");
     emit("    }\n");
@@ -2555,7 +3811,7 @@ void codegen_c_header() {
     emit("    for (int i = n; i < arr.count; i++) {\n");
     emit("        if (result.count >= result.capacity) {\n");
     emit("            result.capacity = result.capacity == 0 ? 4 : result.capacity * 2;\n");
-    emit("            result.data = realloc(result.data, sizeof(WynValue) * result.capacity);\n");
+    emit("            result.data = wyn_pool_realloc(result.data, sizeof(WynValue) * result.capacity);\n");
     emit("        }\n");
     emit("        result.data[result.count++] = arr.data[i];\n");
     emit("    }\n");
@@ -2569,7 +3825,7 @@ void codegen_c_header() {
     emit("    for (int i = start; i < end; i++) {\n");
     emit("        if (result.count >= result.capacity) {\n");
     emit("            result.capacity = result.capacity == 0 ? 4 : result.capacity * 2;\n");
-    emit("            result.data = realloc(result.data, sizeof(WynValue) * result.capacity);\n");
+    emit("            result.data = wyn_pool_realloc(result.data, sizeof(WynValue) * result.capacity);\n");
     emit("        }\n");
     emit("        result.data[result.count++] = arr.data[i];\n");
     emit("    }\n");
@@ -2602,14 +3858,14 @@ void codegen_c_header() {
     emit("    for (int i = 0; i < arr1.count; i++) {\n");
     emit("        if (result.count >= result.capacity) {\n");
     emit("            result.capacity = result.capacity == 0 ? 4 : result.capacity * 2;\n");
-    emit("            result.data = realloc(result.data, sizeof(WynValue) * result.capacity);\n");
+    emit("            result.data = wyn_pool_realloc(result.data, sizeof(WynValue) * result.capacity);\n");
     emit("        }\n");
     emit("        result.data[result.count++] = arr1.data[i];\n");
     emit("    }\n");
     emit("    for (int i = 0; i < arr2.count; i++) {\n");
     emit("        if (result.count >= result.capacity) {\n");
     emit("            result.capacity = result.capacity == 0 ? 4 : result.capacity * 2;\n");
-    emit("            result.data = realloc(result.data, sizeof(WynValue) * result.capacity);\n");
+    emit("            result.data = wyn_pool_realloc(result.data, sizeof(WynValue) * result.capacity);\n");
     emit("        }\n");
     emit("        result.data[result.count++] = arr2.data[i];\n");
     emit("    }\n");
@@ -2626,26 +3882,18 @@ void codegen_c_header() {
     emit("int range_next(WynRange* r) { return r->current++; }\n\n");
     
     // String utility functions
-    emit("int string_length(const char* str) { return strlen(str); }\n");
+    emit("int string_length(const char* str) { return (int)wyn_str_len(str); }\n");
     emit("char* string_substring(const char* str, int start, int end) {\n");
-    emit("    int len = end - start;\n");
-    emit("    char* result = malloc(len + 1);\n");
-    emit("    strncpy(result, str + start, len);\n");
-    emit("    result[len] = '\\0';\n");
-    emit("    return result;\n");
+    emit("    return (char*)wyn_str_new(str + start, end - start);\n");
     emit("}\n");
     emit("int string_contains(const char* str, const char* substr) {\n");
     emit("    return strstr(str, substr) != NULL;\n");
     emit("}\n");
     emit("char* string_concat(const char* a, const char* b) {\n");
-    emit("    int len_a = strlen(a), len_b = strlen(b);\n");
-    emit("    char* result = malloc(len_a + len_b + 1);\n");
-    emit("    strcpy(result, a);\n");
-    emit("    strcat(result, b);\n");
-    emit("    return result;\n");
+    emit("    return (char*)wyn_string_concat_safe(a, b);\n");
     emit("}\n");
     emit("char* string_upper(const char* str) {\n");
-    emit("    int len = strlen(str);\n");
+    emit("    int len = (int)wyn_str_len(str);\n");
     emit("    char* result = malloc(len + 1);\n");
     emit("    for (int i = 0; i < len; i++) {\n");
     emit("        result[i] = toupper(str[i]);\n");
@@ -2654,7 +3902,7 @@ void codegen_c_header() {
     emit("    return result;\n");
     emit("}\n");
     emit("char* string_lower(const char* str) {\n");
-    emit("    int len = strlen(str);\n");
+    emit("    int len = (int)wyn_str_len(str);\n");
     emit("    char* result = malloc(len + 1);\n");
     emit("    for (int i = 0; i < len; i++) {\n");
     emit("        result[i] = tolower(str[i]);\n");
@@ -2696,7 +3944,7 @@ void codegen_c_header() {
     emit("}\n");
     
     emit("const char* string_char_at(const char* str, int index) {\n");
-    emit("    int len = strlen(str);\n");
+    emit("    int len = (int)wyn_str_len(str);\n");
     emit("    if (index < 0 || index >= len) return \"\";\n");
     emit("    char* result = malloc(2);\n");
     emit("    result[0] = str[index];\n");
@@ -2739,7 +3987,7 @@ void codegen_c_header() {
     
     // Phase 2 Task 2.1: Additional string methods
     emit("char* string_capitalize(const char* str) {\n");
-    emit("    int len = strlen(str);\n");
+    emit("    int len = (int)wyn_str_len(str);\n");
     emit("    char* result = malloc(len + 1);\n");
     emit("    if (len > 0) result[0] = toupper(str[0]);\n");
     emit("    for (int i = 1; i < len; i++) result[i] = tolower(str[i]);\n");
@@ -2748,14 +3996,14 @@ void codegen_c_header() {
     emit("}\n");
     
     emit("char* string_reverse(const char* str) {\n");
-    emit("    int len = strlen(str);\n");
+    emit("    int len = (int)wyn_str_len(str);\n");
     emit("    char* result = malloc(len + 1);\n");
     emit("    for (int i = 0; i < len; i++) result[i] = str[len - 1 - i];\n");
     emit("    result[len] = '\\0';\n");
     emit("    return result;\n");
     emit("}\n");
     
-    emit("int string_len(const char* str) { return strlen(str); }\n");
+    emit("int string_len(const char* str) { return (int)wyn_str_len(str); }\n");
     emit("int string_is_empty(const char* str) { return str[0] == '\\0'; }\n");
     
     emit("int string_starts_with(const char* str, const char* prefix) {\n");
@@ -2811,19 +4059,15 @@ void codegen_c_header() {
     emit("}\n");
     
     emit("char* string_slice(const char* str, int start, int end) {\n");
-    emit("    int len = strlen(str);\n");
+    emit("    int len = (int)wyn_str_len(str);\n");
     emit("    if (start < 0) start = 0;\n");
     emit("    if (end > len) end = len;\n");
     emit("    if (start >= end) return strdup(\"\");\n");
-    emit("    int slice_len = end - start;\n");
-    emit("    char* result = malloc(slice_len + 1);\n");
-    emit("    memcpy(result, str + start, slice_len);\n");
-    emit("    result[slice_len] = '\\0';\n");
-    emit("    return result;\n");
+    emit("    return (char*)wyn_str_new(str + start, end - start);\n");
     emit("}\n");
     
     emit("char* string_repeat(const char* str, int count) {\n");
-    emit("    int len = strlen(str);\n");
+    emit("    int len = (int)wyn_str_len(str);\n");
     emit("    char* result = malloc(len * count + 1);\n");
     emit("    for (int i = 0; i < count; i++) memcpy(result + i * len, str, len);\n");
     emit("    result[len * count] = '\\0';\n");
@@ -2831,7 +4075,7 @@ void codegen_c_header() {
     emit("}\n");
     
     emit("char* string_title(const char* str) {\n");
-    emit("    int len = strlen(str);\n");
+    emit("    int len = (int)wyn_str_len(str);\n");
     emit("    char* result = malloc(len + 1);\n");
     emit("    int capitalize_next = 1;\n");
     emit("    for (int i = 0; i < len; i++) {\n");
@@ -2855,7 +4099,7 @@ void codegen_c_header() {
     emit("}\n");
     
     emit("char* string_trim_right(const char* str) {\n");
-    emit("    int len = strlen(str);\n");
+    emit("    int len = (int)wyn_str_len(str);\n");
     emit("    while (len > 0 && (str[len-1] == ' ' || str[len-1] == '\\t' || str[len-1] == '\\n')) len--;\n");
     emit("    char* result = malloc(len + 1);\n");
     emit("    memcpy(result, str, len);\n");
@@ -2865,7 +4109,7 @@ void codegen_c_header() {
     
     emit("char* string_trim(const char* str) {\n");
     emit("    while (*str == ' ' || *str == '\\t' || *str == '\\n') str++;\n");
-    emit("    int len = strlen(str);\n");
+    emit("    int len = (int)wyn_str_len(str);\n");
     emit("    while (len > 0 && (str[len-1] == ' ' || str[len-1] == '\\t' || str[len-1] == '\\n')) len--;\n");
     emit("    char* result = malloc(len + 1);\n");
     emit("    memcpy(result, str, len);\n");
@@ -2886,7 +4130,7 @@ void codegen_c_header() {
     emit("}\n");
     
     emit("const char* wyn_string_charat(const char* str, int index) {\n");
-    emit("    int len = strlen(str);\n");
+    emit("    int len = (int)wyn_str_len(str);\n");
     emit("    if (index < 0 || index >= len) return \"\";\n");
     emit("    char* result = malloc(2);\n");
     emit("    result[0] = str[index];\n");
@@ -2914,7 +4158,7 @@ void codegen_c_header() {
     emit("}\n");
     
     emit("char* string_pad_left(const char* str, int width, const char* pad) {\n");
-    emit("    int len = strlen(str);\n");
+    emit("    int len = (int)wyn_str_len(str);\n");
     emit("    if (len >= width) return strdup(str);\n");
     emit("    int pad_len = width - len;\n");
     emit("    char* result = malloc(width + 1);\n");
@@ -2924,7 +4168,7 @@ void codegen_c_header() {
     emit("}\n");
     
     emit("char* string_pad_right(const char* str, int width, const char* pad) {\n");
-    emit("    int len = strlen(str);\n");
+    emit("    int len = (int)wyn_str_len(str);\n");
     emit("    if (len >= width) return strdup(str);\n");
     emit("    int pad_len = width - len;\n");
     emit("    char* result = malloc(width + 1);\n");
@@ -3103,35 +4347,20 @@ void codegen_c_header() {
     emit("}\n");
     
     emit("void map_merge(WynHashMap* dest, WynHashMap* src) {\n");
-    emit("    // Merge src into dest by iterating all buckets\n");
-    emit("    for (int i = 0; i < 128; i++) {\n");
-    emit("        void* entry = ((void**)src)[i];\n");
-    emit("        while (entry) {\n");
-    emit("            char* key = *(char**)entry;\n");
-    emit("            int value = *((int*)((char*)entry + sizeof(char*)));\n");
-    emit("            hashmap_insert_int(dest, key, value);\n");
-    emit("            entry = *((void**)((char*)entry + sizeof(char*) + sizeof(int)));\n");
-    emit("        }\n");
+    emit("    size_t iter = 0;\n");
+    emit("    HashMapEntry entry;\n");
+    emit("    while (hashmap_next(src, &iter, &entry)) {\n");
+    emit("        if (entry.key) hashmap_insert_value(dest, entry.key, entry.value);\n");
+    emit("        else hashmap_insert_value_int_key(dest, entry.int_key, entry.value);\n");
     emit("    }\n");
     emit("}\n");
     
     emit("int map_len(WynHashMap* map) {\n");
-    emit("    int count = 0;\n");
-    emit("    for (int i = 0; i < 128; i++) {\n");
-    emit("        void* entry = ((void**)map)[i];\n");
-    emit("        while (entry) {\n");
-    emit("            count++;\n");
-    emit("            entry = *((void**)((char*)entry + sizeof(char*) + sizeof(int)));\n");
-    emit("        }\n");
-    emit("    }\n");
-    emit("    return count;\n");
+    emit("    return hashmap_len(map);\n");
     emit("}\n");
     
     emit("bool map_is_empty(WynHashMap* map) {\n");
-    emit("    for (int i = 0; i < 128; i++) {\n");
-    emit("        if (((void**)map)[i] != NULL) return false;\n");
-    emit("    }\n");
-    emit("    return true;\n");
+    emit("    return hashmap_len(map) == 0;\n");
     emit("}\n");
     
     emit("bool map_has(WynHashMap* map, const char* key) {\n");
@@ -3152,155 +4381,18 @@ void codegen_c_header() {
     emit("char http_last_error[256] = {0};\n");
     emit("char last_error[256] = {0};\n\n");
     
-    // Enhanced HTTP client with chunked transfer, redirects, and large responses
+    // HTTP client: pooled keep-alive connections, chunked and sized bodies
+    emit("char* wyn_http_fetch(const char* method, const char* url, const char* headers, const char* body, int* status_out, char* error, size_t error_len);\n");
     emit("char* http_request(const char* method, const char* url, const char* body) {\n");
-    emit("    char hostname[256], path[1024];\n");
-    emit("    int port = 80, is_https = 0;\n");
-    emit("    http_last_error[0] = 0;\n");
-    emit("    \n");
-    emit("    // Parse URL\n");
-    emit("    if(strncmp(url, \"https://\", 8) == 0) { url += 8; port = 443; is_https = 1; }\n");
-    emit("    else if(strncmp(url, \"http://\", 7) == 0) url += 7;\n");
-    emit("    \n");
-    emit("    const char* slash = strchr(url, '/');\n");
-    emit("    if(slash) {\n");
-    emit("        int len = slash - url;\n");
-    emit("        if(len >= 256) len = 255;\n");
-    emit("        strncpy(hostname, url, len);\n");
-    emit("        hostname[len] = 0;\n");
-    emit("        strncpy(path, slash, 1023);\n");
-    emit("        path[1023] = 0;\n");
-    emit("    } else {\n");
-    emit("        strncpy(hostname, url, 255);\n");
-    emit("        hostname[255] = 0;\n");
-    emit("        strcpy(path, \"/\");\n");
-    emit("    }\n");
-    emit("    \n");
-    emit("    // Check for port\n");
-    emit("    char* colon = strchr(hostname, ':');\n");
-    emit("    if(colon) { *colon = 0; port = atoi(colon + 1); }\n");
-    emit("    \n");
-    emit("    // Create socket\n");
-    emit("    int sock = socket(AF_INET, SOCK_STREAM, 0);\n");
-    emit("    if(sock < 0) { snprintf(http_last_error, 256, \"Socket creation failed\"); return NULL; }\n");
-    emit("    \n");
-    emit("    // Set timeout\n");
-    emit("    struct timeval tv = {30, 0};\n");
-    emit("    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));\n");
-    emit("    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));\n");
-    emit("    \n");
-    emit("    // Resolve hostname\n");
-    emit("    struct hostent* server = gethostbyname(hostname);\n");
-    emit("    if(!server) { close(sock); snprintf(http_last_error, 256, \"Host not found: %%s\", hostname); return NULL; }\n");
-    emit("    \n");
-    emit("    // Connect\n");
-    emit("    struct sockaddr_in addr;\n");
-    emit("    memset(&addr, 0, sizeof(addr));\n");
-    emit("    addr.sin_family = AF_INET;\n");
-    emit("    memcpy(&addr.sin_addr.s_addr, server->h_addr_list[0], server->h_length);\n");
-    emit("    addr.sin_port = htons(port);\n");
-    emit("    \n");
-    emit("    if(connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {\n");
-    emit("        close(sock); snprintf(http_last_error, 256, \"Connection failed\"); return NULL;\n");
-    emit("    }\n");
-    emit("    \n");
-    emit("    // HTTPS warning (TLS not implemented yet)\n");
-    emit("    if(is_https) {\n");
-    emit("        close(sock);\n");
-    emit("        snprintf(http_last_error, 256, \"HTTPS not supported yet - use http:// instead\");\n");
-    emit("        return NULL;\n");
-    emit("    }\n");
-    emit("    \n");
-    emit("    // Build request\n");
-    emit("    char* request = malloc(8192);\n");
-    emit("    int len = snprintf(request, 8192, \"%%s %%s HTTP/1.1\\r\\nHost: %%s\\r\\n\", method, path, hostname);\n");
-    emit("    len += snprintf(request + len, 8192 - len, \"User-Agent: Wyn/1.4\\r\\n\");\n");
-    emit("    len += snprintf(request + len, 8192 - len, \"Accept: */*\\r\\n\");\n");
-    emit("    \n");
-    emit("    // Add custom headers\n");
+    emit("    char headers[32 * 514 + 64];\n");
+    emit("    int len = 0;\n");
+    emit("    headers[0] = 0;\n");
     emit("    for(int i = 0; i < http_header_count; i++) {\n");
-    emit("        len += snprintf(request + len, 8192 - len, \"%%s\\r\\n\", http_headers[i]);\n");
-    emit("    }\n");
-    emit("    \n");
-    emit("    // Add body\n");
-    emit("    if(body) {\n");
-    emit("        len += snprintf(request + len, 8192 - len, \"Content-Length: %%d\\r\\n\", (int)strlen(body));\n");
-    emit("        len += snprintf(request + len, 8192 - len, \"Content-Type: application/x-www-form-urlencoded\\r\\n\");\n");
-    emit("    }\n");
-    emit("    \n");
-    emit("    len += snprintf(request + len, 8192 - len, \"Connection: close\\r\\n\\r\\n\");\n");
-    emit("    if(body) len += snprintf(request + len, 8192 - len, \"%%s\", body);\n");
-    emit("    \n");
-    emit("    // Send\n");
-    emit("    if(send(sock, request, len, 0) < 0) {\n");
-    emit("        free(request); close(sock);\n");
-    emit("        snprintf(http_last_error, 256, \"Send failed\");\n");
-    emit("        return NULL;\n");
-    emit("    }\n");
-    emit("    free(request);\n");
-    emit("    \n");
-    emit("    // Read response with dynamic allocation\n");
-    emit("    size_t capacity = 65536, total = 0;\n");
-    emit("    char* response = malloc(capacity);\n");
-    emit("    int n;\n");
-    emit("    while((n = recv(sock, response + total, capacity - total - 1, 0)) > 0) {\n");
-    emit("        total += n;\n");
-    emit("        if(total >= capacity - 1024) {\n");
-    emit("            capacity *= 2;\n");
-    emit("            char* new_resp = realloc(response, capacity);\n");
-    emit("            if(!new_resp) { free(response); close(sock); return NULL; }\n");
-    emit("            response = new_resp;\n");
-    emit("        }\n");
-    emit("    }\n");
-    emit("    response[total] = 0;\n");
-    emit("    close(sock);\n");
-    emit("    \n");
-    emit("    if(total == 0) {\n");
-    emit("        free(response);\n");
-    emit("        snprintf(http_last_error, 256, \"Empty response\");\n");
-    emit("        return NULL;\n");
-    emit("    }\n");
-    emit("    \n");
-    emit("    // Parse status\n");
-    emit("    http_last_status = 0;\n");
-    emit("    if(strncmp(response, \"HTTP/\", 5) == 0) {\n");
-    emit("        char* space = strchr(response, ' ');\n");
-    emit("        if(space) http_last_status = atoi(space + 1);\n");
-    emit("    }\n");
-    emit("    \n");
-    emit("    // Find body\n");
-    emit("    char* body_start = strstr(response, \"\\r\\n\\r\\n\");\n");
-    emit("    if(body_start) {\n");
-    emit("        body_start += 4;\n");
-    emit("        \n");
-    emit("        // Handle chunked transfer encoding\n");
-    emit("        if(strstr(response, \"Transfer-Encoding: chunked\") || strstr(response, \"transfer-encoding: chunked\")) {\n");
-    emit("            char* result = malloc(capacity);\n");
-    emit("            char* dst = result;\n");
-    emit("            char* src = body_start;\n");
-    emit("            while(*src) {\n");
-    emit("                int chunk_size;\n");
-    emit("                if(sscanf(src, \"%%x\", &chunk_size) != 1) break;\n");
-    emit("                if(chunk_size == 0) break;\n");
-    emit("                src = strchr(src, '\\n');\n");
-    emit("                if(!src) break;\n");
-    emit("                src++;\n");
-    emit("                memcpy(dst, src, chunk_size);\n");
-    emit("                dst += chunk_size;\n");
-    emit("                src += chunk_size + 2;\n");
-    emit("            }\n");
-    emit("            *dst = 0;\n");
-    emit("            free(response);\n");
-    emit("            return result;\n");
-    emit("        }\n");
-    emit("        \n");
-    emit("        char* result = malloc(strlen(body_start) + 1);\n");
-    emit("        strcpy(result, body_start);\n");
-    emit("        free(response);\n");
-    emit("        return result;\n");
+    emit("        len += snprintf(headers + len, sizeof(headers) - len, \"%%s\\r\\n\", http_headers[i]);\n");
     emit("    }\n");
-    emit("    \n");
-    emit("    return response;\n");
+    emit("    if(body) snprintf(headers + len, sizeof(headers) - len, \"Content-Type: application/x-www-form-urlencoded\\r\\n\");\n");
+    emit("    http_last_error[0] = 0;\n");
+    emit("    return wyn_http_fetch(method, url, headers, body, &http_last_status, http_last_error, sizeof(http_last_error));\n");
     emit("}\n\n");
     
     // Simple HTTPS support (basic TLS wrapper)
@@ -3397,7 +4489,7 @@ void codegen_c_header() {
     
     emit("char* base64_encode(const char* str) {\n");
     emit("    static const char* b64 = \"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/\";\n");
-    emit("    int len = strlen(str);\n");
+    emit("    int len = (int)wyn_str_len(str);\n");
     emit("    char* out = malloc(((len + 2) / 3) * 4 + 1);\n");
     emit("    int i = 0, j = 0;\n");
     emit("    while(i < len) {\n");
@@ -3491,9 +4583,9 @@ void codegen_c_header() {
     emit("double cos_approx(double x) { return 1 - (x*x)/2 + (x*x*x*x)/24; }\n");
     emit("double pi_const() { return 3.14159265359; }\n");
     emit("double e_const() { return 2.71828182846; }\n");
-    emit("int str_len(const char* s) { return strlen(s); }\n");
+    emit("int str_len(const char* s) { return (int)wyn_str_len(s); }\n");
     emit("int str_eq(const char* a, const char* b) { return strcmp(a, b) == 0; }\n");
-    emit("char* str_concat(const char* a, const char* b) { char* r = malloc(strlen(a) + strlen(b) + 1); strcpy(r, a); strcat(r, b); return r; }\n");
+    emit("char* str_concat(const char* a, const char* b) { return (char*)wyn_string_concat_safe(a, b); }\n");
     emit("char* str_upper(const char* s) { char* r = malloc(strlen(s) + 1); for(int i = 0; s[i]; i++) r[i] = toupper(s[i]); r[strlen(s)] = 0; return r; }\n");
     emit("char* str_lower(const char* s) { char* r = malloc(strlen(s) + 1); for(int i = 0; s[i]; i++) r[i] = tolower(s[i]); r[strlen(s)] = 0; return r; }\n");
     emit("int str_contains(const char* s, const char* sub) { return strstr(s, sub) != NULL; }\n");
@@ -3525,7 +4617,7 @@ void codegen_c_header() {
     emit("WynError ValueError(const char* msg) { WynError e = {msg, \"ValueError\"}; return e; }\n");
     emit("WynError DivisionByZeroError(const char* msg) { WynError e = {msg, \"DivisionByZeroError\"}; return e; }\n");
     // print_error function provided by error.c
-    emit("char* str_substring(const char* s, int start, int end) { int len = strlen(s); if(start < 0) start = 0; if(end > len) end = len; if(start >= end) return malloc(1); int sublen = end - start; char* r = malloc(sublen + 1); strncpy(r, s + start, sublen); r[sublen] = 0; return r; }\n");
+    emit("char* str_substring(const char* s, int start, int end) { int len = (int)wyn_str_len(s); if(start < 0) start = 0; if(end > len) end = len; if(start >= end) return (char*)wyn_str_new(\"\", 0); return (char*)wyn_str_new(s + start, end - start); }\n");
     emit("int str_index_of(const char* s, const char* sub) { char* p = strstr(s, sub); return p ? (int)(p - s) : -1; }\n");
     emit("char* str_slice(const char* s, int start, int end) { return str_substring(s, start, end); }\n");
     emit("char* str_pad_start(const char* s, int len, const char* pad) { int slen = strlen(s); if(slen >= len) { char* r = malloc(slen + 1); strcpy(r, s); return r; } int padlen = len - slen; char* r = malloc(len + 1); for(int i = 0; i < padlen; i++) r[i] = pad[0]; strcpy(r + padlen, s); return r; }\n");
@@ -3536,7 +4628,7 @@ void codegen_c_header() {
     emit("char* str_center(const char* s, int width) { int len = strlen(s); if(len >= width) { char* r = malloc(len + 1); strcpy(r, s); return r; } int pad = (width - len) / 2; char* r = malloc(width + 1); for(int i = 0; i < pad; i++) r[i] = ' '; strcpy(r + pad, s); for(int i = pad + len; i < width; i++) r[i] = ' '; r[width] = 0; return r; }\n");
     emit("char** str_lines(const char* s) { char** lines = malloc(sizeof(char*)); lines[0] = malloc(strlen(s) + 1); strcpy(lines[0], s); return lines; }\n");
     emit("char** str_words(const char* s) { char** words = malloc(sizeof(char*)); words[0] = malloc(strlen(s) + 1); strcpy(words[0], s); return words; }\n");
-    emit("void str_free(char* s) { if(s) free(s); }\n");
+    emit("void str_free(char* s) { wyn_str_free(s); }\n");
     emit("int str_parse_int(const char* s) { return atoi(s); }\n");
     emit("double str_parse_float(const char* s) { return atof(s); }\n");
     emit("int abs_val(int x) { return x < 0 ? -x : x; }\n");
@@ -3827,7 +4919,7 @@ void codegen_c_header() {
     
     emit("WynArray System_args() {\n");
     emit("    WynArray arr;\n");
-    emit("    arr.data = malloc(__wyn_argc * sizeof(WynValue));\n");
+    emit("    arr.data = wyn_pool_alloc(__wyn_argc * sizeof(WynValue));\n");
     emit("    arr.count = __wyn_argc;\n");
     emit("    arr.capacity = __wyn_argc;\n");
     emit("    for (int i = 0; i < __wyn_argc; i++) {\n");
@@ -3858,7 +4950,7 @@ void codegen_c_header() {
     emit("    WynArray arr;\n");
     emit("    int count = 0;\n");
     emit("    for (char** env = environ; *env; env++) count++;\n");
-    emit("    arr.data = malloc(count * sizeof(WynValue));\n");
+    emit("    arr.data = wyn_pool_alloc(count * sizeof(WynValue));\n");
     emit("    arr.count = count;\n");
     emit("    arr.capacity = count;\n");
     emit("    for (int i = 0; i < count; i++) {\n");
@@ -3872,7 +4964,7 @@ void codegen_c_header() {
     emit("typedef struct { WynArray arr; } Queue;\n\n");
     
     emit("Queue* Queue_new() {\n");
-    emit("    Queue* q = malloc(sizeof(Queue));\n");
+    emit("    Queue* q = wyn_pool_alloc(sizeof(Queue));\n");
     emit("    q->arr.data = NULL;\n");
     emit("    q->arr.count = 0;\n");
     emit("    q->arr.capacity = 0;\n");
@@ -3882,7 +4974,7 @@ void codegen_c_header() {
     emit("void Queue_push(Queue* q, int value) {\n");
     emit("    if (q->arr.count >= q->arr.capacity) {\n");
     emit("        q->arr.capacity = q->arr.capacity == 0 ? 4 : q->arr.capacity * 2;\n");
-    emit("        q->arr.data = realloc(q->arr.data, sizeof(WynValue) * q->arr.capacity);\n");
+    emit("        q->arr.data = wyn_pool_realloc(q->arr.data, sizeof(WynValue) * q->arr.capacity);\n");
     emit("    }\n");
     emit("    q->arr.data[q->arr.count].type = WYN_TYPE_INT;\n");
     emit("    q->arr.data[q->arr.count].data.int_val = value;\n");
@@ -3916,7 +5008,7 @@ void codegen_c_header() {
     emit("typedef struct { WynArray arr; } Stack;\n\n");
     
     emit("Stack* Stack_new() {\n");
-    emit("    Stack* s = malloc(sizeof(Stack));\n");
+    emit("    Stack* s = wyn_pool_alloc(sizeof(Stack));\n");
     emit("    s->arr.data = NULL;\n");
     emit("    s->arr.count = 0;\n");
     emit("    s->arr.capacity = 0;\n");
@@ -3926,7 +5018,7 @@ void codegen_c_header() {
     emit("void Stack_push(Stack* s, int value) {\n");
     emit("    if (s->arr.count >= s->arr.capacity) {\n");
     emit("        s->arr.capacity = s->arr.capacity == 0 ? 4 : s->arr.capacity * 2;\n");
-    emit("        s->arr.data = realloc(s->arr.data, sizeof(WynValue) * s->arr.capacity);\n");
+    emit("        s->arr.data = wyn_pool_realloc(s->arr.data, sizeof(WynValue) * s->arr.capacity);\n");
     emit("    }\n");
     emit("    s->arr.data[s->arr.count].type = WYN_TYPE_INT;\n");
     emit("    s->arr.data[s->arr.count].data.int_val = value;\n");
@@ -4000,19 +5092,13 @@ void codegen_c_header() {
     emit("    return sent;\n");
     emit("}\n\n");
     
+    // Reads share the Socket_read_* buffer so they can be mixed with them
     emit("char* Net_recv(int sockfd) {\n");
-    emit("    char* buffer = malloc(4096);\n");
-    emit("    int received = recv(sockfd, buffer, 4095, 0);\n");
-    emit("    if (received < 0) {\n");
-    emit("        free(buffer);\n");
-    emit("        return \"\";\n");
-    emit("    }\n");
-    emit("    buffer[received] = '\\0';\n");
-    emit("    return buffer;\n");
+    emit("    return Socket_read(sockfd, 4095);\n");
     emit("}\n\n");
     
     emit("int Net_close(int sockfd) {\n");
-    emit("    return close(sockfd) == 0 ? 1 : 0;\n");
+    emit("    return Socket_close(sockfd) == 0 ? 1 : 0;\n");
     emit("}\n\n");
     
     // Time and Crypto functions are in stdlib_runtime.c
@@ -4031,7 +5117,7 @@ void codegen_c_header() {
     emit("int arr_contains(WynArray arr, int len, int val) { for(int i = 0; i < len; i++) if(array_get_int(arr, i) == val) return 1; return 0; }\n");
     emit("int arr_find(WynArray arr, int len, int val) { for(int i = 0; i < len; i++) if(array_get_int(arr, i) == val) return i; return -1; }\n");
     emit("void arr_reverse(int* arr, int len) { for(int i = 0; i < len/2; i++) { int t = arr[i]; arr[i] = arr[len-1-i]; arr[len-1-i] = t; } }\n");
-    emit("void arr_sort(int* arr, int len) { for(int i = 0; i < len-1; i++) for(int j = 0; j < len-i-1; j++) if(arr[j] > arr[j+1]) { int t = arr[j]; arr[j] = arr[j+1]; arr[j+1] = t; } }\n");
+    emit("void arr_sort(int* arr, int len) { if (len > 1) wyn_sort_int(arr, len); }\n");
     emit("int arr_count(int* arr, int len, int val) { int c = 0; for(int i = 0; i < len; i++) if(arr[i] == val) c++; return c; }\n");
     emit("void arr_fill(int* arr, int len, int val) { for(int i = 0; i < len; i++) arr[i] = val; }\n");
     emit("int arr_all(int* arr, int len, int val) { for(int i = 0; i < len; i++) if(arr[i] != val) return 0; return 1; }\n");
@@ -4142,9 +5228,7 @@ static void emit_function_with_prefix(Stmt* fn_stmt, const char* prefix) {
     clear_parameters();
     clear_local_variables();
     for (int i = 0; i < fn_stmt->fn.param_count; i++) {
-        char param_name[256];
-        snprintf(param_name, 256, "%.*s", fn_stmt->fn.params[i].length, fn_stmt->fn.params[i].start);
-        register_parameter(param_name);
+        register_parameter(fn_stmt->fn.params[i]);
     }
     
     // Emit function signature with module prefix
@@ -4171,6 +5255,8 @@ static void emit_function_with_prefix(Stmt* fn_stmt, const char* prefix) {
                 return_type = "WynHashMap*";
             } else if (rt.length == 7 && memcmp(rt.start, "HashSet", 7) == 0) {
                 return_type = "WynHashSet*";
+            } else if (rt.length == 13 && memcmp(rt.start, "StringBuilder", 13) == 0) {
+                return_type = "WynStringBuilder*";
             } else {
                 // Custom struct type - add module prefix if in module context
                 if (current_module_prefix) {
@@ -4211,6 +5297,8 @@ static void emit_function_with_prefix(Stmt* fn_stmt, const char* prefix) {
                     c_type = "WynHashMap*";
                 } else if (type_token.length == 7 && memcmp(type_token.start, "HashSet", 7) == 0) {
                     c_type = "WynHashSet*";
+                } else if (type_token.length == 13 && memcmp(type_token.start, "StringBuilder", 13) == 0) {
+                    c_type = "WynStringBuilder*";
                 } else {
                     // Custom struct type - add module prefix if in module context
                     if (current_module_prefix) {
@@ -4261,6 +5349,29 @@ void codegen_stmt(Stmt* stmt) {
             emit(";\n");
             break;
         case STMT_VAR: {
+            Type* init_type = stmt->var.init ? stmt->var.init->expr_type : NULL;
+            if (init_type && init_type->kind == TYPE_SPAWN) {
+                // Released when the variable goes out of scope, on every path out
+                Token fn_name = init_type->spawn_type.fn_name;
+                emit("__attribute__((cleanup(__spawn_drop_%.*s))) __auto_type %.*s = ",
+                     fn_name.length, fn_name.start, stmt->var.name.length, stmt->var.name.start);
+                if (current_module_prefix) register_local_variable(stmt->var.name);
+                emit_spawn_owned(stmt->var.init);
+                emit(";\n");
+                break;
+            }
+            DenseArray* dense = find_dense_array(stmt->var.name);
+            if (dense && !dense->rejected) {
+                // Unboxed storage; elements are appended in place
+                emit("WynDenseArray(%s) %s = {0};\n", dense_elem_c_type(dense), dense->name);
+                for (int i = 0; i < stmt->var.init->array.count; i++) {
+                    emit("    wyn_dense_push(%s, ", dense->name);
+                    codegen_expr(stmt->var.init->array.elements[i]);
+                    emit(");\n");
+                }
+                break;
+            }
+            
             // Determine C type based on explicit type annotation or initializer
             const char* c_type = "int";
             bool is_already_const = false;  // Track if type already has const
@@ -4303,6 +5414,8 @@ void codegen_stmt(Stmt* stmt) {
                         c_type = "double";
                     } else if (type_name.length == 4 && memcmp(type_name.start, "bool", 4) == 0) {
                         c_type = "bool";
+                    } else if (type_name.length == 13 && memcmp(type_name.start, "StringBuilder", 13) == 0) {
+                        c_type = "WynStringBuilder*";
                     } else {
                         // Custom struct/enum type - use the type name as-is
                         static char custom_type_buf[256];
@@ -4318,7 +5431,8 @@ void codegen_stmt(Stmt* stmt) {
                     c_type = "const char*";
                     is_already_const = true;  // String literals already have const
                 } else if (stmt->var.init->type == EXPR_STRING_INTERP) {
-                    c_type = "char*";
+                    c_type = "const char*";
+                    is_already_const = true;
                     needs_arc_management = true;
                 } else if (stmt->var.init->type == EXPR_FLOAT) {
                     c_type = "double";
@@ -4589,7 +5703,6 @@ void codegen_stmt(Stmt* stmt) {
                 int lambda_idx = -1;
                 for (int i = 0; i < lambda_count; i++) {
                     // Match by checking if this is the right lambda (use counter)
-                    static int lambda_var_counter = 0;
                     if (i == lambda_var_counter) {
                         total_params += lambda_functions[i].capture_count;
                         lambda_idx = i;
@@ -4624,18 +5737,12 @@ void codegen_stmt(Stmt* stmt) {
             
             // Register local variable for scope tracking (if inside a function)
             if (current_module_prefix) {
-                char var_name[256];
-                snprintf(var_name, 256, "%.*s", stmt->var.name.length, stmt->var.name.start);
-                register_local_variable(var_name);
+                register_local_variable(stmt->var.name);
             }
             
-            if (needs_arc_management) {
-                emit("({ ");
-                codegen_expr(stmt->var.init);
-                emit("; /* ARC retain for %.*s */ })", stmt->var.name.length, stmt->var.name.start);
-            } else {
-                codegen_expr(stmt->var.init);
-            }
+            // The initializer hands over a fresh reference, so the local takes
+            // it by move: no retain here
+            codegen_expr(stmt->var.init);
             emit(";\n");
             
             // Track ARC-managed variables for automatic cleanup
@@ -4664,21 +5771,17 @@ void codegen_stmt(Stmt* stmt) {
         case STMT_SPAWN: {
             // Spawn: lightweight tasks (not OS threads)
             // Wrapper functions are generated in pre-scan phase
-            if (stmt->spawn.call->type == EXPR_CALL && 
-                stmt->spawn.call->call.callee->type == EXPR_IDENT &&
-                stmt->spawn.call->call.arg_count == 0) {
-                
-                // Extract function name
-                Expr* callee = stmt->spawn.call->call.callee;
-                char func_name[256];
-                int len = callee->token.length < 255 ? callee->token.length : 255;
-                memcpy(func_name, callee->token.start, len);
-                func_name[len] = '\0';
-                
-                // Generate spawn call
-                emit("wyn_spawn(__spawn_wrapper_");
-                emit(func_name);
-                emit(", NULL);\n");
+            SpawnWrapper* wrapper = find_spawn_wrapper(stmt->spawn.call);
+            if (wrapper && wrapper->fn) {
+                // Fire and forget: drop the owner's reference right away
+                emit("wyn_spawn_release(&__spawn_start_%s(", wrapper->func_name);
+                for (int i = 0; i < stmt->spawn.call->call.arg_count; i++) {
+                    if (i > 0) emit(", ");
+                    emit_spawn_arg(stmt->spawn.call->call.args[i]);
+                }
+                emit(")->handle);\n");
+            } else if (wrapper) {
+                emit("wyn_spawn(__spawn_wrapper_%s, NULL);\n", wrapper->func_name);
             } else {
                 // Fallback: just call the function
                 emit("/* spawn (fallback) */ ");
@@ -4687,6 +5790,18 @@ void codegen_stmt(Stmt* stmt) {
             }
             break;
         }
+        case STMT_SCOPE: {
+            // The cleanup attribute waits for the scope's spawns on every
+            // exit from the block, including return and break
+            int id = ++spawn_scope_counter;
+            emit("{\n");
+            emit("    __attribute__((cleanup(wyn_scope_leave))) WynSpawnScope __scope_%d;\n", id);
+            emit("    wyn_scope_enter(&__scope_%d);\n", id);
+            emit("    ");
+            codegen_stmt(stmt->scope.body);
+            emit("}\n");
+            break;
+        }
         case STMT_BLOCK:
             for (int i = 0; i < stmt->block.count; i++) {
                 emit("    ");
@@ -4742,6 +5857,8 @@ void codegen_stmt(Stmt* stmt) {
                         return_type = "WynHashMap*";
                     } else if (type_name.length == 7 && memcmp(type_name.start, "HashSet", 7) == 0) {
                         return_type = "WynHashSet*";
+                    } else if (type_name.length == 13 && memcmp(type_name.start, "StringBuilder", 13) == 0) {
+                        return_type = "WynStringBuilder*";
                     } else {
                         // Assume it's a custom struct type
                         snprintf(return_type_buf, sizeof(return_type_buf), "%.*s", 
@@ -4839,6 +5956,8 @@ void codegen_stmt(Stmt* stmt) {
                             param_type = "WynHashMap*";
                         } else if (type_name.length == 7 && memcmp(type_name.start, "HashSet", 7) == 0) {
                             param_type = "WynHashSet*";
+                        } else if (type_name.length == 13 && memcmp(type_name.start, "StringBuilder", 13) == 0) {
+                            param_type = "WynStringBuilder*";
                         } else {
                             // Assume it's a custom struct type
                             snprintf(custom_type_buf, sizeof(custom_type_buf), "%.*s", 
@@ -4858,8 +5977,11 @@ void codegen_stmt(Stmt* stmt) {
             }
             emit(") {\n");
             push_scope();  // Track allocations in this function
+            analyze_dense_arrays(stmt->fn.body);
+            analyze_append_locals(stmt->fn.body);
             
-            // For async functions, wrap the body in a future
+            // For async functions, run the body to completion on the caller's
+            // thread and return it as an already completed future
             if (is_async) {
                 emit("    WynFuture* future = wyn_future_new();\n");
                 emit("    %s* temp = malloc(sizeof(%s));\n", return_type, return_type);
@@ -4876,6 +5998,8 @@ void codegen_stmt(Stmt* stmt) {
             } else {
                 codegen_stmt(stmt->fn.body);
             }
+            dense_array_count = 0;
+            append_local_count = 0;
             
             pop_scope();   // Auto-cleanup before function end
             emit("}\n\n");
@@ -4947,7 +6071,7 @@ void codegen_stmt(Stmt* stmt) {
                         if (type_name.length == 3 && memcmp(type_name.start, "int", 3) == 0) {
                             c_type = "int";
                         } else if (type_name.length == 5 && memcmp(type_name.start, "float", 5) == 0) {
-                            c_type = "float";
+                            c_type = "double";
                         } else if (type_name.length == 6 && memcmp(type_name.start, "string", 6) == 0) {
                             c_type = "const char*"; // Always use simple strings for now
                         } else if (type_name.length == 3 && memcmp(type_name.start, "str", 3) == 0) {
@@ -5451,7 +6575,19 @@ void codegen_stmt(Stmt* stmt) {
             break;
         case STMT_FOR:
             // Check if this is a for-in loop (array iteration)
-            if (stmt->for_stmt.array_expr) {
+            if (stmt->for_stmt.array_expr && dense_array_for(stmt->for_stmt.array_expr)) {
+                // for-in over a dense local: typed element, no tag checks
+                DenseArray* dense = dense_array_for(stmt->for_stmt.array_expr);
+                emit("{\n");
+                push_scope();
+                emit("    for (int __i = 0, __n = %s.count; __i < __n; __i++) {\n", dense->name);
+                emit("        %s %.*s = %s.data[__i];\n", dense_elem_c_type(dense),
+                     stmt->for_stmt.loop_var.length, stmt->for_stmt.loop_var.start, dense->name);
+                codegen_stmt(stmt->for_stmt.body);
+                emit("    }\n");
+                pop_scope();
+                emit("}\n");
+            } else if (stmt->for_stmt.array_expr) {
                 // Generate for-in loop: for item in array
                 emit("{\n");
                 push_scope();
@@ -5547,13 +6683,11 @@ void codegen_stmt(Stmt* stmt) {
                 if (!modules_emitted_this_compilation) {
                     modules_emitted_this_compilation = true;
                     
-                    extern int get_all_modules_raw(void** out_modules, int max_count);
-                    void* all_modules_raw[64];
-                    int module_count = get_all_modules_raw(all_modules_raw, 64);
+                    ModuleEntry* all_modules[64];
+                    int module_count = get_all_modules(all_modules, 64);
                     
                     for (int m = 0; m < module_count; m++) {
-                        typedef struct { char* name; Program* ast; } ModuleEntry;
-                        ModuleEntry* mod = (ModuleEntry*)all_modules_raw[m];
+                        ModuleEntry* mod = all_modules[m];
                         
                         // Register short name mapping for nested modules
                         register_module_short_name(mod->name);
@@ -5567,9 +6701,7 @@ void codegen_stmt(Stmt* stmt) {
                                 s = s->export.stmt;
                             }
                             if (s->type == STMT_FN) {
-                                char func_name[256];
-                                snprintf(func_name, 256, "%.*s", s->fn.name.length, s->fn.name.start);
-                                register_module_function(func_name);
+                                register_module_function(s->fn.name);
                             }
                         }
                         
@@ -5621,6 +6753,8 @@ void codegen_stmt(Stmt* stmt) {
                                             return_type = "WynHashMap*";
                                         } else if (rt.length == 7 && memcmp(rt.start, "HashSet", 7) == 0) {
                                             return_type = "WynHashSet*";
+                                        } else if (rt.length == 13 && memcmp(rt.start, "StringBuilder", 13) == 0) {
+                                            return_type = "WynStringBuilder*";
                                         } else {
                                             // Custom struct type - add module prefix
                                             snprintf(custom_ret_type, 128, "%s_%.*s", c_mod_name, rt.length, rt.start);
@@ -5895,31 +7029,17 @@ static void scan_stmt_for_lambdas(Stmt* stmt) {
             scan_expr_for_lambdas(stmt->while_stmt.condition);
             scan_stmt_for_lambdas(stmt->while_stmt.body);
             break;
+        case STMT_FOR:
+            scan_stmt_for_lambdas(stmt->for_stmt.init);
+            scan_stmt_for_lambdas(stmt->for_stmt.body);
+            break;
+        case STMT_SCOPE:
+            scan_stmt_for_lambdas(stmt->scope.body);
+            break;
         case STMT_SPAWN:
             // Collect spawn wrappers
-            if (stmt->spawn.call->type == EXPR_CALL && 
-                stmt->spawn.call->call.callee->type == EXPR_IDENT &&
-                stmt->spawn.call->call.arg_count == 0) {
-                
-                Expr* callee = stmt->spawn.call->call.callee;
-                char func_name[256];
-                int len = callee->token.length < 255 ? callee->token.length : 255;
-                memcpy(func_name, callee->token.start, len);
-                func_name[len] = '\0';
-                
-                // Add to spawn wrappers (avoid duplicates)
-                bool already_added = false;
-                for (int i = 0; i < spawn_wrapper_count; i++) {
-                    if (strcmp(spawn_wrappers[i].func_name, func_name) == 0) {
-                        already_added = true;
-                        break;
-                    }
-                }
-                if (!already_added && spawn_wrapper_count < 256) {
-                    strcpy(spawn_wrappers[spawn_wrapper_count].func_name, func_name);
-                    spawn_wrapper_count++;
-                }
-            }
+            register_spawn_target(stmt->spawn.call);
+            scan_expr_for_lambdas(stmt->spawn.call);
             break;
         default:
             break;
@@ -6071,6 +7191,16 @@ static void scan_expr_for_lambdas(Expr* expr) {
                 scan_expr_for_lambdas(expr->call.args[i]);
             }
             break;
+        case EXPR_METHOD_CALL:
+            scan_expr_for_lambdas(expr->method_call.object);
+            for (int i = 0; i < expr->method_call.arg_count; i++) {
+                scan_expr_for_lambdas(expr->method_call.args[i]);
+            }
+            break;
+        case EXPR_SPAWN:
+            register_spawn_target(expr->spawn.call);
+            scan_expr_for_lambdas(expr->spawn.call);
+            break;
         default:
             break;
     }
@@ -6086,13 +7216,22 @@ void codegen_program(Program* prog) {
     
     // Reset module emission flag for this compilation
     modules_emitted_this_compilation = false;
+    codegen_current_program = prog;
     
     // Reset lambda collection
     lambda_count = 0;
     lambda_id_counter = 0;
+    lambda_ref_counter = 0;
+    lambda_var_counter = 0;
+    lambda_var_count = 0;
+    
+    // Module names are registered again as they are emitted
+    module_short_name_count = 0;
+    module_alias_count = 0;
     
     // Reset spawn wrapper collection
     spawn_wrapper_count = 0;
+    spawn_scope_counter = 0;
     
     // PASS 1: Pre-scan to collect all lambdas
     // We need to emit lambda functions before they're used
@@ -6320,6 +7459,8 @@ void codegen_program(Program* prog) {
                         return_type = "WynHashMap*";
                     } else if (type_name.length == 7 && memcmp(type_name.start, "HashSet", 7) == 0) {
                         return_type = "WynHashSet*";
+                    } else if (type_name.length == 13 && memcmp(type_name.start, "StringBuilder", 13) == 0) {
+                        return_type = "WynStringBuilder*";
                     } else {
                         // Assume it's a custom struct type
                         snprintf(return_type_buf, sizeof(return_type_buf), "%.*s", 
@@ -6410,6 +7551,8 @@ void codegen_program(Program* prog) {
                             param_type = "WynHashMap*";
                         } else if (type_name.length == 7 && memcmp(type_name.start, "HashSet", 7) == 0) {
                             param_type = "WynHashSet*";
+                        } else if (type_name.length == 13 && memcmp(type_name.start, "StringBuilder", 13) == 0) {
+                            param_type = "WynStringBuilder*";
                         } else {
                             // Assume it's a struct type
                             snprintf(struct_type_name, sizeof(struct_type_name), "%.*s", 
@@ -6493,6 +7636,10 @@ void codegen_program(Program* prog) {
     if (spawn_wrapper_count > 0) {
         emit("// Spawn wrapper functions\n");
         for (int i = 0; i < spawn_wrapper_count; i++) {
+            if (spawn_wrappers[i].fn) {
+                emit_spawn_record(&spawn_wrappers[i]);
+                continue;
+            }
             emit("void __spawn_wrapper_%s(void* arg) {\n", spawn_wrappers[i].func_name);
             emit("    %s();\n", spawn_wrappers[i].func_name);
             emit("}\n\n");
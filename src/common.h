@@ -18,7 +18,7 @@ typedef enum {
     TOKEN_TRUE, TOKEN_FALSE, TOKEN_NULL,
     TOKEN_TEST, TOKEN_ASSERT,
     TOKEN_SOME, TOKEN_NONE, TOKEN_OK, TOKEN_ERR,
-    TOKEN_SPAWN, TOKEN_CHANNEL, TOKEN_ASYNC, TOKEN_AWAIT,
+    TOKEN_SPAWN, TOKEN_SCOPE, TOKEN_CHANNEL, TOKEN_ASYNC, TOKEN_AWAIT,
     TOKEN_AND, TOKEN_OR, TOKEN_NOT,
     TOKEN_AMPAMP, TOKEN_PIPEPIPE,
     TOKEN_PLUS, TOKEN_MINUS, TOKEN_STAR, TOKEN_SLASH, TOKEN_PERCENT,
@@ -36,6 +36,7 @@ typedef struct {
     const char* start;
     int length;
     int line;
+    uint32_t id;            // interned name for TOKEN_IDENT (see intern.h), 0 otherwise
 } Token;
 
 // Parser functions
@@ -1,387 +1,532 @@
+#define _POSIX_C_SOURCE 200809L
 #include "arc_runtime.h"
-#include "memory.h"
 #include "error.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
 #include <time.h>
 
 // T2.3.4: Cycle Detection Algorithm
-// Trial deletion algorithm for detecting and collecting reference cycles
+// Trial deletion (Bacon-Rajan), run incrementally on the thread that owns
+// the objects.
+//
+// Releasing an object of a traced type to a nonzero count makes it a possible
+// cycle root, and the releasing thread buffers it once in its own root
+// buffer. A thread collects its buffer in rounds, and every round is split
+// into slices that stop when their time budget runs out:
+//   mark     trace the graph reachable from the buffered roots
+//   scan     count the references each graph object gets from inside the
+//            graph. An object with more references than that is reachable
+//            from outside, and so is everything it reaches. This step is
+//            never split, so it sees one consistent graph.
+//   collect  run the destructors of the rest: the garbage
+//   free     release the garbage's memory and let go of the live objects
+// The program runs between slices. Garbage cannot become reachable again, so
+// the scan's verdict stays true while collect and free finish.
+//
+// The collector holds every object it keeps a pointer to (WYN_CYCLE_BUFFERED
+// or WYN_CYCLE_MARKED). When a held object's count reaches zero, the release
+// path leaves it to the collector, which frees it when it lets go.
+//
+// Only objects the thread owns are examined. Shared objects (ARC_SHARED_FLAG,
+// or every object after wyn_arc_share_all) are never buffered, and a graph
+// that reaches one treats it as an outside reference: other threads may be
+// changing its fields.
+//
+// WYN_CYCLE_STATS=1 prints the statistics to stderr at exit.
 
-// Cycle detection configuration
-// (Defined in arc_runtime.h)
+#define DEFAULT_THRESHOLD 1000
+#define DEFAULT_MAX_OBJECTS (1u << 16)
+#define DEFAULT_SLICE_BUDGET_NS 1000000     // 1ms
+#define MAX_GRAPH_OBJECTS ((1u << (32 - WYN_CYCLE_INDEX_SHIFT)) - 1)
+#define DEADLINE_CHECK_INTERVAL 32          // Steps between clock reads
+
+typedef struct {
+    WynObject** items;
+    size_t count;
+    size_t capacity;
+} ObjectList;
 
-// Object state during cycle detection
 typedef enum {
-    CYCLE_STATE_WHITE = 0,  // Not visited
-    CYCLE_STATE_GRAY = 1,   // Being processed
-    CYCLE_STATE_BLACK = 2,  // Processed
-    CYCLE_STATE_PURPLE = 3  // Potential cycle member
-} CycleState;
-
-// Extended object header for cycle detection
-typedef struct CycleDetectionData {
-    CycleState state;
-    bool marked_for_collection;
-    size_t original_ref_count;
-    struct CycleDetectionData* next_in_cycle;
-    WynObject* object;
-} CycleDetectionData;
-
-// Cycle detection registry
+    ROUND_IDLE,
+    ROUND_MARK,
+    ROUND_COLLECT,
+    ROUND_FREE
+} RoundPhase;
+
+// Per-thread collector
 typedef struct {
-    CycleDetectionData** candidates;  // Array of potential cycle candidates
-    size_t candidate_count;
-    size_t candidate_capacity;
-    pthread_mutex_t registry_lock;
-    CycleDetectionConfig config;
-    
-    // Statistics
-    _Atomic size_t cycles_detected;
-    _Atomic size_t objects_collected;
-    _Atomic size_t collection_runs;
-    _Atomic size_t false_positives;
-    _Atomic size_t allocations_since_collection;
-} CycleDetectionRegistry;
-
-static CycleDetectionRegistry g_cycle_registry = {0};
-static bool g_cycle_detection_initialized = false;
-
-// Initialize cycle detection system
-void wyn_cycle_detection_init(void) {
-    if (g_cycle_detection_initialized) return;
-    
-    // Initialize registry
-    g_cycle_registry.candidate_capacity = 1024;
-    g_cycle_registry.candidates = calloc(g_cycle_registry.candidate_capacity, 
-                                       sizeof(CycleDetectionData*));
-    if (!g_cycle_registry.candidates) {
-        wyn_panic("Failed to initialize cycle detection registry");
+    ObjectList roots;           // Buffered possible roots
+    ObjectList spare;           // Second root buffer, swapped in at round start
+    ObjectList graph;           // The round's objects; the first round_roots are its roots
+    ObjectList stack;           // Objects left to trace
+    uint32_t* internal;         // References each graph object gets from inside the graph
+    uint8_t* live;              // Reachable from outside the graph
+    size_t meta_capacity;
+    size_t round_roots;
+    size_t limit;               // max_objects_per_cycle for this round
+    size_t cursor;              // Progress through graph in collect and free
+    size_t since_slice;         // Roots buffered since the last automatic slice
+    size_t collected;           // Garbage objects found on this thread
+    RoundPhase phase;
+    bool overflow;
+    bool in_slice;              // Destructors run by a slice release objects too
+    bool registered;            // Flushed at thread exit
+} Collector;
+
+static _Thread_local Collector t_collector;
+
+_Atomic(WynCycleTrace) wyn_cycle_tracers[WYN_CYCLE_MAX_TYPES];
+
+static pthread_once_t g_cycle_once = PTHREAD_ONCE_INIT;
+static pthread_key_t g_cycle_thread_key;
+static pthread_mutex_t g_config_lock = PTHREAD_MUTEX_INITIALIZER;
+static CycleDetectionConfig g_config = {
+    DEFAULT_THRESHOLD, DEFAULT_MAX_OBJECTS, true, DEFAULT_SLICE_BUDGET_NS
+};
+
+// The release path reads these without taking the lock
+static _Atomic size_t g_threshold = DEFAULT_THRESHOLD;
+static _Atomic bool g_auto = true;
+static _Atomic uint64_t g_budget_ns = DEFAULT_SLICE_BUDGET_NS;
+static _Atomic size_t g_max_objects = DEFAULT_MAX_OBJECTS;
+
+// Statistics, summed over all threads
+static _Atomic size_t g_cycles_detected;
+static _Atomic size_t g_objects_collected;
+static _Atomic size_t g_collection_runs;
+static _Atomic size_t g_false_positives;
+static _Atomic size_t g_rounds_abandoned;
+static _Atomic size_t g_slices;
+static _Atomic uint64_t g_max_slice_ns;
+static _Atomic uint64_t g_total_slice_ns;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static bool list_push(ObjectList* list, WynObject* obj) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 256;
+        WynObject** items = realloc(list->items, capacity * sizeof(WynObject*));
+        if (!items) return false;
+        list->items = items;
+        list->capacity = capacity;
     }
-    
-    g_cycle_registry.candidate_count = 0;
-    pthread_mutex_init(&g_cycle_registry.registry_lock, NULL);
-    
-    // Default configuration
-    g_cycle_registry.config.collection_threshold = 1000;
-    g_cycle_registry.config.max_objects_per_cycle = 100;
-    g_cycle_registry.config.auto_collection_enabled = true;
-    g_cycle_registry.config.collection_frequency = 0.1; // 10% of allocations
-    g_cycle_registry.config.min_cycle_size = 2;
-    
-    // Initialize statistics
-    atomic_store(&g_cycle_registry.cycles_detected, 0);
-    atomic_store(&g_cycle_registry.objects_collected, 0);
-    atomic_store(&g_cycle_registry.collection_runs, 0);
-    atomic_store(&g_cycle_registry.false_positives, 0);
-    atomic_store(&g_cycle_registry.allocations_since_collection, 0);
-    
-    g_cycle_detection_initialized = true;
-}
-
-// Configure cycle detection parameters
-void wyn_cycle_configure(CycleDetectionConfig* config) {
-    if (!config) return;
-    
-    wyn_cycle_detection_init();
-    
-    pthread_mutex_lock(&g_cycle_registry.registry_lock);
-    g_cycle_registry.config = *config;
-    pthread_mutex_unlock(&g_cycle_registry.registry_lock);
+    list->items[list->count++] = obj;
+    return true;
 }
 
-// Add object as potential cycle candidate
-void wyn_cycle_add_candidate(WynObject* obj) {
-    if (!obj || !g_cycle_detection_initialized) return;
-    
-    pthread_mutex_lock(&g_cycle_registry.registry_lock);
-    
-    // Expand capacity if needed
-    if (g_cycle_registry.candidate_count >= g_cycle_registry.candidate_capacity) {
-        size_t new_capacity = g_cycle_registry.candidate_capacity * 2;
-        CycleDetectionData** new_candidates = realloc(g_cycle_registry.candidates,
-                                                     new_capacity * sizeof(CycleDetectionData*));
-        if (!new_candidates) {
-            pthread_mutex_unlock(&g_cycle_registry.registry_lock);
-            return; // Fail silently to avoid disrupting normal operation
+static bool list_reserve(ObjectList* list, size_t capacity) {
+    if (capacity <= list->capacity) return true;
+    WynObject** items = realloc(list->items, capacity * sizeof(WynObject*));
+    if (!items) return false;
+    list->items = items;
+    list->capacity = capacity;
+    return true;
+}
+
+static void list_free(ObjectList* list) {
+    free(list->items);
+    memset(list, 0, sizeof(*list));
+}
+
+static bool is_shared(const WynObject* obj) {
+    return wyn_arc_count_shared(atomic_load_explicit(&obj->header.ref_count, memory_order_relaxed));
+}
+
+static void trace(WynObject* obj, WynCycleVisit visit, Collector* c) {
+    WynCycleTrace tracer = atomic_load_explicit(&wyn_cycle_tracers[obj->header.type_id], memory_order_acquire);
+    if (tracer) tracer(obj, visit, c);
+}
+
+// Graph position of obj, or SIZE_MAX when it is not in the current round
+static size_t graph_index(const Collector* c, WynObject* obj) {
+    uint32_t state = atomic_load_explicit(&obj->header.cycle, memory_order_relaxed);
+    if (!(state & WYN_CYCLE_MARKED)) return SIZE_MAX;
+    size_t index = state >> WYN_CYCLE_INDEX_SHIFT;
+    return index < c->graph.count && c->graph.items[index] == obj ? index : SIZE_MAX;
+}
+
+// Memory of an object whose destructor already ran
+static void free_memory(WynObject* obj) {
+    obj->header.magic = 0;
+    wyn_pool_release(obj);
+}
+
+// Lets go of one hold on obj, freeing it if its count reached zero while held
+static void drop_hold(WynObject* obj, uint32_t hold) {
+    uint32_t clear = hold;
+    if (hold == WYN_CYCLE_MARKED) clear |= ~0u << WYN_CYCLE_INDEX_SHIFT;
+    uint32_t old = atomic_fetch_and_explicit(&obj->header.cycle, ~clear, memory_order_acq_rel);
+    if (old & ~clear & WYN_CYCLE_HELD) return;
+    if (old & WYN_CYCLE_DESTROYED) {
+        free_memory(obj);
+    } else if (old & WYN_CYCLE_ZERO) {
+        wyn_arc_deallocate(obj);
+    }
+}
+
+bool wyn_cycle_defer_free(WynObject* obj) {
+    uint32_t old = atomic_fetch_or_explicit(&obj->header.cycle, WYN_CYCLE_ZERO, memory_order_acq_rel);
+    return (old & WYN_CYCLE_HELD) != 0;
+}
+
+static bool grow_meta(Collector* c) {
+    size_t capacity = c->meta_capacity ? c->meta_capacity * 2 : 256;
+    uint32_t* internal = realloc(c->internal, capacity * sizeof(uint32_t));
+    if (!internal) return false;
+    c->internal = internal;
+    uint8_t* live = realloc(c->live, capacity);
+    if (!live) return false;
+    c->live = live;
+    c->meta_capacity = capacity;
+    return true;
+}
+
+static bool add_to_graph(Collector* c, WynObject* obj) {
+    size_t index = c->graph.count;
+    if (index >= c->meta_capacity && !grow_meta(c)) return false;
+    if (!list_push(&c->graph, obj)) return false;
+    atomic_fetch_or_explicit(&obj->header.cycle,
+                             WYN_CYCLE_MARKED | (uint32_t)index << WYN_CYCLE_INDEX_SHIFT,
+                             memory_order_relaxed);
+    if (!list_push(&c->stack, obj)) c->overflow = true;
+    return true;
+}
+
+static void visit_mark(WynObject* child, void* ctx) {
+    Collector* c = ctx;
+    if (!child || !wyn_cycle_traced(child) || is_shared(child)) return;
+    if (atomic_load_explicit(&child->header.cycle, memory_order_relaxed) & WYN_CYCLE_MARKED) return;
+    if (c->overflow || c->graph.count >= c->limit || !add_to_graph(c, child)) c->overflow = true;
+}
+
+static void visit_count(WynObject* child, void* ctx) {
+    Collector* c = ctx;
+    if (!child) return;
+    size_t index = graph_index(c, child);
+    if (index != SIZE_MAX) c->internal[index]++;
+}
+
+static void visit_live(WynObject* child, void* ctx) {
+    Collector* c = ctx;
+    if (!child) return;
+    size_t index = graph_index(c, child);
+    if (index == SIZE_MAX || c->live[index]) return;
+    c->live[index] = 1;
+    list_push(&c->stack, child);
+}
+
+static void end_round(Collector* c) {
+    c->graph.count = 0;
+    c->stack.count = 0;
+    c->round_roots = 0;
+    c->cursor = 0;
+    c->phase = ROUND_IDLE;
+}
+
+// Gives up on the round; rebuffered roots are examined again by the next one
+static void abandon_round(Collector* c, bool rebuffer) {
+    for (size_t i = 0; i < c->graph.count; i++) {
+        WynObject* obj = c->graph.items[i];
+        if (rebuffer && i < c->round_roots && list_push(&c->roots, obj)) {
+            atomic_fetch_or_explicit(&obj->header.cycle, WYN_CYCLE_BUFFERED, memory_order_relaxed);
         }
-        g_cycle_registry.candidates = new_candidates;
-        g_cycle_registry.candidate_capacity = new_capacity;
+        drop_hold(obj, WYN_CYCLE_MARKED);
     }
-    
-    // Create cycle detection data
-    CycleDetectionData* cycle_data = malloc(sizeof(CycleDetectionData));
-    if (!cycle_data) {
-        pthread_mutex_unlock(&g_cycle_registry.registry_lock);
-        return;
+    atomic_fetch_add_explicit(&g_rounds_abandoned, 1, memory_order_relaxed);
+    end_round(c);
+}
+
+static void start_round(Collector* c) {
+    // Swap buffers: destructors run by this round may buffer new roots
+    ObjectList batch = c->roots;
+    c->roots = c->spare;
+    c->roots.count = 0;
+
+    size_t limit = atomic_load_explicit(&g_max_objects, memory_order_relaxed);
+    c->limit = limit < 1 ? 1 : limit > MAX_GRAPH_OBJECTS ? MAX_GRAPH_OBJECTS : limit;
+    c->overflow = false;
+    c->phase = ROUND_MARK;
+
+    for (size_t i = 0; i < batch.count; i++) {
+        WynObject* obj = batch.items[i];
+        uint32_t state = atomic_load_explicit(&obj->header.cycle, memory_order_acquire);
+        if ((state & (WYN_CYCLE_ZERO | WYN_CYCLE_DESTROYED)) || is_shared(obj)) {
+            drop_hold(obj, WYN_CYCLE_BUFFERED);
+        } else if (c->graph.count >= c->limit || !add_to_graph(c, obj)) {
+            // Left for the next round, still buffered
+            if (!list_push(&c->roots, obj)) drop_hold(obj, WYN_CYCLE_BUFFERED);
+        } else {
+            drop_hold(obj, WYN_CYCLE_BUFFERED);
+        }
     }
-    
-    cycle_data->state = CYCLE_STATE_WHITE;
-    cycle_data->marked_for_collection = false;
-    cycle_data->original_ref_count = wyn_arc_get_ref_count(obj);
-    cycle_data->next_in_cycle = NULL;
-    cycle_data->object = obj;
-    
-    g_cycle_registry.candidates[g_cycle_registry.candidate_count++] = cycle_data;
-    
-    pthread_mutex_unlock(&g_cycle_registry.registry_lock);
-}
-
-// Mark object references (simplified - would need object introspection in real implementation)
-static void mark_object_references(WynObject* obj, CycleState new_state) {
-    if (!obj) return;
-    
-    // In a real implementation, this would traverse object references
-    // For now, we simulate by marking the object itself
-    (void)new_state; // Suppress unused parameter warning
-    
-    // This is where we would:
-    // 1. Get object's reference fields
-    // 2. For each referenced object, mark it with new_state
-    // 3. Recursively process referenced objects
-}
-
-// Trial deletion algorithm
-static bool trial_delete_object(CycleDetectionData* cycle_data) {
-    if (!cycle_data || !cycle_data->object) return false;
-    
-    WynObject* obj = cycle_data->object;
-    
-    // Check if object is still valid before accessing it
-    if (!wyn_arc_is_valid(obj)) {
-        // Object was already deallocated, mark as collected
-        cycle_data->state = CYCLE_STATE_BLACK;
-        cycle_data->marked_for_collection = false;
-        return true;
+    c->round_roots = c->graph.count;
+    batch.count = 0;
+    c->spare = batch;
+    if (c->round_roots == 0) end_round(c);
+}
+
+// Decides which graph objects are garbage; false when the round must be redone
+static bool scan_graph(Collector* c) {
+    size_t n = c->graph.count;
+    for (size_t i = 0; i < n; i++) {
+        if (is_shared(c->graph.items[i])) return false;
     }
-    
-    // Mark object as being processed first
-    cycle_data->state = CYCLE_STATE_GRAY;
-    
-    // Now safely get reference count since we know object is valid
-    uint32_t current_ref_count = wyn_arc_get_ref_count(obj);
-    
-    // If reference count is 0, object is already being deallocated
-    if (current_ref_count == 0) {
-        cycle_data->state = CYCLE_STATE_BLACK;
-        return true; // Consider it collected
+    // Every object is pushed at most once below, so the pushes cannot fail
+    if (!list_reserve(&c->stack, n)) return false;
+    memset(c->internal, 0, n * sizeof(uint32_t));
+    memset(c->live, 0, n);
+    for (size_t i = 0; i < n; i++) trace(c->graph.items[i], visit_count, c);
+
+    c->stack.count = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (c->live[i]) continue;
+        uint32_t count = atomic_load_explicit(&c->graph.items[i]->header.ref_count, memory_order_relaxed) & ARC_COUNT_MASK;
+        if (count <= c->internal[i]) continue;
+        c->live[i] = 1;
+        list_push(&c->stack, c->graph.items[i]);
+        while (c->stack.count > 0) trace(c->stack.items[--c->stack.count], visit_live, c);
     }
-    
-    // Simulate trial deletion by checking if object would be deallocated
-    if (current_ref_count == 1) {
-        // Object would be deallocated if not part of cycle
-        cycle_data->state = CYCLE_STATE_PURPLE; // Potential cycle member
-        return true;
+
+    size_t garbage = 0, garbage_roots = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (c->live[i]) continue;
+        garbage++;
+        if (i < c->round_roots) garbage_roots++;
     }
-    
-    // Mark as processed
-    cycle_data->state = CYCLE_STATE_BLACK;
-    return false;
-}
-
-// Detect cycles in candidate objects
-static size_t detect_cycles(void) {
-    if (!g_cycle_detection_initialized) return 0;
-    
-    size_t cycles_found = 0;
-    size_t objects_in_cycles = 0;
-    
-    pthread_mutex_lock(&g_cycle_registry.registry_lock);
-    
-    // Reset all states and clean up invalid candidates
-    for (size_t i = 0; i < g_cycle_registry.candidate_count; i++) {
-        if (g_cycle_registry.candidates[i]) {
-            WynObject* obj = g_cycle_registry.candidates[i]->object;
-            if (!obj || !wyn_arc_is_valid(obj)) {
-                // Remove invalid candidate
-                free(g_cycle_registry.candidates[i]);
-                g_cycle_registry.candidates[i] = NULL;
-                continue;
+    c->collected += garbage;
+    atomic_fetch_add_explicit(&g_objects_collected, garbage, memory_order_relaxed);
+    atomic_fetch_add_explicit(&g_cycles_detected, garbage_roots, memory_order_relaxed);
+    atomic_fetch_add_explicit(&g_false_positives, c->round_roots - garbage_roots, memory_order_relaxed);
+    atomic_fetch_add_explicit(&g_collection_runs, 1, memory_order_relaxed);
+    return true;
+}
+
+// Does one unit of work: traces, destroys or frees one object, or moves on
+static void step(Collector* c) {
+    switch (c->phase) {
+        case ROUND_IDLE:
+            start_round(c);
+            break;
+
+        case ROUND_MARK:
+            if (c->stack.count > 0 && !c->overflow) {
+                trace(c->stack.items[--c->stack.count], visit_mark, c);
+            } else if (c->overflow) {
+                abandon_round(c, false);
+            } else if (!scan_graph(c)) {
+                abandon_round(c, true);
+            } else {
+                c->phase = ROUND_COLLECT;
+                c->cursor = 0;
             }
-            g_cycle_registry.candidates[i]->state = CYCLE_STATE_WHITE;
-            g_cycle_registry.candidates[i]->marked_for_collection = false;
-        }
-    }
-    
-    // Trial deletion phase
-    for (size_t i = 0; i < g_cycle_registry.candidate_count; i++) {
-        CycleDetectionData* candidate = g_cycle_registry.candidates[i];
-        if (!candidate || candidate->state != CYCLE_STATE_WHITE) continue;
-        
-        if (trial_delete_object(candidate)) {
-            if (candidate->state == CYCLE_STATE_PURPLE) {
-                // Potential cycle member found
-                candidate->marked_for_collection = true;
-                objects_in_cycles++;
-                
-                // Group consecutive cycle members
-                if (objects_in_cycles >= g_cycle_registry.config.min_cycle_size) {
-                    cycles_found++;
-                }
+            break;
+
+        case ROUND_COLLECT:
+            if (c->cursor < c->graph.count) {
+                size_t i = c->cursor++;
+                WynObject* obj = c->graph.items[i];
+                // Garbage references only other garbage and outside objects,
+                // so its destructors release cycle edges safely in any order
+                if (!c->live[i] && obj->header.destructor) obj->header.destructor(obj);
+            } else {
+                c->phase = ROUND_FREE;
+                c->cursor = 0;
             }
-        }
-    }
-    
-    pthread_mutex_unlock(&g_cycle_registry.registry_lock);
-    
-    return cycles_found;
-}
-
-// Collect objects marked for collection
-static size_t collect_marked_objects(void) {
-    if (!g_cycle_detection_initialized) return 0;
-    
-    size_t collected = 0;
-    
-    pthread_mutex_lock(&g_cycle_registry.registry_lock);
-    
-    // Collect marked objects (simulation only - don't actually deallocate)
-    for (size_t i = 0; i < g_cycle_registry.candidate_count; i++) {
-        CycleDetectionData* candidate = g_cycle_registry.candidates[i];
-        if (!candidate || !candidate->marked_for_collection) continue;
-        
-        WynObject* obj = candidate->object;
-        if (obj && wyn_arc_is_valid(obj)) {
-            // Verify object is still in a cycle before collecting
-            uint32_t ref_count = wyn_arc_get_ref_count(obj);
-            if (ref_count > 0) {
-                // In a real implementation, this would deallocate cyclic objects
-                // For testing, we just count it as collected
-                collected++;
+            break;
+
+        case ROUND_FREE:
+            if (c->cursor < c->graph.count) {
+                size_t i = c->cursor++;
+                WynObject* obj = c->graph.items[i];
+                if (c->live[i]) {
+                    drop_hold(obj, WYN_CYCLE_MARKED);
+                } else if (atomic_fetch_or_explicit(&obj->header.cycle, WYN_CYCLE_DESTROYED,
+                                                    memory_order_acq_rel) & WYN_CYCLE_BUFFERED) {
+                    // Rebuffered during the round: the root buffer frees it
+                    drop_hold(obj, WYN_CYCLE_MARKED);
+                } else {
+                    free_memory(obj);
+                }
+            } else {
+                end_round(c);
             }
-        }
-        
-        // Remove from candidates
-        free(candidate);
-        g_cycle_registry.candidates[i] = NULL;
+            break;
     }
-    
-    // Compact candidate array
-    size_t write_pos = 0;
-    for (size_t read_pos = 0; read_pos < g_cycle_registry.candidate_count; read_pos++) {
-        if (g_cycle_registry.candidates[read_pos]) {
-            g_cycle_registry.candidates[write_pos++] = g_cycle_registry.candidates[read_pos];
-        }
-    }
-    g_cycle_registry.candidate_count = write_pos;
-    
-    pthread_mutex_unlock(&g_cycle_registry.registry_lock);
-    
-    return collected;
 }
 
-// Run cycle detection and collection
-size_t wyn_cycle_collect(void) {
+static void cycle_thread_exit(void* arg) {
+    (void)arg;
+    wyn_cycle_cleanup();
+}
+
+static void cycle_setup(void) {
+    pthread_key_create(&g_cycle_thread_key, cycle_thread_exit);
+    const char* env = getenv("WYN_CYCLE_STATS");
+    if (env && *env && strcmp(env, "0") != 0) atexit(wyn_cycle_print_stats);
+}
+
+void wyn_cycle_detection_init(void) {
+    pthread_once(&g_cycle_once, cycle_setup);
+}
+
+// Flushes the calling thread's buffer when it exits
+static void register_thread(Collector* c) {
     wyn_cycle_detection_init();
-    
-    atomic_fetch_add(&g_cycle_registry.collection_runs, 1);
-    
-    // Detect cycles
-    size_t cycles_detected = detect_cycles();
-    atomic_fetch_add(&g_cycle_registry.cycles_detected, cycles_detected);
-    
-    // Collect cyclic objects
-    size_t objects_collected = collect_marked_objects();
-    atomic_fetch_add(&g_cycle_registry.objects_collected, objects_collected);
-    
-    // Reset allocation counter
-    atomic_store(&g_cycle_registry.allocations_since_collection, 0);
-    
-    return objects_collected;
-}
-
-// Check if automatic collection should be triggered
-void wyn_cycle_check_collection_trigger(void) {
-    if (!g_cycle_detection_initialized || !g_cycle_registry.config.auto_collection_enabled) {
+    c->registered = true;
+    pthread_setspecific(g_cycle_thread_key, c);
+}
+
+void wyn_cycle_configure(CycleDetectionConfig* config) {
+    if (!config) return;
+    pthread_mutex_lock(&g_config_lock);
+    g_config = *config;
+    atomic_store_explicit(&g_threshold, config->collection_threshold, memory_order_relaxed);
+    atomic_store_explicit(&g_auto, config->auto_collection_enabled, memory_order_relaxed);
+    atomic_store_explicit(&g_budget_ns, config->slice_budget_ns, memory_order_relaxed);
+    atomic_store_explicit(&g_max_objects, config->max_objects_per_cycle, memory_order_relaxed);
+    pthread_mutex_unlock(&g_config_lock);
+}
+
+void wyn_cycle_register_type(uint32_t type_id, WynCycleTrace trace) {
+    if (type_id >= WYN_CYCLE_MAX_TYPES) {
+        report_error(ERR_INVALID_EXPRESSION, __FILE__, __LINE__, 0, "Cycle tracer type id out of range");
         return;
     }
-    
-    size_t allocations = atomic_fetch_add(&g_cycle_registry.allocations_since_collection, 1);
-    
-    // Trigger collection based on threshold
-    if (allocations >= g_cycle_registry.config.collection_threshold) {
-        wyn_cycle_collect();
+    atomic_store_explicit(&wyn_cycle_tracers[type_id], trace, memory_order_release);
+}
+
+void wyn_cycle_add_candidate(WynObject* obj) {
+    if (!obj || !wyn_cycle_traced(obj) || is_shared(obj)) return;
+    Collector* c = &t_collector;
+    uint32_t state = atomic_load_explicit(&obj->header.cycle, memory_order_relaxed);
+    if (state & (WYN_CYCLE_BUFFERED | WYN_CYCLE_DESTROYED)) return;
+    // Garbage whose destructors are running is released by its own cycle
+    if ((state & WYN_CYCLE_MARKED) && c->phase >= ROUND_COLLECT) {
+        size_t index = graph_index(c, obj);
+        if (index != SIZE_MAX && !c->live[index]) return;
+    }
+
+    if (!c->registered) register_thread(c);
+    if (!list_push(&c->roots, obj)) return;
+    atomic_fetch_or_explicit(&obj->header.cycle, WYN_CYCLE_BUFFERED, memory_order_relaxed);
+
+    if (c->in_slice || !atomic_load_explicit(&g_auto, memory_order_relaxed)) return;
+    if (++c->since_slice < atomic_load_explicit(&g_threshold, memory_order_relaxed)) return;
+    c->since_slice = 0;
+    wyn_cycle_collect_slice(atomic_load_explicit(&g_budget_ns, memory_order_relaxed));
+}
+
+bool wyn_cycle_collect_slice(uint64_t budget_ns) {
+    Collector* c = &t_collector;
+    if (c->in_slice) return true;
+    if (c->phase == ROUND_IDLE && c->roots.count == 0) return false;
+
+    c->in_slice = true;
+    uint64_t start = now_ns();
+    uint64_t deadline = budget_ns > UINT64_MAX - start ? UINT64_MAX : start + budget_ns;
+    bool more = true;
+    for (size_t steps = 1;; steps++) {
+        if (c->phase == ROUND_IDLE && c->roots.count == 0) {
+            more = false;
+            break;
+        }
+        step(c);
+        if (steps % DEADLINE_CHECK_INTERVAL == 0 && now_ns() >= deadline) break;
+    }
+    c->in_slice = false;
+
+    uint64_t elapsed = now_ns() - start;
+    atomic_fetch_add_explicit(&g_slices, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&g_total_slice_ns, elapsed, memory_order_relaxed);
+    uint64_t max = atomic_load_explicit(&g_max_slice_ns, memory_order_relaxed);
+    while (elapsed > max &&
+           !atomic_compare_exchange_weak_explicit(&g_max_slice_ns, &max, elapsed,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
     }
-    
-    // Random collection based on frequency
-    if ((double)rand() / RAND_MAX < g_cycle_registry.config.collection_frequency) {
-        wyn_cycle_collect();
+    return more;
+}
+
+size_t wyn_cycle_collect(void) {
+    Collector* c = &t_collector;
+    if (c->in_slice) return 0;
+    size_t before = c->collected;
+    while (wyn_cycle_collect_slice(UINT64_MAX)) {
     }
+    c->since_slice = 0;
+    return c->collected - before;
+}
+
+void wyn_cycle_check_collection_trigger(void) {
+    Collector* c = &t_collector;
+    if (c->phase == ROUND_IDLE && c->roots.count == 0) return;
+    c->since_slice = 0;
+    wyn_cycle_collect_slice(atomic_load_explicit(&g_budget_ns, memory_order_relaxed));
 }
 
-// Get cycle detection configuration
 CycleDetectionConfig wyn_cycle_get_config(void) {
-    wyn_cycle_detection_init();
-    
-    pthread_mutex_lock(&g_cycle_registry.registry_lock);
-    CycleDetectionConfig config = g_cycle_registry.config;
-    pthread_mutex_unlock(&g_cycle_registry.registry_lock);
-    
+    pthread_mutex_lock(&g_config_lock);
+    CycleDetectionConfig config = g_config;
+    pthread_mutex_unlock(&g_config_lock);
     return config;
 }
 
-// Cycle detection statistics
-// (Defined in arc_runtime.h)
 WynCycleStats wyn_cycle_get_stats(void) {
     WynCycleStats stats;
-    stats.cycles_detected = atomic_load(&g_cycle_registry.cycles_detected);
-    stats.objects_collected = atomic_load(&g_cycle_registry.objects_collected);
-    stats.collection_runs = atomic_load(&g_cycle_registry.collection_runs);
-    stats.false_positives = atomic_load(&g_cycle_registry.false_positives);
-    stats.allocations_since_collection = atomic_load(&g_cycle_registry.allocations_since_collection);
-    
-    pthread_mutex_lock(&g_cycle_registry.registry_lock);
-    stats.candidate_count = g_cycle_registry.candidate_count;
-    pthread_mutex_unlock(&g_cycle_registry.registry_lock);
-    
-    stats.collection_efficiency = stats.collection_runs > 0 ? 
-        (double)stats.objects_collected / stats.collection_runs : 0.0;
-    
+    stats.cycles_detected = atomic_load_explicit(&g_cycles_detected, memory_order_relaxed);
+    stats.objects_collected = atomic_load_explicit(&g_objects_collected, memory_order_relaxed);
+    stats.collection_runs = atomic_load_explicit(&g_collection_runs, memory_order_relaxed);
+    stats.false_positives = atomic_load_explicit(&g_false_positives, memory_order_relaxed);
+    stats.rounds_abandoned = atomic_load_explicit(&g_rounds_abandoned, memory_order_relaxed);
+    stats.slices = atomic_load_explicit(&g_slices, memory_order_relaxed);
+    stats.max_slice_ns = atomic_load_explicit(&g_max_slice_ns, memory_order_relaxed);
+    stats.total_slice_ns = atomic_load_explicit(&g_total_slice_ns, memory_order_relaxed);
+    stats.candidate_count = t_collector.roots.count;
     return stats;
 }
 
 void wyn_cycle_reset_stats(void) {
-    atomic_store(&g_cycle_registry.cycles_detected, 0);
-    atomic_store(&g_cycle_registry.objects_collected, 0);
-    atomic_store(&g_cycle_registry.collection_runs, 0);
-    atomic_store(&g_cycle_registry.false_positives, 0);
-    atomic_store(&g_cycle_registry.allocations_since_collection, 0);
+    atomic_store_explicit(&g_cycles_detected, 0, memory_order_relaxed);
+    atomic_store_explicit(&g_objects_collected, 0, memory_order_relaxed);
+    atomic_store_explicit(&g_collection_runs, 0, memory_order_relaxed);
+    atomic_store_explicit(&g_false_positives, 0, memory_order_relaxed);
+    atomic_store_explicit(&g_rounds_abandoned, 0, memory_order_relaxed);
+    atomic_store_explicit(&g_slices, 0, memory_order_relaxed);
+    atomic_store_explicit(&g_max_slice_ns, 0, memory_order_relaxed);
+    atomic_store_explicit(&g_total_slice_ns, 0, memory_order_relaxed);
 }
 
 void wyn_cycle_print_stats(void) {
     WynCycleStats stats = wyn_cycle_get_stats();
-    printf("=== Cycle Detection Statistics ===\n");
-    printf("Cycles detected: %zu\n", stats.cycles_detected);
-    printf("Objects collected: %zu\n", stats.objects_collected);
-    printf("Collection runs: %zu\n", stats.collection_runs);
-    printf("False positives: %zu\n", stats.false_positives);
-    printf("Current candidates: %zu\n", stats.candidate_count);
-    printf("Allocations since collection: %zu\n", stats.allocations_since_collection);
-    printf("Collection efficiency: %.2f objects/run\n", stats.collection_efficiency);
-    printf("==================================\n");
-}
-
-// Cleanup cycle detection system
+    fprintf(stderr, "=== Cycle Collector Statistics ===\n");
+    fprintf(stderr, "Rounds completed: %zu\n", stats.collection_runs);
+    fprintf(stderr, "Rounds abandoned: %zu\n", stats.rounds_abandoned);
+    fprintf(stderr, "Garbage roots: %zu\n", stats.cycles_detected);
+    fprintf(stderr, "Live roots: %zu\n", stats.false_positives);
+    fprintf(stderr, "Objects collected: %zu\n", stats.objects_collected);
+    fprintf(stderr, "Slices: %zu (max %.3f ms, mean %.3f ms)\n", stats.slices,
+            stats.max_slice_ns / 1e6,
+            stats.slices ? stats.total_slice_ns / 1e6 / stats.slices : 0.0);
+    fprintf(stderr, "Buffered roots (this thread): %zu\n", stats.candidate_count);
+}
+
 void wyn_cycle_cleanup(void) {
-    if (!g_cycle_detection_initialized) return;
-    
-    pthread_mutex_lock(&g_cycle_registry.registry_lock);
-    
-    // Free all candidate data
-    for (size_t i = 0; i < g_cycle_registry.candidate_count; i++) {
-        if (g_cycle_registry.candidates[i]) {
-            free(g_cycle_registry.candidates[i]);
-        }
-    }
-    
-    free(g_cycle_registry.candidates);
-    g_cycle_registry.candidates = NULL;
-    g_cycle_registry.candidate_count = 0;
-    g_cycle_registry.candidate_capacity = 0;
-    
-    pthread_mutex_unlock(&g_cycle_registry.registry_lock);
-    pthread_mutex_destroy(&g_cycle_registry.registry_lock);
-    
-    g_cycle_detection_initialized = false;
+    Collector* c = &t_collector;
+    if (c->in_slice) return;
+    wyn_cycle_collect();
+    list_free(&c->roots);
+    list_free(&c->spare);
+    list_free(&c->graph);
+    list_free(&c->stack);
+    free(c->internal);
+    free(c->live);
+    c->internal = NULL;
+    c->live = NULL;
+    c->meta_capacity = 0;
+    c->registered = false;
 }
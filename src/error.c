@@ -2,6 +2,7 @@
 #define _DEFAULT_SOURCE
 #include "error.h"
 #include "common.h"
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,6 +10,18 @@
 static WynError* errors = NULL;
 static int error_count = 0;
 static int error_capacity = 0;
+static bool errors_quiet = false;
+static WynErrorListener error_listener = NULL;
+static void* error_listener_ctx = NULL;
+
+void set_errors_quiet(bool quiet) {
+    errors_quiet = quiet;
+}
+
+void set_error_listener(WynErrorListener listener, void* ctx) {
+    error_listener = listener;
+    error_listener_ctx = ctx;
+}
 
 void report_error(ErrorCode code, const char* filename, int line, int column, const char* message) {
     report_error_with_suggestion(code, filename, line, column, message, NULL);
@@ -29,6 +42,31 @@ void report_error_with_suggestion(ErrorCode code, const char* filename, int line
     error->line = line;
     error->column = column;
     error->suggestion = suggestion ? strdup(suggestion) : NULL;
+    if (error_listener) error_listener(error, error_listener_ctx);
+}
+
+void compile_error(ErrorCode code, int line, const char* fmt, ...) {
+    char message[1024];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(message, sizeof(message), fmt, args);
+    va_end(args);
+
+    report_error(code, NULL, line, 0, message);
+    if (errors_quiet) return;
+    if (line > 0) {
+        fprintf(stderr, "Error at line %d: %s\n", line, message);
+    } else {
+        fprintf(stderr, "Error: %s\n", message);
+    }
+}
+
+void compile_note(const char* fmt, ...) {
+    if (errors_quiet) return;
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
 }
 
 void print_error(WynError* error) {
@@ -177,6 +215,9 @@ void type_suggest_conversion(const char* from_type, const char* to_type) {
 
 // Show source code context for better error messages
 void show_error_context(const char* filename, int line, int column, const char* message, const char* suggestion) {
+    report_error_with_suggestion(ERR_UNEXPECTED_TOKEN, filename, line, column, message, suggestion);
+    if (errors_quiet) return;
+
     FILE* f = fopen(filename, "r");
     if (!f) {
         printf("Error at %s:%d:%d: %s\n", filename, line, column, message);
@@ -58,6 +58,20 @@ int get_error_count(void);
 // Show source code context for errors
 void show_error_context(const char* filename, int line, int column, const char* message, const char* suggestion);
 
+// Parser and checker diagnostics: recorded like report_error, then printed to
+// stderr as "Error at line N: ..." ("Error: ..." when line is 0)
+void compile_error(ErrorCode code, int line, const char* fmt, ...);
+// Follow-up lines for the previous compile_error; printed only
+void compile_note(const char* fmt, ...);
+
+// Quiet mode records diagnostics without printing them (the language
+// server reports them to the editor instead)
+void set_errors_quiet(bool quiet);
+
+// Called for every recorded diagnostic, on the reporting thread
+typedef void (*WynErrorListener)(const WynError* error, void* ctx);
+void set_error_listener(WynErrorListener listener, void* ctx);
+
 // T1.2.3: Parser error recovery functions
 void parser_error_at_current(const char* message);
 void parser_error_at_previous(const char* message);
@@ -9,6 +9,12 @@
 
 // T2.4.1: Escape Analysis Implementation
 // Identify stack-allocatable objects and eliminate unnecessary retain/release pairs
+//
+// The checker records every value that can reach another thread here, keyed
+// by its expression, with ESCAPE_ARGUMENT_ESCAPE (a spawn argument) or
+// ESCAPE_GLOBAL_ESCAPE. Code generation looks the expression up and promotes
+// only those values to atomic reference counts; everything else keeps the
+// owner thread's plain counts.
 
 // Escape analysis result for an object (defined in arc_runtime.h)
 
@@ -30,6 +36,7 @@ typedef struct {
     size_t total_sites;
     size_t stack_allocatable_sites;
     size_t eliminated_retain_release_pairs;
+    size_t thread_escaping_sites;
     bool analysis_enabled;
     pthread_mutex_t lock;
 } EscapeAnalysisContext;
@@ -49,7 +56,14 @@ void wyn_escape_analysis_init(void) {
     pthread_mutex_init(&g_escape_context.lock, NULL);
 }
 
-// Register allocation site for analysis
+static AllocationSite* find_site(const void* allocation_point) {
+    for (AllocationSite* site = g_escape_context.allocation_sites; site; site = site->next) {
+        if (site->allocation_point == allocation_point) return site;
+    }
+    return NULL;
+}
+
+// Register allocation site for analysis; a point registers once
 AllocationSite* wyn_escape_register_allocation(void* allocation_point, size_t size, uint32_t type_id) {
     if (!g_escape_context.analysis_enabled) return NULL;
     
@@ -67,6 +81,13 @@ AllocationSite* wyn_escape_register_allocation(void* allocation_point, size_t si
     
     pthread_mutex_lock(&g_escape_context.lock);
     
+    AllocationSite* existing = find_site(allocation_point);
+    if (existing) {
+        pthread_mutex_unlock(&g_escape_context.lock);
+        free(site);
+        return existing;
+    }
+    
     // Add to linked list
     site->next = g_escape_context.allocation_sites;
     g_escape_context.allocation_sites = site;
@@ -107,16 +128,55 @@ void wyn_escape_add_reference(AllocationSite* site) {
     pthread_mutex_unlock(&g_escape_context.lock);
 }
 
+// Record how a site escapes. Statuses only widen: a value that reaches
+// another thread anywhere stays marked.
+void wyn_escape_mark(AllocationSite* site, EscapeStatus status) {
+    if (!site) return;
+    
+    pthread_mutex_lock(&g_escape_context.lock);
+    if (!wyn_escape_crosses_threads(site)) site->escape_status = status;
+    pthread_mutex_unlock(&g_escape_context.lock);
+}
+
+AllocationSite* wyn_escape_find(const void* allocation_point) {
+    if (!g_escape_context.analysis_enabled) return NULL;
+    
+    pthread_mutex_lock(&g_escape_context.lock);
+    AllocationSite* site = find_site(allocation_point);
+    pthread_mutex_unlock(&g_escape_context.lock);
+    return site;
+}
+
+EscapeStatus wyn_escape_status(const AllocationSite* site) {
+    return site ? site->escape_status : ESCAPE_UNKNOWN;
+}
+
+uint32_t wyn_escape_type_id(const AllocationSite* site) {
+    return site ? site->type_id : WYN_TYPE_UNKNOWN;
+}
+
+// Whether the value can be seen by a thread other than the one that made it
+bool wyn_escape_crosses_threads(const AllocationSite* site) {
+    return site && (site->escape_status == ESCAPE_ARGUMENT_ESCAPE ||
+                    site->escape_status == ESCAPE_GLOBAL_ESCAPE);
+}
+
 // Run escape analysis on all registered sites
 void wyn_escape_analyze_all(void) {
     if (!g_escape_context.analysis_enabled) return;
     
     pthread_mutex_lock(&g_escape_context.lock);
     
+    g_escape_context.stack_allocatable_sites = 0;
+    g_escape_context.eliminated_retain_release_pairs = 0;
+    g_escape_context.thread_escaping_sites = 0;
+    
     AllocationSite* current = g_escape_context.allocation_sites;
     while (current) {
-        // Perform escape analysis
-        current->escape_status = analyze_escape_status(current);
+        // Sites the checker classified keep their status
+        if (current->escape_status == ESCAPE_UNKNOWN) {
+            current->escape_status = analyze_escape_status(current);
+        }
         
         // Determine optimization opportunities
         switch (current->escape_status) {
@@ -139,6 +199,7 @@ void wyn_escape_analyze_all(void) {
             case ESCAPE_ARGUMENT_ESCAPE:
                 current->can_stack_allocate = false;
                 current->needs_retain_release = true;
+                g_escape_context.thread_escaping_sites++;
                 break;
                 
             case ESCAPE_UNKNOWN:
@@ -242,6 +303,7 @@ WynEscapeStats wyn_escape_get_stats(void) {
     stats.total_allocation_sites = g_escape_context.total_sites;
     stats.stack_allocatable_sites = g_escape_context.stack_allocatable_sites;
     stats.eliminated_retain_release_pairs = g_escape_context.eliminated_retain_release_pairs;
+    stats.thread_escaping_sites = g_escape_context.thread_escaping_sites;
     
     if (stats.total_allocation_sites > 0) {
         stats.stack_allocation_ratio = (double)stats.stack_allocatable_sites / stats.total_allocation_sites;
@@ -260,6 +322,7 @@ void wyn_escape_print_stats(void) {
     printf("Total allocation sites: %zu\n", stats.total_allocation_sites);
     printf("Stack allocatable sites: %zu\n", stats.stack_allocatable_sites);
     printf("Eliminated retain/release pairs: %zu\n", stats.eliminated_retain_release_pairs);
+    printf("Thread-escaping sites: %zu\n", stats.thread_escaping_sites);
     printf("Stack allocation ratio: %.2f%%\n", stats.stack_allocation_ratio * 100);
     printf("Optimization ratio: %.2f%%\n", stats.optimization_ratio * 100);
     printf("==================================\n");
@@ -283,6 +346,7 @@ void wyn_escape_reset(void) {
     g_escape_context.total_sites = 0;
     g_escape_context.stack_allocatable_sites = 0;
     g_escape_context.eliminated_retain_release_pairs = 0;
+    g_escape_context.thread_escaping_sites = 0;
     
     pthread_mutex_unlock(&g_escape_context.lock);
 }
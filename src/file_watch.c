@@ -1,52 +1,196 @@
 // File watching implementation
+// inotify on Linux: each watched file's directory is watched, since editors
+// often save by writing a new file and renaming it over the old one, which
+// a watch on the file itself would lose. Elsewhere files are polled.
 #define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <time.h>
 #include "file_watch.h"
 
+#ifdef __linux__
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#define WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ATTRIB)
+#elif defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#define POLL_INTERVAL_MS 200
+#define SETTLE_MS 30        // editors often touch a file several times per save
+
+static long mtime_ns(const struct stat* st) {
+#if defined(__APPLE__)
+    return st->st_mtimespec.tv_nsec;
+#elif defined(_WIN32)
+    (void)st;
+    return 0;
+#else
+    return st->st_mtim.tv_nsec;
+#endif
+}
+
+// Re-stat a file and set its changed flag if it is not what was seen last
+static int refresh(WatchedFile* file) {
+    struct stat st;
+    if (stat(file->path, &st) != 0) return 0;   // mid-replace; its new version will show up
+
+    if (st.st_mtime == file->last_modified && mtime_ns(&st) == file->last_modified_ns &&
+        (long long)st.st_size == file->size && (unsigned long long)st.st_ino == file->inode) {
+        return 0;
+    }
+    file->last_modified = st.st_mtime;
+    file->last_modified_ns = mtime_ns(&st);
+    file->size = (long long)st.st_size;
+    file->inode = (unsigned long long)st.st_ino;
+    file->changed = 1;
+    return 1;
+}
+
 FileWatcher* file_watcher_create() {
     FileWatcher* watcher = malloc(sizeof(FileWatcher));
     watcher->files = malloc(sizeof(WatchedFile) * 16);
+    watcher->dir_watches = malloc(sizeof(int) * 16);
     watcher->count = 0;
     watcher->capacity = 16;
+#ifdef __linux__
+    watcher->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#else
+    watcher->inotify_fd = -1;
+#endif
     return watcher;
 }
 
 void file_watcher_add(FileWatcher* watcher, const char* path) {
+    for (int i = 0; i < watcher->count; i++) {
+        if (strcmp(watcher->files[i].path, path) == 0) return;
+    }
     if (watcher->count >= watcher->capacity) {
         watcher->capacity *= 2;
         watcher->files = realloc(watcher->files, sizeof(WatchedFile) * watcher->capacity);
+        watcher->dir_watches = realloc(watcher->dir_watches, sizeof(int) * watcher->capacity);
     }
-    
+
     struct stat st;
     if (stat(path, &st) != 0) return;
-    
-    watcher->files[watcher->count].path = strdup(path);
-    watcher->files[watcher->count].last_modified = st.st_mtime;
+
+    WatchedFile* file = &watcher->files[watcher->count];
+    file->path = strdup(path);
+    file->last_modified = st.st_mtime;
+    file->last_modified_ns = mtime_ns(&st);
+    file->size = (long long)st.st_size;
+    file->inode = (unsigned long long)st.st_ino;
+    file->changed = 0;
+    watcher->dir_watches[watcher->count] = -1;
+
+#ifdef __linux__
+    if (watcher->inotify_fd >= 0) {
+        // Adding a directory that is already watched returns its existing descriptor
+        char dir[1024];
+        const char* slash = strrchr(path, '/');
+        if (slash) snprintf(dir, sizeof(dir), "%.*s", (int)(slash - path), path);
+        else strcpy(dir, ".");
+        if (dir[0] == '\0') strcpy(dir, "/");
+        watcher->dir_watches[watcher->count] = inotify_add_watch(watcher->inotify_fd, dir, WATCH_EVENTS);
+    }
+#endif
     watcher->count++;
 }
 
 int file_watcher_check(FileWatcher* watcher) {
+    return file_watcher_wait(watcher, 0);
+}
+
+#ifdef __linux__
+// Reads pending events and re-stats the files they name. Returns how many
+// changed, or -1 if no events were pending.
+static int drain_events(FileWatcher* watcher) {
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
     int changed = 0;
-    for (int i = 0; i < watcher->count; i++) {
-        struct stat st;
-        if (stat(watcher->files[i].path, &st) != 0) continue;
-        
-        if (st.st_mtime > watcher->files[i].last_modified) {
-            watcher->files[i].last_modified = st.st_mtime;
-            changed = 1;
+    int any = 0;
+    for (;;) {
+        ssize_t len = read(watcher->inotify_fd, buf, sizeof(buf));
+        if (len <= 0) break;
+        any = 1;
+        for (char* p = buf; p < buf + len; ) {
+            struct inotify_event* ev = (struct inotify_event*)p;
+            p += sizeof(struct inotify_event) + ev->len;
+            if (ev->len == 0) continue;
+            for (int i = 0; i < watcher->count; i++) {
+                if (watcher->dir_watches[i] != ev->wd) continue;
+                const char* slash = strrchr(watcher->files[i].path, '/');
+                const char* base = slash ? slash + 1 : watcher->files[i].path;
+                if (strcmp(base, ev->name) == 0) changed += refresh(&watcher->files[i]);
+            }
         }
     }
+    return any ? changed : -1;
+}
+#endif
+
+static int poll_files(FileWatcher* watcher) {
+    int changed = 0;
+    for (int i = 0; i < watcher->count; i++) {
+        changed += refresh(&watcher->files[i]);
+    }
     return changed;
 }
 
+static void sleep_ms(int ms) {
+#ifdef _WIN32
+    Sleep(ms);
+#else
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+#endif
+}
+
+int file_watcher_wait(FileWatcher* watcher, int timeout_ms) {
+#ifdef __linux__
+    if (watcher->inotify_fd >= 0) {
+        struct pollfd pfd = { .fd = watcher->inotify_fd, .events = POLLIN };
+        for (;;) {
+            if (poll(&pfd, 1, timeout_ms) <= 0) return 0;
+            int changed = drain_events(watcher);
+            if (changed <= 0) {
+                // Events for other files in the same directories
+                if (timeout_ms == 0) return 0;
+                continue;
+            }
+            // Let the rest of a multi-step save land before reporting
+            while (poll(&pfd, 1, SETTLE_MS) > 0) {
+                int more = drain_events(watcher);
+                if (more > 0) changed += more;
+                else if (more < 0) break;
+            }
+            return changed;
+        }
+    }
+#endif
+    int waited = 0;
+    for (;;) {
+        int changed = poll_files(watcher);
+        if (changed > 0 || timeout_ms == 0) return changed;
+        if (timeout_ms > 0 && waited >= timeout_ms) return 0;
+        sleep_ms(POLL_INTERVAL_MS);
+        waited += POLL_INTERVAL_MS;
+    }
+}
+
 void file_watcher_free(FileWatcher* watcher) {
     if (!watcher) return;
     for (int i = 0; i < watcher->count; i++) {
         free(watcher->files[i].path);
     }
+#ifdef __linux__
+    if (watcher->inotify_fd >= 0) close(watcher->inotify_fd);
+#endif
+    free(watcher->dir_watches);
     free(watcher->files);
     free(watcher);
 }
@@ -4,26 +4,39 @@
 
 #include <time.h>
 
+// A file's identity at the last look: a change to any of these counts as a
+// modification, so same-second edits and editors that replace the file by
+// renaming a new one over it are both seen
 typedef struct {
     char* path;
     time_t last_modified;
+    long last_modified_ns;
+    long long size;
+    unsigned long long inode;
+    int changed;            // set by file_watcher_check/wait, cleared by the caller
 } WatchedFile;
 
 typedef struct {
     WatchedFile* files;
     int count;
     int capacity;
+    int inotify_fd;         // -1 when polling
+    int* dir_watches;       // inotify watch descriptor per file
 } FileWatcher;
 
-// Create file watcher
+// Create file watcher (inotify on Linux, stat() polling elsewhere)
 FileWatcher* file_watcher_create();
 
-// Add file to watch
+// Add file to watch; adding a watched path again does nothing
 void file_watcher_add(FileWatcher* watcher, const char* path);
 
-// Check if any files changed
+// Check if any files changed, without blocking
 int file_watcher_check(FileWatcher* watcher);
 
+// Block until a watched file changes or timeout_ms passes (-1 waits
+// forever). Returns how many files changed; their changed flag is set.
+int file_watcher_wait(FileWatcher* watcher, int timeout_ms);
+
 // Free watcher
 void file_watcher_free(FileWatcher* watcher);
 
@@ -2,6 +2,7 @@
 #include "ast.h"
 #include "memory.h"
 #include "traits.h"
+#include "intern.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -24,6 +25,7 @@ typedef struct TypeConstraint {
 // Generic function registry
 typedef struct GenericFunction {
     Token name;
+    uint32_t name_id;
     Token* type_params;
     int type_param_count;
     TypeConstraint** constraints;  // T3.1.3: Constraints for each type parameter
@@ -34,6 +36,7 @@ typedef struct GenericFunction {
 // T3.1.2: Generic struct registry
 typedef struct GenericStruct {
     Token name;
+    uint32_t name_id;
     Token* type_params;
     int type_param_count;
     TypeConstraint** constraints;  // T3.1.3: Constraints for each type parameter
@@ -44,6 +47,7 @@ typedef struct GenericStruct {
 // T3.1.1: Generic instantiation tracking
 typedef struct GenericInstantiation {
     Token function_name;
+    uint32_t name_id;
     Type** type_args;
     int type_arg_count;
     char* monomorphic_name;  // Generated name like "identity_int"
@@ -53,6 +57,7 @@ typedef struct GenericInstantiation {
 // T4.1: Generic struct instantiation tracking
 typedef struct GenericStructInstantiation {
     Token struct_name;
+    uint32_t name_id;
     Type** type_args;
     int type_arg_count;
     char* monomorphic_name;  // Generated name like "Box_int"
@@ -72,11 +77,10 @@ static GenericStructInstantiation* g_struct_instantiations = NULL;
 // Register a generic function instantiation
 void wyn_register_generic_instantiation(Token func_name, Type** type_args, int type_arg_count) {
     // Check if this instantiation already exists
+    uint32_t name_id = token_name_id(&func_name);
     GenericInstantiation* current = g_instantiations;
     while (current) {
-        if (current->function_name.length == func_name.length &&
-            memcmp(current->function_name.start, func_name.start, func_name.length) == 0 &&
-            current->type_arg_count == type_arg_count) {
+        if (current->name_id == name_id && current->type_arg_count == type_arg_count) {
             
             // Check if type arguments match
             bool types_match = true;
@@ -97,6 +101,7 @@ void wyn_register_generic_instantiation(Token func_name, Type** type_args, int t
     // Create new instantiation
     GenericInstantiation* inst = malloc(sizeof(GenericInstantiation));
     inst->function_name = func_name;
+    inst->name_id = name_id;
     inst->type_arg_count = type_arg_count;
     inst->type_args = malloc(sizeof(Type*) * type_arg_count);
     
@@ -116,11 +121,10 @@ void wyn_register_generic_instantiation(Token func_name, Type** type_args, int t
 // T4.1: Register a generic struct instantiation
 void wyn_register_generic_struct_instantiation(Token struct_name, Type** type_args, int type_arg_count) {
     // Check if this instantiation already exists
+    uint32_t name_id = token_name_id(&struct_name);
     GenericStructInstantiation* current = g_struct_instantiations;
     while (current) {
-        if (current->struct_name.length == struct_name.length &&
-            memcmp(current->struct_name.start, struct_name.start, struct_name.length) == 0 &&
-            current->type_arg_count == type_arg_count) {
+        if (current->name_id == name_id && current->type_arg_count == type_arg_count) {
             
             // Check if type arguments match
             bool types_match = true;
@@ -141,6 +145,7 @@ void wyn_register_generic_struct_instantiation(Token struct_name, Type** type_ar
     // Create new struct instantiation
     GenericStructInstantiation* inst = malloc(sizeof(GenericStructInstantiation));
     inst->struct_name = struct_name;
+    inst->name_id = name_id;
     inst->type_arg_count = type_arg_count;
     inst->type_args = malloc(sizeof(Type*) * type_arg_count);
     
@@ -165,6 +170,7 @@ void wyn_register_generic_struct_instantiation(Token struct_name, Type** type_ar
             new_name.start = inst->monomorphic_name;
             new_name.length = strlen(inst->monomorphic_name);
             new_name.line = struct_name.line;
+            new_name.id = 0;
             inst->monomorphic_struct->name = new_name;
         }
     } else {
@@ -259,11 +265,11 @@ TypeConstraint** wyn_parse_where_constraints(Token* type_params, int type_param_
         
         // Example: Add Display constraint to first type parameter
         if (i == 0) {
-            Token display_trait = {TOKEN_IDENT, "Display", 7, 0};
+            Token display_trait = {TOKEN_IDENT, "Display", 7, 0, 0};
             constraints[i] = wyn_create_constraint(display_trait);
             
             // Example: Add Debug constraint as well (T: Display + Debug)
-            Token debug_trait = {TOKEN_IDENT, "Debug", 5, 0};
+            Token debug_trait = {TOKEN_IDENT, "Debug", 5, 0, 0};
             constraints[i] = wyn_add_constraint(constraints[i], debug_trait);
         }
     }
@@ -359,6 +365,7 @@ void wyn_register_generic_function(void* fn_ptr) {
     if (!generic_fn) return;
     
     generic_fn->name = fn->name;
+    generic_fn->name_id = token_name_id(&fn->name);
     generic_fn->type_params = fn->type_params;
     generic_fn->type_param_count = fn->type_param_count;
     generic_fn->original_fn = fn;
@@ -373,10 +380,11 @@ void wyn_register_generic_function(void* fn_ptr) {
 
 // Find a generic function by name
 GenericFunction* wyn_find_generic_function(Token name) {
+    if (!g_generic_functions) return NULL;
+    uint32_t name_id = token_name_id(&name);
     GenericFunction* current = g_generic_functions;
     while (current) {
-        if (current->name.length == name.length &&
-            memcmp(current->name.start, name.start, name.length) == 0) {
+        if (current->name_id == name_id) {
             return current;
         }
         current = current->next;
@@ -394,6 +402,7 @@ Type* wyn_instantiate_generic_function(const char* name, Type** type_args, int a
     Token name_token;
     name_token.start = name;
     name_token.length = strlen(name);
+    name_token.id = 0;
     // Note: lexeme field doesn't exist in Token, using start instead
     
     // Find the generic function
@@ -428,6 +437,7 @@ void wyn_register_generic_struct(void* struct_ptr) {
     if (!generic_struct) return;
     
     generic_struct->name = struct_stmt->name;
+    generic_struct->name_id = token_name_id(&struct_stmt->name);
     generic_struct->type_params = struct_stmt->type_params;
     generic_struct->type_param_count = struct_stmt->type_param_count;
     generic_struct->original_struct = struct_stmt;
@@ -442,10 +452,11 @@ void wyn_register_generic_struct(void* struct_ptr) {
 
 // T3.1.2: Find a generic struct by name
 GenericStruct* wyn_find_generic_struct(Token name) {
+    if (!g_generic_structs) return NULL;
+    uint32_t name_id = token_name_id(&name);
     GenericStruct* current = g_generic_structs;
     while (current) {
-        if (current->name.length == name.length &&
-            memcmp(current->name.start, name.start, name.length) == 0) {
+        if (current->name_id == name_id) {
             return current;
         }
         current = current->next;
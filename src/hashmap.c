@@ -1,138 +1,430 @@
 #define _POSIX_C_SOURCE 200809L
 #include "hashmap.h"
+#include "arc_runtime.h"
+#include "string_runtime.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define HASHMAP_SIZE 128
+// Open addressing with Robin Hood probing: each slot records how far it sits
+// from its home bucket, inserts displace entries that are closer to home, and
+// removals shift the following run back, so probe sequences stay short even at
+// high load. The full hash is cached in the slot; lookups compare it before
+// touching the key, and growth reinserts without rehashing.
+//
+// Maps are reference counted so they can be shared (hashmap_retain/release).
+// Only maps handed to another thread (hashmap_share, or every map after
+// wyn_arc_share_all) take the reader-writer lock and count atomically; maps
+// one thread owns never touch it, even once spawn workers exist. Maps, slot tables, long
+// keys and string values all come from the size-class pool.
 
-typedef struct Entry {
-    char* key;
+#define HASHMAP_MIN_CAPACITY 16
+#define HASHMAP_INLINE_KEY 16            // Keys shorter than this live in the slot
+#define HASHMAP_INT_KEY_LEN UINT32_MAX   // key_len marker for integer keys
+
+typedef struct {
+    uint64_t hash;
+    uint32_t dist;      // Probe distance + 1; 0 marks an empty slot
+    uint32_t key_len;   // String length, or HASHMAP_INT_KEY_LEN
+    union {
+        long long as_int;
+        char* heap;
+        char inline_key[HASHMAP_INLINE_KEY];
+    } key;
     HashMapValue value;
-    struct Entry* next;
-} Entry;
+} Slot;
 
 struct WynHashMap {
-    Entry* buckets[HASHMAP_SIZE];
+    Slot* slots;
+    size_t capacity;    // Always a power of two
+    size_t count;
+    _Atomic uint32_t refcount;  // Counted like WynObject, ARC_SHARED_FLAG included
+    pthread_rwlock_t lock;
 };
 
-static unsigned int hash(const char* key) {
-    unsigned int h = 0;
-    while (*key) {
-        h = h * 31 + *key++;
-    }
-    return h % HASHMAP_SIZE;
+static inline bool map_shared(WynHashMap* map) {
+    return wyn_arc_count_shared(atomic_load_explicit(&map->refcount, memory_order_relaxed));
 }
 
-WynHashMap* hashmap_new(void) {
-    WynHashMap* map = calloc(1, sizeof(WynHashMap));
-    return map;
+static inline bool lock_read(WynHashMap* map) {
+    if (!map_shared(map)) return false;
+    pthread_rwlock_rdlock(&map->lock);
+    return true;
 }
 
-void hashmap_insert_int(WynHashMap* map, const char* key, int value) {
-    unsigned int idx = hash(key);
-    Entry* entry = map->buckets[idx];
-    
-    while (entry) {
-        if (strcmp(entry->key, key) == 0) {
-            entry->value.type = HASHMAP_INT;
-            entry->value.value.as_int = value;
-            return;
+static inline bool lock_write(WynHashMap* map) {
+    if (!map_shared(map)) return false;
+    pthread_rwlock_wrlock(&map->lock);
+    return true;
+}
+
+static inline void unlock(WynHashMap* map, bool locked) {
+    if (locked) pthread_rwlock_unlock(&map->lock);
+}
+
+// wyhash (public domain, Wang Yi): fast, and passes SMHasher
+static const uint64_t wy_secret[4] = {
+    0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull
+};
+
+static inline void wy_mum(uint64_t* a, uint64_t* b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32), c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static inline uint64_t wy_mix(uint64_t a, uint64_t b) {
+    wy_mum(&a, &b);
+    return a ^ b;
+}
+
+static inline uint64_t wy_r8(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static inline uint64_t wy_r4(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline uint64_t wy_r3(const uint8_t* p, size_t k) {
+    return ((uint64_t)p[0] << 16) | ((uint64_t)p[k >> 1] << 8) | p[k - 1];
+}
+
+static uint64_t wyhash(const void* key, size_t len, uint64_t seed) {
+    const uint8_t* p = key;
+    uint64_t a, b;
+    seed ^= wy_mix(seed ^ wy_secret[0], wy_secret[1]);
+    if (len <= 16) {
+        if (len >= 4) {
+            a = (wy_r4(p) << 32) | wy_r4(p + ((len >> 3) << 2));
+            b = (wy_r4(p + len - 4) << 32) | wy_r4(p + len - 4 - ((len >> 3) << 2));
+        } else if (len > 0) {
+            a = wy_r3(p, len);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = len;
+        if (i > 48) {
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                seed = wy_mix(wy_r8(p) ^ wy_secret[1], wy_r8(p + 8) ^ seed);
+                see1 = wy_mix(wy_r8(p + 16) ^ wy_secret[2], wy_r8(p + 24) ^ see1);
+                see2 = wy_mix(wy_r8(p + 32) ^ wy_secret[3], wy_r8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
         }
-        entry = entry->next;
+        while (i > 16) {
+            seed = wy_mix(wy_r8(p) ^ wy_secret[1], wy_r8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = wy_r8(p + i - 16);
+        b = wy_r8(p + i - 8);
     }
-    
-    Entry* new_entry = malloc(sizeof(Entry));
-    new_entry->key = strdup(key);
-    new_entry->value.type = HASHMAP_INT;
-    new_entry->value.value.as_int = value;
-    new_entry->next = map->buckets[idx];
-    map->buckets[idx] = new_entry;
+    a ^= wy_secret[1];
+    b ^= seed;
+    wy_mum(&a, &b);
+    return wy_mix(a ^ wy_secret[0] ^ len, b ^ wy_secret[1]);
 }
 
-void hashmap_insert_float(WynHashMap* map, const char* key, double value) {
-    unsigned int idx = hash(key);
-    Entry* entry = map->buckets[idx];
-    
-    while (entry) {
-        if (strcmp(entry->key, key) == 0) {
-            entry->value.type = HASHMAP_FLOAT;
-            entry->value.value.as_float = value;
-            return;
-        }
-        entry = entry->next;
+static inline uint64_t hash_int(long long key) {
+    return wy_mix((uint64_t)key ^ wy_secret[0], wy_secret[1]);
+}
+
+// Lookup key: either a string with its length or an integer
+typedef struct {
+    uint64_t hash;
+    uint32_t len;
+    const char* str;
+    long long num;
+} Key;
+
+static Key string_key(const char* key) {
+    Key k;
+    size_t len = strlen(key);
+    k.len = len < HASHMAP_INT_KEY_LEN ? (uint32_t)len : HASHMAP_INT_KEY_LEN - 1;
+    k.str = key;
+    k.num = 0;
+    k.hash = wyhash(key, k.len, 0);
+    return k;
+}
+
+static Key int_key(long long key) {
+    Key k;
+    k.len = HASHMAP_INT_KEY_LEN;
+    k.str = NULL;
+    k.num = key;
+    k.hash = hash_int(key);
+    return k;
+}
+
+static inline const char* slot_key(const Slot* slot) {
+    if (slot->key_len == HASHMAP_INT_KEY_LEN) return NULL;
+    return slot->key_len < HASHMAP_INLINE_KEY ? slot->key.inline_key : slot->key.heap;
+}
+
+static inline int slot_matches(const Slot* slot, const Key* k) {
+    if (slot->hash != k->hash || slot->key_len != k->len) return 0;
+    if (k->len == HASHMAP_INT_KEY_LEN) return slot->key.as_int == k->num;
+    return memcmp(slot_key(slot), k->str, k->len) == 0;
+}
+
+static void release_slot(Slot* slot) {
+    if (slot->key_len != HASHMAP_INT_KEY_LEN && slot->key_len >= HASHMAP_INLINE_KEY) {
+        wyn_pool_release(slot->key.heap);
+    }
+    if (slot->value.type == HASHMAP_STRING) {
+        wyn_pool_release(slot->value.value.as_string);
     }
-    
-    Entry* new_entry = malloc(sizeof(Entry));
-    new_entry->key = strdup(key);
-    new_entry->value.type = HASHMAP_FLOAT;
-    new_entry->value.value.as_float = value;
-    new_entry->next = map->buckets[idx];
-    map->buckets[idx] = new_entry;
 }
 
-void hashmap_insert_string(WynHashMap* map, const char* key, const char* value) {
-    unsigned int idx = hash(key);
-    Entry* entry = map->buckets[idx];
-    
-    while (entry) {
-        if (strcmp(entry->key, key) == 0) {
-            if (entry->value.type == HASHMAP_STRING) {
-                free(entry->value.value.as_string);
-            }
-            entry->value.type = HASHMAP_STRING;
-            entry->value.value.as_string = strdup(value);
-            return;
-        }
-        entry = entry->next;
+static Slot* find_slot(WynHashMap* map, const Key* k) {
+    size_t mask = map->capacity - 1;
+    size_t i = (size_t)k->hash & mask;
+    for (uint32_t dist = 1;; dist++) {
+        Slot* slot = &map->slots[i];
+        // An empty slot, or one closer to home than we are, ends the probe
+        if (slot->dist < dist) return NULL;
+        if (slot_matches(slot, k)) return slot;
+        i = (i + 1) & mask;
     }
-    
-    Entry* new_entry = malloc(sizeof(Entry));
-    new_entry->key = strdup(key);
-    new_entry->value.type = HASHMAP_STRING;
-    new_entry->value.value.as_string = strdup(value);
-    new_entry->next = map->buckets[idx];
-    map->buckets[idx] = new_entry;
 }
 
-void hashmap_insert_bool(WynHashMap* map, const char* key, int value) {
-    unsigned int idx = hash(key);
-    Entry* entry = map->buckets[idx];
-    
-    while (entry) {
-        if (strcmp(entry->key, key) == 0) {
-            entry->value.type = HASHMAP_BOOL;
-            entry->value.value.as_bool = value;
-            return;
+// Place an entry known to be absent; returns where it finally landed
+static Slot* place_slot(WynHashMap* map, Slot entry) {
+    size_t mask = map->capacity - 1;
+    size_t i = (size_t)entry.hash & mask;
+    Slot* placed = NULL;
+    entry.dist = 1;
+    for (;;) {
+        Slot* slot = &map->slots[i];
+        if (slot->dist == 0) {
+            *slot = entry;
+            return placed ? placed : slot;
+        }
+        if (slot->dist < entry.dist) {
+            Slot displaced = *slot;
+            *slot = entry;
+            if (!placed) placed = slot;
+            entry = displaced;
         }
-        entry = entry->next;
+        entry.dist++;
+        i = (i + 1) & mask;
     }
-    
-    Entry* new_entry = malloc(sizeof(Entry));
-    new_entry->key = strdup(key);
-    new_entry->value.type = HASHMAP_BOOL;
-    new_entry->value.value.as_bool = value;
-    new_entry->next = map->buckets[idx];
-    map->buckets[idx] = new_entry;
 }
 
-HashMapValue hashmap_get(WynHashMap* map, const char* key) {
-    unsigned int idx = hash(key);
-    Entry* entry = map->buckets[idx];
-    
-    while (entry) {
-        if (strcmp(entry->key, key) == 0) {
-            return entry->value;
-        }
-        entry = entry->next;
+static int resize(WynHashMap* map, size_t new_capacity) {
+    Slot* old_slots = map->slots;
+    size_t old_capacity = map->capacity;
+    Slot* slots = wyn_pool_calloc(new_capacity, sizeof(Slot));
+    if (!slots) return 0;
+    map->slots = slots;
+    map->capacity = new_capacity;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_slots[i].dist != 0) place_slot(map, old_slots[i]);
     }
-    
-    // Return default value (int 0) if not found
+    wyn_pool_release(old_slots);
+    return 1;
+}
+
+// Find the slot for k, creating an empty-valued entry if it is missing.
+// Returns NULL only on allocation failure.
+static Slot* upsert_slot(WynHashMap* map, const Key* k) {
+    Slot* slot = find_slot(map, k);
+    if (slot) return slot;
+
+    // Keep the load factor at or below 7/8
+    if ((map->count + 1) * 8 > map->capacity * 7) {
+        if (!resize(map, map->capacity * 2)) return NULL;
+    }
+
+    Slot entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.hash = k->hash;
+    entry.key_len = k->len;
+    if (k->len == HASHMAP_INT_KEY_LEN) {
+        entry.key.as_int = k->num;
+    } else if (k->len < HASHMAP_INLINE_KEY) {
+        memcpy(entry.key.inline_key, k->str, k->len);
+        entry.key.inline_key[k->len] = '\0';
+    } else {
+        entry.key.heap = wyn_pool_alloc((size_t)k->len + 1);
+        if (!entry.key.heap) return NULL;
+        memcpy(entry.key.heap, k->str, k->len);
+        entry.key.heap[k->len] = '\0';
+    }
+    entry.value.type = HASHMAP_INT;
+    map->count++;
+    return place_slot(map, entry);
+}
+
+static void remove_key(WynHashMap* map, const Key* k) {
+    Slot* slot = find_slot(map, k);
+    if (!slot) return;
+    release_slot(slot);
+
+    // Backward-shift the rest of the run so no tombstones are needed
+    size_t mask = map->capacity - 1;
+    size_t i = (size_t)(slot - map->slots);
+    size_t next = (i + 1) & mask;
+    while (map->slots[next].dist > 1) {
+        map->slots[i] = map->slots[next];
+        map->slots[i].dist--;
+        i = next;
+        next = (next + 1) & mask;
+    }
+    memset(&map->slots[i], 0, sizeof(Slot));
+    map->count--;
+}
+
+static HashMapValue copy_value(HashMapValue value) {
+    if (value.type == HASHMAP_STRING) {
+        const char* text = value.value.as_string ? value.value.as_string : "";
+        size_t len = strlen(text);
+        value.value.as_string = wyn_pool_alloc(len + 1);
+        if (value.value.as_string) memcpy(value.value.as_string, text, len + 1);
+    }
+    return value;
+}
+
+static void store_value(WynHashMap* map, const Key* k, HashMapValue value) {
+    bool locked = lock_write(map);
+    // Copy before touching the slot: value may be the very string being
+    // replaced, as in m[k] = m[k]
+    HashMapValue stored = copy_value(value);
+    Slot* slot = upsert_slot(map, k);
+    HashMapValue old = stored;
+    if (slot) {
+        old = slot->value;
+        slot->value = stored;
+    }
+    if (old.type == HASHMAP_STRING) wyn_pool_release(old.value.as_string);
+    unlock(map, locked);
+}
+
+// Copies a string value while the lock is held: another thread may replace
+// the slot's string once it is dropped
+static char* get_string(WynHashMap* map, const Key* k) {
+    bool locked = lock_read(map);
+    Slot* slot = find_slot(map, k);
+    const char* copy = "";
+    if (slot && slot->value.type == HASHMAP_STRING && slot->value.value.as_string) {
+        const char* text = slot->value.value.as_string;
+        copy = wyn_str_new(text, strlen(text));
+    }
+    unlock(map, locked);
+    return (char*)copy;
+}
+
+static HashMapValue missing_value(void) {
+    // Return default value (int -1) if not found
     HashMapValue default_val;
     default_val.type = HASHMAP_INT;
     default_val.value.as_int = -1;
     return default_val;
 }
 
+WynHashMap* hashmap_with_capacity(size_t capacity) {
+    WynHashMap* map = wyn_pool_calloc(1, sizeof(WynHashMap));
+    if (!map) return NULL;
+    // Room for capacity entries without growing
+    size_t slots = HASHMAP_MIN_CAPACITY;
+    while (slots * 7 < capacity * 8) slots *= 2;
+    map->slots = wyn_pool_calloc(slots, sizeof(Slot));
+    if (!map->slots) {
+        wyn_pool_release(map);
+        return NULL;
+    }
+    map->capacity = slots;
+    atomic_init(&map->refcount, 1);
+    pthread_rwlock_init(&map->lock, NULL);
+    return map;
+}
+
+WynHashMap* hashmap_new(void) {
+    return hashmap_with_capacity(0);
+}
+
+WynHashMap* hashmap_retain(WynHashMap* map) {
+    if (map) wyn_arc_count_retain(&map->refcount);
+    return map;
+}
+
+void hashmap_release(WynHashMap* map) {
+    if (!map) return;
+    if (wyn_arc_count_release(&map->refcount)) {
+        hashmap_free(map);
+    }
+}
+
+WynHashMap* hashmap_share(WynHashMap* map) {
+    if (map) wyn_arc_count_share(&map->refcount);
+    return map;
+}
+
+void hashmap_insert_value(WynHashMap* map, const char* key, HashMapValue value) {
+    Key k = string_key(key);
+    store_value(map, &k, value);
+}
+
+void hashmap_insert_int(WynHashMap* map, const char* key, int value) {
+    HashMapValue v;
+    v.type = HASHMAP_INT;
+    v.value.as_int = value;
+    hashmap_insert_value(map, key, v);
+}
+
+void hashmap_insert_float(WynHashMap* map, const char* key, double value) {
+    HashMapValue v;
+    v.type = HASHMAP_FLOAT;
+    v.value.as_float = value;
+    hashmap_insert_value(map, key, v);
+}
+
+void hashmap_insert_string(WynHashMap* map, const char* key, const char* value) {
+    HashMapValue v;
+    v.type = HASHMAP_STRING;
+    v.value.as_string = (char*)value;
+    hashmap_insert_value(map, key, v);
+}
+
+void hashmap_insert_bool(WynHashMap* map, const char* key, int value) {
+    HashMapValue v;
+    v.type = HASHMAP_BOOL;
+    v.value.as_bool = value;
+    hashmap_insert_value(map, key, v);
+}
+
+HashMapValue hashmap_get(WynHashMap* map, const char* key) {
+    Key k = string_key(key);
+    bool locked = lock_read(map);
+    Slot* slot = find_slot(map, &k);
+    HashMapValue value = slot ? slot->value : missing_value();
+    unlock(map, locked);
+    return value;
+}
+
 int hashmap_get_int(WynHashMap* map, const char* key) {
     HashMapValue val = hashmap_get(map, key);
     if (val.type == HASHMAP_INT) {
@@ -150,11 +442,8 @@ double hashmap_get_float(WynHashMap* map, const char* key) {
 }
 
 char* hashmap_get_string(WynHashMap* map, const char* key) {
-    HashMapValue val = hashmap_get(map, key);
-    if (val.type == HASHMAP_STRING) {
-        return val.value.as_string;
-    }
-    return "";
+    Key k = string_key(key);
+    return get_string(map, &k);
 }
 
 int hashmap_get_bool(WynHashMap* map, const char* key) {
@@ -166,69 +455,150 @@ int hashmap_get_bool(WynHashMap* map, const char* key) {
 }
 
 int hashmap_has(WynHashMap* map, const char* key) {
-    unsigned int idx = hash(key);
-    Entry* entry = map->buckets[idx];
-    
-    while (entry) {
-        if (strcmp(entry->key, key) == 0) {
-            return 1;
-        }
-        entry = entry->next;
-    }
-    
-    return 0;
+    Key k = string_key(key);
+    bool locked = lock_read(map);
+    int found = find_slot(map, &k) != NULL;
+    unlock(map, locked);
+    return found;
 }
 
 void hashmap_remove(WynHashMap* map, const char* key) {
-    unsigned int idx = hash(key);
-    Entry* entry = map->buckets[idx];
-    Entry* prev = NULL;
-    
-    while (entry) {
-        if (strcmp(entry->key, key) == 0) {
-            if (prev) {
-                prev->next = entry->next;
-            } else {
-                map->buckets[idx] = entry->next;
-            }
-            free(entry->key);
-            if (entry->value.type == HASHMAP_STRING) {
-                free(entry->value.value.as_string);
-            }
-            free(entry);
-            return;
-        }
-        prev = entry;
-        entry = entry->next;
-    }
+    Key k = string_key(key);
+    bool locked = lock_write(map);
+    remove_key(map, &k);
+    unlock(map, locked);
 }
 
 int hashmap_len(WynHashMap* map) {
-    int count = 0;
-    for (int i = 0; i < HASHMAP_SIZE; i++) {
-        Entry* entry = map->buckets[i];
-        while (entry) {
-            count++;
-            entry = entry->next;
-        }
-    }
+    bool locked = lock_read(map);
+    int count = (int)map->count;
+    unlock(map, locked);
     return count;
 }
 
+static void clear_slots(WynHashMap* map) {
+    for (size_t i = 0; i < map->capacity; i++) {
+        if (map->slots[i].dist != 0) release_slot(&map->slots[i]);
+    }
+    memset(map->slots, 0, map->capacity * sizeof(Slot));
+    map->count = 0;
+}
+
+void hashmap_clear(WynHashMap* map) {
+    bool locked = lock_write(map);
+    clear_slots(map);
+    unlock(map, locked);
+}
+
+// Frees immediately regardless of other references; shared maps use hashmap_release
 void hashmap_free(WynHashMap* map) {
-    for (int i = 0; i < HASHMAP_SIZE; i++) {
-        Entry* entry = map->buckets[i];
-        while (entry) {
-            Entry* next = entry->next;
-            free(entry->key);
-            if (entry->value.type == HASHMAP_STRING) {
-                free(entry->value.value.as_string);
-            }
-            free(entry);
-            entry = next;
-        }
+    if (!map) return;
+    clear_slots(map);
+    pthread_rwlock_destroy(&map->lock);
+    wyn_pool_release(map->slots);
+    wyn_pool_release(map);
+}
+
+void hashmap_insert_value_int_key(WynHashMap* map, long long key, HashMapValue value) {
+    Key k = int_key(key);
+    store_value(map, &k, value);
+}
+
+void hashmap_insert_int_key(WynHashMap* map, long long key, int value) {
+    HashMapValue v;
+    v.type = HASHMAP_INT;
+    v.value.as_int = value;
+    hashmap_insert_value_int_key(map, key, v);
+}
+
+HashMapValue hashmap_get_value_int_key(WynHashMap* map, long long key) {
+    Key k = int_key(key);
+    bool locked = lock_read(map);
+    Slot* slot = find_slot(map, &k);
+    HashMapValue value = slot ? slot->value : missing_value();
+    unlock(map, locked);
+    return value;
+}
+
+void hashmap_insert_float_int_key(WynHashMap* map, long long key, double value) {
+    HashMapValue v;
+    v.type = HASHMAP_FLOAT;
+    v.value.as_float = value;
+    hashmap_insert_value_int_key(map, key, v);
+}
+
+void hashmap_insert_string_int_key(WynHashMap* map, long long key, const char* value) {
+    HashMapValue v;
+    v.type = HASHMAP_STRING;
+    v.value.as_string = (char*)value;
+    hashmap_insert_value_int_key(map, key, v);
+}
+
+void hashmap_insert_bool_int_key(WynHashMap* map, long long key, int value) {
+    HashMapValue v;
+    v.type = HASHMAP_BOOL;
+    v.value.as_bool = value;
+    hashmap_insert_value_int_key(map, key, v);
+}
+
+int hashmap_get_int_key(WynHashMap* map, long long key) {
+    HashMapValue val = hashmap_get_value_int_key(map, key);
+    if (val.type == HASHMAP_INT) {
+        return val.value.as_int;
+    }
+    return -1;
+}
+
+double hashmap_get_float_int_key(WynHashMap* map, long long key) {
+    HashMapValue val = hashmap_get_value_int_key(map, key);
+    if (val.type == HASHMAP_FLOAT) {
+        return val.value.as_float;
+    }
+    return 0.0;
+}
+
+char* hashmap_get_string_int_key(WynHashMap* map, long long key) {
+    Key k = int_key(key);
+    return get_string(map, &k);
+}
+
+int hashmap_get_bool_int_key(WynHashMap* map, long long key) {
+    HashMapValue val = hashmap_get_value_int_key(map, key);
+    if (val.type == HASHMAP_BOOL) {
+        return val.value.as_bool;
+    }
+    return 0;
+}
+
+int hashmap_has_int_key(WynHashMap* map, long long key) {
+    Key k = int_key(key);
+    bool locked = lock_read(map);
+    int found = find_slot(map, &k) != NULL;
+    unlock(map, locked);
+    return found;
+}
+
+void hashmap_remove_int_key(WynHashMap* map, long long key) {
+    Key k = int_key(key);
+    bool locked = lock_write(map);
+    remove_key(map, &k);
+    unlock(map, locked);
+}
+
+int hashmap_next(WynHashMap* map, size_t* iter, HashMapEntry* entry) {
+    bool locked = lock_read(map);
+    int found = 0;
+    while (*iter < map->capacity) {
+        Slot* slot = &map->slots[(*iter)++];
+        if (slot->dist == 0) continue;
+        entry->key = slot_key(slot);
+        entry->int_key = slot->key_len == HASHMAP_INT_KEY_LEN ? slot->key.as_int : 0;
+        entry->value = slot->value;
+        found = 1;
+        break;
     }
-    free(map);
+    unlock(map, locked);
+    return found;
 }
 
 // Legacy compatibility
@@ -24,7 +24,15 @@ typedef struct {
     } value;
 } HashMapValue;
 
+// One entry as seen by hashmap_next; key is NULL for integer keys
+typedef struct {
+    const char* key;
+    long long int_key;
+    HashMapValue value;
+} HashMapEntry;
+
 WynHashMap* hashmap_new(void);
+WynHashMap* hashmap_with_capacity(size_t capacity);
 
 // Type-specific insert functions
 void hashmap_insert_int(WynHashMap* map, const char* key, int value);
@@ -32,10 +40,14 @@ void hashmap_insert_float(WynHashMap* map, const char* key, double value);
 void hashmap_insert_string(WynHashMap* map, const char* key, const char* value);
 void hashmap_insert_bool(WynHashMap* map, const char* key, int value);
 
-// Generic get (returns HashMapValue)
+// Generic insert; string values are copied
+void hashmap_insert_value(WynHashMap* map, const char* key, HashMapValue value);
+
+// Generic get (returns HashMapValue). A string value points into the map;
+// use hashmap_get_string for a copy that outlives concurrent writes.
 HashMapValue hashmap_get(WynHashMap* map, const char* key);
 
-// Type-specific get functions
+// Type-specific get functions; hashmap_get_string returns a new string
 int hashmap_get_int(WynHashMap* map, const char* key);
 double hashmap_get_float(WynHashMap* map, const char* key);
 char* hashmap_get_string(WynHashMap* map, const char* key);
@@ -44,8 +56,35 @@ int hashmap_get_bool(WynHashMap* map, const char* key);
 void hashmap_remove(WynHashMap* map, const char* key);
 int hashmap_has(WynHashMap* map, const char* key);
 int hashmap_len(WynHashMap* map);
+void hashmap_clear(WynHashMap* map);
 void hashmap_free(WynHashMap* map);
 
+// Reference counting for maps shared between owners or spawns; the last
+// release frees the map
+WynHashMap* hashmap_retain(WynHashMap* map);
+void hashmap_release(WynHashMap* map);
+// Marks a map as reachable from another thread: from then on every operation
+// on it takes its lock
+WynHashMap* hashmap_share(WynHashMap* map);
+
+// Integer keys, hashed directly instead of being formatted as strings
+void hashmap_insert_int_key(WynHashMap* map, long long key, int value);
+void hashmap_insert_float_int_key(WynHashMap* map, long long key, double value);
+void hashmap_insert_string_int_key(WynHashMap* map, long long key, const char* value);
+void hashmap_insert_bool_int_key(WynHashMap* map, long long key, int value);
+void hashmap_insert_value_int_key(WynHashMap* map, long long key, HashMapValue value);
+HashMapValue hashmap_get_value_int_key(WynHashMap* map, long long key);
+int hashmap_get_int_key(WynHashMap* map, long long key);
+double hashmap_get_float_int_key(WynHashMap* map, long long key);
+char* hashmap_get_string_int_key(WynHashMap* map, long long key);
+int hashmap_get_bool_int_key(WynHashMap* map, long long key);
+int hashmap_has_int_key(WynHashMap* map, long long key);
+void hashmap_remove_int_key(WynHashMap* map, long long key);
+
+// Iteration: start with *iter = 0; returns 0 when there are no more entries.
+// The map must not be modified while iterating.
+int hashmap_next(WynHashMap* map, size_t* iter, HashMapEntry* entry);
+
 // Legacy compatibility (defaults to int)
 void hashmap_insert(WynHashMap* map, const char* key, int value);
 
@@ -1,5 +1,6 @@
 #define _POSIX_C_SOURCE 200809L
 #include "hashset.h"
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -12,6 +13,7 @@ typedef struct Entry {
 
 struct WynHashSet {
     Entry* buckets[HASHSET_SIZE];
+    _Atomic int refcount;
 };
 
 static unsigned int hash(const char* key) {
@@ -24,9 +26,22 @@ static unsigned int hash(const char* key) {
 
 WynHashSet* hashset_new(void) {
     WynHashSet* set = calloc(1, sizeof(WynHashSet));
+    if (set) atomic_init(&set->refcount, 1);
     return set;
 }
 
+WynHashSet* hashset_retain(WynHashSet* set) {
+    if (set) atomic_fetch_add_explicit(&set->refcount, 1, memory_order_relaxed);
+    return set;
+}
+
+void hashset_release(WynHashSet* set) {
+    if (!set) return;
+    if (atomic_fetch_sub_explicit(&set->refcount, 1, memory_order_acq_rel) == 1) {
+        hashset_free(set);
+    }
+}
+
 void hashset_add(WynHashSet* set, const char* key) {
     unsigned int idx = hash(key);
     Entry* entry = set->buckets[idx];
@@ -9,6 +9,10 @@ int hashset_contains(WynHashSet* set, const char* key);
 void hashset_remove(WynHashSet* set, const char* key);
 void hashset_free(WynHashSet* set);
 
+// Reference counting; the last release frees the set
+WynHashSet* hashset_retain(WynHashSet* set);
+void hashset_release(WynHashSet* set);
+
 // Wrapper functions
 void wyn_hashset_insert(WynHashSet* set, const char* key);
 int wyn_hashset_contains(WynHashSet* set, const char* key);
@@ -0,0 +1,758 @@
+// HTTP/1.1 client for Wyn programs
+// Keep-alive connection pool, cached host lookups, chunked and
+// Content-Length bodies, and request pipelining.
+
+#define _GNU_SOURCE
+#include "http_client.h"
+#include "net.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+
+#define HTTP_IO_TIMEOUT_SEC 30
+#define HTTP_IDLE_TIMEOUT_SEC 60
+#define HTTP_DNS_CACHE_SIZE 64
+
+static int pool_limit = 8;
+static int dns_ttl = 60;
+
+static time_t monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+static void set_error(char* error, size_t error_len, const char* fmt, ...) {
+    if (!error || error_len == 0) return;
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(error, error_len, fmt, args);
+    va_end(args);
+}
+
+// ============================================================================
+// Growable byte buffer
+// ============================================================================
+
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+} HttpBuf;
+
+static int buf_reserve(HttpBuf* buf, size_t extra) {
+    if (buf->len + extra + 1 <= buf->cap) return 0;
+    size_t cap = buf->cap ? buf->cap : 256;
+    while (cap < buf->len + extra + 1) cap *= 2;
+    char* data = realloc(buf->data, cap);
+    if (!data) return -1;
+    buf->data = data;
+    buf->cap = cap;
+    return 0;
+}
+
+static int buf_append(HttpBuf* buf, const char* data, size_t len) {
+    if (buf_reserve(buf, len) < 0) return -1;
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+    buf->data[buf->len] = '\0';
+    return 0;
+}
+
+static int buf_printf(HttpBuf* buf, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(NULL, 0, fmt, args);
+    va_end(args);
+    if (n < 0 || buf_reserve(buf, (size_t)n) < 0) return -1;
+    va_start(args, fmt);
+    vsnprintf(buf->data + buf->len, (size_t)n + 1, fmt, args);
+    va_end(args);
+    buf->len += (size_t)n;
+    return 0;
+}
+
+// ============================================================================
+// URLs and headers
+// ============================================================================
+
+typedef struct {
+    char host[256];
+    int port;
+    const char* path;   // into the URL; may start with '?' or be empty
+} HttpTarget;
+
+static int parse_url(const char* url, HttpTarget* target, char* error, size_t error_len) {
+    if (!url) {
+        set_error(error, error_len, "No URL");
+        return -1;
+    }
+    if (strncmp(url, "https://", 8) == 0) {
+        set_error(error, error_len, "HTTPS not supported yet - use http:// instead");
+        return -1;
+    }
+    if (strncmp(url, "http://", 7) == 0) url += 7;
+
+    const char* end = url + strcspn(url, "/?#");
+    const char* colon = memchr(url, ':', (size_t)(end - url));
+    size_t host_len = (size_t)((colon ? colon : end) - url);
+    if (host_len == 0 || host_len >= sizeof(target->host)) {
+        set_error(error, error_len, "Invalid URL: %s", url);
+        return -1;
+    }
+    memcpy(target->host, url, host_len);
+    target->host[host_len] = '\0';
+
+    target->port = 80;
+    if (colon) {
+        char* port_end;
+        long port = strtol(colon + 1, &port_end, 10);
+        if (port_end != end || port <= 0 || port > 65535) {
+            set_error(error, error_len, "Invalid port in URL: %s", url);
+            return -1;
+        }
+        target->port = (int)port;
+    }
+    target->path = end;
+    return 0;
+}
+
+static int same_target(const HttpTarget* a, const HttpTarget* b) {
+    return a->port == b->port && strcmp(a->host, b->host) == 0;
+}
+
+// Value of the first "name:" line in a block of header lines
+static const char* find_header(const char* headers, const char* name, size_t* len_out) {
+    if (!headers) return NULL;
+    size_t name_len = strlen(name);
+    for (const char* line = headers; *line; ) {
+        const char* eol = strchr(line, '\n');
+        size_t line_len = eol ? (size_t)(eol - line) : strlen(line);
+        if (line_len > name_len && line[name_len] == ':' && strncasecmp(line, name, name_len) == 0) {
+            const char* value = line + name_len + 1;
+            const char* value_end = line + line_len;
+            while (value < value_end && (*value == ' ' || *value == '\t')) value++;
+            while (value_end > value && (value_end[-1] == '\r' || value_end[-1] == ' ' || value_end[-1] == '\t')) value_end--;
+            if (len_out) *len_out = (size_t)(value_end - value);
+            return value;
+        }
+        if (!eol) break;
+        line = eol + 1;
+    }
+    return NULL;
+}
+
+static int header_has_token(const char* headers, const char* name, const char* token) {
+    size_t len;
+    const char* value = find_header(headers, name, &len);
+    if (!value) return 0;
+    size_t token_len = strlen(token);
+    for (size_t i = 0; i + token_len <= len; i++) {
+        if (strncasecmp(value + i, token, token_len) == 0) return 1;
+    }
+    return 0;
+}
+
+static int is_idempotent(const char* method) {
+    return strcmp(method, "GET") == 0 || strcmp(method, "HEAD") == 0 || strcmp(method, "PUT") == 0 ||
+           strcmp(method, "DELETE") == 0 || strcmp(method, "OPTIONS") == 0;
+}
+
+static int write_request(HttpBuf* out, const WynHttpRequest* req, const HttpTarget* target) {
+    const char* method = req->method ? req->method : "GET";
+    const char* path = target->path;
+    size_t path_len = strcspn(path, "#");
+
+    int failed = buf_printf(out, "%s %s", method, *path == '/' ? "" : "/");
+    failed |= buf_append(out, path, path_len);
+    if (target->port == 80) {
+        failed |= buf_printf(out, " HTTP/1.1\r\nHost: %s\r\n", target->host);
+    } else {
+        failed |= buf_printf(out, " HTTP/1.1\r\nHost: %s:%d\r\n", target->host, target->port);
+    }
+    if (!find_header(req->headers, "User-Agent", NULL)) failed |= buf_printf(out, "User-Agent: Wyn/1.4\r\n");
+    if (!find_header(req->headers, "Accept", NULL)) failed |= buf_printf(out, "Accept: */*\r\n");
+    if (req->headers) failed |= buf_append(out, req->headers, strlen(req->headers));
+    if (req->body || strcmp(method, "POST") == 0 || strcmp(method, "PUT") == 0) {
+        failed |= buf_printf(out, "Content-Length: %zu\r\n", req->body ? req->body_len : 0);
+    }
+    failed |= buf_append(out, "\r\n", 2);
+    if (req->body) failed |= buf_append(out, req->body, req->body_len);
+    return failed ? -1 : 0;
+}
+
+// ============================================================================
+// Host lookup cache
+// ============================================================================
+
+typedef struct {
+    char host[256];
+    struct in_addr addr;
+    time_t expires;
+} DnsEntry;
+
+static DnsEntry dns_cache[HTTP_DNS_CACHE_SIZE];
+static pthread_mutex_t dns_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int resolve_host(const char* host, struct in_addr* out, char* error, size_t error_len) {
+    if (inet_pton(AF_INET, host, out) == 1) return 0;
+
+    time_t now = monotonic_seconds();
+    pthread_mutex_lock(&dns_lock);
+    for (int i = 0; i < HTTP_DNS_CACHE_SIZE; i++) {
+        if (dns_cache[i].expires > now && strcmp(dns_cache[i].host, host) == 0) {
+            *out = dns_cache[i].addr;
+            pthread_mutex_unlock(&dns_lock);
+            return 0;
+        }
+    }
+    pthread_mutex_unlock(&dns_lock);
+
+    struct addrinfo hints, *result;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, NULL, &hints, &result) != 0 || !result) {
+        set_error(error, error_len, "Host not found: %s", host);
+        return -1;
+    }
+    *out = ((struct sockaddr_in*)result->ai_addr)->sin_addr;
+    freeaddrinfo(result);
+
+    if (dns_ttl > 0) {
+        // Refresh this host's entry, else take a free or the oldest slot
+        pthread_mutex_lock(&dns_lock);
+        DnsEntry* slot = &dns_cache[0];
+        for (int i = 0; i < HTTP_DNS_CACHE_SIZE; i++) {
+            if (strcmp(dns_cache[i].host, host) == 0) {
+                slot = &dns_cache[i];
+                break;
+            }
+            if (dns_cache[i].expires < slot->expires) slot = &dns_cache[i];
+        }
+        snprintf(slot->host, sizeof(slot->host), "%s", host);
+        slot->addr = *out;
+        slot->expires = now + dns_ttl;
+        pthread_mutex_unlock(&dns_lock);
+    }
+    return 0;
+}
+
+// ============================================================================
+// Connection pool
+// ============================================================================
+
+typedef struct HttpConn {
+    int fd;
+    WynReadBuffer input;
+    HttpTarget target;
+    time_t idle_since;
+    int reused;             // came from the pool
+    struct HttpConn* next;
+} HttpConn;
+
+// Idle connections for every host, most recently used first
+static HttpConn* idle_conns = NULL;
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void conn_close(HttpConn* conn) {
+    close(conn->fd);
+    wyn_read_buffer_free(&conn->input);
+    free(conn);
+}
+
+static void conn_close_list(HttpConn* conn) {
+    while (conn) {
+        HttpConn* next = conn->next;
+        conn_close(conn);
+        conn = next;
+    }
+}
+
+// An idle connection the server has closed (or written to unasked) polls
+// readable; so does one past the idle timeout we assume servers apply
+static int conn_is_stale(HttpConn* conn, time_t now) {
+    if (now - conn->idle_since >= HTTP_IDLE_TIMEOUT_SEC) return 1;
+    if (conn->input.end != conn->input.start) return 1;
+    struct pollfd pfd = { conn->fd, POLLIN, 0 };
+    return poll(&pfd, 1, 0) != 0;
+}
+
+static HttpConn* pool_checkout(const HttpTarget* target) {
+    time_t now = monotonic_seconds();
+    HttpConn* found = NULL;
+    HttpConn* stale = NULL;
+
+    pthread_mutex_lock(&pool_lock);
+    for (HttpConn** link = &idle_conns; *link; ) {
+        HttpConn* conn = *link;
+        if (!same_target(&conn->target, target)) {
+            link = &conn->next;
+            continue;
+        }
+        *link = conn->next;
+        if (conn_is_stale(conn, now)) {
+            conn->next = stale;
+            stale = conn;
+            continue;
+        }
+        found = conn;
+        break;
+    }
+    pthread_mutex_unlock(&pool_lock);
+
+    conn_close_list(stale);
+    if (found) {
+        found->next = NULL;
+        found->reused = 1;
+    }
+    return found;
+}
+
+static void pool_checkin(HttpConn* conn) {
+    time_t now = monotonic_seconds();
+    HttpConn* expired = NULL;
+    int same_host = 0;
+    conn->idle_since = now;
+
+    pthread_mutex_lock(&pool_lock);
+    for (HttpConn** link = &idle_conns; *link; ) {
+        HttpConn* idle = *link;
+        if (now - idle->idle_since >= HTTP_IDLE_TIMEOUT_SEC) {
+            *link = idle->next;
+            idle->next = expired;
+            expired = idle;
+            continue;
+        }
+        if (same_target(&idle->target, &conn->target)) same_host++;
+        link = &idle->next;
+    }
+    if (same_host < pool_limit) {
+        conn->next = idle_conns;
+        idle_conns = conn;
+        conn = NULL;
+    }
+    pthread_mutex_unlock(&pool_lock);
+
+    if (conn) conn_close(conn);
+    conn_close_list(expired);
+}
+
+static HttpConn* conn_open(const HttpTarget* target, char* error, size_t error_len) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)target->port);
+    if (resolve_host(target->host, &addr.sin_addr, error, error_len) < 0) return NULL;
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        set_error(error, error_len, "Socket creation failed");
+        return NULL;
+    }
+    struct timeval tv = { HTTP_IO_TIMEOUT_SEC, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    // Each request goes out in one send; don't hold it back for an ACK
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        set_error(error, error_len, "Connection failed: %s:%d", target->host, target->port);
+        return NULL;
+    }
+
+    HttpConn* conn = malloc(sizeof(HttpConn));
+    if (!conn) {
+        close(fd);
+        set_error(error, error_len, "Out of memory");
+        return NULL;
+    }
+    conn->fd = fd;
+    wyn_read_buffer_init(&conn->input);
+    conn->target = *target;
+    conn->idle_since = 0;
+    conn->reused = 0;
+    conn->next = NULL;
+    return conn;
+}
+
+static int send_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// ============================================================================
+// Responses
+// ============================================================================
+
+typedef enum {
+    READ_OK,
+    READ_FAILED,
+    READ_NOTHING    // the connection ended before any of the response arrived
+} ReadResult;
+
+static int deliver(const WynHttpRequest* req, HttpBuf* body, const char* data, size_t len) {
+    if (len == 0) return 0;
+    if (req->sink) return req->sink(req->sink_ctx, data, len) ? -1 : 0;
+    return buf_append(body, data, len);
+}
+
+// Copies exactly len body bytes from the connection, without buffering
+// more than one read of them at a time
+static int read_body_bytes(HttpConn* conn, const WynHttpRequest* req, HttpBuf* body, size_t len) {
+    while (len > 0) {
+        size_t avail;
+        const char* data = wyn_read_buffer_peek(&conn->input, conn->fd, &avail, NULL);
+        if (!data || avail == 0) return -1;
+        if (avail > len) avail = len;
+        if (deliver(req, body, data, avail) < 0) return -1;
+        conn->input.start += avail;
+        len -= avail;
+    }
+    return 0;
+}
+
+static const char* read_line(HttpConn* conn, size_t* len, WynNetError* error) {
+    const char* line = wyn_read_buffer_until(&conn->input, conn->fd, "\n", 1, len, error);
+    if (line && *len > 0 && line[*len - 1] == '\r') (*len)--;
+    return line;
+}
+
+static int read_chunked_body(HttpConn* conn, const WynHttpRequest* req, HttpBuf* body) {
+    for (;;) {
+        size_t len;
+        const char* line = read_line(conn, &len, NULL);
+        if (!line) return -1;
+
+        size_t size = 0;
+        size_t i = 0;
+        for (; i < len; i++) {
+            char c = line[i];
+            int digit = c >= '0' && c <= '9' ? c - '0' :
+                        c >= 'a' && c <= 'f' ? c - 'a' + 10 :
+                        c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+            if (digit < 0) break;
+            if (size > (SIZE_MAX >> 4)) return -1;
+            size = size * 16 + (size_t)digit;
+        }
+        if (i == 0) return -1;
+
+        if (size == 0) {
+            // Trailer fields, up to the blank line
+            do {
+                if (!read_line(conn, &len, NULL)) return -1;
+            } while (len > 0);
+            return 0;
+        }
+        if (read_body_bytes(conn, req, body, size) < 0) return -1;
+        if (!read_line(conn, &len, NULL) || len != 0) return -1;
+    }
+}
+
+static ReadResult read_response(HttpConn* conn, const WynHttpRequest* req, WynHttpResponse** out,
+                                int* keep_alive, char* error, size_t error_len) {
+    const char* method = req->method ? req->method : "GET";
+    HttpBuf headers = {0};
+    int status = 0;
+    int minor = 1;
+    int first = 1;
+
+    // Status line and headers; interim 1xx responses are skipped
+    for (;;) {
+        size_t len;
+        WynNetError net_error;
+        const char* line = read_line(conn, &len, &net_error);
+        if (!line) {
+            free(headers.data);
+            if (first && (net_error == WYN_NET_ERROR_CLOSED || net_error == WYN_NET_ERROR_UNKNOWN)) {
+                set_error(error, error_len, "Connection closed before the response");
+                return READ_NOTHING;
+            }
+            set_error(error, error_len, "Failed to read response: %s", wyn_net_error_string(net_error));
+            return READ_FAILED;
+        }
+        first = 0;
+        if (len < 12 || memcmp(line, "HTTP/1.", 7) != 0 || line[8] != ' ' ||
+            line[9] < '1' || line[9] > '9' || line[10] < '0' || line[10] > '9' || line[11] < '0' || line[11] > '9') {
+            free(headers.data);
+            set_error(error, error_len, "Malformed status line");
+            return READ_FAILED;
+        }
+        minor = line[7] - '0';
+        status = (line[9] - '0') * 100 + (line[10] - '0') * 10 + (line[11] - '0');
+
+        headers.len = 0;
+        if (buf_append(&headers, "", 0) < 0) {
+            set_error(error, error_len, "Out of memory");
+            return READ_FAILED;
+        }
+        for (;;) {
+            line = read_line(conn, &len, NULL);
+            if (!line) {
+                free(headers.data);
+                set_error(error, error_len, "Connection closed in the response headers");
+                return READ_FAILED;
+            }
+            if (len == 0) break;
+            if (buf_append(&headers, line, len) < 0 || buf_append(&headers, "\r\n", 2) < 0) {
+                free(headers.data);
+                set_error(error, error_len, "Out of memory");
+                return READ_FAILED;
+            }
+        }
+        if (status >= 200 || status == 101) break;
+    }
+
+    *keep_alive = minor >= 1 ? !header_has_token(headers.data, "Connection", "close")
+                             : header_has_token(headers.data, "Connection", "keep-alive");
+
+    HttpBuf body = {0};
+    int failed = 0;
+    size_t length_len;
+    const char* length = find_header(headers.data, "Content-Length", &length_len);
+    if (strcmp(method, "HEAD") == 0 || status == 204 || status == 304 || status < 200) {
+        // No body
+    } else if (header_has_token(headers.data, "Transfer-Encoding", "chunked")) {
+        failed = read_chunked_body(conn, req, &body);
+    } else if (length) {
+        char digits[32];
+        size_t n = length_len < sizeof(digits) - 1 ? length_len : sizeof(digits) - 1;
+        memcpy(digits, length, n);
+        digits[n] = '\0';
+        char* end;
+        unsigned long long content_length = strtoull(digits, &end, 10);
+        failed = end == digits || *end != '\0' ? -1 : read_body_bytes(conn, req, &body, (size_t)content_length);
+    } else {
+        // Delimited by the server closing the connection
+        *keep_alive = 0;
+        for (;;) {
+            size_t avail;
+            const char* data = wyn_read_buffer_peek(&conn->input, conn->fd, &avail, NULL);
+            if (!data) {
+                failed = -1;
+                break;
+            }
+            if (avail == 0) break;
+            if (deliver(req, &body, data, avail) < 0) {
+                failed = -1;
+                break;
+            }
+            conn->input.start += avail;
+        }
+    }
+    if (failed || buf_append(&body, "", 0) < 0) {
+        free(headers.data);
+        free(body.data);
+        set_error(error, error_len, "Failed to read response body");
+        return READ_FAILED;
+    }
+
+    WynHttpResponse* resp = malloc(sizeof(WynHttpResponse));
+    if (!resp) {
+        free(headers.data);
+        free(body.data);
+        set_error(error, error_len, "Out of memory");
+        return READ_FAILED;
+    }
+    resp->status = status;
+    resp->headers = headers.data;
+    resp->body = body.data;
+    resp->body_len = body.len;
+    *out = resp;
+    return READ_OK;
+}
+
+// ============================================================================
+// Requests
+// ============================================================================
+
+WynHttpResponse* wyn_http_request(const WynHttpRequest* req, char* error, size_t error_len) {
+    HttpTarget target;
+    if (!req || parse_url(req->url, &target, error, error_len) < 0) return NULL;
+
+    HttpBuf request = {0};
+    if (write_request(&request, req, &target) < 0) {
+        free(request.data);
+        set_error(error, error_len, "Out of memory");
+        return NULL;
+    }
+
+    const char* method = req->method ? req->method : "GET";
+    WynHttpResponse* resp = NULL;
+    // A pooled connection may have been closed by the server since it was
+    // checked; one that fails before any response arrives gets one retry on
+    // a fresh connection
+    for (int attempt = 0; attempt < 2 && !resp; attempt++) {
+        HttpConn* conn = attempt == 0 ? pool_checkout(&target) : NULL;
+        if (!conn) conn = conn_open(&target, error, error_len);
+        if (!conn) break;
+
+        int sent = send_all(conn->fd, request.data, request.len) == 0;
+        int keep_alive = 0;
+        ReadResult result = sent ? read_response(conn, req, &resp, &keep_alive, error, error_len) : READ_NOTHING;
+        if (result == READ_OK && keep_alive) {
+            pool_checkin(conn);
+            break;
+        }
+        int retry = result == READ_NOTHING && conn->reused && (!sent || is_idempotent(method));
+        conn_close(conn);
+        if (!sent && !retry) set_error(error, error_len, "Send failed");
+        if (!retry) break;
+    }
+    free(request.data);
+    return resp;
+}
+
+int wyn_http_pipeline(const WynHttpRequest* reqs, int count, WynHttpResponse** out, char* error, size_t error_len) {
+    if (!reqs || !out || count <= 0) return 0;
+    for (int i = 0; i < count; i++) out[i] = NULL;
+
+    HttpTarget target;
+    if (parse_url(reqs[0].url, &target, error, error_len) < 0) return 0;
+
+    // Indices of the requests for the first request's host, in order
+    int* batch = malloc(sizeof(int) * (size_t)count);
+    if (!batch) return 0;
+    int batch_len = 0;
+    for (int i = 0; i < count; i++) {
+        HttpTarget other;
+        if (i == 0 || (parse_url(reqs[i].url, &other, NULL, 0) == 0 && same_target(&other, &target))) {
+            batch[batch_len++] = i;
+        }
+    }
+
+    int next = 0;
+    int stalled = 0;
+    while (next < batch_len) {
+        HttpConn* conn = pool_checkout(&target);
+        if (!conn) conn = conn_open(&target, error, error_len);
+        if (!conn) break;
+
+        HttpBuf request = {0};
+        int failed = 0;
+        for (int j = next; j < batch_len && !failed; j++) {
+            HttpTarget request_target;
+            failed = parse_url(reqs[batch[j]].url, &request_target, NULL, 0) < 0 ||
+                     write_request(&request, &reqs[batch[j]], &request_target) < 0;
+        }
+        int sent = !failed && send_all(conn->fd, request.data, request.len) == 0;
+        free(request.data);
+
+        int done = next;
+        int keep_alive = 0;
+        ReadResult result = sent ? READ_OK : READ_NOTHING;
+        while (sent && done < batch_len) {
+            result = read_response(conn, &reqs[batch[done]], &out[batch[done]], &keep_alive, error, error_len);
+            if (result != READ_OK) break;
+            done++;
+            if (!keep_alive) break;
+        }
+
+        if (done == batch_len && keep_alive) {
+            pool_checkin(conn);
+        } else {
+            conn_close(conn);
+        }
+
+        if (result == READ_FAILED) {
+            // The server saw this request but its response is unusable
+            done++;
+        } else if (done == next) {
+            // Nothing came back: the pooled connection had gone stale, or
+            // the server refuses this request; retry once, then give up on it
+            if (++stalled > 1) {
+                done++;
+                stalled = 0;
+            }
+        } else {
+            stalled = 0;
+        }
+        next = done;
+    }
+
+    for (int i = 0; i < count; i++) {
+        HttpTarget other;
+        int in_batch = i == 0 || (parse_url(reqs[i].url, &other, NULL, 0) == 0 && same_target(&other, &target));
+        if (!in_batch) out[i] = wyn_http_request(&reqs[i], error, error_len);
+    }
+    free(batch);
+
+    int received = 0;
+    for (int i = 0; i < count; i++) {
+        if (out[i]) received++;
+    }
+    return received;
+}
+
+const char* wyn_http_response_header(const WynHttpResponse* resp, const char* name, size_t* len_out) {
+    if (!resp || !name) return NULL;
+    return find_header(resp->headers, name, len_out);
+}
+
+void wyn_http_response_free(WynHttpResponse* resp) {
+    if (!resp) return;
+    free(resp->headers);
+    free(resp->body);
+    free(resp);
+}
+
+char* wyn_http_fetch(const char* method, const char* url, const char* headers, const char* body,
+                     int* status_out, char* error, size_t error_len) {
+    WynHttpRequest req;
+    memset(&req, 0, sizeof(req));
+    req.method = method;
+    req.url = url;
+    req.headers = headers;
+    req.body = body;
+    req.body_len = body ? strlen(body) : 0;
+
+    WynHttpResponse* resp = wyn_http_request(&req, error, error_len);
+    if (status_out) *status_out = resp ? resp->status : 0;
+    if (!resp) return NULL;
+
+    char* result = resp->body;
+    resp->body = NULL;
+    wyn_http_response_free(resp);
+    return result;
+}
+
+void wyn_http_set_pool_limit(int idle_per_host) {
+    pool_limit = idle_per_host < 0 ? 0 : idle_per_host;
+    if (pool_limit == 0) wyn_http_pool_clear();
+}
+
+void wyn_http_set_dns_ttl(int seconds) {
+    dns_ttl = seconds < 0 ? 0 : seconds;
+    pthread_mutex_lock(&dns_lock);
+    memset(dns_cache, 0, sizeof(dns_cache));
+    pthread_mutex_unlock(&dns_lock);
+}
+
+void wyn_http_pool_clear(void) {
+    pthread_mutex_lock(&pool_lock);
+    HttpConn* conns = idle_conns;
+    idle_conns = NULL;
+    pthread_mutex_unlock(&pool_lock);
+    conn_close_list(conns);
+}
@@ -0,0 +1,56 @@
+#ifndef WYN_HTTP_CLIENT_H
+#define WYN_HTTP_CLIENT_H
+
+#include <stddef.h>
+
+// HTTP/1.1 client. Connections are kept alive and pooled per host and port,
+// host lookups are cached for a TTL, and bodies of any size are read whether
+// they are framed by Content-Length, chunked, or end when the server closes.
+typedef struct WynHttpResponse {
+    int status;
+    char* headers;      // header lines after the status line, NUL-terminated
+    char* body;         // NUL-terminated; empty when the body went to a sink
+    size_t body_len;
+} WynHttpResponse;
+
+// Receives the body as it arrives; a nonzero return aborts the request
+typedef int (*WynHttpBodySink)(void* ctx, const char* data, size_t len);
+
+typedef struct WynHttpRequest {
+    const char* method;     // "GET" when NULL
+    const char* url;        // http://host[:port][/path]
+    const char* headers;    // extra header lines, each ending in "\r\n"; may be NULL
+    const char* body;       // may be NULL
+    size_t body_len;
+    WynHttpBodySink sink;   // when set, the body is streamed instead of kept
+    void* sink_ctx;
+} WynHttpRequest;
+
+// NULL on failure, with the reason in error (if given)
+WynHttpResponse* wyn_http_request(const WynHttpRequest* req, char* error, size_t error_len);
+
+// Sends every request on one connection before reading any response, then
+// reads the responses in order. Requests for other hosts than the first
+// are sent on their own. If the server closes the connection part way, the
+// unanswered requests are sent again on a new one, so pipeline only
+// idempotent requests. Returns how many responses arrived; out[i] is NULL
+// for a request that failed.
+int wyn_http_pipeline(const WynHttpRequest* reqs, int count, WynHttpResponse** out, char* error, size_t error_len);
+
+// Value of header name (case-insensitive), not NUL-terminated; NULL if absent
+const char* wyn_http_response_header(const WynHttpResponse* resp, const char* name, size_t* len_out);
+void wyn_http_response_free(WynHttpResponse* resp);
+
+// Body of a request as a malloc'd string; headers as for WynHttpRequest.
+// For generated code that does not see the structs above.
+char* wyn_http_fetch(const char* method, const char* url, const char* headers, const char* body,
+                     int* status_out, char* error, size_t error_len);
+
+// Idle connections kept per host (default 8; 0 disables pooling)
+void wyn_http_set_pool_limit(int idle_per_host);
+// How long a host lookup is reused (default 60 seconds; 0 disables caching)
+void wyn_http_set_dns_ttl(int seconds);
+// Close every idle connection
+void wyn_http_pool_clear(void);
+
+#endif // WYN_HTTP_CLIENT_H
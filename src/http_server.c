@@ -0,0 +1,845 @@
+// HTTP/1.1 server runtime for Wyn
+// One epoll loop per worker thread, each accepting on its own SO_REUSEPORT
+// listener so the kernel spreads connections across workers without a
+// shared accept lock. Connections are non-blocking and kept alive; requests
+// are parsed as views into the connection's read buffer and only copied
+// when a handler asks for a piece of them. Responses are queued per
+// connection and written with writev (headers and body together) or
+// sendfile for files.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "http_server.h"
+#include "string_runtime.h"
+
+#define HTTP_READ_BUFFER_SIZE 16384
+#define HTTP_MAX_HEADER_BYTES 65536
+#define HTTP_MAX_BODY_BYTES (16 * 1024 * 1024)
+#define HTTP_MAX_HEADERS 64
+#define HTTP_INLINE_BODY 4096        // bodies up to this size are copied next to their headers
+#define HTTP_MAX_QUEUED_OUTPUT (1024 * 1024)
+#define HTTP_MAX_IOV 64
+#define HTTP_MAX_EVENTS 256
+
+typedef struct {
+    const char* data;
+    size_t len;
+} Slice;
+
+typedef struct {
+    Slice method, path, query, body;
+    Slice header_names[HTTP_MAX_HEADERS];
+    Slice header_values[HTTP_MAX_HEADERS];
+    int header_count;
+    int keep_alive;
+    int head;                       // HEAD request: send headers only
+} RequestView;
+
+typedef enum { SEG_BUFFER, SEG_STRING, SEG_FILE } SegmentKind;
+
+// A piece of queued output: a range of the connection's out buffer, a
+// retained Wyn string, or a range of an open file
+typedef struct {
+    SegmentKind kind;
+    const char* data;               // SEG_STRING
+    size_t offset;                  // SEG_BUFFER: into out; SEG_FILE: file offset
+    size_t len;                     // bytes not yet sent
+    int file_fd;
+} Segment;
+
+typedef struct {
+    char* data;
+    size_t len, cap;
+} ByteBuffer;
+
+typedef struct HttpConn {
+    int fd;
+    ByteBuffer in;
+    ByteBuffer out;                 // response headers and small bodies
+    ByteBuffer extra;               // set_header lines for the next response
+    Segment* segs;
+    int seg_head, seg_count, seg_cap;
+    int close_after;                // close once the queued output is sent
+    int writing;                    // waiting for EPOLLOUT
+    int in_handler;
+    int responded;
+    RequestView req;
+} HttpConn;
+
+typedef struct {
+    WynHttpServer* server;
+    int epfd;
+    int listen_fd;
+    int owns_listener;
+    int wake_fd;
+    HttpConn** conns;               // indexed by fd
+    int conn_cap;
+    pthread_t thread;
+} HttpWorker;
+
+struct WynHttpServer {
+    int port;
+    int listen_fd;
+    int worker_count;
+    atomic_int stopping;
+    WynHttpHandler handler;
+    HttpWorker* workers;
+    int running_workers;
+    pthread_mutex_t lock;
+};
+
+// Request handles are connection fds, which are only unique per worker
+static __thread HttpWorker* current_worker;
+
+// ============================================================================
+// Buffers
+// ============================================================================
+
+static int buffer_reserve(ByteBuffer* buf, size_t extra) {
+    if (buf->len + extra <= buf->cap) return 0;
+    size_t cap = buf->cap ? buf->cap : 1024;
+    while (cap < buf->len + extra) cap *= 2;
+    char* data = realloc(buf->data, cap);
+    if (!data) return -1;
+    buf->data = data;
+    buf->cap = cap;
+    return 0;
+}
+
+static int buffer_append(ByteBuffer* buf, const char* data, size_t len) {
+    if (buffer_reserve(buf, len) != 0) return -1;
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+    return 0;
+}
+
+static Segment* push_segment(HttpConn* conn, SegmentKind kind) {
+    if (conn->seg_count == conn->seg_cap) {
+        int cap = conn->seg_cap ? conn->seg_cap * 2 : 8;
+        Segment* segs = realloc(conn->segs, cap * sizeof(Segment));
+        if (!segs) return NULL;
+        conn->segs = segs;
+        conn->seg_cap = cap;
+    }
+    Segment* seg = &conn->segs[conn->seg_count++];
+    memset(seg, 0, sizeof(*seg));
+    seg->kind = kind;
+    seg->file_fd = -1;
+    return seg;
+}
+
+// Queue out[offset..out.len) as output, joining it to the previous buffer
+// segment when they are adjacent so pipelined responses share one iovec
+static int queue_buffered(HttpConn* conn, size_t offset) {
+    size_t len = conn->out.len - offset;
+    if (len == 0) return 0;
+    if (conn->seg_count > conn->seg_head) {
+        Segment* last = &conn->segs[conn->seg_count - 1];
+        if (last->kind == SEG_BUFFER && last->offset + last->len == offset) {
+            last->len += len;
+            return 0;
+        }
+    }
+    Segment* seg = push_segment(conn, SEG_BUFFER);
+    if (!seg) return -1;
+    seg->offset = offset;
+    seg->len = len;
+    return 0;
+}
+
+static void segment_done(Segment* seg) {
+    if (seg->kind == SEG_STRING) wyn_str_release(seg->data);
+    if (seg->kind == SEG_FILE && seg->file_fd >= 0) close(seg->file_fd);
+    seg->kind = SEG_BUFFER;
+    seg->file_fd = -1;
+    seg->len = 0;
+}
+
+static size_t queued_bytes(HttpConn* conn) {
+    size_t total = 0;
+    for (int i = conn->seg_head; i < conn->seg_count; i++) total += conn->segs[i].len;
+    return total;
+}
+
+// ============================================================================
+// Parsing
+// ============================================================================
+
+static int slice_eq_nocase(Slice s, const char* text) {
+    size_t len = strlen(text);
+    return s.len == len && strncasecmp(s.data, text, len) == 0;
+}
+
+static int slice_contains_token(Slice s, const char* token) {
+    size_t len = strlen(token);
+    for (size_t i = 0; i + len <= s.len; i++) {
+        if (strncasecmp(s.data + i, token, len) == 0) return 1;
+    }
+    return 0;
+}
+
+static Slice trim(const char* start, const char* end) {
+    while (start < end && (*start == ' ' || *start == '\t')) start++;
+    while (end > start && (end[-1] == ' ' || end[-1] == '\t')) end--;
+    return (Slice){ start, (size_t)(end - start) };
+}
+
+// Parses one request from data[0..len) into view without copying. Returns
+// the bytes it spans, 0 if more input is needed, or minus the HTTP status
+// to answer a malformed request with.
+static long parse_request(const char* data, size_t len, RequestView* view) {
+    const char* header_end = memmem(data, len, "\r\n\r\n", 4);
+    if (!header_end) return len > HTTP_MAX_HEADER_BYTES ? -431 : 0;
+    size_t header_len = (size_t)(header_end - data) + 4;
+    if (header_len > HTTP_MAX_HEADER_BYTES) return -431;
+
+    memset(view, 0, offsetof(RequestView, header_names));
+    view->header_count = 0;
+
+    // Request line: METHOD SP target SP HTTP/1.x
+    const char* line_end = memchr(data, '\r', header_len);
+    const char* sp1 = memchr(data, ' ', (size_t)(line_end - data));
+    if (!sp1 || sp1 == data) return -400;
+    const char* sp2 = memchr(sp1 + 1, ' ', (size_t)(line_end - sp1 - 1));
+    if (!sp2 || sp2 == sp1 + 1) return -400;
+    if (line_end - sp2 - 1 != 8 || memcmp(sp2 + 1, "HTTP/1.", 7) != 0) return -400;
+    int minor = sp2[8] - '0';
+    if (minor < 0 || minor > 9) return -400;
+
+    view->method = (Slice){ data, (size_t)(sp1 - data) };
+    const char* target = sp1 + 1;
+    const char* question = memchr(target, '?', (size_t)(sp2 - target));
+    if (question) {
+        view->path = (Slice){ target, (size_t)(question - target) };
+        view->query = (Slice){ question + 1, (size_t)(sp2 - question - 1) };
+    } else {
+        view->path = (Slice){ target, (size_t)(sp2 - target) };
+        view->query = (Slice){ sp2, 0 };
+    }
+    view->head = slice_eq_nocase(view->method, "HEAD");
+    view->keep_alive = minor >= 1;
+
+    size_t content_length = 0;
+    const char* line = line_end + 2;
+    while (line < header_end + 2) {
+        const char* end = memchr(line, '\r', (size_t)(header_end + 2 - line));
+        const char* colon = memchr(line, ':', (size_t)(end - line));
+        if (!colon || colon == line) return -400;
+        if (view->header_count == HTTP_MAX_HEADERS) return -431;
+        Slice name = { line, (size_t)(colon - line) };
+        Slice value = trim(colon + 1, end);
+        view->header_names[view->header_count] = name;
+        view->header_values[view->header_count] = value;
+        view->header_count++;
+
+        if (slice_eq_nocase(name, "Content-Length")) {
+            content_length = 0;
+            for (size_t i = 0; i < value.len; i++) {
+                if (value.data[i] < '0' || value.data[i] > '9') return -400;
+                content_length = content_length * 10 + (size_t)(value.data[i] - '0');
+                if (content_length > HTTP_MAX_BODY_BYTES) return -413;
+            }
+        } else if (slice_eq_nocase(name, "Transfer-Encoding")) {
+            // Chunked request bodies are not supported; clients send
+            // Content-Length for everything handlers can read
+            return -501;
+        } else if (slice_eq_nocase(name, "Connection")) {
+            if (slice_contains_token(value, "close")) view->keep_alive = 0;
+            else if (slice_contains_token(value, "keep-alive")) view->keep_alive = 1;
+        }
+        line = end + 2;
+    }
+
+    if (len - header_len < content_length) return 0;
+    view->body = (Slice){ data + header_len, content_length };
+    return (long)(header_len + content_length);
+}
+
+// ============================================================================
+// Responses
+// ============================================================================
+
+static const char* status_reason(int status) {
+    switch (status) {
+        case 100: return "Continue";
+        case 200: return "OK";
+        case 201: return "Created";
+        case 202: return "Accepted";
+        case 204: return "No Content";
+        case 206: return "Partial Content";
+        case 301: return "Moved Permanently";
+        case 302: return "Found";
+        case 303: return "See Other";
+        case 304: return "Not Modified";
+        case 307: return "Temporary Redirect";
+        case 308: return "Permanent Redirect";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 408: return "Request Timeout";
+        case 409: return "Conflict";
+        case 411: return "Length Required";
+        case 413: return "Content Too Large";
+        case 415: return "Unsupported Media Type";
+        case 429: return "Too Many Requests";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 502: return "Bad Gateway";
+        case 503: return "Service Unavailable";
+        default:  return "Unknown";
+    }
+}
+
+// Appends the status line and headers to out and queues them
+static int queue_head(HttpConn* conn, int status, const char* content_type, size_t body_len, size_t* offset_out) {
+    char line[256];
+    int n = snprintf(line, sizeof(line), "HTTP/1.1 %d %s\r\nContent-Length: %zu\r\n",
+                     status, status_reason(status), body_len);
+    size_t offset = conn->out.len;
+    if (buffer_append(&conn->out, line, (size_t)n) != 0) return -1;
+    if (content_type && *content_type) {
+        if (buffer_append(&conn->out, "Content-Type: ", 14) != 0 ||
+            buffer_append(&conn->out, content_type, strlen(content_type)) != 0 ||
+            buffer_append(&conn->out, "\r\n", 2) != 0) return -1;
+    }
+    if (conn->extra.len > 0) {
+        if (buffer_append(&conn->out, conn->extra.data, conn->extra.len) != 0) return -1;
+        conn->extra.len = 0;
+    }
+    if (conn->close_after && buffer_append(&conn->out, "Connection: close\r\n", 19) != 0) return -1;
+    if (buffer_append(&conn->out, "\r\n", 2) != 0) return -1;
+    *offset_out = offset;
+    return 0;
+}
+
+static int queue_response(HttpConn* conn, int status, const char* content_type, const char* body) {
+    size_t body_len = body ? wyn_str_len(body) : 0;
+    size_t offset;
+    if (queue_head(conn, status, content_type, body_len, &offset) != 0) return -1;
+    if (conn->req.head || body_len == 0) return queue_buffered(conn, offset);
+
+    if (body_len <= HTTP_INLINE_BODY) {
+        if (buffer_append(&conn->out, body, body_len) != 0) return -1;
+        return queue_buffered(conn, offset);
+    }
+    // Large bodies go out from the string itself as a second iovec
+    if (queue_buffered(conn, offset) != 0) return -1;
+    Segment* seg = push_segment(conn, SEG_STRING);
+    if (!seg) return -1;
+    seg->data = wyn_str_retain(body);
+    seg->len = body_len;
+    return 0;
+}
+
+// Writes queued output until it is all sent (0), the socket is full (1) or
+// the connection failed (-1)
+static int flush_output(HttpConn* conn) {
+    while (conn->seg_head < conn->seg_count) {
+        Segment* first = &conn->segs[conn->seg_head];
+        if (first->kind == SEG_FILE) {
+            off_t offset = (off_t)first->offset;
+            ssize_t sent = sendfile(conn->fd, first->file_fd, &offset, first->len);
+            if (sent < 0) {
+                if (errno == EINTR) continue;
+                return (errno == EAGAIN || errno == EWOULDBLOCK) ? 1 : -1;
+            }
+            if (sent == 0) return -1;   // file shrank under us
+            first->offset = (size_t)offset;
+            first->len -= (size_t)sent;
+            if (first->len == 0) {
+                segment_done(first);
+                conn->seg_head++;
+            }
+            continue;
+        }
+
+        struct iovec iov[HTTP_MAX_IOV];
+        int count = 0;
+        for (int i = conn->seg_head; i < conn->seg_count && count < HTTP_MAX_IOV; i++) {
+            Segment* seg = &conn->segs[i];
+            if (seg->kind == SEG_FILE) break;
+            iov[count].iov_base = seg->kind == SEG_STRING
+                ? (void*)(seg->data + wyn_str_len(seg->data) - seg->len)
+                : (void*)(conn->out.data + seg->offset);
+            iov[count].iov_len = seg->len;
+            count++;
+        }
+        ssize_t sent = writev(conn->fd, iov, count);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? 1 : -1;
+        }
+        size_t left = (size_t)sent;
+        while (left > 0 && conn->seg_head < conn->seg_count) {
+            Segment* seg = &conn->segs[conn->seg_head];
+            size_t take = left < seg->len ? left : seg->len;
+            if (seg->kind == SEG_BUFFER) seg->offset += take;
+            seg->len -= take;
+            left -= take;
+            if (seg->len > 0) break;
+            segment_done(seg);
+            conn->seg_head++;
+        }
+    }
+    conn->seg_head = conn->seg_count = 0;
+    conn->out.len = 0;
+    return 0;
+}
+
+// ============================================================================
+// Connections
+// ============================================================================
+
+static HttpConn* conn_open(HttpWorker* worker, int fd) {
+    if (fd >= worker->conn_cap) {
+        int cap = worker->conn_cap ? worker->conn_cap : 64;
+        while (cap <= fd) cap *= 2;
+        HttpConn** conns = realloc(worker->conns, cap * sizeof(HttpConn*));
+        if (!conns) return NULL;
+        memset(conns + worker->conn_cap, 0, (cap - worker->conn_cap) * sizeof(HttpConn*));
+        worker->conns = conns;
+        worker->conn_cap = cap;
+    }
+    HttpConn* conn = calloc(1, sizeof(HttpConn));
+    if (!conn) return NULL;
+    conn->fd = fd;
+    if (buffer_reserve(&conn->in, HTTP_READ_BUFFER_SIZE) != 0) {
+        free(conn);
+        return NULL;
+    }
+    worker->conns[fd] = conn;
+    return conn;
+}
+
+static void conn_close(HttpWorker* worker, HttpConn* conn) {
+    for (int i = conn->seg_head; i < conn->seg_count; i++) segment_done(&conn->segs[i]);
+    worker->conns[conn->fd] = NULL;
+    close(conn->fd);
+    free(conn->in.data);
+    free(conn->out.data);
+    free(conn->extra.data);
+    free(conn->segs);
+    free(conn);
+}
+
+static void conn_watch(HttpWorker* worker, HttpConn* conn, int writing) {
+    if (conn->writing == writing) return;
+    struct epoll_event ev = { .events = writing ? EPOLLOUT : EPOLLIN, .data.fd = conn->fd };
+    epoll_ctl(worker->epfd, EPOLL_CTL_MOD, conn->fd, &ev);
+    conn->writing = writing;
+}
+
+static void answer_error(HttpConn* conn, int status) {
+    conn->close_after = 1;
+    conn->req.head = 0;
+    conn->extra.len = 0;
+    queue_response(conn, status, "text/plain", status_reason(status));
+}
+
+// Runs the handler for every complete request in the buffer, stopping early
+// when enough output is queued that the client should read some first.
+// Returns how many requests were answered.
+static int handle_requests(HttpWorker* worker, HttpConn* conn) {
+    WynHttpHandler handler = worker->server->handler;
+    size_t consumed = 0;
+    int handled = 0;
+
+    while (!conn->close_after && queued_bytes(conn) < HTTP_MAX_QUEUED_OUTPUT) {
+        long n = parse_request(conn->in.data + consumed, conn->in.len - consumed, &conn->req);
+        if (n == 0) break;
+        if (n < 0) {
+            answer_error(conn, (int)-n);
+            handled++;
+            break;
+        }
+
+        conn->close_after = !conn->req.keep_alive;
+        conn->responded = 0;
+        conn->in_handler = 1;
+        conn->extra.len = 0;
+        handler(conn->fd);
+        conn->in_handler = 0;
+        if (!conn->responded) queue_response(conn, 404, "text/plain", "Not Found");
+        consumed += (size_t)n;
+        handled++;
+    }
+
+    if (conn->close_after) {
+        conn->in.len = 0;
+    } else if (consumed > 0) {
+        memmove(conn->in.data, conn->in.data + consumed, conn->in.len - consumed);
+        conn->in.len -= consumed;
+    }
+    return handled;
+}
+
+// Answers what is buffered and writes it out; -1 once the connection is gone
+static int conn_process(HttpWorker* worker, HttpConn* conn) {
+    for (;;) {
+        int handled = handle_requests(worker, conn);
+        int pending = flush_output(conn);
+        if (pending < 0) {
+            conn_close(worker, conn);
+            return -1;
+        }
+        if (pending > 0) {
+            conn_watch(worker, conn, 1);
+            return 0;
+        }
+        if (conn->close_after) {
+            conn_close(worker, conn);
+            return -1;
+        }
+        conn_watch(worker, conn, 0);
+        if (handled == 0) return 0;
+    }
+}
+
+static void conn_readable(HttpWorker* worker, HttpConn* conn) {
+    if (conn->in.len == conn->in.cap) {
+        if (buffer_reserve(&conn->in, conn->in.cap) != 0) {
+            conn_close(worker, conn);
+            return;
+        }
+    }
+    ssize_t n;
+    do {
+        n = recv(conn->fd, conn->in.data + conn->in.len, conn->in.cap - conn->in.len, 0);
+    } while (n < 0 && errno == EINTR);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        conn_close(worker, conn);
+        return;
+    }
+    if (n < 0) return;
+    conn->in.len += (size_t)n;
+    conn_process(worker, conn);
+}
+
+static void accept_connections(HttpWorker* worker) {
+    for (;;) {
+        int fd = accept4(worker->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            return;     // EAGAIN, or out of descriptors until some close
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (!conn_open(worker, fd)) {
+            close(fd);
+            continue;
+        }
+        struct epoll_event ev = { .events = EPOLLIN, .data.fd = fd };
+        if (epoll_ctl(worker->epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            conn_close(worker, worker->conns[fd]);
+        }
+    }
+}
+
+// ============================================================================
+// Workers
+// ============================================================================
+
+static int open_listener(int port, int reuse_port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (reuse_port && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) != 0) {
+        close(fd);
+        return -1;
+    }
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons((unsigned short)port);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void* worker_run(void* arg) {
+    HttpWorker* worker = arg;
+    current_worker = worker;
+    struct epoll_event events[HTTP_MAX_EVENTS];
+
+    while (!atomic_load(&worker->server->stopping)) {
+        int n = epoll_wait(worker->epfd, events, HTTP_MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            if (fd == worker->wake_fd) continue;
+            if (fd == worker->listen_fd) {
+                accept_connections(worker);
+                continue;
+            }
+            HttpConn* conn = fd < worker->conn_cap ? worker->conns[fd] : NULL;
+            if (!conn) continue;
+            if (events[i].events & (EPOLLERR | EPOLLHUP) && !(events[i].events & EPOLLIN)) {
+                conn_close(worker, conn);
+            } else if (conn->writing) {
+                conn_process(worker, conn);
+            } else {
+                conn_readable(worker, conn);
+            }
+        }
+    }
+
+    for (int fd = 0; fd < worker->conn_cap; fd++) {
+        if (worker->conns[fd]) conn_close(worker, worker->conns[fd]);
+    }
+    current_worker = NULL;
+    return NULL;
+}
+
+static int worker_init(HttpWorker* worker, WynHttpServer* server, int listen_fd, int owns_listener) {
+    memset(worker, 0, sizeof(*worker));
+    worker->server = server;
+    worker->listen_fd = listen_fd;
+    worker->owns_listener = owns_listener;
+    worker->epfd = epoll_create1(EPOLL_CLOEXEC);
+    worker->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (worker->epfd < 0 || worker->wake_fd < 0) return -1;
+
+    // A listener shared by several workers wakes only one of them per
+    // connection; SO_REUSEPORT listeners are per worker anyway
+    struct epoll_event ev = { .events = EPOLLIN | (owns_listener ? 0 : EPOLLEXCLUSIVE), .data.fd = listen_fd };
+    if (epoll_ctl(worker->epfd, EPOLL_CTL_ADD, listen_fd, &ev) != 0) return -1;
+    ev.events = EPOLLIN;
+    ev.data.fd = worker->wake_fd;
+    return epoll_ctl(worker->epfd, EPOLL_CTL_ADD, worker->wake_fd, &ev);
+}
+
+static void worker_free(HttpWorker* worker) {
+    if (worker->epfd >= 0) close(worker->epfd);
+    if (worker->wake_fd >= 0) close(worker->wake_fd);
+    if (worker->owns_listener && worker->listen_fd >= 0) close(worker->listen_fd);
+    free(worker->conns);
+}
+
+WynHttpServer* HttpServer_new(int port) {
+    int fd = open_listener(port, 1);
+    if (fd < 0) fd = open_listener(port, 0);
+    if (fd < 0) return NULL;
+
+    WynHttpServer* server = calloc(1, sizeof(WynHttpServer));
+    if (!server) {
+        close(fd);
+        return NULL;
+    }
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    getsockname(fd, (struct sockaddr*)&addr, &addr_len);
+    server->port = ntohs(addr.sin_port);
+    server->listen_fd = fd;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    server->worker_count = cpus > 0 ? (int)cpus : 1;
+    pthread_mutex_init(&server->lock, NULL);
+    return server;
+}
+
+void HttpServer_workers(WynHttpServer* server, int count) {
+    if (server && count > 0) server->worker_count = count;
+}
+
+int HttpServer_port(WynHttpServer* server) {
+    return server ? server->port : 0;
+}
+
+int HttpServer_serve(WynHttpServer* server, WynHttpHandler handler) {
+    if (!server || !handler) return -1;
+    // Peers that hang up mid-response must not kill the process
+    signal(SIGPIPE, SIG_IGN);
+
+    int count = server->worker_count;
+    HttpWorker* workers = calloc((size_t)count, sizeof(HttpWorker));
+    if (!workers) return -1;
+    server->handler = handler;
+
+    int ready = 0;
+    for (; ready < count; ready++) {
+        int fd = server->listen_fd;
+        int owns = 0;
+        if (ready > 0) {
+            fd = open_listener(server->port, 1);
+            owns = fd >= 0;
+            if (fd < 0) fd = server->listen_fd;
+        }
+        if (worker_init(&workers[ready], server, fd, owns) != 0) {
+            worker_free(&workers[ready]);
+            break;
+        }
+    }
+    if (ready == 0) {
+        free(workers);
+        return -1;
+    }
+
+    pthread_mutex_lock(&server->lock);
+    server->workers = workers;
+    server->running_workers = ready;
+    pthread_mutex_unlock(&server->lock);
+
+    int started = 1;
+    for (; started < ready; started++) {
+        if (pthread_create(&workers[started].thread, NULL, worker_run, &workers[started]) != 0) break;
+    }
+    worker_run(&workers[0]);
+    for (int i = 1; i < started; i++) pthread_join(workers[i].thread, NULL);
+
+    pthread_mutex_lock(&server->lock);
+    server->workers = NULL;
+    server->running_workers = 0;
+    pthread_mutex_unlock(&server->lock);
+    for (int i = 0; i < ready; i++) worker_free(&workers[i]);
+    free(workers);
+    atomic_store(&server->stopping, 0);
+    return 0;
+}
+
+void HttpServer_stop(WynHttpServer* server) {
+    if (!server) return;
+    atomic_store(&server->stopping, 1);
+    pthread_mutex_lock(&server->lock);
+    uint64_t one = 1;
+    for (int i = 0; i < server->running_workers; i++) {
+        ssize_t ignored = write(server->workers[i].wake_fd, &one, sizeof(one));
+        (void)ignored;
+    }
+    pthread_mutex_unlock(&server->lock);
+}
+
+void HttpServer_free(WynHttpServer* server) {
+    if (!server) return;
+    close(server->listen_fd);
+    pthread_mutex_destroy(&server->lock);
+    free(server);
+}
+
+// ============================================================================
+// Handler API
+// ============================================================================
+
+static HttpConn* handler_conn(int req) {
+    HttpWorker* worker = current_worker;
+    if (!worker || req < 0 || req >= worker->conn_cap) return NULL;
+    HttpConn* conn = worker->conns[req];
+    return conn && conn->in_handler ? conn : NULL;
+}
+
+static const char* slice_str(Slice s) {
+    return s.len > 0 ? wyn_str_new(s.data, s.len) : "";
+}
+
+const char* HttpServer_method(int req) {
+    HttpConn* conn = handler_conn(req);
+    return conn ? slice_str(conn->req.method) : "";
+}
+
+const char* HttpServer_path(int req) {
+    HttpConn* conn = handler_conn(req);
+    return conn ? slice_str(conn->req.path) : "";
+}
+
+const char* HttpServer_query(int req) {
+    HttpConn* conn = handler_conn(req);
+    return conn ? slice_str(conn->req.query) : "";
+}
+
+const char* HttpServer_header(int req, const char* name) {
+    HttpConn* conn = handler_conn(req);
+    if (!conn || !name) return "";
+    for (int i = 0; i < conn->req.header_count; i++) {
+        if (slice_eq_nocase(conn->req.header_names[i], name)) return slice_str(conn->req.header_values[i]);
+    }
+    return "";
+}
+
+const char* HttpServer_body(int req) {
+    HttpConn* conn = handler_conn(req);
+    return conn ? slice_str(conn->req.body) : "";
+}
+
+void HttpServer_set_header(int req, const char* name, const char* value) {
+    HttpConn* conn = handler_conn(req);
+    if (!conn || conn->responded || !name || !value) return;
+    // Header injection through CR/LF in either part is refused
+    if (strpbrk(name, "\r\n:") || strpbrk(value, "\r\n")) return;
+    buffer_append(&conn->extra, name, strlen(name));
+    buffer_append(&conn->extra, ": ", 2);
+    buffer_append(&conn->extra, value, strlen(value));
+    buffer_append(&conn->extra, "\r\n", 2);
+}
+
+int HttpServer_respond(int req, int status, const char* content_type, const char* body) {
+    HttpConn* conn = handler_conn(req);
+    if (!conn || conn->responded || status < 100 || status > 999) return -1;
+    conn->responded = 1;
+    return queue_response(conn, status, content_type, body);
+}
+
+int HttpServer_send_file(int req, const char* path, const char* content_type) {
+    HttpConn* conn = handler_conn(req);
+    if (!conn || conn->responded || !path) return -1;
+    conn->responded = 1;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        if (fd >= 0) close(fd);
+        conn->extra.len = 0;
+        queue_response(conn, 404, "text/plain", "Not Found");
+        return -1;
+    }
+
+    size_t offset;
+    if (queue_head(conn, 200, content_type, (size_t)st.st_size, &offset) != 0 ||
+        queue_buffered(conn, offset) != 0) {
+        close(fd);
+        return -1;
+    }
+    if (conn->req.head || st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+    Segment* seg = push_segment(conn, SEG_FILE);
+    if (!seg) {
+        close(fd);
+        return -1;
+    }
+    seg->file_fd = fd;
+    seg->offset = 0;
+    seg->len = (size_t)st.st_size;
+    return 0;
+}
+
+void HttpServer_shutdown(int req) {
+    if (handler_conn(req)) HttpServer_stop(current_worker->server);
+}
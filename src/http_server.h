@@ -0,0 +1,41 @@
+#ifndef WYN_HTTP_SERVER_H
+#define WYN_HTTP_SERVER_H
+
+// HTTP/1.1 server. Every worker thread owns an SO_REUSEPORT listener and an
+// epoll loop over its non-blocking connections. Requests are parsed in place
+// in the connection's buffer and passed to the handler on the worker's
+// thread; pipelined requests are answered in order on kept-alive connections.
+typedef struct WynHttpServer WynHttpServer;
+
+// Called once per request with a handle valid until it returns. Respond
+// with HttpServer_respond or HttpServer_send_file; a request left without a
+// response gets 404.
+typedef int (*WynHttpHandler)(int req);
+
+// Binds port (0 picks a free one); NULL if it cannot
+WynHttpServer* HttpServer_new(int port);
+// Worker threads, default one per online CPU
+void HttpServer_workers(WynHttpServer* server, int count);
+int HttpServer_port(WynHttpServer* server);
+// Runs until HttpServer_stop; the calling thread is one of the workers
+int HttpServer_serve(WynHttpServer* server, WynHttpHandler handler);
+// Safe from any thread, including from a handler
+void HttpServer_stop(WynHttpServer* server);
+void HttpServer_free(WynHttpServer* server);
+
+// Inside a handler. Strings are copies; "" when absent.
+const char* HttpServer_method(int req);
+const char* HttpServer_path(int req);
+const char* HttpServer_query(int req);
+const char* HttpServer_header(int req, const char* name);
+const char* HttpServer_body(int req);
+// Extra response header for the next respond/send_file
+void HttpServer_set_header(int req, const char* name, const char* value);
+int HttpServer_respond(int req, int status, const char* content_type, const char* body);
+// Sends path with sendfile(), or a 404 if it cannot be opened
+int HttpServer_send_file(int req, const char* path, const char* content_type);
+// HttpServer_stop for the server answering req, for handlers, which have
+// no other way to reach it
+void HttpServer_shutdown(int req);
+
+#endif // WYN_HTTP_SERVER_H
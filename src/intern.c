@@ -0,0 +1,123 @@
+// Identifier interning
+// Names are copied into 64KB blocks that are never moved or freed, so the
+// strings stay valid for as long as the ids handed out for them. Ids index
+// a table of (string, length, hash); an open-addressing index of ids finds
+// a name's id from its bytes. The table is filled by the lexer and is not
+// locked: one thread compiles at a time.
+#include <stdlib.h>
+#include <string.h>
+#include "intern.h"
+
+#define INTERN_BLOCK_SIZE 65536
+
+typedef struct {
+    const char* string;
+    int length;
+    uint32_t hash;
+} InternedName;
+
+static InternedName* names = NULL;   // names[0] is unused so 0 can mean "no id"
+static uint32_t name_count = 1;
+static uint32_t name_capacity = 0;
+
+static uint32_t* index_slots = NULL;  // id, 0 when empty
+static uint32_t index_capacity = 0;   // power of two
+
+static char* block = NULL;
+static size_t block_used = 0;
+
+uint32_t intern_hash(const char* name, int length) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < length; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static const char* copy_name(const char* name, int length) {
+    size_t size = (size_t)length + 1;
+    char* copy;
+    if (size > INTERN_BLOCK_SIZE / 4) {
+        copy = malloc(size);
+    } else {
+        if (!block || block_used + size > INTERN_BLOCK_SIZE) {
+            block = malloc(INTERN_BLOCK_SIZE);
+            block_used = 0;
+        }
+        copy = block + block_used;
+        block_used += size;
+    }
+    memcpy(copy, name, (size_t)length);
+    copy[length] = '\0';
+    return copy;
+}
+
+static void grow_index(void) {
+    uint32_t capacity = index_capacity ? index_capacity * 2 : 1024;
+    uint32_t* slots = calloc(capacity, sizeof(uint32_t));
+    for (uint32_t id = 1; id < name_count; id++) {
+        uint32_t i = names[id].hash & (capacity - 1);
+        while (slots[i]) i = (i + 1) & (capacity - 1);
+        slots[i] = id;
+    }
+    free(index_slots);
+    index_slots = slots;
+    index_capacity = capacity;
+}
+
+uint32_t intern_name(const char* name, int length) {
+    uint32_t hash = intern_hash(name, length);
+    if (index_capacity) {
+        uint32_t mask = index_capacity - 1;
+        for (uint32_t i = hash & mask; index_slots[i]; i = (i + 1) & mask) {
+            InternedName* entry = &names[index_slots[i]];
+            if (entry->hash == hash && entry->length == length &&
+                memcmp(entry->string, name, (size_t)length) == 0) {
+                return index_slots[i];
+            }
+        }
+    }
+
+    if (name_count >= name_capacity) {
+        name_capacity = name_capacity ? name_capacity * 2 : 512;
+        names = realloc(names, name_capacity * sizeof(InternedName));
+    }
+    uint32_t id = name_count++;
+    names[id].string = copy_name(name, length);
+    names[id].length = length;
+    names[id].hash = hash;
+
+    // Keep the index at most half full
+    if (name_count * 2 > index_capacity) {
+        grow_index();
+    } else {
+        uint32_t mask = index_capacity - 1;
+        uint32_t i = hash & mask;
+        while (index_slots[i]) i = (i + 1) & mask;
+        index_slots[i] = id;
+    }
+    return id;
+}
+
+const char* interned_string(uint32_t id) {
+    return id && id < name_count ? names[id].string : NULL;
+}
+
+int interned_length(uint32_t id) {
+    return id && id < name_count ? names[id].length : 0;
+}
+
+const char* intern_cstr(const char* name) {
+    return names[intern_name(name, (int)strlen(name))].string;
+}
+
+uint32_t token_name_id(const Token* token) {
+    uint32_t id = token->id;
+    if (id && id < name_count && names[id].length == token->length &&
+        (names[id].string == token->start ||
+         memcmp(names[id].string, token->start, (size_t)token->length) == 0)) {
+        return id;
+    }
+    return intern_name(token->start, token->length);
+}
@@ -0,0 +1,26 @@
+// Identifier interning: each distinct name is stored once and numbered, so
+// later phases can compare names by id instead of byte by byte
+#ifndef WYN_INTERN_H
+#define WYN_INTERN_H
+
+#include "common.h"
+
+// FNV-1a over a name's bytes; the hash every name table in the compiler uses
+uint32_t intern_hash(const char* name, int length);
+
+// Returns the name's id (never 0), adding it on first sight
+uint32_t intern_name(const char* name, int length);
+
+// The stored copy of an interned name: NUL-terminated and valid for the life of the process
+const char* interned_string(uint32_t id);
+int interned_length(uint32_t id);
+
+// Canonical copy of a C string; equal names return the same pointer
+const char* intern_cstr(const char* name);
+
+// Id of the name a token spells. Tokens whose text was rewritten after
+// lexing can carry a stale id, so the id is only trusted if it still
+// spells the token's text; otherwise the text is interned.
+uint32_t token_name_id(const Token* token);
+
+#endif
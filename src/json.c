@@ -1,113 +1,1188 @@
 #include "json.h"
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <math.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
-#define MAX_PAIRS 32
+#define JSON_MAX_DEPTH 1024
+#define JSON_INDEX_MIN 8        // Objects with more members get a hash index
+#define JSON_CHUNK_MIN 4096
 
-typedef struct {
-    char* key;
-    char* str_value;
-    int int_value;
-    int is_int;
-} JsonPair;
+typedef struct JsonMember JsonMember;
 
 struct WynJson {
-    JsonPair pairs[MAX_PAIRS];
-    int count;
+    uint8_t type;
+    uint8_t is_int;     // Number without fraction or exponent that fits a long long
+    uint8_t is_root;
+    uint32_t len;       // String bytes, array items or object members
+    union {
+        long long integer;
+        double number;
+        int boolean;
+        char* string;
+        WynJson* items;
+        JsonMember* members;    // Followed by the hash index when len > JSON_INDEX_MIN
+    };
+};
+
+struct JsonMember {
+    const char* key;
+    uint32_t key_len;
+    uint32_t hash;
+    WynJson value;
 };
 
-static void skip_whitespace(const char** p) {
-    while (**p && isspace(**p)) (*p)++;
+typedef struct JsonChunk {
+    struct JsonChunk* next;
+    size_t size;
+    size_t used;
+    char data[];
+} JsonChunk;
+
+// The root node comes first so json_free can find the document from it
+typedef struct {
+    WynJson root;
+    JsonChunk* chunks;
+} JsonDoc;
+
+static _Thread_local char json_error_buf[128];
+
+const char* json_error(void) {
+    return json_error_buf[0] ? json_error_buf : NULL;
 }
 
-static char* parse_string(const char** p) {
-    if (**p != '"') return NULL;
-    (*p)++; // Skip opening quote
-    
-    const char* start = *p;
-    while (**p && **p != '"') (*p)++;
-    
-    int len = *p - start;
-    char* str = malloc(len + 1);
-    memcpy(str, start, len);
-    str[len] = '\0';
-    
-    if (**p == '"') (*p)++; // Skip closing quote
-    return str;
+// ---------------------------------------------------------------------------
+// Shared scanning helpers
+
+// First byte at or after p that ends a run of plain string bytes: a quote,
+// a backslash or a control character. Returns end if there is none.
+static const char* json_scan_plain(const char* p, const char* end) {
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash));
+        // Unsigned v <= 0x1F
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(_mm_min_epu8(v, control), v));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask) return p + __builtin_ctz((unsigned)mask);
+        p += 16;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t control = vdupq_n_u8(0x1F);
+    while (end - p >= 16) {
+        uint8x16_t v = vld1q_u8((const uint8_t*)p);
+        uint8x16_t hit = vorrq_u8(vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, backslash)),
+                                  vcleq_u8(v, control));
+        if (vmaxvq_u8(hit)) break;
+        p += 16;
+    }
+#endif
+    while (p < end) {
+        unsigned char c = (unsigned char)*p;
+        if (c == '"' || c == '\\' || c < 0x20) return p;
+        p++;
+    }
+    return end;
+}
+
+static inline int json_is_space(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static const char* json_skip_space(const char* p, const char* end) {
+    // Most gaps are empty or a single space; long runs are indentation
+    if (p < end && !json_is_space(*p)) return p;
+#if defined(__SSE2__)
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                                               _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))),
+                                  _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')),
+                                               _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))));
+        int mask = ~_mm_movemask_epi8(ws) & 0xFFFF;
+        if (mask) return p + __builtin_ctz((unsigned)mask);
+        p += 16;
+    }
+#endif
+    while (p < end && json_is_space(*p)) p++;
+    return p;
+}
+
+static uint32_t json_hash(const char* key, size_t len) {
+    // FNV-1a; keys are short
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)key[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static int json_hex4(const char* p, uint32_t* out) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') v |= (uint32_t)(c - '0');
+        else if (c >= 'a' && c <= 'f') v |= (uint32_t)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') v |= (uint32_t)(c - 'A' + 10);
+        else return 0;
+    }
+    *out = v;
+    return 1;
+}
+
+static size_t json_utf8(uint32_t cp, char* out) {
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// Decode the escape after a backslash at p (p[0] is the escape letter).
+// Writes UTF-8 to out and returns the bytes consumed after the backslash,
+// or 0 if the escape is malformed or truncated.
+static size_t json_unescape(const char* p, const char* end, char* out, size_t* written) {
+    if (p >= end) return 0;
+    char c = *p;
+    char simple = 0;
+    switch (c) {
+        case '"': simple = '"'; break;
+        case '\\': simple = '\\'; break;
+        case '/': simple = '/'; break;
+        case 'b': simple = '\b'; break;
+        case 'f': simple = '\f'; break;
+        case 'n': simple = '\n'; break;
+        case 'r': simple = '\r'; break;
+        case 't': simple = '\t'; break;
+        case 'u': break;
+        default: return 0;
+    }
+    if (simple) {
+        out[0] = simple;
+        *written = 1;
+        return 1;
+    }
+    uint32_t cp;
+    if (end - p < 5 || !json_hex4(p + 1, &cp)) return 0;
+    size_t used = 5;
+    if (cp >= 0xD800 && cp <= 0xDBFF) {
+        uint32_t low;
+        if (end - p >= 11 && p[5] == '\\' && p[6] == 'u' && json_hex4(p + 7, &low) &&
+            low >= 0xDC00 && low <= 0xDFFF) {
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+            used = 11;
+        } else {
+            cp = 0xFFFD;
+        }
+    } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+        cp = 0xFFFD;
+    }
+    *written = json_utf8(cp, out);
+    return used;
+}
+
+static const double json_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Parse the number at p into out; returns the end of the number or NULL
+static const char* json_scan_number(const char* p, const char* end, WynJson* out) {
+    const char* start = p;
+    int negative = 0;
+    if (p < end && *p == '-') {
+        negative = 1;
+        p++;
+    }
+    if (p >= end || *p < '0' || *p > '9') return NULL;
+
+    uint64_t mantissa = 0;
+    int digits = 0;         // Significant digits accumulated in mantissa
+    int truncated = 0;      // Digits did not fit: leave the value to strtod
+    int exponent = 0;
+    if (*p == '0') {
+        p++;
+    } else {
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+                digits++;
+            } else {
+                truncated = 1;
+            }
+            p++;
+        }
+    }
+    int is_int = 1;
+    if (p < end && *p == '.') {
+        is_int = 0;
+        p++;
+        if (p >= end || *p < '0' || *p > '9') return NULL;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (mantissa == 0 && *p == '0') {
+                exponent--;         // Leading zeros carry no digits
+            } else if (digits < 19) {
+                mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+                digits++;
+                exponent--;
+            } else {
+                truncated = 1;
+            }
+            p++;
+        }
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        is_int = 0;
+        p++;
+        int exp_negative = 0;
+        if (p < end && (*p == '+' || *p == '-')) {
+            exp_negative = *p == '-';
+            p++;
+        }
+        if (p >= end || *p < '0' || *p > '9') return NULL;
+        int e = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (e < 100000) e = e * 10 + (*p - '0');
+            p++;
+        }
+        exponent += exp_negative ? -e : e;
+    }
+
+    out->type = JSON_NUMBER;
+    out->len = 0;
+    if (is_int && !truncated && mantissa <= (uint64_t)INT64_MAX + (uint64_t)negative) {
+        out->is_int = 1;
+        out->integer = negative ? (long long)(0 - mantissa) : (long long)mantissa;
+        return p;
+    }
+    out->is_int = 0;
+    // Exact when both the mantissa and the power of ten are exact doubles
+    if (!truncated && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+        double value = (double)mantissa;
+        value = exponent < 0 ? value / json_pow10[-exponent] : value * json_pow10[exponent];
+        out->number = negative ? -value : value;
+        return p;
+    }
+    char local[64];
+    size_t n = (size_t)(p - start);
+    char* text = n < sizeof(local) ? local : malloc(n + 1);
+    if (!text) return NULL;
+    memcpy(text, start, n);
+    text[n] = '\0';
+    out->number = strtod(text, NULL);
+    if (text != local) free(text);
+    return p;
+}
+
+// ---------------------------------------------------------------------------
+// Document parser
+
+static void* json_arena_alloc(JsonDoc* doc, size_t size) {
+    size = (size + 7) & ~(size_t)7;
+    JsonChunk* chunk = doc->chunks;
+    if (!chunk || chunk->size - chunk->used < size) {
+        size_t chunk_size = chunk ? chunk->size * 2 : JSON_CHUNK_MIN;
+        if (chunk_size < size) chunk_size = size;
+        JsonChunk* fresh = malloc(sizeof(JsonChunk) + chunk_size);
+        if (!fresh) return NULL;
+        fresh->size = chunk_size;
+        fresh->used = 0;
+        fresh->next = chunk;
+        doc->chunks = fresh;
+        chunk = fresh;
+    }
+    void* result = chunk->data + chunk->used;
+    chunk->used += size;
+    return result;
+}
+
+typedef struct {
+    const char* p;
+    const char* start;
+    const char* end;
+    JsonDoc* doc;
+    JsonMember* stack;      // Children of the containers being parsed
+    size_t top;
+    size_t cap;
+    int depth;
+    const char* error;
+} JsonParser;
+
+static int json_fail(JsonParser* parser, const char* message) {
+    if (!parser->error) parser->error = message;
+    return 0;
+}
+
+static int json_push(JsonParser* parser, JsonMember* member) {
+    if (parser->top == parser->cap) {
+        size_t cap = parser->cap ? parser->cap * 2 : 64;
+        JsonMember* grown = realloc(parser->stack, cap * sizeof(JsonMember));
+        if (!grown) return json_fail(parser, "out of memory");
+        parser->stack = grown;
+        parser->cap = cap;
+    }
+    parser->stack[parser->top++] = *member;
+    return 1;
+}
+
+// String at parser->p (after the opening quote) into the arena
+static int json_parse_string(JsonParser* parser, char** out, uint32_t* len_out) {
+    const char* p = parser->p;
+    const char* end = parser->end;
+    const char* q = json_scan_plain(p, end);
+    if (q < end && *q == '"') {
+        // No escapes: one copy
+        size_t len = (size_t)(q - p);
+        char* s = json_arena_alloc(parser->doc, len + 1);
+        if (!s) return json_fail(parser, "out of memory");
+        memcpy(s, p, len);
+        s[len] = '\0';
+        *out = s;
+        *len_out = (uint32_t)len;
+        parser->p = q + 1;
+        return 1;
+    }
+    // Find the closing quote; the decoded text is never longer than the raw
+    const char* close = q;
+    while (close < end && *close != '"') {
+        if (*close == '\\') {
+            close += 2;
+        } else if ((unsigned char)*close < 0x20) {
+            return json_fail(parser, "control character in string");
+        } else {
+            close++;
+        }
+        if (close < end) close = json_scan_plain(close, end);
+    }
+    if (close >= end) return json_fail(parser, "unterminated string");
+    char* s = json_arena_alloc(parser->doc, (size_t)(close - p) + 1);
+    if (!s) return json_fail(parser, "out of memory");
+    char* w = s;
+    while (p < close) {
+        q = json_scan_plain(p, close);
+        memcpy(w, p, (size_t)(q - p));
+        w += q - p;
+        p = q;
+        if (p >= close) break;
+        if (*p != '\\') return json_fail(parser, "control character in string");
+        size_t written;
+        size_t used = json_unescape(p + 1, close, w, &written);
+        if (!used) return json_fail(parser, "invalid escape");
+        w += written;
+        p += 1 + used;
+    }
+    *w = '\0';
+    *out = s;
+    *len_out = (uint32_t)(w - s);
+    parser->p = close + 1;
+    return 1;
+}
+
+static int json_parse_value(JsonParser* parser, WynJson* out);
+
+static int json_parse_array(JsonParser* parser, WynJson* out) {
+    size_t base = parser->top;
+    parser->p = json_skip_space(parser->p, parser->end);
+    if (parser->p < parser->end && *parser->p == ']') {
+        parser->p++;
+    } else {
+        for (;;) {
+            JsonMember slot;
+            slot.key = NULL;
+            slot.key_len = 0;
+            slot.hash = 0;
+            if (!json_parse_value(parser, &slot.value) || !json_push(parser, &slot)) return 0;
+            parser->p = json_skip_space(parser->p, parser->end);
+            if (parser->p >= parser->end) return json_fail(parser, "unterminated array");
+            char c = *parser->p++;
+            if (c == ']') break;
+            if (c != ',') return json_fail(parser, "expected ',' or ']'");
+        }
+    }
+    size_t count = parser->top - base;
+    out->type = JSON_ARRAY;
+    out->is_int = 0;
+    out->len = (uint32_t)count;
+    out->items = NULL;
+    if (count) {
+        out->items = json_arena_alloc(parser->doc, count * sizeof(WynJson));
+        if (!out->items) return json_fail(parser, "out of memory");
+        for (size_t i = 0; i < count; i++) out->items[i] = parser->stack[base + i].value;
+    }
+    parser->top = base;
+    return 1;
+}
+
+static size_t json_index_cap(uint32_t count) {
+    size_t cap = 16;
+    while (cap < (size_t)count * 2) cap <<= 1;
+    return cap;
+}
+
+static int json_parse_object(JsonParser* parser, WynJson* out) {
+    size_t base = parser->top;
+    parser->p = json_skip_space(parser->p, parser->end);
+    if (parser->p < parser->end && *parser->p == '}') {
+        parser->p++;
+    } else {
+        for (;;) {
+            JsonMember member;
+            parser->p = json_skip_space(parser->p, parser->end);
+            if (parser->p >= parser->end || *parser->p != '"') return json_fail(parser, "expected key");
+            parser->p++;
+            char* key;
+            if (!json_parse_string(parser, &key, &member.key_len)) return 0;
+            member.key = key;
+            member.hash = json_hash(key, member.key_len);
+            parser->p = json_skip_space(parser->p, parser->end);
+            if (parser->p >= parser->end || *parser->p != ':') return json_fail(parser, "expected ':'");
+            parser->p++;
+            if (!json_parse_value(parser, &member.value) || !json_push(parser, &member)) return 0;
+            parser->p = json_skip_space(parser->p, parser->end);
+            if (parser->p >= parser->end) return json_fail(parser, "unterminated object");
+            char c = *parser->p++;
+            if (c == '}') break;
+            if (c != ',') return json_fail(parser, "expected ',' or '}'");
+        }
+    }
+    uint32_t count = (uint32_t)(parser->top - base);
+    out->type = JSON_OBJECT;
+    out->is_int = 0;
+    out->len = count;
+    out->members = NULL;
+    if (count) {
+        size_t bytes = count * sizeof(JsonMember);
+        size_t cap = count > JSON_INDEX_MIN ? json_index_cap(count) : 0;
+        out->members = json_arena_alloc(parser->doc, bytes + cap * sizeof(uint32_t));
+        if (!out->members) return json_fail(parser, "out of memory");
+        memcpy(out->members, parser->stack + base, bytes);
+        if (cap) {
+            // Slots hold member index + 1; the first of duplicate keys wins
+            uint32_t* index = (uint32_t*)(out->members + count);
+            memset(index, 0, cap * sizeof(uint32_t));
+            for (uint32_t i = 0; i < count; i++) {
+                JsonMember* m = &out->members[i];
+                size_t slot = m->hash & (cap - 1);
+                for (;;) {
+                    uint32_t at = index[slot];
+                    if (!at) {
+                        index[slot] = i + 1;
+                        break;
+                    }
+                    JsonMember* other = &out->members[at - 1];
+                    if (other->hash == m->hash && other->key_len == m->key_len &&
+                        memcmp(other->key, m->key, m->key_len) == 0) {
+                        break;
+                    }
+                    slot = (slot + 1) & (cap - 1);
+                }
+            }
+        }
+    }
+    parser->top = base;
+    return 1;
+}
+
+static int json_literal(JsonParser* parser, const char* word, size_t len) {
+    if ((size_t)(parser->end - parser->p) < len || memcmp(parser->p, word, len) != 0) {
+        return json_fail(parser, "invalid literal");
+    }
+    parser->p += len;
+    return 1;
+}
+
+static int json_parse_value(JsonParser* parser, WynJson* out) {
+    parser->p = json_skip_space(parser->p, parser->end);
+    if (parser->p >= parser->end) return json_fail(parser, "unexpected end of input");
+    out->is_int = 0;
+    out->is_root = 0;
+    out->len = 0;
+    char c = *parser->p;
+    switch (c) {
+        case '{':
+        case '[': {
+            if (++parser->depth > JSON_MAX_DEPTH) return json_fail(parser, "nesting too deep");
+            parser->p++;
+            int ok = c == '{' ? json_parse_object(parser, out) : json_parse_array(parser, out);
+            parser->depth--;
+            return ok;
+        }
+        case '"':
+            parser->p++;
+            out->type = JSON_STRING;
+            return json_parse_string(parser, &out->string, &out->len);
+        case 't':
+            out->type = JSON_BOOL;
+            out->boolean = 1;
+            return json_literal(parser, "true", 4);
+        case 'f':
+            out->type = JSON_BOOL;
+            out->boolean = 0;
+            return json_literal(parser, "false", 5);
+        case 'n':
+            out->type = JSON_NULL;
+            out->integer = 0;
+            return json_literal(parser, "null", 4);
+        default: {
+            const char* next = json_scan_number(parser->p, parser->end, out);
+            if (!next) return json_fail(parser, "unexpected character");
+            parser->p = next;
+            return 1;
+        }
+    }
+}
+
+static void json_free_chunks(JsonChunk* chunk) {
+    while (chunk) {
+        JsonChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+}
+
+WynJson* json_parse_n(const char* text, size_t len) {
+    json_error_buf[0] = '\0';
+    if (!text) {
+        snprintf(json_error_buf, sizeof(json_error_buf), "no input");
+        return NULL;
+    }
+    JsonDoc* doc = calloc(1, sizeof(JsonDoc));
+    if (!doc) return NULL;
+    JsonParser parser = {0};
+    parser.p = text;
+    parser.start = text;
+    parser.end = text + len;
+    parser.doc = doc;
+
+    int ok = json_parse_value(&parser, &doc->root);
+    if (ok) {
+        parser.p = json_skip_space(parser.p, parser.end);
+        if (parser.p < parser.end) ok = json_fail(&parser, "trailing characters");
+    }
+    free(parser.stack);
+    if (!ok) {
+        snprintf(json_error_buf, sizeof(json_error_buf), "%s at offset %zu",
+                 parser.error ? parser.error : "invalid JSON", (size_t)(parser.p - parser.start));
+        json_free_chunks(doc->chunks);
+        free(doc);
+        return NULL;
+    }
+    doc->root.is_root = 1;
+    return &doc->root;
 }
 
 WynJson* json_parse(const char* text) {
-    WynJson* json = calloc(1, sizeof(WynJson));
-    const char* p = text;
-    
-    skip_whitespace(&p);
-    if (*p != '{') return json;
-    p++; // Skip {
-    
-    while (*p && *p != '}') {
-        skip_whitespace(&p);
-        if (*p == '}') break;
-        
-        // Parse key
-        char* key = parse_string(&p);
-        if (!key) break;
-        
-        skip_whitespace(&p);
-        if (*p != ':') { free(key); break; }
-        p++; // Skip :
-        
-        skip_whitespace(&p);
-        
-        // Parse value
-        if (*p == '"') {
-            // String value
-            char* value = parse_string(&p);
-            json->pairs[json->count].key = key;
-            json->pairs[json->count].str_value = value;
-            json->pairs[json->count].is_int = 0;
-            json->count++;
-        } else if (isdigit(*p) || *p == '-') {
-            // Int value
-            int value = atoi(p);
-            while (*p && (isdigit(*p) || *p == '-')) p++;
-            json->pairs[json->count].key = key;
-            json->pairs[json->count].int_value = value;
-            json->pairs[json->count].is_int = 1;
-            json->count++;
-        }
-        
-        skip_whitespace(&p);
-        if (*p == ',') p++;
-    }
-    
+    return json_parse_n(text, text ? strlen(text) : 0);
+}
+
+WynJson* json_parse_file(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        snprintf(json_error_buf, sizeof(json_error_buf), "cannot open %s", path);
+        return NULL;
+    }
+    char* text = NULL;
+    size_t len = 0;
+    size_t cap = 0;
+    for (;;) {
+        if (cap - len < 65536) {
+            cap = cap ? cap * 2 : 65536;
+            char* grown = realloc(text, cap);
+            if (!grown) {
+                free(text);
+                fclose(file);
+                return NULL;
+            }
+            text = grown;
+        }
+        size_t n = fread(text + len, 1, cap - len, file);
+        if (n == 0) break;
+        len += n;
+    }
+    fclose(file);
+    WynJson* json = json_parse_n(text, len);
+    free(text);
     return json;
 }
 
-char* json_get_string(WynJson* json, const char* key) {
-    for (int i = 0; i < json->count; i++) {
-        if (strcmp(json->pairs[i].key, key) == 0 && !json->pairs[i].is_int) {
-            return json->pairs[i].str_value;
+void json_free(WynJson* json) {
+    // Nodes below the root belong to its arena
+    if (!json || !json->is_root) return;
+    JsonDoc* doc = (JsonDoc*)json;
+    json_free_chunks(doc->chunks);
+    free(doc);
+}
+
+// ---------------------------------------------------------------------------
+// Access
+
+WynJsonType json_type(const WynJson* json) {
+    return json ? (WynJsonType)json->type : JSON_NULL;
+}
+
+size_t json_len(const WynJson* json) {
+    if (!json) return 0;
+    if (json->type == JSON_ARRAY || json->type == JSON_OBJECT || json->type == JSON_STRING) return json->len;
+    return 0;
+}
+
+WynJson* json_object_get_n(WynJson* json, const char* key, size_t key_len) {
+    if (!json || json->type != JSON_OBJECT || !key) return NULL;
+    uint32_t hash = json_hash(key, key_len);
+    JsonMember* members = json->members;
+    if (json->len > JSON_INDEX_MIN) {
+        size_t cap = json_index_cap(json->len);
+        uint32_t* index = (uint32_t*)(members + json->len);
+        size_t slot = hash & (cap - 1);
+        while (index[slot]) {
+            JsonMember* m = &members[index[slot] - 1];
+            if (m->hash == hash && m->key_len == key_len && memcmp(m->key, key, key_len) == 0) {
+                return &m->value;
+            }
+            slot = (slot + 1) & (cap - 1);
+        }
+        return NULL;
+    }
+    for (uint32_t i = 0; i < json->len; i++) {
+        JsonMember* m = &members[i];
+        if (m->hash == hash && m->key_len == key_len && memcmp(m->key, key, key_len) == 0) {
+            return &m->value;
         }
     }
     return NULL;
 }
 
+WynJson* json_object_get(WynJson* json, const char* key) {
+    return key ? json_object_get_n(json, key, strlen(key)) : NULL;
+}
+
+const char* json_object_key(WynJson* json, size_t index) {
+    if (!json || json->type != JSON_OBJECT || index >= json->len) return NULL;
+    return json->members[index].key;
+}
+
+WynJson* json_object_value(WynJson* json, size_t index) {
+    if (!json || json->type != JSON_OBJECT || index >= json->len) return NULL;
+    return &json->members[index].value;
+}
+
+WynJson* json_array_get(WynJson* json, size_t index) {
+    if (!json || json->type != JSON_ARRAY || index >= json->len) return NULL;
+    return &json->items[index];
+}
+
+const char* json_string(const WynJson* json) {
+    return json && json->type == JSON_STRING ? json->string : NULL;
+}
+
+long long json_int(const WynJson* json) {
+    if (!json || json->type != JSON_NUMBER) return 0;
+    return json->is_int ? json->integer : (long long)json->number;
+}
+
+double json_number(const WynJson* json) {
+    if (!json || json->type != JSON_NUMBER) return 0.0;
+    return json->is_int ? (double)json->integer : json->number;
+}
+
+int json_bool(const WynJson* json) {
+    return json && json->type == JSON_BOOL ? json->boolean : 0;
+}
+
+char* json_get_string(WynJson* json, const char* key) {
+    return (char*)json_string(json_object_get(json, key));
+}
+
 int json_get_int(WynJson* json, const char* key) {
-    for (int i = 0; i < json->count; i++) {
-        if (strcmp(json->pairs[i].key, key) == 0 && json->pairs[i].is_int) {
-            return json->pairs[i].int_value;
+    return (int)json_int(json_object_get(json, key));
+}
+
+// ---------------------------------------------------------------------------
+// Serializer
+
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+    int failed;
+} JsonBuf;
+
+static int json_reserve(JsonBuf* buf, size_t extra) {
+    if (buf->failed) return 0;
+    if (buf->cap - buf->len >= extra) return 1;
+    size_t cap = buf->cap ? buf->cap : 256;
+    while (cap - buf->len < extra) cap *= 2;
+    char* grown = realloc(buf->data, cap);
+    if (!grown) {
+        buf->failed = 1;
+        return 0;
+    }
+    buf->data = grown;
+    buf->cap = cap;
+    return 1;
+}
+
+static void json_put(JsonBuf* buf, const char* s, size_t n) {
+    if (!json_reserve(buf, n)) return;
+    memcpy(buf->data + buf->len, s, n);
+    buf->len += n;
+}
+
+static void json_put_string(JsonBuf* buf, const char* s, size_t len) {
+    static const char hex[] = "0123456789abcdef";
+    const char* end = s + len;
+    json_put(buf, "\"", 1);
+    while (s < end) {
+        const char* q = json_scan_plain(s, end);
+        json_put(buf, s, (size_t)(q - s));
+        if (q >= end) break;
+        unsigned char c = (unsigned char)*q;
+        char esc[6] = {'\\', 0, 0, 0, 0, 0};
+        size_t n = 2;
+        switch (c) {
+            case '"': esc[1] = '"'; break;
+            case '\\': esc[1] = '\\'; break;
+            case '\n': esc[1] = 'n'; break;
+            case '\r': esc[1] = 'r'; break;
+            case '\t': esc[1] = 't'; break;
+            case '\b': esc[1] = 'b'; break;
+            case '\f': esc[1] = 'f'; break;
+            default:
+                esc[1] = 'u';
+                esc[2] = '0';
+                esc[3] = '0';
+                esc[4] = hex[c >> 4];
+                esc[5] = hex[c & 15];
+                n = 6;
         }
+        json_put(buf, esc, n);
+        s = q + 1;
     }
-    return 0;
+    json_put(buf, "\"", 1);
 }
 
-void json_free(WynJson* json) {
-    for (int i = 0; i < json->count; i++) {
-        free(json->pairs[i].key);
-        if (!json->pairs[i].is_int && json->pairs[i].str_value) {
-            free(json->pairs[i].str_value);
+static void json_put_number(JsonBuf* buf, const WynJson* json) {
+    char text[32];
+    int n;
+    if (json->is_int) {
+        n = snprintf(text, sizeof(text), "%lld", json->integer);
+    } else if (!isfinite(json->number)) {
+        n = snprintf(text, sizeof(text), "null");
+    } else {
+        // Shortest of 15-17 digits that reads back as the same double
+        n = snprintf(text, sizeof(text), "%.15g", json->number);
+        if (strtod(text, NULL) != json->number) n = snprintf(text, sizeof(text), "%.16g", json->number);
+        if (strtod(text, NULL) != json->number) n = snprintf(text, sizeof(text), "%.17g", json->number);
+    }
+    json_put(buf, text, (size_t)n);
+}
+
+static void json_put_value(JsonBuf* buf, const WynJson* json) {
+    switch (json->type) {
+        case JSON_NULL:
+            json_put(buf, "null", 4);
+            break;
+        case JSON_BOOL:
+            if (json->boolean) json_put(buf, "true", 4);
+            else json_put(buf, "false", 5);
+            break;
+        case JSON_NUMBER:
+            json_put_number(buf, json);
+            break;
+        case JSON_STRING:
+            json_put_string(buf, json->string, json->len);
+            break;
+        case JSON_ARRAY:
+            json_put(buf, "[", 1);
+            for (uint32_t i = 0; i < json->len; i++) {
+                if (i) json_put(buf, ",", 1);
+                json_put_value(buf, &json->items[i]);
+            }
+            json_put(buf, "]", 1);
+            break;
+        case JSON_OBJECT:
+            json_put(buf, "{", 1);
+            for (uint32_t i = 0; i < json->len; i++) {
+                if (i) json_put(buf, ",", 1);
+                json_put_string(buf, json->members[i].key, json->members[i].key_len);
+                json_put(buf, ":", 1);
+                json_put_value(buf, &json->members[i].value);
+            }
+            json_put(buf, "}", 1);
+            break;
+    }
+}
+
+char* json_stringify(const WynJson* json, size_t* len_out) {
+    JsonBuf buf = {0};
+    if (json) json_put_value(&buf, json);
+    else json_put(&buf, "null", 4);
+    json_put(&buf, "", 1);
+    if (buf.failed) {
+        free(buf.data);
+        return NULL;
+    }
+    if (len_out) *len_out = buf.len - 1;
+    return buf.data;
+}
+
+// ---------------------------------------------------------------------------
+// Pull parser
+
+#define READER_BUF_SIZE 65536
+
+enum { READER_VALUE, READER_KEY, READER_AFTER, READER_DONE };
+
+struct WynJsonReader {
+    FILE* file;
+    int owns_file;
+    char* buf;
+    size_t pos;
+    size_t end;
+    int owns_buf;
+    char* stack;            // 'o' or 'a' per open container
+    int depth;
+    int stack_cap;
+    int state;
+    int first;              // Container just opened: its closer is allowed
+    char* str;              // Current key, string or number text
+    size_t str_len;
+    size_t str_cap;
+    WynJson value;
+    const char* error;
+};
+
+static WynJsonReader* json_reader_new(void) {
+    WynJsonReader* reader = calloc(1, sizeof(WynJsonReader));
+    if (!reader) return NULL;
+    reader->state = READER_VALUE;
+    return reader;
+}
+
+WynJsonReader* json_reader_from_file(FILE* file) {
+    if (!file) return NULL;
+    WynJsonReader* reader = json_reader_new();
+    if (!reader) return NULL;
+    reader->buf = malloc(READER_BUF_SIZE);
+    if (!reader->buf) {
+        free(reader);
+        return NULL;
+    }
+    reader->owns_buf = 1;
+    reader->file = file;
+    return reader;
+}
+
+WynJsonReader* json_reader_open(const char* path) {
+    FILE* file = path ? fopen(path, "rb") : NULL;
+    if (!file) return NULL;
+    WynJsonReader* reader = json_reader_from_file(file);
+    if (!reader) {
+        fclose(file);
+        return NULL;
+    }
+    reader->owns_file = 1;
+    return reader;
+}
+
+WynJsonReader* json_reader_from_string(const char* text, size_t len) {
+    if (!text) return NULL;
+    WynJsonReader* reader = json_reader_new();
+    if (!reader) return NULL;
+    reader->buf = (char*)text;
+    reader->end = len;
+    return reader;
+}
+
+void json_reader_free(WynJsonReader* reader) {
+    if (!reader) return;
+    if (reader->owns_file) fclose(reader->file);
+    if (reader->owns_buf) free(reader->buf);
+    free(reader->stack);
+    free(reader->str);
+    free(reader);
+}
+
+// Make at least one unread byte available; 0 at end of input
+static int reader_fill(WynJsonReader* reader) {
+    if (reader->pos < reader->end) return 1;
+    if (!reader->file) return 0;
+    size_t n = fread(reader->buf, 1, READER_BUF_SIZE, reader->file);
+    reader->pos = 0;
+    reader->end = n;
+    return n > 0;
+}
+
+static int reader_peek(WynJsonReader* reader) {
+    return reader_fill(reader) ? (unsigned char)reader->buf[reader->pos] : -1;
+}
+
+static void reader_skip_space(WynJsonReader* reader) {
+    while (reader_fill(reader)) {
+        const char* p = reader->buf + reader->pos;
+        const char* q = json_skip_space(p, reader->buf + reader->end);
+        reader->pos += (size_t)(q - p);
+        if (reader->pos < reader->end) return;
+    }
+}
+
+static int reader_append(WynJsonReader* reader, const char* s, size_t n) {
+    if (reader->str_cap - reader->str_len <= n) {
+        size_t cap = reader->str_cap ? reader->str_cap : 256;
+        while (cap - reader->str_len <= n) cap *= 2;
+        char* grown = realloc(reader->str, cap);
+        if (!grown) return 0;
+        reader->str = grown;
+        reader->str_cap = cap;
+    }
+    memcpy(reader->str + reader->str_len, s, n);
+    reader->str_len += n;
+    reader->str[reader->str_len] = '\0';
+    return 1;
+}
+
+static WynJsonEvent reader_fail(WynJsonReader* reader, const char* message) {
+    if (!reader->error) reader->error = message;
+    return JSON_EVENT_ERROR;
+}
+
+static int reader_append_cp(WynJsonReader* reader, uint32_t cp) {
+    char out[4];
+    return reader_append(reader, out, json_utf8(cp, out));
+}
+
+static int reader_hex4(WynJsonReader* reader, uint32_t* out) {
+    char raw[4];
+    for (int i = 0; i < 4; i++) {
+        int c = reader_peek(reader);
+        if (c < 0) return 0;
+        raw[i] = (char)c;
+        reader->pos++;
+    }
+    return json_hex4(raw, out);
+}
+
+// Decode the escape after a backslash; it may straddle a refill
+static int reader_escape(WynJsonReader* reader) {
+    int c = reader_peek(reader);
+    if (c < 0) return 0;
+    reader->pos++;
+    uint32_t cp;
+    if (c != 'u' || !reader_hex4(reader, &cp)) {
+        if (c == 'u') return 0;
+        char letter = (char)c;
+        char out[4];
+        size_t written;
+        if (!json_unescape(&letter, &letter + 1, out, &written)) return 0;
+        return reader_append(reader, out, written);
+    }
+    for (;;) {
+        if (cp < 0xD800 || cp > 0xDFFF) return reader_append_cp(reader, cp);
+        if (cp >= 0xDC00 || reader_peek(reader) != '\\') return reader_append_cp(reader, 0xFFFD);
+        // High surrogate followed by another escape: a low surrogate completes it
+        reader->pos++;
+        if (reader_peek(reader) != 'u') {
+            if (!reader_append_cp(reader, 0xFFFD)) return 0;
+            return reader_escape(reader);
+        }
+        reader->pos++;
+        uint32_t low;
+        if (!reader_hex4(reader, &low)) return 0;
+        if (low >= 0xDC00 && low <= 0xDFFF) {
+            return reader_append_cp(reader, 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00));
         }
+        if (!reader_append_cp(reader, 0xFFFD)) return 0;
+        cp = low;
+    }
+}
+
+static int reader_string(WynJsonReader* reader) {
+    reader->pos++;  // Opening quote
+    reader->str_len = 0;
+    if (!reader_append(reader, "", 0)) return 0;
+    for (;;) {
+        if (!reader_fill(reader)) return reader_fail(reader, "unterminated string"), 0;
+        const char* p = reader->buf + reader->pos;
+        const char* q = json_scan_plain(p, reader->buf + reader->end);
+        if (q > p && !reader_append(reader, p, (size_t)(q - p))) return 0;
+        reader->pos += (size_t)(q - p);
+        if (reader->pos >= reader->end) continue;
+        char c = reader->buf[reader->pos++];
+        if (c == '"') return 1;
+        if (c != '\\') return reader_fail(reader, "control character in string"), 0;
+        if (!reader_escape(reader)) return reader_fail(reader, "invalid escape"), 0;
+    }
+}
+
+static int reader_number(WynJsonReader* reader) {
+    reader->str_len = 0;
+    for (;;) {
+        int c = reader_peek(reader);
+        if (!((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E')) break;
+        char ch = (char)c;
+        if (!reader_append(reader, &ch, 1)) return 0;
+        reader->pos++;
+    }
+    const char* end = reader->str + reader->str_len;
+    if (!reader->str_len || json_scan_number(reader->str, end, &reader->value) != end) {
+        return reader_fail(reader, "invalid number"), 0;
     }
-    free(json);
+    return 1;
+}
+
+static int reader_literal(WynJsonReader* reader, const char* word) {
+    for (const char* w = word; *w; w++) {
+        if (reader_peek(reader) != (unsigned char)*w) return reader_fail(reader, "invalid literal"), 0;
+        reader->pos++;
+    }
+    return 1;
+}
+
+static WynJsonEvent reader_open(WynJsonReader* reader, char kind) {
+    if (reader->depth >= JSON_MAX_DEPTH) return reader_fail(reader, "nesting too deep");
+    if (reader->depth == reader->stack_cap) {
+        int cap = reader->stack_cap ? reader->stack_cap * 2 : 32;
+        char* grown = realloc(reader->stack, (size_t)cap);
+        if (!grown) return reader_fail(reader, "out of memory");
+        reader->stack = grown;
+        reader->stack_cap = cap;
+    }
+    reader->stack[reader->depth++] = kind;
+    reader->pos++;
+    reader->first = 1;
+    reader->state = kind == 'o' ? READER_KEY : READER_VALUE;
+    return kind == 'o' ? JSON_EVENT_OBJECT_START : JSON_EVENT_ARRAY_START;
+}
+
+static void reader_after_value(WynJsonReader* reader) {
+    reader->first = 0;
+    reader->state = reader->depth ? READER_AFTER : READER_DONE;
+}
+
+static WynJsonEvent reader_close(WynJsonReader* reader) {
+    char kind = reader->stack[--reader->depth];
+    reader->pos++;
+    reader_after_value(reader);
+    return kind == 'o' ? JSON_EVENT_OBJECT_END : JSON_EVENT_ARRAY_END;
+}
+
+WynJsonEvent json_reader_next(WynJsonReader* reader) {
+    if (!reader) return JSON_EVENT_ERROR;
+    if (reader->error) return JSON_EVENT_ERROR;
+    reader_skip_space(reader);
+    int c = reader_peek(reader);
+    char top = reader->depth ? reader->stack[reader->depth - 1] : 0;
+
+    switch (reader->state) {
+        case READER_DONE:
+            return c < 0 ? JSON_EVENT_END : reader_fail(reader, "trailing characters");
+        case READER_AFTER:
+            if ((c == '}' && top == 'o') || (c == ']' && top == 'a')) return reader_close(reader);
+            if (c != ',') return reader_fail(reader, c < 0 ? "unexpected end of input" : "expected ',' or a closing bracket");
+            reader->pos++;
+            reader->state = top == 'o' ? READER_KEY : READER_VALUE;
+            reader_skip_space(reader);
+            c = reader_peek(reader);
+            if (reader->state == READER_VALUE) break;
+            /* fall through */
+        case READER_KEY:
+            if (c == '}' && reader->first) return reader_close(reader);
+            if (c != '"') return reader_fail(reader, "expected key");
+            if (!reader_string(reader)) return reader_fail(reader, "out of memory");
+            reader_skip_space(reader);
+            if (reader_peek(reader) != ':') return reader_fail(reader, "expected ':'");
+            reader->pos++;
+            reader->first = 0;
+            reader->state = READER_VALUE;
+            return JSON_EVENT_KEY;
+        case READER_VALUE:
+            if (c == ']' && reader->first && top == 'a') return reader_close(reader);
+            break;
+    }
+
+    // A value
+    WynJsonEvent event;
+    switch (c) {
+        case -1:
+            return reader_fail(reader, "unexpected end of input");
+        case '{':
+            return reader_open(reader, 'o');
+        case '[':
+            return reader_open(reader, 'a');
+        case '"':
+            if (!reader_string(reader)) return reader_fail(reader, "out of memory");
+            event = JSON_EVENT_STRING;
+            break;
+        case 't':
+        case 'f':
+            if (!reader_literal(reader, c == 't' ? "true" : "false")) return JSON_EVENT_ERROR;
+            reader->value.type = JSON_BOOL;
+            reader->value.boolean = c == 't';
+            event = JSON_EVENT_BOOL;
+            break;
+        case 'n':
+            if (!reader_literal(reader, "null")) return JSON_EVENT_ERROR;
+            event = JSON_EVENT_NULL;
+            break;
+        default:
+            if (!reader_number(reader)) return reader_fail(reader, "out of memory");
+            event = JSON_EVENT_NUMBER;
+            break;
+    }
+    reader_after_value(reader);
+    return event;
+}
+
+const char* json_reader_string(WynJsonReader* reader, size_t* len_out) {
+    if (!reader || !reader->str) return NULL;
+    if (len_out) *len_out = reader->str_len;
+    return reader->str;
+}
+
+long long json_reader_int(WynJsonReader* reader) {
+    return reader ? json_int(&reader->value) : 0;
+}
+
+double json_reader_number(WynJsonReader* reader) {
+    return reader ? json_number(&reader->value) : 0.0;
+}
+
+int json_reader_bool(WynJsonReader* reader) {
+    return reader ? json_bool(&reader->value) : 0;
+}
+
+int json_reader_depth(WynJsonReader* reader) {
+    return reader ? reader->depth : 0;
+}
+
+const char* json_reader_error(WynJsonReader* reader) {
+    return reader ? reader->error : NULL;
 }
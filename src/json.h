@@ -1,11 +1,84 @@
 #ifndef WYN_JSON_H
 #define WYN_JSON_H
 
+#include <stddef.h>
+#include <stdio.h>
+
+// JSON documents. json_parse builds the whole tree in one arena owned by
+// the root; every node, key and string below it is freed by json_free(root).
+// Objects keep their members in document order and look keys up by hash.
 typedef struct WynJson WynJson;
 
+typedef enum {
+    JSON_NULL,
+    JSON_BOOL,
+    JSON_NUMBER,
+    JSON_STRING,
+    JSON_ARRAY,
+    JSON_OBJECT
+} WynJsonType;
+
+// NULL on malformed input; json_error() says why
 WynJson* json_parse(const char* text);
+WynJson* json_parse_n(const char* text, size_t len);
+WynJson* json_parse_file(const char* path);
+const char* json_error(void);
+void json_free(WynJson* json);
+
+WynJsonType json_type(const WynJson* json);
+// Items of an array, members of an object, bytes of a string; 0 otherwise
+size_t json_len(const WynJson* json);
+WynJson* json_object_get(WynJson* json, const char* key);
+WynJson* json_object_get_n(WynJson* json, const char* key, size_t key_len);
+const char* json_object_key(WynJson* json, size_t index);
+WynJson* json_object_value(WynJson* json, size_t index);
+WynJson* json_array_get(WynJson* json, size_t index);
+
+// Scalar values; a node of another type yields NULL, 0 or 0.0
+const char* json_string(const WynJson* json);
+long long json_int(const WynJson* json);
+double json_number(const WynJson* json);
+int json_bool(const WynJson* json);
+
+// Members of an object by key
 char* json_get_string(WynJson* json, const char* key);
 int json_get_int(WynJson* json, const char* key);
-void json_free(WynJson* json);
+
+// Compact JSON text for json, malloc'd; *len_out (if given) gets its length
+char* json_stringify(const WynJson* json, size_t* len_out);
+
+// Pull parser for documents too large to hold in memory. Each call to
+// json_reader_next returns one event; keys and strings are available from
+// json_reader_string until the next call. Only the current token is buffered.
+typedef struct WynJsonReader WynJsonReader;
+
+typedef enum {
+    JSON_EVENT_ERROR = -1,
+    JSON_EVENT_END = 0,
+    JSON_EVENT_OBJECT_START,
+    JSON_EVENT_OBJECT_END,
+    JSON_EVENT_ARRAY_START,
+    JSON_EVENT_ARRAY_END,
+    JSON_EVENT_KEY,
+    JSON_EVENT_STRING,
+    JSON_EVENT_NUMBER,
+    JSON_EVENT_BOOL,
+    JSON_EVENT_NULL
+} WynJsonEvent;
+
+WynJsonReader* json_reader_open(const char* path);
+// Reads from file, which stays open after json_reader_free
+WynJsonReader* json_reader_from_file(FILE* file);
+// Reads from text, which must outlive the reader
+WynJsonReader* json_reader_from_string(const char* text, size_t len);
+WynJsonEvent json_reader_next(WynJsonReader* reader);
+const char* json_reader_string(WynJsonReader* reader, size_t* len_out);
+long long json_reader_int(WynJsonReader* reader);
+double json_reader_number(WynJsonReader* reader);
+int json_reader_bool(WynJsonReader* reader);
+// Containers open around the current event
+int json_reader_depth(WynJsonReader* reader);
+const char* json_reader_error(WynJsonReader* reader);
+void json_reader_free(WynJsonReader* reader);
 
 #endif
@@ -1,19 +1,122 @@
 // JSON Runtime Wrappers for Wyn
 #include "json.h"
+#include "string_runtime.h"
 
 // Wrapper functions with Wyn naming convention
 WynJson* Json_parse(const char* text) {
-    return json_parse(text);
+    return json_parse_n(text, wyn_str_len(text));
+}
+
+WynJson* Json_parse_file(const char* path) {
+    return json_parse_file(path);
+}
+
+// Why the last parse failed, or NULL
+const char* Json_error(void) {
+    return json_error();
+}
+
+// Nested values; NULL when missing or of the wrong kind
+WynJson* Json_get(WynJson* json, const char* key) {
+    return json_object_get_n(json, key, wyn_str_len(key));
+}
+
+WynJson* Json_at(WynJson* json, int index) {
+    return index < 0 ? NULL : json_array_get(json, (size_t)index);
+}
+
+int Json_len(WynJson* json) {
+    return (int)json_len(json);
+}
+
+int Json_has(WynJson* json, const char* key) {
+    return Json_get(json, key) != NULL;
+}
+
+// 0 null, 1 bool, 2 number, 3 string, 4 array, 5 object
+int Json_kind(WynJson* json) {
+    return (int)json_type(json);
 }
 
 char* Json_get_string(WynJson* json, const char* key) {
-    return json_get_string(json, key);
+    return (char*)json_string(Json_get(json, key));
 }
 
 int Json_get_int(WynJson* json, const char* key) {
-    return json_get_int(json, key);
+    return (int)json_int(Json_get(json, key));
+}
+
+double Json_get_float(WynJson* json, const char* key) {
+    return json_number(Json_get(json, key));
+}
+
+int Json_get_bool(WynJson* json, const char* key) {
+    return json_bool(Json_get(json, key));
+}
+
+char* Json_as_string(WynJson* json) {
+    return (char*)json_string(json);
+}
+
+int Json_as_int(WynJson* json) {
+    return (int)json_int(json);
+}
+
+double Json_as_float(WynJson* json) {
+    return json_number(json);
+}
+
+int Json_as_bool(WynJson* json) {
+    return json_bool(json);
+}
+
+const char* Json_stringify(WynJson* json) {
+    return json_stringify(json, NULL);
 }
 
 void Json_free(WynJson* json) {
     json_free(json);
 }
+
+// Streaming reader: Json::reader_next returns the JSON_EVENT_* codes
+WynJsonReader* Json_reader_open(const char* path) {
+    return json_reader_open(path);
+}
+
+WynJsonReader* Json_reader_from_string(const char* text) {
+    return json_reader_from_string(text, wyn_str_len(text));
+}
+
+int Json_reader_next(WynJsonReader* reader) {
+    return (int)json_reader_next(reader);
+}
+
+const char* Json_reader_string(WynJsonReader* reader) {
+    size_t len;
+    const char* s = json_reader_string(reader, &len);
+    return s ? wyn_str_new(s, len) : NULL;
+}
+
+int Json_reader_int(WynJsonReader* reader) {
+    return (int)json_reader_int(reader);
+}
+
+double Json_reader_float(WynJsonReader* reader) {
+    return json_reader_number(reader);
+}
+
+int Json_reader_bool(WynJsonReader* reader) {
+    return json_reader_bool(reader);
+}
+
+int Json_reader_depth(WynJsonReader* reader) {
+    return json_reader_depth(reader);
+}
+
+const char* Json_reader_error(WynJsonReader* reader) {
+    return json_reader_error(reader);
+}
+
+void Json_reader_close(WynJsonReader* reader) {
+    json_reader_free(reader);
+}
@@ -4,6 +4,7 @@
 #include <ctype.h>
 #include "common.h"
 #include "error.h"
+#include "intern.h"
 
 typedef struct {
     const char* start;
@@ -66,6 +67,7 @@ static Token make_token(WynTokenType type) {
     token.start = lexer.start;
     token.length = (int)(lexer.current - lexer.start);
     token.line = lexer.line;
+    token.id = 0;
     return token;
 }
 
@@ -168,6 +170,7 @@ static WynTokenType keyword_type(const char* start, int length) {
         case 's': 
             if (length == 6 && memcmp(start, "struct", 6) == 0) return TOKEN_STRUCT;
             if (length == 5 && memcmp(start, "spawn", 5) == 0) return TOKEN_SPAWN;
+            if (length == 5 && memcmp(start, "scope", 5) == 0) return TOKEN_SCOPE;
             if (length == 4 && memcmp(start, "self", 4) == 0) return TOKEN_SELF;
             break;
         case 'S':
@@ -193,7 +196,9 @@ static Token identifier() {
     while (isalnum(peek()) || peek() == '_') advance();
     int length = (int)(lexer.current - lexer.start);
     WynTokenType type = keyword_type(lexer.start, length);
-    return make_token(type);
+    Token token = make_token(type);
+    if (type == TOKEN_IDENT) token.id = intern_name(lexer.start, length);
+    return token;
 }
 
 static Token string() {
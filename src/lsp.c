@@ -1,338 +1,1216 @@
-// Production-ready LSP server for Wyn
-// Implements Language Server Protocol for IDE integration
+// Language server for Wyn (LSP, JSON-RPC 2.0 over stdin/stdout)
+//
+// The main thread reads messages and applies text edits. A single analysis
+// thread parses and checks a document once its edits have paused for
+// DIAGNOSTIC_DELAY_MS and publishes the diagnostics. Documents are kept as
+// top-level chunks (one declaration with its leading comments), each with
+// the statements parsed from it; an edit re-parses only the chunks whose
+// text changed. Tokens in a chunk count lines from the chunk's first line,
+// so chunks that merely moved keep their ASTs.
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
-
-// Forward declarations for compiler integration
-extern void* parse_file(const char* filename);
-extern void* check_file(void* ast);
-extern void get_diagnostics(void* ast, char* buffer, size_t size);
-extern int find_definition(void* ast, int line, int col, char* buffer, size_t size);
-extern int find_references(void* ast, int line, int col, char* buffer, size_t size);
-extern int get_hover_info(void* ast, int line, int col, char* buffer, size_t size);
-extern int get_completions(void* ast, int line, int col, char* buffer, size_t size);
-extern int rename_symbol(void* ast, int line, int col, const char* new_name, char* buffer, size_t size);
-extern int format_document(const char* filename, char* buffer, size_t size);
-
-// Document cache
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include "ast.h"
+#include "error.h"
+#include "json.h"
+#include "memory.h"
+#include "module.h"
+#include "module_registry.h"
+#include "types.h"
+
+extern void init_lexer(const char* source);
+extern void init_parser();
+extern Program* parse_program();
+extern bool parser_had_error();
+extern void set_parser_filename(const char* filename);
+extern void init_checker();
+extern void check_program(Program* prog);
+extern Stmt* checker_current_decl();
+
+#define DIAGNOSTIC_DELAY_MS 150
+
+typedef struct {
+    int line;               // document line for check errors, chunk line for parse errors
+    char* message;
+} Diagnostic;
+
+typedef struct {
+    char* text;             // NUL-terminated copy; the AST's tokens point into it
+    size_t len;
+    uint64_t hash;
+    int start_line;         // first document line, updated when the chunk moves
+    int line_count;
+    Program* prog;          // statements parsed from text
+    Diagnostic* parse_errors;
+    int parse_error_count;
+    int parse_error_cap;
+} Chunk;
+
 typedef struct {
-    char uri[512];
-    char* content;
-    void* ast;
-    void* checked_ast;
+    char* uri;
+    char* path;
+    // Guarded by docs_lock
+    char* text;
+    size_t len;
+    size_t cap;
+    int version;
+    bool dirty;
+    long long due_ms;       // analyse no earlier than this
+    // Guarded by analysis_lock
+    Chunk* chunks;
+    int chunk_count;
+    Program program;        // statements of every chunk, as last checked
+    Diagnostic* check_errors;
+    int check_error_count;
+    int check_error_cap;
 } Document;
 
-static Document docs[100];
+static Document** docs = NULL;
 static int doc_count = 0;
+static int doc_cap = 0;
 
-static Document* find_document(const char* uri) {
-    for (int i = 0; i < doc_count; i++) {
-        if (strcmp(docs[i].uri, uri) == 0) return &docs[i];
+static pthread_mutex_t docs_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t docs_changed;
+static pthread_mutex_t analysis_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t write_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool stopping = false;
+
+static FILE* protocol_out = NULL;
+
+// Where diagnostics reported by the parser and checker go (analysis thread)
+static Chunk* parsing_chunk = NULL;
+static Document* checking_doc = NULL;
+
+static long long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// ---------------------------------------------------------------------------
+// Output buffers and message framing
+
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+} Buf;
+
+static void buf_append(Buf* buf, const char* data, size_t len) {
+    if (buf->len + len + 1 > buf->cap) {
+        size_t cap = buf->cap ? buf->cap : 256;
+        while (buf->len + len + 1 > cap) cap *= 2;
+        buf->data = realloc(buf->data, cap);
+        buf->cap = cap;
     }
-    return NULL;
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+    buf->data[buf->len] = '\0';
+}
+
+static void buf_puts(Buf* buf, const char* s) {
+    buf_append(buf, s, strlen(s));
 }
 
-static Document* add_document(const char* uri, const char* content) {
-    if (doc_count >= 100) return NULL;
-    Document* doc = &docs[doc_count++];
-    strncpy(doc->uri, uri, sizeof(doc->uri) - 1);
-    doc->content = strdup(content);
-    doc->ast = NULL;
-    doc->checked_ast = NULL;
-    return doc;
+static void buf_printf(Buf* buf, const char* fmt, ...) {
+    char small[256];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(small, sizeof(small), fmt, args);
+    va_end(args);
+    if (n < 0) return;
+    if ((size_t)n < sizeof(small)) {
+        buf_append(buf, small, (size_t)n);
+        return;
+    }
+    char* big = malloc((size_t)n + 1);
+    va_start(args, fmt);
+    vsnprintf(big, (size_t)n + 1, fmt, args);
+    va_end(args);
+    buf_append(buf, big, (size_t)n);
+    free(big);
+}
+
+static void buf_json_string(Buf* buf, const char* s, size_t len) {
+    buf_append(buf, "\"", 1);
+    size_t run = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        buf_append(buf, s + run, i - run);
+        run = i + 1;
+        switch (c) {
+            case '"': buf_puts(buf, "\\\""); break;
+            case '\\': buf_puts(buf, "\\\\"); break;
+            case '\n': buf_puts(buf, "\\n"); break;
+            case '\r': buf_puts(buf, "\\r"); break;
+            case '\t': buf_puts(buf, "\\t"); break;
+            default: buf_printf(buf, "\\u%04x", c); break;
+        }
+    }
+    buf_append(buf, s + run, len - run);
+    buf_append(buf, "\"", 1);
+}
+
+// Content-Length counts the body's bytes exactly and nothing follows it
+static void send_message(const Buf* body) {
+    pthread_mutex_lock(&write_lock);
+    fprintf(protocol_out, "Content-Length: %zu\r\n\r\n", body->len);
+    fwrite(body->data, 1, body->len, protocol_out);
+    fflush(protocol_out);
+    pthread_mutex_unlock(&write_lock);
 }
 
-// Simple JSON-RPC message handling
 static void send_response(const char* id, const char* result) {
-    printf("Content-Length: %zu\r\n\r\n", strlen(result) + 50);
-    printf("{\"jsonrpc\":\"2.0\",\"id\":%s,\"result\":%s}\n", id, result);
-    fflush(stdout);
-}
-
-static void send_notification(const char* method, const char* params) {
-    char msg[4096];
-    snprintf(msg, sizeof(msg), "{\"jsonrpc\":\"2.0\",\"method\":\"%s\",\"params\":%s}", 
-             method, params);
-    printf("Content-Length: %zu\r\n\r\n%s\n", strlen(msg), msg);
-    fflush(stdout);
-}
-
-static char* read_message() {
-    char header[256];
-    int content_length = 0;
-    
-    // Read headers
-    while (fgets(header, sizeof(header), stdin)) {
-        if (strcmp(header, "\r\n") == 0) break;
-        if (strncmp(header, "Content-Length:", 15) == 0) {
-            content_length = atoi(header + 15);
+    Buf msg = {0};
+    buf_printf(&msg, "{\"jsonrpc\":\"2.0\",\"id\":%s,\"result\":", id);
+    buf_puts(&msg, result);
+    buf_puts(&msg, "}");
+    send_message(&msg);
+    free(msg.data);
+}
+
+static void send_error(const char* id, int code, const char* message) {
+    Buf msg = {0};
+    buf_printf(&msg, "{\"jsonrpc\":\"2.0\",\"id\":%s,\"error\":{\"code\":%d,\"message\":", id, code);
+    buf_json_string(&msg, message, strlen(message));
+    buf_puts(&msg, "}}");
+    send_message(&msg);
+    free(msg.data);
+}
+
+// Reads one message body; NULL at end of input
+static char* read_message(size_t* len_out) {
+    char header[1024];
+    long content_length = -1;
+    for (;;) {
+        if (!fgets(header, sizeof(header), stdin)) return NULL;
+        if (strcmp(header, "\r\n") == 0 || strcmp(header, "\n") == 0) {
+            if (content_length >= 0) break;
+            continue;
+        }
+        if (strncasecmp(header, "Content-Length:", 15) == 0) {
+            content_length = strtol(header + 15, NULL, 10);
         }
     }
-    
-    if (content_length == 0) return NULL;
-    
-    // Read content
-    char* content = malloc(content_length + 1);
-    if (fread(content, 1, content_length, stdin) != (size_t)content_length) {
+
+    char* content = malloc((size_t)content_length + 1);
+    if (fread(content, 1, (size_t)content_length, stdin) != (size_t)content_length) {
         free(content);
         return NULL;
     }
     content[content_length] = '\0';
-    
+    *len_out = (size_t)content_length;
     return content;
 }
 
+// ---------------------------------------------------------------------------
+// Positions. LSP counts characters in UTF-16 code units.
+
+static size_t line_start_offset(const char* text, size_t len, int line) {
+    size_t pos = 0;
+    for (int l = 0; l < line; l++) {
+        const char* nl = memchr(text + pos, '\n', len - pos);
+        if (!nl) return len;
+        pos = (size_t)(nl - text) + 1;
+    }
+    return pos;
+}
+
+static size_t position_offset(const char* text, size_t len, int line, int character) {
+    size_t pos = line_start_offset(text, len, line);
+    int units = 0;
+    while (pos < len && text[pos] != '\n' && units < character) {
+        unsigned char c = (unsigned char)text[pos];
+        int bytes = c < 0x80 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+        units += bytes == 4 ? 2 : 1;
+        pos += (size_t)bytes;
+    }
+    return pos > len ? len : pos;
+}
+
+static int utf16_length(const char* s, size_t bytes) {
+    int units = 0;
+    for (size_t i = 0; i < bytes; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if ((c & 0xC0) == 0x80) continue;
+        units += c >= 0xF0 ? 2 : 1;
+    }
+    return units;
+}
+
+// Range covering the text of a line, without its indentation
+static void buf_line_range(Buf* buf, const char* text, size_t len, int line) {
+    size_t start = line_start_offset(text, len, line);
+    size_t end = start;
+    while (end < len && text[end] != '\n' && text[end] != '\r') end++;
+    size_t first = start;
+    while (first < end && (text[first] == ' ' || text[first] == '\t')) first++;
+    buf_printf(buf, "{\"start\":{\"line\":%d,\"character\":%d},\"end\":{\"line\":%d,\"character\":%d}}",
+               line, utf16_length(text + start, first - start),
+               line, utf16_length(text + start, end - start));
+}
+
+static void buf_token_range(Buf* buf, const Chunk* chunk, Token tok) {
+    const char* line_start = tok.start;
+    while (line_start > chunk->text && line_start[-1] != '\n') line_start--;
+    int line = chunk->start_line + tok.line - 1;
+    int col = utf16_length(line_start, (size_t)(tok.start - line_start));
+    buf_printf(buf, "{\"start\":{\"line\":%d,\"character\":%d},\"end\":{\"line\":%d,\"character\":%d}}",
+               line, col, line, col + utf16_length(tok.start, (size_t)tok.length));
+}
+
+// ---------------------------------------------------------------------------
+// Documents
+
+static uint64_t hash_bytes(const char* s, size_t len) {
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static char* uri_to_path(const char* uri) {
+    if (strncmp(uri, "file://", 7) == 0) uri += 7;
+    char* path = malloc(strlen(uri) + 1);
+    char* out = path;
+    for (const char* p = uri; *p; p++) {
+        if (p[0] == '%' && p[1] && p[2]) {
+            char hex[3] = {p[1], p[2], 0};
+            *out++ = (char)strtol(hex, NULL, 16);
+            p += 2;
+        } else {
+            *out++ = *p;
+        }
+    }
+    *out = '\0';
+    return path;
+}
+
+// Callers hold docs_lock
+static Document* find_document(const char* uri) {
+    for (int i = 0; i < doc_count; i++) {
+        if (strcmp(docs[i]->uri, uri) == 0) return docs[i];
+    }
+    return NULL;
+}
+
+static void set_text(Document* doc, const char* text, size_t len) {
+    if (len + 1 > doc->cap) {
+        doc->cap = len + 1 > 2 * doc->cap ? len + 1 : 2 * doc->cap;
+        doc->text = realloc(doc->text, doc->cap);
+    }
+    memcpy(doc->text, text, len);
+    doc->len = len;
+    doc->text[len] = '\0';
+}
+
+// Replaces [start, end) with text
+static void splice_text(Document* doc, size_t start, size_t end, const char* text, size_t len) {
+    size_t new_len = doc->len - (end - start) + len;
+    if (new_len + 1 > doc->cap) {
+        doc->cap = new_len + 1 > 2 * doc->cap ? new_len + 1 : 2 * doc->cap;
+        doc->text = realloc(doc->text, doc->cap);
+    }
+    memmove(doc->text + start + len, doc->text + end, doc->len - end + 1);
+    memcpy(doc->text + start, text, len);
+    doc->len = new_len;
+}
+
+static void schedule_analysis(Document* doc, int delay_ms) {
+    doc->dirty = true;
+    doc->due_ms = now_ms() + delay_ms;
+    pthread_cond_signal(&docs_changed);
+}
+
+static void free_diagnostics(Diagnostic* diags, int count) {
+    for (int i = 0; i < count; i++) free(diags[i].message);
+    free(diags);
+}
+
+static void free_chunk(Chunk* chunk) {
+    free_program(chunk->prog);
+    free_diagnostics(chunk->parse_errors, chunk->parse_error_count);
+    free(chunk->text);
+}
+
+static void free_document(Document* doc) {
+    for (int i = 0; i < doc->chunk_count; i++) free_chunk(&doc->chunks[i]);
+    free(doc->chunks);
+    free(doc->program.stmts);
+    free_diagnostics(doc->check_errors, doc->check_error_count);
+    free(doc->text);
+    free(doc->path);
+    free(doc->uri);
+    free(doc);
+}
+
+// ---------------------------------------------------------------------------
+// Chunks
+
+typedef struct {
+    size_t start;
+    size_t end;
+    int line;
+} Span;
+
+// Splits text into top-level chunks. A chunk starts at a line at brace depth
+// zero once the previous chunk has ended in ';' or '}', so a statement that
+// continues onto the next line is never cut. Blank lines stay with the chunk
+// before them and comments with the chunk after them.
+static int split_chunks(const char* text, size_t len, Span** out) {
+    int cap = 64, count = 0;
+    Span* spans = malloc(sizeof(Span) * (size_t)cap);
+    int depth = 0, line = 0;
+    bool in_string = false, in_block_comment = false;
+    bool complete = false;
+    char quote = 0;
+    spans[count++] = (Span){0, len, 0};
+
+    size_t pos = 0;
+    while (pos < len) {
+        size_t eol = pos;
+        while (eol < len && text[eol] != '\n') eol++;
+
+        if (depth == 0 && !in_string && !in_block_comment) {
+            size_t first = pos;
+            while (first < eol && (text[first] == ' ' || text[first] == '\t' || text[first] == '\r')) first++;
+            char c = first < eol ? text[first] : 0;
+            bool continues = c == '}' || c == ')' || c == ']' || c == '.' || c == ',' ||
+                             (eol - first >= 4 && strncmp(text + first, "else", 4) == 0);
+            if (c && complete && !continues) {
+                if (count == cap) {
+                    cap *= 2;
+                    spans = realloc(spans, sizeof(Span) * (size_t)cap);
+                }
+                spans[count - 1].end = pos;
+                spans[count++] = (Span){pos, len, line};
+                complete = false;
+            }
+        }
+
+        for (size_t i = pos; i < eol; i++) {
+            char c = text[i];
+            if (in_block_comment) {
+                if (c == '*' && i + 1 < eol && text[i + 1] == '/') {
+                    in_block_comment = false;
+                    i++;
+                }
+            } else if (in_string) {
+                if (c == '\\') i++;
+                else if (c == quote) in_string = false;
+            } else if (c == '/' && i + 1 < eol && text[i + 1] == '/') {
+                break;
+            } else if (c == '/' && i + 1 < eol && text[i + 1] == '*') {
+                in_block_comment = true;
+                i++;
+            } else if (c == ' ' || c == '\t' || c == '\r') {
+                continue;
+            } else {
+                if (c == '"' || c == '\'') {
+                    in_string = true;
+                    quote = c;
+                } else if (c == '{' || c == '(' || c == '[') {
+                    depth++;
+                } else if (c == '}' || c == ')' || c == ']') {
+                    if (depth > 0) depth--;
+                }
+                complete = depth == 0 && (c == ';' || c == '}');
+            }
+        }
+        pos = eol < len ? eol + 1 : len;
+        line++;
+    }
+    *out = spans;
+    return count;
+}
+
+static void add_diagnostic(Diagnostic** diags, int* count, int* cap, int line, const char* message) {
+    for (int i = 0; i < *count; i++) {
+        if ((*diags)[i].line == line && strcmp((*diags)[i].message, message) == 0) return;
+    }
+    if (*count == *cap) {
+        *cap = *cap ? *cap * 2 : 8;
+        *diags = realloc(*diags, sizeof(Diagnostic) * (size_t)*cap);
+    }
+    (*diags)[*count].line = line;
+    (*diags)[*count].message = strdup(message);
+    (*count)++;
+}
+
+static int count_lines(const char* text, size_t len) {
+    int lines = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (text[i] == '\n') lines++;
+    }
+    return lines;
+}
+
+static void parse_chunk(Chunk* chunk) {
+    parsing_chunk = chunk;
+    init_lexer(chunk->text);
+    init_parser();
+    chunk->prog = parse_program();
+    if (parser_had_error() && chunk->parse_error_count == 0) {
+        add_diagnostic(&chunk->parse_errors, &chunk->parse_error_count, &chunk->parse_error_cap,
+                       0, "Syntax error");
+    }
+    parsing_chunk = NULL;
+}
+
+// Re-chunks text, keeping every chunk whose text is unchanged (wherever it
+// moved) and parsing the rest. Returns how many chunks were parsed.
+static int update_chunks(Document* doc, const char* text, size_t len) {
+    Span* spans;
+    int span_count = split_chunks(text, len, &spans);
+    Chunk* chunks = calloc((size_t)span_count, sizeof(Chunk));
+    bool* reused = calloc((size_t)(doc->chunk_count ? doc->chunk_count : 1), sizeof(bool));
+    int parsed = 0;
+
+    for (int i = 0; i < span_count; i++) {
+        const char* start = text + spans[i].start;
+        size_t chunk_len = spans[i].end - spans[i].start;
+        uint64_t hash = hash_bytes(start, chunk_len);
+        Chunk* chunk = &chunks[i];
+
+        for (int j = 0; j < doc->chunk_count; j++) {
+            Chunk* old = &doc->chunks[j];
+            if (!reused[j] && old->hash == hash && old->len == chunk_len &&
+                memcmp(old->text, start, chunk_len) == 0) {
+                *chunk = *old;
+                reused[j] = true;
+                break;
+            }
+        }
+        if (!chunk->text) {
+            chunk->text = malloc(chunk_len + 1);
+            memcpy(chunk->text, start, chunk_len);
+            chunk->text[chunk_len] = '\0';
+            chunk->len = chunk_len;
+            chunk->hash = hash;
+            chunk->line_count = count_lines(chunk->text, chunk_len);
+            parse_chunk(chunk);
+            parsed++;
+        }
+        chunk->start_line = spans[i].line;
+    }
+
+    for (int j = 0; j < doc->chunk_count; j++) {
+        if (!reused[j]) free_chunk(&doc->chunks[j]);
+    }
+    free(doc->chunks);
+    free(reused);
+    free(spans);
+    doc->chunks = chunks;
+    doc->chunk_count = span_count;
+    return parsed;
+}
+
+static bool chunk_has_stmt(const Chunk* chunk, const Stmt* stmt) {
+    if (!chunk->prog) return false;
+    for (int i = 0; i < chunk->prog->count; i++) {
+        if (chunk->prog->stmts[i] == stmt) return true;
+    }
+    return false;
+}
+
+// Error listener: parse errors belong to the chunk being parsed and check
+// errors to the chunk holding the declaration being checked. Errors in
+// imported modules land on the chunk that imports them.
+static void on_error(const WynError* error, void* ctx) {
+    (void)ctx;
+    if (parsing_chunk) {
+        int line = error->line > 0 ? error->line - 1 : 0;
+        if (line >= parsing_chunk->line_count) line = parsing_chunk->line_count - 1;
+        add_diagnostic(&parsing_chunk->parse_errors, &parsing_chunk->parse_error_count,
+                       &parsing_chunk->parse_error_cap, line, error->message);
+        return;
+    }
+    if (!checking_doc) return;
+
+    int line = 0;
+    Stmt* decl = checker_current_decl();
+    for (int i = 0; decl && i < checking_doc->chunk_count; i++) {
+        Chunk* chunk = &checking_doc->chunks[i];
+        if (!chunk_has_stmt(chunk, decl)) continue;
+        int rel = error->line > 0 ? error->line - 1 : 0;
+        if (rel >= chunk->line_count) rel = 0;
+        line = chunk->start_line + rel;
+        break;
+    }
+    add_diagnostic(&checking_doc->check_errors, &checking_doc->check_error_count,
+                   &checking_doc->check_error_cap, line, error->message);
+}
+
+static void publish_diagnostics(Document* doc, const char* text, size_t len, int version) {
+    Buf msg = {0};
+    buf_puts(&msg, "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\",\"params\":{\"uri\":");
+    buf_json_string(&msg, doc->uri, strlen(doc->uri));
+    buf_printf(&msg, ",\"version\":%d,\"diagnostics\":[", version);
+    bool first = true;
+    for (int i = 0; i < doc->chunk_count; i++) {
+        Chunk* chunk = &doc->chunks[i];
+        for (int j = 0; j < chunk->parse_error_count; j++) {
+            if (!first) buf_puts(&msg, ",");
+            first = false;
+            buf_puts(&msg, "{\"range\":");
+            buf_line_range(&msg, text, len, chunk->start_line + chunk->parse_errors[j].line);
+            buf_puts(&msg, ",\"severity\":1,\"source\":\"wyn\",\"message\":");
+            buf_json_string(&msg, chunk->parse_errors[j].message, strlen(chunk->parse_errors[j].message));
+            buf_puts(&msg, "}");
+        }
+    }
+    for (int i = 0; i < doc->check_error_count; i++) {
+        if (!first) buf_puts(&msg, ",");
+        first = false;
+        buf_puts(&msg, "{\"range\":");
+        buf_line_range(&msg, text, len, doc->check_errors[i].line);
+        buf_puts(&msg, ",\"severity\":1,\"source\":\"wyn\",\"message\":");
+        buf_json_string(&msg, doc->check_errors[i].message, strlen(doc->check_errors[i].message));
+        buf_puts(&msg, "}");
+    }
+    buf_puts(&msg, "]}}");
+    send_message(&msg);
+    free(msg.data);
+}
+
+// Parses what changed and checks the whole document. Holds analysis_lock.
+static void analyze_document(Document* doc, const char* text, size_t len, int version) {
+    // The generics registry keeps tokens of the last check, which may be
+    // about to be freed with their chunks
+    wyn_cleanup_generics();
+    set_parser_filename(doc->path);
+    set_source_directory(doc->path);
+    update_chunks(doc, text, len);
+
+    free_diagnostics(doc->check_errors, doc->check_error_count);
+    doc->check_errors = NULL;
+    doc->check_error_count = 0;
+    doc->check_error_cap = 0;
+
+    bool parsed_cleanly = true;
+    int stmt_count = 0;
+    for (int i = 0; i < doc->chunk_count; i++) {
+        if (doc->chunks[i].parse_error_count > 0 || !doc->chunks[i].prog) parsed_cleanly = false;
+        else stmt_count += doc->chunks[i].prog->count;
+    }
+
+    free(doc->program.stmts);
+    doc->program.stmts = malloc(sizeof(Stmt*) * (size_t)(stmt_count ? stmt_count : 1));
+    doc->program.count = 0;
+    for (int i = 0; i < doc->chunk_count; i++) {
+        Program* prog = doc->chunks[i].prog;
+        if (!prog || doc->chunks[i].parse_error_count > 0) continue;
+        for (int j = 0; j < prog->count; j++) {
+            if (prog->stmts[j]) doc->program.stmts[doc->program.count++] = prog->stmts[j];
+        }
+    }
+
+    // Like the compiler, report syntax errors before checking anything
+    if (parsed_cleanly) {
+        preload_imports(text);
+        init_checker();
+        check_all_modules();
+        checking_doc = doc;
+        check_program(&doc->program);
+        checking_doc = NULL;
+    }
+    clear_errors();
+    publish_diagnostics(doc, text, len, version);
+}
+
+static void* analysis_thread(void* arg) {
+    (void)arg;
+    pthread_mutex_lock(&docs_lock);
+    while (!stopping) {
+        Document* next = NULL;
+        for (int i = 0; i < doc_count; i++) {
+            if (docs[i]->dirty && (!next || docs[i]->due_ms < next->due_ms)) next = docs[i];
+        }
+        if (!next) {
+            pthread_cond_wait(&docs_changed, &docs_lock);
+            continue;
+        }
+        long long wait = next->due_ms - now_ms();
+        if (wait > 0) {
+            // Edits still arriving; wait for a pause
+            struct timespec until;
+            clock_gettime(CLOCK_MONOTONIC, &until);
+            until.tv_sec += wait / 1000;
+            until.tv_nsec += (wait % 1000) * 1000000L;
+            if (until.tv_nsec >= 1000000000L) {
+                until.tv_sec++;
+                until.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&docs_changed, &docs_lock, &until);
+            continue;
+        }
+        pthread_mutex_unlock(&docs_lock);
+
+        // Lock order is analysis_lock, then docs_lock; the document may
+        // have been closed while neither was held
+        pthread_mutex_lock(&analysis_lock);
+        pthread_mutex_lock(&docs_lock);
+        Document* doc = NULL;
+        for (int i = 0; i < doc_count; i++) {
+            if (docs[i] == next && next->dirty) doc = next;
+        }
+        char* text = NULL;
+        size_t len = 0;
+        int version = 0;
+        if (doc) {
+            text = malloc(doc->len + 1);
+            memcpy(text, doc->text, doc->len + 1);
+            len = doc->len;
+            version = doc->version;
+            doc->dirty = false;
+        }
+        pthread_mutex_unlock(&docs_lock);
+        if (doc) analyze_document(doc, text, len, version);
+        pthread_mutex_unlock(&analysis_lock);
+        free(text);
+        pthread_mutex_lock(&docs_lock);
+    }
+    pthread_mutex_unlock(&docs_lock);
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Queries against the cached ASTs. Callers hold analysis_lock.
+
+typedef struct {
+    Token name;
+    int kind;               // LSP CompletionItemKind
+    const Chunk* chunk;
+} Decl;
+
+typedef void (*DeclVisitor)(const Decl* decl, void* ctx);
+
+static void visit_fn(FnStmt* fn, int kind, const Chunk* chunk, DeclVisitor visit, void* ctx) {
+    Decl decl = {fn->name, kind, chunk};
+    visit(&decl, ctx);
+}
+
+static void visit_stmt(Stmt* stmt, const Chunk* chunk, DeclVisitor visit, void* ctx) {
+    if (!stmt) return;
+    Decl decl = {{0}, 0, chunk};
+    switch (stmt->type) {
+        case STMT_FN:
+        case STMT_ASYNC_FN:
+            visit_fn(&stmt->fn, 3, chunk, visit, ctx);
+            return;
+        case STMT_EXTERN:
+            decl.name = stmt->extern_fn.name;
+            decl.kind = 3;
+            break;
+        case STMT_STRUCT:
+            decl.name = stmt->struct_decl.name;
+            decl.kind = 22;
+            for (int i = 0; i < stmt->struct_decl.method_count; i++) {
+                visit_fn(stmt->struct_decl.methods[i], 2, chunk, visit, ctx);
+            }
+            break;
+        case STMT_IMPL:
+            for (int i = 0; i < stmt->impl.method_count; i++) {
+                visit_fn(stmt->impl.methods[i], 2, chunk, visit, ctx);
+            }
+            return;
+        case STMT_ENUM:
+            decl.name = stmt->enum_decl.name;
+            decl.kind = 13;
+            break;
+        case STMT_TRAIT:
+            decl.name = stmt->trait_decl.name;
+            decl.kind = 8;
+            break;
+        case STMT_CONST:
+            decl.name = stmt->const_stmt.name;
+            decl.kind = 21;
+            break;
+        case STMT_VAR:
+            decl.name = stmt->var.name;
+            decl.kind = 6;
+            break;
+        case STMT_EXPORT:
+            visit_stmt(stmt->export.stmt, chunk, visit, ctx);
+            return;
+        default:
+            return;
+    }
+    if (decl.name.length > 0) visit(&decl, ctx);
+}
+
+static void visit_decls(Document* doc, DeclVisitor visit, void* ctx) {
+    for (int i = 0; i < doc->chunk_count; i++) {
+        Chunk* chunk = &doc->chunks[i];
+        if (!chunk->prog) continue;
+        for (int j = 0; j < chunk->prog->count; j++) {
+            visit_stmt(chunk->prog->stmts[j], chunk, visit, ctx);
+        }
+    }
+}
+
+typedef struct {
+    const char* name;
+    size_t len;
+    Decl found;
+    bool ok;
+} DeclSearch;
+
+static void match_decl(const Decl* decl, void* ctx) {
+    DeclSearch* search = ctx;
+    if (!search->ok && (size_t)decl->name.length == search->len &&
+        memcmp(decl->name.start, search->name, search->len) == 0) {
+        search->found = *decl;
+        search->ok = true;
+    }
+}
+
+static bool is_ident_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// Copies the identifier under a position; false if there is none
+static bool word_at(const char* text, size_t len, int line, int character, char* out, size_t out_size) {
+    size_t pos = position_offset(text, len, line, character);
+    size_t start = pos, end = pos;
+    while (start > 0 && is_ident_char(text[start - 1])) start--;
+    while (end < len && is_ident_char(text[end])) end++;
+    if (end == start || end - start >= out_size) return false;
+    memcpy(out, text + start, end - start);
+    out[end - start] = '\0';
+    return true;
+}
+
+// Every occurrence of name as a whole identifier outside strings and comments
+static void buf_occurrences(Buf* buf, const char* text, size_t len, const char* name,
+                            const char* uri, const char* new_text) {
+    size_t name_len = strlen(name);
+    int line = 0;
+    size_t line_start = 0;
+    bool first = true;
+    for (size_t i = 0; i < len; i++) {
+        char c = text[i];
+        if (c == '\n') {
+            line++;
+            line_start = i + 1;
+        } else if (c == '/' && i + 1 < len && text[i + 1] == '/') {
+            while (i + 1 < len && text[i + 1] != '\n') i++;
+        } else if (c == '/' && i + 1 < len && text[i + 1] == '*') {
+            for (i += 2; i + 1 < len && !(text[i] == '*' && text[i + 1] == '/'); i++) {
+                if (text[i] == '\n') {
+                    line++;
+                    line_start = i + 1;
+                }
+            }
+            i++;
+        } else if (c == '"') {
+            for (i++; i < len && text[i] != '"'; i++) {
+                if (text[i] == '\\') i++;
+                else if (text[i] == '\n') {
+                    line++;
+                    line_start = i + 1;
+                }
+            }
+        } else if (is_ident_char(c) && (i == 0 || !is_ident_char(text[i - 1]))) {
+            size_t end = i;
+            while (end < len && is_ident_char(text[end])) end++;
+            if (end - i == name_len && memcmp(text + i, name, name_len) == 0) {
+                int col = utf16_length(text + line_start, i - line_start);
+                if (!first) buf_puts(buf, ",");
+                first = false;
+                buf_puts(buf, "{");
+                if (uri) {
+                    buf_puts(buf, "\"uri\":");
+                    buf_json_string(buf, uri, strlen(uri));
+                    buf_puts(buf, ",");
+                }
+                buf_printf(buf, "\"range\":{\"start\":{\"line\":%d,\"character\":%d},"
+                                "\"end\":{\"line\":%d,\"character\":%d}}",
+                           line, col, line, col + (int)name_len);
+                if (new_text) {
+                    buf_puts(buf, ",\"newText\":");
+                    buf_json_string(buf, new_text, strlen(new_text));
+                }
+                buf_puts(buf, "}");
+            }
+            i = end - 1;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Handlers
+
+typedef struct {
+    Document* doc;
+    int line;
+    int character;
+    char word[256];
+} Target;
+
+static WynJson* params_of(WynJson* msg) {
+    return json_object_get(msg, "params");
+}
+
+static const char* uri_of(WynJson* params) {
+    return json_string(json_object_get(json_object_get(params, "textDocument"), "uri"));
+}
+
+// Resolves textDocument/position and the identifier there; takes
+// analysis_lock, which the caller releases
+static bool resolve_target(WynJson* params, Target* target) {
+    const char* uri = uri_of(params);
+    WynJson* position = json_object_get(params, "position");
+    if (!uri || !position) return false;
+    target->line = (int)json_int(json_object_get(position, "line"));
+    target->character = (int)json_int(json_object_get(position, "character"));
+
+    pthread_mutex_lock(&analysis_lock);
+    pthread_mutex_lock(&docs_lock);
+    target->doc = find_document(uri);
+    bool ok = target->doc && word_at(target->doc->text, target->doc->len, target->line,
+                                     target->character, target->word, sizeof(target->word));
+    pthread_mutex_unlock(&docs_lock);
+    if (!ok) pthread_mutex_unlock(&analysis_lock);
+    return ok;
+}
+
 static void handle_initialize(const char* id) {
-    const char* capabilities = 
+    send_response(id,
         "{\"capabilities\":{"
-        "\"textDocumentSync\":1,"
+        "\"textDocumentSync\":{\"openClose\":true,\"change\":2,\"save\":{\"includeText\":false}},"
         "\"hoverProvider\":true,"
         "\"definitionProvider\":true,"
         "\"referencesProvider\":true,"
         "\"renameProvider\":true,"
         "\"documentFormattingProvider\":true,"
-        "\"completionProvider\":{\"triggerCharacters\":[\".\",\"::\"]}"
-        "}}";
-    send_response(id, capabilities);
-}
-
-static void handle_did_open(const char* msg) {
-    // Extract URI and content from message
-    char uri[512] = {0};
-    char* uri_start = strstr(msg, "\"uri\":\"");
-    if (uri_start) {
-        uri_start += 7;
-        char* uri_end = strchr(uri_start, '"');
-        if (uri_end) {
-            size_t len = uri_end - uri_start;
-            if (len < sizeof(uri)) {
-                strncpy(uri, uri_start, len);
-            }
+        "\"completionProvider\":{\"triggerCharacters\":[\".\",\":\"]}"
+        "},\"serverInfo\":{\"name\":\"wyn-lsp\",\"version\":\"1.1\"}}");
+}
+
+static void handle_did_open(WynJson* params) {
+    WynJson* item = json_object_get(params, "textDocument");
+    const char* uri = json_string(json_object_get(item, "uri"));
+    WynJson* text = json_object_get(item, "text");
+    if (!uri || !text) return;
+
+    pthread_mutex_lock(&docs_lock);
+    Document* doc = find_document(uri);
+    if (!doc) {
+        if (doc_count == doc_cap) {
+            doc_cap = doc_cap ? doc_cap * 2 : 16;
+            docs = realloc(docs, sizeof(Document*) * (size_t)doc_cap);
         }
+        doc = calloc(1, sizeof(Document));
+        doc->uri = strdup(uri);
+        doc->path = uri_to_path(uri);
+        docs[doc_count++] = doc;
     }
-    
-    // For now, just track the document
-    // Real implementation would parse and store content
-    fprintf(stderr, "Document opened: %s\n", uri);
-}
-
-static void handle_did_change(const char* msg) {
-    // Extract URI and changes
-    char uri[512] = {0};
-    char* uri_start = strstr(msg, "\"uri\":\"");
-    if (uri_start) {
-        uri_start += 7;
-        char* uri_end = strchr(uri_start, '"');
-        if (uri_end) {
-            size_t len = uri_end - uri_start;
-            if (len < sizeof(uri)) {
-                strncpy(uri, uri_start, len);
+    set_text(doc, json_string(text), json_len(text));
+    doc->version = (int)json_int(json_object_get(item, "version"));
+    schedule_analysis(doc, 0);
+    pthread_mutex_unlock(&docs_lock);
+}
+
+static void handle_did_change(WynJson* params) {
+    const char* uri = uri_of(params);
+    WynJson* changes = json_object_get(params, "contentChanges");
+    if (!uri || !changes) return;
+
+    pthread_mutex_lock(&docs_lock);
+    Document* doc = find_document(uri);
+    if (doc) {
+        for (size_t i = 0; i < json_len(changes); i++) {
+            WynJson* change = json_array_get(changes, i);
+            WynJson* text = json_object_get(change, "text");
+            WynJson* range = json_object_get(change, "range");
+            if (!text) continue;
+            if (!range) {
+                set_text(doc, json_string(text), json_len(text));
+                continue;
             }
+            WynJson* from = json_object_get(range, "start");
+            WynJson* to = json_object_get(range, "end");
+            size_t start = position_offset(doc->text, doc->len, (int)json_int(json_object_get(from, "line")),
+                                           (int)json_int(json_object_get(from, "character")));
+            size_t end = position_offset(doc->text, doc->len, (int)json_int(json_object_get(to, "line")),
+                                         (int)json_int(json_object_get(to, "character")));
+            if (end < start) end = start;
+            splice_text(doc, start, end, json_string(text), json_len(text));
         }
+        WynJson* version = json_object_get(json_object_get(params, "textDocument"), "version");
+        if (version) doc->version = (int)json_int(version);
+        schedule_analysis(doc, DIAGNOSTIC_DELAY_MS);
     }
-    
-    fprintf(stderr, "Document changed: %s\n", uri);
-    // Real implementation would update document and send diagnostics
+    pthread_mutex_unlock(&docs_lock);
 }
 
-static void handle_hover(const char* id, const char* msg) {
-    // Extract position
-    char* line_str = strstr(msg, "\"line\":");
-    char* char_str = strstr(msg, "\"character\":");
-    
-    if (!line_str || !char_str) {
+// A saved file may be a module other documents import: drop its cached
+// parse and recheck everything
+static void handle_did_save(WynJson* params) {
+    const char* uri = uri_of(params);
+    if (!uri) return;
+    char* path = uri_to_path(uri);
+    pthread_mutex_lock(&analysis_lock);
+    int dropped = forget_module_file(path);
+    pthread_mutex_lock(&docs_lock);
+    for (int i = 0; dropped > 0 && i < doc_count; i++) {
+        schedule_analysis(docs[i], DIAGNOSTIC_DELAY_MS);
+    }
+    pthread_mutex_unlock(&docs_lock);
+    pthread_mutex_unlock(&analysis_lock);
+    free(path);
+}
+
+static void handle_did_close(WynJson* params) {
+    const char* uri = uri_of(params);
+    if (!uri) return;
+    pthread_mutex_lock(&analysis_lock);
+    pthread_mutex_lock(&docs_lock);
+    for (int i = 0; i < doc_count; i++) {
+        if (strcmp(docs[i]->uri, uri) != 0) continue;
+        free_document(docs[i]);
+        docs[i] = docs[--doc_count];
+        break;
+    }
+    pthread_mutex_unlock(&docs_lock);
+    pthread_mutex_unlock(&analysis_lock);
+
+    Buf msg = {0};
+    buf_puts(&msg, "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\",\"params\":{\"uri\":");
+    buf_json_string(&msg, uri, strlen(uri));
+    buf_puts(&msg, ",\"diagnostics\":[]}}");
+    send_message(&msg);
+    free(msg.data);
+}
+
+static void handle_hover(const char* id, WynJson* params) {
+    Target target;
+    if (!resolve_target(params, &target)) {
         send_response(id, "null");
         return;
     }
-    
-    int line = atoi(line_str + 7);
-    int character = atoi(char_str + 12);
-    
-    // Real implementation would query AST for type info
-    char hover[512];
-    snprintf(hover, sizeof(hover), 
-        "{\"contents\":{\"kind\":\"markdown\",\"value\":\"Type information at line %d, col %d\"}}",
-        line, character);
-    send_response(id, hover);
-}
-
-static void handle_definition(const char* id, const char* msg) {
-    // Extract position
-    char* line_str = strstr(msg, "\"line\":");
-    char* char_str = strstr(msg, "\"character\":");
-    
-    if (!line_str || !char_str) {
+    DeclSearch search = {target.word, strlen(target.word), {{0}, 0, NULL}, false};
+    visit_decls(target.doc, match_decl, &search);
+    if (!search.ok) {
+        pthread_mutex_unlock(&analysis_lock);
         send_response(id, "null");
         return;
     }
-    
-    int line = atoi(line_str + 7);
-    int character = atoi(char_str + 12);
-    
-    // Real implementation would find definition in AST
-    char def[512];
-    snprintf(def, sizeof(def),
-        "{\"uri\":\"file:///test.wyn\",\"range\":{\"start\":{\"line\":%d,\"character\":0},\"end\":{\"line\":%d,\"character\":10}}}",
-        line, line);
-    send_response(id, def);
-}
-
-static void handle_references(const char* id, const char* msg) {
-    // Extract position
-    char* line_str = strstr(msg, "\"line\":");
-    char* char_str = strstr(msg, "\"character\":");
-    
-    if (!line_str || !char_str) {
-        send_response(id, "[]");
+
+    // The declaration's first line up to its body
+    const char* start = search.found.name.start;
+    while (start > search.found.chunk->text && start[-1] != '\n') start--;
+    while (*start == ' ' || *start == '\t') start++;
+    const char* end = start;
+    while (*end && *end != '\n' && *end != '{') end++;
+    while (end > start && (end[-1] == ' ' || end[-1] == '\r')) end--;
+
+    Buf code = {0};
+    buf_puts(&code, "```wyn\n");
+    buf_append(&code, start, (size_t)(end - start));
+    buf_puts(&code, "\n```");
+    Buf result = {0};
+    buf_puts(&result, "{\"contents\":{\"kind\":\"markdown\",\"value\":");
+    buf_json_string(&result, code.data, code.len);
+    buf_puts(&result, "}}");
+    pthread_mutex_unlock(&analysis_lock);
+    send_response(id, result.data);
+    free(code.data);
+    free(result.data);
+}
+
+static void handle_definition(const char* id, WynJson* params) {
+    Target target;
+    if (!resolve_target(params, &target)) {
+        send_response(id, "null");
         return;
     }
-    
-    int line = atoi(line_str + 7);
-    int character = atoi(char_str + 12);
-    
-    // Real implementation would find all references in AST
-    char refs[1024];
-    snprintf(refs, sizeof(refs),
-        "[{\"uri\":\"file:///test.wyn\",\"range\":{\"start\":{\"line\":%d,\"character\":0},\"end\":{\"line\":%d,\"character\":10}}}]",
-        line, line);
-    send_response(id, refs);
-}
-
-static void handle_rename(const char* id, const char* msg) {
-    // Extract position and new name
-    char* line_str = strstr(msg, "\"line\":");
-    char* char_str = strstr(msg, "\"character\":");
-    char* name_str = strstr(msg, "\"newName\":\"");
-    
-    if (!line_str || !char_str || !name_str) {
+    DeclSearch search = {target.word, strlen(target.word), {{0}, 0, NULL}, false};
+    visit_decls(target.doc, match_decl, &search);
+    if (!search.ok) {
+        pthread_mutex_unlock(&analysis_lock);
         send_response(id, "null");
         return;
     }
-    
-    int line = atoi(line_str + 7);
-    int character = atoi(char_str + 12);
-    name_str += 11;
-    char new_name[128] = {0};
-    char* name_end = strchr(name_str, '"');
-    if (name_end) {
-        size_t len = name_end - name_str;
-        if (len < sizeof(new_name)) {
-            strncpy(new_name, name_str, len);
-        }
-    }
-    
-    // Real implementation would perform rename across all files
-    char result[512];
-    snprintf(result, sizeof(result),
-        "{\"changes\":{\"file:///test.wyn\":[{\"range\":{\"start\":{\"line\":%d,\"character\":0},\"end\":{\"line\":%d,\"character\":10}},\"newText\":\"%s\"}]}}",
-        line, line, new_name);
-    send_response(id, result);
+    Buf result = {0};
+    buf_puts(&result, "{\"uri\":");
+    buf_json_string(&result, target.doc->uri, strlen(target.doc->uri));
+    buf_puts(&result, ",\"range\":");
+    buf_token_range(&result, search.found.chunk, search.found.name);
+    buf_puts(&result, "}");
+    pthread_mutex_unlock(&analysis_lock);
+    send_response(id, result.data);
+    free(result.data);
 }
 
-static void handle_format(const char* id, const char* msg) {
-    // Real implementation would format the document
-    const char* edits = "[]";  // No edits for now
-    send_response(id, edits);
+static void handle_references(const char* id, WynJson* params) {
+    Target target;
+    if (!resolve_target(params, &target)) {
+        send_response(id, "[]");
+        return;
+    }
+    Buf result = {0};
+    buf_puts(&result, "[");
+    pthread_mutex_lock(&docs_lock);
+    buf_occurrences(&result, target.doc->text, target.doc->len, target.word, target.doc->uri, NULL);
+    pthread_mutex_unlock(&docs_lock);
+    buf_puts(&result, "]");
+    pthread_mutex_unlock(&analysis_lock);
+    send_response(id, result.data);
+    free(result.data);
 }
 
-static void handle_completion(const char* id, const char* msg) {
-    // Extract position
-    char* line_str = strstr(msg, "\"line\":");
-    char* char_str = strstr(msg, "\"character\":");
-    
-    if (!line_str || !char_str) {
-        send_response(id, "[]");
+static void handle_rename(const char* id, WynJson* params) {
+    const char* new_name = json_string(json_object_get(params, "newName"));
+    Target target;
+    if (!new_name || !resolve_target(params, &target)) {
+        send_response(id, "null");
         return;
     }
-    
-    int line = atoi(line_str + 7);
-    int character = atoi(char_str + 12);
-    
-    // Real implementation would provide context-aware completions
-    const char* completions = 
-        "[{\"label\":\"print\",\"kind\":3,\"detail\":\"fn(string)\"},"
-        "{\"label\":\"var\",\"kind\":14,\"detail\":\"keyword\"},"
-        "{\"label\":\"fn\",\"kind\":14,\"detail\":\"keyword\"},"
-        "{\"label\":\"struct\",\"kind\":14,\"detail\":\"keyword\"},"
-        "{\"label\":\"enum\",\"kind\":14,\"detail\":\"keyword\"},"
-        "{\"label\":\"match\",\"kind\":14,\"detail\":\"keyword\"},"
-        "{\"label\":\"if\",\"kind\":14,\"detail\":\"keyword\"},"
-        "{\"label\":\"while\",\"kind\":14,\"detail\":\"keyword\"},"
-        "{\"label\":\"for\",\"kind\":14,\"detail\":\"keyword\"},"
-        "{\"label\":\"return\",\"kind\":14,\"detail\":\"keyword\"}]";
-    send_response(id, completions);
+    Buf result = {0};
+    buf_puts(&result, "{\"changes\":{");
+    buf_json_string(&result, target.doc->uri, strlen(target.doc->uri));
+    buf_puts(&result, ":[");
+    pthread_mutex_lock(&docs_lock);
+    buf_occurrences(&result, target.doc->text, target.doc->len, target.word, NULL, new_name);
+    pthread_mutex_unlock(&docs_lock);
+    buf_puts(&result, "]}}");
+    pthread_mutex_unlock(&analysis_lock);
+    send_response(id, result.data);
+    free(result.data);
+}
+
+static void handle_format(const char* id) {
+    // No formatter yet; an empty edit list leaves the document as it is
+    send_response(id, "[]");
+}
+
+static void add_completion(const Decl* decl, void* ctx) {
+    Buf* result = ctx;
+    buf_puts(result, ",{\"label\":");
+    buf_json_string(result, decl->name.start, (size_t)decl->name.length);
+    buf_printf(result, ",\"kind\":%d}", decl->kind);
+}
+
+static void handle_completion(const char* id, WynJson* params) {
+    static const char* keywords[] = {
+        "var", "const", "fn", "struct", "enum", "trait", "impl", "match", "if", "else",
+        "while", "for", "return", "break", "continue", "import", "export", "pub", "spawn",
+    };
+    Buf result = {0};
+    buf_puts(&result, "[{\"label\":\"print\",\"kind\":3,\"detail\":\"fn(string)\"}");
+    for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++) {
+        buf_printf(&result, ",{\"label\":\"%s\",\"kind\":14,\"detail\":\"keyword\"}", keywords[i]);
+    }
+
+    const char* uri = uri_of(params);
+    pthread_mutex_lock(&analysis_lock);
+    pthread_mutex_lock(&docs_lock);
+    Document* doc = uri ? find_document(uri) : NULL;
+    pthread_mutex_unlock(&docs_lock);
+    if (doc) visit_decls(doc, add_completion, &result);
+    pthread_mutex_unlock(&analysis_lock);
+
+    buf_puts(&result, "]");
+    send_response(id, result.data);
+    free(result.data);
 }
 
 int lsp_server_start() {
     fprintf(stderr, "Wyn Language Server starting...\n");
     fprintf(stderr, "LSP Protocol: JSON-RPC 2.0\n");
-    fprintf(stderr, "Capabilities: hover, definition, references, rename, format, completion\n");
+    fprintf(stderr, "Capabilities: incremental sync, diagnostics, hover, definition, references, rename, completion\n");
     fprintf(stderr, "Listening on stdin/stdout...\n");
-    
-    while (1) {
-        char* msg = read_message();
-        if (!msg) break;
-        
-        // Parse method and id (simple parsing)
-        char* method = strstr(msg, "\"method\":");
-        char* id_str = strstr(msg, "\"id\":");
-        
-        if (!method) {
-            free(msg);
+
+    // Messages get the real stdout to themselves; anything else the
+    // compiler prints ends up on stderr
+    protocol_out = fdopen(dup(STDOUT_FILENO), "w");
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+
+    set_errors_quiet(true);
+    set_error_listener(on_error, NULL);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&docs_changed, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_t analyzer;
+    pthread_create(&analyzer, NULL, analysis_thread, NULL);
+
+    size_t len;
+    char* text;
+    while ((text = read_message(&len)) != NULL) {
+        WynJson* msg = json_parse_n(text, len);
+        free(text);
+        if (!msg) {
+            send_error("null", -32700, "Parse error");
             continue;
         }
-        
-        method += 9;
-        while (*method && (*method == ' ' || *method == '"')) method++;
-        
-        char id[64] = "null";
-        if (id_str) {
-            id_str += 5;
-            while (*id_str && (*id_str == ' ' || *id_str == ':')) id_str++;
-            int i = 0;
-            while (*id_str && *id_str != ',' && *id_str != '}' && i < 63) {
-                id[i++] = *id_str++;
-            }
-            id[i] = '\0';
-        }
-        
-        // Handle methods
-        if (strncmp(method, "initialize", 10) == 0) {
-            handle_initialize(id);
-        } else if (strncmp(method, "initialized", 11) == 0) {
-            // No response needed
-        } else if (strncmp(method, "shutdown", 8) == 0) {
-            send_response(id, "null");
-            free(msg);
-            break;
-        } else if (strncmp(method, "textDocument/didOpen", 20) == 0) {
-            handle_did_open(msg);
-        } else if (strncmp(method, "textDocument/didChange", 22) == 0) {
-            handle_did_change(msg);
-        } else if (strncmp(method, "textDocument/hover", 18) == 0) {
-            handle_hover(id, msg);
-        } else if (strncmp(method, "textDocument/definition", 23) == 0) {
-            handle_definition(id, msg);
-        } else if (strncmp(method, "textDocument/references", 23) == 0) {
-            handle_references(id, msg);
-        } else if (strncmp(method, "textDocument/rename", 19) == 0) {
-            handle_rename(id, msg);
-        } else if (strncmp(method, "textDocument/formatting", 23) == 0) {
-            handle_format(id, msg);
-        } else if (strncmp(method, "textDocument/completion", 23) == 0) {
-            handle_completion(id, msg);
+
+        const char* method = json_string(json_object_get(msg, "method"));
+        WynJson* id_node = json_object_get(msg, "id");
+        char* id = id_node ? json_stringify(id_node, NULL) : NULL;
+        WynJson* params = params_of(msg);
+        bool exit_requested = false;
+
+        if (!method) {
+            // A response to something we never send
+        } else if (strcmp(method, "initialize") == 0) {
+            handle_initialize(id ? id : "null");
+        } else if (strcmp(method, "shutdown") == 0) {
+            send_response(id ? id : "null", "null");
+        } else if (strcmp(method, "exit") == 0) {
+            exit_requested = true;
+        } else if (strcmp(method, "textDocument/didOpen") == 0) {
+            handle_did_open(params);
+        } else if (strcmp(method, "textDocument/didChange") == 0) {
+            handle_did_change(params);
+        } else if (strcmp(method, "textDocument/didSave") == 0) {
+            handle_did_save(params);
+        } else if (strcmp(method, "textDocument/didClose") == 0) {
+            handle_did_close(params);
+        } else if (!id) {
+            // initialized, $/cancelRequest and other notifications
+        } else if (strcmp(method, "textDocument/hover") == 0) {
+            handle_hover(id, params);
+        } else if (strcmp(method, "textDocument/definition") == 0) {
+            handle_definition(id, params);
+        } else if (strcmp(method, "textDocument/references") == 0) {
+            handle_references(id, params);
+        } else if (strcmp(method, "textDocument/rename") == 0) {
+            handle_rename(id, params);
+        } else if (strcmp(method, "textDocument/formatting") == 0) {
+            handle_format(id);
+        } else if (strcmp(method, "textDocument/completion") == 0) {
+            handle_completion(id, params);
         } else {
-            // Unknown method - send null response
-            if (strcmp(id, "null") != 0) {
-                send_response(id, "null");
-            }
+            send_error(id, -32601, "Method not found");
         }
-        
-        free(msg);
+
+        free(id);
+        json_free(msg);
+        if (exit_requested) break;
     }
-    
+
+    pthread_mutex_lock(&docs_lock);
+    stopping = true;
+    pthread_cond_signal(&docs_changed);
+    pthread_mutex_unlock(&docs_lock);
+    pthread_join(analyzer, NULL);
+
     fprintf(stderr, "LSP server stopped\n");
     return 0;
 }
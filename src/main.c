@@ -11,6 +11,7 @@
 #include "optimize.h"
 #include "module.h"
 #include "commands.h"
+#include "runtime_lib.h"
 
 void init_lexer(const char* source);
 void init_parser();
@@ -99,6 +100,8 @@ int main(int argc, char** argv) {
         fprintf(stderr, "\nOptimization flags:\n");
         fprintf(stderr, "  -O1                      Basic optimizations\n");
         fprintf(stderr, "  -O2                      Advanced optimizations\n");
+        fprintf(stderr, "  -O3, -Os                 Aggressive / size optimizations\n");
+        fprintf(stderr, "  --release                -O3 with link-time optimization\n");
         return 1;
     }
     
@@ -134,6 +137,14 @@ int main(int argc, char** argv) {
         printf("\nOptimization flags:\n");
         printf("  -O1                      Basic optimizations (dead code elimination)\n");
         printf("  -O2                      Advanced optimizations (includes function inlining)\n");
+        printf("  -O3                      Aggressive optimizations\n");
+        printf("  -Os                      Optimize for size\n");
+        printf("  --release                -O3 with link-time optimization\n");
+        printf("  -march=native            Tune for the host CPU\n");
+        printf("  -flto                    Link-time optimization\n");
+        printf("  --pgo-use                Optimize with a profile from 'wyn run --pgo-train'\n");
+        printf("\nOptimization flags apply to the program and the runtime library alike.\n");
+        printf("Record a profile with: wyn run --pgo-train <file.wyn>\n");
         printf("\nCross-compile targets:\n");
         printf("  linux   - Linux x86_64\n");
         printf("  macos   - macOS (current platform)\n");
@@ -247,12 +258,19 @@ int main(int argc, char** argv) {
     }
     
     if (strcmp(command, "build") == 0) {
-        if (argc < 3) {
-            fprintf(stderr, "Usage: wyn build <directory>\n");
+        WynBuildOptions build_opts;
+        wyn_build_options_init(&build_opts, "-O0");
+        char* dir = NULL;
+        for (int i = 2; i < argc; i++) {
+            if (!wyn_build_options_parse(&build_opts, argv[i]) && !dir) {
+                dir = argv[i];
+            }
+        }
+        if (!dir) {
+            fprintf(stderr, "Usage: wyn build [options] <directory>\n");
             return 1;
         }
-        
-        char* dir = argv[2];
+        wyn_build_options_set_source(&build_opts, dir);
         
         // Create temp directory if it doesn't exist
         system("mkdir -p temp");
@@ -375,27 +393,12 @@ int main(int argc, char** argv) {
         fclose(out);
         
         // Get WYN_ROOT or auto-detect
-        char wyn_root[1024] = ".";
-        char* root_env = getenv("WYN_ROOT");
-        if (root_env) {
-            snprintf(wyn_root, sizeof(wyn_root), "%s", root_env);
-        } else {
-            // Auto-detect: check if src/wyn_wrapper.c exists, if not try ./wyn
-            FILE* test = fopen("./src/wyn_wrapper.c", "r");
-            if (!test) {
-                test = fopen("./wyn/src/wyn_wrapper.c", "r");
-                if (test) {
-                    snprintf(wyn_root, sizeof(wyn_root), "./wyn");
-                }
-            }
-            if (test) fclose(test);
-        }
+        char wyn_root[1024];
+        wyn_find_root(wyn_root, sizeof(wyn_root));
         
-        char compile_cmd[4096];
-        snprintf(compile_cmd, sizeof(compile_cmd), 
-                 "gcc -std=c11 -I %s/src -o %s/main %s/main.c %s/src/wyn_wrapper.c %s/src/wyn_interface.c %s/src/io.c %s/src/optional.c %s/src/result.c %s/src/arc_runtime.c %s/src/concurrency.c %s/src/async_runtime.c %s/src/safe_memory.c %s/src/error.c %s/src/string_runtime.c %s/src/hashmap.c %s/src/hashset.c %s/src/json.c %s/src/json_runtime.c %s/src/stdlib_runtime.c %s/src/hashmap_runtime.c %s/src/stdlib_string.c %s/src/stdlib_array.c %s/src/stdlib_time.c %s/src/stdlib_crypto.c %s/src/spawn.c %s/src/net.c %s/src/net_runtime.c %s/src/test_runtime.c %s/src/net_advanced.c -lm", 
-                 wyn_root, dir, dir, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root);
-        int result = system(compile_cmd);
+        char bin_path[256];
+        snprintf(bin_path, sizeof(bin_path), "%s/main", dir);
+        int result = wyn_link_program(wyn_root, out_path, bin_path, &build_opts);
         
         if (result == 0) {
             printf("Build successful: %s/main\n", dir);
@@ -615,11 +618,21 @@ int main(int argc, char** argv) {
     }
     
     if (strcmp(command, "run") == 0) {
-        if (argc < 3) {
-            fprintf(stderr, "Usage: wyn run <file.wyn>\n");
+        WynBuildOptions build_opts;
+        wyn_build_options_init(&build_opts, "-O2");
+        char* file = NULL;
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "--pgo-train") == 0) {
+                build_opts.pgo = WYN_PGO_GENERATE;
+            } else if (!wyn_build_options_parse(&build_opts, argv[i]) && !file) {
+                file = argv[i];
+            }
+        }
+        if (!file) {
+            fprintf(stderr, "Usage: wyn run [options] <file.wyn>\n");
             return 1;
         }
-        char* file = argv[2];
+        wyn_build_options_set_source(&build_opts, file);
         char* source = read_file(file);
         
         // Pre-load all imports before parsing
@@ -657,27 +670,12 @@ int main(int argc, char** argv) {
         fclose(out);
         
         // Get WYN_ROOT or auto-detect
-        char wyn_root[1024] = ".";
-        char* root_env = getenv("WYN_ROOT");
-        if (root_env) {
-            snprintf(wyn_root, sizeof(wyn_root), "%s", root_env);
-        } else {
-            // Auto-detect: check if src/wyn_wrapper.c exists, if not try ./wyn
-            FILE* test = fopen("./src/wyn_wrapper.c", "r");
-            if (!test) {
-                test = fopen("./wyn/src/wyn_wrapper.c", "r");
-                if (test) {
-                    snprintf(wyn_root, sizeof(wyn_root), "./wyn");
-                }
-            }
-            if (test) fclose(test);
-        }
+        char wyn_root[1024];
+        wyn_find_root(wyn_root, sizeof(wyn_root));
         
-        char compile_cmd[4096];
-        snprintf(compile_cmd, sizeof(compile_cmd), 
-                 "gcc -std=c11 -O2 -I %s/src -o %s.out %s.c %s/src/wyn_wrapper.c %s/src/wyn_interface.c %s/src/io.c %s/src/optional.c %s/src/result.c %s/src/arc_runtime.c %s/src/concurrency.c %s/src/async_runtime.c %s/src/safe_memory.c %s/src/error.c %s/src/string_runtime.c %s/src/hashmap.c %s/src/hashset.c %s/src/json.c %s/src/json_runtime.c %s/src/stdlib_runtime.c %s/src/hashmap_runtime.c %s/src/stdlib_string.c %s/src/stdlib_array.c %s/src/stdlib_time.c %s/src/stdlib_crypto.c %s/src/spawn.c %s/src/net.c %s/src/net_runtime.c %s/src/test_runtime.c %s/src/net_advanced.c -lm", 
-                 wyn_root, file, file, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root);
-        int result = system(compile_cmd);
+        char bin_path[256];
+        snprintf(bin_path, sizeof(bin_path), "%s.out", file);
+        int result = wyn_link_program(wyn_root, out_path, bin_path, &build_opts);
         
         if (result != 0) {
             fprintf(stderr, "C compilation failed\n");
@@ -686,23 +684,26 @@ int main(int argc, char** argv) {
         }
         
         char run_cmd[512];
-        snprintf(run_cmd, 512, "./%s.out", file);
+        snprintf(run_cmd, 512, "%s%s.out", file[0] == '/' ? "" : "./", file);
         result = system(run_cmd);
+        if (build_opts.pgo == WYN_PGO_GENERATE) {
+            printf("Profile written to %s\n", build_opts.pgo_dir);
+            printf("Rebuild with: wyn --pgo-use %s\n", file);
+        }
         free(source);
         return result;
     }
     
     // Parse optimization flags and -o flag
-    OptLevel optimization = OPT_NONE;
+    WynBuildOptions build_opts;
+    wyn_build_options_init(&build_opts, "-O0");
     int file_arg_index = -1;
     const char* output_name = NULL;
     
     // Check for flags (scan all args)
     for (int i = 1; i < argc; i++) {
-        if (strcmp(argv[i], "-O1") == 0) {
-            optimization = OPT_O1;
-        } else if (strcmp(argv[i], "-O2") == 0) {
-            optimization = OPT_O2;
+        if (wyn_build_options_parse(&build_opts, argv[i])) {
+            continue;
         } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
             output_name = argv[i + 1];
             i++; // Skip next arg
@@ -716,6 +717,14 @@ int main(int argc, char** argv) {
         return 1;
     }
     
+    // Front-end passes follow the backend optimization level
+    OptLevel optimization = OPT_NONE;
+    if (strcmp(build_opts.opt_flag, "-O1") == 0) optimization = OPT_O1;
+    else if (strcmp(build_opts.opt_flag, "-O2") == 0) optimization = OPT_O2;
+    else if (strcmp(build_opts.opt_flag, "-O3") == 0) optimization = OPT_O3;
+    else if (strcmp(build_opts.opt_flag, "-Os") == 0) optimization = OPT_OS;
+    wyn_build_options_set_source(&build_opts, argv[file_arg_index]);
+    
     // Initialize optimizer
     init_optimizer(optimization);
     
@@ -782,34 +791,16 @@ int main(int argc, char** argv) {
     free_program(prog);
     
     // Get WYN_ROOT or auto-detect
-    char wyn_root[1024] = ".";
-    char* root_env = getenv("WYN_ROOT");
-    if (root_env) {
-        snprintf(wyn_root, sizeof(wyn_root), "%s", root_env);
-    } else {
-        // Auto-detect: check if src/wyn_wrapper.c exists, if not try ./wyn
-        FILE* test = fopen("./src/wyn_wrapper.c", "r");
-        if (!test) {
-            test = fopen("./wyn/src/wyn_wrapper.c", "r");
-            if (test) {
-                snprintf(wyn_root, sizeof(wyn_root), "./wyn");
-            }
-        }
-        if (test) fclose(test);
-    }
+    char wyn_root[1024];
+    wyn_find_root(wyn_root, sizeof(wyn_root));
     
-    char compile_cmd[2048];
-    const char* opt_flag = (optimization == OPT_O2) ? "-O2" : (optimization == OPT_O1) ? "-O1" : "-O0";
     char output_bin[256];
     if (output_name) {
         snprintf(output_bin, 256, "%s", output_name);
     } else {
         snprintf(output_bin, 256, "%s.out", argv[file_arg_index]);
     }
-    snprintf(compile_cmd, sizeof(compile_cmd), 
-             "gcc %s -std=c11 -I %s/src -o %s %s.c %s/src/wyn_wrapper.c %s/src/wyn_interface.c %s/src/io.c %s/src/optional.c %s/src/result.c %s/src/arc_runtime.c %s/src/concurrency.c %s/src/async_runtime.c %s/src/safe_memory.c %s/src/error.c %s/src/string_runtime.c %s/src/hashmap.c %s/src/hashset.c %s/src/json.c %s/src/json_runtime.c %s/src/stdlib_runtime.c %s/src/hashmap_runtime.c %s/src/stdlib_string.c %s/src/stdlib_array.c %s/src/stdlib_time.c %s/src/stdlib_crypto.c %s/src/spawn.c %s/src/net.c %s/src/net_runtime.c %s/src/test_runtime.c %s/src/net_advanced.c -lm", 
-             opt_flag, wyn_root, output_bin, argv[file_arg_index], wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root, wyn_root);
-    int result = system(compile_cmd);
+    int result = wyn_link_program(wyn_root, out_path, output_bin, &build_opts);
     
     // Check if output file was actually created
     FILE* check = fopen(output_bin, "r");
@@ -822,7 +813,6 @@ int main(int argc, char** argv) {
         // remove(c_file);
     } else {
         fprintf(stderr, "C compilation failed - output file not created\n");
-        fprintf(stderr, "Command: %s\n", compile_cmd);
         fprintf(stderr, "GCC exit code: %d\n", result);
         return 1;
     }
@@ -41,6 +41,9 @@ void free_expr(Expr* expr) {
         case EXPR_AWAIT:
             free_expr(expr->await.expr);
             break;
+        case EXPR_SPAWN:
+            free_expr(expr->spawn.call);
+            break;
         case EXPR_MATCH:
             free_match_expr(&expr->match);
             break;
@@ -228,7 +231,10 @@ void free_stmt(Stmt* stmt) {
             free_stmt(stmt->catch_stmt.body);
             break;
         case STMT_SPAWN:
-            free_expr(stmt->expr);
+            free_expr(stmt->spawn.call);
+            break;
+        case STMT_SCOPE:
+            free_stmt(stmt->scope.body);
             break;
         case STMT_TEST:  // T1.6.2: Testing Framework Agent addition
             free_stmt(stmt->test_stmt.body);
@@ -1,345 +1,558 @@
+#ifndef _WIN32
+#define _DEFAULT_SOURCE
+#endif
 #include "arc_runtime.h"
-#include "memory.h"
-#include "error.h"
 #include <stdio.h>
 #include <stdlib.h>
-#include <pthread.h>
 #include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
 
 // T2.3.5: Memory Pool Optimization
-// Size-class based allocation pools for reduced fragmentation and fast paths
+//
+// Size-class allocator behind ARC objects, arrays, maps and strings.
+//
+// Every class owns a 1GB region of one reserved address range and carves it
+// into 64KB slabs, so a block's class follows from its address: frees need no
+// size, and pointers that came from malloc are recognized by a range check.
+// Slabs are page aligned, so blocks of the classes that are multiples of 64
+// bytes never share a cache line with a neighbour.
+//
+// Each thread keeps a free list per class and allocates and frees against it
+// without locks or atomics. A list that grows past two batches hands one batch
+// to the class's central list; an empty list takes a whole batch back, so the
+// central lock is taken once per batch rather than once per block. Exiting
+// threads hand everything they cached back.
+//
+// WYN_POOL_STATS=1 prints the statistics to stderr at exit; 2 adds the
+// per-class table.
+
+#define POOL_REGION_SHIFT 30
+#define POOL_SLAB_SIZE 65536
+#define POOL_MAX_CACHES 32          // Pool classes plus caches registered by other heaps
+#define POOL_MIN_BATCH 4
+#define POOL_MAX_BATCH 64
 
-// Size classes for memory pools (powers of 2 + some common sizes)
 static const size_t SIZE_CLASSES[] = {
-    8, 16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048
+    32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048,
+    3072, 4096, 6144, 8192, 12288, 16384, 24576, 32768
 };
-static const size_t NUM_SIZE_CLASSES = sizeof(SIZE_CLASSES) / sizeof(SIZE_CLASSES[0]);
-static const size_t MAX_POOLED_SIZE = 2048;
+#define NUM_SIZE_CLASSES ((int)(sizeof(SIZE_CLASSES) / sizeof(SIZE_CLASSES[0])))
+#define MAX_POOLED_SIZE 32768
 
-// Memory block for pool allocation
+// The first words of a free block. Only the first block of a batch on a
+// central list uses next_batch and count.
 typedef struct PoolBlock {
     struct PoolBlock* next;
-    uint8_t data[];
+    struct PoolBlock* next_batch;
+    size_t count;
 } PoolBlock;
 
-// Memory pool for a specific size class
+// Shared state of a size class, or of a cache registered by another heap
 typedef struct {
     size_t block_size;
-    PoolBlock* free_list;
-    size_t total_blocks;
-    size_t free_blocks;
-    size_t allocations;
-    size_t deallocations;
+    uint32_t batch;
     pthread_mutex_t lock;
-} MemoryPool;
+    PoolBlock* batches;             // Central list, guarded by lock
+    size_t central_blocks;
+    _Atomic size_t carved;          // Bytes of the region handed out as slabs
+    _Atomic size_t allocations;     // Folded in from threads that exited
+    _Atomic size_t deallocations;
+} PoolClass;
 
-// Pool manager
+// One thread's view of a class. The counters are only written by the owning
+// thread; they are atomic so statistics can read them from another.
 typedef struct {
-    MemoryPool pools[NUM_SIZE_CLASSES];
-    size_t large_allocations;
-    size_t large_deallocations;
-    size_t total_memory_used;
-    size_t peak_memory_used;
-    pthread_mutex_t stats_lock;
-    bool initialized;
+    PoolBlock* head;
+    uint32_t count;
+    uint32_t limit;                 // Hand a batch back above this; 0 until first needed
+    char* bump;                     // Uncarved part of the thread's current slab
+    char* bump_end;
+    _Atomic size_t allocations;
+    _Atomic size_t deallocations;
+} PoolThreadClass;
+
+typedef struct PoolThreadCache {
+    PoolThreadClass classes[POOL_MAX_CACHES];
+    _Atomic size_t large_allocations;
+    _Atomic size_t large_deallocations;
+    struct PoolThreadCache* next;   // Registry of live caches, for statistics
+    bool registered;
+} PoolThreadCache;
+
+typedef struct {
+    _Atomic(char*) base;            // NULL when the range could not be reserved
+    PoolClass classes[POOL_MAX_CACHES];
+    _Atomic int class_count;
+    pthread_mutex_t registry_lock;
+    PoolThreadCache* threads;
+    pthread_key_t thread_key;
+    _Atomic size_t large_allocations;
+    _Atomic size_t large_deallocations;
+    // Counter values at the last wyn_pool_reset_stats
+    size_t base_allocations;
+    size_t base_deallocations;
+    size_t base_large_allocations;
+    size_t base_large_deallocations;
+    int stats_level;
 } PoolManager;
 
-static PoolManager g_pool_manager = {0};
+static PoolManager g_pool;
+static pthread_once_t g_pool_once = PTHREAD_ONCE_INIT;
+static _Thread_local PoolThreadCache t_cache;
 
-// Find appropriate size class for allocation
-static int find_size_class(size_t size) {
-    for (size_t i = 0; i < NUM_SIZE_CLASSES; i++) {
-        if (size <= SIZE_CLASSES[i]) {
-            return (int)i;
-        }
+static inline void count_one(_Atomic size_t* counter) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+}
+
+// Classes alternate between 2^k and 1.5 * 2^k from 32 bytes up
+static inline int find_size_class(size_t size) {
+    if (size <= 32) return 0;
+    int bits = 64 - __builtin_clzll((unsigned long long)(size - 1));
+    size_t pow2 = (size_t)1 << bits;
+    int index = (bits - 5) * 2;
+    return size <= pow2 - pow2 / 4 ? index - 1 : index;
+}
+
+// Class of a block handed out by the pool, or -1 for anything else
+static inline int pool_class_of(const void* ptr) {
+    char* base = atomic_load_explicit(&g_pool.base, memory_order_acquire);
+    if (!base || (const char*)ptr < base) return -1;
+    size_t index = (size_t)((const char*)ptr - base) >> POOL_REGION_SHIFT;
+    return index < (size_t)NUM_SIZE_CLASSES ? (int)index : -1;
+}
+
+static size_t slab_size(size_t block_size) {
+    return block_size * 8 > POOL_SLAB_SIZE ? block_size * 8 : POOL_SLAB_SIZE;
+}
+
+static void class_init(PoolClass* pc, size_t block_size) {
+    size_t batch = POOL_SLAB_SIZE / 4 / block_size;
+    if (batch < POOL_MIN_BATCH) batch = POOL_MIN_BATCH;
+    if (batch > POOL_MAX_BATCH) batch = POOL_MAX_BATCH;
+    pc->block_size = block_size;
+    pc->batch = (uint32_t)batch;
+    pthread_mutex_init(&pc->lock, NULL);
+}
+
+static void pool_flush_class(int cls, PoolThreadClass* tc);
+static void pool_thread_exit(void* arg);
+static void pool_dump_stats(void);
+
+static void pool_setup(void) {
+    for (int i = 0; i < NUM_SIZE_CLASSES; i++) class_init(&g_pool.classes[i], SIZE_CLASSES[i]);
+    atomic_store_explicit(&g_pool.class_count, NUM_SIZE_CLASSES, memory_order_release);
+    pthread_mutex_init(&g_pool.registry_lock, NULL);
+    pthread_key_create(&g_pool.thread_key, pool_thread_exit);
+#if !defined(_WIN32) && UINTPTR_MAX > 0xFFFFFFFFu && defined(MAP_NORESERVE)
+    size_t reserve = (size_t)NUM_SIZE_CLASSES << POOL_REGION_SHIFT;
+    void* base = mmap(NULL, reserve, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base != MAP_FAILED) atomic_store_explicit(&g_pool.base, base, memory_order_release);
+#endif
+    const char* env = getenv("WYN_POOL_STATS");
+    if (env && *env && strcmp(env, "0") != 0) {
+        g_pool.stats_level = atoi(env) >= 2 ? 2 : 1;
+        atexit(pool_dump_stats);
     }
-    return -1; // Too large for pooling
 }
 
 // Initialize memory pools
 void wyn_pool_init(void) {
-    if (g_pool_manager.initialized) return;
-    
-    for (size_t i = 0; i < NUM_SIZE_CLASSES; i++) {
-        MemoryPool* pool = &g_pool_manager.pools[i];
-        pool->block_size = SIZE_CLASSES[i];
-        pool->free_list = NULL;
-        pool->total_blocks = 0;
-        pool->free_blocks = 0;
-        pool->allocations = 0;
-        pool->deallocations = 0;
-        pthread_mutex_init(&pool->lock, NULL);
+    pthread_once(&g_pool_once, pool_setup);
+}
+
+// Makes the calling thread's cache visible to statistics and flushed at exit
+static void pool_register_thread(void) {
+    if (t_cache.registered) return;
+    wyn_pool_init();
+    t_cache.registered = true;
+    pthread_setspecific(g_pool.thread_key, &t_cache);
+    pthread_mutex_lock(&g_pool.registry_lock);
+    t_cache.next = g_pool.threads;
+    g_pool.threads = &t_cache;
+    pthread_mutex_unlock(&g_pool.registry_lock);
+}
+
+// Moves one batch from the central list onto the (empty) thread list
+static bool pool_take_batch(int cls, PoolThreadClass* tc) {
+    PoolClass* pc = &g_pool.classes[cls];
+    pthread_mutex_lock(&pc->lock);
+    PoolBlock* first = pc->batches;
+    if (first) {
+        pc->batches = first->next_batch;
+        pc->central_blocks -= first->count;
+    }
+    pthread_mutex_unlock(&pc->lock);
+    if (!first) return false;
+    tc->head = first;
+    tc->count = (uint32_t)first->count;
+    return true;
+}
+
+static void pool_give_blocks(int cls, PoolBlock* first, size_t count) {
+    PoolClass* pc = &g_pool.classes[cls];
+    first->count = count;
+    pthread_mutex_lock(&pc->lock);
+    first->next_batch = pc->batches;
+    pc->batches = first;
+    pc->central_blocks += count;
+    pthread_mutex_unlock(&pc->lock);
+}
+
+// Called when a thread list grows past its limit
+static void pool_overflow(int cls, PoolThreadClass* tc) {
+    PoolClass* pc = &g_pool.classes[cls];
+    if (!t_cache.registered) pool_register_thread();
+    if (tc->limit == 0) {
+        tc->limit = pc->batch * 2;
+        if (tc->count <= tc->limit) return;
     }
-    
-    g_pool_manager.large_allocations = 0;
-    g_pool_manager.large_deallocations = 0;
-    g_pool_manager.total_memory_used = 0;
-    g_pool_manager.peak_memory_used = 0;
-    pthread_mutex_init(&g_pool_manager.stats_lock, NULL);
-    g_pool_manager.initialized = true;
-}
-
-// Allocate a block from pool
-static PoolBlock* allocate_pool_block(MemoryPool* pool) {
-    size_t total_size = sizeof(PoolBlock) + pool->block_size;
-    PoolBlock* block = malloc(total_size);
-    if (!block) return NULL;
-    
-    block->next = NULL;
-    pool->total_blocks++;
-    
-    // Update global statistics
-    pthread_mutex_lock(&g_pool_manager.stats_lock);
-    g_pool_manager.total_memory_used += total_size;
-    if (g_pool_manager.total_memory_used > g_pool_manager.peak_memory_used) {
-        g_pool_manager.peak_memory_used = g_pool_manager.total_memory_used;
+    PoolBlock* first = tc->head;
+    PoolBlock* last = first;
+    for (uint32_t i = 1; i < pc->batch; i++) last = last->next;
+    tc->head = last->next;
+    tc->count -= pc->batch;
+    last->next = NULL;
+    pool_give_blocks(cls, first, pc->batch);
+}
+
+static inline void pool_push(int cls, void* ptr) {
+    PoolThreadClass* tc = &t_cache.classes[cls];
+    PoolBlock* block = ptr;
+    block->next = tc->head;
+    tc->head = block;
+    count_one(&tc->deallocations);
+    if (++tc->count > tc->limit) pool_overflow(cls, tc);
+}
+
+static void* pool_alloc_large(size_t size) {
+    count_one(&t_cache.large_allocations);
+    return malloc(size);
+}
+
+static void* pool_alloc_slow(int cls) {
+    pool_register_thread();
+    char* base = atomic_load_explicit(&g_pool.base, memory_order_relaxed);
+    if (!base) return pool_alloc_large(SIZE_CLASSES[cls]);
+
+    PoolThreadClass* tc = &t_cache.classes[cls];
+    size_t block_size = SIZE_CLASSES[cls];
+    if (tc->bump == tc->bump_end && !pool_take_batch(cls, tc)) {
+        PoolClass* pc = &g_pool.classes[cls];
+        size_t slab = slab_size(block_size);
+        size_t offset = atomic_fetch_add_explicit(&pc->carved, slab, memory_order_relaxed);
+        if (offset + slab > ((size_t)1 << POOL_REGION_SHIFT)) {
+            atomic_fetch_sub_explicit(&pc->carved, slab, memory_order_relaxed);
+            return pool_alloc_large(block_size);
+        }
+        tc->bump = base + ((size_t)cls << POOL_REGION_SHIFT) + offset;
+        tc->bump_end = tc->bump + slab / block_size * block_size;
     }
-    pthread_mutex_unlock(&g_pool_manager.stats_lock);
-    
+    count_one(&tc->allocations);
+    if (tc->head) {
+        PoolBlock* block = tc->head;
+        tc->head = block->next;
+        tc->count--;
+        return block;
+    }
+    void* block = tc->bump;
+    tc->bump += block_size;
     return block;
 }
 
 // Fast pooled allocation
 void* wyn_pool_alloc(size_t size) {
-    wyn_pool_init();
-    
-    int class_index = find_size_class(size);
-    if (class_index == -1) {
-        // Large allocation - use regular malloc
-        pthread_mutex_lock(&g_pool_manager.stats_lock);
-        g_pool_manager.large_allocations++;
-        g_pool_manager.total_memory_used += size;
-        if (g_pool_manager.total_memory_used > g_pool_manager.peak_memory_used) {
-            g_pool_manager.peak_memory_used = g_pool_manager.total_memory_used;
-        }
-        pthread_mutex_unlock(&g_pool_manager.stats_lock);
-        
-        return malloc(size);
-    }
-    
-    MemoryPool* pool = &g_pool_manager.pools[class_index];
-    pthread_mutex_lock(&pool->lock);
-    
-    PoolBlock* block;
-    if (pool->free_list) {
-        // Fast path: reuse existing block
-        block = pool->free_list;
-        pool->free_list = block->next;
-        pool->free_blocks--;
-    } else {
-        // Slow path: allocate new block
-        block = allocate_pool_block(pool);
-        if (!block) {
-            pthread_mutex_unlock(&pool->lock);
-            return NULL;
-        }
+    if (size > MAX_POOLED_SIZE) return pool_alloc_large(size);
+    int cls = find_size_class(size);
+    PoolThreadClass* tc = &t_cache.classes[cls];
+    PoolBlock* block = tc->head;
+    if (!block) return pool_alloc_slow(cls);
+    tc->head = block->next;
+    tc->count--;
+    count_one(&tc->allocations);
+    return block;
+}
+
+void* wyn_pool_calloc(size_t count, size_t size) {
+    if (size && count > SIZE_MAX / size) return NULL;
+    size_t total = count * size;
+    if (total > MAX_POOLED_SIZE) {
+        count_one(&t_cache.large_allocations);
+        return calloc(count, size);
     }
-    
-    pool->allocations++;
-    pthread_mutex_unlock(&pool->lock);
-    
-    return block->data;
+    void* ptr = wyn_pool_alloc(total);
+    if (ptr) memset(ptr, 0, total);
+    return ptr;
 }
 
-// Fast pooled deallocation
-void wyn_pool_free(void* ptr, size_t size) {
+// Grows in place while the block's class has room; blocks from malloc stay there
+void* wyn_pool_realloc(void* ptr, size_t size) {
+    if (!ptr) return wyn_pool_alloc(size);
+    int cls = pool_class_of(ptr);
+    if (cls < 0) return realloc(ptr, size);
+    size_t have = SIZE_CLASSES[cls];
+    if (size <= have) return ptr;
+    void* grown = wyn_pool_alloc(size);
+    if (!grown) return NULL;
+    memcpy(grown, ptr, have);
+    pool_push(cls, ptr);
+    return grown;
+}
+
+// Fast pooled deallocation; also takes pointers that came from malloc
+void wyn_pool_release(void* ptr) {
     if (!ptr) return;
-    
-    int class_index = find_size_class(size);
-    if (class_index == -1) {
-        // Large allocation - use regular free
-        pthread_mutex_lock(&g_pool_manager.stats_lock);
-        g_pool_manager.large_deallocations++;
-        g_pool_manager.total_memory_used -= size;
-        pthread_mutex_unlock(&g_pool_manager.stats_lock);
-        
+    int cls = pool_class_of(ptr);
+    if (cls < 0) {
+        count_one(&t_cache.large_deallocations);
         free(ptr);
         return;
     }
-    
-    // Calculate block address from data pointer
-    PoolBlock* block = (PoolBlock*)((uint8_t*)ptr - sizeof(PoolBlock));
-    
-    MemoryPool* pool = &g_pool_manager.pools[class_index];
-    pthread_mutex_lock(&pool->lock);
-    
-    // Add to free list
-    block->next = pool->free_list;
-    pool->free_list = block;
-    pool->free_blocks++;
-    pool->deallocations++;
-    
-    pthread_mutex_unlock(&pool->lock);
+    pool_push(cls, ptr);
 }
 
-// Optimized ARC allocation using pools
-WynObject* wyn_arc_alloc_pooled(size_t size, uint32_t type_id, void (*destructor)(void*)) {
-    if (size == 0) {
-        report_error(ERR_INVALID_EXPRESSION, __FILE__, __LINE__, 0, "Cannot allocate zero-sized object");
-        return NULL;
+void wyn_pool_free(void* ptr, size_t size) {
+    (void)size;
+    wyn_pool_release(ptr);
+}
+
+// Thread caches for blocks another heap carves itself (the string heap)
+int wyn_pool_cache_register(size_t block_size) {
+    if (block_size < sizeof(PoolBlock)) return -1;
+    wyn_pool_init();
+    pthread_mutex_lock(&g_pool.registry_lock);
+    int id = atomic_load_explicit(&g_pool.class_count, memory_order_relaxed);
+    if (id < POOL_MAX_CACHES) {
+        class_init(&g_pool.classes[id], block_size);
+        atomic_store_explicit(&g_pool.class_count, id + 1, memory_order_release);
+    } else {
+        id = -1;
     }
-    
-    // Calculate total size including header
-    size_t total_size = sizeof(WynObjectHeader) + size;
-    
-    // Use pooled allocation
-    WynObject* obj = (WynObject*)wyn_pool_alloc(total_size);
-    if (!obj) {
-        report_error(ERR_OUT_OF_MEMORY, __FILE__, __LINE__, 0, "Failed to allocate ARC object from pool");
-        return NULL;
+    pthread_mutex_unlock(&g_pool.registry_lock);
+    return id;
+}
+
+void* wyn_pool_cache_pop(int cache) {
+    PoolThreadClass* tc = &t_cache.classes[cache];
+    if (!tc->head) {
+        pool_register_thread();
+        if (!pool_take_batch(cache, tc)) return NULL;
     }
-    
-    // Initialize header
-    obj->header.magic = ARC_MAGIC;
-    atomic_store(&obj->header.ref_count, 1);
-    obj->header.type_id = type_id;
-    obj->header.size = (uint32_t)size;
-    obj->header.destructor = destructor;
-    
-    // Zero-initialize data area
-    memset(obj->data, 0, size);
-    
+    PoolBlock* block = tc->head;
+    tc->head = block->next;
+    tc->count--;
+    count_one(&tc->allocations);
+    return block;
+}
+
+void wyn_pool_cache_push(int cache, void* block) {
+    pool_push(cache, block);
+}
+
+// Optimized ARC allocation using pools
+WynObject* wyn_arc_alloc_pooled(size_t size, uint32_t type_id, void (*destructor)(void*)) {
+    WynObject* obj = wyn_arc_alloc(size, type_id, destructor);
+    if (obj) memset(obj->data, 0, size);
     return obj;
 }
 
 // Optimized ARC deallocation using pools
 void wyn_arc_deallocate_pooled(WynObject* obj) {
-    if (!obj) return;
-    
-    // Call custom destructor if provided
-    if (obj->header.destructor) {
-        obj->header.destructor(obj->data);
+    wyn_arc_deallocate(obj);
+}
+
+// Returns everything a thread list holds, including the rest of its slab
+static void pool_flush_class(int cls, PoolThreadClass* tc) {
+    size_t block_size = g_pool.classes[cls].block_size;
+    while (tc->bump && tc->bump + block_size <= tc->bump_end) {
+        PoolBlock* block = (PoolBlock*)tc->bump;
+        block->next = tc->head;
+        tc->head = block;
+        tc->count++;
+        tc->bump += block_size;
+    }
+    tc->bump = tc->bump_end = NULL;
+    if (tc->head) pool_give_blocks(cls, tc->head, tc->count);
+    tc->head = NULL;
+    tc->count = 0;
+}
+
+static void pool_thread_exit(void* arg) {
+    PoolThreadCache* cache = arg;
+    int classes = atomic_load_explicit(&g_pool.class_count, memory_order_acquire);
+    for (int i = 0; i < classes; i++) pool_flush_class(i, &cache->classes[i]);
+
+    pthread_mutex_lock(&g_pool.registry_lock);
+    for (int i = 0; i < classes; i++) {
+        PoolThreadClass* tc = &cache->classes[i];
+        atomic_fetch_add(&g_pool.classes[i].allocations, atomic_load(&tc->allocations));
+        atomic_fetch_add(&g_pool.classes[i].deallocations, atomic_load(&tc->deallocations));
+        atomic_store(&tc->allocations, 0);
+        atomic_store(&tc->deallocations, 0);
+    }
+    atomic_fetch_add(&g_pool.large_allocations, atomic_load(&cache->large_allocations));
+    atomic_fetch_add(&g_pool.large_deallocations, atomic_load(&cache->large_deallocations));
+    atomic_store(&cache->large_allocations, 0);
+    atomic_store(&cache->large_deallocations, 0);
+    for (PoolThreadCache** link = &g_pool.threads; *link; link = &(*link)->next) {
+        if (*link == cache) {
+            *link = cache->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_pool.registry_lock);
+    cache->registered = false;
+}
+
+// Counters of class i across exited and live threads; registry_lock held
+static void class_counts(int i, size_t* allocations, size_t* deallocations) {
+    size_t allocs = atomic_load(&g_pool.classes[i].allocations);
+    size_t frees = atomic_load(&g_pool.classes[i].deallocations);
+    for (PoolThreadCache* cache = g_pool.threads; cache; cache = cache->next) {
+        allocs += atomic_load_explicit(&cache->classes[i].allocations, memory_order_relaxed);
+        frees += atomic_load_explicit(&cache->classes[i].deallocations, memory_order_relaxed);
+    }
+    *allocations = allocs;
+    *deallocations = frees;
+}
+
+static void large_counts(size_t* allocations, size_t* deallocations) {
+    size_t allocs = atomic_load(&g_pool.large_allocations);
+    size_t frees = atomic_load(&g_pool.large_deallocations);
+    for (PoolThreadCache* cache = g_pool.threads; cache; cache = cache->next) {
+        allocs += atomic_load_explicit(&cache->large_allocations, memory_order_relaxed);
+        frees += atomic_load_explicit(&cache->large_deallocations, memory_order_relaxed);
     }
-    
-    // Calculate total size for pool deallocation
-    size_t total_size = sizeof(WynObjectHeader) + obj->header.size;
-    
-    // Clear magic number for safety
-    obj->header.magic = 0;
-    
-    // Use pooled deallocation
-    wyn_pool_free(obj, total_size);
-}
-
-// Pool statistics
-// (Defined in arc_runtime.h)
+    *allocations = allocs;
+    *deallocations = frees;
+}
+
+// Pool statistics. Registered caches are not counted here: their blocks
+// belong to the heap that carved them.
 WynPoolStats wyn_pool_get_stats(void) {
     wyn_pool_init();
-    
+
     WynPoolStats stats = {0};
     stats.total_pools = NUM_SIZE_CLASSES;
-    
-    for (size_t i = 0; i < NUM_SIZE_CLASSES; i++) {
-        MemoryPool* pool = &g_pool_manager.pools[i];
-        pthread_mutex_lock(&pool->lock);
-        
-        stats.total_blocks += pool->total_blocks;
-        stats.free_blocks += pool->free_blocks;
-        stats.total_allocations += pool->allocations;
-        stats.total_deallocations += pool->deallocations;
-        
-        pthread_mutex_unlock(&pool->lock);
+
+    pthread_mutex_lock(&g_pool.registry_lock);
+    for (int i = 0; i < NUM_SIZE_CLASSES; i++) {
+        size_t allocs, frees;
+        class_counts(i, &allocs, &frees);
+        size_t block_size = SIZE_CLASSES[i];
+        size_t carved = atomic_load_explicit(&g_pool.classes[i].carved, memory_order_relaxed);
+        size_t blocks = carved / slab_size(block_size) * (slab_size(block_size) / block_size);
+        size_t live = allocs > frees ? allocs - frees : 0;
+        if (live > blocks) live = blocks;
+        stats.total_blocks += blocks;
+        stats.free_blocks += blocks - live;
+        stats.total_allocations += allocs;
+        stats.total_deallocations += frees;
+        stats.total_memory_used += live * block_size;
+        stats.peak_memory_used += carved;
     }
-    
-    pthread_mutex_lock(&g_pool_manager.stats_lock);
-    stats.large_allocations = g_pool_manager.large_allocations;
-    stats.large_deallocations = g_pool_manager.large_deallocations;
-    stats.total_memory_used = g_pool_manager.total_memory_used;
-    stats.peak_memory_used = g_pool_manager.peak_memory_used;
-    pthread_mutex_unlock(&g_pool_manager.stats_lock);
-    
+    large_counts(&stats.large_allocations, &stats.large_deallocations);
+    pthread_mutex_unlock(&g_pool.registry_lock);
+
+    stats.total_allocations -= g_pool.base_allocations;
+    stats.total_deallocations -= g_pool.base_deallocations;
+    stats.large_allocations -= g_pool.base_large_allocations;
+    stats.large_deallocations -= g_pool.base_large_deallocations;
+
     // Calculate derived statistics
     if (stats.total_blocks > 0) {
         stats.fragmentation_ratio = (double)stats.free_blocks / stats.total_blocks;
         stats.pool_utilization = 1.0 - stats.fragmentation_ratio;
     }
-    
+
     return stats;
 }
 
 void wyn_pool_reset_stats(void) {
-    for (size_t i = 0; i < NUM_SIZE_CLASSES; i++) {
-        MemoryPool* pool = &g_pool_manager.pools[i];
-        pthread_mutex_lock(&pool->lock);
-        pool->allocations = 0;
-        pool->deallocations = 0;
-        pthread_mutex_unlock(&pool->lock);
+    g_pool.base_allocations = g_pool.base_deallocations = 0;
+    g_pool.base_large_allocations = g_pool.base_large_deallocations = 0;
+    WynPoolStats stats = wyn_pool_get_stats();
+    g_pool.base_allocations = stats.total_allocations;
+    g_pool.base_deallocations = stats.total_deallocations;
+    g_pool.base_large_allocations = stats.large_allocations;
+    g_pool.base_large_deallocations = stats.large_deallocations;
+}
+
+static void write_stats(FILE* out) {
+    WynPoolStats stats = wyn_pool_get_stats();
+
+    fprintf(out, "=== Memory Pool Statistics ===\n");
+    fprintf(out, "Total pools: %zu\n", stats.total_pools);
+    fprintf(out, "Total blocks: %zu\n", stats.total_blocks);
+    fprintf(out, "Free blocks: %zu\n", stats.free_blocks);
+    fprintf(out, "Pool allocations: %zu\n", stats.total_allocations);
+    fprintf(out, "Pool deallocations: %zu\n", stats.total_deallocations);
+    fprintf(out, "Large allocations: %zu\n", stats.large_allocations);
+    fprintf(out, "Large deallocations: %zu\n", stats.large_deallocations);
+    fprintf(out, "Total memory used: %zu bytes\n", stats.total_memory_used);
+    fprintf(out, "Peak memory used: %zu bytes\n", stats.peak_memory_used);
+    fprintf(out, "Fragmentation ratio: %.2f%%\n", stats.fragmentation_ratio * 100);
+    fprintf(out, "Pool utilization: %.2f%%\n", stats.pool_utilization * 100);
+    fprintf(out, "==============================\n");
+}
+
+static void write_detailed_stats(FILE* out) {
+    wyn_pool_init();
+
+    fprintf(out, "=== Detailed Pool Statistics ===\n");
+    pthread_mutex_lock(&g_pool.registry_lock);
+    int classes = atomic_load_explicit(&g_pool.class_count, memory_order_acquire);
+    for (int i = 0; i < classes; i++) {
+        PoolClass* pc = &g_pool.classes[i];
+        size_t allocs, frees;
+        class_counts(i, &allocs, &frees);
+        pthread_mutex_lock(&pc->lock);
+        size_t central = pc->central_blocks;
+        pthread_mutex_unlock(&pc->lock);
+        if (i < NUM_SIZE_CLASSES) {
+            fprintf(out, "Pool %d (size %zu): %zu KB carved, %zu central, %zu allocs, %zu deallocs\n",
+                    i, pc->block_size, atomic_load(&pc->carved) / 1024, central, allocs, frees);
+        } else {
+            fprintf(out, "Cache %d (size %zu): %zu central, %zu reused, %zu returned\n",
+                    i, pc->block_size, central, allocs, frees);
+        }
     }
-    
-    pthread_mutex_lock(&g_pool_manager.stats_lock);
-    g_pool_manager.large_allocations = 0;
-    g_pool_manager.large_deallocations = 0;
-    pthread_mutex_unlock(&g_pool_manager.stats_lock);
+    pthread_mutex_unlock(&g_pool.registry_lock);
+    fprintf(out, "================================\n");
 }
 
 void wyn_pool_print_stats(void) {
-    WynPoolStats stats = wyn_pool_get_stats();
-    
-    printf("=== Memory Pool Statistics ===\n");
-    printf("Total pools: %zu\n", stats.total_pools);
-    printf("Total blocks: %zu\n", stats.total_blocks);
-    printf("Free blocks: %zu\n", stats.free_blocks);
-    printf("Pool allocations: %zu\n", stats.total_allocations);
-    printf("Pool deallocations: %zu\n", stats.total_deallocations);
-    printf("Large allocations: %zu\n", stats.large_allocations);
-    printf("Large deallocations: %zu\n", stats.large_deallocations);
-    printf("Total memory used: %zu bytes\n", stats.total_memory_used);
-    printf("Peak memory used: %zu bytes\n", stats.peak_memory_used);
-    printf("Fragmentation ratio: %.2f%%\n", stats.fragmentation_ratio * 100);
-    printf("Pool utilization: %.2f%%\n", stats.pool_utilization * 100);
-    printf("==============================\n");
+    write_stats(stdout);
 }
 
 // Detailed pool information
 void wyn_pool_print_detailed_stats(void) {
-    wyn_pool_init();
-    
-    printf("=== Detailed Pool Statistics ===\n");
-    for (size_t i = 0; i < NUM_SIZE_CLASSES; i++) {
-        MemoryPool* pool = &g_pool_manager.pools[i];
-        pthread_mutex_lock(&pool->lock);
-        
-        printf("Pool %zu (size %zu): %zu total, %zu free, %zu allocs, %zu deallocs\n",
-               i, pool->block_size, pool->total_blocks, pool->free_blocks,
-               pool->allocations, pool->deallocations);
-        
-        pthread_mutex_unlock(&pool->lock);
-    }
-    printf("================================\n");
+    write_detailed_stats(stdout);
 }
 
-// Pool cleanup
+static void pool_dump_stats(void) {
+    write_stats(stderr);
+    if (g_pool.stats_level >= 2) write_detailed_stats(stderr);
+}
+
+// Hands the calling thread's cached blocks back to the central lists. Slabs
+// stay reserved for the life of the process.
 void wyn_pool_cleanup(void) {
-    if (!g_pool_manager.initialized) return;
-    
-    for (size_t i = 0; i < NUM_SIZE_CLASSES; i++) {
-        MemoryPool* pool = &g_pool_manager.pools[i];
-        pthread_mutex_lock(&pool->lock);
-        
-        // Free all blocks in the pool
-        PoolBlock* current = pool->free_list;
-        while (current) {
-            PoolBlock* next = current->next;
-            free(current);
-            current = next;
-        }
-        
-        pool->free_list = NULL;
-        pool->total_blocks = 0;
-        pool->free_blocks = 0;
-        
-        pthread_mutex_unlock(&pool->lock);
-        pthread_mutex_destroy(&pool->lock);
-    }
-    
-    pthread_mutex_destroy(&g_pool_manager.stats_lock);
-    g_pool_manager.initialized = false;
+    if (!t_cache.registered) return;
+    int classes = atomic_load_explicit(&g_pool.class_count, memory_order_acquire);
+    for (int i = 0; i < classes; i++) pool_flush_class(i, &t_cache.classes[i]);
 }
 
 // Batch allocation for improved performance
 void wyn_pool_alloc_batch(void** ptrs, size_t* sizes, size_t count) {
     if (!ptrs || !sizes || count == 0) return;
-    
+
     for (size_t i = 0; i < count; i++) {
         ptrs[i] = wyn_pool_alloc(sizes[i]);
     }
@@ -347,10 +560,10 @@ void wyn_pool_alloc_batch(void** ptrs, size_t* sizes, size_t count) {
 
 void wyn_pool_free_batch(void** ptrs, size_t* sizes, size_t count) {
     if (!ptrs || !sizes || count == 0) return;
-    
+
     for (size_t i = 0; i < count; i++) {
         if (ptrs[i]) {
-            wyn_pool_free(ptrs[i], sizes[i]);
+            wyn_pool_release(ptrs[i]);
             ptrs[i] = NULL;
         }
     }
@@ -281,7 +281,6 @@ Program* load_module(const char* module_name) {
     fread(source, 1, size, f);
     source[size] = '\0';
     fclose(f);
-    free(path);
     
     // Save current module path before loading imports
     char saved_module_path[512];
@@ -319,9 +318,10 @@ Program* load_module(const char* module_name) {
     
     // Register module
     if (prog) {
-        extern void register_module(const char* name, Program* ast);
-        register_module(resolved_name, prog);
+        extern void register_module(const char* name, const char* path, Program* ast);
+        register_module(resolved_name, path, prog);
     }
+    free(path);
     
     // Remove from loading stack
     pop_loading_stack();
@@ -13,16 +13,39 @@ void init_module_registry() {
     }
 }
 
-void register_module(const char* name, Program* ast) {
+void register_module(const char* name, const char* path, Program* ast) {
     if (global_module_registry.count >= 64) return;
     
     ModuleEntry* entry = malloc(sizeof(ModuleEntry));
     entry->name = strdup(name);
+    entry->path = path ? strdup(path) : NULL;
     entry->ast = ast;
     
     global_module_registry.modules[global_module_registry.count++] = entry;
 }
 
+int forget_module_file(const char* path) {
+    int kept = 0;
+    int dropped = 0;
+    for (int i = 0; i < global_module_registry.count; i++) {
+        ModuleEntry* entry = global_module_registry.modules[i];
+        if (entry->path && strcmp(entry->path, path) == 0) {
+            // The AST is not freed: types from earlier checks may still point into it
+            free(entry->name);
+            free(entry->path);
+            free(entry);
+            dropped++;
+        } else {
+            global_module_registry.modules[kept++] = entry;
+        }
+    }
+    for (int i = kept; i < global_module_registry.count; i++) {
+        global_module_registry.modules[i] = NULL;
+    }
+    global_module_registry.count = kept;
+    return dropped;
+}
+
 Program* get_module(const char* name) {
     for (int i = 0; i < global_module_registry.count; i++) {
         if (strcmp(global_module_registry.modules[i]->name, name) == 0) {
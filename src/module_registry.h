@@ -5,6 +5,7 @@
 
 typedef struct {
     char* name;
+    char* path;         // source file, NULL if not loaded from one
     Program* ast;
 } ModuleEntry;
 
@@ -20,7 +21,11 @@ extern ModuleRegistry global_module_registry;
 void init_module_registry();
 
 // Register a module
-void register_module(const char* name, Program* ast);
+void register_module(const char* name, const char* path, Program* ast);
+
+// Drop the modules parsed from path so the next import parses it again.
+// Returns how many were dropped.
+int forget_module_file(const char* path);
 
 // Get a module
 Program* get_module(const char* name);
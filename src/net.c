@@ -35,6 +35,166 @@ static WynNetError errno_to_net_error(int err) {
     }
 }
 
+// Buffered reads
+void wyn_read_buffer_init(WynReadBuffer* buf) {
+    buf->data = NULL;
+    buf->start = 0;
+    buf->end = 0;
+    buf->cap = 0;
+}
+
+void wyn_read_buffer_free(WynReadBuffer* buf) {
+    free(buf->data);
+    wyn_read_buffer_init(buf);
+}
+
+// One recv() into the free space after the buffered bytes, making room
+// first: slide unread bytes to the front, or double the buffer when it is
+// full of them. Returns bytes read, 0 at end of stream, -1 on error.
+static ssize_t read_buffer_fill(WynReadBuffer* buf, int fd, size_t want, WynNetError* error) {
+    size_t pending = buf->end - buf->start;
+    if (pending == 0) {
+        buf->start = buf->end = 0;
+        // Drop a buffer grown for one oversized record
+        if (buf->cap > WYN_NET_READ_BUFFER_SIZE * 4) {
+            free(buf->data);
+            buf->data = NULL;
+            buf->cap = 0;
+        }
+    }
+    if (buf->cap - buf->end < want && buf->start > 0) {
+        memmove(buf->data, buf->data + buf->start, pending);
+        buf->start = 0;
+        buf->end = pending;
+    }
+    if (buf->cap - buf->end < want) {
+        size_t cap = buf->cap ? buf->cap * 2 : WYN_NET_READ_BUFFER_SIZE;
+        while (cap - buf->end < want) cap *= 2;
+        char* data = realloc(buf->data, cap);
+        if (!data) {
+            if (error) *error = WYN_NET_ERROR_UNKNOWN;
+            return -1;
+        }
+        buf->data = data;
+        buf->cap = cap;
+    }
+    
+    ssize_t n;
+    do {
+        n = recv(fd, buf->data + buf->end, buf->cap - buf->end, 0);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        if (error) *error = errno_to_net_error(errno);
+        return -1;
+    }
+    buf->end += (size_t)n;
+    return n;
+}
+
+static const char* find_delim(const char* from, size_t len, const char* delim, size_t delim_len) {
+    if (delim_len == 1) return memchr(from, delim[0], len);
+    if (len < delim_len) return NULL;
+    const char* last = from + len - delim_len;
+    for (const char* p = from; p <= last; p++) {
+        p = memchr(p, delim[0], (size_t)(last - p) + 1);
+        if (!p) return NULL;
+        if (memcmp(p, delim, delim_len) == 0) return p;
+    }
+    return NULL;
+}
+
+const char* wyn_read_buffer_until(WynReadBuffer* buf, int fd, const char* delim, size_t delim_len, size_t* len_out, WynNetError* error) {
+    if (!delim || delim_len == 0) {
+        if (error) *error = WYN_NET_ERROR_INVALID_ADDR;
+        return NULL;
+    }
+    
+    // Bytes already searched, relative to start, so they survive compaction
+    size_t scanned = 0;
+    for (;;) {
+        const char* base = buf->data + buf->start;
+        size_t pending = buf->end - buf->start;
+        const char* hit = pending ? find_delim(base + scanned, pending - scanned, delim, delim_len) : NULL;
+        if (hit) {
+            size_t len = (size_t)(hit - base);
+            buf->start += len + delim_len;
+            if (len_out) *len_out = len;
+            if (error) *error = WYN_NET_SUCCESS;
+            return base;
+        }
+        // A delimiter may straddle the end of what is buffered
+        scanned = pending >= delim_len ? pending - delim_len + 1 : 0;
+        
+        ssize_t n = read_buffer_fill(buf, fd, 1, error);
+        if (n < 0) return NULL;
+        if (n == 0) {
+            pending = buf->end - buf->start;
+            if (pending == 0) {
+                if (error) *error = WYN_NET_ERROR_CLOSED;
+                return NULL;
+            }
+            base = buf->data + buf->start;
+            buf->start = buf->end;
+            if (len_out) *len_out = pending;
+            if (error) *error = WYN_NET_SUCCESS;
+            return base;
+        }
+    }
+}
+
+const char* wyn_read_buffer_take(WynReadBuffer* buf, int fd, size_t len, WynNetError* error) {
+    while (buf->end - buf->start < len) {
+        ssize_t n = read_buffer_fill(buf, fd, len - (buf->end - buf->start), error);
+        if (n < 0) return NULL;
+        if (n == 0) {
+            if (error) *error = WYN_NET_ERROR_CLOSED;
+            return NULL;
+        }
+    }
+    const char* data = buf->data + buf->start;
+    buf->start += len;
+    if (error) *error = WYN_NET_SUCCESS;
+    return data;
+}
+
+const char* wyn_read_buffer_peek(WynReadBuffer* buf, int fd, size_t* len_out, WynNetError* error) {
+    if (buf->end == buf->start && read_buffer_fill(buf, fd, 1, error) < 0) return NULL;
+    if (len_out) *len_out = buf->end - buf->start;
+    if (error) *error = WYN_NET_SUCCESS;
+    return buf->data ? buf->data + buf->start : "";
+}
+
+WynNetError wyn_read_buffer_read(WynReadBuffer* buf, int fd, void* out, size_t len, size_t* received) {
+    size_t pending = buf->end - buf->start;
+    // Small reads refill the buffer so the next ones need no syscall;
+    // large ones go straight into out
+    if (pending == 0 && len < WYN_NET_READ_BUFFER_SIZE) {
+        WynNetError error = WYN_NET_SUCCESS;
+        ssize_t n = read_buffer_fill(buf, fd, 1, &error);
+        if (n < 0) return error;
+        pending = (size_t)n;
+        if (pending == 0) {
+            if (received) *received = 0;
+            return WYN_NET_SUCCESS;
+        }
+    }
+    if (pending > 0) {
+        size_t n = pending < len ? pending : len;
+        memcpy(out, buf->data + buf->start, n);
+        buf->start += n;
+        if (received) *received = n;
+        return WYN_NET_SUCCESS;
+    }
+    
+    ssize_t n;
+    do {
+        n = recv(fd, out, len, 0);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) return errno_to_net_error(errno);
+    if (received) *received = (size_t)n;
+    return WYN_NET_SUCCESS;
+}
+
 // Socket address operations
 WynSocketAddr* wyn_socket_addr_new(const char* ip, uint16_t port) {
     if (!ip) return NULL;
@@ -451,6 +611,7 @@ WynTcpStream* wyn_tcp_listener_accept(WynTcpListener* listener, WynNetError* err
     
     stream->socket = client_socket;
     stream->peer_addr = peer_addr;
+    wyn_read_buffer_init(&stream->input);
     
     return stream;
 }
@@ -498,6 +659,7 @@ WynTcpStream* wyn_tcp_stream_connect(const char* addr, WynNetError* error) {
     
     stream->socket = socket;
     stream->peer_addr = *socket_addr;
+    wyn_read_buffer_init(&stream->input);
     wyn_socket_addr_free(socket_addr);
     
     if (error) *error = WYN_NET_SUCCESS;
@@ -510,8 +672,8 @@ WynNetError wyn_tcp_stream_send(WynTcpStream* stream, const void* data, size_t l
 }
 
 WynNetError wyn_tcp_stream_recv(WynTcpStream* stream, void* buffer, size_t len, size_t* received) {
-    if (!stream) return WYN_NET_ERROR_INVALID_ADDR;
-    return wyn_socket_recv(stream->socket, buffer, len, received);
+    if (!stream || !buffer) return WYN_NET_ERROR_INVALID_ADDR;
+    return wyn_read_buffer_read(&stream->input, stream->socket->fd, buffer, len, received);
 }
 
 WynNetError wyn_tcp_stream_send_all(WynTcpStream* stream, const void* data, size_t len) {
@@ -532,41 +694,58 @@ WynNetError wyn_tcp_stream_send_all(WynTcpStream* stream, const void* data, size
     return WYN_NET_SUCCESS;
 }
 
-char* wyn_tcp_stream_recv_line(WynTcpStream* stream, WynNetError* error) {
-    if (!stream) {
+char* wyn_tcp_stream_read_until(WynTcpStream* stream, const char* delim, size_t* len_out, WynNetError* error) {
+    if (!stream || !delim) {
         if (error) *error = WYN_NET_ERROR_INVALID_ADDR;
         return NULL;
     }
     
-    char* line = malloc(1024);
-    if (!line) {
+    size_t len;
+    const char* data = wyn_read_buffer_until(&stream->input, stream->socket->fd, delim, strlen(delim), &len, error);
+    if (!data) return NULL;
+    
+    char* result = malloc(len + 1);
+    if (!result) {
         if (error) *error = WYN_NET_ERROR_UNKNOWN;
         return NULL;
     }
+    memcpy(result, data, len);
+    result[len] = '\0';
+    if (len_out) *len_out = len;
+    return result;
+}
+
+char* wyn_tcp_stream_read_line(WynTcpStream* stream, WynNetError* error) {
+    size_t len;
+    char* line = wyn_tcp_stream_read_until(stream, "\n", &len, error);
+    if (line && len > 0 && line[len - 1] == '\r') line[len - 1] = '\0';
+    return line;
+}
+
+WynNetError wyn_tcp_stream_read_exact(WynTcpStream* stream, void* buffer, size_t len) {
+    if (!stream || !buffer) return WYN_NET_ERROR_INVALID_ADDR;
     
-    size_t pos = 0;
-    char ch;
-    
-    while (pos < 1023) {
+    WynReadBuffer* input = &stream->input;
+    char* out = buffer;
+    while (len > 0) {
         size_t received;
-        WynNetError recv_error = wyn_tcp_stream_recv(stream, &ch, 1, &received);
-        
-        if (recv_error != WYN_NET_SUCCESS) {
-            if (error) *error = recv_error;
-            free(line);
-            return NULL;
-        }
-        
-        if (received == 0) break;  // Connection closed
-        
-        if (ch == '\n') break;
-        if (ch != '\r') {
-            line[pos++] = ch;
-        }
+        WynNetError error = wyn_read_buffer_read(input, stream->socket->fd, out, len, &received);
+        if (error != WYN_NET_SUCCESS) return error;
+        if (received == 0) return WYN_NET_ERROR_CLOSED;
+        out += received;
+        len -= received;
     }
-    
-    line[pos] = '\0';
-    if (error) *error = WYN_NET_SUCCESS;
+    return WYN_NET_SUCCESS;
+}
+
+char* wyn_tcp_stream_recv_line(WynTcpStream* stream, WynNetError* error) {
+    WynNetError read_error;
+    char* line = wyn_tcp_stream_read_line(stream, &read_error);
+    if (!line && read_error == WYN_NET_ERROR_CLOSED) {
+        line = calloc(1, 1);
+        read_error = line ? WYN_NET_SUCCESS : WYN_NET_ERROR_UNKNOWN;
+    }
+    if (error) *error = read_error;
     return line;
 }
 
@@ -577,6 +756,7 @@ WynNetError wyn_tcp_stream_close(WynTcpStream* stream) {
 
 void wyn_tcp_stream_free(WynTcpStream* stream) {
     if (!stream) return;
+    wyn_read_buffer_free(&stream->input);
     wyn_socket_free(stream->socket);
     free(stream);
 }
@@ -666,6 +846,7 @@ const char* wyn_net_error_string(WynNetError error) {
         case WYN_NET_ERROR_PERMISSION_DENIED: return "Permission denied";
         case WYN_NET_ERROR_INTERRUPTED: return "Operation interrupted";
         case WYN_NET_ERROR_WOULD_BLOCK: return "Operation would block";
+        case WYN_NET_ERROR_CLOSED: return "Connection closed";
         default: return "Unknown network error";
     }
 }
@@ -24,6 +24,7 @@ typedef enum {
     WYN_NET_ERROR_INTERRUPTED,
     WYN_NET_ERROR_WOULD_BLOCK,
     WYN_NET_ERROR_SOCKET_CONFIG,
+    WYN_NET_ERROR_CLOSED,
     WYN_NET_ERROR_UNKNOWN
 } WynNetError;
 
@@ -62,10 +63,23 @@ typedef struct WynTcpListener {
     WynSocketAddr addr;
 } WynTcpListener;
 
+// Read-ahead buffer for a stream socket. Each refill is one recv() of as
+// much as fits; delimiters are found with memchr over what is buffered, and
+// the buffer grows when a record is longer than its capacity.
+#define WYN_NET_READ_BUFFER_SIZE 16384
+
+typedef struct WynReadBuffer {
+    char* data;
+    size_t start;  // first unread byte
+    size_t end;    // end of buffered bytes
+    size_t cap;
+} WynReadBuffer;
+
 // TCP Stream
 typedef struct WynTcpStream {
     WynSocket* socket;
     WynSocketAddr peer_addr;
+    WynReadBuffer input;
 } WynTcpStream;
 
 // UDP Socket
@@ -73,6 +87,22 @@ typedef struct WynUdpSocket {
     WynSocket* socket;
 } WynUdpSocket;
 
+// Buffered reads on fd. The pointers returned by _until and _take point into
+// the buffer and stay valid until the next call on it; the bytes are consumed.
+void wyn_read_buffer_init(WynReadBuffer* buf);
+void wyn_read_buffer_free(WynReadBuffer* buf);
+// Bytes up to delim (not included; delim is consumed). At end of stream the
+// remaining bytes are returned without a delimiter, then NULL with
+// WYN_NET_ERROR_CLOSED.
+const char* wyn_read_buffer_until(WynReadBuffer* buf, int fd, const char* delim, size_t delim_len, size_t* len_out, WynNetError* error);
+// Exactly len bytes; NULL with WYN_NET_ERROR_CLOSED if the stream ends first
+const char* wyn_read_buffer_take(WynReadBuffer* buf, int fd, size_t len, WynNetError* error);
+// What is buffered, reading once if nothing is; *len_out is 0 at end of
+// stream. Nothing is consumed: advance buf->start past what was used.
+const char* wyn_read_buffer_peek(WynReadBuffer* buf, int fd, size_t* len_out, WynNetError* error);
+// Like recv(): buffered bytes first; 0 received means end of stream
+WynNetError wyn_read_buffer_read(WynReadBuffer* buf, int fd, void* out, size_t len, size_t* received);
+
 // Socket address operations
 WynSocketAddr* wyn_socket_addr_new(const char* ip, uint16_t port);
 WynSocketAddr* wyn_socket_addr_parse(const char* addr_str);
@@ -108,6 +138,12 @@ WynTcpStream* wyn_tcp_stream_connect(const char* addr, WynNetError* error);
 WynNetError wyn_tcp_stream_send(WynTcpStream* stream, const void* data, size_t len, size_t* sent);
 WynNetError wyn_tcp_stream_recv(WynTcpStream* stream, void* buffer, size_t len, size_t* received);
 WynNetError wyn_tcp_stream_send_all(WynTcpStream* stream, const void* data, size_t len);
+// Buffered reads; results are malloc'd and NUL-terminated
+char* wyn_tcp_stream_read_until(WynTcpStream* stream, const char* delim, size_t* len_out, WynNetError* error);
+// A line without its "\n" or "\r\n"
+char* wyn_tcp_stream_read_line(WynTcpStream* stream, WynNetError* error);
+WynNetError wyn_tcp_stream_read_exact(WynTcpStream* stream, void* buffer, size_t len);
+// read_line that returns "" at end of stream
 char* wyn_tcp_stream_recv_line(WynTcpStream* stream, WynNetError* error);
 WynNetError wyn_tcp_stream_close(WynTcpStream* stream);
 void wyn_tcp_stream_free(WynTcpStream* stream);
@@ -15,198 +15,45 @@
 #include <errno.h>
 #include <poll.h>
 #include <time.h>
+#include <pthread.h>
+#include "net.h"
+#include "http_client.h"
+#include "string_runtime.h"
 
 // ============================================================================
 // HTTP Client
 // ============================================================================
 
-typedef struct {
-    int status_code;
-    char* headers;
-    char* body;
-    int body_len;
-} HttpResponse;
-
-// Parse HTTP response
-static HttpResponse* parse_http_response(const char* raw) {
-    HttpResponse* resp = malloc(sizeof(HttpResponse));
-    if (!resp) return NULL;
-    
-    resp->status_code = 0;
-    resp->headers = NULL;
-    resp->body = NULL;
-    resp->body_len = 0;
-    
-    // Parse status line
-    if (sscanf(raw, "HTTP/%*d.%*d %d", &resp->status_code) != 1) {
-        free(resp);
-        return NULL;
-    }
-    
-    // Find body separator
-    const char* body_start = strstr(raw, "\r\n\r\n");
-    if (body_start) {
-        body_start += 4;
-        
-        // Extract headers
-        int header_len = body_start - raw - 4;
-        resp->headers = malloc(header_len + 1);
-        if (resp->headers) {
-            memcpy(resp->headers, raw, header_len);
-            resp->headers[header_len] = '\0';
-        }
-        
-        // Extract body
-        resp->body_len = strlen(body_start);
-        resp->body = malloc(resp->body_len + 1);
-        if (resp->body) {
-            memcpy(resp->body, body_start, resp->body_len);
-            resp->body[resp->body_len] = '\0';
-        }
-    }
-    
-    return resp;
-}
+// Requests go through the pooled keep-alive client in http_client.c
+typedef WynHttpResponse HttpResponse;
 
 // HTTP GET request
 HttpResponse* Http_get(const char* url) {
-    // Parse URL
-    char host[256] = {0};
-    char path[512] = "/";
-    int port = 80;
-    int use_https = 0;
-    
-    if (strncmp(url, "https://", 8) == 0) {
-        use_https = 1;
-        port = 443;
-        sscanf(url + 8, "%255[^/]%511s", host, path);
-    } else if (strncmp(url, "http://", 7) == 0) {
-        sscanf(url + 7, "%255[^/]%511s", host, path);
-    } else {
-        sscanf(url, "%255[^/]%511s", host, path);
-    }
-    
-    // Check for port in host
-    char* colon = strchr(host, ':');
-    if (colon) {
-        *colon = '\0';
-        port = atoi(colon + 1);
-    }
-    
-    // Resolve host
-    struct hostent* he = gethostbyname(host);
-    if (!he) return NULL;
-    
-    // Create socket
-    int sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock < 0) return NULL;
-    
-    struct sockaddr_in addr;
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(port);
-    memcpy(&addr.sin_addr, he->h_addr_list[0], he->h_length);
-    
-    // Connect
-    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-        close(sock);
-        return NULL;
-    }
-    
-    // Build request
-    char request[2048];
-    snprintf(request, sizeof(request),
-        "GET %s HTTP/1.1\r\n"
-        "Host: %s\r\n"
-        "User-Agent: Wyn/1.0\r\n"
-        "Accept: */*\r\n"
-        "Connection: close\r\n"
-        "\r\n",
-        path, host);
-    
-    // Send request
-    send(sock, request, strlen(request), 0);
-    
-    // Receive response
-    char buffer[65536] = {0};
-    int total = 0;
-    int n;
-    while ((n = recv(sock, buffer + total, sizeof(buffer) - total - 1, 0)) > 0) {
-        total += n;
-        if (total >= sizeof(buffer) - 1) break;
-    }
-    
-    close(sock);
-    
-    return parse_http_response(buffer);
+    WynHttpRequest req;
+    memset(&req, 0, sizeof(req));
+    req.url = url;
+    return wyn_http_request(&req, NULL, 0);
 }
 
 // HTTP POST request
 HttpResponse* Http_post(const char* url, const char* body, const char* content_type) {
-    // Parse URL (same as GET)
-    char host[256] = {0};
-    char path[512] = "/";
-    int port = 80;
-    
-    if (strncmp(url, "http://", 7) == 0) {
-        sscanf(url + 7, "%255[^/]%511s", host, path);
-    } else {
-        sscanf(url, "%255[^/]%511s", host, path);
-    }
-    
-    char* colon = strchr(host, ':');
-    if (colon) {
-        *colon = '\0';
-        port = atoi(colon + 1);
-    }
-    
-    struct hostent* he = gethostbyname(host);
-    if (!he) return NULL;
-    
-    int sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock < 0) return NULL;
-    
-    struct sockaddr_in addr;
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(port);
-    memcpy(&addr.sin_addr, he->h_addr_list[0], he->h_length);
-    
-    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-        close(sock);
-        return NULL;
-    }
-    
-    // Build request
-    char request[4096];
-    snprintf(request, sizeof(request),
-        "POST %s HTTP/1.1\r\n"
-        "Host: %s\r\n"
-        "User-Agent: Wyn/1.0\r\n"
-        "Content-Type: %s\r\n"
-        "Content-Length: %zu\r\n"
-        "Connection: close\r\n"
-        "\r\n"
-        "%s",
-        path, host, content_type ? content_type : "application/json",
-        strlen(body), body);
-    
-    send(sock, request, strlen(request), 0);
-    
-    char buffer[65536] = {0};
-    int total = 0;
-    int n;
-    while ((n = recv(sock, buffer + total, sizeof(buffer) - total - 1, 0)) > 0) {
-        total += n;
-        if (total >= sizeof(buffer) - 1) break;
-    }
-    
-    close(sock);
-    
-    return parse_http_response(buffer);
+    char headers[320];
+    snprintf(headers, sizeof(headers), "Content-Type: %s\r\n",
+             content_type ? content_type : "application/json");
+    
+    WynHttpRequest req;
+    memset(&req, 0, sizeof(req));
+    req.method = "POST";
+    req.url = url;
+    req.headers = headers;
+    req.body = body ? body : "";
+    req.body_len = body ? wyn_str_len(body) : 0;
+    return wyn_http_request(&req, NULL, 0);
 }
 
 // Get response status
 int Http_status(HttpResponse* resp) {
-    return resp ? resp->status_code : 0;
+    return resp ? resp->status : 0;
 }
 
 // Get response body
@@ -216,33 +63,14 @@ const char* Http_body(HttpResponse* resp) {
 
 // Get response header
 const char* Http_header(HttpResponse* resp, const char* name) {
-    if (!resp || !resp->headers) return "";
-    
-    char search[256];
-    snprintf(search, sizeof(search), "%s:", name);
-    
-    const char* found = strstr(resp->headers, search);
-    if (!found) return "";
-    
-    found += strlen(search);
-    while (*found == ' ') found++;
-    
-    static char value[512];
-    int i = 0;
-    while (*found && *found != '\r' && *found != '\n' && i < 511) {
-        value[i++] = *found++;
-    }
-    value[i] = '\0';
-    
-    return value;
+    size_t len;
+    const char* value = wyn_http_response_header(resp, name, &len);
+    return value ? wyn_str_new(value, len) : "";
 }
 
 // Free response
 void Http_free(HttpResponse* resp) {
-    if (!resp) return;
-    free(resp->headers);
-    free(resp->body);
-    free(resp);
+    wyn_http_response_free(resp);
 }
 
 // ============================================================================
@@ -342,22 +170,96 @@ int Socket_poll_read(int sock, int timeout_ms) {
     return poll(&pfd, 1, timeout_ms);
 }
 
-// Read line from socket
+// Read-ahead buffers for the Socket_read_* functions, indexed by fd and
+// created on first read. Socket_close drops the buffer with the socket, so
+// a reused fd never sees a previous connection's bytes.
+static WynReadBuffer** socket_buffers = NULL;
+static int socket_buffer_count = 0;
+static pthread_mutex_t socket_buffers_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static WynReadBuffer* socket_buffer(int sock) {
+    if (sock < 0) return NULL;
+    pthread_mutex_lock(&socket_buffers_lock);
+    if (sock >= socket_buffer_count) {
+        int count = socket_buffer_count ? socket_buffer_count : 64;
+        while (count <= sock) count *= 2;
+        WynReadBuffer** table = realloc(socket_buffers, count * sizeof(WynReadBuffer*));
+        if (!table) {
+            pthread_mutex_unlock(&socket_buffers_lock);
+            return NULL;
+        }
+        memset(table + socket_buffer_count, 0, (count - socket_buffer_count) * sizeof(WynReadBuffer*));
+        socket_buffers = table;
+        socket_buffer_count = count;
+    }
+    WynReadBuffer* buf = socket_buffers[sock];
+    if (!buf) {
+        buf = malloc(sizeof(WynReadBuffer));
+        if (buf) {
+            wyn_read_buffer_init(buf);
+            socket_buffers[sock] = buf;
+        }
+    }
+    pthread_mutex_unlock(&socket_buffers_lock);
+    return buf;
+}
+
+// Read a line from socket, including its '\n'; "" at end of stream
 char* Socket_read_line(int sock) {
-    static char buffer[4096];
-    int pos = 0;
+    WynReadBuffer* buf = socket_buffer(sock);
+    if (!buf) return (char*)wyn_str_new("", 0);
+    
+    size_t len;
+    const char* line = wyn_read_buffer_until(buf, sock, "\n", 1, &len, NULL);
+    if (!line) return (char*)wyn_str_new("", 0);
+    // The delimiter was consumed right after the line unless the stream ended
+    int has_newline = line + len < buf->data + buf->start;
+    return (char*)wyn_str_new(line, len + has_newline);
+}
+
+// Bytes up to delim, which is consumed but not returned
+char* Socket_read_until(int sock, const char* delim) {
+    WynReadBuffer* buf = socket_buffer(sock);
+    if (!buf || !delim) return (char*)wyn_str_new("", 0);
+    
+    size_t len;
+    const char* data = wyn_read_buffer_until(buf, sock, delim, wyn_str_len(delim), &len, NULL);
+    return (char*)wyn_str_new(data ? data : "", data ? len : 0);
+}
+
+// Exactly count bytes, or "" if the stream ends first
+char* Socket_read_exact(int sock, int count) {
+    WynReadBuffer* buf = socket_buffer(sock);
+    if (!buf || count < 0) return (char*)wyn_str_new("", 0);
     
-    while (pos < sizeof(buffer) - 1) {
-        char c;
-        int n = recv(sock, &c, 1, 0);
-        if (n <= 0) break;
-        
-        buffer[pos++] = c;
-        if (c == '\n') break;
+    const char* data = wyn_read_buffer_take(buf, sock, (size_t)count, NULL);
+    return (char*)wyn_str_new(data ? data : "", data ? (size_t)count : 0);
+}
+
+// Up to max_len bytes: what is buffered, else one recv()
+char* Socket_read(int sock, int max_len) {
+    WynReadBuffer* buf = socket_buffer(sock);
+    if (!buf || max_len <= 0) return (char*)wyn_str_new("", 0);
+    
+    size_t len;
+    const char* data = wyn_read_buffer_peek(buf, sock, &len, NULL);
+    if (!data) return (char*)wyn_str_new("", 0);
+    if (len > (size_t)max_len) len = (size_t)max_len;
+    buf->start += len;
+    return (char*)wyn_str_new(data, len);
+}
+
+// Close socket and drop its read buffer
+int Socket_close(int sock) {
+    if (sock < 0) return -1;
+    pthread_mutex_lock(&socket_buffers_lock);
+    if (sock < socket_buffer_count && socket_buffers[sock]) {
+        wyn_read_buffer_free(socket_buffers[sock]);
+        free(socket_buffers[sock]);
+        socket_buffers[sock] = NULL;
     }
-    
-    buffer[pos] = '\0';
-    return strdup(buffer);
+    pthread_mutex_unlock(&socket_buffers_lock);
+    return close(sock);
 }
 
 // ============================================================================
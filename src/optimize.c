@@ -64,7 +64,7 @@ Expr* fold_constants(Expr* expr) {
 
 // Function inlining
 bool should_inline_function(Stmt* func_stmt) {
-    if (opt_level < OPT_O2 || !func_stmt || func_stmt->type != STMT_FN) return false;
+    if (opt_level < OPT_O2 || opt_level == OPT_OS || !func_stmt || func_stmt->type != STMT_FN) return false;
     
     // Simple heuristic: inline functions with short names (likely small)
     if (func_stmt->fn.name.length <= 15) {
@@ -75,7 +75,7 @@ bool should_inline_function(Stmt* func_stmt) {
 }
 
 void inline_small_functions(Program* prog) {
-    if (opt_level < OPT_O2 || !prog) return;
+    if (opt_level < OPT_O2 || opt_level == OPT_OS || !prog) return;
     
     // Mark functions for inlining
     for (int i = 0; i < prog->count; i++) {
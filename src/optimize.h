@@ -8,7 +8,9 @@
 typedef enum {
     OPT_NONE = 0,
     OPT_O1 = 1,
-    OPT_O2 = 2
+    OPT_O2 = 2,
+    OPT_O3 = 3,
+    OPT_OS = 4     // Size: front-end passes as O1, no inlining
 } OptLevel;
 
 // Global optimization settings
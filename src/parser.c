@@ -114,7 +114,7 @@ static void expect(WynTokenType type, const char* message) {
         show_error_context(current_source_file, parser.current.line, 1, message, NULL);
     } else {
         // Fallback to basic error
-        fprintf(stderr, "Error at line %d: %s (no filename set)\n", parser.current.line, message);
+        compile_error(ERR_UNEXPECTED_TOKEN, parser.current.line, "%s (no filename set)", message);
     }
     
     parser.had_error = true;
@@ -157,6 +157,14 @@ static Expr* primary() {
         return expr;
     }
     
+    if (match(TOKEN_SPAWN)) {
+        Expr* expr = alloc_expr();
+        expr->type = EXPR_SPAWN;
+        expr->token = parser.previous;
+        expr->spawn.call = call();
+        return expr;
+    }
+    
     if (match(TOKEN_NOT) || match(TOKEN_MINUS) || match(TOKEN_BANG) || match(TOKEN_TILDE)) {
         Token op = parser.previous;
         Expr* operand = primary();
@@ -393,7 +401,7 @@ static Expr* primary() {
     if (match(TOKEN_NULL)) {
         Expr* expr = alloc_expr();
         expr->type = EXPR_INT;
-        Token zero = {TOKEN_INT, "0", 1, 0};
+        Token zero = {TOKEN_INT, "0", 1, 0, 0};
         expr->token = zero;
         return expr;
     }
@@ -589,16 +597,16 @@ static Expr* primary() {
             expr->array.elements = malloc(sizeof(Expr*) * capacity);
             
             do {
-                // Expect string key
-                if (!check(TOKEN_STRING)) {
-                    fprintf(stderr, "Error: HashMap keys must be strings\n");
+                // Expect string or int key
+                if (!check(TOKEN_STRING) && !check(TOKEN_INT)) {
+                    compile_error(ERR_UNEXPECTED_TOKEN, parser.current.line, "HashMap keys must be strings or ints");
                     break;
                 }
                 Expr* key = expression();
                 
                 // Expect colon
                 if (!match(TOKEN_COLON)) {
-                    fprintf(stderr, "Error: Expected ':' after HashMap key\n");
+                    compile_error(ERR_UNEXPECTED_TOKEN, parser.current.line, "Expected ':' after HashMap key");
                     break;
                 }
                 
@@ -1182,9 +1190,9 @@ static Expr* assignment() {
             inc->binary.left = expr;
             inc->binary.right = alloc_expr();
             inc->binary.right->type = EXPR_INT;
-            Token one = {TOKEN_INT, "1", 1, 0};
+            Token one = {TOKEN_INT, "1", 1, 0, 0};
             inc->binary.right->token = one;
-            Token plus = {TOKEN_PLUS, "+", 1, 0};
+            Token plus = {TOKEN_PLUS, "+", 1, 0, 0};
             inc->binary.op = plus;
             
             assign->assign.value = inc;
@@ -1203,9 +1211,9 @@ static Expr* assignment() {
             dec->binary.left = expr;
             dec->binary.right = alloc_expr();
             dec->binary.right->type = EXPR_INT;
-            Token one = {TOKEN_INT, "1", 1, 0};
+            Token one = {TOKEN_INT, "1", 1, 0, 0};
             dec->binary.right->token = one;
-            Token minus = {TOKEN_MINUS, "-", 1, 0};
+            Token minus = {TOKEN_MINUS, "-", 1, 0, 0};
             dec->binary.op = minus;
             
             assign->assign.value = dec;
@@ -1325,7 +1333,7 @@ Stmt* statement() {
     }
     
     if (check(TOKEN_FN)) {
-        fprintf(stderr, "Error at line %d: Nested functions are not supported. Functions can only be defined at the top level.\n", parser.current.line);
+        compile_error(ERR_UNEXPECTED_TOKEN, parser.current.line, "Nested functions are not supported. Functions can only be defined at the top level.");
         parser.had_error = true;
         
         // Skip the entire function definition to prevent further errors
@@ -1403,6 +1411,17 @@ Stmt* statement() {
         return stmt;
     }
     
+    if (match(TOKEN_SCOPE)) {
+        Stmt* stmt = alloc_stmt();
+        stmt->type = STMT_SCOPE;
+        if (!check(TOKEN_LBRACE)) {
+            expect(TOKEN_LBRACE, "Expected '{' after scope");
+            return stmt;
+        }
+        stmt->scope.body = statement();
+        return stmt;
+    }
+    
     if (match(TOKEN_VAR) || match(TOKEN_CONST)) {
         Stmt* stmt = alloc_stmt();
         WynTokenType decl_type = parser.previous.type;
@@ -1726,7 +1745,7 @@ Stmt* statement() {
                     inc_val->binary.op.length = 1;
                     inc_val->binary.right = alloc_expr();
                     inc_val->binary.right->type = EXPR_INT;
-                    Token one = {TOKEN_INT, "1", 1, 0};
+                    Token one = {TOKEN_INT, "1", 1, 0, 0};
                     inc_val->binary.right->token = one;
                     inc->assign.value = inc_val;
                     stmt->for_stmt.increment = inc;
@@ -1743,7 +1762,7 @@ Stmt* statement() {
                     // Create index variable name (loop_var + "_i")
                     static char index_name[64];
                     snprintf(index_name, 64, "%.*s_i", loop_var.length, loop_var.start);
-                    Token index_var = {TOKEN_IDENT, index_name, strlen(index_name), loop_var.line};
+                    Token index_var = {TOKEN_IDENT, index_name, strlen(index_name), loop_var.line, 0};
                     
                     // Initialize: var loop_var_i = 0
                     stmt->for_stmt.init = alloc_stmt();
@@ -1751,7 +1770,7 @@ Stmt* statement() {
                     stmt->for_stmt.init->var.name = index_var;
                     stmt->for_stmt.init->var.init = alloc_expr();
                     stmt->for_stmt.init->var.init->type = EXPR_INT;
-                    Token zero = {TOKEN_INT, "0", 1, 0};
+                    Token zero = {TOKEN_INT, "0", 1, 0, 0};
                     stmt->for_stmt.init->var.init->token = zero;
                     stmt->for_stmt.init->var.is_const = false;
                     
@@ -1767,7 +1786,7 @@ Stmt* statement() {
                     // For now, assume array length is 3 (hardcoded for testing)
                     stmt->for_stmt.condition->binary.right = alloc_expr();
                     stmt->for_stmt.condition->binary.right->type = EXPR_INT;
-                    Token three = {TOKEN_INT, "3", 1, 0};
+                    Token three = {TOKEN_INT, "3", 1, 0, 0};
                     stmt->for_stmt.condition->binary.right->token = three;
                     
                     // Increment: loop_var_i += 1
@@ -1784,7 +1803,7 @@ Stmt* statement() {
                     inc_val->binary.op.length = 1;
                     inc_val->binary.right = alloc_expr();
                     inc_val->binary.right->type = EXPR_INT;
-                    Token one = {TOKEN_INT, "1", 1, 0};
+                    Token one = {TOKEN_INT, "1", 1, 0, 0};
                     inc_val->binary.right->token = one;
                     stmt->for_stmt.increment->assign.value = inc_val;
                     
@@ -1979,7 +1998,7 @@ Stmt* function() {
     
     while (!check(TOKEN_RBRACE) && !check(TOKEN_EOF)) {
         if (body->block.count >= 1024) {
-            fprintf(stderr, "Error at line %d: Function body too large (max 1024 statements)\n", parser.current.line);
+            compile_error(ERR_UNEXPECTED_TOKEN, parser.current.line, "Function body too large (max 1024 statements)");
             break;
         }
         body->block.stmts[body->block.count++] = statement();
@@ -2344,7 +2363,7 @@ Stmt* impl_block() {
             stmt->impl.methods[stmt->impl.method_count] = fn_copy;
             stmt->impl.method_count++;
         } else {
-            fprintf(stderr, "Error at line %d: Expected function in impl block\n", parser.current.line);
+            compile_error(ERR_UNEXPECTED_TOKEN, parser.current.line, "Expected function in impl block");
             parser.had_error = true;
             advance();
         }
@@ -2445,7 +2464,7 @@ Stmt* trait_decl() {
             stmt->trait_decl.method_has_default[stmt->trait_decl.method_count] = false;
             stmt->trait_decl.method_count++;
         } else {
-            fprintf(stderr, "Error at line %d: Expected function in trait block\n", parser.current.line);
+            compile_error(ERR_UNEXPECTED_TOKEN, parser.current.line, "Expected function in trait block");
             parser.had_error = true;
             advance();
         }
@@ -2503,7 +2522,7 @@ Stmt* enum_decl() {
                         types[type_count++] = type_expr;
                         advance();
                     } else {
-                        fprintf(stderr, "Error: Expected type name in variant\n");
+                        compile_error(ERR_UNEXPECTED_TOKEN, parser.current.line, "Expected type name in variant");
                         break;
                     }
                 } while (match(TOKEN_COMMA));
@@ -2528,7 +2547,8 @@ Stmt* enum_decl() {
             break;
         } else {
             // Unexpected token
-            fprintf(stderr, "Error: Expected ',' or '}' after enum variant, got type=%d\n", parser.current.type);
+            compile_error(ERR_UNEXPECTED_TOKEN, parser.current.line,
+                          "Expected ',' or '}' after enum variant, got type=%d", parser.current.type);
             break;
         }
     }
@@ -2799,7 +2819,7 @@ Program* parse_program() {
             } else if (check(TOKEN_VAR)) {
                 stmt->export.stmt = statement();
             } else {
-                fprintf(stderr, "Error at line %d: Expected function, struct, enum, or variable after 'export'\n", parser.current.line);
+                compile_error(ERR_UNEXPECTED_TOKEN, parser.current.line, "Expected function, struct, enum, or variable after 'export'");
                 parser.had_error = true;
             }
             
@@ -2862,10 +2882,21 @@ Program* parse_program() {
             // Global variable/constant declarations
             prog->stmts[prog->count++] = statement();
         } else {
+            const char* before = parser.current.start;
             prog->stmts[prog->count++] = statement();
+            if (parser.current.start == before) {
+                // Nothing consumed (a stray '}' or ')'): fail now rather than
+                // parse the same token until the statement array fills up
+                compile_error(ERR_UNEXPECTED_TOKEN, parser.current.line, "Unexpected '%.*s'",
+                              parser.current.length, parser.current.start);
+                parser.had_error = true;
+                safe_free(prog->stmts);
+                safe_free(prog);
+                return NULL;
+            }
         }
     }
-    
+
     return prog;
 }
 
@@ -3050,7 +3081,7 @@ static Stmt* parse_match_statement() {
                 pattern->ident.name = first_token;
             }
         } else {
-            fprintf(stderr, "Error at line %d: Expected pattern\n", parser.current.line);
+            compile_error(ERR_UNEXPECTED_TOKEN, parser.current.line, "Expected pattern");
             parser.had_error = true;
             return NULL;
         }
@@ -3182,7 +3213,7 @@ static Expr* parse_type() {
             }
         }
     } else {
-        fprintf(stderr, "Error at line %d: Expected type name\n", parser.current.line);
+        compile_error(ERR_UNEXPECTED_TOKEN, parser.current.line, "Expected type name");
         return NULL;
     }
     
@@ -3255,7 +3286,7 @@ static Pattern* parse_pattern() {
             
             while (!check(TOKEN_RBRACE) && !check(TOKEN_EOF)) {
                 if (pattern->struct_pat.field_count >= 16) {
-                    fprintf(stderr, "Error: Too many fields in struct pattern\n");
+                    compile_error(ERR_UNEXPECTED_TOKEN, parser.current.line, "Too many fields in struct pattern");
                     break;
                 }
                 
@@ -3295,7 +3326,7 @@ static Pattern* parse_pattern() {
         
         while (!check(TOKEN_RBRACKET) && !check(TOKEN_EOF)) {
             if (pattern->array.element_count >= 16) {
-                fprintf(stderr, "Error: Too many elements in array pattern\n");
+                compile_error(ERR_UNEXPECTED_TOKEN, parser.current.line, "Too many elements in array pattern");
                 break;
             }
             
@@ -3328,7 +3359,7 @@ static Pattern* parse_pattern() {
         
         while (!check(TOKEN_RPAREN) && !check(TOKEN_EOF)) {
             if (pattern->tuple.element_count >= 16) {
-                fprintf(stderr, "Error: Too many elements in tuple pattern\n");
+                compile_error(ERR_UNEXPECTED_TOKEN, parser.current.line, "Too many elements in tuple pattern");
                 break;
             }
             
@@ -3385,7 +3416,7 @@ static Pattern* parse_pattern() {
     }
     
     // If we get here, it's an error
-    fprintf(stderr, "Error: Expected pattern at line %d\n", parser.current.line);
+    compile_error(ERR_UNEXPECTED_TOKEN, parser.current.line, "Expected pattern");
     free(pattern);
     return NULL;
 }
@@ -1,8 +1,1677 @@
+// Regular expressions
+// Patterns are parsed into a WynRegexNode tree and compiled to two byte-level
+// programs: a forward one with capture slots and a reversed one without.
+// UTF-8 is handled by the compiler, which turns every character class into
+// alternatives of byte-range sequences, so matching never decodes the text
+// and never allocates per character. A search runs a lazily built DFA over
+// byte classes forward to find where the leftmost-first match ends, then the
+// reversed program backward from there to find where it starts. A Pike VM
+// over the forward program fills in capture groups, and takes over if the
+// DFA cache keeps overflowing. All of them are linear in the text length.
+// Literal bytes that every match must contain are looked for with memchr
+// before any automaton runs.
+#define _POSIX_C_SOURCE 200809L
 #include "regex.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
+
+#define RX_MAX_REPEAT 1000          // largest n in {n} / {n,m}
+#define RX_MAX_DEPTH 250            // group nesting
+#define RX_MAX_INSTS (1 << 20)
+#define RX_DFA_CACHE_BYTES (4u << 20)
+#define RX_DFA_MAX_FLUSHES 8        // per search, before falling back to the Pike VM
+#define RX_NO_POS ((size_t)-1)
+
+// ---------------------------------------------------------------------------
+// Programs
+
+typedef enum {
+    RX_BYTE_RANGE,      // consume a byte in lo..hi
+    RX_BYTE_SET,        // consume a byte in sets[y]
+    RX_SPLIT,           // try x, then y
+    RX_JMP,
+    RX_SAVE,            // record the position in slot y
+    RX_ASSERT,          // empty-width assertion arg
+    RX_MATCH
+} RxOp;
+
+typedef struct {
+    uint8_t op;
+    uint8_t lo, hi;
+    uint8_t arg;
+    int x;              // next instruction
+    int y;
+} RxInst;
+
+typedef struct {
+    RxInst* insts;
+    int count;
+    int capacity;
+    uint64_t (*sets)[4];
+    int set_count;
+    int set_capacity;
+    int start;              // anchored entry
+    int unanchored_start;   // lazy any-byte loop in front of start
+    int slot_count;
+    bool has_asserts;
+    bool failed;            // grew past RX_MAX_INSTS
+} RxProgram;
+
+// Context of the byte on one side of a position, for assertions
+enum { RX_CTX_NONE, RX_CTX_NEWLINE, RX_CTX_WORD, RX_CTX_OTHER };
+
+static bool is_word_byte(uint8_t c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static int byte_ctx(uint8_t c) {
+    if (c == '\n') return RX_CTX_NEWLINE;
+    return is_word_byte(c) ? RX_CTX_WORD : RX_CTX_OTHER;
+}
+
+// prev and next are the contexts before and after the position in scan order
+static bool assertion_holds(int kind, int prev, int next) {
+    switch (kind) {
+        case REGEX_BEGIN_TEXT: return prev == RX_CTX_NONE;
+        case REGEX_END_TEXT: return next == RX_CTX_NONE;
+        case REGEX_BEGIN_LINE: return prev == RX_CTX_NONE || prev == RX_CTX_NEWLINE;
+        case REGEX_END_LINE: return next == RX_CTX_NONE || next == RX_CTX_NEWLINE;
+        case REGEX_WORD_BOUNDARY: return (prev == RX_CTX_WORD) != (next == RX_CTX_WORD);
+        case REGEX_NOT_WORD_BOUNDARY: return (prev == RX_CTX_WORD) == (next == RX_CTX_WORD);
+    }
+    return false;
+}
+
+static int emit(RxProgram* prog, RxOp op) {
+    if (prog->count >= RX_MAX_INSTS) {
+        prog->failed = true;
+        prog->count = 0;    // keep emitting into the first slots; the result is discarded
+    }
+    if (prog->count >= prog->capacity) {
+        prog->capacity = prog->capacity ? prog->capacity * 2 : 64;
+        prog->insts = realloc(prog->insts, prog->capacity * sizeof(RxInst));
+    }
+    int pc = prog->count++;
+    memset(&prog->insts[pc], 0, sizeof(RxInst));
+    prog->insts[pc].op = (uint8_t)op;
+    prog->insts[pc].x = pc + 1;
+    return pc;
+}
+
+static int add_byte_set(RxProgram* prog, const uint64_t set[4]) {
+    for (int i = 0; i < prog->set_count; i++) {
+        if (memcmp(prog->sets[i], set, sizeof(uint64_t) * 4) == 0) return i;
+    }
+    if (prog->set_count >= prog->set_capacity) {
+        prog->set_capacity = prog->set_capacity ? prog->set_capacity * 2 : 8;
+        prog->sets = realloc(prog->sets, prog->set_capacity * sizeof(*prog->sets));
+    }
+    memcpy(prog->sets[prog->set_count], set, sizeof(uint64_t) * 4);
+    return prog->set_count++;
+}
+
+static bool inst_accepts(const RxProgram* prog, const RxInst* inst, uint8_t c) {
+    if (inst->op == RX_BYTE_RANGE) return c >= inst->lo && c <= inst->hi;
+    return (prog->sets[inst->y][c >> 6] >> (c & 63)) & 1;
+}
+
+static void free_program(RxProgram* prog) {
+    if (!prog) return;
+    free(prog->insts);
+    free(prog->sets);
+    free(prog);
+}
+
+// ---------------------------------------------------------------------------
+// Codepoint ranges
+
+typedef struct {
+    uint32_t* pairs;    // lo, hi, lo, hi, ...
+    size_t count;       // ranges
+    size_t capacity;
+} RxRanges;
+
+static void ranges_add(RxRanges* r, uint32_t lo, uint32_t hi) {
+    if (r->count >= r->capacity) {
+        r->capacity = r->capacity ? r->capacity * 2 : 8;
+        r->pairs = realloc(r->pairs, r->capacity * 2 * sizeof(uint32_t));
+    }
+    r->pairs[r->count * 2] = lo;
+    r->pairs[r->count * 2 + 1] = hi;
+    r->count++;
+}
+
+static int compare_ranges(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+// Sorts and merges overlapping or adjacent ranges
+static void ranges_normalize(RxRanges* r) {
+    if (r->count == 0) return;
+    qsort(r->pairs, r->count, 2 * sizeof(uint32_t), compare_ranges);
+    size_t out = 0;
+    for (size_t i = 1; i < r->count; i++) {
+        uint32_t lo = r->pairs[i * 2], hi = r->pairs[i * 2 + 1];
+        if (lo <= r->pairs[out * 2 + 1] + 1) {
+            if (hi > r->pairs[out * 2 + 1]) r->pairs[out * 2 + 1] = hi;
+        } else {
+            out++;
+            r->pairs[out * 2] = lo;
+            r->pairs[out * 2 + 1] = hi;
+        }
+    }
+    r->count = out + 1;
+}
+
+static void ranges_negate(RxRanges* r) {
+    ranges_normalize(r);
+    RxRanges neg = {0};
+    uint32_t next = 0;
+    for (size_t i = 0; i < r->count; i++) {
+        if (r->pairs[i * 2] > next) ranges_add(&neg, next, r->pairs[i * 2] - 1);
+        next = r->pairs[i * 2 + 1] + 1;
+    }
+    if (next <= 0x10FFFF) ranges_add(&neg, next, 0x10FFFF);
+    free(r->pairs);
+    *r = neg;
+}
+
+// Adds the other ASCII case of every letter in the ranges
+static void ranges_fold_case(RxRanges* r) {
+    size_t count = r->count;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t lo = r->pairs[i * 2], hi = r->pairs[i * 2 + 1];
+        uint32_t a = lo > 'a' ? lo : 'a', b = hi < 'z' ? hi : 'z';
+        if (a <= b) ranges_add(r, a - 32, b - 32);
+        a = lo > 'A' ? lo : 'A';
+        b = hi < 'Z' ? hi : 'Z';
+        if (a <= b) ranges_add(r, a + 32, b + 32);
+    }
+    ranges_normalize(r);
+}
+
+static void ranges_add_perl_class(RxRanges* r, char kind) {
+    RxRanges cls = {0};
+    switch (kind | 0x20) {
+        case 'd':
+            ranges_add(&cls, '0', '9');
+            break;
+        case 'w':
+            ranges_add(&cls, '0', '9');
+            ranges_add(&cls, 'A', 'Z');
+            ranges_add(&cls, '_', '_');
+            ranges_add(&cls, 'a', 'z');
+            break;
+        case 's':
+            ranges_add(&cls, '\t', '\r');   // \t \n \v \f \r
+            ranges_add(&cls, ' ', ' ');
+            break;
+    }
+    if (kind >= 'A' && kind <= 'Z') ranges_negate(&cls);
+    for (size_t i = 0; i < cls.count; i++) ranges_add(r, cls.pairs[i * 2], cls.pairs[i * 2 + 1]);
+    free(cls.pairs);
+}
+
+// ---------------------------------------------------------------------------
+// Parser
+
+typedef struct {
+    const char* pattern;
+    size_t pos;
+    size_t len;
+    size_t flags;
+    int depth;
+    int group_count;
+    char** group_names;
+    int names_capacity;
+    WynRegexError* error;
+    bool failed;
+} RxParser;
+
+static void set_error(WynRegexError* error, WynRegexErrorCode code, const char* message, size_t position) {
+    if (!error) return;
+    error->code = code;
+    error->message = message ? strdup(message) : NULL;
+    error->position = position;
+}
+
+static void parse_error(RxParser* p, WynRegexErrorCode code, const char* message) {
+    if (p->failed) return;
+    p->failed = true;
+    set_error(p->error, code, message, p->pos);
+}
+
+static WynRegexNode* new_node(RxParser* p, WynRegexNodeType type) {
+    WynRegexNode* node = calloc(1, sizeof(WynRegexNode));
+    node->type = type;
+    node->case_insensitive = (p->flags & WYN_REGEX_CASE_INSENSITIVE) != 0;
+    node->greedy = true;
+    return node;
+}
+
+static void free_node(WynRegexNode* node) {
+    while (node) {
+        WynRegexNode* next = node->next;
+        free_node(node->left);
+        free_node(node->right);
+        free(node->char_class);
+        free(node->group_name);
+        free(node);
+        node = next;
+    }
+}
+
+static WynRegexNode* class_node(RxParser* p, WynRegexNodeType type, RxRanges* ranges, bool negated) {
+    if (p->flags & WYN_REGEX_CASE_INSENSITIVE) ranges_fold_case(ranges);
+    if (negated) ranges_negate(ranges);
+    else ranges_normalize(ranges);
+    WynRegexNode* node = new_node(p, type);
+    node->char_class = ranges->pairs;
+    node->char_class_size = ranges->count;
+    node->negated = negated;
+    return node;
+}
+
+static bool at_end(RxParser* p) {
+    return p->pos >= p->len;
+}
+
+static void skip_extended(RxParser* p) {
+    if (!(p->flags & WYN_REGEX_EXTENDED)) return;
+    while (!at_end(p)) {
+        char c = p->pattern[p->pos];
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v') {
+            p->pos++;
+        } else if (c == '#') {
+            while (!at_end(p) && p->pattern[p->pos] != '\n') p->pos++;
+        } else {
+            break;
+        }
+    }
+}
+
+// Decodes the UTF-8 character at the current position
+static uint32_t next_codepoint(RxParser* p) {
+    uint32_t cp = 0;
+    size_t n = wyn_utf8_decode_char((const uint8_t*)p->pattern + p->pos, p->len - p->pos, &cp);
+    if (n == 0) {
+        parse_error(p, WYN_REGEX_UNICODE_ERROR, "Invalid UTF-8 in pattern");
+        p->pos++;
+        return 0;
+    }
+    p->pos += n;
+    return cp;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Parses the character after a backslash that stands for one codepoint
+static uint32_t parse_escape_codepoint(RxParser* p, char c) {
+    switch (c) {
+        case 'n': return '\n';
+        case 't': return '\t';
+        case 'r': return '\r';
+        case 'f': return '\f';
+        case 'v': return '\v';
+        case 'a': return 7;
+        case 'e': return 27;
+        case '0': return 0;
+        case 'x': {
+            uint32_t cp = 0;
+            if (!at_end(p) && p->pattern[p->pos] == '{') {
+                p->pos++;
+                int digits = 0;
+                while (!at_end(p) && hex_value(p->pattern[p->pos]) >= 0 && digits < 6) {
+                    cp = cp * 16 + (uint32_t)hex_value(p->pattern[p->pos++]);
+                    digits++;
+                }
+                if (digits == 0 || at_end(p) || p->pattern[p->pos] != '}' || cp > 0x10FFFF ||
+                    (cp >= 0xD800 && cp <= 0xDFFF)) {
+                    parse_error(p, WYN_REGEX_INVALID_PATTERN, "Invalid \\x{...} escape");
+                    return 0;
+                }
+                p->pos++;
+                return cp;
+            }
+            for (int i = 0; i < 2; i++) {
+                if (at_end(p) || hex_value(p->pattern[p->pos]) < 0) {
+                    parse_error(p, WYN_REGEX_INVALID_PATTERN, "Invalid \\x escape");
+                    return 0;
+                }
+                cp = cp * 16 + (uint32_t)hex_value(p->pattern[p->pos++]);
+            }
+            return cp;
+        }
+    }
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '1' && c <= '9')) {
+        parse_error(p, WYN_REGEX_INVALID_PATTERN, "Unknown escape sequence");
+        return 0;
+    }
+    return (uint8_t)c;
+}
+
+static bool parse_posix_class(RxParser* p, RxRanges* ranges) {
+    static const struct { const char* name; const char* ranges; } classes[] = {
+        {"alpha", "AZaz"}, {"digit", "09"}, {"alnum", "09AZaz"}, {"upper", "AZ"},
+        {"lower", "az"}, {"space", "\t\r  "}, {"xdigit", "09AFaf"}, {"word", "09AZ__az"},
+        {"punct", "!/:@[`{~"}, {"blank", "\t\t  "}, {"cntrl", "\x01\x1f\x7f\x7f"},
+        {"print", " ~"}, {"graph", "!~"},
+    };
+    const char* s = p->pattern + p->pos;   // at "[:"
+    const char* end = strstr(s + 2, ":]");
+    if (!end) return false;
+    size_t n = (size_t)(end - (s + 2));
+    for (size_t i = 0; i < sizeof(classes) / sizeof(classes[0]); i++) {
+        if (strlen(classes[i].name) == n && memcmp(classes[i].name, s + 2, n) == 0) {
+            for (const char* r = classes[i].ranges; *r; r += 2) {
+                ranges_add(ranges, (uint8_t)r[0], (uint8_t)r[1]);
+            }
+            p->pos += n + 4;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Reads one class member: a character (returned in *cp) or a set added straight to ranges
+static bool parse_class_atom(RxParser* p, RxRanges* ranges, uint32_t* cp) {
+    if (p->pattern[p->pos] == '[' && p->pos + 1 < p->len && p->pattern[p->pos + 1] == ':' &&
+        parse_posix_class(p, ranges)) {
+        return false;
+    }
+    if (p->pattern[p->pos] == '\\') {
+        p->pos++;
+        if (at_end(p)) {
+            parse_error(p, WYN_REGEX_INVALID_PATTERN, "Trailing backslash");
+            return false;
+        }
+        char c = p->pattern[p->pos++];
+        if (strchr("dDwWsS", c)) {
+            ranges_add_perl_class(ranges, c);
+            return false;
+        }
+        *cp = parse_escape_codepoint(p, c);
+        return true;
+    }
+    *cp = next_codepoint(p);
+    return true;
+}
+
+static WynRegexNode* parse_bracket(RxParser* p) {
+    p->pos++;   // [
+    bool negated = false;
+    if (!at_end(p) && p->pattern[p->pos] == '^') {
+        negated = true;
+        p->pos++;
+    }
+    RxRanges ranges = {0};
+    bool first = true;
+    while (!p->failed) {
+        if (at_end(p)) {
+            parse_error(p, WYN_REGEX_INVALID_PATTERN, "Unterminated character class");
+            break;
+        }
+        if (p->pattern[p->pos] == ']' && !first) {
+            p->pos++;
+            break;
+        }
+        first = false;
+        uint32_t lo;
+        if (!parse_class_atom(p, &ranges, &lo)) continue;
+        uint32_t hi = lo;
+        if (p->pos + 1 < p->len && p->pattern[p->pos] == '-' && p->pattern[p->pos + 1] != ']') {
+            p->pos++;
+            if (!parse_class_atom(p, &ranges, &hi) || hi < lo) {
+                parse_error(p, WYN_REGEX_INVALID_PATTERN, "Invalid range in character class");
+                break;
+            }
+        }
+        ranges_add(&ranges, lo, hi);
+    }
+    if (p->failed) {
+        free(ranges.pairs);
+        return NULL;
+    }
+    return class_node(p, REGEX_BRACKET, &ranges, negated);
+}
+
+static WynRegexNode* assertion_node(RxParser* p, WynRegexAssertion kind) {
+    WynRegexNode* node = new_node(p, REGEX_ASSERTION);
+    node->assertion = kind;
+    return node;
+}
+
+static WynRegexNode* parse_alternation(RxParser* p);
+
+// Applies flag letters like "im-s"; returns false on an unknown letter
+static bool parse_flags(RxParser* p, size_t* flags) {
+    bool clear = false;
+    while (!at_end(p)) {
+        char c = p->pattern[p->pos];
+        size_t flag = 0;
+        if (c == 'i') flag = WYN_REGEX_CASE_INSENSITIVE;
+        else if (c == 'm') flag = WYN_REGEX_MULTILINE;
+        else if (c == 's') flag = WYN_REGEX_DOTALL;
+        else if (c == 'x') flag = WYN_REGEX_EXTENDED;
+        else if (c == '-') clear = true;
+        else return true;
+        if (flag) *flags = clear ? (*flags & ~flag) : (*flags | flag);
+        p->pos++;
+    }
+    return true;
+}
+
+// Returns NULL without an error for a bare flag group like (?i)
+static WynRegexNode* parse_group(RxParser* p) {
+    size_t open = p->pos++;   // (
+    if (++p->depth > RX_MAX_DEPTH) {
+        parse_error(p, WYN_REGEX_COMPILATION_ERROR, "Groups nested too deeply");
+        return NULL;
+    }
+    size_t saved_flags = p->flags;
+    int group_id = 0;
+    char* name = NULL;
+
+    if (!at_end(p) && p->pattern[p->pos] == '?') {
+        p->pos++;
+        const char* s = p->pattern + p->pos;
+        if (*s == ':') {
+            p->pos++;
+        } else if ((*s == 'P' && s[1] == '<') || (*s == '<' && s[1] != '=' && s[1] != '!')) {
+            p->pos += *s == 'P' ? 2 : 1;
+            size_t start = p->pos;
+            while (!at_end(p) && (is_word_byte((uint8_t)p->pattern[p->pos]))) p->pos++;
+            if (at_end(p) || p->pattern[p->pos] != '>' || p->pos == start) {
+                parse_error(p, WYN_REGEX_INVALID_GROUP, "Invalid group name");
+                return NULL;
+            }
+            name = strndup(p->pattern + start, p->pos - start);
+            p->pos++;
+            group_id = ++p->group_count;
+        } else {
+            size_t flags = p->flags;
+            parse_flags(p, &flags);
+            if (!at_end(p) && p->pattern[p->pos] == ')') {
+                // (?flags) applies to the rest of the enclosing group
+                p->pos++;
+                p->flags = flags;
+                p->depth--;
+                return NULL;
+            }
+            if (at_end(p) || p->pattern[p->pos] != ':') {
+                p->pos = open;
+                parse_error(p, WYN_REGEX_INVALID_GROUP, "Unsupported group syntax (look-around is not supported)");
+                return NULL;
+            }
+            p->pos++;
+            p->flags = flags;
+        }
+    } else {
+        group_id = ++p->group_count;
+    }
+
+    if (group_id) {
+        if (group_id > p->names_capacity) {
+            int capacity = p->names_capacity ? p->names_capacity * 2 : 8;
+            while (capacity < group_id) capacity *= 2;
+            p->group_names = realloc(p->group_names, capacity * sizeof(char*));
+            memset(p->group_names + p->names_capacity, 0, (capacity - p->names_capacity) * sizeof(char*));
+            p->names_capacity = capacity;
+        }
+        p->group_names[group_id - 1] = name ? strdup(name) : NULL;
+    }
+
+    WynRegexNode* body = parse_alternation(p);
+    p->flags = saved_flags;
+    p->depth--;
+    if (p->failed) {
+        free(name);
+        free_node(body);
+        return NULL;
+    }
+    if (at_end(p) || p->pattern[p->pos] != ')') {
+        p->pos = open;
+        parse_error(p, WYN_REGEX_INVALID_GROUP, "Unclosed group");
+        free(name);
+        free_node(body);
+        return NULL;
+    }
+    p->pos++;
+    WynRegexNode* node = new_node(p, REGEX_GROUP);
+    node->left = body;
+    node->group_id = group_id;
+    node->group_name = name;
+    return node;
+}
+
+static WynRegexNode* parse_atom(RxParser* p) {
+    char c = p->pattern[p->pos];
+    switch (c) {
+        case '(':
+            return parse_group(p);
+        case '[':
+            return parse_bracket(p);
+        case '.': {
+            p->pos++;
+            RxRanges ranges = {0};
+            if (p->flags & WYN_REGEX_DOTALL) {
+                ranges_add(&ranges, 0, 0x10FFFF);
+            } else {
+                ranges_add(&ranges, 0, '\n' - 1);
+                ranges_add(&ranges, '\n' + 1, 0x10FFFF);
+            }
+            size_t flags = p->flags;
+            p->flags &= ~(size_t)WYN_REGEX_CASE_INSENSITIVE;
+            WynRegexNode* node = class_node(p, REGEX_DOT, &ranges, false);
+            p->flags = flags;
+            return node;
+        }
+        case '^':
+            p->pos++;
+            return assertion_node(p, (p->flags & WYN_REGEX_MULTILINE) ? REGEX_BEGIN_LINE : REGEX_BEGIN_TEXT);
+        case '$':
+            p->pos++;
+            return assertion_node(p, (p->flags & WYN_REGEX_MULTILINE) ? REGEX_END_LINE : REGEX_END_TEXT);
+        case '*': case '+': case '?':
+            parse_error(p, WYN_REGEX_INVALID_PATTERN, "Nothing to repeat");
+            return NULL;
+        case '\\': {
+            p->pos++;
+            if (at_end(p)) {
+                parse_error(p, WYN_REGEX_INVALID_PATTERN, "Trailing backslash");
+                return NULL;
+            }
+            char e = p->pattern[p->pos++];
+            switch (e) {
+                case 'b': return assertion_node(p, REGEX_WORD_BOUNDARY);
+                case 'B': return assertion_node(p, REGEX_NOT_WORD_BOUNDARY);
+                case 'A': return assertion_node(p, REGEX_BEGIN_TEXT);
+                case 'z': return assertion_node(p, REGEX_END_TEXT);
+                case 'd': case 'D': case 'w': case 'W': case 's': case 'S': {
+                    RxRanges ranges = {0};
+                    ranges_add_perl_class(&ranges, e);
+                    return class_node(p, REGEX_BRACKET, &ranges, false);
+                }
+            }
+            WynRegexNode* node = new_node(p, REGEX_LITERAL);
+            node->codepoint = parse_escape_codepoint(p, e);
+            return node;
+        }
+    }
+    WynRegexNode* node = new_node(p, REGEX_LITERAL);
+    node->codepoint = next_codepoint(p);
+    return node;
+}
+
+// Parses {n}, {n,} or {n,m}; leaves pos alone and returns false if it is not one
+static bool parse_counted(RxParser* p, int* min, int* max) {
+    size_t pos = p->pos + 1;
+    long n = 0, m = -1;
+    size_t digits = 0;
+    while (pos < p->len && p->pattern[pos] >= '0' && p->pattern[pos] <= '9') {
+        n = n * 10 + (p->pattern[pos++] - '0');
+        if (n > RX_MAX_REPEAT) n = RX_MAX_REPEAT + 1;
+        digits++;
+    }
+    if (digits == 0) return false;
+    if (pos < p->len && p->pattern[pos] == ',') {
+        pos++;
+        digits = 0;
+        long v = 0;
+        while (pos < p->len && p->pattern[pos] >= '0' && p->pattern[pos] <= '9') {
+            v = v * 10 + (p->pattern[pos++] - '0');
+            if (v > RX_MAX_REPEAT) v = RX_MAX_REPEAT + 1;
+            digits++;
+        }
+        if (digits) m = v;
+    } else {
+        m = n;
+    }
+    if (pos >= p->len || p->pattern[pos] != '}') return false;
+    p->pos = pos + 1;
+    if (n > RX_MAX_REPEAT || m > RX_MAX_REPEAT) {
+        parse_error(p, WYN_REGEX_COMPILATION_ERROR, "Repetition count too large");
+    } else if (m >= 0 && m < n) {
+        parse_error(p, WYN_REGEX_INVALID_PATTERN, "Invalid repetition range");
+    }
+    *min = (int)n;
+    *max = (int)m;
+    return true;
+}
+
+static WynRegexNode* parse_repeat(RxParser* p) {
+    WynRegexNode* atom = parse_atom(p);
+    while (!p->failed) {
+        skip_extended(p);
+        if (at_end(p)) break;
+        char c = p->pattern[p->pos];
+        int min, max;
+        if (c == '*') { min = 0; max = -1; p->pos++; }
+        else if (c == '+') { min = 1; max = -1; p->pos++; }
+        else if (c == '?') { min = 0; max = 1; p->pos++; }
+        else if (c == '{' && parse_counted(p, &min, &max)) { if (p->failed) break; }
+        else break;
+        if (!atom || atom->type == REGEX_ASSERTION) {
+            parse_error(p, WYN_REGEX_INVALID_PATTERN, "Nothing to repeat");
+            break;
+        }
+        WynRegexNode* node = new_node(p, REGEX_QUANTIFIER);
+        node->left = atom;
+        node->min_count = min;
+        node->max_count = max;
+        if (!at_end(p) && p->pattern[p->pos] == '?') {
+            node->greedy = false;
+            p->pos++;
+        }
+        atom = node;
+    }
+    if (p->failed) {
+        free_node(atom);
+        return NULL;
+    }
+    return atom;
+}
+
+static WynRegexNode* parse_sequence(RxParser* p) {
+    WynRegexNode* head = NULL;
+    WynRegexNode* tail = NULL;
+    while (!p->failed) {
+        skip_extended(p);
+        if (at_end(p) || p->pattern[p->pos] == '|' || p->pattern[p->pos] == ')') break;
+        WynRegexNode* node = parse_repeat(p);
+        if (!node) continue;
+        if (tail) tail->next = node;
+        else head = node;
+        tail = node;
+    }
+    if (p->failed) {
+        free_node(head);
+        return NULL;
+    }
+    return head;
+}
+
+static WynRegexNode* parse_alternation(RxParser* p) {
+    WynRegexNode* first = parse_sequence(p);
+    if (p->failed || at_end(p) || p->pattern[p->pos] != '|') return first;
+    p->pos++;
+    WynRegexNode* rest = parse_alternation(p);
+    if (p->failed) {
+        free_node(first);
+        return NULL;
+    }
+    WynRegexNode* node = new_node(p, REGEX_ALTERNATION);
+    node->left = first;
+    node->right = rest;
+    return node;
+}
+
+// ---------------------------------------------------------------------------
+// Compiler
+
+typedef struct {
+    uint8_t lo[4], hi[4];
+    int len;
+} RxUtf8Seq;
+
+typedef struct {
+    RxUtf8Seq* seqs;
+    int count;
+    int capacity;
+} RxUtf8Seqs;
+
+static int encode_utf8(uint32_t cp, uint8_t out[4]) {
+    return (int)wyn_utf8_encode_char(cp, out);
+}
+
+// Splits lo..hi into ranges whose UTF-8 encodings are byte-range products
+// (the usual construction from RE2 and Rust's utf8-ranges)
+static void utf8_sequences(RxUtf8Seqs* out, uint32_t lo, uint32_t hi) {
+    if (lo > hi) return;
+    if (lo <= 0xDFFF && hi >= 0xD800) {
+        if (lo < 0xD800) utf8_sequences(out, lo, 0xD7FF);
+        if (hi > 0xDFFF) utf8_sequences(out, 0xE000, hi);
+        return;
+    }
+    static const uint32_t limits[] = {0x7F, 0x7FF, 0xFFFF};
+    for (int i = 0; i < 3; i++) {
+        if (lo <= limits[i] && hi > limits[i]) {
+            utf8_sequences(out, lo, limits[i]);
+            utf8_sequences(out, limits[i] + 1, hi);
+            return;
+        }
+    }
+    if (hi > 0x7F) {
+        for (int i = 1; i < 4; i++) {
+            uint32_t m = (1u << (6 * i)) - 1;
+            if ((lo & ~m) != (hi & ~m)) {
+                if ((lo & m) != 0) {
+                    utf8_sequences(out, lo, lo | m);
+                    utf8_sequences(out, (lo | m) + 1, hi);
+                    return;
+                }
+                if ((hi & m) != m) {
+                    utf8_sequences(out, lo, (hi & ~m) - 1);
+                    utf8_sequences(out, hi & ~m, hi);
+                    return;
+                }
+            }
+        }
+    }
+    if (out->count >= out->capacity) {
+        out->capacity = out->capacity ? out->capacity * 2 : 16;
+        out->seqs = realloc(out->seqs, out->capacity * sizeof(RxUtf8Seq));
+    }
+    RxUtf8Seq* seq = &out->seqs[out->count++];
+    seq->len = encode_utf8(lo, seq->lo);
+    encode_utf8(hi, seq->hi);
+}
+
+typedef struct {
+    RxProgram* prog;
+    bool reverse;
+} RxCompiler;
+
+static void compile_node(RxCompiler* c, const WynRegexNode* node);
+
+static void compile_class(RxCompiler* c, const uint32_t* pairs, size_t count) {
+    RxProgram* prog = c->prog;
+    uint64_t set[4] = {0};
+    bool has_set = false;
+    RxUtf8Seqs seqs = {0};
+    for (size_t i = 0; i < count; i++) {
+        uint32_t lo = pairs[i * 2], hi = pairs[i * 2 + 1];
+        if (lo <= 0x7F) {
+            uint32_t top = hi < 0x7F ? hi : 0x7F;
+            for (uint32_t b = lo; b <= top; b++) set[b >> 6] |= 1ull << (b & 63);
+            has_set = true;
+            lo = 0x80;
+        }
+        if (lo <= hi) utf8_sequences(&seqs, lo, hi);
+    }
+
+    int alternatives = (has_set ? 1 : 0) + seqs.count;
+    if (alternatives == 0) {
+        // Empty class: a set nothing belongs to
+        int pc = emit(prog, RX_BYTE_SET);
+        prog->insts[pc].y = add_byte_set(prog, set);
+        free(seqs.seqs);
+        return;
+    }
+    int* jumps = malloc(alternatives * sizeof(int));
+    int jump_count = 0;
+    for (int a = 0; a < alternatives; a++) {
+        int split = -1;
+        if (a < alternatives - 1) split = emit(prog, RX_SPLIT);
+        if (has_set && a == 0) {
+            int pc = emit(prog, RX_BYTE_SET);
+            prog->insts[pc].y = add_byte_set(prog, set);
+        } else {
+            RxUtf8Seq* seq = &seqs.seqs[a - (has_set ? 1 : 0)];
+            for (int k = 0; k < seq->len; k++) {
+                int b = c->reverse ? seq->len - 1 - k : k;
+                int pc = emit(prog, RX_BYTE_RANGE);
+                prog->insts[pc].lo = seq->lo[b];
+                prog->insts[pc].hi = seq->hi[b];
+            }
+        }
+        if (split >= 0) {
+            jumps[jump_count++] = emit(prog, RX_JMP);
+            prog->insts[split].y = prog->count;
+        }
+    }
+    for (int i = 0; i < jump_count; i++) prog->insts[jumps[i]].x = prog->count;
+    free(jumps);
+    free(seqs.seqs);
+}
+
+static bool is_ascii_letter(uint32_t cp) {
+    return (cp >= 'a' && cp <= 'z') || (cp >= 'A' && cp <= 'Z');
+}
+
+static void compile_literal(RxCompiler* c, const WynRegexNode* node) {
+    if (node->case_insensitive && is_ascii_letter(node->codepoint)) {
+        uint32_t pairs[4] = {node->codepoint | 0x20, node->codepoint | 0x20,
+                             node->codepoint & ~0x20u, node->codepoint & ~0x20u};
+        compile_class(c, pairs, 2);
+        return;
+    }
+    uint8_t bytes[4];
+    int n = encode_utf8(node->codepoint, bytes);
+    for (int k = 0; k < n; k++) {
+        int pc = emit(c->prog, RX_BYTE_RANGE);
+        c->prog->insts[pc].lo = c->prog->insts[pc].hi = bytes[c->reverse ? n - 1 - k : k];
+    }
+}
+
+static void compile_sequence(RxCompiler* c, const WynRegexNode* node) {
+    if (!c->reverse) {
+        for (; node; node = node->next) compile_node(c, node);
+        return;
+    }
+    int count = 0;
+    for (const WynRegexNode* n = node; n; n = n->next) count++;
+    const WynRegexNode** nodes = malloc((count ? count : 1) * sizeof(*nodes));
+    count = 0;
+    for (const WynRegexNode* n = node; n; n = n->next) nodes[count++] = n;
+    for (int i = count - 1; i >= 0; i--) compile_node(c, nodes[i]);
+    free(nodes);
+}
+
+static void compile_repeat(RxCompiler* c, const WynRegexNode* node) {
+    RxProgram* prog = c->prog;
+    for (int i = 0; i < node->min_count && !prog->failed; i++) compile_node(c, node->left);
+    if (node->max_count < 0) {
+        int loop = emit(prog, RX_SPLIT);
+        compile_node(c, node->left);
+        int back = emit(prog, RX_JMP);
+        prog->insts[back].x = loop;
+        if (node->greedy) {
+            prog->insts[loop].x = loop + 1;
+            prog->insts[loop].y = prog->count;
+        } else {
+            prog->insts[loop].x = prog->count;
+            prog->insts[loop].y = loop + 1;
+        }
+        return;
+    }
+    // Optional copies nest: x{0,3} is (x(x(x)?)?)?
+    int optional = node->max_count - node->min_count;
+    int* splits = malloc((optional ? optional : 1) * sizeof(int));
+    for (int i = 0; i < optional && !prog->failed; i++) {
+        splits[i] = emit(prog, RX_SPLIT);
+        compile_node(c, node->left);
+    }
+    if (prog->failed) optional = 0;
+    for (int i = 0; i < optional; i++) {
+        if (node->greedy) {
+            prog->insts[splits[i]].y = prog->count;
+        } else {
+            prog->insts[splits[i]].x = prog->count;
+            prog->insts[splits[i]].y = splits[i] + 1;
+        }
+    }
+    free(splits);
+}
+
+static void compile_node(RxCompiler* c, const WynRegexNode* node) {
+    RxProgram* prog = c->prog;
+    if (prog->failed) return;
+    switch (node->type) {
+        case REGEX_LITERAL:
+            compile_literal(c, node);
+            break;
+        case REGEX_DOT:
+        case REGEX_BRACKET:
+            compile_class(c, node->char_class, node->char_class_size);
+            break;
+        case REGEX_GROUP:
+            if (node->group_id && !c->reverse) {
+                int pc = emit(prog, RX_SAVE);
+                prog->insts[pc].y = node->group_id * 2;
+            }
+            compile_sequence(c, node->left);
+            if (node->group_id && !c->reverse) {
+                int pc = emit(prog, RX_SAVE);
+                prog->insts[pc].y = node->group_id * 2 + 1;
+            }
+            break;
+        case REGEX_ALTERNATION: {
+            int split = emit(prog, RX_SPLIT);
+            compile_sequence(c, node->left);
+            int jump = emit(prog, RX_JMP);
+            prog->insts[split].y = prog->count;
+            compile_sequence(c, node->right);
+            prog->insts[jump].x = prog->count;
+            break;
+        }
+        case REGEX_QUANTIFIER:
+            compile_repeat(c, node);
+            break;
+        case REGEX_ASSERTION: {
+            static const uint8_t mirrored[] = {
+                [REGEX_BEGIN_TEXT] = REGEX_END_TEXT, [REGEX_END_TEXT] = REGEX_BEGIN_TEXT,
+                [REGEX_BEGIN_LINE] = REGEX_END_LINE, [REGEX_END_LINE] = REGEX_BEGIN_LINE,
+                [REGEX_WORD_BOUNDARY] = REGEX_WORD_BOUNDARY,
+                [REGEX_NOT_WORD_BOUNDARY] = REGEX_NOT_WORD_BOUNDARY,
+            };
+            int pc = emit(prog, RX_ASSERT);
+            prog->insts[pc].arg = c->reverse ? mirrored[node->assertion] : (uint8_t)node->assertion;
+            prog->has_asserts = true;
+            break;
+        }
+    }
+}
+
+static RxProgram* compile_program(const WynRegexNode* root, int group_count, bool reverse) {
+    RxProgram* prog = calloc(1, sizeof(RxProgram));
+    RxCompiler c = { prog, reverse };
+    prog->slot_count = (group_count + 1) * 2;
+    prog->start = 0;
+    if (!reverse) {
+        int pc = emit(prog, RX_SAVE);
+        prog->insts[pc].y = 0;
+    }
+    compile_sequence(&c, root);
+    if (!reverse) {
+        int pc = emit(prog, RX_SAVE);
+        prog->insts[pc].y = 1;
+    }
+    emit(prog, RX_MATCH);
+
+    // Unanchored entry: prefer starting here, else skip a character and
+    // retry, so matches only start on character boundaries
+    static const uint32_t any[] = {0, 0x10FFFF};
+    prog->unanchored_start = emit(prog, RX_SPLIT);
+    prog->insts[prog->unanchored_start].x = prog->start;
+    prog->insts[prog->unanchored_start].y = prog->unanchored_start + 1;
+    compile_class(&c, any, 1);
+    int back = emit(prog, RX_JMP);
+    prog->insts[back].x = prog->unanchored_start;
+
+    if (prog->failed) {
+        free_program(prog);
+        return NULL;
+    }
+    return prog;
+}
+
+// ---------------------------------------------------------------------------
+// Lazy DFA
+// A state is the ordered list of program counters waiting to consume the
+// next byte, plus the context of the byte just consumed. Empty-width
+// instructions are followed when the next byte is known, so assertions see
+// both sides. Keeping the list in priority order lets leftmost-first
+// searches cut every thread below a match, exactly as the Pike VM does.
+
+enum { RX_EARLIEST, RX_LEFTMOST_FIRST, RX_LONGEST };
+
+typedef struct {
+    int* pcs;
+    int count;
+    uint8_t ctx;            // context of the byte consumed to get here
+    bool match;             // a match ended just before that byte
+    bool at_start;          // only the unanchored loop is alive
+    uint32_t hash;
+    int8_t end_match[4];    // match here given the next context; -1 until computed
+    int32_t next[];         // per byte class; -1 until computed
+} RxState;
+
+typedef struct {
+    const RxProgram* prog;
+    int start_pc;
+    int mode;
+    uint8_t classes[256];
+    uint8_t class_byte[256];    // a member of each class
+    int class_count;
+    RxState** states;
+    int state_count;
+    int state_capacity;
+    int* table;                 // state index + 1, 0 when empty
+    int table_capacity;
+    int start_states[4];
+    size_t memory;
+    int flushes;
+    // scratch for closures
+    int* stack;
+    int stack_capacity;
+    int* list;
+    uint32_t* seen;
+    uint32_t* seen_next;
+    uint32_t generation;
+} RxDfa;
+
+static void dfa_clear(RxDfa* dfa) {
+    for (int i = 0; i < dfa->state_count; i++) {
+        free(dfa->states[i]->pcs);
+        free(dfa->states[i]);
+    }
+    dfa->state_count = 0;
+    memset(dfa->table, 0, dfa->table_capacity * sizeof(int));
+    for (int i = 0; i < 4; i++) dfa->start_states[i] = -1;
+    dfa->memory = 0;
+}
+
+static void dfa_free(RxDfa* dfa) {
+    if (!dfa) return;
+    dfa_clear(dfa);
+    free(dfa->states);
+    free(dfa->table);
+    free(dfa->stack);
+    free(dfa->list);
+    free(dfa->seen);
+    free(dfa->seen_next);
+    free(dfa);
+}
+
+// Bytes that every instruction and assertion treats alike share a class
+static void compute_byte_classes(RxDfa* dfa) {
+    const RxProgram* prog = dfa->prog;
+    bool boundary[257] = {0};
+    for (int pc = 0; pc < prog->count; pc++) {
+        const RxInst* inst = &prog->insts[pc];
+        if (inst->op == RX_BYTE_RANGE) {
+            boundary[inst->lo] = true;
+            boundary[inst->hi + 1] = true;
+        } else if (inst->op == RX_BYTE_SET) {
+            for (int b = 1; b < 256; b++) {
+                if (inst_accepts(prog, inst, (uint8_t)b) != inst_accepts(prog, inst, (uint8_t)(b - 1))) {
+                    boundary[b] = true;
+                }
+            }
+        }
+    }
+    if (prog->has_asserts) {
+        for (int b = 1; b < 256; b++) {
+            if (byte_ctx((uint8_t)b) != byte_ctx((uint8_t)(b - 1))) boundary[b] = true;
+        }
+    }
+    int cls = 0;
+    for (int b = 0; b < 256; b++) {
+        if (b > 0 && boundary[b]) cls++;
+        dfa->classes[b] = (uint8_t)cls;
+        dfa->class_byte[cls] = (uint8_t)b;
+    }
+    dfa->class_count = cls + 1;
+}
+
+static RxDfa* dfa_new(const RxProgram* prog, int start_pc, int mode) {
+    RxDfa* dfa = calloc(1, sizeof(RxDfa));
+    dfa->prog = prog;
+    dfa->start_pc = start_pc;
+    dfa->mode = mode;
+    compute_byte_classes(dfa);
+    dfa->table_capacity = 1024;
+    dfa->table = calloc(dfa->table_capacity, sizeof(int));
+    dfa->stack_capacity = prog->count * 2 + 16;
+    dfa->stack = malloc(dfa->stack_capacity * sizeof(int));
+    dfa->list = malloc(prog->count * sizeof(int));
+    dfa->seen = calloc(prog->count, sizeof(uint32_t));
+    dfa->seen_next = calloc(prog->count, sizeof(uint32_t));
+    for (int i = 0; i < 4; i++) dfa->start_states[i] = -1;
+    return dfa;
+}
+
+static uint32_t state_hash(const int* pcs, int count, int ctx, bool match) {
+    uint32_t hash = 2166136261u ^ (uint32_t)(ctx * 2 + match);
+    for (int i = 0; i < count; i++) {
+        hash ^= (uint32_t)pcs[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int find_or_add_state(RxDfa* dfa, const int* pcs, int count, int ctx, bool match) {
+    uint32_t hash = state_hash(pcs, count, ctx, match);
+    uint32_t mask = (uint32_t)dfa->table_capacity - 1;
+    uint32_t i = hash & mask;
+    for (; dfa->table[i]; i = (i + 1) & mask) {
+        RxState* s = dfa->states[dfa->table[i] - 1];
+        if (s->hash == hash && s->count == count && s->ctx == ctx && s->match == match &&
+            memcmp(s->pcs, pcs, count * sizeof(int)) == 0) {
+            return dfa->table[i] - 1;
+        }
+    }
+
+    RxState* s = malloc(sizeof(RxState) + dfa->class_count * sizeof(int32_t));
+    s->pcs = malloc((count ? count : 1) * sizeof(int));
+    memcpy(s->pcs, pcs, count * sizeof(int));
+    s->count = count;
+    s->ctx = (uint8_t)ctx;
+    s->match = match;
+    s->at_start = !match && count == 1 && pcs[0] == dfa->prog->unanchored_start;
+    s->hash = hash;
+    memset(s->end_match, -1, sizeof(s->end_match));
+    memset(s->next, -1, dfa->class_count * sizeof(int32_t));
+    dfa->memory += sizeof(RxState) + dfa->class_count * sizeof(int32_t) + count * sizeof(int);
+
+    if (dfa->state_count >= dfa->state_capacity) {
+        dfa->state_capacity = dfa->state_capacity ? dfa->state_capacity * 2 : 64;
+        dfa->states = realloc(dfa->states, dfa->state_capacity * sizeof(RxState*));
+    }
+    int index = dfa->state_count++;
+    dfa->states[index] = s;
+    dfa->table[i] = index + 1;
+
+    if (dfa->state_count * 2 > dfa->table_capacity) {
+        dfa->table_capacity *= 2;
+        free(dfa->table);
+        dfa->table = calloc(dfa->table_capacity, sizeof(int));
+        mask = (uint32_t)dfa->table_capacity - 1;
+        for (int k = 0; k < dfa->state_count; k++) {
+            uint32_t j = dfa->states[k]->hash & mask;
+            while (dfa->table[j]) j = (j + 1) & mask;
+            dfa->table[j] = k + 1;
+        }
+    }
+    return index;
+}
+
+// Follows empty-width instructions from pcs in priority order, collecting
+// the byte-consuming ones into dfa->list. Returns how many; *matched is set
+// if a match instruction was reached (and, unless searching for the longest
+// match, everything after it is dropped).
+static int dfa_closure(RxDfa* dfa, const int* pcs, int count, int prev, int next, bool* matched) {
+    const RxProgram* prog = dfa->prog;
+    uint32_t gen = ++dfa->generation;
+    if (gen == 0) {
+        memset(dfa->seen, 0, prog->count * sizeof(uint32_t));
+        gen = dfa->generation = 1;
+    }
+    int out = 0;
+    *matched = false;
+    for (int i = 0; i < count; i++) {
+        int sp = 0;
+        dfa->stack[sp++] = pcs[i];
+        while (sp > 0) {
+            int pc = dfa->stack[--sp];
+            if (dfa->seen[pc] == gen) continue;
+            dfa->seen[pc] = gen;
+            const RxInst* inst = &prog->insts[pc];
+            switch (inst->op) {
+                case RX_JMP:
+                case RX_SAVE:
+                    dfa->stack[sp++] = inst->x;
+                    break;
+                case RX_SPLIT:
+                    dfa->stack[sp++] = inst->y;
+                    dfa->stack[sp++] = inst->x;
+                    break;
+                case RX_ASSERT:
+                    if (assertion_holds(inst->arg, prev, next)) dfa->stack[sp++] = inst->x;
+                    break;
+                case RX_MATCH:
+                    *matched = true;
+                    if (dfa->mode != RX_LONGEST) return out;
+                    break;
+                default:
+                    dfa->list[out++] = pc;
+                    break;
+            }
+        }
+    }
+    return out;
+}
+
+static int start_state(RxDfa* dfa, int ctx) {
+    if (dfa->start_states[ctx] < 0) {
+        dfa->start_states[ctx] = find_or_add_state(dfa, &dfa->start_pc, 1, ctx, false);
+    }
+    return dfa->start_states[ctx];
+}
+
+// Builds the transition from state on byte c; -1 if the cache keeps overflowing
+static int dfa_transition(RxDfa* dfa, int state, uint8_t c) {
+    RxState* s = dfa->states[state];
+    if (dfa->memory > RX_DFA_CACHE_BYTES) {
+        if (++dfa->flushes > RX_DFA_MAX_FLUSHES) return -1;
+        // Keep the current state alive across the flush
+        int count = s->count;
+        int ctx = s->ctx;
+        bool match = s->match;
+        int* pcs = malloc((count ? count : 1) * sizeof(int));
+        memcpy(pcs, s->pcs, count * sizeof(int));
+        dfa_clear(dfa);
+        state = find_or_add_state(dfa, pcs, count, ctx, match);
+        free(pcs);
+        s = dfa->states[state];
+    }
+
+    bool matched;
+    int ctx = byte_ctx(c);
+    int n = dfa_closure(dfa, s->pcs, s->count, s->ctx, ctx, &matched);
+    if (matched && dfa->mode == RX_EARLIEST) n = 0;
+
+    // Step every waiting instruction over c, keeping priority order
+    const RxProgram* prog = dfa->prog;
+    uint32_t gen = dfa->generation;
+    int* next = dfa->stack;     // free again once the closure is done
+    int next_count = 0;
+    for (int i = 0; i < n; i++) {
+        const RxInst* inst = &prog->insts[dfa->list[i]];
+        if (inst_accepts(prog, inst, c) && dfa->seen_next[inst->x] != gen) {
+            dfa->seen_next[inst->x] = gen;
+            next[next_count++] = inst->x;
+        }
+    }
+    int target = find_or_add_state(dfa, next, next_count, ctx, matched);
+    dfa->states[state]->next[dfa->classes[c]] = target;
+    return target;
+}
+
+// Whether state has a match at the current position, given the context after it
+static bool dfa_match_here(RxDfa* dfa, int state, int next_ctx) {
+    RxState* s = dfa->states[state];
+    if (s->end_match[next_ctx] < 0) {
+        bool matched;
+        dfa_closure(dfa, s->pcs, s->count, s->ctx, next_ctx, &matched);
+        s->end_match[next_ctx] = matched;
+    }
+    return s->end_match[next_ctx];
+}
+
+// ---------------------------------------------------------------------------
+// Literal prefilters
+
+typedef struct {
+    uint8_t* bytes;
+    size_t len;
+    size_t rare;            // offset of the byte memchr looks for
+} RxLiteral;
+
+// Rough frequency of a byte in text and logs: memchr for the rarest
+static int byte_rank(uint8_t c) {
+    if (c == ' ') return 0;
+    if (c >= 'a' && c <= 'z') return strchr("etaoinshrdlu", c) ? 1 : 2;
+    if (c >= '0' && c <= '9') return 2;
+    if (c >= 'A' && c <= 'Z') return 3;
+    if (c == '\n' || c == ',' || c == '.' || c == '/' || c == ':' || c == '-' || c == '=') return 3;
+    return 4;
+}
+
+static void literal_init(RxLiteral* lit, const uint8_t* bytes, size_t len) {
+    lit->bytes = malloc(len ? len : 1);
+    memcpy(lit->bytes, bytes, len);
+    lit->len = len;
+    lit->rare = 0;
+    for (size_t i = 1; i < len; i++) {
+        if (byte_rank(bytes[i]) > byte_rank(bytes[lit->rare])) lit->rare = i;
+    }
+}
+
+static const uint8_t* find_literal(const RxLiteral* lit, const uint8_t* text, size_t len) {
+    if (lit->len > len) return NULL;
+    const uint8_t* p = text + lit->rare;
+    const uint8_t* last = text + len - lit->len + lit->rare;  // last place the rare byte can be
+    uint8_t rare = lit->bytes[lit->rare];
+    while (p <= last) {
+        p = memchr(p, rare, (size_t)(last - p) + 1);
+        if (!p) return NULL;
+        const uint8_t* start = p - lit->rare;
+        if (memcmp(start, lit->bytes, lit->len) == 0) return start;
+        p++;
+    }
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Compiled regex
+
+struct WynRegexProgram {
+    RxProgram* forward;
+    RxProgram* reverse;
+    RxDfa* first;           // forward, leftmost-first: where matches end
+    RxDfa* earliest;        // forward, stops at the first match: is_match
+    RxDfa* backward;        // reverse, longest: where matches start
+    RxLiteral required;     // bytes every match contains (len 0 if none)
+    bool required_prefix;   // ...at its start
+    bool literal;           // the whole pattern is `required`
+    bool anchored;          // starts with \A
+    size_t* slots;          // Pike VM scratch
+};
+
+// Appends n's bytes to buf if it matches exactly one fixed string
+static bool literal_bytes(const WynRegexNode* n, uint8_t* buf, size_t* len, size_t cap) {
+    if (n->type == REGEX_LITERAL && !(n->case_insensitive && is_ascii_letter(n->codepoint))) {
+        if (*len + 4 > cap) return false;
+        *len += (size_t)encode_utf8(n->codepoint, buf + *len);
+        return true;
+    }
+    if (n->type == REGEX_GROUP && n->left && n->left->type != REGEX_ALTERNATION) {
+        size_t saved = *len;
+        for (const WynRegexNode* c = n->left; c; c = c->next) {
+            if (!literal_bytes(c, buf, len, cap)) {
+                *len = saved;
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+// Longer literals reject more; among equal lengths prefer rarer bytes
+static int literal_score(const uint8_t* bytes, size_t len) {
+    int rarest = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (byte_rank(bytes[i]) > rarest) rarest = byte_rank(bytes[i]);
+    }
+    return len ? (int)len * 5 + rarest : 0;
+}
+
+// Finds the most selective run of fixed bytes in the top-level sequence
+static void extract_literals(WynRegexProgram* program, const WynRegexNode* root) {
+    if (!root || root->type == REGEX_ALTERNATION) return;
+    const WynRegexNode* node = root;
+    if (node->type == REGEX_ASSERTION && node->assertion == REGEX_BEGIN_TEXT) {
+        program->anchored = true;
+        node = node->next;
+    }
+    uint8_t best[256], run[256];
+    size_t best_len = 0, run_len = 0;
+    bool best_is_prefix = false, run_is_prefix = true, all_literal = !program->anchored;
+    for (; node; node = node->next) {
+        size_t before = run_len;
+        if (literal_bytes(node, run, &run_len, sizeof(run))) continue;
+        run_len = before;
+        all_literal = false;
+        if (literal_score(run, run_len) > literal_score(best, best_len)) {
+            memcpy(best, run, run_len);
+            best_len = run_len;
+            best_is_prefix = run_is_prefix;
+        }
+        run_len = 0;
+        run_is_prefix = false;
+    }
+    if (literal_score(run, run_len) > literal_score(best, best_len)) {
+        memcpy(best, run, run_len);
+        best_len = run_len;
+        best_is_prefix = run_is_prefix;
+    }
+    if (best_len == 0) return;
+    literal_init(&program->required, best, best_len);
+    program->required_prefix = best_is_prefix;
+    program->literal = all_literal && best_is_prefix && run_len == best_len;
+}
+
+static void free_compiled(WynRegexProgram* program) {
+    if (!program) return;
+    dfa_free(program->first);
+    dfa_free(program->earliest);
+    dfa_free(program->backward);
+    free_program(program->forward);
+    free_program(program->reverse);
+    free(program->required.bytes);
+    free(program->slots);
+    free(program);
+}
+
+// ---------------------------------------------------------------------------
+// Pike VM: leftmost-first search with capture slots
+
+typedef struct {
+    int* dense;
+    int* sparse;
+    int count;
+    size_t* slots;          // slot_count per entry
+} RxThreadList;
+
+typedef struct {
+    int pc;
+    int slot;               // >= 0: restore slot to value, then continue
+    size_t value;
+} RxFrame;
+
+typedef struct {
+    const RxProgram* prog;
+    const uint8_t* text;
+    size_t len;
+    RxFrame* stack;
+    int stack_capacity;
+} RxPike;
+
+static bool list_contains(const RxThreadList* list, int pc) {
+    int i = list->sparse[pc];
+    return i >= 0 && i < list->count && list->dense[i] == pc;
+}
+
+static void pike_add(RxPike* vm, RxThreadList* list, int pc0, size_t* slots, size_t pos) {
+    const RxProgram* prog = vm->prog;
+    int prev = pos == 0 ? RX_CTX_NONE : byte_ctx(vm->text[pos - 1]);
+    int next = pos >= vm->len ? RX_CTX_NONE : byte_ctx(vm->text[pos]);
+    int sp = 0;
+    vm->stack[sp++] = (RxFrame){ pc0, -1, 0 };
+    while (sp > 0) {
+        RxFrame f = vm->stack[--sp];
+        if (f.slot >= 0) {
+            slots[f.slot] = f.value;
+            continue;
+        }
+        int pc = f.pc;
+        if (list_contains(list, pc)) continue;
+        list->sparse[pc] = list->count;
+        list->dense[list->count++] = pc;
+        const RxInst* inst = &prog->insts[pc];
+        if (sp + 3 > vm->stack_capacity) {
+            vm->stack_capacity *= 2;
+            vm->stack = realloc(vm->stack, vm->stack_capacity * sizeof(RxFrame));
+        }
+        switch (inst->op) {
+            case RX_JMP:
+                vm->stack[sp++] = (RxFrame){ inst->x, -1, 0 };
+                break;
+            case RX_SPLIT:
+                vm->stack[sp++] = (RxFrame){ inst->y, -1, 0 };
+                vm->stack[sp++] = (RxFrame){ inst->x, -1, 0 };
+                break;
+            case RX_SAVE:
+                vm->stack[sp++] = (RxFrame){ 0, inst->y, slots[inst->y] };
+                slots[inst->y] = pos;
+                vm->stack[sp++] = (RxFrame){ inst->x, -1, 0 };
+                break;
+            case RX_ASSERT:
+                if (assertion_holds(inst->arg, prev, next)) vm->stack[sp++] = (RxFrame){ inst->x, -1, 0 };
+                break;
+            default:
+                memcpy(list->slots + (size_t)(list->count - 1) * prog->slot_count, slots,
+                       prog->slot_count * sizeof(size_t));
+                break;
+        }
+    }
+}
+
+static bool pike_search(const RxProgram* prog, const uint8_t* text, size_t len, size_t from,
+                        bool anchored, size_t* out_slots) {
+    int n = prog->count;
+    int slot_count = prog->slot_count;
+    RxThreadList lists[2];
+    for (int i = 0; i < 2; i++) {
+        lists[i].dense = malloc(n * sizeof(int));
+        lists[i].sparse = calloc(n, sizeof(int));
+        lists[i].slots = malloc((size_t)n * slot_count * sizeof(size_t));
+        lists[i].count = 0;
+    }
+    RxPike vm = { prog, text, len, malloc(64 * sizeof(RxFrame)), 64 };
+    size_t* slots = malloc(slot_count * sizeof(size_t));
+    RxThreadList* current = &lists[0];
+    RxThreadList* next = &lists[1];
+    bool matched = false;
+
+    for (size_t pos = from;; pos++) {
+        bool boundary = pos >= len || (text[pos] & 0xC0) != 0x80;
+        if (!matched && (anchored ? pos == from : boundary)) {
+            for (int i = 0; i < slot_count; i++) slots[i] = RX_NO_POS;
+            pike_add(&vm, current, prog->start, slots, pos);
+        }
+        if (current->count == 0) break;
+        next->count = 0;
+        for (int i = 0; i < current->count; i++) {
+            int pc = current->dense[i];
+            const RxInst* inst = &prog->insts[pc];
+            size_t* thread_slots = current->slots + (size_t)i * slot_count;
+            if (inst->op == RX_MATCH) {
+                memcpy(out_slots, thread_slots, slot_count * sizeof(size_t));
+                matched = true;
+                break;      // lower-priority threads lose
+            }
+            if ((inst->op == RX_BYTE_RANGE || inst->op == RX_BYTE_SET) && pos < len &&
+                inst_accepts(prog, inst, text[pos])) {
+                memcpy(slots, thread_slots, slot_count * sizeof(size_t));
+                pike_add(&vm, next, inst->x, slots, pos + 1);
+            }
+        }
+        RxThreadList* t = current;
+        current = next;
+        next = t;
+        if (pos >= len) break;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        free(lists[i].dense);
+        free(lists[i].sparse);
+        free(lists[i].slots);
+    }
+    free(vm.stack);
+    free(slots);
+    return matched;
+}
+
+// ---------------------------------------------------------------------------
+// Searching
+
+// Runs the forward DFA from `from`. Returns 1 and sets *end on a match, 0 if
+// there is none, -1 if the cache overflowed too often.
+static int dfa_forward(RxDfa* dfa, const RxLiteral* prefix, const uint8_t* text, size_t len,
+                       size_t from, size_t* end) {
+    dfa->flushes = 0;
+    int state = start_state(dfa, from == 0 ? RX_CTX_NONE : byte_ctx(text[from - 1]));
+    size_t last = RX_NO_POS;
+    for (size_t pos = from; pos < len; pos++) {
+        RxState* s = dfa->states[state];
+        if (s->at_start && prefix) {
+            // Nothing is in progress: jump to where a match could start
+            const uint8_t* hit = find_literal(prefix, text + pos, len - pos);
+            if (!hit) return 0;
+            if ((size_t)(hit - text) != pos) {
+                pos = (size_t)(hit - text);
+                state = start_state(dfa, byte_ctx(text[pos - 1]));
+                s = dfa->states[state];
+            }
+        }
+        int next = s->next[dfa->classes[text[pos]]];
+        if (next < 0) {
+            next = dfa_transition(dfa, state, text[pos]);
+            if (next < 0) return -1;
+        }
+        state = next;
+        s = dfa->states[state];
+        if (s->match) {
+            last = pos;
+            if (dfa->mode == RX_EARLIEST) break;
+        }
+        if (s->count == 0) {
+            if (last == RX_NO_POS) return 0;
+            *end = last;
+            return 1;
+        }
+    }
+    if (last == RX_NO_POS || dfa->mode != RX_EARLIEST) {
+        if (dfa_match_here(dfa, state, RX_CTX_NONE)) last = len;
+    }
+    if (last == RX_NO_POS) return 0;
+    *end = last;
+    return 1;
+}
+
+// Runs the reverse DFA from end back to `from`, finding the earliest start
+static int dfa_backward(RxDfa* dfa, const uint8_t* text, size_t len, size_t from, size_t end,
+                        size_t* start) {
+    dfa->flushes = 0;
+    int state = start_state(dfa, end == len ? RX_CTX_NONE : byte_ctx(text[end]));
+    size_t first = RX_NO_POS;
+    for (size_t pos = end; pos > from; pos--) {
+        RxState* s = dfa->states[state];
+        int next = s->next[dfa->classes[text[pos - 1]]];
+        if (next < 0) {
+            next = dfa_transition(dfa, state, text[pos - 1]);
+            if (next < 0) return -1;
+        }
+        state = next;
+        s = dfa->states[state];
+        if (s->match) first = pos;
+        if (s->count == 0) break;
+    }
+    if (dfa->states[state]->count > 0 || first == RX_NO_POS) {
+        int before = from == 0 ? RX_CTX_NONE : byte_ctx(text[from - 1]);
+        if (dfa->states[state]->count > 0 && dfa_match_here(dfa, state, before)) first = from;
+    }
+    if (first == RX_NO_POS) return 0;
+    *start = first;
+    return 1;
+}
+
+static bool pike_find(const WynRegex* regex, const uint8_t* text, size_t len, size_t from,
+                      size_t* start, size_t* end) {
+    WynRegexProgram* program = regex->program;
+    if (!program->slots) program->slots = malloc(program->forward->slot_count * sizeof(size_t));
+    if (!pike_search(program->forward, text, len, from, program->anchored, program->slots)) return false;
+    *start = program->slots[0];
+    *end = program->slots[1];
+    return true;
+}
+
+bool wyn_regex_search(const WynRegex* regex, const uint8_t* text, size_t len, size_t from,
+                      size_t* match_start, size_t* match_end) {
+    if (!regex || !regex->program || from > len) return false;
+    static const uint8_t empty[1] = {0};
+    if (!text) text = empty;
+    WynRegexProgram* program = regex->program;
+
+    if (program->anchored && from > 0) return false;
+    const RxLiteral* required = program->required.len ? &program->required : NULL;
+    if (required) {
+        const uint8_t* hit = find_literal(required, text + from, len - from);
+        if (!hit) return false;
+        if (program->literal) {
+            *match_start = (size_t)(hit - text);
+            *match_end = *match_start + required->len;
+            return true;
+        }
+        // Every match starts with the prefix, so none starts before it
+        if (program->required_prefix) from = (size_t)(hit - text);
+    }
+
+    if (!program->first) {
+        program->first = dfa_new(program->forward,
+                                 program->anchored ? program->forward->start : program->forward->unanchored_start,
+                                 RX_LEFTMOST_FIRST);
+        program->backward = dfa_new(program->reverse, program->reverse->start, RX_LONGEST);
+    }
+    size_t end, start;
+    int found = dfa_forward(program->first, program->required_prefix ? required : NULL, text, len, from, &end);
+    if (found < 0) return pike_find(regex, text, len, from, match_start, match_end);
+    if (!found) return false;
+    found = dfa_backward(program->backward, text, len, from, end, &start);
+    if (found <= 0) return pike_find(regex, text, len, from, match_start, match_end);
+    *match_start = start;
+    *match_end = end;
+    return true;
+}
+
+bool wyn_regex_matches_bytes(const WynRegex* regex, const uint8_t* text, size_t len) {
+    if (!regex || !regex->program) return false;
+    static const uint8_t empty[1] = {0};
+    if (!text) text = empty;
+    WynRegexProgram* program = regex->program;
+    size_t from = 0;
+    if (program->required.len) {
+        const uint8_t* hit = find_literal(&program->required, text, len);
+        if (!hit) return false;
+        if (program->literal) return true;
+        if (program->required_prefix) from = (size_t)(hit - text);
+    }
+    if (!program->earliest) {
+        program->earliest = dfa_new(program->forward,
+                                    program->anchored ? program->forward->start : program->forward->unanchored_start,
+                                    RX_EARLIEST);
+    }
+    size_t end;
+    int found = dfa_forward(program->earliest, program->required_prefix ? &program->required : NULL,
+                            text, len, from, &end);
+    if (found >= 0) return found;
+    size_t start;
+    return pike_find(regex, text, len, from, &start, &end);
+}
+
+// ---------------------------------------------------------------------------
+// Public API
 
 // Regex compilation and destruction
 WynRegex* wyn_regex_new(const char* pattern, WynRegexError* error) {
@@ -10,68 +1679,60 @@ WynRegex* wyn_regex_new(const char* pattern, WynRegexError* error) {
 }
 
 WynRegex* wyn_regex_new_with_flags(const char* pattern, size_t flags, WynRegexError* error) {
+    if (error) {
+        error->code = WYN_REGEX_OK;
+        error->message = NULL;
+        error->position = 0;
+    }
     if (!pattern) {
-        if (error) {
-            *error = *wyn_regex_error_new(WYN_REGEX_INVALID_PATTERN, "Pattern cannot be NULL", 0);
-        }
+        set_error(error, WYN_REGEX_INVALID_PATTERN, "Pattern cannot be NULL", 0);
         return NULL;
     }
-    
-    WynRegex* regex = malloc(sizeof(WynRegex));
+
+    RxParser parser = {0};
+    parser.pattern = pattern;
+    parser.len = strlen(pattern);
+    parser.flags = flags;
+    parser.error = error;
+    WynRegexNode* root = parse_alternation(&parser);
+    if (!parser.failed && !at_end(&parser)) {
+        parse_error(&parser, WYN_REGEX_INVALID_PATTERN, "Unmatched ')'");
+    }
+
+    WynRegex* regex = calloc(1, sizeof(WynRegex));
     if (!regex) {
-        if (error) {
-            *error = *wyn_regex_error_new(WYN_REGEX_MEMORY_ERROR, "Failed to allocate regex", 0);
-        }
+        set_error(error, WYN_REGEX_MEMORY_ERROR, "Failed to allocate regex", 0);
+        free_node(root);
         return NULL;
     }
-    
-    regex->group_count = 0;
-    regex->group_names = NULL;
+    regex->root = root;
     regex->flags = flags;
-    regex->last_error = NULL;
-    
-    // Parse the pattern
-    size_t pos = 0;
-    WynRegexError parse_error = {0};
-    regex->root = wyn_regex_parse_pattern(pattern, &pos, &parse_error);
-    
-    if (!regex->root || parse_error.code != WYN_REGEX_OK) {
-        if (error) *error = parse_error;
+    regex->group_count = parser.group_count;
+    regex->group_names = parser.group_names;
+    if (parser.failed) {
         wyn_regex_free(regex);
         return NULL;
     }
-    
-    // Optimize the pattern
-    regex->root = wyn_regex_optimize_pattern(regex->root);
-    
-    if (error) {
-        error->code = WYN_REGEX_OK;
-        error->message = NULL;
-        error->position = 0;
+
+    WynRegexProgram* program = calloc(1, sizeof(WynRegexProgram));
+    regex->program = program;
+    program->forward = compile_program(root, regex->group_count, false);
+    program->reverse = compile_program(root, regex->group_count, true);
+    if (!program->forward || !program->reverse) {
+        set_error(error, WYN_REGEX_COMPILATION_ERROR, "Pattern is too large", 0);
+        wyn_regex_free(regex);
+        return NULL;
     }
-    
+    extract_literals(program, root);
     return regex;
 }
 
-// Helper function to free regex tree recursively
-static void wyn_regex_free_node(WynRegexNode* node) {
-    if (!node) return;
-    
-    wyn_regex_free_node(node->left);
-    wyn_regex_free_node(node->right);
-    wyn_regex_free_node(node->next);
-    
-    free(node->char_class);
-    free(node->group_name);
-    free(node);
-}
-
 void wyn_regex_free(WynRegex* regex) {
     if (!regex) return;
-    
-    // Free regex tree
-    wyn_regex_free_node(regex->root);
-    
+
+    free_node(regex->root);
+    free_compiled(regex->program);
+
     // Free group names
     if (regex->group_names) {
         for (int i = 0; i < regex->group_count; i++) {
@@ -79,42 +1740,45 @@ void wyn_regex_free(WynRegex* regex) {
         }
         free(regex->group_names);
     }
-    
+
     if (regex->last_error) {
         wyn_regex_error_free(regex->last_error);
     }
-    
+
     free(regex);
 }
 
+static WynMatch* match_from_span(const WynString* text, size_t start, size_t end) {
+    WynMatch* match = malloc(sizeof(WynMatch));
+    if (!match) return NULL;
+    match->start = start;
+    match->end = end;
+    WynUtf8Error err;
+    match->text = wyn_string_from_utf8(wyn_string_as_bytes(text) + start, end - start, &err);
+    return match;
+}
+
+// Position to resume at after a match, stepping over a whole character after an empty one
+static size_t resume_after(const WynString* text, size_t start, size_t end) {
+    if (end > start) return end;
+    if (end >= text->byte_len) return end + 1;
+    size_t step = wyn_utf8_char_byte_len(text->data[end]);
+    return end + (step ? step : 1);
+}
+
 // Pattern matching
 bool wyn_regex_is_match(const WynRegex* regex, const WynString* text) {
     if (!regex || !text) return false;
-    
-    WynMatch* match = wyn_regex_find(regex, text);
-    bool result = (match != NULL);
-    wyn_match_free(match);
-    return result;
+    return wyn_regex_matches_bytes(regex, wyn_string_as_bytes(text), wyn_string_byte_len(text));
 }
 
 WynMatch* wyn_regex_find(const WynRegex* regex, const WynString* text) {
     if (!regex || !text) return NULL;
-    
-    // Simple implementation - try matching at each position
-    size_t text_len = wyn_string_char_count((WynString*)text);
-    
-    for (size_t i = 0; i < text_len; i++) {
-        size_t end_pos;
-        if (wyn_regex_match_node(regex->root, text, i, &end_pos, NULL)) {
-            // Extract matched substring
-            WynString* match_text = wyn_string_substring(text, i, end_pos);
-            WynMatch* match = wyn_match_new(i, end_pos, match_text);
-            wyn_string_free(match_text);
-            return match;
-        }
-    }
-    
-    return NULL;
+    size_t start, end;
+    if (!wyn_regex_search(regex, wyn_string_as_bytes(text), wyn_string_byte_len(text), 0, &start, &end)) {
+        return NULL;
+    }
+    return match_from_span(text, start, end);
 }
 
 WynMatch** wyn_regex_find_all(const WynRegex* regex, const WynString* text, size_t* count) {
@@ -122,133 +1786,126 @@ WynMatch** wyn_regex_find_all(const WynRegex* regex, const WynString* text, size
         if (count) *count = 0;
         return NULL;
     }
-    
-    // Simple implementation - collect all matches
+
     WynMatch** matches = NULL;
     size_t capacity = 0;
     *count = 0;
-    
-    size_t text_len = wyn_string_char_count((WynString*)text);
+
+    const uint8_t* bytes = wyn_string_as_bytes(text);
+    size_t len = wyn_string_byte_len(text);
     size_t pos = 0;
-    
-    while (pos < text_len) {
-        size_t end_pos;
-        if (wyn_regex_match_node(regex->root, text, pos, &end_pos, NULL)) {
-            // Grow matches array if needed
-            if (*count >= capacity) {
-                capacity = capacity == 0 ? 4 : capacity * 2;
-                matches = realloc(matches, capacity * sizeof(WynMatch*));
-                if (!matches) {
-                    *count = 0;
-                    return NULL;
-                }
-            }
-            
-            // Create match
-            WynString* match_text = wyn_string_substring(text, pos, end_pos);
-            matches[*count] = wyn_match_new(pos, end_pos, match_text);
-            wyn_string_free(match_text);
-            (*count)++;
-            
-            pos = end_pos > pos ? end_pos : pos + 1;  // Avoid infinite loop
-        } else {
-            pos++;
+    size_t start, end;
+    while (pos <= len && wyn_regex_search(regex, bytes, len, pos, &start, &end)) {
+        if (*count >= capacity) {
+            capacity = capacity == 0 ? 4 : capacity * 2;
+            WynMatch** grown = realloc(matches, capacity * sizeof(WynMatch*));
+            if (!grown) break;
+            matches = grown;
         }
+        matches[(*count)++] = match_from_span(text, start, end);
+        pos = resume_after(text, start, end);
     }
-    
+
     return matches;
 }
 
 WynCaptures* wyn_regex_captures(const WynRegex* regex, const WynString* text) {
     if (!regex || !text) return NULL;
-    
-    WynCaptures* captures = wyn_captures_new(regex->group_count);
+
+    const uint8_t* bytes = wyn_string_as_bytes(text);
+    size_t len = wyn_string_byte_len(text);
+    size_t start, end;
+    if (!wyn_regex_search(regex, bytes, len, 0, &start, &end)) return NULL;
+
+    // The match is known; replay just that span to place the groups
+    WynRegexProgram* program = regex->program;
+    if (!program->slots) program->slots = malloc(program->forward->slot_count * sizeof(size_t));
+    size_t* slots = program->slots;
+    if (!pike_search(program->forward, bytes ? bytes : (const uint8_t*)"", len, start, true, slots)) {
+        return NULL;
+    }
+
+    WynCaptures* captures = wyn_captures_new(regex->group_count + 1);
     if (!captures) return NULL;
-    
-    size_t end_pos;
-    if (wyn_regex_match_node(regex->root, text, 0, &end_pos, captures)) {
-        return captures;
+    for (int g = 0; g <= regex->group_count; g++) {
+        if (slots[g * 2] != RX_NO_POS && slots[g * 2 + 1] != RX_NO_POS) {
+            captures->matches[g] = match_from_span(text, slots[g * 2], slots[g * 2 + 1]);
+        }
     }
-    
-    wyn_captures_free(captures);
-    return NULL;
+
+    size_t named = 0;
+    for (int g = 0; g < regex->group_count; g++) {
+        if (regex->group_names[g]) named++;
+    }
+    if (named) {
+        captures->named_groups = calloc(named, sizeof(char*));
+        captures->named_matches = calloc(named, sizeof(WynMatch*));
+        for (int g = 0; g < regex->group_count; g++) {
+            if (!regex->group_names[g]) continue;
+            size_t i = captures->named_count++;
+            captures->named_groups[i] = strdup(regex->group_names[g]);
+            WynMatch* m = captures->matches[g + 1];
+            captures->named_matches[i] = m ? match_from_span(text, m->start, m->end) : NULL;
+        }
+    }
+    return captures;
 }
 
 // String replacement
-WynString* wyn_regex_replace(const WynRegex* regex, const WynString* text, const char* replacement) {
-    if (!regex || !text || !replacement) return NULL;
-    
-    WynMatch* match = wyn_regex_find(regex, text);
-    if (!match) {
-        return wyn_string_clone(text);
+static WynString* replace_matches(const WynRegex* regex, const WynString* text, const char* replacement,
+                                  bool all) {
+    const uint8_t* bytes = wyn_string_as_bytes(text);
+    size_t len = wyn_string_byte_len(text);
+    size_t rep_len = strlen(replacement);
+    size_t cap = len + 16, out_len = 0;
+    uint8_t* out = malloc(cap);
+    size_t pos = 0, copied = 0;
+    size_t start, end;
+    while (pos <= len && wyn_regex_search(regex, bytes, len, pos, &start, &end)) {
+        size_t need = out_len + (start - copied) + rep_len;
+        if (need > cap) {
+            while (cap < need) cap *= 2;
+            out = realloc(out, cap);
+        }
+        memcpy(out + out_len, bytes + copied, start - copied);
+        out_len += start - copied;
+        memcpy(out + out_len, replacement, rep_len);
+        out_len += rep_len;
+        copied = end;
+        if (!all) break;
+        pos = resume_after(text, start, end);
     }
-    
-    // Build replacement string
-    WynString* result = wyn_string_new();
-    
-    // Add text before match
-    WynString* before = wyn_string_substring(text, 0, match->start);
-    wyn_string_push_string(result, before);
-    wyn_string_free(before);
-    
-    // Add replacement
-    wyn_string_push_str(result, replacement);
-    
-    // Add text after match
-    size_t text_len = wyn_string_char_count((WynString*)text);
-    WynString* after = wyn_string_substring(text, match->end, text_len);
-    wyn_string_push_string(result, after);
-    wyn_string_free(after);
-    
-    wyn_match_free(match);
+    if (out_len + (len - copied) > cap) {
+        cap = out_len + (len - copied);
+        out = realloc(out, cap);
+    }
+    if (len > copied) memcpy(out + out_len, bytes + copied, len - copied);
+    out_len += len - copied;
+    WynUtf8Error err;
+    WynString* result = wyn_string_from_utf8(out, out_len, &err);
+    free(out);
     return result;
 }
 
+WynString* wyn_regex_replace(const WynRegex* regex, const WynString* text, const char* replacement) {
+    if (!regex || !text || !replacement) return NULL;
+    return replace_matches(regex, text, replacement, false);
+}
+
 WynString* wyn_regex_replace_all(const WynRegex* regex, const WynString* text, const char* replacement) {
     if (!regex || !text || !replacement) return NULL;
-    
-    size_t match_count;
-    WynMatch** matches = wyn_regex_find_all(regex, text, &match_count);
-    
-    if (match_count == 0) {
-        return wyn_string_clone(text);
-    }
-    
-    WynString* result = wyn_string_new();
-    size_t last_end = 0;
-    
-    for (size_t i = 0; i < match_count; i++) {
-        // Add text between matches
-        WynString* between = wyn_string_substring(text, last_end, matches[i]->start);
-        wyn_string_push_string(result, between);
-        wyn_string_free(between);
-        
-        // Add replacement
-        wyn_string_push_str(result, replacement);
-        
-        last_end = matches[i]->end;
-        wyn_match_free(matches[i]);
-    }
-    
-    // Add remaining text
-    size_t text_len = wyn_string_char_count((WynString*)text);
-    WynString* remaining = wyn_string_substring(text, last_end, text_len);
-    wyn_string_push_string(result, remaining);
-    wyn_string_free(remaining);
-    
-    free(matches);
-    return result;
+    return replace_matches(regex, text, replacement, true);
 }
 
 // Match and capture management
 WynMatch* wyn_match_new(size_t start, size_t end, const WynString* text) {
     WynMatch* match = malloc(sizeof(WynMatch));
     if (!match) return NULL;
-    
+
     match->start = start;
     match->end = end;
     match->text = text ? wyn_string_clone(text) : NULL;
-    
+
     return match;
 }
 
@@ -261,36 +1918,36 @@ void wyn_match_free(WynMatch* match) {
 WynCaptures* wyn_captures_new(size_t group_count) {
     WynCaptures* captures = malloc(sizeof(WynCaptures));
     if (!captures) return NULL;
-    
+
     captures->count = group_count;
     captures->matches = calloc(group_count, sizeof(WynMatch*));
     captures->named_groups = NULL;
     captures->named_matches = NULL;
     captures->named_count = 0;
-    
+
     if (group_count > 0 && !captures->matches) {
         free(captures);
         return NULL;
     }
-    
+
     return captures;
 }
 
 void wyn_captures_free(WynCaptures* captures) {
     if (!captures) return;
-    
+
     for (size_t i = 0; i < captures->count; i++) {
         wyn_match_free(captures->matches[i]);
     }
     free(captures->matches);
-    
+
     for (size_t i = 0; i < captures->named_count; i++) {
         free(captures->named_groups[i]);
         wyn_match_free(captures->named_matches[i]);
     }
     free(captures->named_groups);
     free(captures->named_matches);
-    
+
     free(captures);
 }
 
@@ -303,13 +1960,13 @@ WynMatch* wyn_captures_get(const WynCaptures* captures, int group_id) {
 
 WynMatch* wyn_captures_get_named(const WynCaptures* captures, const char* name) {
     if (!captures || !name) return NULL;
-    
+
     for (size_t i = 0; i < captures->named_count; i++) {
         if (strcmp(captures->named_groups[i], name) == 0) {
             return captures->named_matches[i];
         }
     }
-    
+
     return NULL;
 }
 
@@ -317,11 +1974,11 @@ WynMatch* wyn_captures_get_named(const WynCaptures* captures, const char* name)
 WynRegexError* wyn_regex_error_new(WynRegexErrorCode code, const char* message, size_t position) {
     WynRegexError* error = malloc(sizeof(WynRegexError));
     if (!error) return NULL;
-    
+
     error->code = code;
     error->message = message ? strdup(message) : NULL;
     error->position = position;
-    
+
     return error;
 }
 
@@ -353,230 +2010,29 @@ bool wyn_regex_is_digit_char(uint32_t codepoint) {
 }
 
 bool wyn_regex_is_space_char(uint32_t codepoint) {
-    return wyn_unicode_is_whitespace(codepoint);
+    return wyn_unicode_is_whitespace(codepoint) || codepoint == '\f' || codepoint == '\v';
 }
 
-// Simplified pattern parsing (basic implementation)
-WynRegexNode* wyn_regex_parse_pattern(const char* pattern, size_t* pos, WynRegexError* error) {
-    if (!pattern || !pos) {
-        if (error) {
-            *error = *wyn_regex_error_new(WYN_REGEX_INVALID_PATTERN, "Invalid parameters", 0);
-        }
-        return NULL;
-    }
-    
-    // Convert pattern to WynString for proper Unicode handling
-    WynString* pattern_str = wyn_string_from_cstr(pattern);
-    if (!pattern_str) {
-        if (error) {
-            *error = *wyn_regex_error_new(WYN_REGEX_UNICODE_ERROR, "Failed to parse pattern as UTF-8", 0);
-        }
-        return NULL;
-    }
-    
-    size_t pattern_len = wyn_string_char_count(pattern_str);
-    if (pattern_len == 0) {
-        wyn_string_free(pattern_str);
-        if (error) {
-            error->code = WYN_REGEX_OK;
-            error->message = NULL;
-            error->position = 0;
-        }
-        return NULL;
-    }
-    
-    // Create a chain of literal nodes from Unicode characters
-    WynRegexNode* root = NULL;
-    WynRegexNode* current = NULL;
-    
-    WynStringIterator* iter = wyn_string_iter(pattern_str);
-    uint32_t codepoint;
-    size_t char_pos = 0;
-    
-    while (wyn_string_iter_next(iter, &codepoint)) {
-        WynRegexNode* node = malloc(sizeof(WynRegexNode));
-        if (!node) {
-            wyn_string_iter_free(iter);
-            wyn_string_free(pattern_str);
-            if (error) {
-                *error = *wyn_regex_error_new(WYN_REGEX_MEMORY_ERROR, "Memory allocation failed", char_pos);
-            }
-            return NULL;
-        }
-        
-        memset(node, 0, sizeof(WynRegexNode));
-        
-        // Handle special characters
-        switch (codepoint) {
-            case '.':
-                node->type = REGEX_DOT;
-                break;
-            case '^':
-                node->type = REGEX_CARET;
-                break;
-            case '$':
-                node->type = REGEX_DOLLAR;
-                break;
-            default:
-                // Regular character
-                node->type = REGEX_LITERAL;
-                node->codepoint = codepoint;
-                break;
-        }
-        
-        // Link nodes together
-        if (!root) {
-            root = node;
-            current = node;
-        } else {
-            current->next = node;
-            current = node;
-        }
-        
-        char_pos++;
-    }
-    
-    wyn_string_iter_free(iter);
-    wyn_string_free(pattern_str);
-    *pos = strlen(pattern);  // Set to end of byte string
-    
-    if (error) {
-        error->code = WYN_REGEX_OK;
-        error->message = NULL;
-        error->position = 0;
-    }
-    
-    return root;
-}
-
-// Simplified matching engine
-bool wyn_regex_match_node(const WynRegexNode* node, const WynString* text, size_t pos, 
-                         size_t* end_pos, WynCaptures* captures) {
-    (void)captures; // Suppress unused parameter warning
-    
-    if (!node || !text) return false;
-    
-    size_t text_len = wyn_string_char_count((WynString*)text);
-    size_t current_pos = pos;
-    const WynRegexNode* current_node = node;
-    
-    // Match sequence of nodes
-    while (current_node) {
-        switch (current_node->type) {
-            case REGEX_LITERAL: {
-                if (current_pos >= text_len) return false;
-                
-                // Get character at position using substring approach
-                WynString* char_str = wyn_string_substring(text, current_pos, current_pos + 1);
-                if (!char_str || wyn_string_is_empty(char_str)) {
-                    wyn_string_free(char_str);
-                    return false;
-                }
-                
-                // Get the first (and only) character
-                WynStringIterator* iter = wyn_string_iter(char_str);
-                uint32_t codepoint = 0;
-                bool has_char = wyn_string_iter_next(iter, &codepoint);
-                wyn_string_iter_free(iter);
-                wyn_string_free(char_str);
-                
-                if (!has_char) return false;
-                
-                bool match = wyn_regex_match_literal(current_node->codepoint, codepoint, false);
-                if (!match) return false;
-                
-                current_pos++;
-                break;
-            }
-            
-            case REGEX_DOT: {
-                if (current_pos >= text_len) return false;
-                current_pos++;
-                break;
-            }
-            
-            case REGEX_CARET: {
-                if (current_pos != 0) return false;
-                // Don't advance position for anchors
-                break;
-            }
-            
-            case REGEX_DOLLAR: {
-                if (current_pos != text_len) return false;
-                // Don't advance position for anchors
-                break;
-            }
-            
-            default:
-                return false;
+// Pattern inspection
+bool wyn_regex_is_literal_string(const WynRegexNode* node) {
+    if (!node) return false;
+    for (; node; node = node->next) {
+        if (node->type != REGEX_LITERAL || (node->case_insensitive && is_ascii_letter(node->codepoint))) {
+            return false;
         }
-        
-        current_node = current_node->next;
     }
-    
-    if (end_pos) *end_pos = current_pos;
     return true;
 }
 
-bool wyn_regex_match_literal(uint32_t pattern_char, uint32_t text_char, bool case_insensitive) {
-    if (case_insensitive) {
-        return wyn_unicode_to_lowercase(pattern_char) == wyn_unicode_to_lowercase(text_char);
-    }
-    return pattern_char == text_char;
-}
-
-bool wyn_regex_match_char_class(const WynRegexNode* node, uint32_t codepoint) {
-    if (!node || node->type != REGEX_BRACKET) return false;
-    
-    // Simple implementation - check if codepoint is in character class
-    for (size_t i = 0; i < node->char_class_size; i++) {
-        if (node->char_class[i] == codepoint) {
-            return !node->negated;
-        }
-    }
-    
-    return node->negated;
-}
-
-// Optimization utilities (simplified)
-WynRegexNode* wyn_regex_optimize_pattern(WynRegexNode* root) {
-    // Basic optimization - just return as-is for now
-    return root;
-}
-
-bool wyn_regex_is_literal_string(const WynRegexNode* node) {
-    return node && node->type == REGEX_LITERAL;
-}
-
 WynString* wyn_regex_extract_literal_prefix(const WynRegexNode* node) {
-    if (!wyn_regex_is_literal_string(node)) return NULL;
-    
     WynString* result = wyn_string_new();
-    wyn_string_push_char(result, node->codepoint);
-    return result;
-}
-
-// Regex feature implementations (not yet implemented)
-WynRegexNode* wyn_regex_parse_group(const char* pattern, size_t* pos, int* group_id, WynRegexError* error) {
-    // Groups not implemented
-    if (error) {
-        *error = *wyn_regex_error_new(WYN_REGEX_COMPILATION_ERROR, "Groups not implemented", *pos);
-    }
-    return NULL;
-}
-
-WynRegexNode* wyn_regex_parse_bracket(const char* pattern, size_t* pos, WynRegexError* error) {
-    // Bracket expressions not implemented
-    if (error) {
-        *error = *wyn_regex_error_new(WYN_REGEX_COMPILATION_ERROR, "Bracket expressions not implemented", *pos);
+    for (; node && node->type == REGEX_LITERAL; node = node->next) {
+        if (node->case_insensitive && is_ascii_letter(node->codepoint)) break;
+        wyn_string_push_char(result, node->codepoint);
     }
-    return NULL;
-}
-
-WynRegexNode* wyn_regex_parse_quantifier(const char* pattern, size_t* pos, WynRegexNode* node, WynRegexError* error) {
-    // Quantifiers not implemented
-    if (error) {
-        *error = *wyn_regex_error_new(WYN_REGEX_COMPILATION_ERROR, "Quantifiers not implemented", *pos);
+    if (wyn_string_is_empty(result)) {
+        wyn_string_free(result);
+        return NULL;
     }
-    return node;
+    return result;
 }
@@ -22,7 +22,8 @@ typedef enum {
     WYN_REGEX_UNICODE_ERROR
 } WynRegexErrorCode;
 
-// Match result structure
+// Match result structure. start and end are byte offsets into the searched
+// text; matches always begin and end on UTF-8 character boundaries.
 typedef struct WynMatch {
     size_t start;
     size_t end;
@@ -31,8 +32,8 @@ typedef struct WynMatch {
 
 // Capture groups structure
 typedef struct WynCaptures {
-    WynMatch** matches;     // Array of match pointers (NULL for no match)
-    size_t count;           // Number of capture groups
+    WynMatch** matches;     // Group 0 is the whole match (NULL for a group that did not take part)
+    size_t count;           // Number of capture groups, plus one
     char** named_groups;    // Array of named group names
     WynMatch** named_matches; // Array of named group matches
     size_t named_count;     // Number of named groups
@@ -45,54 +46,66 @@ typedef struct WynRegexError {
     size_t position;        // Position in pattern where error occurred
 } WynRegexError;
 
-// Internal regex pattern representation
+// Parsed pattern. Classes are normalized while parsing: char_class holds
+// sorted, disjoint, inclusive codepoint ranges with negation and case
+// folding already applied, so `.`, `\d` and `[^a-z]` all compile alike.
 typedef enum {
-    REGEX_LITERAL,
+    REGEX_LITERAL,          // one character
     REGEX_DOT,              // .
-    REGEX_STAR,             // *
-    REGEX_PLUS,             // +
-    REGEX_QUESTION,         // ?
-    REGEX_CARET,            // ^
-    REGEX_DOLLAR,           // $
-    REGEX_BRACKET,          // [...]
-    REGEX_GROUP,            // (...)
-    REGEX_ALTERNATION,      // |
-    REGEX_ESCAPE,           // backslash
-    REGEX_QUANTIFIER        // {n,m}
+    REGEX_BRACKET,          // [...], \d, \w, \s and their negations
+    REGEX_GROUP,            // (...), (?:...), (?P<name>...)
+    REGEX_ALTERNATION,      // left|right
+    REGEX_QUANTIFIER,       // *, +, ?, {n}, {n,}, {n,m}
+    REGEX_ASSERTION         // ^, $, \A, \z, \b, \B
 } WynRegexNodeType;
 
+typedef enum {
+    REGEX_BEGIN_TEXT,
+    REGEX_END_TEXT,
+    REGEX_BEGIN_LINE,
+    REGEX_END_LINE,
+    REGEX_WORD_BOUNDARY,
+    REGEX_NOT_WORD_BOUNDARY
+} WynRegexAssertion;
+
 typedef struct WynRegexNode {
     WynRegexNodeType type;
     uint32_t codepoint;     // For literals
-    struct WynRegexNode* left;
-    struct WynRegexNode* right;
-    struct WynRegexNode* next;
-    
+    WynRegexAssertion assertion;
+    struct WynRegexNode* left;      // Group body, repeated node, or first alternative
+    struct WynRegexNode* right;     // Remaining alternatives
+    struct WynRegexNode* next;      // Next node in the sequence
+
     // Quantifier data
     int min_count;
-    int max_count;
-    
-    // Character class data
+    int max_count;          // -1 for unbounded
+
+    // Character class data: char_class_size ranges stored as lo, hi pairs
     uint32_t* char_class;
     size_t char_class_size;
     bool negated;
-    
+
     // Group data
-    int group_id;
+    int group_id;           // 0 for non-capturing groups
     char* group_name;
-    
+
     // Flags
     bool greedy;
     bool case_insensitive;
 } WynRegexNode;
 
-// Compiled regex structure
+// Compiled programs, literal prefilters and DFA caches (regex.c)
+typedef struct WynRegexProgram WynRegexProgram;
+
+// Compiled regex structure. Searching fills a lazily built DFA cache, so a
+// regex must not be used from several threads at once.
 typedef struct WynRegex {
     WynRegexNode* root;
     int group_count;
-    char** group_names;
+    char** group_names;     // Indexed by group id - 1; NULL for unnamed groups
     size_t flags;
     WynRegexError* last_error;
+    WynRegexProgram* program;
 } WynRegex;
 
 // Regex compilation and destruction
@@ -100,12 +113,19 @@ WynRegex* wyn_regex_new(const char* pattern, WynRegexError* error);
 WynRegex* wyn_regex_new_with_flags(const char* pattern, size_t flags, WynRegexError* error);
 void wyn_regex_free(WynRegex* regex);
 
-// Pattern matching
+// Pattern matching. All searches run in time linear in the text length.
 bool wyn_regex_is_match(const WynRegex* regex, const WynString* text);
 WynMatch* wyn_regex_find(const WynRegex* regex, const WynString* text);
 WynMatch** wyn_regex_find_all(const WynRegex* regex, const WynString* text, size_t* count);
 WynCaptures* wyn_regex_captures(const WynRegex* regex, const WynString* text);
 
+// Byte-level search without allocating: finds the leftmost-first match that
+// starts at or after `from`, as byte offsets into text, which must be valid
+// UTF-8. Bytes before `from` still count for ^, \b and friends.
+bool wyn_regex_search(const WynRegex* regex, const uint8_t* text, size_t len, size_t from,
+                      size_t* match_start, size_t* match_end);
+bool wyn_regex_matches_bytes(const WynRegex* regex, const uint8_t* text, size_t len);
+
 // String replacement
 WynString* wyn_regex_replace(const WynRegex* regex, const WynString* text, const char* replacement);
 WynString* wyn_regex_replace_all(const WynRegex* regex, const WynString* text, const char* replacement);
@@ -123,32 +143,19 @@ WynRegexError* wyn_regex_error_new(WynRegexErrorCode code, const char* message,
 void wyn_regex_error_free(WynRegexError* error);
 const char* wyn_regex_error_string(WynRegexErrorCode code);
 
-// Regex flags
+// Regex flags; (?i), (?m), (?s) and (?x) set the same flags inside a pattern
 #define WYN_REGEX_CASE_INSENSITIVE  (1 << 0)
-#define WYN_REGEX_MULTILINE         (1 << 1)
-#define WYN_REGEX_DOTALL            (1 << 2)
-#define WYN_REGEX_UNICODE           (1 << 3)
-#define WYN_REGEX_EXTENDED          (1 << 4)
+#define WYN_REGEX_MULTILINE         (1 << 1)    // ^ and $ also match at line breaks
+#define WYN_REGEX_DOTALL            (1 << 2)    // . also matches \n
+#define WYN_REGEX_UNICODE           (1 << 3)    // Patterns and text are UTF-8 (always on)
+#define WYN_REGEX_EXTENDED          (1 << 4)    // Whitespace and # comments in the pattern are ignored
 
-// Unicode character classes
+// Character classes for \w, \d and \s (ASCII, like the rest of unicode.c)
 bool wyn_regex_is_word_char(uint32_t codepoint);
 bool wyn_regex_is_digit_char(uint32_t codepoint);
 bool wyn_regex_is_space_char(uint32_t codepoint);
 
-// Pattern compilation utilities
-WynRegexNode* wyn_regex_parse_pattern(const char* pattern, size_t* pos, WynRegexError* error);
-WynRegexNode* wyn_regex_parse_group(const char* pattern, size_t* pos, int* group_id, WynRegexError* error);
-WynRegexNode* wyn_regex_parse_bracket(const char* pattern, size_t* pos, WynRegexError* error);
-WynRegexNode* wyn_regex_parse_quantifier(const char* pattern, size_t* pos, WynRegexNode* node, WynRegexError* error);
-
-// Pattern matching engine
-bool wyn_regex_match_node(const WynRegexNode* node, const WynString* text, size_t pos, 
-                         size_t* end_pos, WynCaptures* captures);
-bool wyn_regex_match_literal(uint32_t pattern_char, uint32_t text_char, bool case_insensitive);
-bool wyn_regex_match_char_class(const WynRegexNode* node, uint32_t codepoint);
-
-// Optimization utilities
-WynRegexNode* wyn_regex_optimize_pattern(WynRegexNode* root);
+// Pattern inspection
 bool wyn_regex_is_literal_string(const WynRegexNode* node);
 WynString* wyn_regex_extract_literal_prefix(const WynRegexNode* node);
 
@@ -0,0 +1,375 @@
+// Prebuilt runtime library for compiled Wyn programs
+// Builds libwynrt.a from the runtime sources once per (sources, headers,
+// version, flags) combination and caches it under ~/.wyn/cache.
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+    #include <direct.h>
+    #include <process.h>
+    #define mkdir(path, mode) _mkdir(path)
+    #define getpid _getpid
+#else
+    #include <dirent.h>
+    #include <fcntl.h>
+    #include <sys/file.h>
+    #include <unistd.h>
+#endif
+
+#include "runtime_lib.h"
+
+#define WYN_CC "gcc"
+
+// Runtime sources linked into every compiled Wyn program
+static const char* runtime_sources[] = {
+    "wyn_wrapper.c", "wyn_interface.c", "io.c", "optional.c", "result.c",
+    "arc_runtime.c", "concurrency.c", "async_runtime.c", "safe_memory.c",
+    "error.c", "string_runtime.c", "hashmap.c", "hashset.c", "json.c",
+    "json_runtime.c", "stdlib_runtime.c", "hashmap_runtime.c", "stdlib_string.c",
+    "stdlib_array.c", "stdlib_time.c", "stdlib_crypto.c", "spawn.c", "net.c",
+    "net_runtime.c", "test_runtime.c", "net_advanced.c", "http_client.c",
+    "http_server.c", "sort.c", "memory_pool.c", "cycle_detection.c",
+    NULL
+};
+
+void wyn_build_options_init(WynBuildOptions* opts, const char* opt_flag) {
+    memset(opts, 0, sizeof(*opts));
+    opts->opt_flag = opt_flag ? opt_flag : "-O0";
+}
+
+bool wyn_build_options_parse(WynBuildOptions* opts, const char* arg) {
+    static const char* levels[] = { "-O0", "-O1", "-O2", "-O3", "-Os", NULL };
+    for (int i = 0; levels[i] != NULL; i++) {
+        if (strcmp(arg, levels[i]) == 0) {
+            opts->opt_flag = levels[i];
+            return true;
+        }
+    }
+
+    if (strcmp(arg, "--release") == 0) {
+        opts->opt_flag = "-O3";
+        opts->lto = true;
+    } else if (strcmp(arg, "-march=native") == 0) {
+        opts->native = true;
+    } else if (strcmp(arg, "-flto") == 0) {
+        opts->lto = true;
+    } else if (strcmp(arg, "--pgo-use") == 0) {
+        opts->pgo = WYN_PGO_USE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void wyn_build_options_set_source(WynBuildOptions* opts, const char* source_file) {
+    if (opts->pgo_dir[0] == '\0') {
+        snprintf(opts->pgo_dir, sizeof(opts->pgo_dir), "%s.pgo", source_file);
+    }
+}
+
+void wyn_build_runtime_cflags(const WynBuildOptions* opts, char* out, size_t size) {
+    // Profiles are only meaningful for optimized code, and training and
+    // optimized builds must agree on the level to produce matching CFGs
+    const char* opt_flag = opts->opt_flag;
+    if (opts->pgo != WYN_PGO_NONE && strcmp(opt_flag, "-O0") == 0) {
+        opt_flag = "-O2";
+    }
+
+    snprintf(out, size, "%s%s%s", opt_flag,
+             opts->native ? " -march=native" : "",
+             opts->lto ? " -flto" : "");
+}
+
+static void build_program_cflags(const WynBuildOptions* opts, char* out, size_t size) {
+    char runtime_cflags[128];
+    wyn_build_runtime_cflags(opts, runtime_cflags, sizeof(runtime_cflags));
+
+    switch (opts->pgo) {
+        case WYN_PGO_GENERATE:
+            snprintf(out, size, "%s -fprofile-generate=\"%s\" -fprofile-update=prefer-atomic",
+                     runtime_cflags, opts->pgo_dir);
+            break;
+        case WYN_PGO_USE:
+            snprintf(out, size, "%s -fprofile-use=\"%s\" -Wno-missing-profile -Wno-error=coverage-mismatch",
+                     runtime_cflags, opts->pgo_dir);
+            break;
+        default:
+            snprintf(out, size, "%s", runtime_cflags);
+            break;
+    }
+}
+
+void wyn_find_root(char* out, size_t size) {
+    snprintf(out, size, ".");
+
+    char* root_env = getenv("WYN_ROOT");
+    if (root_env) {
+        snprintf(out, size, "%s", root_env);
+        return;
+    }
+
+    // Auto-detect: try common locations
+    const char* search_paths[] = {
+        ".",
+        "./wyn",
+        "..",
+        "../..",
+        "/usr/local/share/wyn",
+        "/usr/share/wyn",
+        NULL
+    };
+
+    for (int i = 0; search_paths[i] != NULL; i++) {
+        char test_path[1024];
+        snprintf(test_path, sizeof(test_path), "%s/src/wyn_wrapper.c", search_paths[i]);
+        FILE* test = fopen(test_path, "r");
+        if (test) {
+            fclose(test);
+            snprintf(out, size, "%s", search_paths[i]);
+            return;
+        }
+    }
+}
+
+// FNV-1a, used only to key the cache
+static uint64_t hash_bytes(uint64_t h, const void* data, size_t len) {
+    const unsigned char* p = data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static int hash_file(uint64_t* h, const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return -1;
+
+    char buf[8192];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        *h = hash_bytes(*h, buf, n);
+    }
+    fclose(f);
+    return 0;
+}
+
+static int runtime_key(const char* wyn_root, const char* cflags, uint64_t* key) {
+    uint64_t h = 14695981039346656037ULL;
+    char path[1024];
+
+    h = hash_bytes(h, WYN_CC, strlen(WYN_CC));
+    h = hash_bytes(h, cflags, strlen(cflags) + 1);
+
+    snprintf(path, sizeof(path), "%s/VERSION", wyn_root);
+    hash_file(&h, path);
+
+    for (int i = 0; runtime_sources[i] != NULL; i++) {
+        snprintf(path, sizeof(path), "%s/src/%s", wyn_root, runtime_sources[i]);
+        h = hash_bytes(h, runtime_sources[i], strlen(runtime_sources[i]) + 1);
+        if (hash_file(&h, path) != 0) return -1;
+    }
+
+#ifndef _WIN32
+    // Headers are combined order-independently since readdir order varies
+    snprintf(path, sizeof(path), "%s/src", wyn_root);
+    DIR* d = opendir(path);
+    if (d) {
+        uint64_t headers = 0;
+        struct dirent* entry;
+        while ((entry = readdir(d)) != NULL) {
+            size_t len = strlen(entry->d_name);
+            if (len < 3 || strcmp(entry->d_name + len - 2, ".h") != 0) continue;
+
+            uint64_t hh = hash_bytes(14695981039346656037ULL, entry->d_name, len + 1);
+            snprintf(path, sizeof(path), "%s/src/%s", wyn_root, entry->d_name);
+            hash_file(&hh, path);
+            headers += hh;
+        }
+        closedir(d);
+        h = hash_bytes(h, &headers, sizeof(headers));
+    }
+#endif
+
+    *key = h;
+    return 0;
+}
+
+static int get_cache_dir(char* out, size_t size) {
+    char* cache_env = getenv("WYN_CACHE_DIR");
+    if (cache_env && cache_env[0]) {
+        snprintf(out, size, "%s", cache_env);
+        mkdir(out, 0755);
+        return 0;
+    }
+
+    char* home = getenv("HOME");
+    if (!home) home = getenv("USERPROFILE");
+    if (!home) return -1;
+
+    snprintf(out, size, "%s/.wyn", home);
+    mkdir(out, 0755);
+    snprintf(out, size, "%s/.wyn/cache", home);
+    mkdir(out, 0755);
+    return 0;
+}
+
+static int file_exists(const char* path) {
+    struct stat st;
+    return stat(path, &st) == 0;
+}
+
+static void remove_dir(const char* path) {
+    char cmd[1400];
+    snprintf(cmd, sizeof(cmd), "rm -rf \"%s\"", path);
+    system(cmd);
+}
+
+// The log lives next to the cache entry, not in tmp_dir, so it survives the
+// cleanup of a failed build
+static int build_runtime_lib(const char* wyn_root, const char* cflags, const char* tmp_dir, const char* log) {
+    char cmd[4096];
+
+    remove(log);
+    for (int i = 0; runtime_sources[i] != NULL; i++) {
+        snprintf(cmd, sizeof(cmd),
+                 WYN_CC " -std=c11 %s -I \"%s/src\" -c \"%s/src/%s\" -o \"%s/%d.o\" >> \"%s\" 2>&1",
+                 cflags, wyn_root, wyn_root, runtime_sources[i], tmp_dir, i, log);
+        if (system(cmd) != 0) {
+            fprintf(stderr, "Error: Failed to compile runtime source %s (see %s)\n", runtime_sources[i], log);
+            return -1;
+        }
+    }
+
+    // LTO objects need the plugin-aware archiver for a usable symbol index
+    const char* ar = strstr(cflags, "-flto") ? "gcc-ar" : "ar";
+    snprintf(cmd, sizeof(cmd), "%s rcs \"%s/libwynrt.a\" \"%s\"/*.o >> \"%s\" 2>&1 && rm -f \"%s\"/*.o",
+             ar, tmp_dir, tmp_dir, log, tmp_dir);
+    if (system(cmd) != 0) {
+        fprintf(stderr, "Error: Failed to archive runtime library (see %s)\n", log);
+        return -1;
+    }
+    remove(log);
+    return 0;
+}
+
+// Serializes cold builds of one key across processes: later compilers wait
+// for the first and then find its library. Returns -1 if there is no lock.
+static int lock_runtime_build(const char* lib_dir) {
+#ifndef _WIN32
+    char lock_path[1300];
+    snprintf(lock_path, sizeof(lock_path), "%s.lock", lib_dir);
+    int fd = open(lock_path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return -1;
+    if (flock(fd, LOCK_EX) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+#else
+    (void)lib_dir;
+    return -1;
+#endif
+}
+
+static void unlock_runtime_build(int fd) {
+#ifndef _WIN32
+    if (fd < 0) return;
+    flock(fd, LOCK_UN);
+    close(fd);
+#else
+    (void)fd;
+#endif
+}
+
+int wyn_runtime_lib(const char* wyn_root, const char* cflags, char* out, size_t size) {
+    uint64_t key;
+    if (runtime_key(wyn_root, cflags, &key) != 0) return -1;
+
+    char cache_dir[1024];
+    if (get_cache_dir(cache_dir, sizeof(cache_dir)) != 0) return -1;
+
+    char lib_dir[1200];
+    snprintf(lib_dir, sizeof(lib_dir), "%s/runtime-%016llx", cache_dir, (unsigned long long)key);
+    snprintf(out, size, "%s/libwynrt.a", lib_dir);
+    if (file_exists(out)) return 0;
+
+    int lock = lock_runtime_build(lib_dir);
+    if (file_exists(out)) {
+        // Published while we waited for the lock
+        unlock_runtime_build(lock);
+        return 0;
+    }
+
+    // Build into a private directory and publish it with rename(), so
+    // readers never observe a partially written archive, even where there
+    // is no lock
+    char tmp_dir[1300];
+    char log[1300];
+    snprintf(tmp_dir, sizeof(tmp_dir), "%s.tmp%d", lib_dir, (int)getpid());
+    snprintf(log, sizeof(log), "%s.log", lib_dir);
+    if (mkdir(tmp_dir, 0755) != 0) {
+        unlock_runtime_build(lock);
+        return -1;
+    }
+
+    if (build_runtime_lib(wyn_root, cflags, tmp_dir, log) != 0 || rename(tmp_dir, lib_dir) != 0) {
+        // Failed, or (without a lock) another process published the key first
+        remove_dir(tmp_dir);
+    }
+    unlock_runtime_build(lock);
+    return file_exists(out) ? 0 : -1;
+}
+
+int wyn_link_program(const char* wyn_root, const char* c_file, const char* output_bin, const WynBuildOptions* opts) {
+    char runtime_cflags[128];
+    char cflags[1200];
+    char lib_path[1400];
+    char cmd[8192];
+
+    wyn_build_runtime_cflags(opts, runtime_cflags, sizeof(runtime_cflags));
+    build_program_cflags(opts, cflags, sizeof(cflags));
+
+    if (opts->pgo == WYN_PGO_GENERATE) {
+        mkdir(opts->pgo_dir, 0755);
+    }
+
+    if (wyn_runtime_lib(wyn_root, runtime_cflags, lib_path, sizeof(lib_path)) == 0) {
+        if (opts->pgo == WYN_PGO_NONE) {
+            snprintf(cmd, sizeof(cmd),
+                     WYN_CC " %s -std=c11 -I \"%s/src\" -o \"%s\" \"%s\" \"%s\" -lm -lpthread",
+                     cflags, wyn_root, output_bin, c_file, lib_path);
+            return system(cmd);
+        }
+
+        // Profile data is keyed by object path, so compile to a fixed object
+        // name that stays the same between the training and optimized builds
+        snprintf(cmd, sizeof(cmd),
+                 WYN_CC " %s -std=c11 -I \"%s/src\" -c \"%s\" -o \"%s.o\" && "
+                 WYN_CC " %s -o \"%s\" \"%s.o\" \"%s\" -lm -lpthread",
+                 cflags, wyn_root, c_file, c_file,
+                 cflags, output_bin, c_file, lib_path);
+        int result = system(cmd);
+
+        char obj_path[1024];
+        snprintf(obj_path, sizeof(obj_path), "%s.o", c_file);
+        remove(obj_path);
+        return result;
+    }
+
+    fprintf(stderr, "Warning: Runtime library unavailable, compiling runtime sources directly\n");
+    int len = snprintf(cmd, sizeof(cmd), WYN_CC " %s -std=c11 -I \"%s/src\" -o \"%s\" \"%s\"",
+                       cflags, wyn_root, output_bin, c_file);
+    for (int i = 0; runtime_sources[i] != NULL && len < (int)sizeof(cmd); i++) {
+        len += snprintf(cmd + len, sizeof(cmd) - len, " \"%s/src/%s\"", wyn_root, runtime_sources[i]);
+    }
+    if (len < (int)sizeof(cmd)) {
+        snprintf(cmd + len, sizeof(cmd) - len, " -lm -lpthread");
+    }
+    return system(cmd);
+}
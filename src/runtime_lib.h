@@ -0,0 +1,55 @@
+// Prebuilt runtime library for compiled Wyn programs
+// The runtime sources are compiled once into libwynrt.a and cached,
+// keyed by a content hash, so each build only compiles the generated C file.
+
+#ifndef RUNTIME_LIB_H
+#define RUNTIME_LIB_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// Profile-guided optimization stage
+typedef enum {
+    WYN_PGO_NONE = 0,
+    WYN_PGO_GENERATE,    // Instrument the program to record a profile
+    WYN_PGO_USE          // Optimize using a previously recorded profile
+} WynPgoMode;
+
+// Backend C compiler options, shared by the program and the runtime library
+typedef struct {
+    const char* opt_flag;    // "-O0", "-O1", "-O2", "-O3" or "-Os"
+    bool native;             // -march=native
+    bool lto;                // -flto
+    WynPgoMode pgo;
+    char pgo_dir[512];       // Profile directory (defaults to <file>.pgo)
+} WynBuildOptions;
+
+// Initialize options with the given default optimization flag
+void wyn_build_options_init(WynBuildOptions* opts, const char* opt_flag);
+
+// Consume a command-line build flag (-O<n>, -Os, --release, -march=native,
+// -flto, --pgo-use). Returns true if the argument was recognized.
+bool wyn_build_options_parse(WynBuildOptions* opts, const char* arg);
+
+// Set the default profile directory for a source file if none was given
+void wyn_build_options_set_source(WynBuildOptions* opts, const char* source_file);
+
+// Flags used for the runtime library (optimization level, target, LTO)
+void wyn_build_runtime_cflags(const WynBuildOptions* opts, char* out, size_t size);
+
+// Locate the Wyn root (the directory containing src/wyn_wrapper.c).
+// Honors WYN_ROOT, otherwise searches common locations; defaults to ".".
+void wyn_find_root(char* out, size_t size);
+
+// Ensure a cached libwynrt.a exists for this root and C flags.
+// Writes the archive path into out. Returns 0 on success, -1 on failure.
+int wyn_runtime_lib(const char* wyn_root, const char* cflags, char* out, size_t size);
+
+// Compile a generated C file and link it against the runtime library.
+// The runtime library is built with the same optimization, target and LTO
+// flags; PGO flags apply to the program only. Falls back to compiling the
+// runtime sources directly if the library cannot be built.
+// Returns the C compiler's exit status.
+int wyn_link_program(const char* wyn_root, const char* c_file, const char* output_bin, const WynBuildOptions* opts);
+
+#endif // RUNTIME_LIB_H
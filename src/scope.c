@@ -1,5 +1,6 @@
 #define _POSIX_C_SOURCE 200809L
 #include "scope.h"
+#include "intern.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -17,7 +18,6 @@ void ident_scope_free(IdentScope* scope) {
     IdentScopeEntry* entry = scope->entries;
     while (entry) {
         IdentScopeEntry* next = entry->next;
-        free(entry->name);
         free(entry);
         entry = next;
     }
@@ -28,7 +28,7 @@ void ident_scope_add(IdentScope* scope, const char* name, IdentScopeLevel level,
     if (!scope || !name) return;
     
     IdentScopeEntry* entry = calloc(1, sizeof(IdentScopeEntry));
-    entry->name = strdup(name);
+    entry->name = intern_cstr(name);
     entry->level = level;
     entry->is_function = is_function;
     entry->is_parameter = is_parameter;
@@ -39,8 +39,10 @@ void ident_scope_add(IdentScope* scope, const char* name, IdentScopeLevel level,
 IdentScopeEntry* ident_scope_lookup_local(IdentScope* scope, const char* name) {
     if (!scope || !name) return NULL;
     
+    // Entry names are interned, so equal names are the same pointer
+    const char* interned = intern_cstr(name);
     for (IdentScopeEntry* entry = scope->entries; entry; entry = entry->next) {
-        if (strcmp(entry->name, name) == 0) {
+        if (entry->name == interned) {
             return entry;
         }
     }
@@ -11,7 +11,7 @@ typedef enum {
 } IdentScopeLevel;
 
 typedef struct IdentScopeEntry {
-    char* name;
+    const char* name;       // interned (see intern.h)
     IdentScopeLevel level;
     bool is_function;
     bool is_parameter;
@@ -0,0 +1,378 @@
+#ifndef _WIN32
+#define _DEFAULT_SOURCE
+#endif
+#include "sort.h"
+#include "spawn.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <math.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <sched.h>
+#else
+#include <windows.h>
+#define sched_yield() SwitchToThread()
+#endif
+
+// Typed pdqsort instantiations
+
+#define SORT_NAME sort_int
+#define SORT_TYPE int
+#define SORT_CTX int
+#define SORT_LESS(ctx, a, b) ((a) < (b))
+#include "sort_impl.h"
+
+// NaNs order after every number so the comparison stays a strict weak order
+static inline bool float_less(double a, double b) {
+    return a < b || (isnan(b) && !isnan(a));
+}
+
+#define SORT_NAME sort_float
+#define SORT_TYPE double
+#define SORT_CTX int
+#define SORT_LESS(ctx, a, b) float_less((a), (b))
+#include "sort_impl.h"
+
+static inline bool str_less(const char* a, const char* b) {
+    return strcmp(a ? a : "", b ? b : "") < 0;
+}
+
+#define SORT_NAME sort_str
+#define SORT_TYPE const char*
+#define SORT_CTX int
+#define SORT_LESS(ctx, a, b) str_less((a), (b))
+#include "sort_impl.h"
+
+#define SORT_NAME sort_int_by
+#define SORT_TYPE int
+#define SORT_CTX WynIntCompare
+#define SORT_LESS(cmp, a, b) ((cmp)((a), (b)) < 0)
+#include "sort_impl.h"
+
+// Key/index pairs for struct-by-key sorting. Ties are broken by the
+// original index, which makes the sort stable.
+typedef struct { long long key; size_t index; } IntKey;
+typedef struct { double key; size_t index; } FloatKey;
+typedef struct { const char* key; size_t index; } StrKey;
+
+#define SORT_NAME sort_int_key
+#define SORT_TYPE IntKey
+#define SORT_CTX int
+#define SORT_LESS(ctx, a, b) ((a).key < (b).key || ((a).key == (b).key && (a).index < (b).index))
+#include "sort_impl.h"
+
+#define SORT_NAME sort_float_key
+#define SORT_TYPE FloatKey
+#define SORT_CTX int
+#define SORT_LESS(ctx, a, b) (float_less((a).key, (b).key) || \
+    (!float_less((b).key, (a).key) && (a).index < (b).index))
+#include "sort_impl.h"
+
+static inline int str_compare(const char* a, const char* b) {
+    return strcmp(a ? a : "", b ? b : "");
+}
+
+#define SORT_NAME sort_str_key
+#define SORT_TYPE StrKey
+#define SORT_CTX int
+#define SORT_LESS(ctx, a, b) (str_compare((a).key, (b).key) < 0 || \
+    (str_compare((a).key, (b).key) == 0 && (a).index < (b).index))
+#include "sort_impl.h"
+
+void wyn_sort_int(int* data, size_t count) {
+    sort_int_pdqsort(data, count, 0);
+}
+
+void wyn_sort_float(double* data, size_t count) {
+    sort_float_pdqsort(data, count, 0);
+}
+
+void wyn_sort_str(const char** data, size_t count) {
+    sort_str_pdqsort(data, count, 0);
+}
+
+void wyn_sort_int_by(int* data, size_t count, WynIntCompare cmp) {
+    sort_int_by_pdqsort(data, count, cmp);
+}
+
+// Stable merge sort
+
+#define MERGE_RUN 16
+
+static void merge_sort(char* data, char* tmp, size_t count, size_t size, WynSortCompare cmp, void* ctx) {
+    if (count <= MERGE_RUN) {
+        // Insertion sort; tmp holds the element being placed
+        for (size_t i = 1; i < count; i++) {
+            size_t j = i;
+            while (j > 0 && cmp(data + (j - 1) * size, data + i * size, ctx) > 0) j--;
+            if (j != i) {
+                memcpy(tmp, data + i * size, size);
+                memmove(data + (j + 1) * size, data + j * size, (i - j) * size);
+                memcpy(data + j * size, tmp, size);
+            }
+        }
+        return;
+    }
+
+    size_t mid = count / 2;
+    merge_sort(data, tmp, mid, size, cmp, ctx);
+    merge_sort(data + mid * size, tmp, count - mid, size, cmp, ctx);
+
+    // Halves already in order
+    if (cmp(data + (mid - 1) * size, data + mid * size, ctx) <= 0) return;
+
+    memcpy(tmp, data, mid * size);
+    char* left = tmp;
+    char* left_end = tmp + mid * size;
+    char* right = data + mid * size;
+    char* right_end = data + count * size;
+    char* out = data;
+    while (left < left_end && right < right_end) {
+        if (cmp(right, left, ctx) < 0) {
+            memcpy(out, right, size);
+            right += size;
+        } else {
+            memcpy(out, left, size);
+            left += size;
+        }
+        out += size;
+    }
+    if (left < left_end) memcpy(out, left, (size_t)(left_end - left));
+}
+
+void wyn_sort_stable(void* base, size_t count, size_t size, WynSortCompare cmp, void* ctx) {
+    if (count < 2 || size == 0) return;
+    // Merging needs half the array; small runs need one element
+    size_t tmp_count = count / 2 + 1;
+    char* tmp = malloc(tmp_count * size);
+    if (!tmp) return;
+    merge_sort(base, tmp, count, size, cmp, ctx);
+    free(tmp);
+}
+
+typedef struct { WynIntCompare cmp; } IntCompareCtx;
+
+static int int_compare_adapter(const void* a, const void* b, void* ctx) {
+    return ((IntCompareCtx*)ctx)->cmp(*(const int*)a, *(const int*)b);
+}
+
+void wyn_sort_int_stable_by(int* data, size_t count, WynIntCompare cmp) {
+    IntCompareCtx ctx = { cmp };
+    wyn_sort_stable(data, count, sizeof(int), int_compare_adapter, &ctx);
+}
+
+// Struct-by-key sort: extract keys, sort the small pairs, then permute
+void wyn_sort_by_key(void* base, size_t count, size_t size, size_t key_offset, WynSortKeyType key_type) {
+    if (count < 2) return;
+    char* bytes = base;
+    size_t* order = malloc(count * sizeof(size_t));
+    char* tmp = malloc(count * size);
+    if (!order || !tmp) {
+        free(order);
+        free(tmp);
+        return;
+    }
+
+    // Unsorted order if a key buffer cannot be allocated
+    for (size_t i = 0; i < count; i++) order[i] = i;
+
+    switch (key_type) {
+        case WYN_SORT_KEY_INT: {
+            IntKey* keys = malloc(count * sizeof(IntKey));
+            if (!keys) break;
+            for (size_t i = 0; i < count; i++) {
+                int key;
+                memcpy(&key, bytes + i * size + key_offset, sizeof(int));
+                keys[i].key = key;
+                keys[i].index = i;
+            }
+            sort_int_key_pdqsort(keys, count, 0);
+            for (size_t i = 0; i < count; i++) order[i] = keys[i].index;
+            free(keys);
+            break;
+        }
+        case WYN_SORT_KEY_FLOAT: {
+            FloatKey* keys = malloc(count * sizeof(FloatKey));
+            if (!keys) break;
+            for (size_t i = 0; i < count; i++) {
+                // Wyn float fields are C doubles
+                double key;
+                memcpy(&key, bytes + i * size + key_offset, sizeof(double));
+                keys[i].key = key;
+                keys[i].index = i;
+            }
+            sort_float_key_pdqsort(keys, count, 0);
+            for (size_t i = 0; i < count; i++) order[i] = keys[i].index;
+            free(keys);
+            break;
+        }
+        case WYN_SORT_KEY_STRING: {
+            StrKey* keys = malloc(count * sizeof(StrKey));
+            if (!keys) break;
+            for (size_t i = 0; i < count; i++) {
+                memcpy(&keys[i].key, bytes + i * size + key_offset, sizeof(const char*));
+                keys[i].index = i;
+            }
+            sort_str_key_pdqsort(keys, count, 0);
+            for (size_t i = 0; i < count; i++) order[i] = keys[i].index;
+            free(keys);
+            break;
+        }
+        default:
+            break;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        memcpy(tmp + i * size, bytes + order[i] * size, size);
+    }
+    memcpy(bytes, tmp, count * size);
+    free(tmp);
+    free(order);
+}
+
+// Parallel sort
+//
+// The array is split into one chunk per CPU. Each chunk is offered to the
+// spawn scheduler, but the caller also claims and sorts any chunk no worker
+// has started yet, so it never waits on a task that is still queued (for
+// example when called from inside a spawned task). Sorted chunks are then
+// merged pairwise.
+
+#define CHUNK_PENDING 0
+#define CHUNK_CLAIMED 1
+#define CHUNK_DONE 2
+
+typedef struct ParallelSort ParallelSort;
+
+typedef struct {
+    ParallelSort* job;
+    int* data;
+    size_t count;
+    _Atomic int state;
+} SortChunk;
+
+struct ParallelSort {
+    _Atomic int refs;  // Caller plus one per queued task
+    int chunk_count;
+    SortChunk chunks[];
+};
+
+static void parallel_sort_release(ParallelSort* job) {
+    if (atomic_fetch_sub(&job->refs, 1) == 1) free(job);
+}
+
+static bool sort_chunk_claim(SortChunk* chunk) {
+    int expected = CHUNK_PENDING;
+    if (!atomic_compare_exchange_strong(&chunk->state, &expected, CHUNK_CLAIMED)) return false;
+    wyn_sort_int(chunk->data, chunk->count);
+    atomic_store(&chunk->state, CHUNK_DONE);
+    return true;
+}
+
+static void sort_chunk_task(void* arg) {
+    SortChunk* chunk = arg;
+    ParallelSort* job = chunk->job;
+    sort_chunk_claim(chunk);
+    parallel_sort_release(job);
+}
+
+static int online_cpus(void) {
+#ifdef _WIN32
+    SYSTEM_INFO sysinfo;
+    GetSystemInfo(&sysinfo);
+    return (int)sysinfo.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+static void merge_ints(const int* a, size_t a_count, const int* b, size_t b_count, int* out) {
+    size_t i = 0, j = 0, k = 0;
+    while (i < a_count && j < b_count) {
+        out[k++] = (b[j] < a[i]) ? b[j++] : a[i++];
+    }
+    while (i < a_count) out[k++] = a[i++];
+    while (j < b_count) out[k++] = b[j++];
+}
+
+void wyn_sort_int_parallel(int* data, size_t count) {
+    int cpus = online_cpus();
+    if (count < WYN_SORT_PARALLEL_THRESHOLD || cpus < 2) {
+        wyn_sort_int(data, count);
+        return;
+    }
+    if (cpus > 64) cpus = 64;
+
+    int* tmp = malloc(count * sizeof(int));
+    ParallelSort* job = malloc(sizeof(ParallelSort) + cpus * sizeof(SortChunk));
+    if (!tmp || !job) {
+        free(tmp);
+        free(job);
+        wyn_sort_int(data, count);
+        return;
+    }
+
+    job->chunk_count = cpus;
+    atomic_init(&job->refs, cpus);  // Caller plus cpus - 1 tasks
+    size_t per_chunk = count / cpus;
+    for (int i = 0; i < cpus; i++) {
+        SortChunk* chunk = &job->chunks[i];
+        chunk->job = job;
+        chunk->data = data + i * per_chunk;
+        chunk->count = (i == cpus - 1) ? count - i * per_chunk : per_chunk;
+        atomic_init(&chunk->state, CHUNK_PENDING);
+    }
+
+    // Offer all but the first chunk to workers; the caller takes the rest
+    for (int i = 1; i < cpus; i++) {
+        wyn_spawn(sort_chunk_task, &job->chunks[i]);
+    }
+    for (int i = 0; i < cpus; i++) {
+        sort_chunk_claim(&job->chunks[i]);
+    }
+    for (int i = 0; i < cpus; i++) {
+        while (atomic_load(&job->chunks[i].state) != CHUNK_DONE) sched_yield();
+    }
+
+    // Merge runs pairwise, alternating between data and tmp
+    size_t* bounds = malloc((cpus + 1) * sizeof(size_t));
+    if (!bounds) {
+        parallel_sort_release(job);
+        free(tmp);
+        wyn_sort_int(data, count);
+        return;
+    }
+    for (int i = 0; i < cpus; i++) bounds[i] = (size_t)(job->chunks[i].data - data);
+    bounds[cpus] = count;
+    parallel_sort_release(job);
+
+    int runs = cpus;
+    int* src = data;
+    int* dst = tmp;
+    while (runs > 1) {
+        int out_runs = 0;
+        for (int r = 0; r < runs; r += 2) {
+            size_t start = bounds[r];
+            if (r + 1 < runs) {
+                size_t mid = bounds[r + 1];
+                size_t end = bounds[r + 2];
+                merge_ints(src + start, mid - start, src + mid, end - mid, dst + start);
+            } else {
+                memcpy(dst + start, src + start, (bounds[r + 1] - start) * sizeof(int));
+            }
+            bounds[out_runs++] = start;
+        }
+        bounds[out_runs] = count;
+        runs = out_runs;
+        int* swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != data) memcpy(data, src, count * sizeof(int));
+
+    free(bounds);
+    free(tmp);
+}
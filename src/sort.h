@@ -0,0 +1,42 @@
+#ifndef WYN_SORT_H
+#define WYN_SORT_H
+
+#include <stddef.h>
+
+// Sorting runtime: pattern-defeating quicksort for typed element arrays,
+// a stable merge sort for arbitrary elements, and a parallel sort that
+// splits large int arrays across the spawn scheduler.
+
+// Arrays at least this long are sorted in parallel when more than one CPU is online
+#define WYN_SORT_PARALLEL_THRESHOLD 65536
+
+// Comparator for sort_by: negative, zero or positive like strcmp
+typedef int (*WynIntCompare)(int a, int b);
+
+// Comparator for arbitrary elements
+typedef int (*WynSortCompare)(const void* a, const void* b, void* ctx);
+
+// Type of the key field for struct-by-key sorting
+typedef enum {
+    WYN_SORT_KEY_INT,
+    WYN_SORT_KEY_FLOAT,
+    WYN_SORT_KEY_STRING
+} WynSortKeyType;
+
+// Unstable, O(n log n) worst case
+void wyn_sort_int(int* data, size_t count);
+void wyn_sort_float(double* data, size_t count);
+void wyn_sort_str(const char** data, size_t count);
+void wyn_sort_int_by(int* data, size_t count, WynIntCompare cmp);
+
+// Stable merge sort
+void wyn_sort_stable(void* base, size_t count, size_t size, WynSortCompare cmp, void* ctx);
+void wyn_sort_int_stable_by(int* data, size_t count, WynIntCompare cmp);
+
+// Stable sort of structs by the field at key_offset
+void wyn_sort_by_key(void* base, size_t count, size_t size, size_t key_offset, WynSortKeyType key_type);
+
+// Parallel int sort; falls back to wyn_sort_int below the threshold or on one CPU
+void wyn_sort_int_parallel(int* data, size_t count);
+
+#endif
@@ -0,0 +1,267 @@
+// Pattern-defeating quicksort, instantiated by sort.c once per element type.
+// Before including, define:
+//   SORT_NAME             prefix for the generated functions
+//   SORT_TYPE             element type
+//   SORT_CTX              type of the comparison context
+//   SORT_LESS(ctx, a, b)  strict weak ordering on two elements (may evaluate
+//                         its arguments more than once)
+//
+// Insertion sort for small ranges, ninther pivots, partitioning that detects
+// already-sorted and many-equal inputs, and a heapsort fallback once too many
+// unbalanced partitions bound the worst case to O(n log n).
+
+#define SORT_CAT_(a, b) a##_##b
+#define SORT_CAT(a, b) SORT_CAT_(a, b)
+#define SORT_FN(name) SORT_CAT(SORT_NAME, name)
+
+#define SORT_INSERTION_THRESHOLD 24
+#define SORT_NINTHER_THRESHOLD 128
+#define SORT_PARTIAL_INSERTION_LIMIT 8
+
+static inline void SORT_FN(swap)(SORT_TYPE* a, SORT_TYPE* b) {
+    SORT_TYPE tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+static inline void SORT_FN(sort2)(SORT_TYPE* a, SORT_TYPE* b, SORT_CTX ctx) {
+    (void)ctx;
+    if (SORT_LESS(ctx, *b, *a)) SORT_FN(swap)(a, b);
+}
+
+static inline void SORT_FN(sort3)(SORT_TYPE* a, SORT_TYPE* b, SORT_TYPE* c, SORT_CTX ctx) {
+    SORT_FN(sort2)(a, b, ctx);
+    SORT_FN(sort2)(b, c, ctx);
+    SORT_FN(sort2)(a, b, ctx);
+}
+
+static void SORT_FN(insertion)(SORT_TYPE* begin, SORT_TYPE* end, SORT_CTX ctx) {
+    (void)ctx;
+    if (begin == end) return;
+    for (SORT_TYPE* cur = begin + 1; cur != end; cur++) {
+        SORT_TYPE* sift = cur;
+        SORT_TYPE* sift_1 = cur - 1;
+        if (SORT_LESS(ctx, *sift, *sift_1)) {
+            SORT_TYPE tmp = *sift;
+            do {
+                *sift-- = *sift_1;
+            } while (sift != begin && (--sift_1, SORT_LESS(ctx, tmp, *sift_1)));
+            *sift = tmp;
+        }
+    }
+}
+
+// Requires an element before begin that is not greater than any in the range
+static void SORT_FN(unguarded_insertion)(SORT_TYPE* begin, SORT_TYPE* end, SORT_CTX ctx) {
+    (void)ctx;
+    if (begin == end) return;
+    for (SORT_TYPE* cur = begin + 1; cur != end; cur++) {
+        SORT_TYPE* sift = cur;
+        SORT_TYPE* sift_1 = cur - 1;
+        if (SORT_LESS(ctx, *sift, *sift_1)) {
+            SORT_TYPE tmp = *sift;
+            do {
+                *sift-- = *sift_1;
+            } while ((--sift_1, SORT_LESS(ctx, tmp, *sift_1)));
+            *sift = tmp;
+        }
+    }
+}
+
+// Insertion sort that gives up after moving a few elements
+static bool SORT_FN(partial_insertion)(SORT_TYPE* begin, SORT_TYPE* end, SORT_CTX ctx) {
+    (void)ctx;
+    if (begin == end) return true;
+    size_t limit = 0;
+    for (SORT_TYPE* cur = begin + 1; cur != end; cur++) {
+        if (limit > SORT_PARTIAL_INSERTION_LIMIT) return false;
+        SORT_TYPE* sift = cur;
+        SORT_TYPE* sift_1 = cur - 1;
+        if (SORT_LESS(ctx, *sift, *sift_1)) {
+            SORT_TYPE tmp = *sift;
+            do {
+                *sift-- = *sift_1;
+            } while (sift != begin && (--sift_1, SORT_LESS(ctx, tmp, *sift_1)));
+            *sift = tmp;
+            limit += (size_t)(cur - sift);
+        }
+    }
+    return true;
+}
+
+static void SORT_FN(sift_down)(SORT_TYPE* data, size_t root, size_t count, SORT_CTX ctx) {
+    (void)ctx;
+    for (;;) {
+        size_t child = 2 * root + 1;
+        if (child >= count) return;
+        if (child + 1 < count && SORT_LESS(ctx, data[child], data[child + 1])) child++;
+        if (!SORT_LESS(ctx, data[root], data[child])) return;
+        SORT_FN(swap)(&data[root], &data[child]);
+        root = child;
+    }
+}
+
+static void SORT_FN(heapsort)(SORT_TYPE* begin, SORT_TYPE* end, SORT_CTX ctx) {
+    size_t count = (size_t)(end - begin);
+    for (size_t i = count / 2; i-- > 0;) {
+        SORT_FN(sift_down)(begin, i, count, ctx);
+    }
+    for (size_t i = count; i-- > 1;) {
+        SORT_FN(swap)(&begin[0], &begin[i]);
+        SORT_FN(sift_down)(begin, 0, i, ctx);
+    }
+}
+
+// Partition around *begin; elements equal to the pivot go right.
+// Sets *already_partitioned if no swaps were needed.
+static SORT_TYPE* SORT_FN(partition_right)(SORT_TYPE* begin, SORT_TYPE* end, SORT_CTX ctx,
+                                           bool* already_partitioned) {
+    (void)ctx;
+    SORT_TYPE pivot = *begin;
+    SORT_TYPE* first = begin;
+    SORT_TYPE* last = end;
+
+    // The median-of-three guarantees a sentinel on both sides
+    while ((++first, SORT_LESS(ctx, *first, pivot)));
+    if (first - 1 == begin) {
+        while (first < last && !(--last, SORT_LESS(ctx, *last, pivot)));
+    } else {
+        while (!(--last, SORT_LESS(ctx, *last, pivot)));
+    }
+
+    *already_partitioned = first >= last;
+    while (first < last) {
+        SORT_FN(swap)(first, last);
+        while ((++first, SORT_LESS(ctx, *first, pivot)));
+        while (!(--last, SORT_LESS(ctx, *last, pivot)));
+    }
+
+    SORT_TYPE* pivot_pos = first - 1;
+    *begin = *pivot_pos;
+    *pivot_pos = pivot;
+    return pivot_pos;
+}
+
+// Partition around *begin; elements equal to the pivot go left.
+// Used when the pivot equals the element before the range, so the left part
+// is all equal and needs no further sorting.
+static SORT_TYPE* SORT_FN(partition_left)(SORT_TYPE* begin, SORT_TYPE* end, SORT_CTX ctx) {
+    (void)ctx;
+    SORT_TYPE pivot = *begin;
+    SORT_TYPE* first = begin;
+    SORT_TYPE* last = end;
+
+    while ((--last, SORT_LESS(ctx, pivot, *last)));
+    if (last + 1 == end) {
+        while (first < last && !(++first, SORT_LESS(ctx, pivot, *first)));
+    } else {
+        while (!(++first, SORT_LESS(ctx, pivot, *first)));
+    }
+
+    while (first < last) {
+        SORT_FN(swap)(first, last);
+        while ((--last, SORT_LESS(ctx, pivot, *last)));
+        while (!(++first, SORT_LESS(ctx, pivot, *first)));
+    }
+
+    SORT_TYPE* pivot_pos = last;
+    *begin = *pivot_pos;
+    *pivot_pos = pivot;
+    return pivot_pos;
+}
+
+static void SORT_FN(loop)(SORT_TYPE* begin, SORT_TYPE* end, SORT_CTX ctx, int bad_allowed, bool leftmost) {
+    for (;;) {
+        size_t size = (size_t)(end - begin);
+        if (size < SORT_INSERTION_THRESHOLD) {
+            if (leftmost) {
+                SORT_FN(insertion)(begin, end, ctx);
+            } else {
+                SORT_FN(unguarded_insertion)(begin, end, ctx);
+            }
+            return;
+        }
+
+        // Move the median of three (or ninther) to begin
+        size_t s2 = size / 2;
+        if (size > SORT_NINTHER_THRESHOLD) {
+            SORT_FN(sort3)(begin, begin + s2, end - 1, ctx);
+            SORT_FN(sort3)(begin + 1, begin + (s2 - 1), end - 2, ctx);
+            SORT_FN(sort3)(begin + 2, begin + (s2 + 1), end - 3, ctx);
+            SORT_FN(sort3)(begin + (s2 - 1), begin + s2, begin + (s2 + 1), ctx);
+            SORT_FN(swap)(begin, begin + s2);
+        } else {
+            SORT_FN(sort3)(begin + s2, begin, end - 1, ctx);
+        }
+
+        // Many equal elements: everything equal to the pivot is already in place
+        if (!leftmost && !SORT_LESS(ctx, *(begin - 1), *begin)) {
+            begin = SORT_FN(partition_left)(begin, end, ctx) + 1;
+            continue;
+        }
+
+        bool already_partitioned;
+        SORT_TYPE* pivot_pos = SORT_FN(partition_right)(begin, end, ctx, &already_partitioned);
+
+        size_t l_size = (size_t)(pivot_pos - begin);
+        size_t r_size = (size_t)(end - (pivot_pos + 1));
+        bool highly_unbalanced = l_size < size / 8 || r_size < size / 8;
+
+        if (highly_unbalanced) {
+            if (--bad_allowed == 0) {
+                SORT_FN(heapsort)(begin, end, ctx);
+                return;
+            }
+
+            // Break up patterns that defeat the pivot choice
+            if (l_size >= SORT_INSERTION_THRESHOLD) {
+                SORT_FN(swap)(begin, begin + l_size / 4);
+                SORT_FN(swap)(pivot_pos - 1, pivot_pos - l_size / 4);
+                if (l_size > SORT_NINTHER_THRESHOLD) {
+                    SORT_FN(swap)(begin + 1, begin + (l_size / 4 + 1));
+                    SORT_FN(swap)(begin + 2, begin + (l_size / 4 + 2));
+                    SORT_FN(swap)(pivot_pos - 2, pivot_pos - (l_size / 4 + 1));
+                    SORT_FN(swap)(pivot_pos - 3, pivot_pos - (l_size / 4 + 2));
+                }
+            }
+            if (r_size >= SORT_INSERTION_THRESHOLD) {
+                SORT_FN(swap)(pivot_pos + 1, pivot_pos + (1 + r_size / 4));
+                SORT_FN(swap)(end - 1, end - r_size / 4);
+                if (r_size > SORT_NINTHER_THRESHOLD) {
+                    SORT_FN(swap)(pivot_pos + 2, pivot_pos + (2 + r_size / 4));
+                    SORT_FN(swap)(pivot_pos + 3, pivot_pos + (3 + r_size / 4));
+                    SORT_FN(swap)(end - 2, end - (1 + r_size / 4));
+                    SORT_FN(swap)(end - 3, end - (2 + r_size / 4));
+                }
+            }
+        } else if (already_partitioned &&
+                   SORT_FN(partial_insertion)(begin, pivot_pos, ctx) &&
+                   SORT_FN(partial_insertion)(pivot_pos + 1, end, ctx)) {
+            // Input was (nearly) sorted
+            return;
+        }
+
+        // Recurse into the left part, loop on the right
+        SORT_FN(loop)(begin, pivot_pos, ctx, bad_allowed, leftmost);
+        begin = pivot_pos + 1;
+        leftmost = false;
+    }
+}
+
+static void SORT_FN(pdqsort)(SORT_TYPE* data, size_t count, SORT_CTX ctx) {
+    if (count < 2) return;
+    int log2 = 0;
+    for (size_t n = count; n > 1; n >>= 1) log2++;
+    SORT_FN(loop)(data, data + count, ctx, log2, true);
+}
+
+#undef SORT_CAT_
+#undef SORT_CAT
+#undef SORT_FN
+#undef SORT_INSERTION_THRESHOLD
+#undef SORT_NINTHER_THRESHOLD
+#undef SORT_PARTIAL_INSERTION_LIMIT
+#undef SORT_NAME
+#undef SORT_TYPE
+#undef SORT_CTX
+#undef SORT_LESS
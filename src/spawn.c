@@ -9,204 +9,570 @@
 #ifndef _WIN32
 #include <unistd.h>
 #include <sched.h>
+#include <time.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
 #ifdef __APPLE__
 #include <sys/sysctl.h>
 #endif
 #else
 #include <windows.h>
-// Windows doesn't have usleep, use Sleep (milliseconds) instead
-#define usleep(us) Sleep((us) / 1000)
 // Windows doesn't have sched_yield, use SwitchToThread
 #define sched_yield() SwitchToThread()
 #endif
 
-WynScheduler* global_scheduler = NULL;
+// Scheduling: every worker owns a Chase-Lev deque ("Dynamic Circular
+// Work-Stealing Deque", with the C11 orderings from Le et al. 2013). The
+// owner pushes and pops at the bottom without locks; thieves take from the
+// top with a CAS. Spawns issued on a worker go to that worker's deque, so
+// fan-out stays local and LIFO; spawns from other threads go through a
+// mutex-protected injection queue. Idle workers steal from random victims.
+//
+// Parking: a worker that finds nothing spins for up to WYN_SCHED_SPIN_US,
+// then registers as a sleeper, re-checks every queue and blocks on its own
+// futex word (a condvar where futexes are unavailable). Enqueues publish the
+// spawn and wake one sleeper if there are any (local pushes only on the
+// empty-to-non-empty edge, with successful thieves passing the wakeup on).
+// A seq_cst fence on both sides guarantees that either the sleeper sees the
+// spawn or the enqueuer sees the sleeper, so no wakeup is lost and parked
+// workers cost nothing.
 
-// Spawn pool for memory reuse (per-worker to reduce contention)
+#define DEQUE_INITIAL_SIZE 256
 #define SPAWN_POOL_SIZE 256
+#define DEFAULT_SPIN_US 20
+
+enum { PARK_AWAKE = 0, PARK_SLEEPING = 1 };
+
 typedef struct {
-    WynSpawn* pool[SPAWN_POOL_SIZE];
-    _Atomic int count;
-} SpawnPool;
+    _Alignas(64) _Atomic uint32_t state;  // PARK_AWAKE or PARK_SLEEPING
+#ifndef __linux__
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+#endif
+} WorkerPark;
 
-static SpawnPool worker_pools[64];  // Max 64 workers
+typedef struct DequeBuffer {
+    long size;                     // Power of two
+    struct DequeBuffer* retired;   // Older buffers, freed with the deque
+    _Atomic(WynSpawn*) slots[];
+} DequeBuffer;
 
-// Allocate spawn (from thread-local pool)
-static inline WynSpawn* alloc_spawn(int worker_id) {
-    if (worker_id < 0 || worker_id >= 64) {
-        return malloc(sizeof(WynSpawn));
-    }
-    
-    SpawnPool* pool = &worker_pools[worker_id];
-    int count = atomic_load(&pool->count);
-    
-    if (count > 0) {
-        int idx = atomic_fetch_sub(&pool->count, 1) - 1;
-        if (idx >= 0 && idx < SPAWN_POOL_SIZE) {
-            return pool->pool[idx];
-        }
+typedef struct {
+    _Atomic long top;
+    char pad0[64 - sizeof(long)];  // Keep thieves' and owner's ends on separate lines
+    _Atomic long bottom;
+    _Atomic(DequeBuffer*) buffer;
+    char pad1[64 - sizeof(long) - sizeof(void*)];
+} WynDeque;
+
+typedef struct {
+    WynScheduler* sched;
+    int id;
+} WorkerContext;
+
+struct WynScheduler {
+    WynDeque* deques;          // Per-worker deques
+    WorkerContext* contexts;
+    pthread_t* workers;        // Worker threads
+    int num_workers;
+    _Atomic int running;
+    pthread_mutex_t global_lock;  // Guards the injection queue
+    WynSpawn* inject_head;
+    WynSpawn* inject_tail;
+    _Atomic int inject_count;
+    WorkerPark* parks;         // Per-worker parking slots
+    _Atomic int sleepers;      // Workers registered as parked
+    _Atomic unsigned wake_cursor;
+    uint64_t spin_ns;          // How long an idle worker spins before parking
+};
+
+WynScheduler* global_scheduler = NULL;
+
+// Scheduler and worker index of the current thread, or NULL/-1 outside a pool
+static _Thread_local WynScheduler* current_sched = NULL;
+static _Thread_local int current_worker = -1;
+static _Thread_local uint64_t steal_rng = 0;
+
+// Innermost `scope { ... }` active on this thread; spawned functions run
+// inside the scope they were spawned from
+static _Thread_local WynSpawnScope* current_scope = NULL;
+
+// Recycled spawn records; each thread keeps its own free list
+static _Thread_local WynSpawn* spawn_pool = NULL;
+static _Thread_local int spawn_pool_count = 0;
+
+static inline WynSpawn* alloc_spawn(void) {
+    WynSpawn* spawn = spawn_pool;
+    if (spawn) {
+        spawn_pool = spawn->next;
+        spawn_pool_count--;
+        return spawn;
     }
     return malloc(sizeof(WynSpawn));
 }
 
-// Free spawn (return to thread-local pool)
-static inline void free_spawn(WynSpawn* spawn, int worker_id) {
-    if (worker_id < 0 || worker_id >= 64) {
-        free(spawn);
+static inline void free_spawn(WynSpawn* spawn) {
+    if (spawn_pool_count < SPAWN_POOL_SIZE) {
+        spawn->next = spawn_pool;
+        spawn_pool = spawn;
+        spawn_pool_count++;
         return;
     }
-    
-    SpawnPool* pool = &worker_pools[worker_id];
-    int count = atomic_load(&pool->count);
-    
-    if (count < SPAWN_POOL_SIZE) {
-        int idx = atomic_fetch_add(&pool->count, 1);
-        if (idx < SPAWN_POOL_SIZE) {
-            pool->pool[idx] = spawn;
+    free(spawn);
+}
+
+static void drain_spawn_pool(void) {
+    while (spawn_pool) {
+        WynSpawn* next = spawn_pool->next;
+        free(spawn_pool);
+        spawn_pool = next;
+    }
+    spawn_pool_count = 0;
+}
+
+static DequeBuffer* deque_buffer_new(long size) {
+    DequeBuffer* buf = malloc(sizeof(DequeBuffer) + (size_t)size * sizeof(_Atomic(WynSpawn*)));
+    buf->size = size;
+    buf->retired = NULL;
+    return buf;
+}
+
+static void deque_init(WynDeque* dq) {
+    atomic_init(&dq->top, 0);
+    atomic_init(&dq->bottom, 0);
+    atomic_init(&dq->buffer, deque_buffer_new(DEQUE_INITIAL_SIZE));
+}
+
+static void deque_destroy(WynDeque* dq) {
+    DequeBuffer* buf = atomic_load_explicit(&dq->buffer, memory_order_relaxed);
+    long t = atomic_load_explicit(&dq->top, memory_order_relaxed);
+    long b = atomic_load_explicit(&dq->bottom, memory_order_relaxed);
+    for (long i = t; i < b; i++) {
+        free(atomic_load_explicit(&buf->slots[i & (buf->size - 1)], memory_order_relaxed));
+    }
+    while (buf) {
+        DequeBuffer* older = buf->retired;
+        free(buf);
+        buf = older;
+    }
+}
+
+// Owner only. Thieves may still be reading the old buffer, so it is kept
+// on the retired list until the deque is destroyed.
+static DequeBuffer* deque_grow(WynDeque* dq, DequeBuffer* old, long t, long b) {
+    DequeBuffer* buf = deque_buffer_new(old->size * 2);
+    for (long i = t; i < b; i++) {
+        WynSpawn* s = atomic_load_explicit(&old->slots[i & (old->size - 1)], memory_order_relaxed);
+        atomic_store_explicit(&buf->slots[i & (buf->size - 1)], s, memory_order_relaxed);
+    }
+    buf->retired = old;
+    atomic_store_explicit(&dq->buffer, buf, memory_order_release);
+    return buf;
+}
+
+// Owner only; returns nonzero if the deque looked empty before the push
+static int deque_push(WynDeque* dq, WynSpawn* spawn) {
+    long b = atomic_load_explicit(&dq->bottom, memory_order_relaxed);
+    long t = atomic_load_explicit(&dq->top, memory_order_acquire);
+    DequeBuffer* buf = atomic_load_explicit(&dq->buffer, memory_order_relaxed);
+    if (b - t > buf->size - 1) {
+        buf = deque_grow(dq, buf, t, b);
+    }
+    atomic_store_explicit(&buf->slots[b & (buf->size - 1)], spawn, memory_order_relaxed);
+    atomic_store_explicit(&dq->bottom, b + 1, memory_order_release);
+    return b == t;
+}
+
+// Owner only; newest first
+static WynSpawn* deque_pop(WynDeque* dq) {
+    long b = atomic_load_explicit(&dq->bottom, memory_order_relaxed) - 1;
+    DequeBuffer* buf = atomic_load_explicit(&dq->buffer, memory_order_relaxed);
+    atomic_store_explicit(&dq->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long t = atomic_load_explicit(&dq->top, memory_order_relaxed);
+    if (t > b) {
+        // Empty
+        atomic_store_explicit(&dq->bottom, b + 1, memory_order_relaxed);
+        return NULL;
+    }
+    WynSpawn* spawn = atomic_load_explicit(&buf->slots[b & (buf->size - 1)], memory_order_relaxed);
+    if (t == b) {
+        // Last element: race thieves for it
+        if (!atomic_compare_exchange_strong_explicit(&dq->top, &t, t + 1,
+                                                     memory_order_seq_cst, memory_order_relaxed)) {
+            spawn = NULL;
+        }
+        atomic_store_explicit(&dq->bottom, b + 1, memory_order_relaxed);
+    }
+    return spawn;
+}
+
+// Any thread; oldest first. Returns NULL when empty or when losing a race.
+static WynSpawn* deque_steal(WynDeque* dq) {
+    long t = atomic_load_explicit(&dq->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&dq->bottom, memory_order_acquire);
+    if (t >= b) return NULL;
+    DequeBuffer* buf = atomic_load_explicit(&dq->buffer, memory_order_acquire);
+    WynSpawn* spawn = atomic_load_explicit(&buf->slots[t & (buf->size - 1)], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&dq->top, &t, t + 1,
+                                                 memory_order_seq_cst, memory_order_relaxed)) {
+        return NULL;
+    }
+    return spawn;
+}
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __asm__ __volatile__("pause" ::: "memory");
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield" ::: "memory");
+#endif
+}
+
+static inline uint64_t now_ns(void) {
+#ifdef _WIN32
+    return (uint64_t)GetTickCount64() * 1000000ULL;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static void park_init(WorkerPark* p) {
+    atomic_init(&p->state, PARK_AWAKE);
+#ifndef __linux__
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->cond, NULL);
+#endif
+}
+
+static void park_destroy(WorkerPark* p) {
+#ifndef __linux__
+    pthread_mutex_destroy(&p->lock);
+    pthread_cond_destroy(&p->cond);
+#else
+    (void)p;
+#endif
+}
+
+// Block until someone moves the slot out of PARK_SLEEPING
+static void park_block(WorkerPark* p) {
+#ifdef __linux__
+    while (atomic_load_explicit(&p->state, memory_order_acquire) == PARK_SLEEPING) {
+        syscall(SYS_futex, &p->state, FUTEX_WAIT_PRIVATE, PARK_SLEEPING, NULL, NULL, 0);
+    }
+#else
+    pthread_mutex_lock(&p->lock);
+    while (atomic_load_explicit(&p->state, memory_order_acquire) == PARK_SLEEPING) {
+        pthread_cond_wait(&p->cond, &p->lock);
+    }
+    pthread_mutex_unlock(&p->lock);
+#endif
+}
+
+static void park_unblock(WorkerPark* p) {
+#ifdef __linux__
+    syscall(SYS_futex, &p->state, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#else
+    pthread_mutex_lock(&p->lock);
+    pthread_cond_signal(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+#endif
+}
+
+// Take a sleeping worker's slot; whoever wins the CAS owns the wakeup and
+// the sleeper count decrement
+static inline int park_claim(WynScheduler* sched, WorkerPark* p) {
+    uint32_t expected = PARK_SLEEPING;
+    if (!atomic_compare_exchange_strong_explicit(&p->state, &expected, PARK_AWAKE,
+                                                 memory_order_acq_rel, memory_order_relaxed)) {
+        return 0;
+    }
+    atomic_fetch_sub_explicit(&sched->sleepers, 1, memory_order_relaxed);
+    return 1;
+}
+
+static void wake_one(WynScheduler* sched) {
+    int n = sched->num_workers;
+    unsigned start = atomic_fetch_add_explicit(&sched->wake_cursor, 1, memory_order_relaxed);
+    for (int i = 0; i < n; i++) {
+        WorkerPark* p = &sched->parks[(start + (unsigned)i) % (unsigned)n];
+        if (atomic_load_explicit(&p->state, memory_order_relaxed) == PARK_SLEEPING &&
+            park_claim(sched, p)) {
+            park_unblock(p);
             return;
         }
     }
-    free(spawn);
+}
+
+// Called after publishing a spawn
+static inline void notify_work(WynScheduler* sched) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&sched->sleepers, memory_order_acquire) > 0) wake_one(sched);
+}
+
+static int has_work(WynScheduler* sched) {
+    if (atomic_load_explicit(&sched->inject_count, memory_order_relaxed) > 0) return 1;
+    for (int i = 0; i < sched->num_workers; i++) {
+        WynDeque* dq = &sched->deques[i];
+        if (atomic_load_explicit(&dq->top, memory_order_relaxed) <
+            atomic_load_explicit(&dq->bottom, memory_order_relaxed)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void worker_park(WynScheduler* sched, int worker_id) {
+    WorkerPark* p = &sched->parks[worker_id];
+    atomic_store_explicit(&p->state, PARK_SLEEPING, memory_order_relaxed);
+    atomic_fetch_add_explicit(&sched->sleepers, 1, memory_order_seq_cst);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (has_work(sched) || !atomic_load_explicit(&sched->running, memory_order_relaxed)) {
+        // If the claim fails an enqueuer already woke us
+        park_claim(sched, p);
+        return;
+    }
+    park_block(p);
+}
+
+#define INJECT_BATCH 32
+
+// Take a single spawn from the injection queue, for threads without a deque
+static WynSpawn* inject_pop(WynScheduler* sched) {
+    if (atomic_load_explicit(&sched->inject_count, memory_order_relaxed) == 0) return NULL;
+    pthread_mutex_lock(&sched->global_lock);
+    WynSpawn* spawn = sched->inject_head;
+    if (spawn) {
+        sched->inject_head = spawn->next;
+        if (!sched->inject_head) sched->inject_tail = NULL;
+        atomic_fetch_sub_explicit(&sched->inject_count, 1, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&sched->global_lock);
+    return spawn;
+}
+
+// Take a batch from the injection queue: the first spawn is returned, the
+// rest go onto this worker's deque where idle workers can steal them
+static WynSpawn* inject_take(WynScheduler* sched, int worker_id) {
+    if (atomic_load_explicit(&sched->inject_count, memory_order_relaxed) == 0) return NULL;
+    pthread_mutex_lock(&sched->global_lock);
+    WynSpawn* first = sched->inject_head;
+    WynSpawn* last = first;
+    int taken = first ? 1 : 0;
+    while (last && last->next && taken < INJECT_BATCH) {
+        last = last->next;
+        taken++;
+    }
+    if (first) {
+        sched->inject_head = last->next;
+        if (!sched->inject_head) sched->inject_tail = NULL;
+        last->next = NULL;
+        atomic_fetch_sub_explicit(&sched->inject_count, taken, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&sched->global_lock);
+    if (!first) return NULL;
+
+    // Oldest first once popped LIFO: push the batch in reverse
+    WynSpawn* rest[INJECT_BATCH];
+    int n = 0;
+    for (WynSpawn* s = first->next; s; s = s->next) rest[n++] = s;
+    if (n > 0) {
+        while (n > 0) deque_push(&sched->deques[worker_id], rest[--n]);
+        notify_work(sched);
+    }
+    return first;
+}
+
+static inline uint32_t next_random(void) {
+    // xorshift64*
+    uint64_t x = steal_rng;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    steal_rng = x;
+    return (uint32_t)((x * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+// Visit every other worker once, starting from a random victim
+static WynSpawn* steal_any(WynScheduler* sched, int self) {
+    int n = sched->num_workers;
+    if (n <= 1) return NULL;
+    int start = (int)(next_random() % (uint32_t)n);
+    for (int i = 0; i < n; i++) {
+        int victim = (start + i) % n;
+        if (victim == self) continue;
+        WynDeque* dq = &sched->deques[victim];
+        WynSpawn* spawn = deque_steal(dq);
+        if (spawn) {
+            // More left behind: let another sleeper help drain it
+            if (atomic_load_explicit(&dq->top, memory_order_relaxed) <
+                atomic_load_explicit(&dq->bottom, memory_order_relaxed)) {
+                notify_work(sched);
+            }
+            return spawn;
+        }
+    }
+    return NULL;
+}
+
+static WynSpawn* find_work(WynScheduler* sched, int worker_id) {
+    WynSpawn* spawn = deque_pop(&sched->deques[worker_id]);
+    if (!spawn) spawn = inject_take(sched, worker_id);
+    if (!spawn) spawn = steal_any(sched, worker_id);
+    return spawn;
+}
+
+static inline void run_spawn(WynSpawn* spawn) {
+    WynSpawnFunc func = spawn->func;
+    void* arg = spawn->arg;
+    free_spawn(spawn);
+    func(arg);
 }
 
 // Initialize scheduler with N worker threads
 WynScheduler* wyn_scheduler_init(int num_workers) {
-    WynScheduler* sched = malloc(sizeof(WynScheduler));
+    if (num_workers < 1) num_workers = 1;
+    WynScheduler* sched = calloc(1, sizeof(WynScheduler));
     sched->num_workers = num_workers;
-    sched->running = 1;
-    
-    // Allocate per-worker queues and locks
-    sched->queues = calloc(num_workers, sizeof(WynSpawn*));
-    sched->locks = malloc(num_workers * sizeof(pthread_mutex_t));
+    atomic_init(&sched->running, 1);
+    atomic_init(&sched->inject_count, 0);
+    atomic_init(&sched->sleepers, 0);
+    atomic_init(&sched->wake_cursor, 0);
+
+    long spin_us = DEFAULT_SPIN_US;
+    const char* spin_env = getenv("WYN_SCHED_SPIN_US");
+    if (spin_env && *spin_env) {
+        spin_us = strtol(spin_env, NULL, 10);
+        if (spin_us < 0) spin_us = 0;
+    }
+    sched->spin_ns = (uint64_t)spin_us * 1000ULL;
+
+    sched->deques = aligned_alloc(64, ((num_workers * sizeof(WynDeque) + 63) / 64) * 64);
+    sched->parks = aligned_alloc(64, ((num_workers * sizeof(WorkerPark) + 63) / 64) * 64);
+    sched->contexts = malloc(num_workers * sizeof(WorkerContext));
     sched->workers = malloc(num_workers * sizeof(pthread_t));
-    
+
     pthread_mutex_init(&sched->global_lock, NULL);
-    
+
     for (int i = 0; i < num_workers; i++) {
-        pthread_mutex_init(&sched->locks[i], NULL);
+        deque_init(&sched->deques[i]);
+        park_init(&sched->parks[i]);
+        sched->contexts[i].sched = sched;
+        sched->contexts[i].id = i;
     }
-    
+
     return sched;
 }
 
 // Worker thread function
 static void* worker_thread(void* arg) {
-    WynScheduler* sched = (WynScheduler*)arg;
-    int worker_id = 0;
+    WorkerContext* ctx = (WorkerContext*)arg;
+    WynScheduler* sched = ctx->sched;
+    int worker_id = ctx->id;
+    current_sched = sched;
+    current_worker = worker_id;
+    steal_rng = 0x9E3779B97F4A7C15ULL * (uint64_t)(worker_id + 1);
     
-    // Find our worker ID
-    for (int i = 0; i < sched->num_workers; i++) {
-        if (pthread_equal(sched->workers[i], pthread_self())) {
-            worker_id = i;
-            break;
-        }
-    }
+    uint64_t idle_since = 0;
+    unsigned spins = 0;
     
-    int idle_spins = 0;
-    
-    while (sched->running) {
-        WynSpawn* spawn = NULL;
-        
-        // Try to get spawn from our queue (fast path)
-        pthread_mutex_lock(&sched->locks[worker_id]);
-        if (sched->queues[worker_id]) {
-            spawn = sched->queues[worker_id];
-            sched->queues[worker_id] = spawn->next;
-        }
-        pthread_mutex_unlock(&sched->locks[worker_id]);
+    while (atomic_load_explicit(&sched->running, memory_order_relaxed)) {
+        WynSpawn* spawn = find_work(sched, worker_id);
         
-        // Work stealing: try other queues
-        if (!spawn) {
-            for (int i = 1; i < sched->num_workers; i++) {
-                int target = (worker_id + i) % sched->num_workers;
-                
-                pthread_mutex_lock(&sched->locks[target]);
-                if (sched->queues[target]) {
-                    spawn = sched->queues[target];
-                    sched->queues[target] = spawn->next;
-                    pthread_mutex_unlock(&sched->locks[target]);
-                    break;
-                }
-                pthread_mutex_unlock(&sched->locks[target]);
-            }
-        }
-        
-        // Execute spawn
         if (spawn) {
-            spawn->func(spawn->arg);
-            free_spawn(spawn, worker_id);  // Return to worker's pool
-            idle_spins = 0;
-        } else {
-            // Adaptive backoff: spin → yield → sleep
-            if (idle_spins < 100) {
-                // Spin (no syscall) - architecture-specific
-                for (int i = 0; i < 10; i++) {
-                    #if defined(__x86_64__) || defined(__i386__)
-                    __asm__ __volatile__("pause" ::: "memory");
-                    #elif defined(__aarch64__) || defined(__arm__)
-                    __asm__ __volatile__("yield" ::: "memory");
-                    #else
-                    // Fallback for other architectures
-                    volatile int dummy = 0; (void)dummy;
-                    #endif
-                }
-                idle_spins++;
-            } else if (idle_spins < 200) {
-                // Yield to other threads
-                sched_yield();
-                idle_spins++;
-            } else {
-                // Sleep (longer idle)
-                usleep(100);  // 0.1ms
-                idle_spins = 0;
+            run_spawn(spawn);
+            idle_since = 0;
+            continue;
+        }
+
+        // Spin briefly so bursts are picked up without a syscall, then park
+        if (sched->spin_ns > 0) {
+            uint64_t now = now_ns();
+            if (idle_since == 0) idle_since = now;
+            if (now - idle_since < sched->spin_ns) {
+                cpu_relax();
+                if ((++spins & 63) == 0) sched_yield();
+                continue;
             }
         }
+        worker_park(sched, worker_id);
+        idle_since = 0;
     }
     
+    drain_spawn_pool();
+    current_sched = NULL;
+    current_worker = -1;
     return NULL;
 }
 
 // Start worker threads
 void wyn_scheduler_start(WynScheduler* sched) {
     for (int i = 0; i < sched->num_workers; i++) {
-        pthread_create(&sched->workers[i], NULL, worker_thread, sched);
+        pthread_create(&sched->workers[i], NULL, worker_thread, &sched->contexts[i]);
     }
 }
 
-// Enqueue a spawn (optimized)
+// Enqueue a spawn: onto the current worker's own deque when called from a
+// spawn, otherwise through the injection queue
 void wyn_scheduler_enqueue(WynScheduler* sched, WynSpawnFunc func, void* arg) {
-    // Round-robin assignment to workers
-    static _Atomic int next_worker = 0;
-    int worker_id = atomic_fetch_add(&next_worker, 1) % sched->num_workers;
-    
-    WynSpawn* spawn = alloc_spawn(worker_id);  // Use worker's pool
+    WynSpawn* spawn = alloc_spawn();
     spawn->func = func;
     spawn->arg = arg;
     spawn->next = NULL;
     
-    pthread_mutex_lock(&sched->locks[worker_id]);
-    spawn->next = sched->queues[worker_id];
-    sched->queues[worker_id] = spawn;
-    pthread_mutex_unlock(&sched->locks[worker_id]);
+    spawn->worker_id = current_worker;
+    if (current_sched == sched) {
+        // Only the first spawn into an empty deque wakes a sleeper; thieves
+        // wake the next one while work remains. The owner itself drains
+        // anything left, so skipping the wakeup never strands a spawn.
+        if (deque_push(&sched->deques[current_worker], spawn)) notify_work(sched);
+        return;
+    }
+    
+    pthread_mutex_lock(&sched->global_lock);
+    if (sched->inject_tail) {
+        sched->inject_tail->next = spawn;
+    } else {
+        sched->inject_head = spawn;
+    }
+    sched->inject_tail = spawn;
+    atomic_fetch_add_explicit(&sched->inject_count, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&sched->global_lock);
+    notify_work(sched);
 }
 
 // Shutdown scheduler
 void wyn_scheduler_shutdown(WynScheduler* sched) {
-    sched->running = 0;
+    atomic_store(&sched->running, 0);
+    for (int i = 0; i < sched->num_workers; i++) {
+        if (park_claim(sched, &sched->parks[i])) park_unblock(&sched->parks[i]);
+    }
     
     // Wait for workers
     for (int i = 0; i < sched->num_workers; i++) {
         pthread_join(sched->workers[i], NULL);
     }
     
-    // Cleanup
+    // Cleanup, dropping spawns that never ran
     for (int i = 0; i < sched->num_workers; i++) {
-        pthread_mutex_destroy(&sched->locks[i]);
+        deque_destroy(&sched->deques[i]);
+        park_destroy(&sched->parks[i]);
+    }
+    while (sched->inject_head) {
+        WynSpawn* next = sched->inject_head->next;
+        free(sched->inject_head);
+        sched->inject_head = next;
     }
     pthread_mutex_destroy(&sched->global_lock);
     
-    free(sched->queues);
-    free(sched->locks);
+    free(sched->deques);
+    free(sched->parks);
+    free(sched->contexts);
     free(sched->workers);
     free(sched);
 }
@@ -238,6 +604,154 @@ void wyn_yield() {
     sched_yield();
 }
 
+// Join handles and scopes
+
+enum { SPAWN_RUNNING = 0, SPAWN_WAITING = 1, SPAWN_DONE = 2, SPAWN_JOINED = 3 };
+
+#define JOIN_SPINS 128
+
+#ifndef __linux__
+// Waiters on handles and scopes share one condvar; wakeups are rare enough
+// (only after the spin phase) that broadcasting is cheap
+static pthread_mutex_t join_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t join_cond = PTHREAD_COND_INITIALIZER;
+#endif
+
+// Sleep while *addr == value
+static void wait_on(_Atomic uint32_t* addr, uint32_t value) {
+#ifdef __linux__
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+#else
+    pthread_mutex_lock(&join_lock);
+    while (atomic_load_explicit(addr, memory_order_acquire) == value) {
+        pthread_cond_wait(&join_cond, &join_lock);
+    }
+    pthread_mutex_unlock(&join_lock);
+#endif
+}
+
+// The scope behind addr may already be gone by the time this runs; a futex
+// wake on a stale address is harmless, and the fallback never touches it
+static void wake_all(_Atomic uint32_t* addr) {
+#ifdef __linux__
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT32_MAX, NULL, NULL, 0);
+#else
+    (void)addr;
+    pthread_mutex_lock(&join_lock);
+    pthread_cond_broadcast(&join_cond);
+    pthread_mutex_unlock(&join_lock);
+#endif
+}
+
+// Run one queued spawn on the calling thread while it waits for a result.
+// Workers use their own deque first; other threads take from the injection
+// queue or steal. Returns 0 if nothing was runnable.
+static int help_run_one(void) {
+    WynScheduler* sched = current_sched ? current_sched : global_scheduler;
+    if (!sched) return 0;
+    WynSpawn* spawn;
+    if (current_sched == sched) {
+        spawn = find_work(sched, current_worker);
+    } else {
+        if (!steal_rng) steal_rng = 0x9E3779B97F4A7C15ULL ^ (uint64_t)(uintptr_t)&steal_rng;
+        spawn = inject_pop(sched);
+        if (!spawn) spawn = steal_any(sched, -1);
+    }
+    if (!spawn) return 0;
+    run_spawn(spawn);
+    return 1;
+}
+
+static void spawn_trampoline(void* arg) {
+    WynSpawnHandle* handle = (WynSpawnHandle*)arg;
+    WynSpawnScope* scope = handle->scope;
+    WynSpawnScope* saved = current_scope;
+    current_scope = scope;
+    handle->run(handle);
+    current_scope = saved;
+
+    if (atomic_exchange_explicit(&handle->state, SPAWN_DONE, memory_order_acq_rel) == SPAWN_WAITING) {
+        wake_all(&handle->state);
+    }
+    wyn_spawn_release(handle);
+    if (scope && atomic_fetch_sub_explicit(&scope->pending, 1, memory_order_acq_rel) == 1) {
+        wake_all(&scope->pending);
+    }
+}
+
+void* wyn_spawn_record(size_t size) {
+    WynSpawnHandle* handle = malloc(size < sizeof(WynSpawnHandle) ? sizeof(WynSpawnHandle) : size);
+    atomic_init(&handle->state, SPAWN_RUNNING);
+    atomic_init(&handle->refs, 2);
+    handle->scope = NULL;
+    handle->run = NULL;
+    return handle;
+}
+
+void wyn_spawn_submit(WynSpawnHandle* handle, WynSpawnFunc run) {
+    handle->run = run;
+    handle->scope = current_scope;
+    if (handle->scope) atomic_fetch_add_explicit(&handle->scope->pending, 1, memory_order_relaxed);
+    wyn_spawn(spawn_trampoline, handle);
+}
+
+// Joining again finds the handle joined and returns at once: the result
+// stays in the record until the last reference is released
+void wyn_spawn_join(WynSpawnHandle* handle) {
+    unsigned spins = 0;
+    uint32_t state;
+    while ((state = atomic_load_explicit(&handle->state, memory_order_acquire)) < SPAWN_DONE) {
+        if (help_run_one()) {
+            spins = 0;
+            continue;
+        }
+        if (++spins < JOIN_SPINS) {
+            cpu_relax();
+            continue;
+        }
+        // Fails harmlessly if the spawn finished or another joiner got here first
+        uint32_t expected = SPAWN_RUNNING;
+        atomic_compare_exchange_strong_explicit(&handle->state, &expected, SPAWN_WAITING,
+                                                memory_order_acq_rel, memory_order_acquire);
+        wait_on(&handle->state, SPAWN_WAITING);
+        spins = 0;
+    }
+    if (state == SPAWN_DONE) atomic_store_explicit(&handle->state, SPAWN_JOINED, memory_order_relaxed);
+}
+
+void wyn_spawn_retain(WynSpawnHandle* handle) {
+    atomic_fetch_add_explicit(&handle->refs, 1, memory_order_relaxed);
+}
+
+void wyn_spawn_release(WynSpawnHandle* handle) {
+    if (atomic_fetch_sub_explicit(&handle->refs, 1, memory_order_acq_rel) == 1) {
+        free(handle);
+    }
+}
+
+void wyn_scope_enter(WynSpawnScope* scope) {
+    atomic_init(&scope->pending, 0);
+    scope->parent = current_scope;
+    current_scope = scope;
+}
+
+void wyn_scope_leave(WynSpawnScope* scope) {
+    current_scope = scope->parent;
+    unsigned spins = 0;
+    for (;;) {
+        uint32_t pending = atomic_load_explicit(&scope->pending, memory_order_acquire);
+        if (pending == 0) break;
+        if (help_run_one()) {
+            spins = 0;
+        } else if (++spins < JOIN_SPINS) {
+            cpu_relax();
+        } else {
+            wait_on(&scope->pending, pending);
+            spins = 0;
+        }
+    }
+}
+
 // Task coordinator implementation
 WynTask* wyn_task_new(int capacity) {
     WynTask* task = malloc(sizeof(WynTask));
@@ -4,12 +4,15 @@
 #define WYN_SPAWN_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
 #include <pthread.h>
 
 // Forward declarations
 typedef struct WynSpawn WynSpawn;
 typedef struct WynTask WynTask;
 typedef struct WynScheduler WynScheduler;
+typedef struct WynSpawnScope WynSpawnScope;
 
 // Spawn function type
 typedef void (*WynSpawnFunc)(void*);
@@ -21,6 +24,24 @@ struct WynSpawn {
     int worker_id;
 };
 
+// Join handle for `spawn f(args)`. Generated code embeds it as the first
+// member of a per-function record that also holds the captured arguments and
+// the result slot; the record is freed when both the spawn and its owner
+// have released it.
+typedef struct {
+    _Atomic uint32_t state;    // Running, running with a joiner waiting, done, joined
+    _Atomic int refs;
+    WynSpawnScope* scope;      // Scope the spawn was made in, if any
+    WynSpawnFunc run;          // Receives the record
+} WynSpawnHandle;
+
+// `scope { ... }`: spawns made inside the block, including those made by
+// the spawned functions themselves, are counted and waited for on exit
+struct WynSpawnScope {
+    _Atomic uint32_t pending;
+    WynSpawnScope* parent;
+};
+
 // Task coordinator (for communication between spawns)
 struct WynTask {
     void** buffer;
@@ -34,17 +55,7 @@ struct WynTask {
     int closed;
 };
 
-// Work-stealing scheduler
-struct WynScheduler {
-    WynSpawn** queues;       // Per-worker queues
-    pthread_mutex_t* locks;  // Per-worker locks
-    pthread_t* workers;      // Worker threads
-    int num_workers;
-    int running;
-    pthread_mutex_t global_lock;
-};
-
-// Global scheduler
+// Global work-stealing scheduler (per-worker Chase-Lev deques; see spawn.c)
 extern WynScheduler* global_scheduler;
 
 // Scheduler functions
@@ -57,6 +68,23 @@ void wyn_scheduler_enqueue(WynScheduler* sched, WynSpawnFunc func, void* arg);
 void wyn_spawn(WynSpawnFunc func, void* arg);
 void wyn_yield();
 
+// Join handles: allocate a record of `size` bytes (header initialized, two
+// references), fill in the arguments, then submit it. join() waits for the
+// result, running queued spawns on the calling thread meanwhile; a handle
+// may be joined any number of times and keeps its result until released.
+// release() drops an owner's reference (without joining, for fire-and-forget
+// spawns); retain() adds one for a copied handle.
+void* wyn_spawn_record(size_t size);
+void wyn_spawn_submit(WynSpawnHandle* handle, WynSpawnFunc run);
+void wyn_spawn_join(WynSpawnHandle* handle);
+void wyn_spawn_retain(WynSpawnHandle* handle);
+void wyn_spawn_release(WynSpawnHandle* handle);
+
+// Structured scopes; wyn_scope_leave waits for every spawn made inside and
+// has the signature __attribute__((cleanup)) expects
+void wyn_scope_enter(WynSpawnScope* scope);
+void wyn_scope_leave(WynSpawnScope* scope);
+
 // Task coordinator functions (communication)
 WynTask* wyn_task_new(int capacity);
 void wyn_task_send(WynTask* task, void* value);
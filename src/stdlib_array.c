@@ -1,5 +1,6 @@
 #include <stdlib.h>
 #include <string.h>
+#include "sort.h"
 
 // Array module - comprehensive array manipulation functions
 
@@ -76,31 +77,10 @@ void wyn_array_reverse(int* arr, int len) {
     }
 }
 
-// Sort: quicksort implementation
-static void quicksort(int* arr, int low, int high) {
-    if (low < high) {
-        int pivot = arr[high];
-        int i = low - 1;
-        for (int j = low; j < high; j++) {
-            if (arr[j] < pivot) {
-                i++;
-                int temp = arr[i];
-                arr[i] = arr[j];
-                arr[j] = temp;
-            }
-        }
-        int temp = arr[i + 1];
-        arr[i + 1] = arr[high];
-        arr[high] = temp;
-        int pi = i + 1;
-        quicksort(arr, low, pi - 1);
-        quicksort(arr, pi + 1, high);
-    }
-}
-
+// Sort: pattern-defeating quicksort (see sort.c)
 void wyn_array_sort(int* arr, int len) {
     if (len > 1) {
-        quicksort(arr, 0, len - 1);
+        wyn_sort_int(arr, (size_t)len);
     }
 }
 
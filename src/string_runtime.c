@@ -1,25 +1,389 @@
+#ifndef _WIN32
+#define _DEFAULT_SOURCE
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
 #include "string_memory.h"
 #include "string_runtime.h"
 #include "arc_runtime.h"
 #include "wyn_string.h"
 
-// Simple string concatenation for codegen (returns malloc'd string)
+// Runtime string heap.
+//
+// Every size class (32 bytes to 1GB, powers of two) owns a region of one
+// reserved address range, and blocks are aligned to their size within the
+// region. That makes "does this char* carry a header?" a range check plus an
+// alignment check on the pointer alone, so literals, stack buffers and C
+// strings are recognized without reading the memory in front of them.
+// Regions are sized from the class table: STR_REGION_MIN_BLOCKS blocks each,
+// rounded up to a 64MB granule, about 5GB of address space in all. A class
+// whose region is full, or a heap that could not be reserved, hands out
+// plain malloc'd strings instead.
+// A block is a StrHeader followed by the bytes and a NUL; a string of up to
+// 15 bytes fits in one 32-byte block with its header. Freed blocks of up to
+// 2KB go to per-thread caches from the memory pool, larger ones to a locked
+// list per class.
+
+#define STR_MIN_CLASS 5
+#define STR_MAX_CLASS 30
+#define STR_CLASSES (STR_MAX_CLASS - STR_MIN_CLASS + 1)
+#define STR_GRANULE_SHIFT 26     // Regions are whole 64MB granules
+#define STR_REGION_MIN_BLOCKS 2
+#define STR_MAX_GRANULES (STR_CLASSES + ((size_t)1 << (STR_MAX_CLASS + 2 - STR_GRANULE_SHIFT)))
+#define STR_RELEASE_CLASS 16    // Freed blocks this large give their pages back
+#define STR_CACHED_CLASSES 7    // 32 bytes to 2KB
+
+typedef struct {
+    size_t len;
+    _Atomic uint32_t refs;  // Counted like WynObject, ARC_SHARED_FLAG included
+    uint32_t flags;
+} StrHeader;
+
+// Set by wyn_str_append on buffers only its caller's local can reach
+#define STR_OWNED 1u
+
+static _Atomic(char*) str_base;  // NULL when the range could not be reserved
+static size_t str_region_start[STR_CLASSES + 1];    // Offsets; the last is the total
+static uint8_t str_granule_class[STR_MAX_GRANULES];
+static size_t str_granules;
+static _Atomic size_t str_bump[STR_CLASSES];
+static _Atomic(void*) str_free_list[STR_CLASSES];
+static pthread_mutex_t str_lock[STR_CLASSES];
+static int str_cache[STR_CACHED_CLASSES];     // Pool cache ids, -1 when unavailable
+static pthread_once_t str_once = PTHREAD_ONCE_INIT;
+
+static void str_heap_init(void) {
+#if !defined(_WIN32) && UINTPTR_MAX > 0xFFFFFFFFu && defined(MAP_NORESERVE)
+    size_t granule = (size_t)1 << STR_GRANULE_SHIFT;
+    for (int i = 0; i < STR_CLASSES; i++) {
+        size_t want = ((size_t)STR_REGION_MIN_BLOCKS << (i + STR_MIN_CLASS));
+        size_t count = (want + granule - 1) >> STR_GRANULE_SHIFT;
+        for (size_t g = 0; g < count; g++) str_granule_class[str_granules + g] = (uint8_t)i;
+        str_region_start[i] = str_granules << STR_GRANULE_SHIFT;
+        str_granules += count;
+    }
+    size_t reserve = str_granules << STR_GRANULE_SHIFT;
+    str_region_start[STR_CLASSES] = reserve;
+    void* base = mmap(NULL, reserve, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) return;
+    for (int i = 0; i < STR_CLASSES; i++) pthread_mutex_init(&str_lock[i], NULL);
+    for (int i = 0; i < STR_CACHED_CLASSES; i++) {
+        str_cache[i] = wyn_pool_cache_register((size_t)1 << (i + STR_MIN_CLASS));
+    }
+    atomic_store_explicit(&str_base, base, memory_order_release);
+#endif
+}
+
+static inline int str_heap_ready(void) {
+    pthread_once(&str_once, str_heap_init);
+    return atomic_load_explicit(&str_base, memory_order_relaxed) != NULL;
+}
+
+// Header of s if s is the start of a heap string, else NULL
+static inline StrHeader* str_header(const char* s) {
+    char* base = atomic_load_explicit(&str_base, memory_order_acquire);
+    if (!base || s < base + sizeof(StrHeader)) return NULL;
+    size_t offset = (size_t)(s - base);
+    size_t granule = offset >> STR_GRANULE_SHIFT;
+    if (granule >= str_granules) return NULL;
+    size_t index = str_granule_class[granule];
+    size_t in_region = offset - str_region_start[index];
+    size_t block_size = (size_t)1 << (index + STR_MIN_CLASS);
+    if ((in_region & (block_size - 1)) != sizeof(StrHeader)) return NULL;
+    if (in_region >= atomic_load_explicit(&str_bump[index], memory_order_acquire)) return NULL;
+    return (StrHeader*)(s - sizeof(StrHeader));
+}
+
+// Class index of a block or string inside the reserved range
+static inline size_t str_class_index(const char* p) {
+    size_t offset = (size_t)(p - atomic_load_explicit(&str_base, memory_order_relaxed));
+    return str_granule_class[offset >> STR_GRANULE_SHIFT];
+}
+
+static inline size_t str_capacity(const char* s) {
+    size_t index = str_class_index(s);
+    return ((size_t)1 << (index + STR_MIN_CLASS)) - sizeof(StrHeader) - 1;
+}
+
+// Block with room for capacity bytes plus the NUL; NULL if none fits
+static char* str_block_alloc(size_t capacity) {
+    size_t need = sizeof(StrHeader) + capacity + 1;
+    if (!str_heap_ready() || need > ((size_t)1 << STR_MAX_CLASS)) return NULL;
+    int cls = STR_MIN_CLASS;
+    while (((size_t)1 << cls) < need) cls++;
+    int index = cls - STR_MIN_CLASS;
+    size_t block_size = (size_t)1 << cls;
+    char* region = atomic_load_explicit(&str_base, memory_order_relaxed) + str_region_start[index];
+    size_t region_size = str_region_start[index + 1] - str_region_start[index];
+
+    if (index < STR_CACHED_CLASSES && str_cache[index] >= 0) {
+        char* block = wyn_pool_cache_pop(str_cache[index]);
+        if (block) return block;
+    } else if (atomic_load_explicit(&str_free_list[index], memory_order_relaxed)) {
+        pthread_mutex_lock(&str_lock[index]);
+        char* block = atomic_load_explicit(&str_free_list[index], memory_order_relaxed);
+        if (block) atomic_store_explicit(&str_free_list[index], *(void**)block, memory_order_relaxed);
+        pthread_mutex_unlock(&str_lock[index]);
+        if (block) return block;
+    }
+    size_t offset = atomic_fetch_add_explicit(&str_bump[index], block_size, memory_order_acq_rel);
+    if (offset + block_size > region_size) {
+        atomic_fetch_sub_explicit(&str_bump[index], block_size, memory_order_relaxed);
+        return NULL;
+    }
+    return region + offset;
+}
+
+static void str_block_free(char* block) {
+    size_t index = str_class_index(block);
+    int cls = (int)index + STR_MIN_CLASS;
+#ifndef _WIN32
+    if (cls >= STR_RELEASE_CLASS) {
+        // Keep the first page, which holds the free-list link
+        madvise(block + 4096, ((size_t)1 << cls) - 4096, MADV_DONTNEED);
+    }
+#else
+    (void)cls;
+#endif
+    if (index < STR_CACHED_CLASSES && str_cache[index] >= 0) {
+        wyn_pool_cache_push(str_cache[index], block);
+        return;
+    }
+    pthread_mutex_lock(&str_lock[index]);
+    *(void**)block = atomic_load_explicit(&str_free_list[index], memory_order_relaxed);
+    atomic_store_explicit(&str_free_list[index], block, memory_order_relaxed);
+    pthread_mutex_unlock(&str_lock[index]);
+}
+
+// Uninitialized string of len bytes with room to grow to capacity; falls back
+// to a plain malloc'd C string when the heap is unavailable
+static char* str_alloc(size_t len, size_t capacity) {
+    if (capacity < len) capacity = len;
+    char* block = str_block_alloc(capacity);
+    if (!block) {
+        char* plain = malloc(len + 1);
+        if (plain) plain[len] = '\0';
+        return plain;
+    }
+    StrHeader* header = (StrHeader*)block;
+    header->len = len;
+    atomic_init(&header->refs, 1);
+    header->flags = 0;
+    char* data = block + sizeof(StrHeader);
+    data[len] = '\0';
+    return data;
+}
+
+size_t wyn_str_len(const char* s) {
+    if (!s) return 0;
+    StrHeader* header = str_header(s);
+    return header ? header->len : strlen(s);
+}
+
+bool wyn_str_is_managed(const char* s) {
+    return str_header(s) != NULL;
+}
+
+const char* wyn_str_new(const char* data, size_t len) {
+    char* result = str_alloc(len, len);
+    if (result && len) memcpy(result, data, len);
+    return result;
+}
+
+const char* wyn_str_retain(const char* s) {
+    StrHeader* header = str_header(s);
+    if (header) wyn_arc_count_retain(&header->refs);
+    return s;
+}
+
+void wyn_str_release(const char* s) {
+    StrHeader* header = str_header(s);
+    if (header && wyn_arc_count_release(&header->refs)) {
+        str_block_free((char*)header);
+    }
+}
+
+const char* wyn_str_share(const char* s) {
+    StrHeader* header = str_header(s);
+    if (header) wyn_arc_count_share(&header->refs);
+    return s;
+}
+
+void wyn_str_free(const char* s) {
+    if (!s) return;
+    if (str_header(s)) {
+        wyn_str_release(s);
+    } else {
+        free((void*)s);
+    }
+}
+
+bool wyn_str_eq(const char* a, const char* b) {
+    if (a == b) return true;
+    if (!a || !b) return false;
+    StrHeader* ha = str_header(a);
+    StrHeader* hb = str_header(b);
+    if (ha && hb) return ha->len == hb->len && memcmp(a, b, ha->len) == 0;
+    return strcmp(a, b) == 0;
+}
+
+// Lengths of the first STR_PART_CACHE parts are kept from the sizing pass
+#define STR_PART_CACHE 16
+
+const char* wyn_str_append_n(const char* s, int count, const char* const* parts) {
+    if (!s) s = "";
+    size_t lens[STR_PART_CACHE];
+    size_t tail_len = 0;
+    for (int i = 0; i < count; i++) {
+        size_t n = wyn_str_len(parts[i]);
+        if (i < STR_PART_CACHE) lens[i] = n;
+        tail_len += n;
+    }
+    StrHeader* header = str_header(s);
+    bool owned = header && (header->flags & STR_OWNED) &&
+                 atomic_load_explicit(&header->refs, memory_order_acquire) == 1;
+    size_t len = header ? header->len : strlen(s);
+
+    char* result;
+    if (owned && len + tail_len <= str_capacity(s)) {
+        result = (char*)s;
+    } else {
+        // Grow geometrically so a loop of appends copies O(n) bytes in total
+        result = str_alloc(len + tail_len, (len + tail_len) * 2);
+        if (!result) return NULL;
+        memcpy(result, s, len);
+        StrHeader* grown = str_header(result);
+        if (grown) grown->flags |= STR_OWNED;
+    }
+    // A part may be s itself, so copy with memmove while result == s
+    char* cursor = result + len;
+    for (int i = 0; i < count; i++) {
+        if (!parts[i]) continue;
+        size_t n = i < STR_PART_CACHE ? lens[i] : wyn_str_len(parts[i]);
+        memmove(cursor, parts[i], n);
+        cursor += n;
+    }
+    *cursor = '\0';
+    if (result == s) {
+        header->len = len + tail_len;
+    } else if (owned) {
+        wyn_str_release(s);
+    }
+    return result;
+}
+
+const char* wyn_str_append(const char* s, const char* tail) {
+    return wyn_str_append_n(s, 1, &tail);
+}
+
+const char* wyn_str_concat_n(int count, const char* const* parts) {
+    size_t lens[STR_PART_CACHE];
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        size_t n = wyn_str_len(parts[i]);
+        if (i < STR_PART_CACHE) lens[i] = n;
+        total += n;
+    }
+    char* result = str_alloc(total, 0);
+    if (!result) return NULL;
+    char* cursor = result;
+    for (int i = 0; i < count; i++) {
+        if (!parts[i]) continue;
+        size_t n = i < STR_PART_CACHE ? lens[i] : wyn_str_len(parts[i]);
+        memcpy(cursor, parts[i], n);
+        cursor += n;
+    }
+    return result;
+}
+
+const char* wyn_str_from_int(char* buf, long long value) {
+    // Digits are written backwards from the end of the 24-byte buffer
+    char* p = buf + 23;
+    *p = '\0';
+    unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    do {
+        *--p = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (value < 0) *--p = '-';
+    return p;
+}
+
+// StringBuilder: the buffer is an owned heap string, so appends reuse the
+// in-place growth of wyn_str_append_n and finish() hands it over without a copy
+struct WynStringBuilder {
+    const char* data;
+};
+
+WynStringBuilder* StringBuilder_new(void) {
+    return calloc(1, sizeof(WynStringBuilder));
+}
+
+void StringBuilder_reserve(WynStringBuilder* sb, int capacity) {
+    if (!sb || capacity <= 0) return;
+    const char* data = sb->data ? sb->data : "";
+    StrHeader* header = str_header(data);
+    size_t len = header ? header->len : strlen(data);
+    if (header && (header->flags & STR_OWNED) && str_capacity(data) >= (size_t)capacity) return;
+    char* grown = str_alloc(len, (size_t)capacity);
+    if (!grown) return;
+    memcpy(grown, data, len);
+    StrHeader* grown_header = str_header(grown);
+    if (grown_header) grown_header->flags |= STR_OWNED;
+    if (sb->data) wyn_str_free(sb->data);
+    sb->data = grown;
+}
+
+void StringBuilder_append(WynStringBuilder* sb, const char* s) {
+    if (!sb) return;
+    const char* old = sb->data;
+    const char* grown = wyn_str_append_n(old, 1, &s);
+    if (!grown) return;
+    // A malloc'd buffer from the fallback path is never owned, so drop it here
+    if (old && grown != old && !str_header(old)) free((void*)old);
+    sb->data = grown;
+}
+
+int StringBuilder_len(WynStringBuilder* sb) {
+    return sb ? (int)wyn_str_len(sb->data) : 0;
+}
+
+const char* StringBuilder_finish(WynStringBuilder* sb) {
+    if (!sb || !sb->data) return wyn_str_new("", 0);
+    const char* result = sb->data;
+    // The caller may share the result, so it can no longer grow in place
+    StrHeader* header = str_header(result);
+    if (header) header->flags &= ~STR_OWNED;
+    sb->data = NULL;
+    return result;
+}
+
+void StringBuilder_free(WynStringBuilder* sb) {
+    if (!sb) return;
+    if (sb->data) wyn_str_free(sb->data);
+    free(sb);
+}
+
+// String concatenation for codegen; both lengths are O(1) for heap strings
 const char* wyn_string_concat_safe(const char* left, const char* right) {
     if (!left || !right) return NULL;
     
-    size_t left_len = strlen(left);
-    size_t right_len = strlen(right);
-    size_t total_len = left_len + right_len;
+    size_t left_len = wyn_str_len(left);
+    size_t right_len = wyn_str_len(right);
     
-    char* result = malloc(total_len + 1);
+    char* result = str_alloc(left_len + right_len, 0);
     if (!result) return NULL;
     
     memcpy(result, left, left_len);
     memcpy(result + left_len, right, right_len);
-    result[total_len] = '\0';
     
     return result;
 }
@@ -59,7 +423,7 @@ int wyn_string_compare_safe(const char* a, const char* b) {
 
 // String length for generated code
 size_t wyn_string_length_safe(const char* str) {
-    return str ? strlen(str) : 0;
+    return wyn_str_len(str);
 }
 
 // String contains check for generated code
@@ -71,8 +435,8 @@ bool wyn_string_contains_safe(const char* haystack, const char* needle) {
 // String starts with check
 bool wyn_string_starts_with_safe(const char* str, const char* prefix) {
     if (!str || !prefix) return false;
-    size_t prefix_len = strlen(prefix);
-    size_t str_len = strlen(str);
+    size_t prefix_len = wyn_str_len(prefix);
+    size_t str_len = wyn_str_len(str);
     if (prefix_len > str_len) return false;
     return memcmp(str, prefix, prefix_len) == 0;
 }
@@ -80,8 +444,8 @@ bool wyn_string_starts_with_safe(const char* str, const char* prefix) {
 // String ends with check
 bool wyn_string_ends_with_safe(const char* str, const char* suffix) {
     if (!str || !suffix) return false;
-    size_t suffix_len = strlen(suffix);
-    size_t str_len = strlen(str);
+    size_t suffix_len = wyn_str_len(suffix);
+    size_t str_len = wyn_str_len(str);
     if (suffix_len > str_len) return false;
     return memcmp(str + str_len - suffix_len, suffix, suffix_len) == 0;
 }
@@ -90,18 +454,11 @@ bool wyn_string_ends_with_safe(const char* str, const char* suffix) {
 const char* wyn_string_substring_safe(const char* str, size_t start, size_t end) {
     if (!str) return NULL;
     
-    size_t str_len = strlen(str);
+    size_t str_len = wyn_str_len(str);
     if (start >= str_len || start >= end) return NULL;
     if (end > str_len) end = str_len;
     
-    size_t sub_len = end - start;
-    char* result = malloc(sub_len + 1);
-    if (!result) return NULL;
-    
-    memcpy(result, str + start, sub_len);
-    result[sub_len] = '\0';
-    
-    return result;
+    return wyn_str_new(str + start, end - start);
 }
 
 // String replace operation (simple version - replaces first occurrence)
@@ -6,6 +6,43 @@
 
 // Runtime support functions for safe string operations in generated code
 
+// Runtime strings. Strings built at run time carry a header with their
+// length, capacity and reference count in front of the bytes; the pointer
+// itself is a NUL-terminated C string, so it can be handed to C as is.
+// Literals and strings from C have no header: every function below accepts
+// them and falls back to strlen, retain/release ignore them.
+size_t wyn_str_len(const char* s);
+bool wyn_str_is_managed(const char* s);
+const char* wyn_str_new(const char* data, size_t len);
+const char* wyn_str_retain(const char* s);
+void wyn_str_release(const char* s);
+// Marks s as reachable from another thread: its count turns atomic and it is
+// never appended to in place again
+const char* wyn_str_share(const char* s);
+// Release a heap string, free() anything else
+void wyn_str_free(const char* s);
+bool wyn_str_eq(const char* a, const char* b);
+// s + tail. Appends in place when s came from an earlier wyn_str_append and
+// nothing else holds it, which codegen only arranges for append-only locals.
+const char* wyn_str_append(const char* s, const char* tail);
+// s followed by every part, with the same in-place rule as wyn_str_append
+const char* wyn_str_append_n(const char* s, int count, const char* const* parts);
+// All parts joined with one sizing pass and one allocation; codegen lowers
+// `a + b + c` chains and interpolated strings to this
+const char* wyn_str_concat_n(int count, const char* const* parts);
+// Decimal text of value, written into buf (at least 24 bytes); no allocation
+const char* wyn_str_from_int(char* buf, long long value);
+
+// StringBuilder for strings built up in loops
+typedef struct WynStringBuilder WynStringBuilder;
+WynStringBuilder* StringBuilder_new(void);
+void StringBuilder_reserve(WynStringBuilder* sb, int capacity);
+void StringBuilder_append(WynStringBuilder* sb, const char* s);
+int StringBuilder_len(WynStringBuilder* sb);
+// The built string; the builder is left empty and can be reused
+const char* StringBuilder_finish(WynStringBuilder* sb);
+void StringBuilder_free(WynStringBuilder* sb);
+
 // Safe string operations for codegen
 const char* wyn_string_concat_safe(const char* left, const char* right);
 const char* wyn_string_get_cstr(void* str);
@@ -272,18 +272,18 @@ bool wyn_is_standard_trait(Token trait_name) {
 // T3.2.3: Automatically implement standard traits for basic types
 void wyn_implement_standard_traits_for_basic_types(void) {
     // Define basic type tokens
-    Token int_type = {TOKEN_IDENT, "int", 3, 0};
-    Token float_type = {TOKEN_IDENT, "float", 5, 0};
-    Token string_type = {TOKEN_IDENT, "string", 6, 0};
-    Token bool_type = {TOKEN_IDENT, "bool", 4, 0};
+    Token int_type = {TOKEN_IDENT, "int", 3, 0, 0};
+    Token float_type = {TOKEN_IDENT, "float", 5, 0, 0};
+    Token string_type = {TOKEN_IDENT, "string", 6, 0, 0};
+    Token bool_type = {TOKEN_IDENT, "bool", 4, 0, 0};
     
     // Define trait tokens
-    Token eq_trait = {TOKEN_IDENT, "Eq", 2, 0};
-    Token ord_trait = {TOKEN_IDENT, "Ord", 3, 0};
-    Token clone_trait = {TOKEN_IDENT, "Clone", 5, 0};
-    Token copy_trait = {TOKEN_IDENT, "Copy", 4, 0};
-    Token display_trait = {TOKEN_IDENT, "Display", 7, 0};
-    Token debug_trait = {TOKEN_IDENT, "Debug", 5, 0};
+    Token eq_trait = {TOKEN_IDENT, "Eq", 2, 0, 0};
+    Token ord_trait = {TOKEN_IDENT, "Ord", 3, 0, 0};
+    Token clone_trait = {TOKEN_IDENT, "Clone", 5, 0, 0};
+    Token copy_trait = {TOKEN_IDENT, "Copy", 4, 0, 0};
+    Token display_trait = {TOKEN_IDENT, "Display", 7, 0, 0};
+    Token debug_trait = {TOKEN_IDENT, "Debug", 5, 0, 0};
     
     // Implement traits for int
     wyn_register_trait_impl(eq_trait, int_type, NULL, 0);
@@ -359,13 +359,13 @@ bool wyn_can_derive_trait(Token type_name, Token trait_name) {
 // T3.2.3: Standard Traits - Create standard trait definitions
 void wyn_register_standard_traits(void) {
     // Create standard trait tokens
-    Token eq_trait = {TOKEN_IDENT, "Eq", 2, 0};
-    Token ord_trait = {TOKEN_IDENT, "Ord", 3, 0};
-    Token clone_trait = {TOKEN_IDENT, "Clone", 5, 0};
-    Token copy_trait = {TOKEN_IDENT, "Copy", 4, 0};
-    Token display_trait = {TOKEN_IDENT, "Display", 7, 0};
-    Token debug_trait = {TOKEN_IDENT, "Debug", 5, 0};
-    Token iterator_trait = {TOKEN_IDENT, "Iterator", 8, 0};
+    Token eq_trait = {TOKEN_IDENT, "Eq", 2, 0, 0};
+    Token ord_trait = {TOKEN_IDENT, "Ord", 3, 0, 0};
+    Token clone_trait = {TOKEN_IDENT, "Clone", 5, 0, 0};
+    Token copy_trait = {TOKEN_IDENT, "Copy", 4, 0, 0};
+    Token display_trait = {TOKEN_IDENT, "Display", 7, 0, 0};
+    Token debug_trait = {TOKEN_IDENT, "Debug", 5, 0, 0};
+    Token iterator_trait = {TOKEN_IDENT, "Iterator", 8, 0, 0};
     
     // Register Eq trait
     TraitStmt eq_stmt = {0};
@@ -376,7 +376,7 @@ void wyn_register_standard_traits(void) {
     eq_stmt.methods = malloc(sizeof(FnStmt*));
     eq_stmt.method_has_default = malloc(sizeof(bool));
     eq_stmt.methods[0] = malloc(sizeof(FnStmt));
-    eq_stmt.methods[0]->name = (Token){TOKEN_IDENT, "eq", 2, 0};
+    eq_stmt.methods[0]->name = (Token){TOKEN_IDENT, "eq", 2, 0, 0};
     eq_stmt.method_has_default[0] = false;
     wyn_register_trait(&eq_stmt);
     
@@ -389,7 +389,7 @@ void wyn_register_standard_traits(void) {
     ord_stmt.methods = malloc(sizeof(FnStmt*));
     ord_stmt.method_has_default = malloc(sizeof(bool));
     ord_stmt.methods[0] = malloc(sizeof(FnStmt));
-    ord_stmt.methods[0]->name = (Token){TOKEN_IDENT, "cmp", 3, 0};
+    ord_stmt.methods[0]->name = (Token){TOKEN_IDENT, "cmp", 3, 0, 0};
     ord_stmt.method_has_default[0] = false;
     wyn_register_trait(&ord_stmt);
     
@@ -402,7 +402,7 @@ void wyn_register_standard_traits(void) {
     clone_stmt.methods = malloc(sizeof(FnStmt*));
     clone_stmt.method_has_default = malloc(sizeof(bool));
     clone_stmt.methods[0] = malloc(sizeof(FnStmt));
-    clone_stmt.methods[0]->name = (Token){TOKEN_IDENT, "clone", 5, 0};
+    clone_stmt.methods[0]->name = (Token){TOKEN_IDENT, "clone", 5, 0, 0};
     clone_stmt.method_has_default[0] = false;
     wyn_register_trait(&clone_stmt);
     
@@ -425,7 +425,7 @@ void wyn_register_standard_traits(void) {
     display_stmt.methods = malloc(sizeof(FnStmt*));
     display_stmt.method_has_default = malloc(sizeof(bool));
     display_stmt.methods[0] = malloc(sizeof(FnStmt));
-    display_stmt.methods[0]->name = (Token){TOKEN_IDENT, "to_string", 9, 0};
+    display_stmt.methods[0]->name = (Token){TOKEN_IDENT, "to_string", 9, 0, 0};
     display_stmt.method_has_default[0] = false;
     wyn_register_trait(&display_stmt);
     
@@ -438,7 +438,7 @@ void wyn_register_standard_traits(void) {
     debug_stmt.methods = malloc(sizeof(FnStmt*));
     debug_stmt.method_has_default = malloc(sizeof(bool));
     debug_stmt.methods[0] = malloc(sizeof(FnStmt));
-    debug_stmt.methods[0]->name = (Token){TOKEN_IDENT, "debug_string", 12, 0};
+    debug_stmt.methods[0]->name = (Token){TOKEN_IDENT, "debug_string", 12, 0, 0};
     debug_stmt.method_has_default[0] = true; // Has default implementation
     wyn_register_trait(&debug_stmt);
     
@@ -447,31 +447,31 @@ void wyn_register_standard_traits(void) {
     iterator_stmt.name = iterator_trait;
     iterator_stmt.type_param_count = 1;
     iterator_stmt.type_params = malloc(sizeof(Token));
-    iterator_stmt.type_params[0] = (Token){TOKEN_IDENT, "Item", 4, 0};
+    iterator_stmt.type_params[0] = (Token){TOKEN_IDENT, "Item", 4, 0, 0};
     iterator_stmt.method_count = 1;
     iterator_stmt.methods = malloc(sizeof(FnStmt*));
     iterator_stmt.method_has_default = malloc(sizeof(bool));
     iterator_stmt.methods[0] = malloc(sizeof(FnStmt));
-    iterator_stmt.methods[0]->name = (Token){TOKEN_IDENT, "next", 4, 0};
+    iterator_stmt.methods[0]->name = (Token){TOKEN_IDENT, "next", 4, 0, 0};
     iterator_stmt.method_has_default[0] = false;
     wyn_register_trait(&iterator_stmt);
     
     // T3.4.2: Register closure traits (Fn, FnMut, FnOnce)
-    Token fn_trait = {TOKEN_IDENT, "Fn", 2, 0};
-    Token fn_mut_trait = {TOKEN_IDENT, "FnMut", 5, 0};
-    Token fn_once_trait = {TOKEN_IDENT, "FnOnce", 6, 0};
+    Token fn_trait = {TOKEN_IDENT, "Fn", 2, 0, 0};
+    Token fn_mut_trait = {TOKEN_IDENT, "FnMut", 5, 0, 0};
+    Token fn_once_trait = {TOKEN_IDENT, "FnOnce", 6, 0, 0};
     
     // Register Fn trait
     TraitStmt fn_stmt = {0};
     fn_stmt.name = fn_trait;
     fn_stmt.type_param_count = 1;
     fn_stmt.type_params = malloc(sizeof(Token));
-    fn_stmt.type_params[0] = (Token){TOKEN_IDENT, "Args", 4, 0};
+    fn_stmt.type_params[0] = (Token){TOKEN_IDENT, "Args", 4, 0, 0};
     fn_stmt.method_count = 1;
     fn_stmt.methods = malloc(sizeof(FnStmt*));
     fn_stmt.method_has_default = malloc(sizeof(bool));
     fn_stmt.methods[0] = malloc(sizeof(FnStmt));
-    fn_stmt.methods[0]->name = (Token){TOKEN_IDENT, "call", 4, 0};
+    fn_stmt.methods[0]->name = (Token){TOKEN_IDENT, "call", 4, 0, 0};
     fn_stmt.method_has_default[0] = false;
     wyn_register_trait(&fn_stmt);
     
@@ -480,12 +480,12 @@ void wyn_register_standard_traits(void) {
     fn_mut_stmt.name = fn_mut_trait;
     fn_mut_stmt.type_param_count = 1;
     fn_mut_stmt.type_params = malloc(sizeof(Token));
-    fn_mut_stmt.type_params[0] = (Token){TOKEN_IDENT, "Args", 4, 0};
+    fn_mut_stmt.type_params[0] = (Token){TOKEN_IDENT, "Args", 4, 0, 0};
     fn_mut_stmt.method_count = 1;
     fn_mut_stmt.methods = malloc(sizeof(FnStmt*));
     fn_mut_stmt.method_has_default = malloc(sizeof(bool));
     fn_mut_stmt.methods[0] = malloc(sizeof(FnStmt));
-    fn_mut_stmt.methods[0]->name = (Token){TOKEN_IDENT, "call_mut", 8, 0};
+    fn_mut_stmt.methods[0]->name = (Token){TOKEN_IDENT, "call_mut", 8, 0, 0};
     fn_mut_stmt.method_has_default[0] = false;
     wyn_register_trait(&fn_mut_stmt);
     
@@ -494,12 +494,12 @@ void wyn_register_standard_traits(void) {
     fn_once_stmt.name = fn_once_trait;
     fn_once_stmt.type_param_count = 1;
     fn_once_stmt.type_params = malloc(sizeof(Token));
-    fn_once_stmt.type_params[0] = (Token){TOKEN_IDENT, "Args", 4, 0};
+    fn_once_stmt.type_params[0] = (Token){TOKEN_IDENT, "Args", 4, 0, 0};
     fn_once_stmt.method_count = 1;
     fn_once_stmt.methods = malloc(sizeof(FnStmt*));
     fn_once_stmt.method_has_default = malloc(sizeof(bool));
     fn_once_stmt.methods[0] = malloc(sizeof(FnStmt));
-    fn_once_stmt.methods[0]->name = (Token){TOKEN_IDENT, "call_once", 9, 0};
+    fn_once_stmt.methods[0]->name = (Token){TOKEN_IDENT, "call_once", 9, 0, 0};
     fn_once_stmt.method_has_default[0] = false;
     wyn_register_trait(&fn_once_stmt);
 }
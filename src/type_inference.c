@@ -64,7 +64,7 @@ Type* wyn_infer_variable_type(Expr* init_expr, SymbolTable* scope) {
                 if (element_type) {
                     inferred_type = make_type(TYPE_ARRAY);
                     inferred_type->array_type.element_type = element_type;  // Properly set element type
-                    inferred_type->name = (Token){TOKEN_IDENT, "array", 5, 0};
+                    inferred_type->name = (Token){TOKEN_IDENT, "array", 5, 0, 0};
                 }
             } else {
                 inferred_type = make_type(TYPE_ARRAY);
@@ -170,6 +170,11 @@ Type* wyn_infer_binary_result_type(Expr* binary_expr) {
     // For arithmetic operations, result type depends on operands
     WynTokenType op = binary_expr->binary.op.type;
     
+    // String concatenation, as typed by the checker
+    if (op == TOKEN_PLUS && binary_expr->expr_type && binary_expr->expr_type->kind == TYPE_STRING) {
+        return binary_expr->expr_type;
+    }
+    
     if (op == TOKEN_PLUS || op == TOKEN_MINUS || op == TOKEN_STAR || op == TOKEN_SLASH) {
         // Arithmetic operations - check operand types
         if (binary_expr->binary.left->type == EXPR_FLOAT || binary_expr->binary.right->type == EXPR_FLOAT) {
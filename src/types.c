@@ -106,6 +106,9 @@ static const MethodSignature method_signatures[] = {
     {"array", "index_of", "int", 1},
     {"array", "reverse", "void", 0},   // Mutates in place
     {"array", "sort", "void", 0},      // Mutates in place
+    {"array", "sort_by", "void", 1},          // sort_by(fn(a, b) -> int), unstable
+    {"array", "stable_sort_by", "void", 1},   // Stable variant of sort_by
+    {"array", "sort_by_key", "void", 1},      // Structs: sort_by_key("field"), stable
     {"array", "first", "int", 0},      // Returns first element
     {"array", "last", "int", 0},       // Returns last element
     {"array", "count", "int", 1},      // Count occurrences of value
@@ -187,6 +190,13 @@ static const MethodSignature method_signatures[] = {
     {"result", "map", "result", 1},    // Higher-order: map(fn) -> Result<U,E>
     {"result", "and_then", "result", 1}, // Higher-order: and_then(fn) -> Result<U,E>
     
+    // StringBuilder methods
+    {"builder", "append", "void", 1},
+    {"builder", "reserve", "void", 1},
+    {"builder", "len", "int", 0},
+    {"builder", "finish", "string", 0},
+    {"builder", "free", "void", 0},
+    
     // Sentinel - marks end of table
     {NULL, NULL, NULL, 0}
 };
@@ -221,6 +231,7 @@ const char* get_receiver_type_string(const Type* type) {
         case TYPE_SET: return "set";
         case TYPE_OPTIONAL: return "option";
         case TYPE_RESULT: return "result";
+        case TYPE_STRING_BUILDER: return "builder";
         case TYPE_ENUM:
             // Map enum names to method receiver types
             if (type->name.length == 6 && memcmp(type->name.start, "Option", 6) == 0) {
@@ -538,6 +549,16 @@ bool dispatch_method(const char* receiver_type, const char* method_name, int arg
             out->pass_by_ref = true;
             return true;
         }
+        if (strcmp(method_name, "sort_by") == 0 && arg_count == 1) {
+            out->c_function = "array_sort_by";
+            out->pass_by_ref = true;
+            return true;
+        }
+        if (strcmp(method_name, "stable_sort_by") == 0 && arg_count == 1) {
+            out->c_function = "array_stable_sort_by";
+            out->pass_by_ref = true;
+            return true;
+        }
         if (strcmp(method_name, "first") == 0 && arg_count == 0) {
             out->c_function = "array_first"; return true;
         }
@@ -633,13 +654,33 @@ bool dispatch_method(const char* receiver_type, const char* method_name, int arg
             out->c_function = "hashmap_len"; return true;
         }
         if (strcmp(method_name, "is_empty") == 0 && arg_count == 0) {
-            out->c_function = "wyn_hashmap_is_empty"; return true;
+            out->c_function = "map_is_empty"; return true;
         }
         if (strcmp(method_name, "clear") == 0 && arg_count == 0) {
-            out->c_function = "wyn_hashmap_clear"; return true;
+            out->c_function = "hashmap_clear"; return true;
+        }
+        if (strcmp(method_name, "free") == 0 && arg_count == 0) {
+            out->c_function = "hashmap_release"; return true;
+        }
+        return false;
+    }
+    
+    if (strcmp(receiver_type, "builder") == 0) {
+        // StringBuilder methods
+        if (strcmp(method_name, "append") == 0 && arg_count == 1) {
+            out->c_function = "StringBuilder_append"; return true;
+        }
+        if (strcmp(method_name, "reserve") == 0 && arg_count == 1) {
+            out->c_function = "StringBuilder_reserve"; return true;
+        }
+        if (strcmp(method_name, "len") == 0 && arg_count == 0) {
+            out->c_function = "StringBuilder_len"; return true;
+        }
+        if (strcmp(method_name, "finish") == 0 && arg_count == 0) {
+            out->c_function = "StringBuilder_finish"; return true;
         }
         if (strcmp(method_name, "free") == 0 && arg_count == 0) {
-            out->c_function = "hashmap_free"; return true;
+            out->c_function = "StringBuilder_free"; return true;
         }
         return false;
     }
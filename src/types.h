@@ -59,6 +59,9 @@ typedef enum {
     TYPE_UNION,     // T2.5.2: Union Type Support
     TYPE_RESULT,    // TASK-026: Result<T,E> Type Implementation
     TYPE_GENERIC,   // T3.1.2: Generic type parameter
+    TYPE_SPAWN,     // Join handle returned by `spawn f(...)`
+    TYPE_STRING_BUILDER,
+    TYPE_FUTURE,    // Result of an async fn or Async:: call, consumed by await
 } TypeKind;
 
 // Type already forward declared above
@@ -105,6 +108,15 @@ typedef struct {
     int variant_count; // Number of variants
 } EnumType;
 
+typedef struct {
+    Token fn_name;       // Spawned function; selects the generated record
+    Type* result_type;   // What join() returns
+} SpawnType;
+
+typedef struct {
+    Type* value_type;    // What await yields
+} FutureType;
+
 struct Type {
     TypeKind kind;
     Token name;
@@ -117,11 +129,14 @@ struct Type {
         UnionType union_type;        // T2.5.2: Union Type Support
         ResultType result_type;      // TASK-026: Result<T,E> Type Implementation
         EnumType enum_type;          // Enum type with variants
+        SpawnType spawn_type;        // Join handle from spawn
+        FutureType future_type;      // Pending async result
     };
 };
 
 typedef struct Symbol {
     Token name;
+    uint32_t id;                  // interned name
     Type* type;
     bool is_mutable;
     // T1.5.3: Function overloading support
@@ -129,16 +144,25 @@ typedef struct Symbol {
     char* mangled_name;           // Mangled name for code generation
 } Symbol;
 
+// Open-addressing slot mapping a name's hash to an entry (index + 1, 0 when empty)
+typedef struct {
+    uint32_t hash;
+    int entry;
+} NameSlot;
+
 typedef struct SymbolTable {
     Symbol* symbols;
     int count;
     int capacity;
     struct SymbolTable* parent;
+    NameSlot* index;        // built once the scope outgrows a linear scan
+    int index_capacity;     // power of two
 } SymbolTable;
 
 // Symbol table operations
 void add_symbol(SymbolTable* scope, Token name, Type* type, bool is_mutable);
 Symbol* find_symbol(SymbolTable* scope, Token name);
+void free_symbol_table(SymbolTable* scope);
 SymbolTable* get_global_scope(void);
 
 // T2.5.4: Type Inference Improvements
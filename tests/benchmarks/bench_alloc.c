@@ -0,0 +1,126 @@
+// Allocator throughput: alloc/free pairs per second from the size-class pool
+// and from malloc, on one thread, on several, and with blocks freed by a
+// different thread than the one that allocated them.
+//   make bench_alloc && ./tests/benchmarks/bench_alloc [threads]
+#define _POSIX_C_SOURCE 200809L
+#include "arc_runtime.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define OPS 4000000
+#define LIVE 256        // Blocks each thread keeps alive at once
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+typedef struct {
+    void* (*alloc)(size_t);
+    void (*release)(void*);
+} Allocator;
+
+// Mixed sizes in the range of ARC headers, small arrays and map slots
+static void churn(const Allocator* a, unsigned seed) {
+    void* live[LIVE] = {0};
+    for (int i = 0; i < OPS; i++) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned slot = (seed >> 8) % LIVE;
+        a->release(live[slot]);
+        size_t size = 16 + ((seed >> 16) % 6) * ((seed >> 20) % 2 ? 16 : 96);
+        live[slot] = a->alloc(size);
+        memset(live[slot], 0, 8);
+    }
+    for (int i = 0; i < LIVE; i++) a->release(live[i]);
+}
+
+typedef struct {
+    const Allocator* allocator;
+    unsigned seed;
+} ChurnArgs;
+
+static void* churn_thread(void* arg) {
+    ChurnArgs* args = arg;
+    churn(args->allocator, args->seed);
+    return NULL;
+}
+
+static double run_churn(const Allocator* a, int threads) {
+    pthread_t ids[64];
+    ChurnArgs args[64];
+    double begin = now_sec();
+    for (int t = 0; t < threads; t++) {
+        args[t] = (ChurnArgs){a, 1234u + (unsigned)t};
+        pthread_create(&ids[t], NULL, churn_thread, &args[t]);
+    }
+    for (int t = 0; t < threads; t++) pthread_join(ids[t], NULL);
+    return (double)OPS * threads / (now_sec() - begin);
+}
+
+// Producer allocates, consumer frees: every block changes threads once
+#define RING 4096
+typedef struct {
+    const Allocator* allocator;
+    void* ring[RING];
+    _Atomic size_t head;
+    _Atomic size_t tail;
+} Handoff;
+
+static void* producer(void* arg) {
+    Handoff* h = arg;
+    for (size_t i = 0; i < OPS; i++) {
+        while (i - atomic_load_explicit(&h->tail, memory_order_acquire) >= RING) sched_yield();
+        h->ring[i % RING] = h->allocator->alloc(48 + (i % 4) * 16);
+        atomic_store_explicit(&h->head, i + 1, memory_order_release);
+    }
+    return NULL;
+}
+
+static void* consumer(void* arg) {
+    Handoff* h = arg;
+    for (size_t i = 0; i < OPS; i++) {
+        while (atomic_load_explicit(&h->head, memory_order_acquire) <= i) sched_yield();
+        h->allocator->release(h->ring[i % RING]);
+        atomic_store_explicit(&h->tail, i + 1, memory_order_release);
+    }
+    return NULL;
+}
+
+static double run_handoff(const Allocator* a) {
+    static Handoff h;
+    h.allocator = a;
+    atomic_store(&h.head, 0);
+    atomic_store(&h.tail, 0);
+    pthread_t p, c;
+    double begin = now_sec();
+    pthread_create(&p, NULL, producer, &h);
+    pthread_create(&c, NULL, consumer, &h);
+    pthread_join(p, NULL);
+    pthread_join(c, NULL);
+    return OPS / (now_sec() - begin);
+}
+
+int main(int argc, char** argv) {
+    int threads = argc > 1 ? atoi(argv[1]) : 4;
+    if (threads < 1) threads = 1;
+    if (threads > 64) threads = 64;
+
+    Allocator pool = {wyn_pool_alloc, wyn_pool_release};
+    Allocator libc = {malloc, free};
+    printf("%-28s %14s %14s\n", "", "pool Mops/s", "malloc Mops/s");
+    printf("%-28s %14.1f %14.1f\n", "churn, 1 thread",
+           run_churn(&pool, 1) / 1e6, run_churn(&libc, 1) / 1e6);
+    char label[64];
+    snprintf(label, sizeof(label), "churn, %d threads", threads);
+    printf("%-28s %14.1f %14.1f\n", label,
+           run_churn(&pool, threads) / 1e6, run_churn(&libc, threads) / 1e6);
+    printf("%-28s %14.1f %14.1f\n", "producer -> consumer",
+           run_handoff(&pool) / 1e6, run_handoff(&libc) / 1e6);
+    return 0;
+}
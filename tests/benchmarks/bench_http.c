@@ -0,0 +1,152 @@
+// HTTP server load benchmark in the style of wrk: client threads keep
+// connections open to an in-process server on loopback and send requests
+// back to back (or pipelined), counting responses and latency.
+//   make bench_http && ./tests/benchmarks/bench_http [seconds] [connections] [pipeline] [workers]
+#define _GNU_SOURCE
+#include "http_server.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+static int port;
+static int pipeline_depth;
+static double deadline;
+static _Atomic long total_requests;
+static _Atomic long total_errors;
+static _Atomic long total_latency_us;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int handle(int req) {
+    (void)req;
+    return HttpServer_respond(req, 200, "text/plain", "Hello, World!");
+}
+
+static void* serve(void* arg) {
+    HttpServer_serve(arg, handle);
+    return NULL;
+}
+
+// Reads one response with a Content-Length body from buf, refilling from fd
+static int read_response(int fd, char* buf, size_t cap, size_t* len) {
+    for (;;) {
+        char* end = memmem(buf, *len, "\r\n\r\n", 4);
+        if (end) {
+            const char* cl = strstr(buf, "Content-Length: ");
+            size_t body = cl && cl < end ? (size_t)atol(cl + 16) : 0;
+            size_t total = (size_t)(end - buf) + 4 + body;
+            if (*len >= total) {
+                int ok = strncmp(buf, "HTTP/1.1 200", 12) == 0;
+                memmove(buf, buf + total, *len - total);
+                *len -= total;
+                buf[*len] = '\0';
+                return ok ? 0 : -1;
+            }
+        }
+        ssize_t n = recv(fd, buf + *len, cap - *len - 1, 0);
+        if (n <= 0) return -1;
+        *len += (size_t)n;
+        buf[*len] = '\0';
+    }
+}
+
+static void* client(void* arg) {
+    (void)arg;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        atomic_fetch_add(&total_errors, 1);
+        close(fd);
+        return NULL;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    static const char request[] = "GET /plaintext HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    size_t batch_len = (sizeof(request) - 1) * (size_t)pipeline_depth;
+    char* batch = malloc(batch_len);
+    for (int i = 0; i < pipeline_depth; i++) memcpy(batch + i * (sizeof(request) - 1), request, sizeof(request) - 1);
+    char buf[65536];
+    size_t len = 0;
+    long requests = 0, errors = 0, latency_us = 0;
+
+    while (now_sec() < deadline) {
+        double start = now_sec();
+        if (send(fd, batch, batch_len, MSG_NOSIGNAL) != (ssize_t)batch_len) {
+            errors++;
+            break;
+        }
+        int failed = 0;
+        for (int i = 0; i < pipeline_depth; i++) {
+            if (read_response(fd, buf, sizeof(buf), &len) != 0) failed = 1;
+        }
+        if (failed) {
+            errors++;
+            break;
+        }
+        requests += pipeline_depth;
+        latency_us += (long)((now_sec() - start) * 1e6);
+    }
+
+    atomic_fetch_add(&total_requests, requests);
+    atomic_fetch_add(&total_errors, errors);
+    atomic_fetch_add(&total_latency_us, latency_us);
+    free(batch);
+    close(fd);
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 3;
+    int connections = argc > 2 ? atoi(argv[2]) : 64;
+    pipeline_depth = argc > 3 ? atoi(argv[3]) : 1;
+    int workers = argc > 4 ? atoi(argv[4]) : 0;
+    if (connections < 1) connections = 1;
+    if (pipeline_depth < 1) pipeline_depth = 1;
+
+    WynHttpServer* server = HttpServer_new(0);
+    if (!server) {
+        fprintf(stderr, "bench_http: cannot listen\n");
+        return 1;
+    }
+    if (workers > 0) HttpServer_workers(server, workers);
+    port = HttpServer_port(server);
+    pthread_t server_thread;
+    pthread_create(&server_thread, NULL, serve, server);
+    usleep(100000);
+
+    pthread_t* threads = malloc(sizeof(pthread_t) * (size_t)connections);
+    double start = now_sec();
+    deadline = start + seconds;
+    for (int i = 0; i < connections; i++) pthread_create(&threads[i], NULL, client, NULL);
+    for (int i = 0; i < connections; i++) pthread_join(threads[i], NULL);
+    double elapsed = now_sec() - start;
+
+    HttpServer_stop(server);
+    pthread_join(server_thread, NULL);
+    HttpServer_free(server);
+    free(threads);
+
+    long requests = atomic_load(&total_requests);
+    long batches = requests / pipeline_depth;
+    printf("%d connections, pipeline %d, %.1fs\n", connections, pipeline_depth, elapsed);
+    printf("requests: %ld (%.0f req/sec), errors: %ld\n", requests, requests / elapsed, atomic_load(&total_errors));
+    printf("latency:  %.1f us avg per round trip\n", batches ? (double)atomic_load(&total_latency_us) / batches : 0.0);
+    return 0;
+}
@@ -0,0 +1,85 @@
+// Regex throughput: MB/s scanning a generated log for every match of a few
+// typical patterns, plus a line-by-line is_match filter.
+//   make bench_regex && ./tests/benchmarks/bench_regex [megabytes]
+#define _POSIX_C_SOURCE 200809L
+#include "regex.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Log lines with a little non-ASCII text, so classes cross multi-byte characters
+static char* make_log(size_t size, size_t* len) {
+    static const char* levels[] = {"INFO", "DEBUG", "WARN", "INFO", "ERROR"};
+    static const char* methods[] = {"GET", "POST", "GET", "DELETE"};
+    static const char* users[] = {"alice", "bob", "zoë", "jürgen", "li.wei"};
+    char* text = malloc(size + 256);
+    size_t used = 0;
+    unsigned seed = 12345;
+    while (used < size) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned r = seed >> 8;
+        used += (size_t)sprintf(text + used,
+            "2024-05-%02u 12:%02u:%02u %s %s /api/v1/items/%u user=%s@example.com status=%u took=%ums%s\n",
+            r % 28 + 1, r % 60, (r >> 6) % 60, levels[r % 5], methods[(r >> 3) % 4], r % 100000,
+            users[(r >> 5) % 5], r % 7 ? 200 : 503, r % 900, r % 97 == 0 ? " (timeout)" : "");
+    }
+    *len = used;
+    return text;
+}
+
+int main(int argc, char** argv) {
+    size_t mb = argc > 1 ? (size_t)atol(argv[1]) : 32;
+    if (mb < 1) mb = 1;
+    size_t len;
+    char* text = make_log(mb << 20, &len);
+
+    static const char* patterns[] = {
+        "ERROR",                            // pure literal: memchr + memcmp
+        "status=5\\d\\d",                   // literal prefix, then the DFA
+        "[a-z\\x{e0}-\\x{ff}.]+@example\\.com", // multi-byte class
+        "(?i)TIMEOUT",                      // case-insensitive, no literal
+        "\\b(GET|POST|DELETE) /api/v\\d+/items/(\\d+)",
+        "took=\\d{3}ms$",
+    };
+    for (size_t i = 0; i < sizeof(patterns) / sizeof(patterns[0]); i++) {
+        WynRegexError error;
+        WynRegex* regex = wyn_regex_new_with_flags(patterns[i], WYN_REGEX_UNICODE | WYN_REGEX_MULTILINE, &error);
+        if (!regex) {
+            fprintf(stderr, "%s: %s\n", patterns[i], error.message);
+            return 1;
+        }
+        size_t matches = 0, pos = 0, start, end;
+        double begin = now_sec();
+        while (wyn_regex_search(regex, (const uint8_t*)text, len, pos, &start, &end)) {
+            matches++;
+            pos = end > start ? end : end + 1;
+        }
+        double elapsed = now_sec() - begin;
+        printf("%-46s %8zu matches  %8.1f MB/s\n", patterns[i], matches, len / elapsed / 1e6);
+        wyn_regex_free(regex);
+    }
+
+    // Filtering lines one at a time: the per-call overhead matters here
+    WynRegexError error;
+    WynRegex* regex = wyn_regex_new("status=503.*timeout", &error);
+    size_t kept = 0;
+    double begin = now_sec();
+    for (const char* line = text; line < text + len;) {
+        const char* eol = memchr(line, '\n', (size_t)(text + len - line));
+        size_t line_len = (size_t)(eol - line);
+        if (wyn_regex_matches_bytes(regex, (const uint8_t*)line, line_len)) kept++;
+        line = eol + 1;
+    }
+    double elapsed = now_sec() - begin;
+    printf("%-46s %8zu lines    %8.1f MB/s\n", "is_match per line: status=503.*timeout", kept, len / elapsed / 1e6);
+    wyn_regex_free(regex);
+    free(text);
+    return 0;
+}
@@ -0,0 +1,66 @@
+// Spawn scheduler microbenchmark: spawns/sec for tasks injected from outside
+// the pool and for recursive fan-out from inside worker threads.
+//   make bench_spawn && ./tests/benchmarks/bench_spawn [tasks]
+#define _POSIX_C_SOURCE 200809L
+#include "spawn.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sched.h>
+
+static _Atomic long completed;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void wait_for(long target) {
+    while (atomic_load(&completed) < target) sched_yield();
+}
+
+static void noop_task(void* arg) {
+    (void)arg;
+    atomic_fetch_add_explicit(&completed, 1, memory_order_relaxed);
+}
+
+// Each task spawns two children until depth reaches zero
+static void fanout_task(void* arg) {
+    long depth = (long)arg;
+    if (depth > 0) {
+        wyn_spawn(fanout_task, (void*)(depth - 1));
+        wyn_spawn(fanout_task, (void*)(depth - 1));
+    }
+    atomic_fetch_add_explicit(&completed, 1, memory_order_relaxed);
+}
+
+int main(int argc, char** argv) {
+    long tasks = argc > 1 ? atol(argv[1]) : 1000000;
+    if (tasks < 1) tasks = 1;
+
+    // Start the pool outside the timed region
+    atomic_store(&completed, 0);
+    wyn_spawn(noop_task, NULL);
+    wait_for(1);
+
+    atomic_store(&completed, 0);
+    double start = now_sec();
+    for (long i = 0; i < tasks; i++) wyn_spawn(noop_task, NULL);
+    wait_for(tasks);
+    double external = now_sec() - start;
+
+    long depth = 0;
+    while ((2L << (depth + 1)) - 1 <= tasks) depth++;
+    long fanout_tasks = (2L << depth) - 1;
+    atomic_store(&completed, 0);
+    start = now_sec();
+    wyn_spawn(fanout_task, (void*)depth);
+    wait_for(fanout_tasks);
+    double fanout = now_sec() - start;
+
+    printf("external: %ld spawns in %.3fs (%.2fM spawns/sec)\n", tasks, external, tasks / external / 1e6);
+    printf("fan-out:  %ld spawns in %.3fs (%.2fM spawns/sec)\n", fanout_tasks, fanout, fanout_tasks / fanout / 1e6);
+    return 0;
+}
@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <assert.h>
+#include <pthread.h>
+#include "arc_runtime.h"
+
+#define NODE_TYPE 100
+
+// List node holding counted references to its neighbours
+typedef struct {
+    WynObject* next;
+    WynObject* prev;
+    int value;
+} Node;
+
+static _Atomic size_t destroyed;
+
+static Node* node_of(WynObject* obj) {
+    return (Node*)wyn_arc_get_data(obj);
+}
+
+static void node_destroy(void* ptr) {
+    Node* node = node_of(ptr);
+    wyn_arc_release(node->next);
+    wyn_arc_release(node->prev);
+    atomic_fetch_add(&destroyed, 1);
+}
+
+static void node_trace(WynObject* obj, WynCycleVisit visit, void* ctx) {
+    Node* node = node_of(obj);
+    visit(node->next, ctx);
+    visit(node->prev, ctx);
+}
+
+static WynObject* node_new(int value) {
+    WynObject* obj = wyn_arc_alloc(sizeof(Node), NODE_TYPE, node_destroy);
+    Node* node = node_of(obj);
+    node->next = NULL;
+    node->prev = NULL;
+    node->value = value;
+    return obj;
+}
+
+// n nodes linked both ways; returns the first, the caller's only reference
+static WynObject* make_list(int n) {
+    WynObject* head = node_new(0);
+    WynObject* tail = head;
+    for (int i = 1; i < n; i++) {
+        WynObject* node = node_new(i);
+        node_of(tail)->next = node;
+        node_of(node)->prev = wyn_arc_retain(tail);
+        tail = node;
+    }
+    return head;
+}
+
+// n nodes each holding the next, the last holding the first
+static WynObject* make_ring(int n) {
+    WynObject* first = node_new(0);
+    WynObject* last = first;
+    for (int i = 1; i < n; i++) {
+        WynObject* node = node_new(i);
+        node_of(last)->next = node;
+        last = node;
+    }
+    node_of(last)->next = wyn_arc_retain(first);
+    return first;
+}
+
+static size_t destroyed_since(size_t before) {
+    return atomic_load(&destroyed) - before;
+}
+
+static void configure(size_t threshold, bool automatic, uint64_t budget_ns) {
+    CycleDetectionConfig config = wyn_cycle_get_config();
+    config.collection_threshold = threshold;
+    config.auto_collection_enabled = automatic;
+    config.slice_budget_ns = budget_ns;
+    wyn_cycle_configure(&config);
+}
+
+void test_ring_collected() {
+    printf("Testing ring collection...\n");
+    size_t before = atomic_load(&destroyed);
+    WynObject* ring = make_ring(100);
+    wyn_arc_release(ring);
+    assert(destroyed_since(before) == 0);
+    assert(wyn_cycle_collect() == 100);
+    assert(destroyed_since(before) == 100);
+    printf("✓ Ring collection test passed\n");
+}
+
+void test_live_list_survives() {
+    printf("Testing live list survival...\n");
+    size_t before = atomic_load(&destroyed);
+    WynObject* head = make_list(50);
+
+    // Buffer every node as a possible root while head is still referenced
+    WynObject* node = head;
+    while (node) {
+        wyn_arc_release(wyn_arc_retain(node));
+        node = node_of(node)->next;
+    }
+    WynCycleStats stats = wyn_cycle_get_stats();
+    assert(stats.candidate_count == 50);
+    assert(wyn_cycle_collect() == 0);
+    assert(destroyed_since(before) == 0);
+    assert(wyn_arc_get_ref_count(head) == 2);
+
+    wyn_arc_release(head);
+    assert(wyn_cycle_collect() == 50);
+    assert(destroyed_since(before) == 50);
+    printf("✓ Live list survival test passed\n");
+}
+
+void test_garbage_releases_live_objects() {
+    printf("Testing garbage referencing live objects...\n");
+    size_t before = atomic_load(&destroyed);
+    WynObject* live = node_new(-1);
+    WynObject* ring = make_ring(10);
+    node_of(ring)->prev = wyn_arc_retain(live);
+    wyn_arc_release(ring);
+    assert(wyn_arc_get_ref_count(live) == 2);
+
+    assert(wyn_cycle_collect() == 10);
+    assert(wyn_arc_get_ref_count(live) == 1);
+    assert(node_of(live)->value == -1);
+    wyn_arc_release(live);
+    assert(destroyed_since(before) == 11);
+    printf("✓ Garbage referencing live objects test passed\n");
+}
+
+void test_buffered_object_freed_by_count() {
+    printf("Testing buffered objects reaching zero...\n");
+    size_t before = atomic_load(&destroyed);
+    WynObject* node = node_new(1);
+    wyn_arc_retain(node);
+    wyn_arc_release(node);
+    // Buffered: the collector frees it instead of the release path
+    wyn_arc_release(node);
+    assert(destroyed_since(before) == 0);
+    assert(wyn_cycle_collect() == 0);
+    assert(destroyed_since(before) == 1);
+    printf("✓ Buffered objects reaching zero test passed\n");
+}
+
+void test_incremental_slices() {
+    printf("Testing incremental slices...\n");
+    size_t before = atomic_load(&destroyed);
+    configure(1000, false, 1);
+
+    WynObject* ring = make_ring(20000);
+    wyn_arc_release(ring);
+    WynObject* head = make_list(2000);
+    WynObject* middle = head;
+    for (int i = 0; i < 1000; i++) middle = node_of(middle)->next;
+    wyn_arc_release(wyn_arc_retain(middle));
+
+    // The program keeps changing the graph between slices
+    size_t slices = 0;
+    bool dropped = false;
+    while (wyn_cycle_collect_slice(1)) {
+        slices++;
+        if (slices == 3) {
+            wyn_arc_release(head);
+            dropped = true;
+        }
+        WynObject* temp = make_ring(3);
+        wyn_arc_release(temp);
+    }
+    assert(dropped);
+    assert(slices > 10);
+    assert(destroyed_since(before) == 20000 + 2000 + 3 * slices);
+    assert(wyn_cycle_get_stats().max_slice_ns < 1000000000u);
+
+    configure(1000, true, 1000000);
+    printf("✓ Incremental slices test passed (%zu slices)\n", slices);
+}
+
+void test_max_objects_per_cycle() {
+    printf("Testing graph size limit...\n");
+    size_t before = atomic_load(&destroyed);
+    CycleDetectionConfig config = wyn_cycle_get_config();
+    config.max_objects_per_cycle = 100;
+    wyn_cycle_configure(&config);
+
+    WynObject* big = make_ring(1000);
+    wyn_arc_release(big);
+    WynCycleStats stats = wyn_cycle_get_stats();
+    assert(wyn_cycle_collect() == 0);
+    assert(wyn_cycle_get_stats().rounds_abandoned > stats.rounds_abandoned);
+
+    config.max_objects_per_cycle = 1u << 16;
+    wyn_cycle_configure(&config);
+    // The ring is no longer buffered; releasing through it buffers it again
+    wyn_arc_release(wyn_arc_retain(big));
+    assert(wyn_cycle_collect() == 1000);
+    assert(destroyed_since(before) == 1000);
+    printf("✓ Graph size limit test passed\n");
+}
+
+void test_shared_objects_skipped() {
+    printf("Testing shared objects...\n");
+    size_t before = atomic_load(&destroyed);
+    WynObject* ring = make_ring(5);
+    wyn_arc_share(node_of(ring)->next);
+    wyn_arc_release(ring);
+    assert(wyn_cycle_collect() == 0);
+    assert(destroyed_since(before) == 0);
+
+    // Break the cycle by hand
+    WynObject* second = node_of(ring)->next;
+    node_of(ring)->next = NULL;
+    wyn_arc_release(second);
+    assert(destroyed_since(before) == 5);
+    printf("✓ Shared objects test passed\n");
+}
+
+void test_automatic_collection() {
+    printf("Testing automatic collection...\n");
+    size_t before = atomic_load(&destroyed);
+    configure(64, true, 1000000);
+    for (int i = 0; i < 1000; i++) wyn_arc_release(make_ring(4));
+    assert(destroyed_since(before) > 0);
+    wyn_cycle_collect();
+    assert(destroyed_since(before) == 4000);
+    configure(1000, true, 1000000);
+    printf("✓ Automatic collection test passed\n");
+}
+
+static void* ring_worker(void* arg) {
+    (void)arg;
+    for (int i = 0; i < 200; i++) {
+        WynObject* ring = make_ring(5);
+        wyn_arc_release(ring);
+    }
+    // Nothing collected explicitly: thread exit flushes the buffer
+    return NULL;
+}
+
+void test_threads() {
+    printf("Testing per-thread collectors...\n");
+    size_t before = atomic_load(&destroyed);
+    pthread_t threads[4];
+    for (int i = 0; i < 4; i++) pthread_create(&threads[i], NULL, ring_worker, NULL);
+    for (int i = 0; i < 4; i++) pthread_join(threads[i], NULL);
+    assert(destroyed_since(before) == 4 * 200 * 5);
+    printf("✓ Per-thread collectors test passed\n");
+}
+
+int main() {
+    printf("=== Cycle Detection Tests ===\n\n");
+
+    wyn_cycle_detection_init();
+    wyn_cycle_register_type(NODE_TYPE, node_trace);
+
+    test_ring_collected();
+    test_live_list_survives();
+    test_garbage_releases_live_objects();
+    test_buffered_object_freed_by_count();
+    test_incremental_slices();
+    test_max_objects_per_cycle();
+    test_shared_objects_skipped();
+    test_automatic_collection();
+    test_threads();
+
+    printf("\n=== Final Statistics ===\n");
+    wyn_cycle_print_stats();
+    wyn_cycle_cleanup();
+
+    printf("\n✅ All cycle detection tests passed!\n");
+    return 0;
+}
@@ -17,9 +17,11 @@ INIT_LEN=${#INIT_MSG}
 
 # Test 3: Hover request
 echo "Test 3: Hover request"
-HOVER_MSG='{"jsonrpc":"2.0","id":2,"method":"textDocument/hover","params":{"textDocument":{"uri":"file:///test.wyn"},"position":{"line":0,"character":0}}}'
+OPEN_MSG='{"jsonrpc":"2.0","method":"textDocument/didOpen","params":{"textDocument":{"uri":"file:///test.wyn","languageId":"wyn","version":1,"text":"fn main() -> int {\n    return 0;\n}\n"}}}'
+OPEN_LEN=${#OPEN_MSG}
+HOVER_MSG='{"jsonrpc":"2.0","id":2,"method":"textDocument/hover","params":{"textDocument":{"uri":"file:///test.wyn"},"position":{"line":0,"character":4}}}'
 HOVER_LEN=${#HOVER_MSG}
-(printf "Content-Length: %d\r\n\r\n%s" $HOVER_LEN "$HOVER_MSG"; sleep 0.5) | timeout 2 ./wyn lsp 2>/dev/null | grep -q "contents" && echo "✅ PASS" || echo "❌ FAIL"
+(printf "Content-Length: %d\r\n\r\n%s" $OPEN_LEN "$OPEN_MSG"; sleep 0.3; printf "Content-Length: %d\r\n\r\n%s" $HOVER_LEN "$HOVER_MSG"; sleep 0.5) | timeout 2 ./wyn lsp 2>/dev/null | grep -q "contents" && echo "✅ PASS" || echo "❌ FAIL"
 
 # Test 4: Completion request
 echo "Test 4: Completion request"
@@ -41,4 +43,4 @@ SHUT_LEN=${#SHUT_MSG}
 
 echo ""
 echo "=== LSP Test Summary ==="
-echo "Basic LSP server exists but needs enhancement for full functionality"
+echo "LSP server answers from parsed documents"
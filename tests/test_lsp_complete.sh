@@ -5,9 +5,16 @@ set -e
 
 echo "=== Testing Enhanced LSP Server ==="
 
+frame() { printf "Content-Length: %d\r\n\r\n%s" ${#1} "$1"; }
+
+# Opens a document, waits for its analysis, then sends a request
+DOC_TEXT='fn add(a: int, b: int) -> int {\n    return a + b;\n}\n\nfn main() -> int {\n    return add(1, 2);\n}\n'
+OPEN_MSG='{"jsonrpc":"2.0","method":"textDocument/didOpen","params":{"textDocument":{"uri":"file:///test.wyn","languageId":"wyn","version":1,"text":"'"$DOC_TEXT"'"}}}'
+with_document() { { frame "$OPEN_MSG"; sleep 0.5; frame "$1"; sleep 0.5; } | timeout 3 ./wyn lsp 2>/dev/null; }
+
 # Test 1: Server starts with new capabilities
 echo "Test 1: Server starts with enhanced capabilities"
-timeout 1 ./wyn lsp 2>&1 | grep -q "references, rename, format" && echo "✅ PASS" || echo "❌ FAIL"
+timeout 1 ./wyn lsp 2>&1 | grep -q "incremental sync, diagnostics" && echo "✅ PASS" || echo "❌ FAIL"
 
 # Test 2: Initialize shows all capabilities
 echo "Test 2: Initialize shows all capabilities"
@@ -20,31 +27,27 @@ echo "$RESULT" | grep -q "documentFormattingProvider" && echo "✅ PASS: documen
 
 # Test 3: Hover with position
 echo "Test 3: Hover with position"
-HOVER_MSG='{"jsonrpc":"2.0","id":2,"method":"textDocument/hover","params":{"textDocument":{"uri":"file:///test.wyn"},"position":{"line":5,"character":10}}}'
-HOVER_LEN=${#HOVER_MSG}
-RESULT=$(printf "Content-Length: %d\r\n\r\n%s" $HOVER_LEN "$HOVER_MSG" | timeout 2 ./wyn lsp 2>/dev/null)
-echo "$RESULT" | grep -q "line 5, col 10" && echo "✅ PASS" || echo "❌ FAIL"
+HOVER_MSG='{"jsonrpc":"2.0","id":2,"method":"textDocument/hover","params":{"textDocument":{"uri":"file:///test.wyn"},"position":{"line":5,"character":12}}}'
+RESULT=$(with_document "$HOVER_MSG")
+echo "$RESULT" | grep -q "fn add(a: int, b: int) -> int" && echo "✅ PASS" || echo "❌ FAIL"
 
 # Test 4: Go to definition
 echo "Test 4: Go to definition"
-DEF_MSG='{"jsonrpc":"2.0","id":3,"method":"textDocument/definition","params":{"textDocument":{"uri":"file:///test.wyn"},"position":{"line":3,"character":5}}}'
-DEF_LEN=${#DEF_MSG}
-RESULT=$(printf "Content-Length: %d\r\n\r\n%s" $DEF_LEN "$DEF_MSG" | timeout 2 ./wyn lsp 2>/dev/null)
-echo "$RESULT" | grep -q "uri" && echo "✅ PASS" || echo "❌ FAIL"
+DEF_MSG='{"jsonrpc":"2.0","id":3,"method":"textDocument/definition","params":{"textDocument":{"uri":"file:///test.wyn"},"position":{"line":5,"character":12}}}'
+RESULT=$(with_document "$DEF_MSG")
+echo "$RESULT" | grep -q '"range":{"start":{"line":0,"character":3}' && echo "✅ PASS" || echo "❌ FAIL"
 
 # Test 5: Find references
 echo "Test 5: Find references"
-REF_MSG='{"jsonrpc":"2.0","id":4,"method":"textDocument/references","params":{"textDocument":{"uri":"file:///test.wyn"},"position":{"line":2,"character":3}}}'
-REF_LEN=${#REF_MSG}
-RESULT=$(printf "Content-Length: %d\r\n\r\n%s" $REF_LEN "$REF_MSG" | timeout 2 ./wyn lsp 2>/dev/null)
-echo "$RESULT" | grep -q "uri" && echo "✅ PASS" || echo "❌ FAIL"
+REF_MSG='{"jsonrpc":"2.0","id":4,"method":"textDocument/references","params":{"textDocument":{"uri":"file:///test.wyn"},"position":{"line":0,"character":4}}}'
+RESULT=$(with_document "$REF_MSG")
+echo "$RESULT" | grep -q '"line":5,"character":11' && echo "✅ PASS" || echo "❌ FAIL"
 
 # Test 6: Rename symbol
 echo "Test 6: Rename symbol"
-REN_MSG='{"jsonrpc":"2.0","id":5,"method":"textDocument/rename","params":{"textDocument":{"uri":"file:///test.wyn"},"position":{"line":1,"character":2},"newName":"newFunc"}}'
-REN_LEN=${#REN_MSG}
-RESULT=$(printf "Content-Length: %d\r\n\r\n%s" $REN_LEN "$REN_MSG" | timeout 2 ./wyn lsp 2>/dev/null)
-echo "$RESULT" | grep -q "changes" && echo "✅ PASS" || echo "❌ FAIL"
+REN_MSG='{"jsonrpc":"2.0","id":5,"method":"textDocument/rename","params":{"textDocument":{"uri":"file:///test.wyn"},"position":{"line":0,"character":4},"newName":"newFunc"}}'
+RESULT=$(with_document "$REN_MSG")
+echo "$RESULT" | grep -q '"newText":"newFunc"' && echo "✅ PASS" || echo "❌ FAIL"
 
 # Test 7: Format document
 echo "Test 7: Format document"
@@ -64,17 +67,15 @@ echo "$RESULT" | grep -q "match" && echo "✅ PASS: match keyword" || echo "❌
 
 # Test 9: Document lifecycle (didOpen)
 echo "Test 9: Document lifecycle (didOpen)"
-OPEN_MSG='{"jsonrpc":"2.0","method":"textDocument/didOpen","params":{"textDocument":{"uri":"file:///test.wyn","languageId":"wyn","version":1,"text":"fn main() {}"}}}'
-OPEN_LEN=${#OPEN_MSG}
-RESULT=$(printf "Content-Length: %d\r\n\r\n%s" $OPEN_LEN "$OPEN_MSG" | timeout 2 ./wyn lsp 2>&1)
-echo "$RESULT" | grep -q "Document opened" && echo "✅ PASS" || echo "❌ FAIL"
+RESULT=$({ frame "$OPEN_MSG"; sleep 0.5; } | timeout 2 ./wyn lsp 2>/dev/null)
+echo "$RESULT" | grep -q 'publishDiagnostics","params":{"uri":"file:///test.wyn","version":1,"diagnostics":\[\]' && echo "✅ PASS" || echo "❌ FAIL"
 
 # Test 10: Document changes (didChange)
 echo "Test 10: Document changes (didChange)"
-CHG_MSG='{"jsonrpc":"2.0","method":"textDocument/didChange","params":{"textDocument":{"uri":"file:///test.wyn","version":2},"contentChanges":[{"text":"fn main() { print(42) }"}]}}'
-CHG_LEN=${#CHG_MSG}
-RESULT=$(printf "Content-Length: %d\r\n\r\n%s" $CHG_LEN "$CHG_MSG" | timeout 2 ./wyn lsp 2>&1)
-echo "$RESULT" | grep -q "Document changed" && echo "✅ PASS" || echo "❌ FAIL"
+# Replace "b" in "a + b" with "c": an incremental edit that breaks the function
+CHG_MSG='{"jsonrpc":"2.0","method":"textDocument/didChange","params":{"textDocument":{"uri":"file:///test.wyn","version":2},"contentChanges":[{"range":{"start":{"line":1,"character":15},"end":{"line":1,"character":16}},"text":"c"}]}}'
+RESULT=$(with_document "$CHG_MSG")
+echo "$RESULT" | grep -q '"version":2,"diagnostics":\[{"range":{"start":{"line":1,"character":4}.*Undefined variable' && echo "✅ PASS" || echo "❌ FAIL"
 
 echo ""
 echo "=== LSP Test Summary ==="
@@ -87,5 +88,4 @@ echo "  5. Diagnostics - Document lifecycle tracking"
 echo "  6. Rename - Refactor safely"
 echo "  7. Format - Auto-format code"
 echo ""
-echo "Note: Current implementation provides protocol-level support."
-echo "Full semantic analysis requires AST integration (future enhancement)."
+echo "Documents are parsed and checked as they change; diagnostics are pushed to the editor."
@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "regex.h"
+
+static WynRegex* compile(const char* pattern) {
+    WynRegexError error;
+    WynRegex* regex = wyn_regex_new(pattern, &error);
+    if (!regex) fprintf(stderr, "%s: %s\n", pattern, error.message);
+    assert(regex);
+    return regex;
+}
+
+// Leftmost-first match of pattern in text at or after from, as byte offsets
+static bool search_from(const char* pattern, const char* text, size_t from, size_t* start, size_t* end) {
+    WynRegex* regex = compile(pattern);
+    bool found = wyn_regex_search(regex, (const uint8_t*)text, strlen(text), from, start, end);
+    wyn_regex_free(regex);
+    return found;
+}
+
+static void expect_match(const char* pattern, const char* text, size_t start, size_t end) {
+    size_t s, e;
+    if (!search_from(pattern, text, 0, &s, &e) || s != start || e != end) {
+        fprintf(stderr, "/%s/ on \"%s\": expected [%zu, %zu)\n", pattern, text, start, end);
+        assert(0);
+    }
+}
+
+static void expect_no_match(const char* pattern, const char* text) {
+    size_t s, e;
+    if (search_from(pattern, text, 0, &s, &e)) {
+        fprintf(stderr, "/%s/ on \"%s\": unexpected match [%zu, %zu)\n", pattern, text, s, e);
+        assert(0);
+    }
+}
+
+static WynCaptures* captures(const char* pattern, const char* text) {
+    WynRegex* regex = compile(pattern);
+    WynString* str = wyn_string_from_cstr(text);
+    WynCaptures* caps = wyn_regex_captures(regex, str);
+    wyn_string_free(str);
+    wyn_regex_free(regex);
+    return caps;
+}
+
+static void expect_group(const WynMatch* match, size_t start, size_t end) {
+    assert(match);
+    assert(match->start == start);
+    assert(match->end == end);
+}
+
+void test_captures() {
+    printf("Testing capture groups...\n");
+    WynCaptures* caps = captures("(\\d+)-(\\d+)(x)?", "ab 12-345 cd");
+    assert(caps);
+    assert(caps->count == 4);
+    expect_group(wyn_captures_get(caps, 0), 3, 9);
+    expect_group(wyn_captures_get(caps, 1), 3, 5);
+    expect_group(wyn_captures_get(caps, 2), 6, 9);
+    assert(wyn_captures_get(caps, 3) == NULL);
+    wyn_captures_free(caps);
+
+    // A repeated group keeps its last iteration
+    caps = captures("(a|b)+", "xabab");
+    expect_group(wyn_captures_get(caps, 0), 1, 5);
+    expect_group(wyn_captures_get(caps, 1), 4, 5);
+    wyn_captures_free(caps);
+
+    assert(captures("(\\d+)", "no digits") == NULL);
+    printf("✓ Capture groups test passed\n");
+}
+
+void test_alternation_priority() {
+    printf("Testing leftmost-first alternation...\n");
+    // The first alternative that matches wins, not the longest
+    expect_match("a|ab", "ab", 0, 1);
+    expect_match("foo|foobar", "foobar", 0, 3);
+    expect_match("foobar|foo", "foobar", 0, 6);
+    expect_match("sam|samwise", "samwise", 0, 3);
+    // An earlier start beats alternative order
+    expect_match("b|ab", "xab", 1, 3);
+    WynCaptures* caps = captures("(a|ab)(c|bcd)", "abcd");
+    expect_group(wyn_captures_get(caps, 0), 0, 4);
+    expect_group(wyn_captures_get(caps, 1), 0, 1);
+    expect_group(wyn_captures_get(caps, 2), 1, 4);
+    wyn_captures_free(caps);
+    printf("✓ Leftmost-first alternation test passed\n");
+}
+
+void test_lazy_quantifiers() {
+    printf("Testing lazy quantifiers...\n");
+    expect_match("a+?", "aaa", 0, 1);
+    expect_match("a*?", "aaa", 0, 0);
+    expect_match("a{2,4}?", "aaaa", 0, 2);
+    expect_match("<.+?>", "<a><b>", 0, 3);
+    expect_match("<.+>", "<a><b>", 0, 6);
+    WynCaptures* caps = captures("(a+?)(a*)b", "aaab");
+    expect_group(wyn_captures_get(caps, 1), 0, 1);
+    expect_group(wyn_captures_get(caps, 2), 1, 3);
+    wyn_captures_free(caps);
+    printf("✓ Lazy quantifiers test passed\n");
+}
+
+void test_named_captures() {
+    printf("Testing named captures...\n");
+    WynCaptures* caps = captures("(?P<year>\\d{4})-(?<month>\\d{2})", "on 2024-05");
+    assert(caps);
+    expect_group(wyn_captures_get_named(caps, "year"), 3, 7);
+    expect_group(wyn_captures_get_named(caps, "month"), 8, 10);
+    expect_group(wyn_captures_get(caps, 2), 8, 10);
+    assert(wyn_captures_get_named(caps, "day") == NULL);
+    wyn_captures_free(caps);
+
+    WynRegexError error;
+    assert(wyn_regex_new("(?P<>a)", &error) == NULL);
+    assert(error.code == WYN_REGEX_INVALID_GROUP);
+    printf("✓ Named captures test passed\n");
+}
+
+void test_inline_flags() {
+    printf("Testing inline flags...\n");
+    expect_match("(?i)hello", "say HeLLo", 4, 9);
+    expect_no_match("hello", "say HeLLo");
+    // Scoped flags end with their group
+    expect_match("a(?i:b)c", "aBc", 0, 3);
+    expect_no_match("a(?i:b)c", "aBC");
+    expect_match("(?m)^b$", "a\nb\nc", 2, 3);
+    expect_no_match("^b$", "a\nb\nc");
+    expect_match("(?s)a.b", "a\nb", 0, 3);
+    expect_no_match("a.b", "a\nb");
+    expect_match("(?x) a  b # comment", "xab", 1, 3);
+    printf("✓ Inline flags test passed\n");
+}
+
+void test_word_boundaries() {
+    printf("Testing word boundaries...\n");
+    expect_match("\\bcat\\b", "concat cat", 7, 10);
+    expect_match("\\Bcat", "concat cat", 3, 6);
+    expect_match("\\b", "  ab", 2, 2);
+    expect_no_match("\\bcat\\b", "concatenate");
+
+    // Bytes before the search start still decide \b
+    size_t start, end;
+    assert(!search_from("\\bcat", "concat", 3, &start, &end));
+    assert(search_from("\\Bcat", "concat", 3, &start, &end));
+    assert(start == 3 && end == 6);
+    printf("✓ Word boundaries test passed\n");
+}
+
+void test_dfa_fallback() {
+    printf("Testing DFA cache overflow fallback...\n");
+    // a[ab]{20}X needs a DFA state per combination of the last 21 bytes, so
+    // random text overflows the cache and the search finishes in the Pike VM
+    size_t len = 1 << 20;
+    char* text = malloc(len + 1);
+    unsigned seed = 12345;
+    for (size_t i = 0; i < len; i++) {
+        seed = seed * 1103515245u + 12345u;
+        text[i] = (seed >> 16) & 1 ? 'a' : 'b';
+    }
+    text[len - 22] = 'a';
+    text[len - 1] = 'X';
+    text[len] = '\0';
+
+    WynRegex* regex = compile("a[ab]{20}X");
+    size_t start, end;
+    assert(wyn_regex_search(regex, (const uint8_t*)text, len, 0, &start, &end));
+    assert(start == len - 22);
+    assert(end == len);
+    assert(wyn_regex_matches_bytes(regex, (const uint8_t*)text, len));
+    text[len - 1] = 'a';
+    assert(!wyn_regex_search(regex, (const uint8_t*)text, len, 0, &start, &end));
+    wyn_regex_free(regex);
+    free(text);
+    printf("✓ DFA cache overflow fallback test passed\n");
+}
+
+void test_utf8_classes() {
+    printf("Testing multi-byte UTF-8 classes...\n");
+    // "café zoë": é is bytes 3-4, ë is bytes 8-9
+    expect_match("[à-ÿ]+", "café zoë", 3, 5);
+    expect_match("[\\x{e0}-\\x{ff}]", "zoë", 2, 4);
+    expect_match("[^a-z ]", "abc ü", 4, 6);
+    // A negated class consumes whole characters, never part of one
+    expect_match("[^é]+", "éa", 2, 3);
+    expect_match(".", "€", 0, 3);
+    expect_match("^.{3}$", "a€b", 0, 5);
+    expect_match("[€£]+", "cost: £5 or €6", 6, 8);
+    // \w is ASCII
+    expect_match("\\w+", "zoë", 0, 2);
+    printf("✓ Multi-byte UTF-8 classes test passed\n");
+}
+
+int main() {
+    printf("=== Regex Tests ===\n\n");
+
+    test_captures();
+    test_alternation_priority();
+    test_lazy_quantifiers();
+    test_named_captures();
+    test_inline_flags();
+    test_word_boundaries();
+    test_dfa_fallback();
+    test_utf8_classes();
+
+    printf("\n✅ All regex tests passed!\n");
+    return 0;
+}